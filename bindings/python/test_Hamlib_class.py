@@ -84,14 +84,23 @@ class TestClass:
 'rig_stream_open',
 'rig_stream_pause',
 'rig_stream_read',
+'rig_stream_read_acquire',
 'rig_stream_read_info',
 'rig_stream_read_metadata',
+'rig_stream_read_release',
+'rig_stream_reader_close',
+'rig_stream_reader_get_stats',
+'rig_stream_reader_open',
+'rig_stream_reader_read',
+'rig_stream_reader_stats',
 'rig_stream_resume',
 'rig_stream_stats',
 'rig_stream_time_anchor',
 'rig_stream_unmute',
 'rig_stream_wait_write_status',
 'rig_stream_write',
+'rig_stream_write_acquire',
+'rig_stream_write_commit',
 'rig_stream_write_info',
 'rig_stream_write_metadata',
 'rig_stream_write_status',
@@ -2006,6 +2006,8 @@ typedef enum {
 #define RIG_STREAM_CONV_FORMAT   (1<<0)   /* sample format converted */
 #define RIG_STREAM_CONV_RATE     (1<<1)   /* resampled */
 #define RIG_STREAM_CONV_CHANNELS (1<<2)   /* channel count mapped */
+#define RIG_STREAM_CONV_SHIFT    (1<<3)   /* I/Q frequency shifted (iq_shift) */
+#define RIG_STREAM_CONV_CODEC    (1<<4)   /* encoded/decoded from PCM (Opus) */
 
 /* Streaming capability descriptor. Two views share this struct:
  *
@@ -2093,9 +2095,29 @@ struct rig_stream_config {
                                              * install a conversion. 0 (default) =
                                              * convert when the request is in the
                                              * effective but not the native set. */
+    int32_t iq_decimate;                    /* I/Q RX only. 1 = convert the rate
+                                             * with a CIC + half-band decimator
+                                             * rather than the general resampler:
+                                             * the source is the smallest native
+                                             * rate that is an integer multiple
+                                             * of sample_rate (-RIG_EINVAL if
+                                             * none is). 0 (default) = resampler. */
+    freq_t iq_shift;                        /* With iq_decimate: mix the signal at
+                                             * iq_shift Hz from the window centre
+                                             * down to DC before decimating, so a
+                                             * narrow stream can sit anywhere in a
+                                             * wide native one. The stream's
+                                             * center_freq metadata moves with it.
+                                             * |iq_shift| < native rate / 2. */
 };
 
 typedef struct rig_stream rig_stream_t;     /* Opaque — defined in src/stream.h */
+typedef struct rig_stream_reader rig_stream_reader_t; /* Opaque — further
+                                             * reader of an RX stream, see
+                                             * rig_stream_reader_open() */
+typedef struct rig_stream_recorder rig_stream_recorder_t; /* Opaque — RX
+                                             * stream to disk, see
+                                             * rig_stream_recorder_open() */
 
 /* Metadata field presence flags. Bit order follows the struct field order
  * (and wire offsets): vfo_id, ptt, center_freq, vfo_freq. */
@@ -2251,10 +2273,74 @@ struct rig_stream_stats {
                                       per datagram — but counts frames,
                                       surviving any future packing).
                                       0 on raw streams. */
-    uint64_t _reserved[5];         /* ABI headroom; rig_stream_get_stats
+    uint64_t link_packets;         /* Network client only: datagrams sent
+                                      and received on the stream socket */
+    uint64_t link_syscalls;        /* ... and the system calls they took;
+                                      link_packets / link_syscalls is the
+                                      batching achieved */
+    uint64_t _reserved[3];         /* ABI headroom; rig_stream_get_stats
                                       zeroes it (see rig_stream_metadata) */
 };
 
+/* One broadcast reader's counters, returned by rig_stream_reader_get_stats().
+ * Gaps are the stream's and read the same for every reader; see
+ * rig_stream_get_stats(). */
+struct rig_stream_reader_stats {
+    uint32_t overruns;          /* reads that found this reader lapped */
+    uint32_t underruns;         /* blocking reads that timed out empty */
+    uint32_t slow_events;       /* times it fell behind by over 3/4 ring */
+    int32_t  slow;              /* 1 while it is still that far behind */
+    uint64_t lag_samples;       /* written but not yet read by it */
+    uint64_t dropped_samples_overrun;
+    uint64_t _reserved[4];      /* ABI headroom;
+                                   rig_stream_reader_get_stats zeroes it */
+};
+
+/* File layout written by a stream recorder */
+enum rig_stream_record_container {
+    RIG_STREAM_RECORD_SIGMF = 0,    /* SigMF: samples in <path>.sigmf-data,
+                                       captures and annotations in
+                                       <path>.sigmf-meta */
+    RIG_STREAM_RECORD_WAV  = 1      /* WAV with a BWF bext time reference,
+                                       RF64 once it outgrows 4 GB; I/Q as
+                                       I and Q channels, 8-bit as unsigned */
+};
+
+/* What rig_stream_recorder_open() records and how. Callers SHOULD zero-init
+ * it; 0 picks the default of every numeric field. */
+struct rig_stream_record_config {
+    int32_t  container;         /* enum rig_stream_record_container */
+    const char *path;           /* WAV: the file; SigMF: base name the
+                                   .sigmf-data / .sigmf-meta suffixes go on */
+    const char *description;    /* Free text for the file, or NULL */
+    uint32_t block_bytes;       /* Bytes per disk write, rounded up to whole
+                                   4 KB pages and frames (0 = 1 MB) */
+    uint32_t blocks;            /* Blocks queued between the stream and the
+                                   disk, 2..256 (0 = 8) */
+    int32_t  direct_io;         /* 1 = bypass the page cache (O_DIRECT) where
+                                   the system and file system allow it */
+    uint64_t _reserved[4];      /* ABI headroom; callers SHOULD zero it */
+};
+
+/* A recorder's counters, returned by rig_stream_recorder_get_stats() */
+struct rig_stream_record_stats {
+    uint64_t samples;           /* frames in the file, silence included */
+    uint64_t bytes_written;     /* bytes on disk so far */
+    uint64_t dropped_samples;   /* known-size gaps met (lower bound when
+                                   a gap was of unknown size) */
+    uint32_t gaps;              /* gaps met, each an annotation in SigMF,
+                                   silence in WAV */
+    uint32_t captures;          /* SigMF capture segments so far */
+    uint32_t disk_waits;        /* times every block was waiting on the
+                                   disk; the stream kept going and the
+                                   recorder's reader may have been lapped */
+    uint32_t write_errors;      /* failed writes; recording stopped at the
+                                   first */
+    int32_t  direct_io;         /* 1 while O_DIRECT is in use */
+    uint64_t _reserved[4];      /* ABI headroom;
+                                   rig_stream_recorder_get_stats zeroes it */
+};
+
 /* Write-status event kind (TX streams). Delivered by
  * rig_stream_wait_write_status(); RX issues arrive inline via
  * rig_stream_read_info instead. */
@@ -3720,6 +3806,88 @@ rig_stream_write(RIG *rig,
                  int timeout_ms,
                  const struct rig_stream_write_info *info);
 
+/*!
+ * \brief Borrow the next RX stream data in place, without copying it.
+ *
+ * Waits like rig_stream_read(), then points \a *data at up to \a max_bytes
+ * readable bytes inside the stream's ring and sets \a *bytes to their count,
+ * always whole frames. \a info, when non-NULL, is filled as by
+ * rig_stream_read() for the first of them. The bytes stay readable until
+ * rig_stream_read_release(); only one region may be out at a time. A muted
+ * stream's region reads as silence.
+ *
+ * The ring never blocks its producer: a region held so long that the ring
+ * wraps around onto it is reported by rig_stream_read_release().
+ *
+ * \return RIG_OK, -RIG_ETIMEOUT, -RIG_ENAVAIL as rig_stream_read();
+ *         -RIG_ENIMPL for codec streams and backends with their own read
+ *         path; -RIG_EINVAL on bad args, \a max_bytes below one frame or a
+ *         region already out.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_read_acquire(RIG *rig,
+                        rig_stream_t *stream,
+                        const void **data,
+                        size_t max_bytes,
+                        size_t *bytes,
+                        int timeout_ms,
+                        struct rig_stream_read_info *info);
+
+/*!
+ * \brief Consume the first \a bytes of the region from
+ * rig_stream_read_acquire() and give the region back.
+ *
+ * Bytes not consumed are delivered again by the next read or acquire.
+ *
+ * \return RIG_OK; -RIG_EIO when the producer overwrote part of the region
+ *         while it was out (the bytes are consumed all the same and count as
+ *         a local overrun); -RIG_EINVAL when no region is out or \a bytes
+ *         exceeds it.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_read_release(RIG *rig,
+                        rig_stream_t *stream,
+                        size_t bytes);
+
+/*!
+ * \brief Borrow free space in the TX stream's ring to write into in place.
+ *
+ * Points \a *data at up to \a max_bytes of free ring space and sets
+ * \a *bytes to its size, always whole frames. Nothing is sent until
+ * rig_stream_write_commit(); only one region may be out at a time. Unlike
+ * rig_stream_write() this never overwrites unsent data: with no room for a
+ * frame it polls for space for up to \a timeout_ms (< 0 / 0 / > 0 as in
+ * rig_stream_read()).
+ *
+ * \return RIG_OK, -RIG_ETIMEOUT with no space in time, -RIG_ENAVAIL if the
+ *         stream is closing; -RIG_ENIMPL for codec streams, converted
+ *         streams and backends with their own write path; -RIG_EINVAL on bad
+ *         args, \a max_bytes below one frame or a region already out.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_write_acquire(RIG *rig,
+                         rig_stream_t *stream,
+                         void **data,
+                         size_t max_bytes,
+                         size_t *bytes,
+                         int timeout_ms);
+
+/*!
+ * \brief Send the first \a bytes written into the region from
+ * rig_stream_write_acquire() and give the region back.
+ *
+ * \a info binds a timed-burst target or SOB/EOB flags to the first sample
+ * as in rig_stream_write(). A muted stream discards the bytes.
+ *
+ * \return RIG_OK, -RIG_EINVAL when no region is out or \a bytes exceeds it,
+ *         or the errors of rig_stream_write() for \a info.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_write_commit(RIG *rig,
+                        rig_stream_t *stream,
+                        size_t bytes,
+                        const struct rig_stream_write_info *info);
+
 /*!
  * \brief Block until the TX ring drains or \a timeout_ms elapses.
  *
@@ -3748,6 +3916,118 @@ rig_stream_get_stats(RIG *rig,
                      rig_stream_t *stream,
                      struct rig_stream_stats *stats);
 
+/*!
+ * \brief Attach a further reader to the RX \a stream.
+ *
+ * The stream's ring becomes a broadcast ring: each sample the backend
+ * produces is written once and read by the stream's own consumer
+ * (rig_stream_read()) and by every reader, each at its own pace. A reader
+ * starts at the newest sample and never holds the producer back; one that
+ * falls a ring behind is lapped and skips ahead, which its reads report as
+ * an overrun. \a config, when non-NULL, picks the reader's format and
+ * channel count (the type is ignored, the sample rate must be 0 or the
+ * stream's); the reader then converts on its own, leaving the ring and the
+ * other readers alone. NULL reads the stream's format.
+ *
+ * A reader is used from one thread at a time. Closing the stream closes its
+ * readers; a reader handle is not valid after that.
+ *
+ * \return RIG_OK; -RIG_ENIMPL for codec streams and backends with their own
+ *         read path; -RIG_EINVAL on bad args, a TX stream or a format the
+ *         stream cannot be converted to; -RIG_ENOMEM.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_reader_open(RIG *rig,
+                       rig_stream_t *stream,
+                       const struct rig_stream_config *config,
+                       rig_stream_reader_t **reader);
+
+/*!
+ * \brief Read whole frames from a broadcast reader.
+ *
+ * As rig_stream_read(), in the reader's format: \a info reports its own
+ * drops, \a buffer_size must hold at least one frame.
+ *
+ * \return RIG_OK, -RIG_ETIMEOUT, -RIG_ENAVAIL as rig_stream_read();
+ *         -RIG_EINVAL on bad args.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_reader_read(RIG *rig,
+                       rig_stream_reader_t *reader,
+                       void *buffer,
+                       size_t buffer_size,
+                       size_t *bytes_read,
+                       int timeout_ms,
+                       struct rig_stream_read_info *info);
+
+/*!
+ * \brief Read the counters of \a reader into \a stats.
+ *
+ * \return RIG_OK, or -RIG_EINVAL on bad args.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_reader_get_stats(RIG *rig,
+                            rig_stream_reader_t *reader,
+                            struct rig_stream_reader_stats *stats);
+
+/*!
+ * \brief Detach \a reader from its stream and free it.
+ *
+ * \return RIG_OK, or -RIG_EINVAL on bad args.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_reader_close(RIG *rig,
+                        rig_stream_reader_t *reader);
+
+/*!
+ * \brief Record the RX \a stream to disk.
+ *
+ * The recorder is a broadcast reader (see rig_stream_reader_open()) with a
+ * thread of its own that gathers the samples into large blocks, and a
+ * writer thread that puts the blocks on disk; the stream's consumer and
+ * producer never wait for either. SigMF keeps the samples as they are and
+ * starts a capture segment at the first sample, after every gap (with the
+ * stream sample index as core:global_index) and on every frequency change,
+ * each with its time when the stream has one; every gap is also an
+ * annotation. WAV fills the gaps with silence so the file stays
+ * continuous and records the time of the first sample in its bext chunk.
+ *
+ * The files are complete once rig_stream_recorder_close() returns. Closing
+ * the stream closes its recorders the same way; a recorder handle is not
+ * valid after that.
+ *
+ * \return RIG_OK; -RIG_ENIMPL for codec streams and backends with their own
+ *         read path; -RIG_EINVAL on bad args, a TX stream or a container
+ *         that cannot hold the stream's format; -RIG_EIO when a file cannot
+ *         be created; -RIG_ENOMEM.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_recorder_open(RIG *rig,
+                         rig_stream_t *stream,
+                         const struct rig_stream_record_config *config,
+                         rig_stream_recorder_t **recorder);
+
+/*!
+ * \brief Read the counters of \a recorder into \a stats.
+ *
+ * \return RIG_OK, or -RIG_EINVAL on bad args.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_recorder_get_stats(RIG *rig,
+                              rig_stream_recorder_t *recorder,
+                              struct rig_stream_record_stats *stats);
+
+/*!
+ * \brief Stop \a recorder, write out what it holds, finish its files and
+ * free it.
+ *
+ * \return RIG_OK; -RIG_EIO when a write failed on the way, the files then
+ *         end at the failure; -RIG_EINVAL on bad args.
+ */
+extern HAMLIB_EXPORT(int)
+rig_stream_recorder_close(RIG *rig,
+                          rig_stream_recorder_t *recorder);
+
 /*!
  * \brief Fetch the next write-status event on a TX stream.
  *
@@ -262,6 +262,36 @@ struct rig_state {
     int stream_resample_quality;               /*!< Stream resampler quality:
                                                     RIG_RESAMPLE_* + 1, so 0 =
                                                     built-in default (medium) */
+    char status_shm[64];                       /*!< Shared-memory status page name
+                                                    ("" = no status page) */
+    void *status_page_priv;                    /*!< Pointer to status page writer
+                                                    state */
+    int multicast_spectrum_format;             /*!< Spectrum lines in the JSON
+                                                    snapshot, as binary packets or
+                                                    both (see spectrum_packet.h) */
+    int multicast_spectrum_encoding;           /*!< Encoding of binary spectrum
+                                                    packets */
+    void *spectrum_stage_priv;                 /*!< Pointer to per-subscriber
+                                                    spectrum processing state */
+    int multicast_keyframe_interval;           /*!< Milliseconds between full
+                                                    multicast snapshots in delta
+                                                    mode, 0 = no deltas */
+    int multicast_batch_window;                /*!< Microseconds the multicast
+                                                    publisher waits for more
+                                                    packets to send in one
+                                                    batch, 0 = no waiting */
+    int multicast_hub;                         /*!< Publish through the shared
+                                                    multicast hub of the
+                                                    process */
+    int stream_opus_bitrate;                   /*!< Opus bitrate in bits/s for
+                                                    streams encoded from PCM,
+                                                    0 = codec default */
+    unsigned int stream_batch_depth;           /*!< Stream datagrams per send
+                                                    or receive call, 0 =
+                                                    built-in, 1 = no batching */
+    unsigned int stream_batch_window;          /*!< Microseconds the stream
+                                                    sender waits for a fuller
+                                                    batch, 0 = no waiting */
 // New rig_state items go before this line ============================================
 };
 
@@ -0,0 +1,137 @@
+/*
+ *  Hamlib Interface - shared-memory status page
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#ifndef _STATUS_PAGE_H
+#define _STATUS_PAGE_H 1
+
+#include <stdint.h>
+#include <hamlib/rig.h>
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file status_page.h
+ * \brief Shared-memory status page
+ *
+ * With the \c status_shm configuration token set, the rig poll routine
+ * mirrors the rig cache into a POSIX shared-memory object of that name.
+ * A process on the same host maps it read-only with
+ * rig_status_page_open() and takes consistent snapshots with
+ * rig_status_page_read(), without a round trip to the daemon.
+ *
+ * The page is a seqlock: the writer makes #rig_status_page.seq odd while
+ * it updates the page and even again afterwards, so a reader retries
+ * whenever the sequence was odd or changed during its copy.  All fields
+ * are fixed width and in host byte order; the page is only meant for
+ * processes on the same host.
+ */
+
+__BEGIN_DECLS
+
+//! @cond Doxygen_Suppress
+#define RIG_STATUS_PAGE_MAGIC   0x50534c48  /* "HLSP" */
+#define RIG_STATUS_PAGE_VERSION 1
+//! @endcond
+
+/** \brief VFO slots of #rig_status_page.vfo, matching the rig cache */
+enum rig_status_vfo_e
+{
+    RIG_STATUS_VFO_MAIN_A = 0,
+    RIG_STATUS_VFO_MAIN_B,
+    RIG_STATUS_VFO_MAIN_C,
+    RIG_STATUS_VFO_SUB_A,
+    RIG_STATUS_VFO_SUB_B,
+    RIG_STATUS_VFO_SUB_C,
+    RIG_STATUS_VFO_COUNT
+};
+
+/**
+ * \brief Meter slots of #rig_status_page.meter
+ *
+ * Meters are not polled for the page: each slot holds the latest value
+ * any client read with rig_get_level(), with the time it was read.
+ */
+enum rig_status_meter_e
+{
+    RIG_STATUS_METER_STRENGTH = 0,  /*!< RIG_LEVEL_STRENGTH, dB relative to S9 */
+    RIG_STATUS_METER_SWR,           /*!< RIG_LEVEL_SWR */
+    RIG_STATUS_METER_ALC,           /*!< RIG_LEVEL_ALC */
+    RIG_STATUS_METER_RFPOWER,       /*!< RIG_LEVEL_RFPOWER_METER */
+    RIG_STATUS_METER_RFPOWER_WATTS, /*!< RIG_LEVEL_RFPOWER_METER_WATTS */
+    RIG_STATUS_METER_COMP,          /*!< RIG_LEVEL_COMP_METER */
+    RIG_STATUS_METER_VD,            /*!< RIG_LEVEL_VD_METER */
+    RIG_STATUS_METER_ID,            /*!< RIG_LEVEL_ID_METER */
+    RIG_STATUS_METER_COUNT
+};
+
+/** \brief One VFO of the status page */
+struct rig_status_vfo
+{
+    double freq;            /*!< Hz, 0 = unknown */
+    uint64_t mode;          /*!< rmode_t */
+    int64_t width;          /*!< pbwidth_t */
+};
+
+/** \brief One meter of the status page */
+struct rig_status_meter
+{
+    float value;            /*!< Last value read */
+    uint32_t valid;         /*!< Nonzero once a value has been read */
+    uint64_t time_ms;       /*!< Wall clock of the read, ms since the epoch */
+};
+
+/** \brief Layout of the shared-memory status page */
+struct rig_status_page
+{
+    uint32_t magic;         /*!< RIG_STATUS_PAGE_MAGIC */
+    uint32_t version;       /*!< RIG_STATUS_PAGE_VERSION */
+    uint32_t size;          /*!< sizeof(struct rig_status_page) of the writer */
+    uint32_t seq;           /*!< Seqlock sequence, odd while being written */
+    uint64_t update_ms;     /*!< Wall clock of the last update, ms since the epoch */
+    uint32_t rig_model;     /*!< rig_model_t of the publishing rig */
+    uint32_t vfo;           /*!< Current vfo_t */
+    uint32_t tx_vfo;        /*!< TX vfo_t */
+    uint32_t split_vfo;     /*!< Split TX vfo_t */
+    int32_t ptt;            /*!< ptt_t */
+    int32_t split;          /*!< split_t */
+    int32_t satmode;        /*!< Nonzero in satellite mode */
+    int32_t reserved;
+    struct rig_status_vfo vfo_state[RIG_STATUS_VFO_COUNT];  /*!< Per-VFO state */
+    struct rig_status_meter meter[RIG_STATUS_METER_COUNT];  /*!< Latest meter reads */
+};
+
+extern HAMLIB_EXPORT(const struct rig_status_page *)
+rig_status_page_open(const char *name);
+extern HAMLIB_EXPORT(int)
+rig_status_page_read(const struct rig_status_page *page,
+                     struct rig_status_page *snapshot);
+extern HAMLIB_EXPORT(void)
+rig_status_page_close(const struct rig_status_page *page);
+
+__END_DECLS
+
+#endif /* _STATUS_PAGE_H */
+
+/** @} */
@@ -106,7 +106,7 @@ static const struct confparams dummy_cfg_params[] =
         "0", RIG_CONF_CHECKBUTTON, { }
     },
     {
-        TOK_CFG_STREAM_MODE, "stream_mode", "Stream mode", "Streaming mode: tone, silence, or loopback",
+        TOK_CFG_STREAM_MODE, "stream_mode", "Stream mode", "Streaming mode: tone, silence, loopback, counter, or replay",
         "tone", RIG_CONF_STRING, { }
     },
     {
@@ -126,6 +126,21 @@ static const struct confparams dummy_cfg_params[] =
         "Inject one RX gap of N samples for testing (0 = off)",
         "0", RIG_CONF_NUMERIC, { .n = { 0, 10000000, 1 } }
     },
+    {
+        TOK_CFG_STREAM_REPLAY_FILE, "stream_replay_file", "Replay file",
+        "RX samples for stream_mode=replay: SigMF, WAV/RF64, or raw .cs8/.cu8/.cs16/.cf32/.s8/.u8/.s16/.f32",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_CFG_STREAM_REPLAY_PACE, "stream_replay_pace", "Replay pace",
+        "Replay pace: realtime, or fast (as fast as the stream takes it)",
+        "realtime", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_CFG_STREAM_REPLAY_LOOP, "stream_replay_loop", "Replay loop",
+        "Replay the file over and over",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
     { RIG_CONF_END, NULL, }
 };
 
@@ -320,6 +335,9 @@ static int dummy_init(RIG *rig)
     priv->stream_tone_amp = 0.5f;
     priv->stream_iq_offset = 1000.0f;
     priv->stream_synth_gap = 0;
+    priv->stream_replay_file = NULL;
+    priv->stream_replay_fast = 0;
+    priv->stream_replay_loop = 0;
 
     RETURNFUNC(RIG_OK);
 }
@@ -344,6 +362,7 @@ static int dummy_cleanup(RIG *rig)
     free(priv->ext_funcs);
     free(priv->ext_parms);
     free(priv->magic_conf);
+    free(priv->stream_replay_file);
 
     for (int i = 0; i < RIG_SETTING_MAX; i++)
     {
@@ -428,6 +447,10 @@ static int dummy_set_conf(RIG *rig, hamlib_token_t token, const char *val)
         {
             priv->stream_mode = DUMMY_STREAM_COUNTER;
         }
+        else if (strcmp(val, "replay") == 0)
+        {
+            priv->stream_mode = DUMMY_STREAM_REPLAY;
+        }
         else
         {
             RETURNFUNC(-RIG_EINVAL);
@@ -451,6 +474,31 @@ static int dummy_set_conf(RIG *rig, hamlib_token_t token, const char *val)
         priv->stream_synth_gap = atol(val);
         break;
 
+    case TOK_CFG_STREAM_REPLAY_FILE:
+        free(priv->stream_replay_file);
+        priv->stream_replay_file = val && *val ? strdup(val) : NULL;
+        break;
+
+    case TOK_CFG_STREAM_REPLAY_PACE:
+        if (strcmp(val, "realtime") == 0)
+        {
+            priv->stream_replay_fast = 0;
+        }
+        else if (strcmp(val, "fast") == 0)
+        {
+            priv->stream_replay_fast = 1;
+        }
+        else
+        {
+            RETURNFUNC(-RIG_EINVAL);
+        }
+
+        break;
+
+    case TOK_CFG_STREAM_REPLAY_LOOP:
+        priv->stream_replay_loop = atoi(val) ? 1 : 0;
+        break;
+
     default:
         RETURNFUNC(-RIG_EINVAL);
     }
@@ -482,6 +530,7 @@ static int dummy_get_conf(RIG *rig, hamlib_token_t token, char *val)
         case DUMMY_STREAM_SILENCE:  strcpy(val, "silence");  break;
         case DUMMY_STREAM_LOOPBACK: strcpy(val, "loopback"); break;
         case DUMMY_STREAM_COUNTER:  strcpy(val, "counter");  break;
+        case DUMMY_STREAM_REPLAY:   strcpy(val, "replay");   break;
         default:                    strcpy(val, "unknown");   break;
         }
 
@@ -503,6 +552,19 @@ static int dummy_get_conf(RIG *rig, hamlib_token_t token, char *val)
         SNPRINTF(val, 128, "%ld", priv->stream_synth_gap);
         break;
 
+    case TOK_CFG_STREAM_REPLAY_FILE:
+        SNPRINTF(val, 128, "%s",
+                 priv->stream_replay_file ? priv->stream_replay_file : "");
+        break;
+
+    case TOK_CFG_STREAM_REPLAY_PACE:
+        strcpy(val, priv->stream_replay_fast ? "fast" : "realtime");
+        break;
+
+    case TOK_CFG_STREAM_REPLAY_LOOP:
+        SNPRINTF(val, 128, "%d", priv->stream_replay_loop);
+        break;
+
     default:
         RETURNFUNC(-RIG_EINVAL);
     }
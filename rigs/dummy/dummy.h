@@ -33,6 +33,9 @@
 #define TOK_CFG_STREAM_TONE_AMP  TOKEN_BACKEND(5)
 #define TOK_CFG_STREAM_IQ_OFFSET TOKEN_BACKEND(6)
 #define TOK_CFG_STREAM_SYNTH_GAP TOKEN_BACKEND(7)
+#define TOK_CFG_STREAM_REPLAY_FILE TOKEN_BACKEND(8)
+#define TOK_CFG_STREAM_REPLAY_PACE TOKEN_BACKEND(9)
+#define TOK_CFG_STREAM_REPLAY_LOOP TOKEN_BACKEND(10)
 
 
 /* ext_level's and ext_parm's tokens */
@@ -78,11 +81,14 @@ struct dummy_priv_data
     int static_data;
 
     /* Streaming parameters (set via conf tokens, read at stream open) */
-    int stream_mode;            /* DUMMY_STREAM_TONE/SILENCE/LOOPBACK */
+    int stream_mode;            /* DUMMY_STREAM_TONE/SILENCE/LOOPBACK/... */
     float stream_tone_freq;     /* Audio tone frequency in Hz */
     float stream_tone_amp;      /* Tone amplitude 0.0–1.0 */
     float stream_iq_offset;     /* I/Q offset frequency in Hz */
     long stream_synth_gap;      /* Inject one RX gap of N samples (0 = off) */
+    char *stream_replay_file;   /* Replay mode: SigMF, WAV or raw file */
+    int stream_replay_fast;     /* Replay as fast as the stream takes it */
+    int stream_replay_loop;     /* Replay the file over and over */
 
     /* Per-stream state tracking for loopback pairing. stream_states_lock guards
      * the table so open/close and the loopback thread's peer resolution cannot
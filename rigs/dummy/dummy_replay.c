@@ -0,0 +1,943 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* File replay for the dummy backend (stream_mode=replay). */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "stream.h"
+#include "stream_account.h"
+#include "stream_convert.h"
+#include "stream_proto.h"
+#include "stream_record.h"
+#include "stream_time.h"
+#include "cJSON.h"
+#include "dummy_stream.h"
+#include "dummy_replay.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/* Real-time pace: 10 ms of the file per write */
+#define REPLAY_CHUNKS_PER_SEC 100
+
+/* As fast as possible: writes of at least this much, so the per-write cost
+ * stays out of the figures (at most half the ring, so a write waits for
+ * only part of it to drain) */
+#define REPLAY_FAST_CHUNK_BYTES (256 * 1024)
+
+/* As fast as possible: poll for room in the ring this often */
+#define REPLAY_ROOM_POLL_NS 1000000L
+
+/* Re-anchor from the file's time every this many writes, so the time
+ * stays within the staleness watchdog's reach between captures */
+#define REPLAY_ANCHOR_EVERY_CHUNKS 25
+
+/* Idle poll while paused or at the end of a file not looped */
+#define REPLAY_IDLE_NS 10000000L
+
+
+/* ------------------------------------------------------------------ */
+/* Loading                                                             */
+/* ------------------------------------------------------------------ */
+
+/* Raw files, by name */
+static const struct
+{
+    const char *ext;
+    rig_stream_format_t format;
+} replay_raw_formats[] =
+{
+    { ".cs8",   RIG_STREAM_FORMAT_IQ_CS8 },
+    { ".cu8",   RIG_STREAM_FORMAT_IQ_CU8 },
+    { ".cs16",  RIG_STREAM_FORMAT_IQ_CS16 },
+    { ".cf32",  RIG_STREAM_FORMAT_IQ_CF32 },
+    { ".cfile", RIG_STREAM_FORMAT_IQ_CF32 },    /* GNU Radio */
+    { ".s8",    RIG_STREAM_FORMAT_PCM_S8 },
+    { ".u8",    RIG_STREAM_FORMAT_PCM_U8 },
+    { ".s16",   RIG_STREAM_FORMAT_PCM_S16 },
+    { ".f32",   RIG_STREAM_FORMAT_PCM_F32 },
+};
+
+
+static int ends_with(const char *s, const char *suffix)
+{
+    size_t len = strlen(s), slen = strlen(suffix);
+
+    return len >= slen && strcmp(s + len - slen, suffix) == 0;
+}
+
+
+static uint16_t get_le16(const unsigned char *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+
+static uint32_t get_le32(const unsigned char *p)
+{
+    return (uint32_t)get_le16(p) | ((uint32_t)get_le16(p + 2) << 16);
+}
+
+
+static uint64_t get_le64(const unsigned char *p)
+{
+    return (uint64_t)get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+}
+
+
+/* Days from 1970-01-01 to a proleptic Gregorian date */
+static int64_t days_from_civil(int y, int m, int d)
+{
+    int64_t era;
+    int yoe, doy, doe;
+
+    y -= m <= 2;
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = (int)(y - era * 400);
+    doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+
+/* SigMF core:datetime, "YYYY-MM-DDTHH:MM:SS[.fraction]Z" */
+static int parse_datetime(const char *s, int64_t *seconds,
+                          uint64_t *picoseconds)
+{
+    int y, mo, d, h, mi, sec, n = 0;
+    uint64_t ps = 0, scale = RIG_STREAM_PS_PER_SEC / 10;
+
+    if (sscanf(s, "%4d-%2d-%2dT%2d:%2d:%2d%n", &y, &mo, &d, &h, &mi, &sec,
+               &n) != 6 || n == 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    s += n;
+
+    if (*s == '.')
+    {
+        for (s++; *s >= '0' && *s <= '9'; s++)
+        {
+            ps += (uint64_t)(*s - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    if (*s != 'Z' && *s != '\0')
+    {
+        return -RIG_EINVAL;         /* Only UTC, as SigMF writes it */
+    }
+
+    *seconds = days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + sec;
+    *picoseconds = ps;
+    return RIG_OK;
+}
+
+
+static int replay_load(struct dummy_replay *r, const char *path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY | O_BINARY);
+
+    if (fd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot open %s: %s\n", __func__, path,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0
+            || (uint64_t)st.st_size > (uint64_t)(size_t) -1)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s is empty or too large\n", __func__,
+                  path);
+        close(fd);
+        return -RIG_EINVAL;
+    }
+
+    r->map_bytes = (size_t)st.st_size;
+
+#ifdef HAVE_SYS_MMAN_H
+    r->map = mmap(NULL, r->map_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (r->map != MAP_FAILED)
+    {
+        r->mapped = 1;
+#ifdef MADV_SEQUENTIAL
+        madvise(r->map, r->map_bytes, MADV_SEQUENTIAL);
+#endif
+        close(fd);
+        return RIG_OK;
+    }
+
+    r->map = NULL;
+#endif
+
+    /* No mapping: read it whole */
+    unsigned char *buf = malloc(r->map_bytes);
+    size_t done = 0;
+
+    if (!buf)
+    {
+        close(fd);
+        return -RIG_ENOMEM;
+    }
+
+    while (done < r->map_bytes)
+    {
+        ssize_t n = read(fd, buf + done, r->map_bytes - done);
+
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n <= 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: reading %s failed: %s\n", __func__,
+                      path, n < 0 ? strerror(errno) : "short file");
+            free(buf);
+            close(fd);
+            return -RIG_EIO;
+        }
+
+        done += (size_t)n;
+    }
+
+    r->map = buf;
+    close(fd);
+    return RIG_OK;
+}
+
+
+static int replay_add_segment(struct dummy_replay *r,
+                              const struct dummy_replay_segment *segment)
+{
+    void *p = realloc(r->segments, (r->segment_count + 1)
+                      * sizeof(*r->segments));
+
+    if (!p)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    r->segments = p;
+    r->segments[r->segment_count++] = *segment;
+    return RIG_OK;
+}
+
+
+static char *replay_read_text(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    char *text = NULL;
+    long size;
+
+    if (!f)
+    {
+        return NULL;
+    }
+
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0
+            && fseek(f, 0, SEEK_SET) == 0 && (text = malloc(size + 1)))
+    {
+        if (fread(text, 1, (size_t)size, f) != (size_t)size)
+        {
+            free(text);
+            text = NULL;
+        }
+        else
+        {
+            text[size] = '\0';
+        }
+    }
+
+    fclose(f);
+    return text;
+}
+
+
+/* Global and captures of a SigMF recording: a capture whose global_index
+ * runs ahead of the samples since the previous one follows a gap */
+static int replay_parse_sigmf(struct dummy_replay *r, const char *meta_path,
+                              int sample_rate)
+{
+    char *text = replay_read_text(meta_path);
+    const cJSON *global, *item, *captures, *capture;
+    cJSON *root;
+    uint64_t prev_start = 0, prev_index = 0;
+    int have_prev = 0, ret = RIG_OK;
+
+    if (!text)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot read %s\n", __func__, meta_path);
+        return -RIG_EIO;
+    }
+
+    root = cJSON_Parse(text);
+    free(text);
+    global = cJSON_GetObjectItemCaseSensitive(root, "global");
+    item = cJSON_GetObjectItemCaseSensitive(global, "core:datatype");
+
+    if (!cJSON_IsString(item)
+            || !(r->format = stream_record_sigmf_format(item->valuestring)))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s: no core:datatype a stream can "
+                  "carry\n", __func__, meta_path);
+        cJSON_Delete(root);
+        return -RIG_EINVAL;
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(global, "core:sample_rate");
+    r->sample_rate = cJSON_IsNumber(item) ? (int)item->valuedouble
+                     : sample_rate;
+    item = cJSON_GetObjectItemCaseSensitive(global, "core:num_channels");
+    r->channels = cJSON_IsNumber(item) ? item->valueint : 1;
+
+    captures = cJSON_GetObjectItemCaseSensitive(root, "captures");
+
+    cJSON_ArrayForEach(capture, captures)
+    {
+        struct dummy_replay_segment segment;
+        int has_index;
+
+        memset(&segment, 0, sizeof(segment));
+        item = cJSON_GetObjectItemCaseSensitive(capture, "core:sample_start");
+        segment.sample_start = cJSON_IsNumber(item)
+                               ? (uint64_t)item->valuedouble : 0;
+
+        if (r->segment_count > 0 && segment.sample_start
+                <= r->segments[r->segment_count - 1].sample_start)
+        {
+            continue;               /* Out of order: not ours to fix */
+        }
+
+        item = cJSON_GetObjectItemCaseSensitive(capture, "core:global_index");
+        has_index = cJSON_IsNumber(item);
+
+        if (has_index)
+        {
+            uint64_t index = (uint64_t)item->valuedouble;
+
+            if (have_prev && index > prev_index
+                    + (segment.sample_start - prev_start))
+            {
+                segment.gap = index - prev_index
+                              - (segment.sample_start - prev_start);
+            }
+
+            prev_start = segment.sample_start;
+            prev_index = index;
+        }
+
+        have_prev = has_index;
+
+        item = cJSON_GetObjectItemCaseSensitive(capture, "core:frequency");
+        segment.frequency = cJSON_IsNumber(item) ? item->valuedouble : 0;
+
+        item = cJSON_GetObjectItemCaseSensitive(capture, "core:datetime");
+        segment.time_valid = cJSON_IsString(item)
+                             && parse_datetime(item->valuestring,
+                                               &segment.seconds,
+                                               &segment.picoseconds) == RIG_OK;
+
+        /* Without a datetime of its own, time runs on from the capture
+         * before, across the gap */
+        if (!segment.time_valid && r->segment_count > 0
+                && r->segments[r->segment_count - 1].time_valid)
+        {
+            const struct dummy_replay_segment *prev =
+                &r->segments[r->segment_count - 1];
+
+            segment.time_valid = 1;
+            segment.seconds = prev->seconds;
+            segment.picoseconds = prev->picoseconds;
+            stream_time_add_samples(&segment.seconds, &segment.picoseconds,
+                                    segment.sample_start - prev->sample_start
+                                    + segment.gap, (uint32_t)r->sample_rate);
+        }
+
+        if ((ret = replay_add_segment(r, &segment)) != RIG_OK)
+        {
+            break;
+        }
+    }
+
+    cJSON_Delete(root);
+    return ret;
+}
+
+
+/* fmt, data and the bext time reference of a WAV or RF64 file */
+static int replay_parse_wav(struct dummy_replay *r, rig_stream_type_t type)
+{
+    const unsigned char *p = r->map;
+    int rf64 = memcmp(p, "RF64", 4) == 0;
+    uint64_t ds64_data = 0;
+    const unsigned char *bext = NULL;
+    size_t off = 12;
+    int tag = 0, bits = 0;
+    uint64_t data_bytes = 0;
+
+    while (off + 8 <= r->map_bytes)
+    {
+        const unsigned char *chunk = p + off;
+        uint64_t len = get_le32(chunk + 4);
+        size_t body = off + 8;
+
+        if (memcmp(chunk, "ds64", 4) == 0 && len >= 24
+                && body + 24 <= r->map_bytes)
+        {
+            ds64_data = get_le64(chunk + 16);
+        }
+        else if (memcmp(chunk, "fmt ", 4) == 0 && len >= 16
+                 && body + 16 <= r->map_bytes)
+        {
+            tag = get_le16(chunk + 8);
+            r->channels = get_le16(chunk + 10);
+            r->sample_rate = (int)get_le32(chunk + 12);
+            bits = get_le16(chunk + 22);
+
+            /* WAVE_FORMAT_EXTENSIBLE: the tag leads the subformat GUID */
+            if (tag == 0xFFFE && len >= 26 && body + 26 <= r->map_bytes)
+            {
+                tag = get_le16(chunk + 8 + 24);
+            }
+        }
+        else if (memcmp(chunk, "bext", 4) == 0 && len >= 346
+                 && body + 346 <= r->map_bytes)
+        {
+            bext = chunk + 8;
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            r->data = chunk + 8;
+            data_bytes = rf64 && len == 0xFFFFFFFF ? ds64_data : len;
+
+            if (data_bytes > r->map_bytes - body)
+            {
+                data_bytes = r->map_bytes - body;   /* Cut short */
+            }
+
+            break;
+        }
+
+        off = body + len + (len & 1);
+    }
+
+    if (!r->data || r->channels <= 0 || r->sample_rate <= 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: no fmt or data chunk\n", __func__);
+        return -RIG_EINVAL;
+    }
+
+    r->format = tag == 1 && bits == 8 ? RIG_STREAM_FORMAT_PCM_U8
+                : tag == 1 && bits == 16 ? RIG_STREAM_FORMAT_PCM_S16
+                : tag == 3 && bits == 32 ? RIG_STREAM_FORMAT_PCM_F32 : 0;
+
+    /* I/Q as I and Q channels */
+    if (r->format && stream_type_is_iq(type))
+    {
+        if (r->channels % 2)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: %d channels are not I/Q pairs\n",
+                      __func__, r->channels);
+            return -RIG_EINVAL;
+        }
+
+        r->channels /= 2;
+        r->format = r->format == RIG_STREAM_FORMAT_PCM_U8
+                    ? RIG_STREAM_FORMAT_IQ_CU8
+                    : r->format == RIG_STREAM_FORMAT_PCM_S16
+                    ? RIG_STREAM_FORMAT_IQ_CS16 : RIG_STREAM_FORMAT_IQ_CF32;
+    }
+
+    if (!r->format)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: format tag %d with %d bits is not "
+                  "supported\n", __func__, tag, bits);
+        return -RIG_EINVAL;
+    }
+
+    r->frame_bytes = rig_stream_format_sample_size(r->format) * r->channels;
+    r->frames = data_bytes / (uint64_t)r->frame_bytes;
+
+    /* Broadcast WAV: samples since the origination date's midnight */
+    struct dummy_replay_segment segment;
+    int y, mo, d;
+
+    memset(&segment, 0, sizeof(segment));
+
+    if (bext && sscanf((const char *)bext + 320, "%4d%*c%2d%*c%2d", &y, &mo,
+                       &d) == 3 && y >= 1970)
+    {
+        uint64_t reference = get_le64(bext + 338);
+
+        segment.time_valid = 1;
+        segment.seconds = days_from_civil(y, mo, d) * 86400;
+        stream_time_add_samples(&segment.seconds, &segment.picoseconds,
+                                reference, (uint32_t)r->sample_rate);
+    }
+
+    return replay_add_segment(r, &segment);
+}
+
+
+int dummy_replay_open(struct dummy_replay **out, const char *path,
+                      rig_stream_type_t type, int sample_rate, int channels)
+{
+    struct dummy_replay *r;
+    char *base, *data_path = NULL, *meta_path = NULL;
+    FILE *meta;
+    size_t len, i;
+    int ret;
+
+    *out = NULL;
+
+    if (!path || !*path)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: replay needs stream_replay_file\n",
+                  __func__);
+        return -RIG_EINVAL;
+    }
+
+    r = calloc(1, sizeof(*r));
+    base = strdup(path);
+
+    if (!r || !base)
+    {
+        free(r);
+        free(base);
+        return -RIG_ENOMEM;
+    }
+
+    /* A SigMF recording by any of its names */
+    len = strlen(base);
+
+    if (ends_with(base, ".sigmf-meta") || ends_with(base, ".sigmf-data"))
+    {
+        base[len - strlen(".sigmf-meta")] = '\0';
+    }
+
+    len = strlen(base) + sizeof(".sigmf-meta");
+    data_path = malloc(len);
+    meta_path = malloc(len);
+
+    if (!data_path || !meta_path)
+    {
+        ret = -RIG_ENOMEM;
+        goto out;
+    }
+
+    snprintf(data_path, len, "%s.sigmf-data", base);
+    snprintf(meta_path, len, "%s.sigmf-meta", base);
+    meta = fopen(meta_path, "rb");
+
+    if (meta)
+    {
+        fclose(meta);
+        ret = replay_load(r, data_path);
+
+        if (ret == RIG_OK)
+        {
+            ret = replay_parse_sigmf(r, meta_path, sample_rate);
+        }
+
+        if (ret == RIG_OK)
+        {
+            r->data = r->map;
+            r->frame_bytes = rig_stream_format_sample_size(r->format)
+                             * r->channels;
+            r->frames = r->map_bytes / (uint64_t)r->frame_bytes;
+        }
+    }
+    else if ((ret = replay_load(r, path)) != RIG_OK)
+    {
+        goto out;
+    }
+    else if (r->map_bytes >= 12
+             && (memcmp(r->map, "RIFF", 4) == 0
+                 || memcmp(r->map, "RF64", 4) == 0)
+             && memcmp((const char *)r->map + 8, "WAVE", 4) == 0)
+    {
+        ret = replay_parse_wav(r, type);
+    }
+    else
+    {
+        for (i = 0; i < sizeof(replay_raw_formats)
+                / sizeof(replay_raw_formats[0]); i++)
+        {
+            if (ends_with(path, replay_raw_formats[i].ext))
+            {
+                r->format = replay_raw_formats[i].format;
+            }
+        }
+
+        if (!r->format)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: %s is neither SigMF, WAV nor a "
+                      "raw file named by its format\n", __func__, path);
+            ret = -RIG_EINVAL;
+            goto out;
+        }
+
+        r->data = r->map;
+        r->sample_rate = sample_rate;
+        r->channels = channels;
+        r->frame_bytes = rig_stream_format_sample_size(r->format) * channels;
+        r->frames = r->map_bytes / (uint64_t)r->frame_bytes;
+    }
+
+    if (ret != RIG_OK)
+    {
+        goto out;
+    }
+
+    if (stream_type_is_iq(type)
+            != ((r->format & (RIG_STREAM_FORMAT_IQ_CS8
+                              | RIG_STREAM_FORMAT_IQ_CU8
+                              | RIG_STREAM_FORMAT_IQ_CS16
+                              | RIG_STREAM_FORMAT_IQ_CF32)) != 0)
+            || r->channels <= 0 || r->sample_rate <= 0 || r->frames == 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s holds no %s samples\n", __func__,
+                  path, stream_type_is_iq(type) ? "I/Q" : "audio");
+        ret = -RIG_EINVAL;
+        goto out;
+    }
+
+    /* The timeline starts at the first frame whatever the file says */
+    if (r->segment_count == 0 || r->segments[0].sample_start != 0)
+    {
+        struct dummy_replay_segment first;
+
+        memset(&first, 0, sizeof(first));
+
+        if ((ret = replay_add_segment(r, &first)) != RIG_OK)
+        {
+            goto out;
+        }
+
+        memmove(r->segments + 1, r->segments,
+                (r->segment_count - 1) * sizeof(*r->segments));
+        r->segments[0] = first;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s: %s, %d Hz, %d channels, %llu "
+              "frames, %d segments\n", __func__, path,
+              stream_format_name(r->format), r->sample_rate, r->channels,
+              (unsigned long long)r->frames, r->segment_count);
+
+out:
+    free(base);
+    free(data_path);
+    free(meta_path);
+
+    if (ret != RIG_OK)
+    {
+        dummy_replay_free(r);
+        return ret;
+    }
+
+    *out = r;
+    return RIG_OK;
+}
+
+
+void dummy_replay_free(struct dummy_replay *replay)
+{
+    if (!replay)
+    {
+        return;
+    }
+
+#ifdef HAVE_SYS_MMAN_H
+
+    if (replay->mapped)
+    {
+        munmap(replay->map, replay->map_bytes);
+    }
+    else
+#endif
+    {
+        free(replay->map);
+    }
+
+    free(replay->segments);
+    free(replay);
+}
+
+
+/* ------------------------------------------------------------------ */
+/* Replay thread                                                       */
+/* ------------------------------------------------------------------ */
+
+static size_t replay_sink(void *ctx, const void *buf, size_t len)
+{
+    return stream_backend_write((struct rig_stream *)ctx, buf, len);
+}
+
+
+static void replay_idle(void)
+{
+    struct timespec ts = { 0, REPLAY_IDLE_NS };
+
+    nanosleep(&ts, NULL);
+}
+
+
+/* Fast pace: wait until the ring has room for need bytes, so the replay
+ * goes as fast as the consumer drains it and never laps it.  Returns 0
+ * when the stream stops, pauses or closes meanwhile. */
+static int replay_wait_room(struct dummy_stream_state *ds, size_t need)
+{
+    struct rig_stream *stream = ds->stream;
+    struct rig_stream_ringbuf *rb = &stream->ringbuf;
+    struct timespec ts = { 0, REPLAY_ROOM_POLL_NS };
+
+    while (ds->running && !stream->paused
+            && !__atomic_load_n(&rb->closing, __ATOMIC_RELAXED))
+    {
+        if (rb->capacity - stream_ringbuf_available(rb) >= need)
+        {
+            return 1;
+        }
+
+        nanosleep(&ts, NULL);
+    }
+
+    return 0;
+}
+
+
+/* Anchor native_pos (in the stream's native sample domain, like the
+ * generator's anchors) at the file's time of frame pos, pass times the
+ * file's length later on a looped replay */
+static void replay_anchor(struct rig_stream *stream,
+                          const struct dummy_replay *r,
+                          const struct dummy_replay_segment *segment,
+                          uint64_t pass, uint64_t pos, uint64_t native_pos,
+                          uint32_t flags)
+{
+    struct rig_stream_time_anchor anchor;
+
+    if (!segment->time_valid)
+    {
+        return;
+    }
+
+    memset(&anchor, 0, sizeof(anchor));
+    anchor.sample_index = native_pos;
+    anchor.seconds = segment->seconds;
+    anchor.picoseconds = segment->picoseconds;
+    stream_time_add_samples(&anchor.seconds, &anchor.picoseconds,
+                            pass * r->frames + pos - segment->sample_start,
+                            (uint32_t)r->sample_rate);
+    anchor.source = RIG_STREAM_TIME_SRC_HOST;
+    anchor.flags = flags;
+    rig_stream_push_time_anchor(stream, &anchor);
+}
+
+
+void *dummy_stream_replay_thread(void *arg)
+{
+    struct dummy_stream_state *ds = (struct dummy_stream_state *)arg;
+    struct rig_stream *stream = ds->stream;
+    const struct dummy_replay *r = ds->replay;
+    const struct rig_stream_config *cfg = &stream->backend_config;
+    uint64_t native_rate = (uint64_t)cfg->sample_rate;
+    int is_iq = stream_type_is_iq(cfg->type);
+    uint64_t chunk = (uint64_t)r->sample_rate / REPLAY_CHUNKS_PER_SEC;
+    uint64_t pos = 0, pass = 0, written = 0, gap_native = 0, paced = 0;
+    uint64_t ring_rate = (uint64_t)stream->config.sample_rate;
+    size_t chunk_ring_bytes = 0;
+    int next = 0, chunks = 0;
+    const struct dummy_replay_segment *segment = NULL;
+    struct timespec start;
+
+    if (chunk == 0)
+    {
+        chunk = 1;
+    }
+
+    if (ds->replay_fast
+            && chunk * (uint64_t)r->frame_bytes < REPLAY_FAST_CHUNK_BYTES)
+    {
+        chunk = REPLAY_FAST_CHUNK_BYTES / (uint64_t)r->frame_bytes;
+    }
+
+    /* What a chunk takes in the ring, in the client's format and rate, with
+     * a frame to spare for the resampler's rounding */
+    if (ds->replay_fast)
+    {
+        uint64_t most = (uint64_t)stream->ringbuf.capacity / 2
+                        / (uint64_t)stream->frame_bytes;
+
+        if (most > 1 && chunk * ring_rate / (uint64_t)r->sample_rate + 1
+                > most)
+        {
+            chunk = (most - 1) * (uint64_t)r->sample_rate / ring_rate;
+            chunk = chunk > 0 ? chunk : 1;
+        }
+
+        chunk_ring_bytes = (size_t)((chunk * ring_rate
+                                     / (uint64_t)r->sample_rate + 1)
+                                    * (uint64_t)stream->frame_bytes);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (ds->running)
+    {
+        uint64_t native_pos, n;
+
+        if (stream->paused)
+        {
+            replay_idle();
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            paced = 0;
+            continue;
+        }
+
+        if (pos == r->frames)
+        {
+            if (!ds->replay_loop)
+            {
+                replay_idle();      /* Played out; the stream stays open */
+                continue;
+            }
+
+            pos = 0;
+            next = 0;
+            pass++;
+        }
+
+        if (ds->replay_fast && !replay_wait_room(ds, chunk_ring_bytes))
+        {
+            replay_idle();
+            continue;
+        }
+
+        native_pos = gap_native + written * native_rate
+                     / (uint64_t)r->sample_rate;
+
+        if (next < r->segment_count && r->segments[next].sample_start == pos)
+        {
+            segment = &r->segments[next++];
+
+            if (segment->gap > 0)
+            {
+                uint64_t gap = segment->gap * native_rate
+                               / (uint64_t)r->sample_rate;
+
+                rig_stream_mark_gap(stream, gap);
+                gap_native += gap;
+                native_pos += gap;
+            }
+
+            if (segment->frequency > 0 && is_iq)
+            {
+                pthread_mutex_lock(&stream->ringbuf.lock);
+                stream->center_freq = segment->frequency;
+                pthread_mutex_unlock(&stream->ringbuf.lock);
+            }
+
+            replay_anchor(stream, r, segment, pass, pos, native_pos,
+                          segment->gap > 0
+                          ? RIG_STREAM_TIME_FLAG_DISCONTINUITY : 0);
+            chunks = 0;
+        }
+        else if (++chunks % REPLAY_ANCHOR_EVERY_CHUNKS == 0)
+        {
+            replay_anchor(stream, r, segment, pass, pos, native_pos, 0);
+        }
+
+        /* Up to the next segment, the end, or a chunk */
+        n = r->frames - pos;
+        n = n < chunk ? n : chunk;
+
+        if (next < r->segment_count
+                && r->segments[next].sample_start - pos < n)
+        {
+            n = r->segments[next].sample_start - pos;
+        }
+
+        if (ds->replay_conv)
+        {
+            stream_conv_process(ds->replay_conv,
+                                r->data + pos * (uint64_t)r->frame_bytes,
+                                (size_t)(n * (uint64_t)r->frame_bytes),
+                                replay_sink, stream);
+        }
+        else
+        {
+            stream_backend_write(stream,
+                                 r->data + pos * (uint64_t)r->frame_bytes,
+                                 (size_t)(n * (uint64_t)r->frame_bytes));
+        }
+
+        pos += n;
+        written += n;
+        paced += n;
+
+        /* Real time: sleep to where the file says the stream should be,
+         * from the start, so rounding never adds up */
+        if (!ds->replay_fast)
+        {
+            struct timespec now, ts;
+            int64_t ns;
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            ns = (int64_t)(paced * 1000000000ULL / (uint64_t)r->sample_rate)
+                 - ((int64_t)(now.tv_sec - start.tv_sec) * 1000000000LL
+                    + (now.tv_nsec - start.tv_nsec));
+
+            if (ns > 0)
+            {
+                ts.tv_sec = (time_t)(ns / 1000000000LL);
+                ts.tv_nsec = (long)(ns % 1000000000LL);
+                nanosleep(&ts, NULL);
+            }
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,74 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* File replay for the dummy backend (stream_mode=replay). */
+/* Maps a SigMF, WAV/RF64 or raw sample file and feeds it to an RX stream at
+ * real-time pace or as fast as the stream takes it, with the gaps, time
+ * anchors and frequencies the file records. */
+
+#ifndef HAMLIB_DUMMY_REPLAY_H
+#define HAMLIB_DUMMY_REPLAY_H
+
+#include <hamlib/rig.h>
+#include <stdint.h>
+
+/* Where the file's sample timeline changes: a SigMF capture, or the start
+ * of a WAV or raw file */
+struct dummy_replay_segment
+{
+    uint64_t sample_start;      /* Frame in the file */
+    uint64_t gap;               /* Samples lost before it (global_index
+                                   jump), in the file's rate */
+    int time_valid;
+    int64_t seconds;            /* Time of the first frame */
+    uint64_t picoseconds;
+    double frequency;           /* Hz, 0 = not recorded */
+};
+
+struct dummy_replay
+{
+    void *map;                  /* Whole data file, mapped or read */
+    size_t map_bytes;
+    int mapped;                 /* 1 = munmap, 0 = free */
+    const unsigned char *data;  /* First frame */
+    uint64_t frames;
+    rig_stream_format_t format;
+    int channels;               /* I/Q: complex channels */
+    int sample_rate;
+    int frame_bytes;
+    struct dummy_replay_segment *segments;
+    int segment_count;
+};
+
+/* Load path for an RX stream of type whose native side runs at
+ * sample_rate with channels (what a raw file is taken to hold). path is a
+ * SigMF recording (base name, .sigmf-meta or .sigmf-data), a WAV/RF64
+ * file, or raw samples named by format (.cs8 .cu8 .cs16 .cf32 .s8 .u8
+ * .s16 .f32). Returns RIG_OK, -RIG_EIO when the file cannot be read,
+ * -RIG_EINVAL when it holds nothing type can carry, or -RIG_ENOMEM. */
+int dummy_replay_open(struct dummy_replay **out, const char *path,
+                      rig_stream_type_t type, int sample_rate, int channels);
+void dummy_replay_free(struct dummy_replay *replay);
+
+/* RX thread of a stream in replay mode (arg: struct dummy_stream_state) */
+void *dummy_stream_replay_thread(void *arg);
+
+#endif /* HAMLIB_DUMMY_REPLAY_H */
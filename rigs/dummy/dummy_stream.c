@@ -39,6 +39,7 @@
 #include "stream_proto.h"
 #include "stream_time.h"
 #include "dummy.h"
+#include "dummy_replay.h"
 #include "misc.h"
 
 /* Generator: push a host-clock anchor every N frames (~250 ms at 10 ms
@@ -776,12 +777,62 @@ int dummy_stream_open(RIG *rig, struct rig_stream *stream)
     ds->synth_gap = priv->stream_synth_gap;
     ds->burst_ptt = (stream->caps_flags & RIG_STREAM_CAP_BURST_PTT) != 0;
     ds->phase_acc = 0;
+    ds->replay_fast = priv->stream_replay_fast;
+    ds->replay_loop = priv->stream_replay_loop;
+
+    /* Replay mode: load the file before there is anything to undo, and
+     * convert it to the native side when it does not match */
+    if (ds->mode == DUMMY_STREAM_REPLAY && stream_type_is_rx(stream->type))
+    {
+        const struct rig_stream_config *bc = &stream->backend_config;
+        int ret;
+
+        if (stream->is_codec)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: replay carries no codec frames\n",
+                      __func__);
+            free(ds);
+            return -RIG_EINVAL;
+        }
+
+        ret = dummy_replay_open(&ds->replay, priv->stream_replay_file,
+                                stream->type, bc->sample_rate, bc->channels);
+
+        if (ret != RIG_OK)
+        {
+            free(ds);
+            return ret;
+        }
+
+        if ((ds->replay->format != bc->format
+                || ds->replay->sample_rate != bc->sample_rate
+                || ds->replay->channels != bc->channels)
+                && stream_conv_init(&ds->replay_conv, ds->replay->format,
+                                    ds->replay->sample_rate,
+                                    ds->replay->channels, bc->format,
+                                    bc->sample_rate, bc->channels,
+                                    stream_type_is_iq(stream->type),
+                                    stream_resample_quality(rig)) != 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: cannot convert %s %d Hz x%d to "
+                      "%s %d Hz x%d\n", __func__,
+                      stream_format_name(ds->replay->format),
+                      ds->replay->sample_rate, ds->replay->channels,
+                      stream_format_name(bc->format), bc->sample_rate,
+                      bc->channels);
+            dummy_replay_free(ds->replay);
+            free(ds);
+            return -RIG_EINVAL;
+        }
+    }
 
     /* Register in the priv state table */
     if (register_stream_state(priv, stream->type, ds) < 0)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: no free stream slots for type=%s\n",
                   __func__, stream_type_name(stream->type));
+        stream_conv_free(ds->replay_conv);
+        dummy_replay_free(ds->replay);
         free(ds);
         return -RIG_EINVAL;  /* No free slots */
     }
@@ -799,6 +850,10 @@ int dummy_stream_open(RIG *rig, struct rig_stream *stream)
              * each iteration, so no peer is cached here. */
             thread_fn = dummy_stream_loopback_thread;
         }
+        else if (ds->mode == DUMMY_STREAM_REPLAY)
+        {
+            thread_fn = dummy_stream_replay_thread;
+        }
         else
         {
             thread_fn = dummy_stream_generator;
@@ -818,6 +873,8 @@ int dummy_stream_open(RIG *rig, struct rig_stream *stream)
         {
             rig_debug(RIG_DEBUG_ERR, "%s: pthread_create failed\n", __func__);
             unregister_stream_state(priv, stream->type, ds);
+            stream_conv_free(ds->replay_conv);
+            dummy_replay_free(ds->replay);
             free(ds);
             return -RIG_EIO;
         }
@@ -857,6 +914,8 @@ int dummy_stream_close(RIG *rig, struct rig_stream *stream)
 
     /* The loopback pipeline is owned by the (now joined) thread. */
     stream_conv_free(ds->loop_conv);
+    stream_conv_free(ds->replay_conv);
+    dummy_replay_free(ds->replay);
 
     unregister_stream_state(priv, stream->type, ds);
     stream->backend_priv = NULL;
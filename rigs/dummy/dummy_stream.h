@@ -36,6 +36,7 @@
 #define DUMMY_STREAM_SILENCE  1
 #define DUMMY_STREAM_LOOPBACK 2
 #define DUMMY_STREAM_COUNTER  3
+#define DUMMY_STREAM_REPLAY   4
 
 /* Per-stream state for the dummy backend */
 /* Threading model: each stream has one worker thread that solely owns its
@@ -69,6 +70,14 @@ struct dummy_stream_state
     struct stream_conv *loop_conv;
     int lc_src_rate, lc_src_ch;
     int lc_dst_rate, lc_dst_ch;
+
+    /* Replay mode: the file, and its conversion to the native side when
+     * its format, rate or channels differ (owned by the replay thread,
+     * freed at close) */
+    struct dummy_replay *replay;
+    struct stream_conv *replay_conv;
+    int replay_fast;                /* Snapshot at stream open time */
+    int replay_loop;                /* Snapshot at stream open time */
 };
 
 /* Backend stream_open / stream_close hooks */
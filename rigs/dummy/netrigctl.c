@@ -31,6 +31,7 @@
 #include "iofunc.h"
 #include "misc.h"
 #include "num_stdio.h"
+#include "cache.h"
 
 #include "dummy.h"
 #include "dummy_common.h"
@@ -44,12 +45,90 @@
 
 #define CHKSCN1ARG(a) if ((a) != 1) return -RIG_EPROTO; else do {} while(0)
 
+#define TOK_CFG_NOTIFY_INTERVAL TOKEN_BACKEND(1)
+
+/* Items netrigctl asks rigctld to push.  The meters change all the time and
+ * are left out; each level costs rigctld one rig read per interval. */
+#define NETRIGCTL_NOTIFY_ITEMS "VFO,FREQ,MODE,PTT,SPLIT,AF,RF,SQL,RFPOWER"
+
+/* Read cache entries (bits of netrigctl_ncache.valid) */
+#define NCACHE_VFO      (1u << 0)
+#define NCACHE_FREQ     (1u << 1)
+#define NCACHE_MODE     (1u << 2)
+#define NCACHE_PTT      (1u << 3)
+#define NCACHE_SPLIT    (1u << 4)
+#define NCACHE_LEVEL(i) (1u << (5 + (i)))
+#define NCACHE_LEVELS   4
+#define NCACHE_PER_VFO  (NCACHE_FREQ | NCACHE_MODE \
+                         | (((1u << NCACHE_LEVELS) - 1) << 5))
+
+/* Levels held by the read cache, in NCACHE_LEVEL() order, with their key in
+ * the notification lines. */
+static const struct
+{
+    setting_t level;
+    const char *key;
+} ncache_levels[NCACHE_LEVELS] =
+{
+    { RIG_LEVEL_AF,      "af" },
+    { RIG_LEVEL_RF,      "rf" },
+    { RIG_LEVEL_SQL,     "sql" },
+    { RIG_LEVEL_RFPOWER, "rfpower" },
+};
+
+/*
+ * Client-side read cache.  While the change feed is up it is coherent with
+ * rigctld to within one notify interval: the feed refreshes every entry that
+ * changes on the server, whoever changed it, and our own successful writes
+ * are stored straight away.  Freq, mode and levels describe the server's
+ * current VFO only.
+ */
+struct netrigctl_ncache
+{
+    pthread_mutex_t lock;
+    unsigned int valid;
+    vfo_t vfo;
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    ptt_t ptt;
+    split_t split;
+    vfo_t tx_vfo;
+    float level[NCACHE_LEVELS];
+    int vfo_moved;              /* Our set_vfo left vfo; its entries are kept
+                                 * but no longer current */
+
+    /* Statistics */
+    unsigned long hits;
+    unsigned long misses;
+};
+
 struct netrigctl_priv_data
 {
     vfo_t vfo_curr;
     int rigctld_vfo_mode;
     vfo_t rx_vfo;
     vfo_t tx_vfo;
+
+    /* rigctld \subscribe change feed, on a connection of its own */
+    int notify_interval_ms;     /* notify_interval conf, 0 = feed off */
+    int notify_sock;
+    pthread_t notify_thread;
+    HAMLIB_ATOMIC int notify_running;
+    HAMLIB_ATOMIC int notify_live;      /* Feed connected and subscribed */
+    vfo_t notify_vfo;           /* Server VFO as last pushed */
+    struct netrigctl_ncache ncache;
+};
+
+static const struct confparams netrigctl_cfg_params[] =
+{
+    {
+        TOK_CFG_NOTIFY_INTERVAL, "notify_interval", "Notify interval",
+        "Subscribe to rigctld change notifications with this rate limit in ms "
+        "to keep the cache current (0 = off)",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 10000, 1 } }
+    },
+    { RIG_CONF_END, NULL, }
 };
 
 int netrigctl_get_vfo_mode(RIG *rig)
@@ -190,18 +269,483 @@ static int netrigctl_init(RIG *rig)
      */
     priv->vfo_curr = RIG_VFO_A;
     priv->rigctld_vfo_mode = 0;
+    priv->notify_sock = -1;
+    pthread_mutex_init(&priv->ncache.lock, NULL);
 
     return RIG_OK;
 }
 
 static int netrigctl_cleanup(RIG *rig)
 {
-    if (STATE(rig)->priv) { free(STATE(rig)->priv); }
+    struct netrigctl_priv_data *priv;
+
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    if (priv)
+    {
+        pthread_mutex_destroy(&priv->ncache.lock);
+        free(priv);
+    }
 
     STATE(rig)->priv = NULL;
     return RIG_OK;
 }
 
+static int netrigctl_set_conf(RIG *rig, hamlib_token_t token, const char *val)
+{
+    struct netrigctl_priv_data *priv;
+
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    switch (token)
+    {
+    case TOK_CFG_NOTIFY_INTERVAL:
+        priv->notify_interval_ms = atoi(val);
+
+        if (priv->notify_interval_ms < 0) { priv->notify_interval_ms = 0; }
+
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+static int netrigctl_get_conf(RIG *rig, hamlib_token_t token, char *val)
+{
+    const struct netrigctl_priv_data *priv;
+
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    switch (token)
+    {
+    case TOK_CFG_NOTIFY_INTERVAL:
+        SNPRINTF(val, 128, "%d", priv->notify_interval_ms);
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+
+/*
+ * Read cache helpers
+ */
+
+static int ncache_level_index(setting_t level)
+{
+    int i;
+
+    for (i = 0; i < NCACHE_LEVELS; i++)
+    {
+        if (ncache_levels[i].level == level) { return i; }
+    }
+
+    return -1;
+}
+
+/* Lock the read cache if it can answer for entry on vfo.  Returns 1 with the
+ * lock held, 0 (unlocked) when the read must go to the server. */
+static int ncache_lock_if(struct netrigctl_priv_data *priv, unsigned int entry,
+                          vfo_t vfo)
+{
+    struct netrigctl_ncache *nc = &priv->ncache;
+
+    if (!priv->notify_live)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&nc->lock);
+
+    /* Per-VFO entries only describe the server's current VFO */
+    if ((nc->valid & entry)
+            && !(nc->vfo_moved && (entry & (NCACHE_VFO | NCACHE_PER_VFO)))
+            && (!(entry & NCACHE_PER_VFO)
+                || vfo == RIG_VFO_CURR
+                || ((nc->valid & NCACHE_VFO) && vfo == nc->vfo)))
+    {
+        nc->hits++;
+        return 1;
+    }
+
+    nc->misses++;
+    pthread_mutex_unlock(&nc->lock);
+    return 0;
+}
+
+/* Lock the read cache for a write-through of entries set on vfo.  Returns 1
+ * with the lock held if the write landed on the server's current VFO (or the
+ * entries are not per-VFO), 0 (unlocked) otherwise. */
+static int ncache_lock_store(struct netrigctl_priv_data *priv,
+                             unsigned int entry, vfo_t vfo)
+{
+    struct netrigctl_ncache *nc = &priv->ncache;
+
+    if (!priv->notify_live)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&nc->lock);
+
+    if (!(entry & NCACHE_PER_VFO)
+            || (!nc->vfo_moved
+                && (vfo == RIG_VFO_CURR
+                    || ((nc->valid & NCACHE_VFO) && vfo == nc->vfo))))
+    {
+        return 1;
+    }
+
+    /* A write to another VFO may still move the current one on some rigs */
+    nc->valid &= ~entry;
+    pthread_mutex_unlock(&nc->lock);
+    return 0;
+}
+
+static void ncache_invalidate(struct netrigctl_priv_data *priv,
+                              unsigned int entries)
+{
+    pthread_mutex_lock(&priv->ncache.lock);
+    priv->ncache.valid &= ~entries;
+    pthread_mutex_unlock(&priv->ncache.lock);
+}
+
+
+/*
+ * rigctld change feed
+ *
+ * A second TCP connection carries "\subscribe"; rigctld then pushes one
+ * "!notify key=value ..." line per batch of changes.  Each line updates the
+ * read cache, which then answers netrigctl_get_freq() and friends without a
+ * round trip, and refreshes the frontend cache as well.
+ */
+
+/* Apply one pushed line to the read cache and the rig cache. */
+static void netrigctl_notify_apply(RIG *rig, char *line)
+{
+    struct netrigctl_priv_data *priv;
+    struct netrigctl_ncache *nc;
+    struct rig_cache *cachep = CACHE(rig);
+    char *saveptr = NULL;
+    char *tok;
+    rmode_t mode = RIG_MODE_NONE;
+    pbwidth_t width = 0;
+    int have_mode = 0;
+    int i;
+
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+    nc = &priv->ncache;
+
+    tok = strtok_r(line, " \r\n", &saveptr);
+
+    if (!tok || strcmp(tok, "!notify") != 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&nc->lock);
+
+    while ((tok = strtok_r(NULL, " \r\n", &saveptr)))
+    {
+        char *val = strchr(tok, '=');
+
+        if (!val) { continue; }
+
+        *val++ = '\0';
+
+        if (strcmp(tok, "vfo") == 0)
+        {
+            vfo_t vfo = rig_parse_vfo(val);
+
+            /* The per-VFO entries were about the old VFO; the server sends
+             * all of them in the same line, whether they differ or not */
+            if ((nc->valid & NCACHE_VFO) && vfo != nc->vfo)
+            {
+                nc->valid &= ~NCACHE_PER_VFO;
+            }
+
+            nc->vfo = vfo;
+            nc->valid |= NCACHE_VFO;
+            nc->vfo_moved = 0;
+
+            priv->notify_vfo = vfo;
+            cachep->vfo = priv->notify_vfo;
+            elapsed_ms(&cachep->time_vfo, HAMLIB_ELAPSED_SET);
+        }
+        else if (strcmp(tok, "freq") == 0)
+        {
+            freq_t freq = 0;
+
+            if (num_sscanf(val, "%"SCNfreq, &freq) == 1)
+            {
+                nc->freq = freq;
+                nc->valid |= NCACHE_FREQ;
+                rig_set_cache_freq(rig, priv->notify_vfo ? priv->notify_vfo :
+                                   RIG_VFO_CURR, freq);
+            }
+        }
+        else if (strcmp(tok, "mode") == 0)
+        {
+            mode = rig_parse_mode(val);
+            have_mode = 1;
+        }
+        else if (strcmp(tok, "width") == 0)
+        {
+            width = atol(val);
+        }
+        else if (strcmp(tok, "ptt") == 0)
+        {
+            nc->ptt = atoi(val);
+            nc->valid |= NCACHE_PTT;
+            cachep->ptt = nc->ptt;
+            elapsed_ms(&cachep->time_ptt, HAMLIB_ELAPSED_SET);
+        }
+        else if (strcmp(tok, "split") == 0)
+        {
+            nc->split = atoi(val);
+            cachep->split = nc->split;
+            elapsed_ms(&cachep->time_split, HAMLIB_ELAPSED_SET);
+        }
+        else if (strcmp(tok, "txvfo") == 0)
+        {
+            /* split and txvfo arrive as a pair */
+            nc->tx_vfo = rig_parse_vfo(val);
+            nc->valid |= NCACHE_SPLIT;
+            cachep->split_vfo = nc->tx_vfo;
+        }
+        else
+        {
+            for (i = 0; i < NCACHE_LEVELS; i++)
+            {
+                if (strcmp(tok, ncache_levels[i].key) == 0)
+                {
+                    nc->level[i] = (float)atof(val);
+                    nc->valid |= NCACHE_LEVEL(i);
+                    break;
+                }
+            }
+        }
+    }
+
+    /* mode and width arrive as a pair */
+    if (have_mode)
+    {
+        nc->mode = mode;
+        nc->width = width;
+        nc->valid |= NCACHE_MODE;
+        rig_set_cache_mode(rig, priv->notify_vfo ? priv->notify_vfo :
+                           RIG_VFO_CURR, mode, width);
+    }
+
+    pthread_mutex_unlock(&nc->lock);
+}
+
+static void *netrigctl_notify_thread(void *arg)
+{
+    RIG *rig = (RIG *)arg;
+    struct netrigctl_priv_data *priv;
+    char buf[BUF_MAX];
+    size_t len = 0;
+
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    while (priv->notify_running)
+    {
+        fd_set rfds;
+        struct timeval tv = { 0, 200 * 1000 };
+        char *nl;
+        int n;
+
+        FD_ZERO(&rfds);
+        FD_SET(priv->notify_sock, &rfds);
+
+        n = select(priv->notify_sock + 1, &rfds, NULL, NULL, &tv);
+
+        if (n <= 0)
+        {
+            continue;
+        }
+
+        n = recv(priv->notify_sock, buf + len, sizeof(buf) - 1 - len, 0);
+
+        if (n <= 0)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: change feed closed by rigctld\n",
+                      __func__);
+            break;
+        }
+
+        len += n;
+        buf[len] = '\0';
+
+        while ((nl = strchr(buf, '\n')) != NULL)
+        {
+            size_t used = nl - buf + 1;
+
+            *nl = '\0';
+            netrigctl_notify_apply(rig, buf);
+            memmove(buf, buf + used, len - used + 1);
+            len -= used;
+        }
+
+        /* An overlong line cannot be a notification: drop it */
+        if (len == sizeof(buf) - 1) { len = 0; }
+    }
+
+    /* Without the feed nothing keeps the read cache coherent */
+    priv->notify_live = 0;
+    ncache_invalidate(priv, ~0u);
+
+    return NULL;
+}
+
+/* Open the feed connection and subscribe.  Failure is not fatal: reads
+ * simply keep going to the server, as with an older rigctld. */
+static int netrigctl_notify_start(RIG *rig)
+{
+    struct netrigctl_priv_data *priv;
+    const hamlib_port_t *rp = RIGPORT(rig);
+    struct addrinfo hints, *res, *ai;
+    char host[HAMLIB_FILPATHLEN];
+    const char *port = "4532";
+    char cmd[CMD_MAX];
+    char reply[BUF_MAX];
+    char *colon;
+    int sock = -1;
+    int n;
+
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    /* pathname is "host", "host:port" or "[v6addr]:port" */
+    strncpy(host, rp->pathname, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+
+    if (host[0] == '[' && (colon = strchr(host, ']')) != NULL)
+    {
+        if (colon[1] == ':') { port = colon + 2; }
+
+        *colon = '\0';
+        memmove(host, host + 1, strlen(host));
+    }
+    else if ((colon = strchr(host, ':')) != NULL && colon == strrchr(host, ':'))
+    {
+        *colon = '\0';
+        port = colon + 1;
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(host, port, &hints, &res) != 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: cannot resolve %s\n", __func__, host);
+        return -RIG_EIO;
+    }
+
+    for (ai = res; ai; ai = ai->ai_next)
+    {
+        sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+        if (sock < 0) { continue; }
+
+        if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0) { break; }
+
+        socket_close(sock);
+        sock = -1;
+    }
+
+    freeaddrinfo(res);
+
+    if (sock < 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: cannot connect change feed\n", __func__);
+        return -RIG_EIO;
+    }
+
+    SNPRINTF(cmd, sizeof(cmd), "\\subscribe %s %d\n", NETRIGCTL_NOTIFY_ITEMS,
+             priv->notify_interval_ms);
+
+    /* The reply is one "RPRT n" line; pushes only start after it */
+    n = -1;
+
+    if (send(sock, cmd, strlen(cmd), 0) == (ssize_t)strlen(cmd))
+    {
+        size_t len = 0;
+
+        while (len < sizeof(reply) - 1)
+        {
+            if (recv(sock, reply + len, 1, 0) != 1) { break; }
+
+            if (reply[len++] == '\n') { break; }
+        }
+
+        reply[len] = '\0';
+
+        if (strncmp(reply, NETRIGCTL_RET, strlen(NETRIGCTL_RET)) == 0)
+        {
+            n = atoi(reply + strlen(NETRIGCTL_RET));
+        }
+    }
+
+    if (n != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: rigctld does not support \\subscribe, "
+                  "change feed off\n", __func__);
+        socket_close(sock);
+        return -RIG_ENAVAIL;
+    }
+
+    priv->notify_sock = sock;
+    priv->notify_vfo = RIG_VFO_NONE;
+    ncache_invalidate(priv, ~0u);
+    priv->ncache.vfo_moved = 0;
+    priv->notify_running = 1;
+    /* Entries become valid as the first, full, push arrives */
+    priv->notify_live = 1;
+
+    if (pthread_create(&priv->notify_thread, NULL, netrigctl_notify_thread,
+                       rig) != 0)
+    {
+        priv->notify_running = 0;
+        priv->notify_live = 0;
+        socket_close(sock);
+        priv->notify_sock = -1;
+        return -RIG_EINTERNAL;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: change feed active, interval=%dms\n",
+              __func__, priv->notify_interval_ms);
+
+    return RIG_OK;
+}
+
+static void netrigctl_notify_stop(RIG *rig)
+{
+    struct netrigctl_priv_data *priv;
+
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    if (priv->notify_sock < 0)
+    {
+        return;
+    }
+
+    priv->notify_running = 0;
+    pthread_join(priv->notify_thread, NULL);
+    socket_close(priv->notify_sock);
+    priv->notify_sock = -1;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: read cache hits=%lu misses=%lu\n",
+              __func__, priv->ncache.hits, priv->ncache.misses);
+}
+
 int parse_array_int(const char *s, const char *delim, int *array, int array_len)
 {
     char *p;
@@ -721,17 +1265,11 @@ static int netrigctl_open(RIG *rig)
 
                 if (!has) { rig->caps->get_freq = NULL; }
             }
-            else if (strcmp(setting, "has_set_conf") == 0)
+            else if (strcmp(setting, "has_set_conf") == 0
+                     || strcmp(setting, "has_get_conf") == 0)
             {
-                int has = strtol(value, NULL, 0);
-
-                if (!has) { rig->caps->set_conf = NULL; }
-            }
-            else if (strcmp(setting, "has_get_conf") == 0)
-            {
-                int has = strtol(value, NULL, 0);
-
-                if (!has) { rig->caps->get_conf = NULL; }
+                /* netrigctl's conf methods serve its own tokens, not the
+                 * remote rig's, so keep them whatever the server has */
             }
             else if (strcmp(setting, "has_get_ant") == 0)
             {
@@ -999,6 +1537,11 @@ static int netrigctl_open(RIG *rig)
         rig_set_powerstat(rig, 1);
     }
 
+    if (priv->notify_interval_ms > 0)
+    {
+        netrigctl_notify_start(rig);
+    }
+
     RETURNFUNC(RIG_OK);
 }
 
@@ -1015,6 +1558,8 @@ static int netrigctl_close(RIG *rig)
         rig_set_powerstat(rig, 0);
     }
 
+    netrigctl_notify_stop(rig);
+
     /* The session caps described the connection being torn down. */
     stream_set_session_caps(rig, NULL, 0);
 
@@ -1038,9 +1583,12 @@ static int netrigctl_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
     char cmd[CMD_MAX];
     char buf[BUF_MAX];
     char vfostr[16] = "";
+    struct netrigctl_priv_data *priv;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
 #if 1 // implement set_freq VFO later if it can be detected
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), vfo);
 
@@ -1058,10 +1606,16 @@ static int netrigctl_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
     {
         return -RIG_EPROTO;
     }
-    else
+
+    /* A rounded frequency is corrected by the next push */
+    if (ret == RIG_OK && ncache_lock_store(priv, NCACHE_FREQ, vfo))
     {
-        return ret;
+        priv->ncache.freq = freq;
+        priv->ncache.valid |= NCACHE_FREQ;
+        pthread_mutex_unlock(&priv->ncache.lock);
     }
+
+    return ret;
 }
 
 static int netrigctl_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
@@ -1074,9 +1628,20 @@ static int netrigctl_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     char vfotmp[16];
 #endif
 
+    struct netrigctl_priv_data *priv;
+
     rig_debug(RIG_DEBUG_VERBOSE, "%s called, vfo=%s\n", __func__,
               rig_strvfo(vfo));
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    if (ncache_lock_if(priv, NCACHE_FREQ, vfo))
+    {
+        *freq = priv->ncache.freq;
+        pthread_mutex_unlock(&priv->ncache.lock);
+        return RIG_OK;
+    }
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), vfo);
 
     if (ret != RIG_OK) { return ret; }
@@ -1117,9 +1682,12 @@ static int netrigctl_set_mode(RIG *rig, vfo_t vfo, rmode_t mode,
     char cmd[CMD_MAX];
     char buf[BUF_MAX];
     char vfostr[16] = "";
+    struct netrigctl_priv_data *priv;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called, vfo=%s\n", __func__, rig_strvfo(vfo));
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), vfo);
 
     if (ret != RIG_OK) { return ret; }
@@ -1133,10 +1701,25 @@ static int netrigctl_set_mode(RIG *rig, vfo_t vfo, rmode_t mode,
     {
         return -RIG_EPROTO;
     }
-    else
+
+    if (ret == RIG_OK && ncache_lock_store(priv, NCACHE_MODE, vfo))
     {
-        return ret;
+        /* The server picks the width for NORMAL/NOCHANGE: wait for the push */
+        if (width > 0)
+        {
+            priv->ncache.mode = mode;
+            priv->ncache.width = width;
+            priv->ncache.valid |= NCACHE_MODE;
+        }
+        else
+        {
+            priv->ncache.valid &= ~NCACHE_MODE;
+        }
+
+        pthread_mutex_unlock(&priv->ncache.lock);
     }
+
+    return ret;
 }
 
 
@@ -1147,9 +1730,20 @@ static int netrigctl_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
     char cmd[CMD_MAX];
     char buf[BUF_MAX];
     char vfostr[16] = "";
+    struct netrigctl_priv_data *priv;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called, vfo=%s\n", __func__, rig_strvfo(vfo));
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    if (ncache_lock_if(priv, NCACHE_MODE, vfo))
+    {
+        *mode = priv->ncache.mode;
+        *width = priv->ncache.width;
+        pthread_mutex_unlock(&priv->ncache.lock);
+        return RIG_OK;
+    }
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), vfo);
 
     if (ret != RIG_OK) { return ret; }
@@ -1203,6 +1797,28 @@ static int netrigctl_set_vfo(RIG *rig, vfo_t vfo)
 
     priv->vfo_curr = vfo; // remember our vfo
     STATE(rig)->current_vfo = vfo;
+
+    /* The push for the new VFO brings its freq, mode and levels.  Until
+     * then the entries for the pushed VFO are kept, so that switching back
+     * to it before the server notices serves them again. */
+    if (ret == RIG_OK && priv->notify_live)
+    {
+        struct netrigctl_ncache *nc = &priv->ncache;
+
+        pthread_mutex_lock(&nc->lock);
+
+        if (!(nc->valid & NCACHE_VFO))
+        {
+            nc->valid &= ~NCACHE_PER_VFO;
+        }
+        else if (vfo != RIG_VFO_CURR)
+        {
+            nc->vfo_moved = (vfo != nc->vfo);
+        }
+
+        pthread_mutex_unlock(&nc->lock);
+    }
+
     return ret;
 }
 
@@ -1218,6 +1834,14 @@ static int netrigctl_get_vfo(RIG *rig, vfo_t *vfo)
 
     priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
 
+    if (ncache_lock_if(priv, NCACHE_VFO, RIG_VFO_CURR))
+    {
+        *vfo = priv->ncache.vfo;
+        pthread_mutex_unlock(&priv->ncache.lock);
+        priv->vfo_curr = *vfo;
+        return RIG_OK;
+    }
+
     SNPRINTF(cmd, sizeof(cmd), "v\n");
 
     ret = netrigctl_transaction(rig, cmd, strlen(cmd), buf);
@@ -1251,11 +1875,14 @@ static int netrigctl_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
     char buf[BUF_MAX];
     char vfostr[16] = "";
     hamlib_port_t *pttp = PTTPORT(rig);
+    struct netrigctl_priv_data *priv;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called vfo=%s, ptt=%d, ptt_type=%d\n",
               __func__,
               rig_strvfo(vfo), ptt, pttp->type.ptt);
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
     if (pttp->type.ptt == RIG_PTT_NONE) { return RIG_OK; }
 
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), RIG_VFO_A);
@@ -1272,10 +1899,16 @@ static int netrigctl_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
     {
         return -RIG_EPROTO;
     }
-    else
+
+    if (ret == RIG_OK && ncache_lock_store(priv, NCACHE_PTT, vfo))
     {
-        return ret;
+        /* ON_MIC/ON_DATA may read back as plain ON; the next push says so */
+        priv->ncache.ptt = ptt;
+        priv->ncache.valid |= NCACHE_PTT;
+        pthread_mutex_unlock(&priv->ncache.lock);
     }
+
+    return ret;
 }
 
 
@@ -1285,9 +1918,19 @@ static int netrigctl_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     char cmd[CMD_MAX];
     char buf[BUF_MAX];
     char vfostr[16] = "";
+    struct netrigctl_priv_data *priv;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    if (ncache_lock_if(priv, NCACHE_PTT, vfo))
+    {
+        *ptt = priv->ncache.ptt;
+        pthread_mutex_unlock(&priv->ncache.lock);
+        return RIG_OK;
+    }
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), RIG_VFO_A);
 
     if (ret != RIG_OK) { return ret; }
@@ -1804,10 +2447,13 @@ static int netrigctl_set_split_vfo(RIG *rig, vfo_t vfo, split_t split,
     char cmd[CMD_MAX];
     char buf[BUF_MAX];
     char vfostr[16] = "";
+    struct netrigctl_priv_data *priv;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called vfo=%s, vfotx=%s, split=%d\n", __func__,
               rig_strvfo(vfo), rig_strvfo(tx_vfo), split);
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), RIG_VFO_A);
 
     if (ret != RIG_OK) { return ret; }
@@ -1820,10 +2466,16 @@ static int netrigctl_set_split_vfo(RIG *rig, vfo_t vfo, split_t split,
     {
         return -RIG_EPROTO;
     }
-    else
+
+    if (ret == RIG_OK && ncache_lock_store(priv, NCACHE_SPLIT, vfo))
     {
-        return ret;
+        priv->ncache.split = split;
+        priv->ncache.tx_vfo = tx_vfo;
+        priv->ncache.valid |= NCACHE_SPLIT;
+        pthread_mutex_unlock(&priv->ncache.lock);
     }
+
+    return ret;
 }
 
 
@@ -1834,9 +2486,20 @@ static int netrigctl_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
     char cmd[CMD_MAX];
     char buf[BUF_MAX];
     char vfostr[16] = "";
+    struct netrigctl_priv_data *priv;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
+    if (ncache_lock_if(priv, NCACHE_SPLIT, vfo))
+    {
+        *split = priv->ncache.split;
+        *tx_vfo = priv->ncache.tx_vfo;
+        pthread_mutex_unlock(&priv->ncache.lock);
+        return RIG_OK;
+    }
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), RIG_VFO_A);
 
     if (ret != RIG_OK) { return ret; }
@@ -2102,9 +2765,13 @@ static int netrigctl_set_level(RIG *rig, vfo_t vfo, setting_t level,
     char buf[BUF_MAX];
     char lstr[32];
     char vfostr[16] = "";
+    struct netrigctl_priv_data *priv;
+    int i;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+
     if (RIG_LEVEL_IS_FLOAT(level))
     {
         SNPRINTF(lstr, sizeof(lstr), "%f", val.f);
@@ -2127,11 +2794,18 @@ static int netrigctl_set_level(RIG *rig, vfo_t vfo, setting_t level,
     {
         return -RIG_EPROTO;
     }
-    else
+
+    i = ncache_level_index(level);
+
+    if (ret == RIG_OK && i >= 0
+            && ncache_lock_store(priv, NCACHE_LEVEL(i), vfo))
     {
-        return ret;
+        priv->ncache.level[i] = val.f;
+        priv->ncache.valid |= NCACHE_LEVEL(i);
+        pthread_mutex_unlock(&priv->ncache.lock);
     }
 
+    return ret;
 }
 
 
@@ -2142,9 +2816,21 @@ static int netrigctl_get_level(RIG *rig, vfo_t vfo, setting_t level,
     char cmd[CMD_MAX];
     char buf[BUF_MAX];
     char vfostr[16] = "";
+    struct netrigctl_priv_data *priv;
+    int i;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    priv = (struct netrigctl_priv_data *)STATE(rig)->priv;
+    i = ncache_level_index(level);
+
+    if (i >= 0 && ncache_lock_if(priv, NCACHE_LEVEL(i), vfo))
+    {
+        val->f = priv->ncache.level[i];
+        pthread_mutex_unlock(&priv->ncache.lock);
+        return RIG_OK;
+    }
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), vfo);
 
     if (ret != RIG_OK) { return ret; }
@@ -2907,7 +3593,7 @@ static int netrigctl_stream_open(RIG *rig, struct rig_stream *stream)
 {
     int ret;
     /* Larger than CMD_MAX: type + format + rate + key=value options. */
-    char cmd[128];
+    char cmd[160];
     char buf[BUF_MAX];
     hamlib_port_t *rp = RIGPORT(rig);
     struct rig_stream_net_session *sess;
@@ -2926,12 +3612,21 @@ static int netrigctl_stream_open(RIG *rig, struct rig_stream *stream)
      * any format conversion, so the full requested shape is forwarded:
      * channels (the server would otherwise default to 1 and serve
      * mislabeled data) and a native-only demand for it to enforce too. */
-    SNPRINTF(cmd, sizeof(cmd), "+\\stream_open %s %s %d channels=%d%s\n",
+    char decim[64] = "";
+
+    if (stream->config.iq_decimate)
+    {
+        SNPRINTF(decim, sizeof(decim), " iq_decimate=1 iq_shift=%.3f",
+                 stream->config.iq_shift);
+    }
+
+    SNPRINTF(cmd, sizeof(cmd), "+\\stream_open %s %s %d channels=%d%s%s\n",
              stream_type_name(stream->type),
              stream_format_name(stream->config.format),
              stream->config.sample_rate,
              stream->config.channels,
-             stream->config.require_native ? " require_native=1" : "");
+             stream->config.require_native ? " require_native=1" : "",
+             decim);
 
     ret = netrigctl_transaction(rig, cmd, strlen(cmd), buf);
 
@@ -3067,6 +3762,9 @@ static int netrigctl_stream_open(RIG *rig, struct rig_stream *stream)
     /* Rig-level transport_buffer defaults; per-stream config.transport_buffer_* overrides. */
     sess->transport_buffer_ms = STATE(rig)->stream_transport_buffer_ms;
     sess->transport_buffer_bytes = STATE(rig)->stream_transport_buffer_bytes;
+    sess->batch_depth = STATE(rig)->stream_batch_depth
+                        ? (int)STATE(rig)->stream_batch_depth
+                        : RIG_STREAM_BATCH_DEPTH_DEFAULT;
 
     /* Create UDP socket to rigctld */
     if (rig_stream_net_udp_connect(sess, host, udp_port) < 0)
@@ -3263,7 +3961,7 @@ struct rig_caps netrigctl_caps =
     RIG_MODEL(RIG_MODEL_NETRIGCTL),
     .model_name =     "NET rigctl",
     .mfg_name =       "Hamlib",
-    .version =        "20250211.0",
+    .version =        "20261019.1",
     .copyright =      "LGPL",
     .status =         RIG_STATUS_STABLE,
     .rig_type =       RIG_TYPE_OTHER,
@@ -3298,6 +3996,8 @@ struct rig_caps netrigctl_caps =
     .max_ifshift = 0,
     .priv =  NULL,
 
+    .cfgparams =    netrigctl_cfg_params,
+
     .rig_init =     netrigctl_init,
     .rig_cleanup =  netrigctl_cleanup,
     .rig_open =     netrigctl_open,
@@ -3310,6 +4010,9 @@ struct rig_caps netrigctl_caps =
     .set_vfo =      netrigctl_set_vfo,
     .get_vfo =      netrigctl_get_vfo,
 
+    .set_conf =     netrigctl_set_conf,
+    .get_conf =     netrigctl_get_conf,
+
     .set_powerstat =  netrigctl_set_powerstat,
     .get_powerstat =  netrigctl_get_powerstat,
     .set_level =     netrigctl_set_level,
@@ -42,6 +42,8 @@
 #include "hamlib/rig_state.h"
 #include "token.h"
 #include "stream_convert.h"     /* RIG_RESAMPLE_* quality constants */
+#include "spectrum_packet.h"
+#include "event.h"
 
 
 /*
@@ -195,10 +197,33 @@ static const struct confparams frontend_cfg_params[] =
     {
         TOK_STREAM_RESAMPLE_QUALITY, "stream_resample_quality",
         "Stream resampler quality",
-        "libsamplerate sinc converter for stream rate conversion, applied "
-        "to pipelines created after the change",
+        "Filter length of the stream rate converter, applied to pipelines "
+        "created after the change",
         "medium", RIG_CONF_COMBO, { .c = {{ "medium", "best", "fast", NULL }} }
     },
+    {
+        TOK_STREAM_OPUS_BITRATE, "stream_opus_bitrate",
+        "Opus stream bitrate in bits/s",
+        "Target bitrate of Opus streams encoded from PCM audio, applied to "
+        "streams opened after the change; 0 lets the codec choose, else "
+        "6000 to 510000",
+        "0", RIG_CONF_NUMERIC, { .n = {0, 510000, 1}}
+    },
+    {
+        TOK_STREAM_BATCH_DEPTH, "stream_batch_depth",
+        "Stream datagrams per system call",
+        "Most datagrams a stream sends or receives in one system call, with "
+        "UDP segmentation offload where the system has it. 1 sends and "
+        "receives them one at a time; 0 selects the built-in default (16)",
+        "0", RIG_CONF_NUMERIC, { .n = {0, 64, 1}}
+    },
+    {
+        TOK_STREAM_BATCH_WINDOW, "stream_batch_window",
+        "Stream batch window",
+        "Microseconds a stream sender waits for a fuller batch, bounding the "
+        "latency batching adds. 0 sends whatever is ready at once",
+        "0", RIG_CONF_NUMERIC, { .n = {0, 100000, 1}}
+    },
     {
         TOK_STREAM_KEEPALIVE_INTERVAL, "stream_keepalive_interval",
         "Stream keepalive ping interval in seconds",
@@ -287,6 +312,61 @@ static const struct confparams frontend_cfg_params[] =
         "Multicast data UDP port for sending commands to rig",
         "4532", RIG_CONF_NUMERIC, { .n = { 0, 1000000, 1 } }
     },
+    {
+        TOK_MULTICAST_SPECTRUM_FORMAT, "multicast_spectrum_format",
+        "Multicast spectrum format",
+        "Publish spectrum lines hex-encoded in the JSON snapshot, as compact "
+        "binary packets on the same address, or both",
+        "json", RIG_CONF_COMBO, { .c = {{ "json", "binary", "both", NULL }} }
+    },
+    {
+        TOK_MULTICAST_SPECTRUM_ENCODING, "multicast_spectrum_encoding",
+        "Multicast spectrum packet encoding",
+        "Bin encoding of binary spectrum packets; rle and delta fall back to "
+        "raw when they do not save space, auto picks the smallest",
+        "auto", RIG_CONF_COMBO, { .c = {{ "auto", "raw", "rle", "delta", NULL }} }
+    },
+    {
+        TOK_MULTICAST_SPECTRUM_PROCESS, "multicast_spectrum_process",
+        "Multicast spectrum processing",
+        "Processing of spectrum lines before multicast, comma-separated: "
+        "bins=N, decimate=max|mean, average=0..1, peak=DECAY, rate=LINES/S; "
+        "empty sends lines as received",
+        "", RIG_CONF_STRING,
+    },
+    {
+        TOK_SPECTRUM_CALLBACK_PROCESS, "spectrum_callback_process",
+        "Spectrum callback processing",
+        "Processing of spectrum lines before the spectrum callback, same "
+        "syntax as multicast_spectrum_process",
+        "", RIG_CONF_STRING,
+    },
+    {
+        TOK_MULTICAST_KEYFRAME_INTERVAL, "multicast_keyframe_interval",
+        "Multicast keyframe interval",
+        "Milliseconds between full multicast snapshots; in between only "
+        "changed fields are sent. 0 sends every snapshot in full",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 3600000, 1 } }
+    },
+    {
+        TOK_MULTICAST_BATCH_WINDOW, "multicast_batch_window",
+        "Multicast batch window",
+        "Microseconds the multicast publisher waits for more packets so that "
+        "they go out in one system call. 0 sends whatever is ready at once",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 100000, 1 } }
+    },
+    {
+        TOK_MULTICAST_HUB, "multicast_hub", "Multicast hub",
+        "True publishes through the one multicast thread and socket shared by "
+        "all rigs of the process that set it, tagged by rig",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_STATUS_SHM, "status_shm", "Shared-memory status page name",
+        "POSIX shared-memory object the poll routine mirrors the rig cache "
+        "and latest meter reads into, for local readers; empty disables it",
+        "", RIG_CONF_STRING,
+    },
     {
         TOK_FREQ_SKIP, "freq_skip", "Skip setting freq on non-active VFO",
         "True enables skipping setting the TX_VFO when RX_VFO is receiving and skips RX_VFO when TX_VFO is transmitting",
@@ -861,6 +941,34 @@ static int frontend_set_conf(RIG *rig, hamlib_token_t token, const char *val)
 
         break;
 
+    case TOK_STREAM_OPUS_BITRATE:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0 || val_i > 510000
+                || (val_i > 0 && val_i < 6000))
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->stream_opus_bitrate = (int)val_i;
+        break;
+
+    case TOK_STREAM_BATCH_DEPTH:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0 || val_i > 64)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->stream_batch_depth = (unsigned int)val_i;
+        break;
+
+    case TOK_STREAM_BATCH_WINDOW:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0 || val_i > 100000)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->stream_batch_window = (unsigned int)val_i;
+        break;
+
     case TOK_AUTO_POWER_ON:
         if (1 != sscanf(val, "%ld", &val_i))
         {
@@ -992,6 +1100,70 @@ static int frontend_set_conf(RIG *rig, hamlib_token_t token, const char *val)
         rs->multicast_cmd_addr = strdup(val);
         break;
 
+    case TOK_MULTICAST_SPECTRUM_FORMAT:
+        val_i = spectrum_packet_format_parse(val);
+
+        if (val_i < 0)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->multicast_spectrum_format = (int)val_i;
+        break;
+
+    case TOK_MULTICAST_SPECTRUM_ENCODING:
+        val_i = spectrum_packet_encoding_parse(val);
+
+        if (val_i < 0)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->multicast_spectrum_encoding = (int)val_i;
+        break;
+
+    case TOK_MULTICAST_SPECTRUM_PROCESS:
+        return rig_spectrum_stage_set(rig, SPECTRUM_SUBSCRIBER_MULTICAST, val);
+
+    case TOK_SPECTRUM_CALLBACK_PROCESS:
+        return rig_spectrum_stage_set(rig, SPECTRUM_SUBSCRIBER_CALLBACK, val);
+
+    case TOK_MULTICAST_KEYFRAME_INTERVAL:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0 || val_i > 3600000)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->multicast_keyframe_interval = (int)val_i;
+        break;
+
+    case TOK_MULTICAST_BATCH_WINDOW:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0 || val_i > 100000)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->multicast_batch_window = (int)val_i;
+        break;
+
+    case TOK_MULTICAST_HUB:
+        if (1 != sscanf(val, "%ld", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->multicast_hub = val_i ? 1 : 0;
+        break;
+
+    case TOK_STATUS_SHM:
+        if (strlen(val) >= sizeof(rs->status_shm))
+        {
+            return -RIG_EINVAL;
+        }
+
+        strcpy(rs->status_shm, val);
+        break;
+
     case TOK_MULTICAST_CMD_PORT:
         if (1 != sscanf(val, "%ld", &val_i))
         {
@@ -1426,6 +1598,18 @@ static int frontend_get_conf2(RIG *rig, hamlib_token_t token, char *val,
 
         break;
 
+    case TOK_STREAM_OPUS_BITRATE:
+        SNPRINTF(val, val_len, "%d", rs->stream_opus_bitrate);
+        break;
+
+    case TOK_STREAM_BATCH_DEPTH:
+        SNPRINTF(val, val_len, "%u", rs->stream_batch_depth);
+        break;
+
+    case TOK_STREAM_BATCH_WINDOW:
+        SNPRINTF(val, val_len, "%u", rs->stream_batch_window);
+        break;
+
     case TOK_AUTO_POWER_ON:
         SNPRINTF(val, val_len, "%d", rs->auto_power_on);
         break;
@@ -1494,6 +1678,40 @@ static int frontend_get_conf2(RIG *rig, hamlib_token_t token, char *val,
         SNPRINTF(val, val_len, "%d", rs->multicast_cmd_port);
         break;
 
+    case TOK_MULTICAST_SPECTRUM_FORMAT:
+        SNPRINTF(val, val_len, "%s",
+                 spectrum_packet_format_name(rs->multicast_spectrum_format));
+        break;
+
+    case TOK_MULTICAST_SPECTRUM_ENCODING:
+        SNPRINTF(val, val_len, "%s",
+                 spectrum_packet_encoding_name(rs->multicast_spectrum_encoding));
+        break;
+
+    case TOK_STATUS_SHM:
+        SNPRINTF(val, val_len, "%s", rs->status_shm);
+        break;
+
+    case TOK_MULTICAST_SPECTRUM_PROCESS:
+        return rig_spectrum_stage_get(rig, SPECTRUM_SUBSCRIBER_MULTICAST, val,
+                                      val_len);
+
+    case TOK_SPECTRUM_CALLBACK_PROCESS:
+        return rig_spectrum_stage_get(rig, SPECTRUM_SUBSCRIBER_CALLBACK, val,
+                                      val_len);
+
+    case TOK_MULTICAST_KEYFRAME_INTERVAL:
+        SNPRINTF(val, val_len, "%d", rs->multicast_keyframe_interval);
+        break;
+
+    case TOK_MULTICAST_BATCH_WINDOW:
+        SNPRINTF(val, val_len, "%d", rs->multicast_batch_window);
+        break;
+
+    case TOK_MULTICAST_HUB:
+        SNPRINTF(val, val_len, "%d", rs->multicast_hub);
+        break;
+
     case TOK_FREQ_SKIP:
         SNPRINTF(val, val_len, "%d", rs->freq_skip);
         break;
@@ -38,6 +38,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
 
 #include <pthread.h>
 
@@ -47,6 +48,8 @@
 #include "misc.h"
 #include "cache.h"
 #include "network.h"
+#include "status_page.h"
+#include "spectrum_proc.h"
 
 #define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !STATE(r)->comm_state)
 
@@ -61,191 +64,121 @@ typedef struct rig_poll_routine_priv_data_s
     rig_poll_routine_args args;
 } rig_poll_routine_priv_data;
 
-static void *rig_poll_routine(void *arg)
+/* Cache values whose change triggers a publish */
+struct rig_change_watch
+{
+    vfo_t vfo;
+    vfo_t tx_vfo;
+    freq_t freq[6];
+    rmode_t mode[6];
+    pbwidth_t width[6];
+    ptt_t ptt;
+    split_t split;
+};
+
+/* Take the current values into watch, returning whether any changed */
+static int rig_change_watch_update(RIG *rig, struct rig_change_watch *watch)
 {
-    rig_poll_routine_args *args = (rig_poll_routine_args *)arg;
-    RIG *rig = args->rig;
     struct rig_state *rs = STATE(rig);
     struct rig_cache *cachep = CACHE(rig);
-    int update_occurred;
-
-    vfo_t vfo = RIG_VFO_NONE, tx_vfo = RIG_VFO_NONE;
-    freq_t freq_main_a = 0, freq_main_b = 0, freq_main_c = 0, freq_sub_a = 0,
-           freq_sub_b = 0, freq_sub_c = 0;
-    rmode_t mode_main_a = 0, mode_main_b = 0, mode_main_c = 0, mode_sub_a = 0,
-            mode_sub_b = 0, mode_sub_c = 0;
-    pbwidth_t width_main_a = 0, width_main_b = 0, width_main_c = 0, width_sub_a = 0,
-              width_sub_b = 0, width_sub_c = 0;
-    ptt_t ptt = RIG_PTT_OFF;
-    split_t split = RIG_SPLIT_OFF;
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting rig poll routine thread\n",
-              __FILE__, __LINE__);
-
-    // Rig cache time should be equal to rig poll interval (should be set automatically by rigctld at least)
-    rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, rs->poll_interval);
+    struct rig_change_watch now;
+    int changed;
+
+    // Zeroed as a whole so that padding compares equal too
+    memset(&now, 0, sizeof(now));
+
+    now.vfo = rs->current_vfo;
+    now.tx_vfo = rs->tx_vfo;
+    now.freq[0] = cachep->freqMainA;
+    now.freq[1] = cachep->freqMainB;
+    now.freq[2] = cachep->freqMainC;
+    now.freq[3] = cachep->freqSubA;
+    now.freq[4] = cachep->freqSubB;
+    now.freq[5] = cachep->freqSubC;
+    now.mode[0] = cachep->modeMainA;
+    now.mode[1] = cachep->modeMainB;
+    now.mode[2] = cachep->modeMainC;
+    now.mode[3] = cachep->modeSubA;
+    now.mode[4] = cachep->modeSubB;
+    now.mode[5] = cachep->modeSubC;
+    now.width[0] = cachep->widthMainA;
+    now.width[1] = cachep->widthMainB;
+    now.width[2] = cachep->widthMainC;
+    now.width[3] = cachep->widthSubA;
+    now.width[4] = cachep->widthSubB;
+    now.width[5] = cachep->widthSubC;
+    now.ptt = cachep->ptt;
+    now.split = cachep->split;
+
+    changed = memcmp(&now, watch, sizeof(now)) != 0;
+    memcpy(watch, &now, sizeof(now));
+
+    return changed;
+}
 
+/**
+ * \brief Publish rig state whenever the cache changes
+ *
+ * Calls publish once at the start, then within change_detection_interval
+ * of any change to VFO, frequency, mode, passband, PTT or split in the
+ * cache, and at least every keepalive_ms while nothing changes.  A last
+ * publish is made once *run goes to zero.
+ */
+void rig_change_publisher(RIG *rig, volatile int *run, int keepalive_ms,
+                          rig_change_publish_cb publish)
+{
     // Attempt to detect changes with the interval below (in milliseconds)
-    int change_detection_interval = 50;
+    const int change_detection_interval = 50;
+    struct rig_change_watch watch;
     int interval_count = 0;
 
-    update_occurred = 0;
+    memset(&watch, 0, sizeof(watch));
+    rig_change_watch_update(rig, &watch);
 
-    network_publish_rig_poll_data(rig);
+    publish(rig);
 
-    while (rs->poll_routine_thread_run)
+    while (*run)
     {
-        if (rs->current_vfo != vfo)
-        {
-            vfo = rs->current_vfo;
-            update_occurred = 1;
-        }
-
-        if (rs->tx_vfo != tx_vfo)
-        {
-            tx_vfo = rs->tx_vfo;
-            update_occurred = 1;
-        }
-
-        if (cachep->freqMainA != freq_main_a)
-        {
-            freq_main_a = cachep->freqMainA;
-            update_occurred = 1;
-        }
-
-        if (cachep->freqMainB != freq_main_b)
-        {
-            freq_main_b = cachep->freqMainB;
-            update_occurred = 1;
-        }
-
-        if (cachep->freqMainC != freq_main_c)
-        {
-            freq_main_b = cachep->freqMainC;
-            update_occurred = 1;
-        }
-
-        if (cachep->freqSubA != freq_sub_a)
-        {
-            freq_sub_a = cachep->freqSubA;
-            update_occurred = 1;
-        }
-
-        if (cachep->freqSubB != freq_sub_b)
-        {
-            freq_sub_b = cachep->freqSubB;
-            update_occurred = 1;
-        }
-
-        if (cachep->freqSubC != freq_sub_c)
-        {
-            freq_sub_c = cachep->freqSubC;
-            update_occurred = 1;
-        }
-
-        if (cachep->ptt != ptt)
-        {
-            ptt = cachep->ptt;
-            update_occurred = 1;
-        }
-
-        if (cachep->split != split)
-        {
-            split = cachep->split;
-            update_occurred = 1;
-        }
-
-        if (cachep->modeMainA != mode_main_a)
-        {
-            mode_main_a = cachep->modeMainA;
-            update_occurred = 1;
-        }
-
-        if (cachep->modeMainB != mode_main_b)
-        {
-            mode_main_b = cachep->modeMainB;
-            update_occurred = 1;
-        }
-
-        if (cachep->modeMainC != mode_main_c)
-        {
-            mode_main_c = cachep->modeMainC;
-            update_occurred = 1;
-        }
-
-        if (cachep->modeSubA != mode_sub_a)
-        {
-            mode_sub_a = cachep->modeSubA;
-            update_occurred = 1;
-        }
-
-        if (cachep->modeSubB != mode_sub_b)
-        {
-            mode_sub_b = cachep->modeSubB;
-            update_occurred = 1;
-        }
-
-        if (cachep->modeSubC != mode_sub_c)
-        {
-            mode_sub_c = cachep->modeSubC;
-            update_occurred = 1;
-        }
-
-        if (cachep->widthMainA != width_main_a)
-        {
-            width_main_a = cachep->widthMainA;
-            update_occurred = 1;
-        }
-
-        if (cachep->widthMainB != width_main_b)
-        {
-            width_main_b = cachep->widthMainB;
-            update_occurred = 1;
-        }
-
-        if (cachep->widthMainC != width_main_c)
-        {
-            width_main_c = cachep->widthMainC;
-            update_occurred = 1;
-        }
-
-        if (cachep->widthSubA != width_sub_a)
-        {
-            width_sub_a = cachep->widthSubA;
-            update_occurred = 1;
-        }
-
-        if (cachep->widthSubB != width_sub_b)
-        {
-            width_sub_b = cachep->widthSubB;
-            update_occurred = 1;
-        }
-
-        if (cachep->widthSubC != width_sub_c)
-        {
-            width_sub_c = cachep->widthSubC;
-            update_occurred = 1;
-        }
-
-        if (update_occurred)
+        if (rig_change_watch_update(rig, &watch))
         {
-            network_publish_rig_poll_data(rig);
-            update_occurred = 0;
+            publish(rig);
             interval_count = 0;
         }
 
         hl_usleep(change_detection_interval * 1000);
         interval_count++;
 
-        // Publish updates every poll_interval if no changes have been detected
-        if (interval_count >= (rs->poll_interval / change_detection_interval))
+        // Publish updates every keepalive_ms if no changes have been detected
+        if (interval_count >= (keepalive_ms / change_detection_interval))
         {
             interval_count = 0;
-            network_publish_rig_poll_data(rig);
+            publish(rig);
         }
     }
 
+    publish(rig);
+}
+
+static void rig_poll_routine_publish(RIG *rig)
+{
     network_publish_rig_poll_data(rig);
+    status_page_publish(rig);
+}
+
+static void *rig_poll_routine(void *arg)
+{
+    rig_poll_routine_args *args = (rig_poll_routine_args *)arg;
+    RIG *rig = args->rig;
+    struct rig_state *rs = STATE(rig);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting rig poll routine thread\n",
+              __FILE__, __LINE__);
+
+    // Rig cache time should be equal to rig poll interval (should be set automatically by rigctld at least)
+    rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, rs->poll_interval);
+
+    rig_change_publisher(rig, &rs->poll_routine_thread_run, rs->poll_interval,
+                         rig_poll_routine_publish);
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Stopping rig poll routine thread\n",
               __FILE__,
@@ -809,8 +742,52 @@ static int print_spectrum_line(char *str, size_t length,
 }
 
 
+/* Reconfiguration from other threads is only recorded; the thread firing
+ * spectrum events owns the processing state and its output buffers */
+struct spectrum_stage
+{
+    pthread_mutex_t mutex;
+    struct spectrum_proc_config config[SPECTRUM_SUBSCRIBER_COUNT];
+    int changed[SPECTRUM_SUBSCRIBER_COUNT];
+    struct spectrum_proc proc[SPECTRUM_SUBSCRIBER_COUNT];
+};
+
+
+static void spectrum_stage_apply_config(struct spectrum_stage *stage)
+{
+    int i;
+
+    pthread_mutex_lock(&stage->mutex);
+
+    for (i = 0; i < SPECTRUM_SUBSCRIBER_COUNT; i++)
+    {
+        if (stage->changed[i])
+        {
+            spectrum_proc_init(&stage->proc[i], &stage->config[i]);
+            stage->changed[i] = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&stage->mutex);
+}
+
+
+static int64_t spectrum_stage_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
 int rig_fire_spectrum_event(RIG *rig, struct rig_spectrum_line *line)
 {
+    struct spectrum_stage *stage;
+    struct rig_spectrum_line processed;
+    int64_t now_us;
+
     ENTERFUNC;
 
     if (rig_need_debug(RIG_DEBUG_TRACE))
@@ -821,14 +798,123 @@ int rig_fire_spectrum_event(RIG *rig, struct rig_spectrum_line *line)
                   spectrum_debug);
     }
 
-    network_publish_rig_spectrum_data(rig, line);
+    stage = (struct spectrum_stage *) STATE(rig)->spectrum_stage_priv;
+
+    if (stage == NULL)
+    {
+        network_publish_rig_spectrum_data(rig, line);
+
+        if (rig->callbacks.spectrum_event)
+        {
+            rig->callbacks.spectrum_event(rig, line, rig->callbacks.spectrum_arg);
+        }
+
+        RETURNFUNC(RIG_OK);
+    }
+
+    spectrum_stage_apply_config(stage);
+    now_us = spectrum_stage_now_us();
+
+    if (spectrum_proc_run(&stage->proc[SPECTRUM_SUBSCRIBER_MULTICAST], line,
+                          now_us, &processed))
+    {
+        network_publish_rig_spectrum_data(rig, &processed);
+    }
 
-    if (rig->callbacks.spectrum_event)
+    if (rig->callbacks.spectrum_event
+            && spectrum_proc_run(&stage->proc[SPECTRUM_SUBSCRIBER_CALLBACK], line,
+                                 now_us, &processed))
     {
-        rig->callbacks.spectrum_event(rig, line, rig->callbacks.spectrum_arg);
+        rig->callbacks.spectrum_event(rig, &processed, rig->callbacks.spectrum_arg);
     }
 
     RETURNFUNC(RIG_OK);
 }
 
+
+/**
+ * \brief Set the spectrum processing of one subscriber
+ *
+ * \param subscriber SPECTRUM_SUBSCRIBER_*
+ * \param spec processing spec as described in spectrum_proc.h, "" for none
+ *
+ * \return RIG_OK, or -RIG_EINVAL for a malformed spec
+ */
+int rig_spectrum_stage_set(RIG *rig, int subscriber, const char *spec)
+{
+    struct rig_state *rs = STATE(rig);
+    struct spectrum_proc_config config;
+    struct spectrum_stage *stage;
+
+    if (subscriber < 0 || subscriber >= SPECTRUM_SUBSCRIBER_COUNT
+            || spectrum_proc_parse(spec, &config) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    stage = (struct spectrum_stage *) rs->spectrum_stage_priv;
+
+    if (stage == NULL)
+    {
+        if (spectrum_proc_is_passthrough(&config))
+        {
+            return RIG_OK;
+        }
+
+        stage = calloc(1, sizeof(*stage));
+
+        if (stage == NULL)
+        {
+            return -RIG_ENOMEM;
+        }
+
+        pthread_mutex_init(&stage->mutex, NULL);
+        rs->spectrum_stage_priv = stage;
+    }
+
+    pthread_mutex_lock(&stage->mutex);
+    stage->config[subscriber] = config;
+    stage->changed[subscriber] = 1;
+    pthread_mutex_unlock(&stage->mutex);
+
+    return RIG_OK;
+}
+
+
+int rig_spectrum_stage_get(RIG *rig, int subscriber, char *buf, size_t len)
+{
+    struct spectrum_stage *stage =
+        (struct spectrum_stage *) STATE(rig)->spectrum_stage_priv;
+
+    if (subscriber < 0 || subscriber >= SPECTRUM_SUBSCRIBER_COUNT || len == 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    buf[0] = '\0';
+
+    if (stage != NULL)
+    {
+        pthread_mutex_lock(&stage->mutex);
+        spectrum_proc_format(&stage->config[subscriber], buf, len);
+        pthread_mutex_unlock(&stage->mutex);
+    }
+
+    return RIG_OK;
+}
+
+
+void rig_spectrum_stage_free(RIG *rig)
+{
+    struct spectrum_stage *stage =
+        (struct spectrum_stage *) STATE(rig)->spectrum_stage_priv;
+
+    if (stage != NULL)
+    {
+        pthread_mutex_destroy(&stage->mutex);
+        free(stage);
+        STATE(rig)->spectrum_stage_priv = NULL;
+    }
+}
+
 /** @} */
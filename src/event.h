@@ -27,6 +27,10 @@
 int rig_poll_routine_start(RIG *rig);
 int rig_poll_routine_stop(RIG *rig);
 
+typedef void (*rig_change_publish_cb)(RIG *rig);
+void rig_change_publisher(RIG *rig, volatile int *run, int keepalive_ms,
+                          rig_change_publish_cb publish);
+
 int rig_fire_freq_event(RIG *rig, vfo_t vfo, freq_t freq);
 int rig_fire_mode_event(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width);
 int rig_fire_vfo_event(RIG *rig, vfo_t vfo);
@@ -35,5 +39,17 @@ int rig_fire_dcd_event(RIG *rig, vfo_t vfo, dcd_t dcd);
 int rig_fire_pltune_event(RIG *rig, vfo_t vfo, freq_t *freq, rmode_t *mode, pbwidth_t *width);
 int rig_fire_spectrum_event(RIG *rig, struct rig_spectrum_line *line);
 
+/* Consumers of spectrum lines, each processed as configured for it */
+enum spectrum_subscriber_e
+{
+    SPECTRUM_SUBSCRIBER_MULTICAST = 0,  /* Multicast data publisher */
+    SPECTRUM_SUBSCRIBER_CALLBACK,       /* Application spectrum callback */
+    SPECTRUM_SUBSCRIBER_COUNT
+};
+
+int rig_spectrum_stage_set(RIG *rig, int subscriber, const char *spec);
+int rig_spectrum_stage_get(RIG *rig, int subscriber, char *buf, size_t len);
+void rig_spectrum_stage_free(RIG *rig);
+
 #endif /* _EVENT_H */
 
@@ -0,0 +1,310 @@
+/*
+ *  Hamlib Interface - streaming JSON writer
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "hamlib/config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <locale.h>
+
+#include "json_writer.h"
+
+
+void json_writer_init(struct json_writer *w, char *buf, size_t size)
+{
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->need_comma = 0;
+    w->overflow = 0;
+
+    if (size > 0)
+    {
+        buf[0] = '\0';
+    }
+}
+
+
+int json_writer_finish(struct json_writer *w)
+{
+    if (w->overflow || w->len >= w->size)
+    {
+        if (w->size > 0)
+        {
+            w->buf[0] = '\0';
+        }
+
+        return -1;
+    }
+
+    w->buf[w->len] = '\0';
+
+    return (int)w->len;
+}
+
+
+/* Room for n more bytes plus the terminating NUL */
+static int reserve(struct json_writer *w, size_t n)
+{
+    if (w->overflow || w->size - w->len <= n)
+    {
+        w->overflow = 1;
+        return 0;
+    }
+
+    return 1;
+}
+
+
+static void put(struct json_writer *w, const char *s, size_t n)
+{
+    if (reserve(w, n))
+    {
+        memcpy(w->buf + w->len, s, n);
+        w->len += n;
+    }
+}
+
+
+static void put_char(struct json_writer *w, char c)
+{
+    if (reserve(w, 1))
+    {
+        w->buf[w->len++] = c;
+    }
+}
+
+
+static void put_quoted(struct json_writer *w, const char *s)
+{
+    static const char hex[] = "0123456789abcdef";
+    const unsigned char *p = (const unsigned char *)(s ? s : "");
+    const unsigned char *run = p;
+
+    put_char(w, '"');
+
+    for (; *p; p++)
+    {
+        char esc;
+
+        if (*p > 31 && *p != '"' && *p != '\\')
+        {
+            continue;
+        }
+
+        put(w, (const char *)run, p - run);
+        run = p + 1;
+
+        switch (*p)
+        {
+        case '"':  esc = '"'; break;
+
+        case '\\': esc = '\\'; break;
+
+        case '\b': esc = 'b'; break;
+
+        case '\f': esc = 'f'; break;
+
+        case '\n': esc = 'n'; break;
+
+        case '\r': esc = 'r'; break;
+
+        case '\t': esc = 't'; break;
+
+        default:
+        {
+            char u[6] = { '\\', 'u', '0', '0', hex[*p >> 4], hex[*p & 15] };
+            put(w, u, sizeof(u));
+            continue;
+        }
+        }
+
+        put_char(w, '\\');
+        put_char(w, esc);
+    }
+
+    put(w, (const char *)run, p - run);
+    put_char(w, '"');
+}
+
+
+/* Separator and member name ahead of a value */
+static void begin_value(struct json_writer *w, const char *key)
+{
+    if (w->need_comma)
+    {
+        put_char(w, ',');
+    }
+
+    if (key)
+    {
+        put_quoted(w, key);
+        put_char(w, ':');
+    }
+
+    w->need_comma = 1;
+}
+
+
+void json_write_begin_object(struct json_writer *w, const char *key)
+{
+    begin_value(w, key);
+    put_char(w, '{');
+    w->need_comma = 0;
+}
+
+
+void json_write_end_object(struct json_writer *w)
+{
+    put_char(w, '}');
+    w->need_comma = 1;
+}
+
+
+void json_write_begin_array(struct json_writer *w, const char *key)
+{
+    begin_value(w, key);
+    put_char(w, '[');
+    w->need_comma = 0;
+}
+
+
+void json_write_end_array(struct json_writer *w)
+{
+    put_char(w, ']');
+    w->need_comma = 1;
+}
+
+
+void json_write_string(struct json_writer *w, const char *key,
+                       const char *value)
+{
+    begin_value(w, key);
+    put_quoted(w, value);
+}
+
+
+/* Same rules as cJSON's print_number(): integral values that fit an int
+ * as such, others with the shortest of 15 or 17 significant digits that
+ * reads back the same */
+void json_write_number(struct json_writer *w, const char *key, double value)
+{
+    char num[32];
+    char point;
+    int n, i, as_int;
+    double test;
+
+    begin_value(w, key);
+
+    if (isnan(value) || isinf(value))
+    {
+        put(w, "null", 4);
+        return;
+    }
+
+    as_int = value >= INT_MAX ? INT_MAX
+             : value <= (double)INT_MIN ? INT_MIN : (int)value;
+
+    if (value == (double)as_int)
+    {
+        n = snprintf(num, sizeof(num), "%d", as_int);
+    }
+    else
+    {
+        n = snprintf(num, sizeof(num), "%1.15g", value);
+
+        if (sscanf(num, "%lg", &test) != 1
+                || fabs(test - value) > fmax(fabs(test), fabs(value)) * DBL_EPSILON)
+        {
+            n = snprintf(num, sizeof(num), "%1.17g", value);
+        }
+
+        /* JSON wants '.' whatever the locale */
+        point = localeconv()->decimal_point[0];
+
+        for (i = 0; i < n; i++)
+        {
+            if (num[i] == point)
+            {
+                num[i] = '.';
+            }
+        }
+    }
+
+    put(w, num, n);
+}
+
+
+void json_write_bool(struct json_writer *w, const char *key, int value)
+{
+    begin_value(w, key);
+
+    if (value)
+    {
+        put(w, "true", 4);
+    }
+    else
+    {
+        put(w, "false", 5);
+    }
+}
+
+
+void json_write_hex(struct json_writer *w, const char *key,
+                    const unsigned char *data, size_t len)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    size_t i;
+
+    begin_value(w, key);
+    put_char(w, '"');
+
+    if (reserve(w, 2 * len))
+    {
+        char *p = w->buf + w->len;
+
+        for (i = 0; i < len; i++)
+        {
+            *p++ = hex[data[i] >> 4];
+            *p++ = hex[data[i] & 15];
+        }
+
+        w->len += 2 * len;
+    }
+
+    put_char(w, '"');
+}
+
+
+void json_write_raw(struct json_writer *w, const char *json, size_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+
+    begin_value(w, NULL);
+    put(w, json, len);
+}
@@ -0,0 +1,74 @@
+/*
+ *  Hamlib Interface - streaming JSON writer
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Writes compact JSON straight into a caller-supplied buffer without any
+ * allocation.  Numbers and strings are formatted exactly as
+ * cJSON_PrintUnformatted() does, so the output can replace a cJSON tree.
+ *
+ * Every value writer takes the member name as key, or NULL for array
+ * elements and the top-level value; commas are inserted automatically.
+ * On overflow the writer stops writing and json_writer_finish() reports
+ * the error, so callers need to check only once at the end. */
+
+#ifndef _JSON_WRITER_H
+#define _JSON_WRITER_H 1
+
+#include <stddef.h>
+#include "hamlib/rig.h"
+
+__BEGIN_DECLS
+
+struct json_writer
+{
+    char *buf;
+    size_t size;
+    size_t len;
+    int need_comma;
+    int overflow;
+};
+
+void json_writer_init(struct json_writer *w, char *buf, size_t size);
+
+/* NUL-terminates the output; returns its length, or -1 on overflow */
+int json_writer_finish(struct json_writer *w);
+
+void json_write_begin_object(struct json_writer *w, const char *key);
+void json_write_end_object(struct json_writer *w);
+void json_write_begin_array(struct json_writer *w, const char *key);
+void json_write_end_array(struct json_writer *w);
+
+void json_write_string(struct json_writer *w, const char *key,
+                       const char *value);
+void json_write_number(struct json_writer *w, const char *key, double value);
+void json_write_bool(struct json_writer *w, const char *key, int value);
+
+/* String of data as uppercase hex digits, two per byte */
+void json_write_hex(struct json_writer *w, const char *key,
+                    const unsigned char *data, size_t len);
+
+/* Already serialized members or elements, e.g. cached by the caller from
+ * an earlier writer; separated from what precedes like a single value */
+void json_write_raw(struct json_writer *w, const char *json, size_t len);
+
+__END_DECLS
+
+#endif /* _JSON_WRITER_H */
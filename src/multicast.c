@@ -43,6 +43,8 @@
 #include "multicast.h"
 #include "network.h"
 #include "sprintflst.h"
+#include "event.h"
+#include "json_writer.h"
 
 // Multicast off by default
 #define RIG_MULTICAST_ADDR "0.0.0.0"
@@ -142,219 +144,172 @@ static int multicast_status_changed(RIG *rig)
 }
 #endif
 
-void json_add_string(char *msg, const char *key, const char *value,
-                     int addComma)
+void json_add_string(struct json_writer *w, const char *key,
+                     const char *value)
 {
-    strcat(msg, "\"");
-    strcat(msg, key);
-    strcat(msg, "\": ");
-    strcat(msg, "\"");
-    strcat(msg, value);
-    strcat(msg, "\"");
-
-    if (addComma) { strcat(msg, ",\n"); }
+    json_write_string(w, key, value);
 }
 
-void json_add_int(char *msg, const char *key, const int number, int addComma)
+void json_add_int(struct json_writer *w, const char *key, const int number)
 {
-
-    strcat(msg, "\"");
-    strcat(msg, key);
-    strcat(msg, "\": ");
-    char tmp[64];
-    sprintf(tmp, "%d", number);
-    strcat(msg, tmp);
-
-    if (addComma)
-    {
-        strcat(msg, ",\n");
-    }
+    json_write_number(w, key, number);
 }
 
 // cppcheck-suppress unusedFunction
-void json_add_double(char *msg, const char *key, const double value)
+void json_add_double(struct json_writer *w, const char *key,
+                     const double value)
 {
-    if (strlen(msg) != 0)
-    {
-        strcat(msg, ",\n");
-    }
-
-    strcat(msg, "\"");
-    strcat(msg, key);
-    strcat(msg, "\": ");
-    char tmp[64];
-    sprintf(tmp, "%f", value);
-    strcat(msg, tmp);
+    json_write_number(w, key, value);
 }
 
 // cppcheck-suppress unusedFunction
-void json_add_boolean(char *msg, const char *key, const int value, int addComma)
+void json_add_boolean(struct json_writer *w, const char *key,
+                      const int value)
 {
-
-    strcat(msg, "\"");
-    strcat(msg, key);
-    strcat(msg, "\": ");
-    char tmp[64];
-    sprintf(tmp, "%s", value == 0 ? "false" : "true");
-    strcat(msg, tmp);
-
-    if (addComma)
-    {
-        strcat(msg, ",\n");
-    }
+    json_write_bool(w, key, value);
 }
 
-void json_add_time(char *msg, int addComma)
+void json_add_time(struct json_writer *w)
 {
     char mydate[256];
     date_strget(mydate, sizeof(mydate), 0);
 
-
-    strcat(msg, "\"Time\": \"");
-    strcat(msg, mydate);
-    strcat(msg, "\"");
-
-    if (addComma)
-    {
-        strcat(msg, ",\n");
-    }
+    json_write_string(w, "Time", mydate);
 }
 
-void json_add_vfoA(RIG *rig, char *msg)
+static void json_add_vfo(struct json_writer *w, const char *name, freq_t freq,
+                         rmode_t mode, pbwidth_t width)
 {
-    struct rig_cache *cachep = CACHE(rig);
-    struct rig_state *rs = STATE(rig);
-
-    strcat(msg, "{\n");
-    json_add_string(msg, "Name", "VFOA", 1);
-    json_add_int(msg, "Freq", cachep->freqMainA, 1);
+    json_write_begin_object(w, NULL);
+    json_add_string(w, "Name", name);
+    json_add_int(w, "Freq", freq);
 
-    if (strlen(rig_strrmode(cachep->modeMainA)) > 0)
+    if (strlen(rig_strrmode(mode)) > 0)
     {
-        json_add_string(msg, "Mode", rig_strrmode(cachep->modeMainA), 1);
+        json_add_string(w, "Mode", rig_strrmode(mode));
     }
     else
     {
-        json_add_string(msg, "Mode", "None", 1);
+        json_add_string(w, "Mode", "None");
     }
 
-    json_add_int(msg, "Width", cachep->widthMainA, 0);
+    json_add_int(w, "Width", width);
+    json_write_end_object(w);
+}
+
+void json_add_vfoA(RIG *rig, struct json_writer *w)
+{
+    struct rig_cache *cachep = CACHE(rig);
+
+    json_add_vfo(w, "VFOA", cachep->freqMainA, cachep->modeMainA,
+                 cachep->widthMainA);
 
 #if 0 // not working quite yet
     // what about full duplex? rx_vfo would be in rx all the time?
-    rig_debug(RIG_DEBUG_ERR, "%s: rx_vfo=%s, tx_vfo=%s, split=%d\n", __func__,
-              rig_strvfo(rs->rx_vfo), rig_strvfo(rs->tx_vfo),
-              cachep->split);
-    printf("%s: rx_vfo=%s, tx_vfo=%s, split=%d\n", __func__,
-           rig_strvfo(rs->rx_vfo), rig_strvfo(rs->tx_vfo),
-           cachep->split);
+    struct rig_state *rs = STATE(rig);
 
     if (cachep->split)
     {
         if (rs->tx_vfo && (RIG_VFO_B | RIG_VFO_MAIN_B))
         {
-            json_add_boolean(msg, "RX", !cachep->ptt, 1);
-            json_add_boolean(msg, "TX", 0, 0);
+            json_add_boolean(w, "RX", !cachep->ptt);
+            json_add_boolean(w, "TX", 0);
         }
         else // we must be in reverse split
         {
-            json_add_boolean(msg, "RX", 0, 1);
-            json_add_boolean(msg, "TX", cachep->ptt, 0);
+            json_add_boolean(w, "RX", 0);
+            json_add_boolean(w, "TX", cachep->ptt);
         }
     }
     else if (rs->current_vfo && (RIG_VFO_A | RIG_VFO_MAIN_A))
     {
-        json_add_boolean(msg, "RX", !cachep->ptt, 1);
-        json_add_boolean(msg, "TX", cachep->ptt, 0);
+        json_add_boolean(w, "RX", !cachep->ptt);
+        json_add_boolean(w, "TX", cachep->ptt);
     }
     else // VFOB must be active so never RX or TX
     {
-        json_add_boolean(msg, "RX", 0, 1);
-        json_add_boolean(msg, "TX", 0, 0);
+        json_add_boolean(w, "RX", 0);
+        json_add_boolean(w, "TX", 0);
     }
 
 #endif
-    strcat(msg, "\n}");
 }
 
-void json_add_vfoB(RIG *rig, char *msg)
+void json_add_vfoB(RIG *rig, struct json_writer *w)
 {
     struct rig_cache *cachep = CACHE(rig);
-    struct rig_state *rs = STATE(rig);
-
-    strcat(msg, ",\n{\n");
-    json_add_string(msg, "Name", "VFOB", 1);
-    json_add_int(msg, "Freq", cachep->freqMainB, 1);
-
-    if (strlen(rig_strrmode(cachep->modeMainB)) > 0)
-    {
-        json_add_string(msg, "Mode", rig_strrmode(cachep->modeMainB), 1);
-    }
-    else
-    {
-        json_add_string(msg, "Mode", "None", 1);
-    }
 
-    json_add_int(msg, "Width", cachep->widthMainB, 0);
+    json_add_vfo(w, "VFOB", cachep->freqMainB, cachep->modeMainB,
+                 cachep->widthMainB);
 
 #if 0 // not working yet
+    struct rig_state *rs = STATE(rig);
 
     if (rs->rx_vfo != rs->tx_vfo && cachep->split)
     {
         if (rs->tx_vfo && (RIG_VFO_B | RIG_VFO_MAIN_B))
         {
-            json_add_boolean(msg, "RX", 0, 1);
-            json_add_boolean(msg, "TX", cachep->ptt, 0);
+            json_add_boolean(w, "RX", 0);
+            json_add_boolean(w, "TX", cachep->ptt);
         }
         else // we must be in reverse split
         {
-            json_add_boolean(msg, "RX", cachep->ptt, 1);
-            json_add_boolean(msg, "TX", 0, 0);
+            json_add_boolean(w, "RX", cachep->ptt);
+            json_add_boolean(w, "TX", 0);
         }
     }
     else if (rs->current_vfo && (RIG_VFO_A | RIG_VFO_MAIN_A))
     {
-        json_add_boolean(msg, "RX", !cachep->ptt, 1);
-        json_add_boolean(msg, "TX", cachep->ptt, 0);
+        json_add_boolean(w, "RX", !cachep->ptt);
+        json_add_boolean(w, "TX", cachep->ptt);
     }
     else // VFOB must be active so always RX or TX
     {
-        json_add_boolean(msg, "RX", 1, 1);
-        json_add_boolean(msg, "TX", 1, 0);
+        json_add_boolean(w, "RX", 1);
+        json_add_boolean(w, "TX", 1);
     }
 
 #endif
-
-    strcat(msg, "\n}\n]\n");
 }
 
 static int multicast_send_json(RIG *rig)
 {
     char msg[8192]; // could be pretty big
     char buf[4096];
+    struct json_writer w;
+    int len;
     struct rig_cache *cachep = CACHE(rig);
     struct rig_state *rs = STATE(rig);
 
-//    sprintf(msg,"%s:f=%.1f", date_strget(msg, (int)sizeof(msg), 0), f);
-    msg[0] = 0;
+    json_writer_init(&w, msg, sizeof(msg));
+    json_write_begin_object(&w, NULL);
     snprintf(buf, sizeof(buf), "%s:%s", rig->caps->model_name,
              RIGPORT(rig)->pathname);
-    strcat(msg, "{\n");
-    json_add_string(msg, "ID", buf, 1);
-    json_add_time(msg, 1);
-    json_add_int(msg, "Sequence", rs->multicast->seqnumber++, 1);
-    json_add_string(msg, "VFOCurr", rig_strvfo(rs->current_vfo), 1);
-    json_add_int(msg, "PTT", cachep->ptt, 1);
-    json_add_int(msg, "Split", cachep->split, 1);
+    json_add_string(&w, "ID", buf);
+    json_add_time(&w);
+    json_add_int(&w, "Sequence", rs->multicast->seqnumber++);
+    json_add_string(&w, "VFOCurr", rig_strvfo(rs->current_vfo));
+    json_add_int(&w, "PTT", cachep->ptt);
+    json_add_int(&w, "Split", cachep->split);
     rig_sprintf_mode(buf, sizeof(buf), rs->mode_list);
-    json_add_string(msg, "ModeList", buf, 1);
-    strcat(msg, "\"VFOs\": [\n");
-    json_add_vfoA(rig, msg);
-    json_add_vfoB(rig, msg);
-    strcat(msg, "}\n");
+    json_add_string(&w, "ModeList", buf);
+    json_write_begin_array(&w, "VFOs");
+    json_add_vfoA(rig, &w);
+    json_add_vfoB(rig, &w);
+    json_write_end_array(&w);
+    json_write_end_object(&w);
+
+    len = json_writer_finish(&w);
+
+    if (len < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: status packet does not fit %d bytes\n",
+                  __func__, (int)sizeof(msg));
+        return -RIG_EINTERNAL;
+    }
 
     // send the thing
-    multicast_send(rig, msg, strlen(msg));
+    multicast_send(rig, msg, len);
     return 0;
 }
 
@@ -393,96 +348,30 @@ void *multicast_thread_rx(void *vrig)
     return NULL;
 }
 
-#define LOOPCOUNT 50
+static void multicast_publish(RIG *rig)
+{
+    if (STATE(rig)->powerstat == RIG_POWER_OFF)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: waiting for RIG_POWER_ON\n", __func__);
+        return;
+    }
+
+    multicast_send_json(rig);
+}
+
+// Status is resent this often when nothing changes
+#define MULTICAST_KEEPALIVE_MS 500
 // cppcheck-suppress unusedFunction
 void *multicast_thread(void *vrig)
 {
-    //int retval;
     RIG *rig = (RIG *)vrig;
-    //rig_debug(RIG_DEBUG_TRACE, "%s: started\n", __func__);
-
-    // do the 1st packet all the time
-    //multicast_status_changed(rig);
-    //multicast_send_json(rig);
-    int loopcount = LOOPCOUNT;
-
-    freq_t freqA, freqAsave = 0;
-    freq_t freqB, freqBsave = 0;
-    rmode_t modeA, modeAsave = 0;
-    rmode_t modeB, modeBsave = 0;
-    ptt_t ptt, pttsave = 0;
-    struct rig_cache *cachep = CACHE(rig);
     struct rig_state *rs = STATE(rig);
 
     rs->multicast->runflag = 1;
 
-    while (rs->multicast->runflag)
-    {
-        while (STATE(rig)->powerstat == RIG_POWER_OFF)
-        {
-            rig_debug(RIG_DEBUG_VERBOSE, "%s: waiting for RIG_POWER_ON\n", __func__);
-            hl_usleep(500 * 1000);
-        }
-
-#if 0
-
-        if ((retval = rig_get_freq(rig, RIG_VFO_A, &freqA)) != RIG_OK)
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: rig_get_freqA:%s\n", __func__, rigerror(retval));
-        }
-
-        if ((rig->caps->targetable_vfo & RIG_TARGETABLE_FREQ)
-                && (retval = rig_get_freq(rig, RIG_VFO_B, &freqB)) != RIG_OK)
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: rig_get_freqB:%s\n", __func__, rigerror(retval));
-        }
-        else
-        {
-            freqB = cachep->freqMainB;
-        }
-
-#else
-        freqA = cachep->freqMainA;
-        freqB = cachep->freqMainB;
-        modeA = cachep->modeMainA;
-        modeB = cachep->modeMainB;
-        ptt = cachep->ptt;
-#endif
-
-        if (freqA != freqAsave
-                || freqB != freqBsave
-                || modeA != modeAsave
-                || modeB != modeBsave
-                || ptt != pttsave
-                || loopcount-- <= 0)
-        {
-#if 0
-
-            if (loopcount <= 0)
-            {
-                rig_debug(RIG_DEBUG_CACHE, "%s: sending multicast packet timeout\n", __func__);
-            }
-            else { rig_debug(RIG_DEBUG_ERR, "%s: sending multicast packet due to change\n", __func__); }
-
-#endif
-
-//            multicast_status_changed(rig);
-            multicast_send_json(rig);
-            freqAsave = freqA;
-            freqBsave = freqB;
-            modeAsave = modeA;
-            modeBsave = modeB;
-            pttsave = ptt;
-            loopcount = LOOPCOUNT;
-        }
-        else
-        {
-            //rig_debug(RIG_DEBUG_VERBOSE, "%s: loop\n", __func__);
-            hl_usleep(10 * 1000);
-        }
-
-
-    }
+    // Same change detection as the rig poll routine, sending our own packet
+    rig_change_publisher(rig, &rs->multicast->runflag, MULTICAST_KEEPALIVE_MS,
+                         multicast_publish);
 
 #ifdef _WIN32
     WSACleanup();
@@ -41,6 +41,8 @@
 #include <fcntl.h>   /* File control definitions */
 #include <errno.h>   /* Error number definitions */
 #include <sys/types.h>
+#include <sys/time.h>
+#include <time.h>
 #include <signal.h>
 #include <pthread.h>
 
@@ -78,8 +80,11 @@
 #include "hamlib/rig_state.h"
 #include "network.h"
 #include "misc.h"
-#include "asyncpipe.h"
 #include "snapshot_data.h"
+#include "spectrum_packet.h"
+#include "spectrum_ring.h"
+#include "udp_batch.h"
+#include "cJSON.h"
 
 #ifdef HAVE_WINDOWS_H
 // cppcheck-suppress missingInclude
@@ -98,48 +103,64 @@ static int is_networked(char *address, int address_length);
 #define NET_BUFFER_SIZE 8192
 //! @endcond
 
-#define MULTICAST_PUBLISHER_DATA_PACKET_TYPE_POLL       0x01
-#define MULTICAST_PUBLISHER_DATA_PACKET_TYPE_TRANSCEIVE 0x02
-#define MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM   0x03
-
-#pragma pack(push,1)
-typedef struct multicast_publisher_data_packet_s
-{
-    uint8_t type;
-    uint8_t padding;
-    uint16_t data_length;
-} __attribute__((packed)) multicast_publisher_data_packet;
-#pragma pack(pop)
+struct multicast_publisher_thread_s;
 
+/* What one rig has to publish */
 typedef struct multicast_publisher_args_s
 {
     RIG *rig;
-    int socket_fd;
     const char *multicast_addr;
     int multicast_port;
 
-#if defined(WIN32) && defined(HAVE_WINDOWS_H)
-    hamlib_async_pipe_t *data_pipe;
-#else
-    int data_write_fd;
-    int data_read_fd;
-#endif
-
-    pthread_mutex_t write_lock;
+    /* Spectrum lines from the thread that parses them, see spectrum_ring.h */
+    struct spectrum_ring spectrum_ring;
+    int snapshot_pending;       /* Poll or transceive update to publish */
+    int keyframe_requested;     /* A receiver lost track of the deltas */
+
+    /* Kept by the publisher thread */
+    struct multicast_publisher_thread_s *thread;
+    uint32_t source;            /* Rig number in hub packets, 0 = own thread */
+    struct snapshot_static snapshot_static;
+    struct snapshot_delta snapshot_delta;
+    uint32_t spectrum_seq;
+    struct multicast_publisher_args_s *next;    /* Next rig of the thread */
 } multicast_publisher_args;
 
-typedef struct multicast_publisher_priv_data_s
+/* A publisher thread with its socket, serving one rig or, as the hub,
+ * every rig opened with multicast_hub set */
+typedef struct multicast_publisher_thread_s
 {
     pthread_t thread_id;
+    volatile int run;
+    int socket_fd;
+    struct sockaddr_in dest_addr;
+    int batch_window;           /* Microseconds, see multicast_batch_window */
+    multicast_publisher_args *sources;  /* Changed only under lock */
+    int waiting;                /* Publisher is asleep on wakeup */
+    pthread_mutex_t lock;       /* Held by the publisher unless asleep */
+    pthread_cond_t wakeup;
+
+    /* Packets are built here and sent a batch at a time */
+    struct udp_batch batch;
+} multicast_publisher_thread;
+
+typedef struct multicast_publisher_priv_data_s
+{
     multicast_publisher_args args;
 } multicast_publisher_priv_data;
 
+/* The process-wide publisher of the rigs with multicast_hub set */
+static pthread_mutex_t multicast_hub_lock = PTHREAD_MUTEX_INITIALIZER;
+static multicast_publisher_thread *multicast_hub;
+static uint32_t multicast_hub_last_source;
+
 typedef struct multicast_receiver_args_s
 {
     RIG *rig;
     int socket_fd;
     const char *multicast_addr;
     int multicast_port;
+    struct udp_recv_batch recv_batch;
 } multicast_receiver_args;
 
 typedef struct multicast_receiver_priv_data_s
@@ -514,511 +535,275 @@ int network_close(hamlib_port_t *rp)
 
 //! @cond Doxygen_Suppress
 
-#define MULTICAST_DATA_PIPE_TIMEOUT_MILLIS 1000
 #define MULTICAST_DATA_PIPE_TIMEOUT_USEC 100000
 
-#if defined(WIN32) && defined(HAVE_WINDOWS_H)
-
-static int multicast_publisher_create_data_pipe(multicast_publisher_priv_data
-        *mcast_publisher_priv)
+/* Wake the publisher if it went to sleep; the fence orders the caller's
+ * commit before the check, pairing with the one in multicast_publisher_wait() */
+static void multicast_publisher_notify(multicast_publisher_args *args)
 {
-    int status;
+    multicast_publisher_thread *thread = args->thread;
 
-    status = async_pipe_create(&mcast_publisher_priv->args.data_pipe,
-                               PIPE_BUFFER_SIZE_DEFAULT, MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-    if (status != 0)
+    if (__atomic_load_n(&thread->waiting, __ATOMIC_RELAXED))
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: multicast publisher data pipe creation failed with status=%d, err=%s\n",
-                  __func__,
-                  status, strerror(errno));
-        return (-RIG_EINTERNAL);
+        pthread_mutex_lock(&thread->lock);
+        pthread_cond_signal(&thread->wakeup);
+        pthread_mutex_unlock(&thread->lock);
     }
-
-    return (RIG_OK);
 }
 
-static void multicast_publisher_close_data_pipe(multicast_publisher_priv_data
-        *mcast_publisher_priv)
+/* 1 when a rig of the thread has something to publish */
+static int multicast_publisher_ready(multicast_publisher_thread *thread)
 {
-    if (mcast_publisher_priv->args.data_pipe != NULL)
-    {
-        async_pipe_close(mcast_publisher_priv->args.data_pipe);
-        mcast_publisher_priv->args.data_pipe = NULL;
-    }
-}
-
-static int multicast_publisher_write_data(multicast_publisher_args
-        *mcast_publisher_args, size_t length, const unsigned char *data)
-{
-    ssize_t result;
-
-    result = async_pipe_write(mcast_publisher_args->data_pipe, data, length,
-                              MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
-
-    if (result < 0)
-    {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: error writing to multicast publisher data pipe, result=%d\n", __func__,
-                  (int)result);
-        return (-RIG_EIO);
-    }
+    multicast_publisher_args *args;
 
-    if (result != length)
+    for (args = thread->sources; args != NULL; args = args->next)
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: could not write to multicast publisher data pipe, expected %d bytes, wrote %d bytes\n",
-                  __func__, (int)length, (int)result);
-        return (-RIG_EIO);
+        if (!spectrum_ring_empty(&args->spectrum_ring)
+                || __atomic_load_n(&args->snapshot_pending, __ATOMIC_RELAXED))
+        {
+            return 1;
+        }
     }
 
-    return (RIG_OK);
+    return 0;
 }
 
-static int multicast_publisher_read_data(multicast_publisher_args
-        const *mcast_publisher_args, size_t length, unsigned char *data)
+/* Sleep, with thread->lock held, until there is something to publish or
+ * timeout_usec passes, at most MULTICAST_DATA_PIPE_TIMEOUT_USEC so that a
+ * stop request is noticed */
+static void multicast_publisher_wait(multicast_publisher_thread *thread,
+                                     long timeout_usec)
 {
-    ssize_t result;
+    struct timespec deadline;
 
-    result = async_pipe_wait_for_data(mcast_publisher_args->data_pipe, 100);
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += timeout_usec * 1000;
 
-    if (result < 0)
+    while (deadline.tv_nsec >= 1000000000)
     {
-        // Timeout is expected when there is no data
-        if (result != -RIG_ETIMEOUT)
-        {
-            rig_debug(RIG_DEBUG_ERR,
-                      "%s: error waiting for multicast publisher data, result=%ld\n", __func__,
-                      (long) result);
-        }
-
-        return (result);
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
     }
 
-    result = async_pipe_read(mcast_publisher_args->data_pipe, data, length,
-                             MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
+    __atomic_store_n(&thread->waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-    if (result < 0)
+    if (!multicast_publisher_ready(thread))
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: error reading multicast publisher data, result=%ld\n", __func__,
-                  (long) result);
-        return (-RIG_EIO);
+        pthread_cond_timedwait(&thread->wakeup, &thread->lock, &deadline);
     }
 
-    if (result != length)
-    {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: could not read from multicast publisher data pipe, expected %ld bytes, read %ld bytes\n",
-                  __func__, (long) length, (long) result);
-        return (-RIG_EIO);
-    }
-
-    return (RIG_OK);
+    __atomic_store_n(&thread->waiting, 0, __ATOMIC_RELAXED);
 }
 
-#else
-
-static int multicast_publisher_create_data_pipe(multicast_publisher_priv_data
-        *mcast_publisher_priv)
+static int network_publish_snapshot(RIG *rig)
 {
-    int data_pipe_fds[2];
-    int status;
-
-    status = pipe(data_pipe_fds);
+    const struct rig_state *rs = STATE(rig);
+    multicast_publisher_priv_data *mcast_publisher_priv;
 
-    if (status != 0)
+    if (rs->multicast_publisher_priv_data == NULL)
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: multicast publisher data pipe creation failed with status=%d, err=%s\n",
-                  __func__,
-                  status, strerror(errno));
-        return (-RIG_EINTERNAL);
+        // Silently ignore call if multicast publisher is not enabled
+        return RIG_OK;
     }
 
-    int flags = fcntl(data_pipe_fds[0], F_GETFD);
-    flags |= O_NONBLOCK;
-
-    if (fcntl(data_pipe_fds[0], F_SETFD, flags))
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: error setting O_NONBLOCK on pipe=%s\n", __func__,
-                  strerror(errno));
-    }
+    mcast_publisher_priv = (multicast_publisher_priv_data *)
+                           rs->multicast_publisher_priv_data;
 
-    mcast_publisher_priv->args.data_read_fd = data_pipe_fds[0];
-    mcast_publisher_priv->args.data_write_fd = data_pipe_fds[1];
+    // Updates coming in faster than they are sent go out as one snapshot
+    __atomic_store_n(&mcast_publisher_priv->args.snapshot_pending, 1,
+                     __ATOMIC_RELEASE);
+    multicast_publisher_notify(&mcast_publisher_priv->args);
 
-    return (RIG_OK);
+    return RIG_OK;
 }
 
-static void multicast_publisher_close_data_pipe(multicast_publisher_priv_data
-        *mcast_publisher_priv)
+int network_publish_rig_poll_data(RIG *rig)
 {
-    if (mcast_publisher_priv->args.data_read_fd != -1)
-    {
-        close(mcast_publisher_priv->args.data_read_fd);
-        mcast_publisher_priv->args.data_read_fd = -1;
-    }
-
-    if (mcast_publisher_priv->args.data_write_fd != -1)
-    {
-        close(mcast_publisher_priv->args.data_write_fd);
-        mcast_publisher_priv->args.data_write_fd = -1;
-    }
+    return network_publish_snapshot(rig);
 }
 
-static int multicast_publisher_write_data(const multicast_publisher_args
-        *mcast_publisher_args, size_t length, const unsigned char *data)
+int network_publish_rig_transceive_data(RIG *rig)
 {
-    int fd = mcast_publisher_args->data_write_fd;
-    ssize_t result;
-
-    result = write(fd, data, length);
-
-    if (result < 0)
-    {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: error writing to multicast publisher data pipe, result=%d, err=%s\n",
-                  __func__,
-                  (int)result, strerror(errno));
-        return (-RIG_EIO);
-    }
-
-    if (result != length)
-    {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: could not write to multicast publisher data pipe, expected %ld bytes, wrote %ld bytes\n",
-                  __func__, (long) length, (long) result);
-        return (-RIG_EIO);
-    }
-
-    return (RIG_OK);
+    return network_publish_snapshot(rig);
 }
 
-static int multicast_publisher_read_data(const multicast_publisher_args
-        *mcast_publisher_args, size_t length, unsigned char *data)
+/* Make the next snapshot a keyframe, see snapshot_data.h */
+int network_publish_rig_keyframe(RIG *rig)
 {
-    int fd = mcast_publisher_args->data_read_fd;
-    fd_set rfds, efds;
-    struct timeval timeout;
-    ssize_t result;
-    int retval;
-    int retries = 2;
-    size_t offset = 0;
-    size_t length_left = length;
-
-retry:
-    timeout.tv_sec = 0;
-    timeout.tv_usec = MULTICAST_DATA_PIPE_TIMEOUT_USEC;
-
-    FD_ZERO(&rfds);
-    FD_SET(fd, &rfds);
-    efds = rfds;
-
-    retval = select(fd + 1, &rfds, NULL, &efds, &timeout);
-
-    if (retval == 0)
-    {
-        return (-RIG_ETIMEOUT);
-    }
-
-    if (retval < 0)
-    {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s(): select() failed when reading multicast publisher data: %s\n",
-                  __func__,
-                  strerror(errno));
-
-        return -RIG_EIO;
-    }
-
-    if (FD_ISSET(fd, &efds))
-    {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s(): fd error when reading multicast publisher data: %s\n",
-                  __func__,
-                  strerror(errno));
-
-        return -RIG_EIO;
-    }
-
-    result = read(fd, data + offset, length_left);
-
-    if (result < 0)
-    {
-        if (errno == EAGAIN)
-        {
-            return (-RIG_ETIMEOUT);
-        }
-
-        rig_debug(RIG_DEBUG_ERR, "%s: error reading multicast publisher data: %s\n",
-                  __func__, strerror(errno));
-        return (-RIG_EIO);
-    }
-
-    offset += result;
-    length_left -= result;
+    const struct rig_state *rs = STATE(rig);
+    multicast_publisher_priv_data *mcast_publisher_priv;
 
-    if (length_left > 0)
+    if (rs->multicast_publisher_priv_data == NULL)
     {
-        if (retries > 0)
-        {
-            // Execution of this routine may time out between writes to pipe, retry to get more data
-            rig_debug(RIG_DEBUG_VERBOSE,
-                      "%s: could not read from multicast publisher data pipe, expected %ld bytes, read %ld bytes, retrying...\n",
-                      __func__, (long) length, (long) offset);
-            retries--;
-            goto retry;
-        }
-
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: could not read from multicast publisher data pipe even after retries, expected %ld bytes, read %ld bytes\n",
-                  __func__, (long) length, (long) offset);
-
-        return (-RIG_EIO);
+        return RIG_OK;
     }
 
-    return (RIG_OK);
-}
+    mcast_publisher_priv = (multicast_publisher_priv_data *)
+                           rs->multicast_publisher_priv_data;
 
-#endif
+    __atomic_store_n(&mcast_publisher_priv->args.keyframe_requested, 1,
+                     __ATOMIC_RELEASE);
 
-static void multicast_publisher_write_lock(RIG *rig)
-{
-    struct rig_state *rs = STATE(rig);
-    multicast_publisher_priv_data *priv_data = (multicast_publisher_priv_data *)
-            rs->multicast_publisher_priv_data;
-    pthread_mutex_lock(&priv_data->args.write_lock);
+    return network_publish_snapshot(rig);
 }
 
-static void multicast_publisher_write_unlock(RIG *rig)
-{
-    struct rig_state *rs = STATE(rig);
-    multicast_publisher_priv_data *priv_data = (multicast_publisher_priv_data *)
-            rs->multicast_publisher_priv_data;
-    pthread_mutex_unlock(&priv_data->args.write_lock);
-}
-
-static int multicast_publisher_write_packet_header(RIG *rig,
-        multicast_publisher_data_packet *packet)
+/* Must only be called from one thread at a time: the spectrum ring has a
+ * single producer, which is the thread firing spectrum events */
+int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line)
 {
+    int result;
     struct rig_state *rs = STATE(rig);
     multicast_publisher_priv_data *mcast_publisher_priv;
-    multicast_publisher_args *mcast_publisher_args;
-    ssize_t result;
 
     if (rs->multicast_publisher_priv_data == NULL)
     {
-        // Silently ignore if multicast publisher is not enabled
+        // Silently ignore call if multicast publisher is not enabled
         return RIG_OK;
     }
 
     mcast_publisher_priv = (multicast_publisher_priv_data *)
                            rs->multicast_publisher_priv_data;
-    mcast_publisher_args = &mcast_publisher_priv->args;
 
-    result = multicast_publisher_write_data(
-                 mcast_publisher_args, sizeof(multicast_publisher_data_packet),
-                 (unsigned char *) packet);
+    result = spectrum_ring_put(&mcast_publisher_priv->args.spectrum_ring, line);
+
+    if (result == -RIG_ENAVAIL)
+    {
+        // The publisher is behind; dropping a line beats stalling the reader
+        rig_debug(RIG_DEBUG_TRACE,
+                  "%s: spectrum ring full, line dropped (%u dropped in total)\n",
+                  __func__, mcast_publisher_priv->args.spectrum_ring.dropped);
+        return RIG_OK;
+    }
 
     if (result != RIG_OK)
     {
+        rig_debug(RIG_DEBUG_ERR, "%s: invalid spectrum line of %d bytes\n", __func__,
+                  (int)line->spectrum_data_length);
         return result;
     }
 
+    multicast_publisher_notify(&mcast_publisher_priv->args);
+
     return RIG_OK;
 }
 
-int network_publish_rig_poll_data(RIG *rig)
+/* Queue a spectrum line as a binary packet (see spectrum_packet.h) */
+static void multicast_publisher_queue_spectrum(struct udp_batch *batch,
+        multicast_publisher_args *args, const struct rig_spectrum_line *line)
 {
-    const struct rig_state *rs = STATE(rig);
-    int result;
-    multicast_publisher_data_packet packet =
-    {
-        .type = MULTICAST_PUBLISHER_DATA_PACKET_TYPE_POLL,
-        .padding = 0,
-        .data_length = 0,
-    };
+    unsigned char *packet = udp_batch_reserve(batch, SPECTRUM_PACKET_MAX_SIZE);
+    struct timeval tv;
+    uint64_t time_us;
+    int length;
 
-    if (rs->multicast_publisher_priv_data == NULL)
+    gettimeofday(&tv, NULL);
+    time_us = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+
+    length = spectrum_packet_encode(line, args->spectrum_seq++, time_us,
+                                    STATE(args->rig)->multicast_spectrum_encoding, packet,
+                                    SPECTRUM_PACKET_MAX_SIZE);
+
+    if (length < 0)
     {
-        // Silently ignore call if multicast publisher is not enabled
-        return RIG_OK;
+        rig_debug(RIG_DEBUG_ERR, "%s: error encoding spectrum packet, result=%d\n",
+                  __func__, length);
+        return;
     }
 
-    multicast_publisher_write_lock(rig);
-    result = multicast_publisher_write_packet_header(rig, &packet);
-    multicast_publisher_write_unlock(rig);
-    return result;
+    spectrum_packet_set_source(packet, args->source);
+    udp_batch_commit(batch, length);
 }
 
-int network_publish_rig_transceive_data(RIG *rig)
+static uint64_t multicast_publisher_now_us(void)
 {
-    const struct rig_state *rs = STATE(rig);
-    int result;
-    multicast_publisher_data_packet packet =
-    {
-        .type = MULTICAST_PUBLISHER_DATA_PACKET_TYPE_TRANSCEIVE,
-        .padding = 0,
-        .data_length = 0,
-    };
+    struct timespec ts;
 
-    if (rs->multicast_publisher_priv_data == NULL)
-    {
-        // Silently ignore call if multicast publisher is not enabled
-        return RIG_OK;
-    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    multicast_publisher_write_lock(rig);
-    result = multicast_publisher_write_packet_header(rig, &packet);
-    multicast_publisher_write_unlock(rig);
-    return result;
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
 }
 
-int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line)
+/* Queue a JSON snapshot, keyframe or delta, with line in its "spectra" when
+ * not NULL */
+static void multicast_publisher_queue_snapshot(struct udp_batch *batch,
+        multicast_publisher_args *args, struct rig_spectrum_line *line)
 {
+    char *snapshot_buffer = (char *)udp_batch_reserve(batch,
+                            HAMLIB_MAX_SNAPSHOT_PACKET_SIZE);
     int result;
-    struct rig_state *rs = STATE(rig);
-    multicast_publisher_priv_data *mcast_publisher_priv;
-    multicast_publisher_args *mcast_publisher_args;
-    multicast_publisher_data_packet packet =
-    {
-        .type = MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM,
-        .padding = 0,
-        .data_length = sizeof(struct rig_spectrum_line) + line->spectrum_data_length,
-    };
-
-    if (rs->multicast_publisher_priv_data == NULL)
-    {
-        // Silently ignore call if multicast publisher is not enabled
-        return RIG_OK;
-    }
-
-    // Acquire write lock to write all data in one go to the pipe
-    multicast_publisher_write_lock(rig);
-
-    result = multicast_publisher_write_packet_header(rig, &packet);
-
-    if (result != RIG_OK)
-    {
-        multicast_publisher_write_unlock(rig);
-        RETURNFUNC2(result);
-    }
-
-    mcast_publisher_priv = (multicast_publisher_priv_data *)
-                           rs->multicast_publisher_priv_data;
-    mcast_publisher_args = &mcast_publisher_priv->args;
 
-    result = multicast_publisher_write_data(
-                 mcast_publisher_args, sizeof(struct rig_spectrum_line), (unsigned char *) line);
+    result = snapshot_serialize_delta(HAMLIB_MAX_SNAPSHOT_PACKET_SIZE,
+                                      snapshot_buffer, args->rig, &args->snapshot_static, &args->snapshot_delta,
+                                      line, multicast_publisher_now_us() / 1000);
 
     if (result != RIG_OK)
     {
-        multicast_publisher_write_unlock(rig);
-        RETURNFUNC2(result);
+        rig_debug(RIG_DEBUG_ERR, "%s: error serializing rig snapshot data, result=%d\n",
+                  __func__, result);
+        return;
     }
 
-    result = multicast_publisher_write_data(
-                 mcast_publisher_args, line->spectrum_data_length, line->spectrum_data);
-
-    multicast_publisher_write_unlock(rig);
-
-    if (result != RIG_OK)
-    {
-        RETURNFUNC2(result);
-    }
+    rig_debug(RIG_DEBUG_CACHE, "%s: sending rig snapshot data: %s\n", __func__,
+              snapshot_buffer);
 
-    RETURNFUNC2(RIG_OK);
+    udp_batch_commit(batch, strlen(snapshot_buffer));
 }
 
-static int multicast_publisher_read_packet(multicast_publisher_args
-        const *mcast_publisher_args,
-        uint8_t *type, struct rig_spectrum_line *spectrum_line,
-        unsigned char *spectrum_data)
+/* Take one item from each rig in turn; returns 1 if there was any */
+static int multicast_publisher_pass(multicast_publisher_thread *thread)
 {
-    int result;
-    multicast_publisher_data_packet packet;
-
-    result = multicast_publisher_read_data(mcast_publisher_args, sizeof(packet),
-                                           (unsigned char *) &packet);
-
-    if (result < 0)
-    {
-        return (result);
-    }
+    multicast_publisher_args *args;
+    int work = 0;
 
-    switch (packet.type)
+    for (args = thread->sources; args != NULL; args = args->next)
     {
-    case MULTICAST_PUBLISHER_DATA_PACKET_TYPE_POLL:
-    case MULTICAST_PUBLISHER_DATA_PACKET_TYPE_TRANSCEIVE:
-        break;
+        const struct rig_state *rs = STATE(args->rig);
+        struct spectrum_ring_slot *slot = spectrum_ring_peek(&args->spectrum_ring);
 
-    case MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM:
-        result = multicast_publisher_read_data(
-                     mcast_publisher_args, sizeof(struct rig_spectrum_line),
-                     (unsigned char *) spectrum_line);
-
-        if (result < 0)
+        if (__atomic_exchange_n(&args->keyframe_requested, 0, __ATOMIC_ACQ_REL))
         {
-            return (result);
+            args->snapshot_delta.keyframe_pending = 1;
         }
 
-        if (packet.data_length - sizeof(struct rig_spectrum_line) !=
-                spectrum_line->spectrum_data_length)
+        if (slot != NULL)
         {
-            rig_debug(RIG_DEBUG_ERR,
-                      "%s: multicast publisher data error, expected %d bytes of spectrum data, got %d bytes\n",
-                      __func__, (int)spectrum_line->spectrum_data_length,
-                      (int)(packet.data_length - sizeof(struct rig_spectrum_line)));
-            return (-RIG_EPROTO);
-        }
-
-        spectrum_line->spectrum_data = spectrum_data;
+            // Serialized straight from the ring slot the line was put in
+            if (rs->multicast_spectrum_format != SPECTRUM_FORMAT_JSON)
+            {
+                multicast_publisher_queue_spectrum(&thread->batch, args, &slot->line);
+            }
 
-        result = multicast_publisher_read_data(mcast_publisher_args,
-                                               spectrum_line->spectrum_data_length, spectrum_data);
+            if (rs->multicast_spectrum_format != SPECTRUM_FORMAT_BINARY)
+            {
+                multicast_publisher_queue_snapshot(&thread->batch, args, &slot->line);
+            }
 
-        if (result < 0)
+            spectrum_ring_release(&args->spectrum_ring);
+            work = 1;
+        }
+        else if (__atomic_exchange_n(&args->snapshot_pending, 0, __ATOMIC_ACQ_REL))
         {
-            return (result);
+            multicast_publisher_queue_snapshot(&thread->batch, args, NULL);
+            work = 1;
         }
-
-        break;
-
-    default:
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: unexpected multicast publisher data packet type: %d\n", __func__,
-                  packet.type);
-        return (-RIG_EPROTO);
     }
 
-    *type = packet.type;
-
-    return (RIG_OK);
+    return work;
 }
 
 static void *multicast_publisher(void *arg)
 {
-    unsigned char spectrum_data[HAMLIB_MAX_SPECTRUM_DATA];
-    char snapshot_buffer[HAMLIB_MAX_SNAPSHOT_PACKET_SIZE];
 #ifdef __MINGW32__
     char ip4[32];
 #endif
 
-    struct multicast_publisher_args_s *args = (struct multicast_publisher_args_s *)
-            arg;
-    RIG *rig = args->rig;
-    struct rig_state *rs = STATE(rig);
-    struct rig_spectrum_line spectrum_line;
-    uint8_t packet_type = MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM;
-    multicast_publisher_priv_data *mcast_publisher_priv =
-        (multicast_publisher_priv_data *)
-        rs->multicast_publisher_priv_data;
-
-    struct sockaddr_in dest_addr;
-    int socket_fd = args->socket_fd;
-    ssize_t send_result;
+    multicast_publisher_thread *thread = (multicast_publisher_thread *) arg;
+    struct udp_batch *batch = &thread->batch;
+    struct udp_batch_stats stats;
+    uint64_t batch_start_us = 0;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting multicast publisher\n", __FILE__,
               __LINE__);
@@ -1034,74 +819,52 @@ static void *multicast_publisher(void *arg)
 
 #endif
 
-    snapshot_init();
-
-    memset(&dest_addr, 0, sizeof(dest_addr));
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_addr.s_addr = inet_addr(args->multicast_addr);
-    dest_addr.sin_port = htons(args->multicast_port);
-
-    rs->multicast_publisher_run = 1;
-
-    while (rs->multicast_publisher_run)
+    while (thread->run)
     {
-        int result;
+        int queued = batch->count;
 
-        result = multicast_publisher_read_packet(args, &packet_type, &spectrum_line,
-                 spectrum_data);
+        // Rigs come and go under the lock, so it is dropped between passes
+        pthread_mutex_lock(&thread->lock);
 
-        if (result != RIG_OK)
+        if (multicast_publisher_pass(thread))
         {
-            if (result == -RIG_ETIMEOUT)
+            if (queued == 0 && batch->count > 0)
             {
-                continue;
+                batch_start_us = multicast_publisher_now_us();
             }
-
-            // TODO: how to detect closing of pipe, indicate with error code
-            // TODO: error handling, flush pipe in case of error?
-            hl_usleep(100 * 1000);
-            continue;
         }
-
-        result = snapshot_serialize(sizeof(snapshot_buffer), snapshot_buffer, rig,
-                                    packet_type == MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM ? &spectrum_line :
-                                    NULL);
-
-        if (result != RIG_OK)
+        else if (batch->count > 0)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: error serializing rig snapshot data, result=%d\n",
-                      __func__, result);
-            continue;
-        }
-
-        rig_debug(RIG_DEBUG_CACHE, "%s: sending rig snapshot data: %s\n", __func__,
-                  snapshot_buffer);
+            // Nothing else ready: hold the batch for the rest of the window
+            uint64_t waited_us = multicast_publisher_now_us() - batch_start_us;
 
-        send_result = sendto(
-                          socket_fd,
-                          snapshot_buffer,
-                          strlen(snapshot_buffer),
-                          0,
-                          (struct sockaddr *) &dest_addr,
-                          sizeof(dest_addr)
-                      );
-
-        if (send_result < 0)
-        {
-            static int flag = 0;
-
-            if (errno != 0 || flag == 0)
+            if (waited_us < (uint64_t)thread->batch_window)
+            {
+                multicast_publisher_wait(thread, thread->batch_window - (long)waited_us);
+            }
+            else
             {
-                rig_debug(RIG_DEBUG_ERR,
-                          "%s: error sending UDP packet: %s, send result=%d\n", __func__,
-                          strerror(errno), (int)send_result);
-                flag = 1;
+                udp_batch_flush(batch);
             }
         }
+        else
+        {
+            multicast_publisher_wait(thread, MULTICAST_DATA_PIPE_TIMEOUT_USEC);
+        }
+
+        pthread_mutex_unlock(&thread->lock);
     }
 
-    rs->multicast_publisher_run = 0;
-    mcast_publisher_priv->thread_id = 0;
+    if (batch->count > 0)
+    {
+        udp_batch_flush(batch);
+    }
+
+    udp_batch_stats_get(&batch->stats, &stats);
+    rig_debug(RIG_DEBUG_VERBOSE,
+              "%s: sent %llu packets in %llu system calls, %llu failed\n", __func__,
+              (unsigned long long)stats.packets, (unsigned long long)stats.syscalls,
+              (unsigned long long)stats.errors);
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Stopped multicast publisher\n", __FILE__,
               __LINE__);
@@ -1343,9 +1106,29 @@ int is_wireless()
 #endif
 #endif
 
+/* {"request":"keyframe"} from a receiver that lost snapshot deltas */
+static int multicast_receiver_is_keyframe_request(const char *data)
+{
+    cJSON *root = cJSON_Parse(data);
+    const cJSON *request;
+    int is_request;
+
+    if (root == NULL)
+    {
+        return 0;
+    }
+
+    request = cJSON_GetObjectItemCaseSensitive(root, "request");
+    is_request = cJSON_IsString(request)
+                 && strcmp(request->valuestring, "keyframe") == 0;
+
+    cJSON_Delete(root);
+
+    return is_request;
+}
+
 static void *multicast_receiver(void *arg)
 {
-    char data[4096];
     char ip4[INET6_ADDRSTRLEN] = "";
 
     struct multicast_receiver_args_s *args = (struct multicast_receiver_args_s *)
@@ -1358,6 +1141,7 @@ static void *multicast_receiver(void *arg)
 
     struct sockaddr_in dest_addr;
     int socket_fd = args->socket_fd;
+    struct udp_recv_batch *recv_batch = &args->recv_batch;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting multicast receiver\n", __FILE__,
               __LINE__);
@@ -1478,12 +1262,10 @@ static void *multicast_receiver(void *arg)
 
     while (rs->multicast_receiver_run)
     {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
         fd_set rfds, efds;
         struct timeval timeout;
         int select_result;
-        ssize_t result;
+        int result, i;
 
         timeout.tv_sec = 0;
         timeout.tv_usec = MULTICAST_DATA_PIPE_TIMEOUT_USEC;
@@ -1525,32 +1307,40 @@ static void *multicast_receiver(void *arg)
             break;
         }
 
-        result = recvfrom(socket_fd, data, sizeof(data), 0,
-                          (struct sockaddr *) &client_addr, &client_len);
+        // Everything queued on the socket, in one call where supported
+        result = udp_recv_batch(recv_batch, socket_fd);
 
-        if (result <= 0)
+        if (result < 0)
         {
-            if (result < 0)
+            if (errno == 0)
             {
-                if (errno == 0 || errno == EAGAIN || errno == EWOULDBLOCK)
-                {
-                    continue;
-                }
-
-                rig_debug(RIG_DEBUG_ERR, "%s: error receiving from UDP socket %s:%d: %s\n",
-                          __func__,
-                          args->multicast_addr, args->multicast_port, strerror(errno));
+                continue;
             }
 
+            rig_debug(RIG_DEBUG_ERR, "%s: error receiving from UDP socket %s:%d: %s\n",
+                      __func__,
+                      args->multicast_addr, args->multicast_port, strerror(errno));
             break;
         }
 
-        // TODO: handle commands from multicast clients
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: received %ld bytes of data: %.*s\n", __func__,
-                  (long) result, (int) result, data);
+        for (i = 0; i < result; i++)
+        {
+            const char *data = recv_batch->data[i];
+
+            // TODO: handle commands from multicast clients
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: received %ld bytes of data: %s\n", __func__,
+                      (long) recv_batch->length[i], data);
 
-        // TODO: if a new snapshot needs to be sent, call network_publish_rig_poll_data() and the publisher routine will send out a snapshot
-        // TODO: new logic in publisher needs to be written for other types of responses
+            if (multicast_receiver_is_keyframe_request(data))
+            {
+                // A data receiver missed a delta, resynchronize it
+                network_publish_rig_keyframe(rig);
+                continue;
+            }
+
+            // TODO: if a new snapshot needs to be sent, call network_publish_rig_poll_data() and the publisher routine will send out a snapshot
+            // TODO: new logic in publisher needs to be written for other types of responses
+        }
     }
 
     rs->multicast_receiver_run = 0;
@@ -1563,10 +1353,234 @@ static void *multicast_receiver(void *arg)
 
 //! @endcond
 
+/* Open a socket and start a publisher thread sending to it, without rigs */
+static int multicast_publisher_thread_start(multicast_publisher_thread
+        **thread_out, const char *multicast_addr, int multicast_port,
+        int batch_window)
+{
+    multicast_publisher_thread *thread;
+    int socket_fd;
+    int status;
+    int mutex_status;
+
+    socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (socket_fd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: error opening new UDP socket: %s", __func__,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    // Enable non-blocking mode
+    u_long mode = 1;
+#ifdef __MINGW32__
+
+    if (ioctlsocket(socket_fd, FIONBIO, &mode) == SOCKET_ERROR)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: error enabling non-blocking mode for socket: %s",
+                  __func__,
+                  strerror(errno));
+        close(socket_fd);
+        return -RIG_EIO;
+    }
+
+#else
+
+    if (ioctl(socket_fd, FIONBIO, &mode) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: error enabling non-blocking mode for socket: %s",
+                  __func__,
+                  strerror(errno));
+        close(socket_fd);
+        return -RIG_EIO;
+    }
+
+#endif
+
+    thread = calloc(1, sizeof(multicast_publisher_thread));
+
+    if (thread == NULL)
+    {
+        close(socket_fd);
+        return -RIG_ENOMEM;
+    }
+
+    thread->socket_fd = socket_fd;
+    thread->batch_window = batch_window;
+    thread->dest_addr.sin_family = AF_INET;
+    thread->dest_addr.sin_addr.s_addr = inet_addr(multicast_addr);
+    thread->dest_addr.sin_port = htons(multicast_port);
+    udp_batch_init(&thread->batch, socket_fd, &thread->dest_addr,
+                   sizeof(thread->dest_addr));
+
+    mutex_status = pthread_mutex_init(&thread->lock, NULL);
+    status = pthread_cond_init(&thread->wakeup, NULL);
+
+    if (status != 0 || mutex_status != 0)
+    {
+        if (mutex_status == 0)
+        {
+            pthread_mutex_destroy(&thread->lock);
+        }
+
+        if (status == 0)
+        {
+            pthread_cond_destroy(&thread->wakeup);
+        }
+
+        free(thread);
+        close(socket_fd);
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: multicast publisher wakeup creation failed\n", __func__);
+        return -RIG_EINTERNAL;
+    }
+
+    thread->run = 1;
+
+    int err = pthread_create(&thread->thread_id, NULL, multicast_publisher,
+                             thread);
+
+    if (err)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s(%d) pthread_create error %s\n", __FILE__, __LINE__,
+                  strerror(errno));
+        pthread_cond_destroy(&thread->wakeup);
+        pthread_mutex_destroy(&thread->lock);
+        free(thread);
+        close(socket_fd);
+        return -RIG_EINTERNAL;
+    }
+
+    *thread_out = thread;
+
+    return RIG_OK;
+}
+
+/* Stop the thread, sending what it has queued, and free it */
+static void multicast_publisher_thread_stop(multicast_publisher_thread *thread)
+{
+    int err;
+
+    thread->run = 0;
+
+    pthread_mutex_lock(&thread->lock);
+    pthread_cond_signal(&thread->wakeup);
+    pthread_mutex_unlock(&thread->lock);
+
+    err = pthread_join(thread->thread_id, NULL);
+
+    if (err)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s(%d): pthread_join error %s\n", __FILE__, __LINE__,
+                  strerror(errno));
+        // just ignore it
+    }
+
+    close(thread->socket_fd);
+    pthread_cond_destroy(&thread->wakeup);
+    pthread_mutex_destroy(&thread->lock);
+    free(thread);
+}
+
+/* Hand a rig to a running thread */
+static void multicast_publisher_thread_add(multicast_publisher_thread *thread,
+        multicast_publisher_args *args)
+{
+    args->thread = thread;
+
+    pthread_mutex_lock(&thread->lock);
+    args->next = thread->sources;
+    thread->sources = args;
+    pthread_mutex_unlock(&thread->lock);
+}
+
+/* Take a rig back; the thread no longer touches it on return */
+static void multicast_publisher_thread_remove(multicast_publisher_thread
+        *thread, multicast_publisher_args *args)
+{
+    multicast_publisher_args **p;
+
+    pthread_mutex_lock(&thread->lock);
+
+    for (p = &thread->sources; *p != NULL; p = &(*p)->next)
+    {
+        if (*p == args)
+        {
+            *p = args->next;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&thread->lock);
+}
+
+/* Publish a rig through the hub, starting the hub for the first one.
+ * -RIG_ECONF when the hub already sends to another address or port. */
+static int multicast_hub_attach(multicast_publisher_args *args)
+{
+    const struct rig_state *rs = STATE(args->rig);
+    int result = RIG_OK;
+
+    pthread_mutex_lock(&multicast_hub_lock);
+
+    if (multicast_hub == NULL)
+    {
+        result = multicast_publisher_thread_start(&multicast_hub,
+                 args->multicast_addr, args->multicast_port, rs->multicast_batch_window);
+    }
+    else if (multicast_hub->dest_addr.sin_addr.s_addr
+             != inet_addr(args->multicast_addr)
+             || multicast_hub->dest_addr.sin_port != htons(args->multicast_port))
+    {
+        result = -RIG_ECONF;
+    }
+
+    if (result == RIG_OK)
+    {
+        // Numbers are not reused, a receiver may still know the old rig
+        args->source = ++multicast_hub_last_source;
+        result = snapshot_init_source(&args->snapshot_static, args->rig,
+                                      args->source);
+
+        if (result == RIG_OK)
+        {
+            multicast_publisher_thread_add(multicast_hub, args);
+        }
+        else if (multicast_hub->sources == NULL)
+        {
+            multicast_publisher_thread_stop(multicast_hub);
+            multicast_hub = NULL;
+        }
+    }
+
+    pthread_mutex_unlock(&multicast_hub_lock);
+
+    return result;
+}
+
+/* Stop publishing a rig through the hub, stopping the hub after the last */
+static void multicast_hub_detach(multicast_publisher_args *args)
+{
+    pthread_mutex_lock(&multicast_hub_lock);
+
+    multicast_publisher_thread_remove(multicast_hub, args);
+
+    if (multicast_hub->sources == NULL)
+    {
+        multicast_publisher_thread_stop(multicast_hub);
+        multicast_hub = NULL;
+    }
+
+    pthread_mutex_unlock(&multicast_hub_lock);
+}
+
 /**
  * \brief Start multicast publisher
  *
- * Start multicast publisher.
+ * Start multicast publisher.  With the multicast_hub option the rig is
+ * published by the one publisher thread and socket of the process, shared
+ * with the other rigs that set it.
  *
  * \param multicast_addr UDP address
  * \param multicast_port UDP socket port
@@ -1577,9 +1591,8 @@ int network_multicast_publisher_start(RIG *rig, const char *multicast_addr,
 {
     struct rig_state *rs = STATE(rig);
     multicast_publisher_priv_data *mcast_publisher_priv;
-    int socket_fd;
+    multicast_publisher_thread *thread;
     int status;
-    int mutex_status;
 #ifdef __MINGW32__
     char ip4[32];
 #endif
@@ -1625,39 +1638,6 @@ int network_multicast_publisher_start(RIG *rig, const char *multicast_addr,
         RETURNFUNC(status);
     }
 
-#endif
-
-    socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
-
-    if (socket_fd < 0)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: error opening new UDP socket: %s", __func__,
-                  strerror(errno));
-        RETURNFUNC(-RIG_EIO);
-    }
-
-    // Enable non-blocking mode
-    u_long mode = 1;
-#ifdef __MINGW32__
-
-    if (ioctlsocket(socket_fd, FIONBIO, &mode) == SOCKET_ERROR)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: error enabling non-blocking mode for socket: %s",
-                  __func__,
-                  strerror(errno));
-        RETURNFUNC(-RIG_EIO);
-    }
-
-#else
-
-    if (ioctl(socket_fd, FIONBIO, &mode) < 0)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: error enabling non-blocking mode for socket: %s",
-                  __func__,
-                  strerror(errno));
-        RETURNFUNC(-RIG_EIO);
-    }
-
 #endif
 
     if (items & RIG_MULTICAST_TRANSCEIVE)
@@ -1674,52 +1654,65 @@ int network_multicast_publisher_start(RIG *rig, const char *multicast_addr,
 
     rs->snapshot_packet_sequence_number = 0;
     rs->multicast_publisher_run = 0;
-    rs->multicast_publisher_priv_data = calloc(1,
-                                        sizeof(multicast_publisher_priv_data));
+    mcast_publisher_priv = calloc(1, sizeof(multicast_publisher_priv_data));
 
-    if (rs->multicast_publisher_priv_data == NULL)
+    if (mcast_publisher_priv == NULL)
     {
-        close(socket_fd);
         RETURNFUNC(-RIG_ENOMEM);
     }
 
-    mcast_publisher_priv = (multicast_publisher_priv_data *)
-                           rs->multicast_publisher_priv_data;
-    mcast_publisher_priv->args.socket_fd = socket_fd;
     mcast_publisher_priv->args.multicast_addr = multicast_addr;
     mcast_publisher_priv->args.multicast_port = multicast_port;
     mcast_publisher_priv->args.rig = rig;
 
-    mutex_status = pthread_mutex_init(&mcast_publisher_priv->args.write_lock, NULL);
+    spectrum_ring_init(&mcast_publisher_priv->args.spectrum_ring);
+    snapshot_delta_init(&mcast_publisher_priv->args.snapshot_delta,
+                        rs->multicast_keyframe_interval);
+
+    if (rs->multicast_hub)
+    {
+        status = multicast_hub_attach(&mcast_publisher_priv->args);
+
+        if (status == RIG_OK)
+        {
+            rs->multicast_publisher_priv_data = mcast_publisher_priv;
+            rs->multicast_publisher_run = 1;
+            RETURNFUNC(RIG_OK);
+        }
 
-    status = multicast_publisher_create_data_pipe(mcast_publisher_priv);
+        if (status != -RIG_ECONF)
+        {
+            free(mcast_publisher_priv);
+            RETURNFUNC(status);
+        }
 
-    if (status < 0 || mutex_status != 0)
+        rig_debug(RIG_DEBUG_WARN,
+                  "%s: multicast hub sends elsewhere, %s:%d gets its own publisher\n",
+                  __func__, multicast_addr, multicast_port);
+    }
+
+    if (snapshot_init(&mcast_publisher_priv->args.snapshot_static, rig) != RIG_OK)
     {
-        free(rs->multicast_publisher_priv_data);
-        rs->multicast_publisher_priv_data = NULL;
-        close(socket_fd);
         rig_debug(RIG_DEBUG_ERR,
-                  "%s: multicast publisher data pipe creation failed, result=%d\n", __func__,
-                  status);
-        RETURNFUNC(-RIG_EINTERNAL);
+                  "%s: rig identification too long for snapshot data, multicast disabled\n",
+                  __func__);
+        free(mcast_publisher_priv);
+        RETURNFUNC(-RIG_EINVAL);
     }
 
-    int err = pthread_create(&mcast_publisher_priv->thread_id, NULL,
-                             multicast_publisher,
-                             &mcast_publisher_priv->args);
+    status = multicast_publisher_thread_start(&thread, multicast_addr,
+             multicast_port, rs->multicast_batch_window);
 
-    if (err)
+    if (status != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s(%d) pthread_create error %s\n", __FILE__, __LINE__,
-                  strerror(errno));
-        multicast_publisher_close_data_pipe(mcast_publisher_priv);
         free(mcast_publisher_priv);
-        rs->multicast_publisher_priv_data = NULL;
-        close(socket_fd);
-        RETURNFUNC(-RIG_EINTERNAL);
+        RETURNFUNC(status);
     }
 
+    multicast_publisher_thread_add(thread, &mcast_publisher_priv->args);
+    rs->multicast_publisher_priv_data = mcast_publisher_priv;
+    rs->multicast_publisher_run = 1;
+
     RETURNFUNC(RIG_OK);
 }
 
@@ -1734,6 +1727,7 @@ int network_multicast_publisher_stop(RIG *rig)
 {
     struct rig_state *rs = STATE(rig);
     multicast_publisher_priv_data *mcast_publisher_priv;
+    multicast_publisher_thread *thread;
 
     ENTERFUNC;
 
@@ -1747,36 +1741,50 @@ int network_multicast_publisher_stop(RIG *rig)
         RETURNFUNC(RIG_OK);
     }
 
-    if (mcast_publisher_priv->thread_id != 0)
-    {
-        int err = pthread_join(mcast_publisher_priv->thread_id, NULL);
-
-        if (err)
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s(%d): pthread_join error %s\n", __FILE__, __LINE__,
-                      strerror(errno));
-            // just ignore it
-        }
+    thread = mcast_publisher_priv->args.thread;
 
-        mcast_publisher_priv->thread_id = 0;
+    if (mcast_publisher_priv->args.source != 0)
+    {
+        multicast_hub_detach(&mcast_publisher_priv->args);
     }
-
-    multicast_publisher_close_data_pipe(mcast_publisher_priv);
-
-    if (mcast_publisher_priv->args.socket_fd >= 0)
+    else
     {
-        close(mcast_publisher_priv->args.socket_fd);
-        mcast_publisher_priv->args.socket_fd = -1;
+        multicast_publisher_thread_remove(thread, &mcast_publisher_priv->args);
+        multicast_publisher_thread_stop(thread);
     }
 
-    pthread_mutex_destroy(&mcast_publisher_priv->args.write_lock);
-
     free(rs->multicast_publisher_priv_data);
     rs->multicast_publisher_priv_data = NULL;
 
     RETURNFUNC(RIG_OK);
 }
 
+/**
+ * \brief Read multicast publisher send counters
+ *
+ * Packets sent and the system calls it took, see udp_batch.h.  A rig in
+ * the multicast hub reads the counters of the whole hub.
+ *
+ * \param stats Filled with the counters
+ * \return RIG_OK or -RIG_ENAVAIL when the publisher is not running
+ */
+int network_multicast_publisher_get_stats(RIG *rig,
+        struct udp_batch_stats *stats)
+{
+    const struct rig_state *rs = STATE(rig);
+    multicast_publisher_priv_data *mcast_publisher_priv =
+        (multicast_publisher_priv_data *) rs->multicast_publisher_priv_data;
+
+    if (mcast_publisher_priv == NULL)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    udp_batch_stats_get(&mcast_publisher_priv->args.thread->batch.stats, stats);
+
+    return RIG_OK;
+}
+
 
 /**
  * \brief Start multicast receiver
@@ -24,6 +24,7 @@
 
 #include "hamlib/rig.h"
 #include "iofunc.h"
+#include "udp_batch.h"
 
 __BEGIN_DECLS
 
@@ -35,11 +36,13 @@ int network_flush2(hamlib_port_t *rp, unsigned char *stopset, char *buf, int buf
 int network_publish_rig_poll_data(RIG *rig);
 int network_publish_rig_transceive_data(RIG *rig);
 int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line);
+int network_publish_rig_keyframe(RIG *rig);
 int network_publish_rig_status_change(RIG *rig, int32_t status);
 HAMLIB_EXPORT(int) network_multicast_publisher_start(RIG *rig, const char *multicast_addr, int multicast_port, enum multicast_item_e items);
 HAMLIB_EXPORT(int) network_multicast_publisher_stop(RIG *rig);
 HAMLIB_EXPORT(int) network_multicast_receiver_start(RIG *rig, const char *multicast_addr, int multicast_port);
 HAMLIB_EXPORT(int) network_multicast_receiver_stop(RIG *rig);
+int network_multicast_publisher_get_stats(RIG *rig, struct udp_batch_stats *stats);
 
 __END_DECLS
 
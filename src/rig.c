@@ -67,6 +67,8 @@
 #include "parallel.h"
 #include "network.h"
 #include "event.h"
+#include "status_page.h"
+#include "spectrum_packet.h"
 #include "cm108.h"
 #include "gpio.h"
 #include "misc.h"
@@ -591,6 +593,7 @@ static void vaporize(RIG *rig)
     }
     if (STATE(rig))
     {
+        rig_spectrum_stage_free(rig);
         free(STATE(rig));
         STATE(rig) = NULL;
     }
@@ -842,6 +845,8 @@ RIG *HAMLIB_API rig_init(rig_model_t rig_model)
 #endif
     rs->multicast_data_port = 4532;
     rs->multicast_cmd_port = 4532;
+    rs->multicast_spectrum_format = SPECTRUM_FORMAT_JSON;
+    rs->multicast_spectrum_encoding = SPECTRUM_ENCODING_AUTO;
     rs->lo_freq = 0;
     cachep->timeout_ms = 500;  // 500ms cache timeout by default
     cachep->ptt = 0;
@@ -1704,6 +1709,18 @@ int HAMLIB_API rig_open(RIG *rig)
         // we will consider this non-fatal for now
     }
 
+    if (rs->status_shm[0] != '\0')
+    {
+        retval = status_page_start(rig, rs->status_shm);
+
+        if (retval != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: status_page_start failed: %.23000s\n",
+                      __FILE__, rigerror(retval));
+            // we will consider this non-fatal for now
+        }
+    }
+
     retval = rig_poll_routine_start(rig);
 
     if (retval != RIG_OK)
@@ -1780,6 +1797,7 @@ int HAMLIB_API rig_close(RIG *rig)
         morse_data_handler_stop(rig);
         async_data_handler_stop(rig);
         rig_poll_routine_stop(rig);
+        status_page_stop(rig);
         network_multicast_receiver_stop(rig);
         network_multicast_publisher_stop(rig);
     }
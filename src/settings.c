@@ -45,6 +45,7 @@
 #include "hamlib/rig_state.h"
 #include "cal.h"
 #include "misc.h"
+#include "status_page.h"
 
 
 #ifndef DOC_HIDDEN
@@ -197,6 +198,7 @@ int HAMLIB_API rig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
         }
 
         val->i = (int)rig_raw2val(rawstr.i, &rs->str_cal);
+        status_page_update_meter(rig, level, val);
         rig_lock(rig, 0);
         return RIG_OK;
     }
@@ -207,6 +209,12 @@ int HAMLIB_API rig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
             || vfo == rs->current_vfo)
     {
         retcode = caps->get_level(rig, vfo, level, val);
+
+        if (retcode == RIG_OK)
+        {
+            status_page_update_meter(rig, level, val);
+        }
+
         rig_lock(rig, 0);
         return retcode;
     }
@@ -228,6 +236,12 @@ int HAMLIB_API rig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
 
     retcode = caps->get_level(rig, vfo, level, val);
     caps->set_vfo(rig, curr_vfo);
+
+    if (retcode == RIG_OK)
+    {
+        status_page_update_meter(rig, level, val);
+    }
+
     rig_lock(rig, 0);
     return retcode;
 }
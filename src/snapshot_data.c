@@ -10,200 +10,274 @@
 #include "hamlibdatetime.h"
 #include "sprintflst.h"
 
-#include "cJSON.h"
+#include "json_writer.h"
 
 #define SPECTRUM_MODE_FIXED "FIXED"
 #define SPECTRUM_MODE_CENTER "CENTER"
 
 char snapshot_data_pid[20];
 
-static int snapshot_serialize_rig(cJSON *rig_node, RIG *rig)
+/* Render one cached fragment into the free space of st->text */
+static int snapshot_static_end(struct snapshot_static *st,
+                               struct json_writer *w,
+                               struct snapshot_fragment *fragment)
 {
-    cJSON *node;
-    char buf[1024];
-    struct rig_cache *cachep = CACHE(rig);
-    struct rig_state *rs = STATE(rig);
-
-    cJSON *id_node = cJSON_CreateObject();
-    cJSON_AddStringToObject(id_node, "model", rig->caps->model_name);
-    cJSON_AddStringToObject(id_node, "endpoint", RIGPORT(rig)->pathname);
-    cJSON_AddStringToObject(id_node, "process", snapshot_data_pid);
-    cJSON_AddStringToObject(id_node, "deviceId", rs->device_id);
-    cJSON_AddItemToObject(rig_node, "id", id_node);
-
-    node = cJSON_AddStringToObject(rig_node, "status",
-                                   rig_strcommstatus(rs->comm_status));
+    int len = json_writer_finish(w);
 
-    if (node == NULL)
+    if (len < 0)
     {
-        goto error;
+        return -RIG_EINTERNAL;
     }
 
-    // TODO: need to store last error code
-    node = cJSON_AddStringToObject(rig_node, "errorMsg", "");
+    fragment->offset = st->used;
+    fragment->length = len;
+    st->used += len;
 
-    if (node == NULL)
-    {
-        goto error;
-    }
+    return RIG_OK;
+}
 
-    node = cJSON_AddStringToObject(rig_node, "name", rig->caps->model_name);
+static void snapshot_static_begin(struct snapshot_static *st,
+                                  struct json_writer *w)
+{
+    json_writer_init(w, st->text + st->used, sizeof(st->text) - st->used);
+}
 
-    if (node == NULL)
+int snapshot_init(struct snapshot_static *st, RIG *rig)
+{
+    return snapshot_init_source(st, rig, 0);
+}
+
+
+int snapshot_init_source(struct snapshot_static *st, RIG *rig,
+                         uint32_t source)
+{
+    struct json_writer w;
+    struct rig_state *rs = STATE(rig);
+    char modes[1024];
+    char *p, *end;
+    int result;
+
+    snprintf(snapshot_data_pid, sizeof(snapshot_data_pid), "%d", getpid());
+
+    memset(st, 0, sizeof(*st));
+
+    snapshot_static_begin(st, &w);
+    json_write_string(&w, "app", PACKAGE_NAME);
+    json_write_string(&w, "version", PACKAGE_VERSION " " HAMLIBDATETIME);
+    result = snapshot_static_end(st, &w, &st->header);
+
+    if (result != RIG_OK)
     {
-        goto error;
+        return result;
     }
 
-    node = cJSON_AddBoolToObject(rig_node, "split",
-                                 cachep->split == RIG_SPLIT_ON ? 1 : 0);
+    snapshot_static_begin(st, &w);
+    json_write_begin_object(&w, "id");
+    json_write_string(&w, "model", rig->caps->model_name);
+    json_write_string(&w, "endpoint", RIGPORT(rig)->pathname);
+    json_write_string(&w, "process", snapshot_data_pid);
+    json_write_string(&w, "deviceId", rs->device_id);
 
-    if (node == NULL)
+    if (source != 0)
     {
-        goto error;
+        json_write_number(&w, "source", source);
     }
 
-    node = cJSON_AddStringToObject(rig_node, "splitVfo",
-                                   rig_strvfo(cachep->split_vfo));
+    json_write_end_object(&w);
+    result = snapshot_static_end(st, &w, &st->rig_id);
 
-    if (node == NULL)
+    if (result != RIG_OK)
     {
-        goto error;
+        return result;
     }
 
-    node = cJSON_AddBoolToObject(rig_node, "satMode",
-                                 cachep->satmode ? 1 : 0);
+    // TODO: need to store last error code
+    snapshot_static_begin(st, &w);
+    json_write_string(&w, "errorMsg", "");
+    json_write_string(&w, "name", rig->caps->model_name);
+    result = snapshot_static_end(st, &w, &st->rig_name);
 
-    if (node == NULL)
+    if (result != RIG_OK)
     {
-        goto error;
+        return result;
     }
 
-    rig_sprintf_mode(buf, sizeof(buf), rs->mode_list);
-    char *p;
-    cJSON *modes_array = cJSON_CreateArray();
+    rig_sprintf_mode(modes, sizeof(modes), rs->mode_list);
+
+    snapshot_static_begin(st, &w);
+    json_write_begin_array(&w, "modes");
 
-    for (p = strtok(buf, " "); p; p = strtok(NULL, " "))
+    for (p = modes; *p; p = end)
     {
-        if (strlen(buf) > 0)
+        while (*p == ' ')
+        {
+            p++;
+        }
+
+        for (end = p; *end && *end != ' '; end++)
         {
-            cJSON *tmp = cJSON_CreateString(p);
-            cJSON_AddItemToArray(modes_array, tmp);
         }
-    }
 
-    cJSON_AddItemToObject(rig_node, "modes", modes_array);
+        if (end > p)
+        {
+            char c = *end;
 
-    return RIG_OK;
+            *end = '\0';
+            json_write_string(&w, NULL, p);
+            *end = c;
+        }
+    }
+
+    json_write_end_array(&w);
 
-error:
-    RETURNFUNC2(-RIG_EINTERNAL);
+    return snapshot_static_end(st, &w, &st->modes);
 }
 
-// 128 max modes should last a while
-#define MAX_MODES 128
+static void snapshot_write_fragment(struct json_writer *w,
+                                    const struct snapshot_static *st,
+                                    const struct snapshot_fragment *fragment)
+{
+    json_write_raw(w, st->text + fragment->offset, fragment->length);
+}
 
-static int snapshot_serialize_vfo(cJSON *vfo_node, RIG *rig, vfo_t vfo)
+/* Fill in the parts of the snapshot that change while the rig is open */
+static void snapshot_capture(RIG *rig, struct snapshot_state *state)
 {
-    freq_t freq;
-    int freq_ms, mode_ms, width_ms;
-    rmode_t mode;
-    //rmode_t modes[MAX_MODES];
-    pbwidth_t width;
-    ptt_t ptt;
-    split_t split;
-    vfo_t split_vfo;
-    int result;
-    int is_rx, is_tx;
-    cJSON *node;
     struct rig_cache *cachep = CACHE(rig);
     struct rig_state *rs = STATE(rig);
+    int i;
 
-    // TODO: This data should match rig_get_info command response
-
-    node = cJSON_AddStringToObject(vfo_node, "name", rig_strvfo(vfo));
-
-    if (node == NULL)
-    {
-        goto error;
-    }
+    memset(state, 0, sizeof(*state));
 
-    result = rig_get_cache(rig, vfo, &freq, &freq_ms, &mode, &mode_ms, &width,
-                           &width_ms);
+    state->status = rs->comm_status;
+    state->split = cachep->split;
+    state->split_vfo = cachep->split_vfo;
+    state->sat_mode = cachep->satmode;
 
-    if (result == RIG_OK)
+    for (i = 0; i < HAMLIB_MAX_VFOS; i++)
     {
-        node = cJSON_AddNumberToObject(vfo_node, "freq", freq);
+        struct snapshot_vfo_state *v = &state->vfos[state->vfo_count];
+        vfo_t vfo = rs->vfo_list & RIG_VFO_N(i);
+        int freq_ms, mode_ms, width_ms;
+        int is_tx;
 
-        if (node == NULL)
+        if (!vfo)
         {
-            goto error;
+            continue;
         }
 
-        node = cJSON_AddStringToObject(vfo_node, "mode", rig_strrmode(mode));
+        // TODO: This data should match rig_get_info command response
 
-        if (node == NULL)
-        {
-            goto error;
-        }
+        v->vfo = vfo;
+        v->have_cache = rig_get_cache(rig, vfo, &v->freq, &freq_ms, &v->mode,
+                                      &mode_ms, &v->width, &width_ms) == RIG_OK;
 
-        node = cJSON_AddNumberToObject(vfo_node, "width", (double) width);
+        v->rx = (state->split == RIG_SPLIT_OFF && vfo == rs->current_vfo)
+                || (state->split == RIG_SPLIT_ON && vfo != state->split_vfo);
+        is_tx = (state->split == RIG_SPLIT_OFF && vfo == rs->current_vfo)
+                || (state->split == RIG_SPLIT_ON && vfo == state->split_vfo);
+        v->tx = is_tx;
+        v->ptt = is_tx && cachep->ptt != RIG_PTT_OFF;
 
-        if (node == NULL)
-        {
-            goto error;
-        }
+        state->vfo_count++;
     }
+}
 
-    split = cachep->split;
-    split_vfo = cachep->split_vfo;
+/* The rig object with every field when prev is NULL, else only the
+ * identification and what differs from prev */
+static void snapshot_serialize_rig(struct json_writer *w,
+                                   const struct snapshot_static *st,
+                                   const struct snapshot_state *state,
+                                   const struct snapshot_state *prev)
+{
+    snapshot_write_fragment(w, st, &st->rig_id);
 
-    is_rx = (split == RIG_SPLIT_OFF && vfo == rs->current_vfo)
-            || (split == RIG_SPLIT_ON && vfo != split_vfo);
-    is_tx = (split == RIG_SPLIT_OFF && vfo == rs->current_vfo)
-            || (split == RIG_SPLIT_ON && vfo == split_vfo);
-    ptt = cachep->ptt && is_tx;
+    if (!prev || state->status != prev->status)
+    {
+        json_write_string(w, "status", rig_strcommstatus(state->status));
+    }
 
-    if (is_tx)
+    if (!prev)
     {
-        node = cJSON_AddBoolToObject(vfo_node, "ptt", ptt == RIG_PTT_OFF ? 0 : 1);
+        snapshot_write_fragment(w, st, &st->rig_name);
     }
-    else
+
+    if (!prev || state->split != prev->split)
+    {
+        json_write_bool(w, "split", state->split == RIG_SPLIT_ON);
+    }
+
+    if (!prev || state->split_vfo != prev->split_vfo)
+    {
+        json_write_string(w, "splitVfo", rig_strvfo(state->split_vfo));
+    }
+
+    if (!prev || state->sat_mode != prev->sat_mode)
     {
-        node = cJSON_AddBoolToObject(vfo_node, "ptt", 0);
+        json_write_bool(w, "satMode", state->sat_mode);
     }
 
-    if (node == NULL)
+    if (!prev)
     {
-        goto error;
+        snapshot_write_fragment(w, st, &st->modes);
     }
+}
 
+/* Like snapshot_serialize_rig(), for one VFO; a VFO is always named */
+static void snapshot_serialize_vfo(struct json_writer *w,
+                                   const struct snapshot_vfo_state *v,
+                                   const struct snapshot_vfo_state *prev)
+{
+    int cache_changed = prev && v->have_cache != prev->have_cache;
 
-    node = cJSON_AddBoolToObject(vfo_node, "rx", is_rx);
+    json_write_string(w, "name", rig_strvfo(v->vfo));
 
-    if (node == NULL)
+    if (v->have_cache)
     {
-        goto error;
+        if (!prev || cache_changed || v->freq != prev->freq)
+        {
+            json_write_number(w, "freq", v->freq);
+        }
+
+        if (!prev || cache_changed || v->mode != prev->mode)
+        {
+            json_write_string(w, "mode", rig_strrmode(v->mode));
+        }
+
+        if (!prev || cache_changed || v->width != prev->width)
+        {
+            json_write_number(w, "width", (double) v->width);
+        }
     }
 
-    node = cJSON_AddBoolToObject(vfo_node, "tx", is_tx);
+    if (!prev || v->ptt != prev->ptt)
+    {
+        json_write_bool(w, "ptt", v->ptt);
+    }
 
-    if (node == NULL)
+    if (!prev || v->rx != prev->rx)
     {
-        goto error;
+        json_write_bool(w, "rx", v->rx);
     }
 
-    return RIG_OK;
+    if (!prev || v->tx != prev->tx)
+    {
+        json_write_bool(w, "tx", v->tx);
+    }
+}
 
-error:
-    RETURNFUNC2(-RIG_EINTERNAL);
+static int snapshot_vfo_changed(const struct snapshot_vfo_state *v,
+                                const struct snapshot_vfo_state *prev)
+{
+    return v->have_cache != prev->have_cache
+           || (v->have_cache && (v->freq != prev->freq || v->mode != prev->mode
+                                 || v->width != prev->width))
+           || v->ptt != prev->ptt || v->rx != prev->rx || v->tx != prev->tx;
 }
 
-static int snapshot_serialize_spectrum(cJSON *spectrum_node, RIG *rig,
-                                       struct rig_spectrum_line *spectrum_line)
+static void snapshot_serialize_spectrum(struct json_writer *w, RIG *rig,
+                                        struct rig_spectrum_line *spectrum_line)
 {
-    // Spectrum data is represented as a hexadecimal ASCII string where each data byte is represented as 2 ASCII letters
-    char spectrum_data_string[HAMLIB_MAX_SPECTRUM_DATA * 2];
-    cJSON *node;
     int i;
     struct rig_spectrum_scope *scopes = rig->caps->spectrum_scopes;
     char *name = "?";
@@ -216,264 +290,252 @@ static int snapshot_serialize_spectrum(cJSON *spectrum_node, RIG *rig,
         }
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "id", spectrum_line->id);
+    json_write_number(w, "id", spectrum_line->id);
+    json_write_string(w, "name", name);
+    json_write_string(w, "type",
+                      spectrum_line->spectrum_mode == RIG_SPECTRUM_MODE_CENTER ?
+                      SPECTRUM_MODE_CENTER : SPECTRUM_MODE_FIXED);
+    json_write_number(w, "minLevel", spectrum_line->data_level_min);
+    json_write_number(w, "maxLevel", spectrum_line->data_level_max);
+    json_write_number(w, "minStrength", spectrum_line->signal_strength_min);
+    json_write_number(w, "maxStrength", spectrum_line->signal_strength_max);
+    json_write_number(w, "centerFreq", spectrum_line->center_freq);
+    json_write_number(w, "span", spectrum_line->span_freq);
+    json_write_number(w, "lowFreq", spectrum_line->low_edge_freq);
+    json_write_number(w, "highFreq", spectrum_line->high_edge_freq);
+    json_write_number(w, "length", (double) spectrum_line->spectrum_data_length);
 
-    if (node == NULL)
-    {
-        goto error;
-    }
+    // Spectrum data is represented as a hexadecimal ASCII string where each data byte is represented as 2 ASCII letters
+    json_write_hex(w, "data", spectrum_line->spectrum_data,
+                   spectrum_line->spectrum_data_length);
+}
 
-    node = cJSON_AddStringToObject(spectrum_node, "name", name);
+/* Replace the "0" placeholder at crc_offset with the CRC-32 of the record
+ * as it stands, so receivers can check it by zeroing the value again */
+static int snapshot_insert_crc(size_t buffer_length, char *buffer, size_t len,
+                               size_t crc_offset)
+{
+    char crc[16];
+    int n;
+
+    n = snprintf(crc, sizeof(crc), "%lu",
+                 (unsigned long) CRC32_function((const uint8_t *) buffer, len));
 
-    if (node == NULL)
+    if (len + n - 1 >= buffer_length)
     {
-        goto error;
+        return -RIG_EINVAL;
     }
 
-    node = cJSON_AddStringToObject(spectrum_node, "type",
-                                   spectrum_line->spectrum_mode == RIG_SPECTRUM_MODE_CENTER ?
-                                   SPECTRUM_MODE_CENTER : SPECTRUM_MODE_FIXED);
+    memmove(buffer + crc_offset + n, buffer + crc_offset + 1,
+            len - crc_offset);
+    memcpy(buffer + crc_offset, crc, n);
 
-    if (node == NULL)
-    {
-        goto error;
-    }
+    return RIG_OK;
+}
 
-    node = cJSON_AddNumberToObject(spectrum_node, "minLevel",
-                                   spectrum_line->data_level_min);
+/* Write a full snapshot, or with prev a delta against it, and insert
+ * the CRC.  keyframe_seq < 0 leaves out the delta mode fields. */
+static int snapshot_write(size_t buffer_length, char *buffer, RIG *rig,
+                          const struct snapshot_static *st,
+                          const struct snapshot_state *state,
+                          const struct snapshot_state *prev, long keyframe_seq,
+                          struct rig_spectrum_line *spectrum_line)
+{
+    struct json_writer w;
+    char buf[256];
+    size_t crc_offset;
+    int len;
+    int i;
+    int vfos_open = 0;
+    struct rig_state *rs = STATE(rig);
 
-    if (node == NULL)
-    {
-        goto error;
-    }
+    json_writer_init(&w, buffer, buffer_length);
 
-    node = cJSON_AddNumberToObject(spectrum_node, "maxLevel",
-                                   spectrum_line->data_level_max);
+    json_write_begin_object(&w, NULL);
 
-    if (node == NULL)
+    if (!prev)
     {
-        goto error;
+        snapshot_write_fragment(&w, st, &st->header);
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "minStrength",
-                                   spectrum_line->signal_strength_min);
+    json_write_number(&w, "seq", rs->snapshot_packet_sequence_number);
 
-    if (node == NULL)
-    {
-        goto error;
-    }
+    date_strget(buf, sizeof(buf), 0);
+    json_write_string(&w, "time", buf);
 
-    node = cJSON_AddNumberToObject(spectrum_node, "maxStrength",
-                                   spectrum_line->signal_strength_max);
+    json_write_number(&w, "crc", 0);
+    crc_offset = w.len - 1;
 
-    if (node == NULL)
+    if (keyframe_seq >= 0)
     {
-        goto error;
+        if (prev)
+        {
+            json_write_number(&w, "delta", (double) keyframe_seq);
+        }
+        else
+        {
+            json_write_bool(&w, "keyframe", 1);
+        }
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "centerFreq",
-                                   spectrum_line->center_freq);
+    json_write_begin_object(&w, "rig");
+    snapshot_serialize_rig(&w, st, state, prev);
+    json_write_end_object(&w);
 
-    if (node == NULL)
+    for (i = 0; i < state->vfo_count; i++)
     {
-        goto error;
-    }
+        const struct snapshot_vfo_state *v = &state->vfos[i];
+        const struct snapshot_vfo_state *pv = prev ? &prev->vfos[i] : NULL;
 
-    node = cJSON_AddNumberToObject(spectrum_node, "span", spectrum_line->span_freq);
+        if (pv && !snapshot_vfo_changed(v, pv))
+        {
+            continue;
+        }
 
-    if (node == NULL)
-    {
-        goto error;
-    }
+        if (!vfos_open)
+        {
+            json_write_begin_array(&w, "vfos");
+            vfos_open = 1;
+        }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "lowFreq",
-                                   spectrum_line->low_edge_freq);
+        json_write_begin_object(&w, NULL);
+        snapshot_serialize_vfo(&w, v, pv);
+        json_write_end_object(&w);
+    }
 
-    if (node == NULL)
+    if (vfos_open)
     {
-        goto error;
+        json_write_end_array(&w);
     }
-
-    node = cJSON_AddNumberToObject(spectrum_node, "highFreq",
-                                   spectrum_line->high_edge_freq);
-
-    if (node == NULL)
+    else if (!prev)
     {
-        goto error;
+        json_write_begin_array(&w, "vfos");
+        json_write_end_array(&w);
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "length",
-                                   (double) spectrum_line->spectrum_data_length);
-
-    if (node == NULL)
+    if (spectrum_line != NULL)
     {
-        goto error;
+        json_write_begin_array(&w, "spectra");
+        json_write_begin_object(&w, NULL);
+        snapshot_serialize_spectrum(&w, rig, spectrum_line);
+        json_write_end_object(&w);
+        json_write_end_array(&w);
     }
 
-    to_hex(spectrum_line->spectrum_data_length, spectrum_line->spectrum_data,
-           sizeof(spectrum_data_string), spectrum_data_string);
-    node = cJSON_AddStringToObject(spectrum_node, "data", spectrum_data_string);
+    json_write_end_object(&w);
+
+    len = json_writer_finish(&w);
 
-    if (node == NULL)
+    if (len < 0 || snapshot_insert_crc(buffer_length, buffer, len,
+                                       crc_offset) != RIG_OK)
     {
-        goto error;
+        RETURNFUNC2(-RIG_EINVAL);
     }
 
-    return RIG_OK;
-
-error:
-    RETURNFUNC2(-RIG_EINTERNAL);
-}
+    rs->snapshot_packet_sequence_number++;
 
-void snapshot_init()
-{
-    snprintf(snapshot_data_pid, sizeof(snapshot_data_pid), "%d", getpid());
+    return RIG_OK;
 }
 
 int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig,
+                       const struct snapshot_static *st,
                        struct rig_spectrum_line *spectrum_line)
 {
-    cJSON *root_node;
-    cJSON *rig_node, *vfos_array, *vfo_node, *spectra_array, *spectrum_node;
-    cJSON *node;
-    cJSON_bool bool_result;
-    char buf[256];
-    int result;
-    int i;
-    struct rig_state *rs = STATE(rig);
-
-    root_node = cJSON_CreateObject();
+    struct snapshot_state state;
 
-    if (root_node == NULL)
-    {
-        RETURNFUNC2(-RIG_EINTERNAL);
-    }
+    snapshot_capture(rig, &state);
 
-    node = cJSON_AddStringToObject(root_node, "app", PACKAGE_NAME);
+    return snapshot_write(buffer_length, buffer, rig, st, &state, NULL, -1,
+                          spectrum_line);
+}
 
-    if (node == NULL)
-    {
-        goto error;
-    }
+void snapshot_delta_init(struct snapshot_delta *delta, int keyframe_interval_ms)
+{
+    memset(delta, 0, sizeof(*delta));
+    delta->keyframe_interval_ms = keyframe_interval_ms;
+    delta->keyframe_pending = 1;
+}
 
-    node = cJSON_AddStringToObject(root_node, "version",
-                                   PACKAGE_VERSION " " HAMLIBDATETIME);
+int snapshot_serialize_delta(size_t buffer_length, char *buffer, RIG *rig,
+                             const struct snapshot_static *st,
+                             struct snapshot_delta *delta,
+                             struct rig_spectrum_line *spectrum_line,
+                             uint64_t now_ms)
+{
+    struct snapshot_state state;
+    struct rig_state *rs = STATE(rig);
+    int keyframe;
+    int result;
 
-    if (node == NULL)
+    if (delta->keyframe_interval_ms <= 0)
     {
-        goto error;
+        return snapshot_serialize(buffer_length, buffer, rig, st, spectrum_line);
     }
 
-    node = cJSON_AddNumberToObject(root_node, "seq",
-                                   rs->snapshot_packet_sequence_number);
+    snapshot_capture(rig, &state);
 
-    if (node == NULL)
-    {
-        goto error;
-    }
+    // A changed VFO list has nothing to compare against
+    keyframe = delta->keyframe_pending
+               || now_ms - delta->keyframe_ms >= (uint64_t)delta->keyframe_interval_ms
+               || state.vfo_count != delta->last.vfo_count;
 
-    date_strget(buf, sizeof(buf), 0);
-    node = cJSON_AddStringToObject(root_node, "time", buf);
-
-    if (node == NULL)
+    if (keyframe)
     {
-        goto error;
-    }
+        uint32_t seq = rs->snapshot_packet_sequence_number;
 
+        result = snapshot_write(buffer_length, buffer, rig, st, &state, NULL, seq,
+                                spectrum_line);
 
-    // TODO: Calculate 32-bit CRC of the entire JSON record replacing the CRC value with 0
-    node = cJSON_AddNumberToObject(root_node, "crc", 0);
-
-    if (node == NULL)
-    {
-        goto error;
+        if (result == RIG_OK)
+        {
+            delta->keyframe_pending = 0;
+            delta->keyframe_ms = now_ms;
+            delta->keyframe_seq = seq;
+        }
     }
-
-    rig_node = cJSON_CreateObject();
-
-    if (rig_node == NULL)
+    else
     {
-        goto error;
+        result = snapshot_write(buffer_length, buffer, rig, st, &state,
+                                &delta->last, delta->keyframe_seq, spectrum_line);
     }
 
-    result = snapshot_serialize_rig(rig_node, rig);
-
-    if (result != RIG_OK)
+    if (result == RIG_OK)
     {
-        cJSON_Delete(rig_node);
-        goto error;
+        delta->last = state;
     }
-
-    cJSON_AddItemToObject(root_node, "rig", rig_node);
-
-    vfos_array = cJSON_CreateArray();
-
-    if (vfos_array == NULL)
+    else
     {
-        goto error;
+        // Receivers see a sequence gap either way, so start over cleanly
+        delta->keyframe_pending = 1;
     }
 
-    for (i = 0; i < HAMLIB_MAX_VFOS; i++)
-    {
-        vfo_t vfo = rs->vfo_list & RIG_VFO_N(i);
-
-        if (!vfo)
-        {
-            continue;
-        }
-
-        vfo_node = cJSON_CreateObject();
-        result = snapshot_serialize_vfo(vfo_node, rig, vfo);
+    return result;
+}
 
-        if (result != RIG_OK)
-        {
-            cJSON_Delete(vfo_node);
-            goto error;
-        }
+int snapshot_delta_receive(struct snapshot_delta_receiver *rx, uint32_t seq,
+                           int keyframe)
+{
+    int in_order = rx->have_last && seq == rx->last_seq + 1;
 
-        cJSON_AddItemToArray(vfos_array, vfo_node);
+    // A step back means the publisher started over rather than a loss
+    if (rx->have_last && !in_order && (int32_t)(seq - rx->last_seq) > 0)
+    {
+        rx->lost += seq - rx->last_seq - 1;
     }
 
-    cJSON_AddItemToObject(root_node, "vfos", vfos_array);
+    rx->have_last = 1;
+    rx->last_seq = seq;
 
-    if (spectrum_line != NULL)
+    if (keyframe)
     {
-        spectra_array = cJSON_CreateArray();
-
-        if (spectra_array == NULL)
-        {
-            goto error;
-        }
-
-        spectrum_node = cJSON_CreateObject();
-        result = snapshot_serialize_spectrum(spectrum_node, rig, spectrum_line);
-
-        if (result != RIG_OK)
-        {
-            cJSON_Delete(spectrum_node);
-            goto error;
-        }
-
-        cJSON_AddItemToArray(spectra_array, spectrum_node);
-
-        cJSON_AddItemToObject(root_node, "spectra", spectra_array);
+        rx->synced = 1;
+        return SNAPSHOT_DELTA_APPLY;
     }
 
-    bool_result = cJSON_PrintPreallocated(root_node, buffer, (int) buffer_length,
-                                          0);
-
-    cJSON_Delete(root_node);
-
-    if (!bool_result)
+    if (!in_order)
     {
-        RETURNFUNC2(-RIG_EINVAL);
+        rx->synced = 0;
     }
 
-    rs->snapshot_packet_sequence_number++;
-
-    return RIG_OK;
-
-error:
-    cJSON_Delete(root_node);
-    RETURNFUNC2(-RIG_EINTERNAL);
+    return rx->synced ? SNAPSHOT_DELTA_APPLY : SNAPSHOT_DELTA_AWAIT_KEYFRAME;
 }
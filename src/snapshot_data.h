@@ -1,7 +1,102 @@
 #ifndef _SNAPSHOT_DATA_H
 #define _SNAPSHOT_DATA_H
 
-void snapshot_init();
-int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig, struct rig_spectrum_line *spectrum_line);
+#include <stdint.h>
+#include "hamlib/rig.h"
+
+/* Parts of the JSON snapshot that stay the same while the rig is open,
+ * serialized once by snapshot_init() and copied into every packet */
+struct snapshot_fragment
+{
+    size_t offset;
+    size_t length;
+};
+
+struct snapshot_static
+{
+    char text[4096];
+    size_t used;
+    struct snapshot_fragment header;    /* "app" and "version" */
+    struct snapshot_fragment rig_id;    /* "id" object of "rig" */
+    struct snapshot_fragment rig_name;  /* "errorMsg" and "name" of "rig" */
+    struct snapshot_fragment modes;     /* "modes" array of "rig" */
+};
+
+/* Parts of the snapshot that change, compared field by field for deltas */
+struct snapshot_vfo_state
+{
+    vfo_t vfo;
+    int have_cache;     /* freq, mode and width are known */
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    int ptt;
+    int rx;
+    int tx;
+};
+
+struct snapshot_state
+{
+    int status;
+    int split;
+    vfo_t split_vfo;
+    int sat_mode;
+    int vfo_count;
+    struct snapshot_vfo_state vfos[HAMLIB_MAX_VFOS];
+};
+
+/* Delta publishing: a keyframe is a full snapshot with "keyframe":true,
+ * sent at least every keyframe_interval_ms; in between, each packet
+ * carries "delta" (the seq of its keyframe), the rig "id" and only the
+ * fields that changed since the previous packet.  "seq" counts all of
+ * them, so a gap tells a receiver that it has to wait for (or ask for)
+ * the next keyframe. */
+struct snapshot_delta
+{
+    int keyframe_interval_ms;   /* 0 = always send full snapshots */
+    int keyframe_pending;       /* Next packet is a keyframe */
+    uint64_t keyframe_ms;
+    uint32_t keyframe_seq;
+    struct snapshot_state last; /* As of the previous packet */
+};
+
+/* Receiver side bookkeeping for snapshot_delta_receive() */
+struct snapshot_delta_receiver
+{
+    int have_last;
+    int synced;                 /* Holds a keyframe and every delta since */
+    uint32_t last_seq;
+    unsigned long lost;         /* Packets missing from the sequence */
+};
+
+enum snapshot_delta_action_e
+{
+    SNAPSHOT_DELTA_AWAIT_KEYFRAME = 0,
+    SNAPSHOT_DELTA_APPLY = 1,
+};
+
+int snapshot_init(struct snapshot_static *st, RIG *rig);
+/* As above, with "source" in the rig id for a rig sending through the
+ * multicast hub */
+int snapshot_init_source(struct snapshot_static *st, RIG *rig,
+                         uint32_t source);
+int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig,
+                       const struct snapshot_static *st,
+                       struct rig_spectrum_line *spectrum_line);
+
+void snapshot_delta_init(struct snapshot_delta *delta,
+                         int keyframe_interval_ms);
+/* Keyframe or delta as due at now_ms (any millisecond clock), or a plain
+ * snapshot when delta mode is off */
+int snapshot_serialize_delta(size_t buffer_length, char *buffer, RIG *rig,
+                             const struct snapshot_static *st,
+                             struct snapshot_delta *delta,
+                             struct rig_spectrum_line *spectrum_line,
+                             uint64_t now_ms);
+
+/* Account for a received packet; returns SNAPSHOT_DELTA_APPLY when it can
+ * be applied, SNAPSHOT_DELTA_AWAIT_KEYFRAME after a loss */
+int snapshot_delta_receive(struct snapshot_delta_receiver *rx, uint32_t seq,
+                           int keyframe);
 
 #endif
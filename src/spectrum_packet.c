@@ -0,0 +1,446 @@
+/*
+ *  Hamlib Interface - binary spectrum multicast packet
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "hamlib/config.h"
+
+#include <string.h>
+#include <math.h>
+
+#include "hamlib/rig.h"
+#include "spectrum_packet.h"
+
+
+static void put_u16(unsigned char *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v;
+}
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    put_u16(p, v >> 16);
+    put_u16(p + 2, v);
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+    put_u32(p, v >> 32);
+    put_u32(p + 4, v);
+}
+
+static uint16_t get_u16(const unsigned char *p)
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return (uint32_t)get_u16(p) << 16 | get_u16(p + 2);
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+    return (uint64_t)get_u32(p) << 32 | get_u32(p + 4);
+}
+
+
+static uint64_t freq_to_wire(freq_t f)
+{
+    return f > 0 ? (uint64_t)llround(f) : 0;
+}
+
+
+/* Signal strength in dB to 0.1 dB steps, saturating */
+static int16_t strength_to_wire(double db)
+{
+    double v = round(db * 10);
+
+    if (v > INT16_MAX) { return INT16_MAX; }
+
+    if (v < INT16_MIN) { return INT16_MIN; }
+
+    return (int16_t)v;
+}
+
+
+int spectrum_packbits_encode(const unsigned char *in, size_t in_len,
+                             unsigned char *out, size_t out_len)
+{
+    size_t i = 0, o = 0;
+
+    while (i < in_len)
+    {
+        size_t run = 1;
+
+        while (i + run < in_len && run < 128 && in[i + run] == in[i])
+        {
+            run++;
+        }
+
+        if (run >= 2)
+        {
+            if (o + 2 > out_len)
+            {
+                return -1;
+            }
+
+            out[o++] = (unsigned char)(257 - run);
+            out[o++] = in[i];
+            i += run;
+        }
+        else
+        {
+            size_t start = i;
+            size_t len = 0;
+
+            /* Literal bytes up to the start of the next run */
+            while (i < in_len && len < 128
+                    && !(i + 1 < in_len && in[i] == in[i + 1]))
+            {
+                i++;
+                len++;
+            }
+
+            if (o + 1 + len > out_len)
+            {
+                return -1;
+            }
+
+            out[o++] = (unsigned char)(len - 1);
+            memcpy(out + o, in + start, len);
+            o += len;
+        }
+    }
+
+    return (int)o;
+}
+
+
+int spectrum_packbits_decode(const unsigned char *in, size_t in_len,
+                             unsigned char *out, size_t out_len)
+{
+    size_t i = 0, o = 0;
+
+    while (i < in_len)
+    {
+        unsigned int c = in[i++];
+
+        if (c < 128)
+        {
+            size_t len = c + 1;
+
+            if (i + len > in_len || o + len > out_len)
+            {
+                return -1;
+            }
+
+            memcpy(out + o, in + i, len);
+            i += len;
+            o += len;
+        }
+        else if (c > 128)
+        {
+            size_t len = 257 - c;
+
+            if (i >= in_len || o + len > out_len)
+            {
+                return -1;
+            }
+
+            memset(out + o, in[i++], len);
+            o += len;
+        }
+
+        /* 128 is a no-op */
+    }
+
+    return (int)o;
+}
+
+
+/* Code bins with encoding into out; -1 if it does not fit out_len */
+static int encode_bins(const unsigned char *bins, size_t n, int encoding,
+                       unsigned char *out, size_t out_len)
+{
+    unsigned char delta[HAMLIB_MAX_SPECTRUM_DATA];
+    size_t i;
+
+    switch (encoding)
+    {
+    case SPECTRUM_ENCODING_RAW:
+        if (n > out_len)
+        {
+            return -1;
+        }
+
+        memcpy(out, bins, n);
+        return (int)n;
+
+    case SPECTRUM_ENCODING_RLE:
+        return spectrum_packbits_encode(bins, n, out, out_len);
+
+    case SPECTRUM_ENCODING_DELTA:
+        for (i = 0; i < n; i++)
+        {
+            delta[i] = (unsigned char)(bins[i] - (i ? bins[i - 1] : 0));
+        }
+
+        return spectrum_packbits_encode(delta, n, out, out_len);
+    }
+
+    return -1;
+}
+
+
+int spectrum_packet_encode(const struct rig_spectrum_line *line,
+                           uint32_t seq, uint64_t time_us, int encoding,
+                           unsigned char *buf, size_t buf_len)
+{
+    size_t n = line->spectrum_data_length;
+    unsigned char *payload = buf + SPECTRUM_PACKET_HEADER_SIZE;
+    int len = -1;
+
+    if (n > HAMLIB_MAX_SPECTRUM_DATA || (n > 0 && line->spectrum_data == NULL)
+            || buf_len < SPECTRUM_PACKET_HEADER_SIZE + n)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (encoding == SPECTRUM_ENCODING_AUTO)
+    {
+        unsigned char trial[HAMLIB_MAX_SPECTRUM_DATA];
+        int rle = encode_bins(line->spectrum_data, n, SPECTRUM_ENCODING_RLE, trial,
+                              n);
+        int delta = encode_bins(line->spectrum_data, n, SPECTRUM_ENCODING_DELTA,
+                                payload, n);
+
+        encoding = SPECTRUM_ENCODING_DELTA;
+        len = delta;
+
+        if (rle >= 0 && (delta < 0 || rle < delta))
+        {
+            memcpy(payload, trial, rle);
+            encoding = SPECTRUM_ENCODING_RLE;
+            len = rle;
+        }
+    }
+    else if (encoding != SPECTRUM_ENCODING_RAW)
+    {
+        /* Only worth it when smaller than the raw bins */
+        len = encode_bins(line->spectrum_data, n, encoding, payload, n);
+    }
+
+    if (len < 0 || (size_t)len >= n)
+    {
+        encoding = SPECTRUM_ENCODING_RAW;
+        len = encode_bins(line->spectrum_data, n, encoding, payload, n);
+    }
+
+    put_u32(buf, SPECTRUM_PACKET_MAGIC);
+    buf[4] = SPECTRUM_PACKET_VERSION;
+    buf[5] = (unsigned char)encoding;
+    buf[6] = (unsigned char)line->spectrum_mode;
+    buf[7] = (unsigned char)line->id;
+    put_u32(buf + 8, seq);
+    put_u32(buf + 12, 0);
+    put_u64(buf + 16, time_us);
+    put_u64(buf + 24, freq_to_wire(line->center_freq));
+    put_u64(buf + 32, freq_to_wire(line->span_freq));
+    put_u64(buf + 40, freq_to_wire(line->low_edge_freq));
+    put_u64(buf + 48, freq_to_wire(line->high_edge_freq));
+    put_u32(buf + 56, (uint32_t)line->data_level_min);
+    put_u32(buf + 60, (uint32_t)line->data_level_max);
+    put_u16(buf + 64, (uint16_t)strength_to_wire(line->signal_strength_min));
+    put_u16(buf + 66, (uint16_t)strength_to_wire(line->signal_strength_max));
+    put_u16(buf + 68, (uint16_t)n);
+    put_u16(buf + 70, (uint16_t)len);
+
+    return SPECTRUM_PACKET_HEADER_SIZE + len;
+}
+
+
+uint32_t spectrum_packet_source(const unsigned char *buf)
+{
+    return get_u32(buf + 12);
+}
+
+
+void spectrum_packet_set_source(unsigned char *buf, uint32_t source)
+{
+    put_u32(buf + 12, source);
+}
+
+
+int spectrum_packet_decode(const unsigned char *buf, size_t len,
+                           struct rig_spectrum_line *line, unsigned char *data,
+                           uint32_t *seq, uint64_t *time_us)
+{
+    size_t bins, payload_len;
+    int decoded;
+    size_t i;
+
+    if (len < SPECTRUM_PACKET_HEADER_SIZE
+            || get_u32(buf) != SPECTRUM_PACKET_MAGIC
+            || buf[4] != SPECTRUM_PACKET_VERSION)
+    {
+        return -RIG_EPROTO;
+    }
+
+    bins = get_u16(buf + 68);
+    payload_len = get_u16(buf + 70);
+
+    if (bins > HAMLIB_MAX_SPECTRUM_DATA
+            || SPECTRUM_PACKET_HEADER_SIZE + payload_len > len)
+    {
+        return -RIG_EPROTO;
+    }
+
+    switch (buf[5])
+    {
+    case SPECTRUM_ENCODING_RAW:
+        if (payload_len != bins)
+        {
+            return -RIG_EPROTO;
+        }
+
+        memcpy(data, buf + SPECTRUM_PACKET_HEADER_SIZE, bins);
+        break;
+
+    case SPECTRUM_ENCODING_RLE:
+    case SPECTRUM_ENCODING_DELTA:
+        decoded = spectrum_packbits_decode(buf + SPECTRUM_PACKET_HEADER_SIZE,
+                                           payload_len, data, bins);
+
+        if (decoded < 0 || (size_t)decoded != bins)
+        {
+            return -RIG_EPROTO;
+        }
+
+        if (buf[5] == SPECTRUM_ENCODING_DELTA)
+        {
+            for (i = 1; i < bins; i++)
+            {
+                data[i] = (unsigned char)(data[i] + data[i - 1]);
+            }
+        }
+
+        break;
+
+    default:
+        return -RIG_EPROTO;
+    }
+
+    memset(line, 0, sizeof(*line));
+    line->spectrum_mode = (enum rig_spectrum_mode_e)buf[6];
+    line->id = buf[7];
+    line->center_freq = (freq_t)get_u64(buf + 24);
+    line->span_freq = (freq_t)get_u64(buf + 32);
+    line->low_edge_freq = (freq_t)get_u64(buf + 40);
+    line->high_edge_freq = (freq_t)get_u64(buf + 48);
+    line->data_level_min = (int32_t)get_u32(buf + 56);
+    line->data_level_max = (int32_t)get_u32(buf + 60);
+    line->signal_strength_min = (int16_t)get_u16(buf + 64) / 10.0;
+    line->signal_strength_max = (int16_t)get_u16(buf + 66) / 10.0;
+    line->spectrum_data_length = bins;
+    line->spectrum_data = data;
+
+    if (seq) { *seq = get_u32(buf + 8); }
+
+    if (time_us) { *time_us = get_u64(buf + 16); }
+
+    return RIG_OK;
+}
+
+
+static const char *const format_names[] = { "json", "binary", "both" };
+
+
+const char *spectrum_packet_format_name(int format)
+{
+    if (format < 0 || format >= (int)(sizeof(format_names) / sizeof(format_names[0])))
+    {
+        return "";
+    }
+
+    return format_names[format];
+}
+
+
+int spectrum_packet_format_parse(const char *name)
+{
+    int i;
+
+    for (i = 0; i < (int)(sizeof(format_names) / sizeof(format_names[0])); i++)
+    {
+        if (strcmp(name, format_names[i]) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+static const struct
+{
+    int encoding;
+    const char *name;
+} encoding_names[] =
+{
+    { SPECTRUM_ENCODING_RAW,   "raw" },
+    { SPECTRUM_ENCODING_RLE,   "rle" },
+    { SPECTRUM_ENCODING_DELTA, "delta" },
+    { SPECTRUM_ENCODING_AUTO,  "auto" },
+};
+
+
+const char *spectrum_packet_encoding_name(int encoding)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(encoding_names) / sizeof(encoding_names[0]); i++)
+    {
+        if (encoding_names[i].encoding == encoding)
+        {
+            return encoding_names[i].name;
+        }
+    }
+
+    return "";
+}
+
+
+int spectrum_packet_encoding_parse(const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(encoding_names) / sizeof(encoding_names[0]); i++)
+    {
+        if (strcmp(name, encoding_names[i].name) == 0)
+        {
+            return encoding_names[i].encoding;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,106 @@
+/*
+ *  Hamlib Interface - binary spectrum multicast packet
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Binary spectrum line packet for the multicast data publisher, sent in
+ * place of (or next to) the hex-encoded "spectra" entry of the JSON
+ * snapshot. The wire format is described in README.multicast;
+ * tests/rigtestmcastrx.c has a standalone reference decoder. */
+
+#ifndef _SPECTRUM_PACKET_H
+#define _SPECTRUM_PACKET_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hamlib/rig.h"
+
+__BEGIN_DECLS
+
+/* "HSPC" in network byte order; a JSON snapshot starts with '{' instead */
+#define SPECTRUM_PACKET_MAGIC       0x48535043
+#define SPECTRUM_PACKET_VERSION     1
+
+/* Fixed header, all fields in network byte order:
+ *   0 u32 magic          4 u8 version       5 u8 encoding
+ *   6 u8 spectrum mode   7 u8 scope id      8 u32 sequence
+ *  12 u32 source       16 u64 time, microseconds since the epoch
+ *  24 u64 center Hz     32 u64 span Hz     40 u64 low edge Hz
+ *  48 u64 high edge Hz  56 i32 level min   60 i32 level max
+ *  64 i16 strength min, 0.1 dB             66 i16 strength max, 0.1 dB
+ *  68 u16 bin count     70 u16 payload bytes following the header */
+#define SPECTRUM_PACKET_HEADER_SIZE 72
+
+/* The encoder falls back to RAW whenever compression does not pay off */
+#define SPECTRUM_PACKET_MAX_SIZE \
+    (SPECTRUM_PACKET_HEADER_SIZE + HAMLIB_MAX_SPECTRUM_DATA)
+
+enum spectrum_packet_encoding_e
+{
+    SPECTRUM_ENCODING_RAW = 0,      /* One byte per bin */
+    SPECTRUM_ENCODING_RLE = 1,      /* PackBits run-length coded bins */
+    SPECTRUM_ENCODING_DELTA = 2,    /* PackBits coded differences of adjacent bins */
+    SPECTRUM_ENCODING_AUTO = 255,   /* Encoder only: smallest of the above */
+};
+
+/* Values of rig_state.multicast_spectrum_format */
+enum spectrum_packet_format_e
+{
+    SPECTRUM_FORMAT_JSON = 0,       /* Spectrum lines in the JSON snapshot only */
+    SPECTRUM_FORMAT_BINARY,         /* Spectrum lines as binary packets only */
+    SPECTRUM_FORMAT_BOTH,
+};
+
+/* Encode line into buf (at least SPECTRUM_PACKET_MAX_SIZE bytes for any
+ * line).  Returns the packet length or a negative Hamlib error code. */
+int spectrum_packet_encode(const struct rig_spectrum_line *line,
+                           uint32_t seq, uint64_t time_us, int encoding,
+                           unsigned char *buf, size_t buf_len);
+
+/* Decode a packet into line, with the bins stored in data (at least
+ * HAMLIB_MAX_SPECTRUM_DATA bytes).  seq and time_us may be NULL.
+ * Returns RIG_OK, or -RIG_EPROTO for a malformed or foreign packet. */
+int spectrum_packet_decode(const unsigned char *buf, size_t len,
+                           struct rig_spectrum_line *line, unsigned char *data,
+                           uint32_t *seq, uint64_t *time_us);
+
+/* The rig a packet came from when the multicast hub sends for several
+ * (see network.c), 0 from a publisher serving a single rig */
+uint32_t spectrum_packet_source(const unsigned char *buf);
+void spectrum_packet_set_source(unsigned char *buf, uint32_t source);
+
+/* PackBits coding used by the RLE and DELTA encodings.  encode returns
+ * the coded length, or -1 if it would exceed out_len; decode returns the
+ * decoded length, or -1 on malformed input or overflow of out_len. */
+int spectrum_packbits_encode(const unsigned char *in, size_t in_len,
+                             unsigned char *out, size_t out_len);
+int spectrum_packbits_decode(const unsigned char *in, size_t in_len,
+                             unsigned char *out, size_t out_len);
+
+/* Names of the multicast_spectrum_format and _encoding tokens; parse
+ * returns -1 for an unknown name */
+const char *spectrum_packet_format_name(int format);
+int spectrum_packet_format_parse(const char *name);
+const char *spectrum_packet_encoding_name(int encoding);
+int spectrum_packet_encoding_parse(const char *name);
+
+__END_DECLS
+
+#endif /* _SPECTRUM_PACKET_H */
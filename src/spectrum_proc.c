@@ -0,0 +1,389 @@
+/*
+ *  Hamlib Interface - spectrum line processing
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "hamlib/config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+
+#include "hamlib/rig.h"
+#include "spectrum_proc.h"
+
+
+size_t spectrum_decimate_max(const unsigned char *in, size_t n, size_t factor,
+                             unsigned char *out)
+{
+    size_t i, j, o = 0;
+
+    for (i = 0; i < n; i += factor)
+    {
+        size_t end = i + factor < n ? i + factor : n;
+        unsigned char m = in[i];
+
+        for (j = i + 1; j < end; j++)
+        {
+            m = in[j] > m ? in[j] : m;
+        }
+
+        out[o++] = m;
+    }
+
+    return o;
+}
+
+
+size_t spectrum_decimate_mean(const unsigned char *in, size_t n, size_t factor,
+                              unsigned char *out)
+{
+    size_t i, j, o = 0;
+
+    for (i = 0; i < n; i += factor)
+    {
+        size_t end = i + factor < n ? i + factor : n;
+        unsigned int sum = 0;
+
+        for (j = i; j < end; j++)
+        {
+            sum += in[j];
+        }
+
+        out[o++] = (unsigned char)((sum + (end - i) / 2) / (end - i));
+    }
+
+    return o;
+}
+
+
+void spectrum_average(float *acc, const unsigned char *in, size_t n,
+                      float alpha)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        acc[i] += alpha * ((float)in[i] - acc[i]);
+    }
+}
+
+
+void spectrum_peak_hold(unsigned char *peak, const unsigned char *in, size_t n,
+                        int decay)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        int held = peak[i] - decay;
+
+        held = held > 0 ? held : 0;
+        peak[i] = in[i] > held ? in[i] : (unsigned char)held;
+    }
+}
+
+
+static int parse_int(const char *val, int min, int max, int *out)
+{
+    char *end;
+    long v;
+
+    errno = 0;
+    v = strtol(val, &end, 10);
+
+    if (end == val || *end != '\0' || errno || v < min || v > max)
+    {
+        return -RIG_EINVAL;
+    }
+
+    *out = (int)v;
+    return RIG_OK;
+}
+
+
+int spectrum_proc_parse(const char *spec, struct spectrum_proc_config *config)
+{
+    struct spectrum_proc_config c;
+    char buf[128];
+    char *item, *saveptr = NULL;
+
+    if (spec == NULL || strlen(spec) >= sizeof(buf))
+    {
+        return -RIG_EINVAL;
+    }
+
+    memset(&c, 0, sizeof(c));
+    strcpy(buf, spec);
+
+    for (item = strtok_r(buf, ",", &saveptr); item;
+            item = strtok_r(NULL, ",", &saveptr))
+    {
+        char *val = strchr(item, '=');
+        int result = RIG_OK;
+
+        if (val == NULL)
+        {
+            return -RIG_EINVAL;
+        }
+
+        *val++ = '\0';
+
+        if (strcmp(item, "bins") == 0)
+        {
+            result = parse_int(val, 0, HAMLIB_MAX_SPECTRUM_DATA, &c.bins);
+        }
+        else if (strcmp(item, "decimate") == 0)
+        {
+            if (strcmp(val, "max") == 0)
+            {
+                c.decimate = SPECTRUM_DECIMATE_MAX;
+            }
+            else if (strcmp(val, "mean") == 0)
+            {
+                c.decimate = SPECTRUM_DECIMATE_MEAN;
+            }
+            else
+            {
+                result = -RIG_EINVAL;
+            }
+        }
+        else if (strcmp(item, "average") == 0)
+        {
+            char *end;
+
+            c.average = strtod(val, &end);
+
+            if (end == val || *end != '\0' || !(c.average >= 0 && c.average <= 1))
+            {
+                result = -RIG_EINVAL;
+            }
+        }
+        else if (strcmp(item, "peak") == 0)
+        {
+            c.peak = 1;
+            result = parse_int(val, 0, 255, &c.peak_decay);
+        }
+        else if (strcmp(item, "rate") == 0)
+        {
+            result = parse_int(val, 0, SPECTRUM_PROC_RATE_MAX, &c.rate);
+        }
+        else
+        {
+            result = -RIG_EINVAL;
+        }
+
+        if (result != RIG_OK)
+        {
+            return result;
+        }
+    }
+
+    /* Averaging with weight 1 is no averaging */
+    if (c.average == 1)
+    {
+        c.average = 0;
+    }
+
+    *config = c;
+
+    return RIG_OK;
+}
+
+
+/* Append a comma-separated item to buf, dropping what does not fit */
+static void append_item(char *buf, size_t len, const char *fmt, ...)
+{
+    size_t used = strlen(buf);
+    char item[64];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(item, sizeof(item), fmt, ap);
+    va_end(ap);
+
+    if (used + 1 + strlen(item) < len)
+    {
+        if (used)
+        {
+            buf[used++] = ',';
+        }
+
+        strcpy(buf + used, item);
+    }
+}
+
+
+void spectrum_proc_format(const struct spectrum_proc_config *config, char *buf,
+                          size_t len)
+{
+    buf[0] = '\0';
+
+    if (config->bins > 0)
+    {
+        append_item(buf, len, "bins=%d", config->bins);
+
+        if (config->decimate == SPECTRUM_DECIMATE_MEAN)
+        {
+            append_item(buf, len, "decimate=mean");
+        }
+    }
+
+    if (config->average > 0)
+    {
+        append_item(buf, len, "average=%g", config->average);
+    }
+
+    if (config->peak)
+    {
+        append_item(buf, len, "peak=%d", config->peak_decay);
+    }
+
+    if (config->rate > 0)
+    {
+        append_item(buf, len, "rate=%d", config->rate);
+    }
+}
+
+
+int spectrum_proc_is_passthrough(const struct spectrum_proc_config *config)
+{
+    return config->bins == 0 && config->average == 0 && !config->peak
+           && config->rate == 0;
+}
+
+
+void spectrum_proc_init(struct spectrum_proc *proc,
+                        const struct spectrum_proc_config *config)
+{
+    memset(proc, 0, sizeof(*proc));
+    proc->config = *config;
+}
+
+
+int spectrum_proc_run(struct spectrum_proc *proc,
+                      const struct rig_spectrum_line *in, int64_t now_us,
+                      struct rig_spectrum_line *out)
+{
+    const struct spectrum_proc_config *c = &proc->config;
+    struct spectrum_proc_scope *sc;
+    const unsigned char *data = in->spectrum_data;
+    size_t n = in->spectrum_data_length;
+    size_t i;
+
+    *out = *in;
+
+    if (in->id < 0 || in->id >= HAMLIB_MAX_SPECTRUM_SCOPES
+            || n > HAMLIB_MAX_SPECTRUM_DATA || spectrum_proc_is_passthrough(c))
+    {
+        return 1;
+    }
+
+    sc = &proc->scope[in->id];
+
+    if (c->bins > 0 && n > (size_t)c->bins)
+    {
+        size_t factor = (n + c->bins - 1) / c->bins;
+
+        n = c->decimate == SPECTRUM_DECIMATE_MEAN
+            ? spectrum_decimate_mean(data, n, factor, sc->out)
+            : spectrum_decimate_max(data, n, factor, sc->out);
+        data = sc->out;
+    }
+
+    /* Averages and peaks of another span or bin count mean nothing here */
+    if (n != sc->length || in->low_edge_freq != sc->low_edge_freq
+            || in->high_edge_freq != sc->high_edge_freq)
+    {
+        sc->primed = 0;
+        sc->length = n;
+        sc->low_edge_freq = in->low_edge_freq;
+        sc->high_edge_freq = in->high_edge_freq;
+    }
+
+    if (c->average > 0)
+    {
+        if (sc->primed)
+        {
+            spectrum_average(sc->avg, data, n, (float)c->average);
+        }
+        else
+        {
+            for (i = 0; i < n; i++)
+            {
+                sc->avg[i] = data[i];
+            }
+        }
+
+        for (i = 0; i < n; i++)
+        {
+            sc->out[i] = (unsigned char)(sc->avg[i] + 0.5f);
+        }
+
+        data = sc->out;
+    }
+
+    if (c->peak)
+    {
+        if (sc->primed)
+        {
+            spectrum_peak_hold(sc->peak, data, n, c->peak_decay);
+        }
+        else
+        {
+            memcpy(sc->peak, data, n);
+        }
+
+        data = sc->peak;
+    }
+
+    sc->primed = 1;
+
+    if (c->rate > 0)
+    {
+        int64_t interval = 1000000 / c->rate;
+
+        if (sc->last_us != 0 && now_us - sc->last_us < interval)
+        {
+            return 0;
+        }
+
+        /* Keep the cadence when lines arrive a little late, so jitter
+         * does not halve the delivered rate */
+        if (sc->last_us != 0 && now_us - sc->last_us < 2 * interval)
+        {
+            sc->last_us += interval;
+        }
+        else
+        {
+            sc->last_us = now_us ? now_us : 1;
+        }
+    }
+
+    if (data != in->spectrum_data)
+    {
+        out->spectrum_data = (unsigned char *)data;
+        out->spectrum_data_length = n;
+    }
+
+    return 1;
+}
@@ -0,0 +1,118 @@
+/*
+ *  Hamlib Interface - spectrum line processing
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Per-subscriber processing of spectrum scope lines before delivery:
+ * bin decimation, exponential averaging, peak hold and rate limiting.
+ *
+ * A configuration is written as a comma-separated list, e.g.
+ * "bins=256,decimate=max,average=0.25,peak=2,rate=5":
+ *   bins=N          reduce each line to at most N bins (0 = keep all)
+ *   decimate=max    keep the strongest bin of each group (default), or
+ *   decimate=mean   their mean
+ *   average=A       exponential average y += A * (x - y), 0 < A <= 1
+ *                   (0 or 1 = off)
+ *   peak=D          peak hold, the held level falling by D per line
+ *                   (0 = hold forever; omit to disable)
+ *   rate=R          deliver at most R lines per second per scope (0 = all)
+ * An empty string passes lines through untouched.  Lines held back by
+ * the rate limit still feed the average and peak hold. */
+
+#ifndef _SPECTRUM_PROC_H
+#define _SPECTRUM_PROC_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hamlib/rig.h"
+
+__BEGIN_DECLS
+
+#define SPECTRUM_PROC_RATE_MAX 1000
+
+enum spectrum_decimate_e
+{
+    SPECTRUM_DECIMATE_MAX = 0,
+    SPECTRUM_DECIMATE_MEAN,
+};
+
+struct spectrum_proc_config
+{
+    int bins;
+    int decimate;
+    double average;
+    int peak;           /* 1 if peak hold is on */
+    int peak_decay;
+    int rate;
+};
+
+struct spectrum_proc_scope
+{
+    int primed;             /* avg/peak hold valid for the current window */
+    size_t length;          /* bins after decimation */
+    freq_t low_edge_freq;   /* window the held state belongs to */
+    freq_t high_edge_freq;
+    int64_t last_us;        /* time of the last delivered line, 0 = none */
+    float avg[HAMLIB_MAX_SPECTRUM_DATA];
+    unsigned char peak[HAMLIB_MAX_SPECTRUM_DATA];
+    unsigned char out[HAMLIB_MAX_SPECTRUM_DATA];
+};
+
+struct spectrum_proc
+{
+    struct spectrum_proc_config config;
+    struct spectrum_proc_scope scope[HAMLIB_MAX_SPECTRUM_SCOPES];
+};
+
+/* Parse spec into config; returns RIG_OK or -RIG_EINVAL, leaving config
+ * untouched on error */
+int spectrum_proc_parse(const char *spec, struct spectrum_proc_config *config);
+
+/* Canonical spec of config, "" when it passes lines through */
+void spectrum_proc_format(const struct spectrum_proc_config *config, char *buf,
+                          size_t len);
+
+int spectrum_proc_is_passthrough(const struct spectrum_proc_config *config);
+
+void spectrum_proc_init(struct spectrum_proc *proc,
+                        const struct spectrum_proc_config *config);
+
+/* Process one line at now_us (any monotonic microsecond clock).  Returns
+ * 1 with out describing the line to deliver, its data held by proc until
+ * the next call for the same scope; 0 when the line is held back. */
+int spectrum_proc_run(struct spectrum_proc *proc,
+                      const struct rig_spectrum_line *in, int64_t now_us,
+                      struct rig_spectrum_line *out);
+
+/* Kernels, written as plain loops over contiguous arrays so that the
+ * compiler can vectorize them.  The decimators reduce groups of factor
+ * bins (the last group may be shorter) and return the output length. */
+size_t spectrum_decimate_max(const unsigned char *in, size_t n, size_t factor,
+                             unsigned char *out);
+size_t spectrum_decimate_mean(const unsigned char *in, size_t n, size_t factor,
+                              unsigned char *out);
+void spectrum_average(float *acc, const unsigned char *in, size_t n,
+                      float alpha);
+void spectrum_peak_hold(unsigned char *peak, const unsigned char *in, size_t n,
+                        int decay);
+
+__END_DECLS
+
+#endif /* _SPECTRUM_PROC_H */
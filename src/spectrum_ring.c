@@ -0,0 +1,114 @@
+/*
+ *  Hamlib Interface - spectrum line ring
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "hamlib/config.h"
+
+#include <string.h>
+
+#include "hamlib/rig.h"
+#include "spectrum_ring.h"
+
+
+void spectrum_ring_init(struct spectrum_ring *ring)
+{
+    memset(ring, 0, sizeof(*ring));
+}
+
+
+struct spectrum_ring_slot *spectrum_ring_acquire(struct spectrum_ring *ring)
+{
+    unsigned int head = ring->head;
+    struct spectrum_ring_slot *slot;
+
+    /* Acquire pairs with the consumer's release, so the slot is no longer
+     * being read once it shows up as free */
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)
+            >= SPECTRUM_RING_SLOTS)
+    {
+        return NULL;
+    }
+
+    slot = &ring->slot[head & (SPECTRUM_RING_SLOTS - 1)];
+    slot->line.spectrum_data = slot->data;
+
+    return slot;
+}
+
+
+void spectrum_ring_commit(struct spectrum_ring *ring)
+{
+    __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+}
+
+
+int spectrum_ring_put(struct spectrum_ring *ring,
+                      const struct rig_spectrum_line *line)
+{
+    struct spectrum_ring_slot *slot;
+
+    if (line->spectrum_data_length > HAMLIB_MAX_SPECTRUM_DATA)
+    {
+        return -RIG_EINVAL;
+    }
+
+    slot = spectrum_ring_acquire(ring);
+
+    if (slot == NULL)
+    {
+        ring->dropped++;
+        return -RIG_ENAVAIL;
+    }
+
+    slot->line = *line;
+    slot->line.spectrum_data = slot->data;
+    memcpy(slot->data, line->spectrum_data, line->spectrum_data_length);
+
+    spectrum_ring_commit(ring);
+
+    return RIG_OK;
+}
+
+
+struct spectrum_ring_slot *spectrum_ring_peek(struct spectrum_ring *ring)
+{
+    unsigned int tail = ring->tail;
+
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        return NULL;
+    }
+
+    return &ring->slot[tail & (SPECTRUM_RING_SLOTS - 1)];
+}
+
+
+void spectrum_ring_release(struct spectrum_ring *ring)
+{
+    __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+
+int spectrum_ring_empty(struct spectrum_ring *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)
+           == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
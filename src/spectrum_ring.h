@@ -0,0 +1,81 @@
+/*
+ *  Hamlib Interface - spectrum line ring
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Lock-free single-producer single-consumer ring of preallocated spectrum
+ * line slots, handing lines from the thread that parses them to the
+ * multicast publisher thread.  The producer fills a slot in place and
+ * commits it; the consumer serializes straight from the slot and releases
+ * it.  When the consumer falls behind, new lines are dropped rather than
+ * blocking the producer. */
+
+#ifndef _SPECTRUM_RING_H
+#define _SPECTRUM_RING_H 1
+
+#include "hamlib/rig.h"
+
+__BEGIN_DECLS
+
+#define SPECTRUM_RING_SLOTS 16      /* Must be a power of two */
+
+struct spectrum_ring_slot
+{
+    struct rig_spectrum_line line;  /* line.spectrum_data points at data */
+    unsigned char data[HAMLIB_MAX_SPECTRUM_DATA];
+};
+
+struct spectrum_ring
+{
+    /* Free-running counters, each written by one side only; kept on
+     * separate cache lines so the two threads do not share one */
+    unsigned int head;          /* Slots committed by the producer */
+    char pad1[64 - sizeof(unsigned int)];
+    unsigned int tail;          /* Slots released by the consumer */
+    char pad2[64 - sizeof(unsigned int)];
+    unsigned int dropped;       /* Lines lost to a full ring, producer side */
+    struct spectrum_ring_slot slot[SPECTRUM_RING_SLOTS];
+};
+
+void spectrum_ring_init(struct spectrum_ring *ring);
+
+/* Producer: the next free slot, its line pointing at its own data, or
+ * NULL when the ring is full.  Nothing is visible to the consumer until
+ * spectrum_ring_commit(). */
+struct spectrum_ring_slot *spectrum_ring_acquire(struct spectrum_ring *ring);
+void spectrum_ring_commit(struct spectrum_ring *ring);
+
+/* Producer: copy line into a slot and commit it.  Returns RIG_OK,
+ * -RIG_EINVAL for a line too long for a slot or -RIG_ENAVAIL (counted
+ * in dropped) when the ring is full. */
+int spectrum_ring_put(struct spectrum_ring *ring,
+                      const struct rig_spectrum_line *line);
+
+/* Consumer: the oldest committed slot or NULL when empty.  The slot stays
+ * valid until spectrum_ring_release(). */
+struct spectrum_ring_slot *spectrum_ring_peek(struct spectrum_ring *ring);
+void spectrum_ring_release(struct spectrum_ring *ring);
+
+/* Either side: 1 when nothing is waiting for the consumer */
+int spectrum_ring_empty(struct spectrum_ring *ring);
+
+__END_DECLS
+
+#endif /* _SPECTRUM_RING_H */
@@ -0,0 +1,448 @@
+/*
+ *  Hamlib Interface - shared-memory status page
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file status_page.c
+ * \brief Shared-memory status page
+ */
+
+#include "hamlib/config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_SHM_OPEN)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define STATUS_PAGE_SHM 1
+#endif
+
+#include "hamlib/rig.h"
+#include "hamlib/rig_state.h"
+#include "status_page.h"
+#include "cache.h"
+#include "misc.h"
+
+/* Readers give up after this many torn copies rather than spin forever
+ * on a writer that died mid-update. */
+#define STATUS_PAGE_READ_TRIES 1000
+
+//! @cond Doxygen_Suppress
+struct status_page_priv
+{
+    struct rig_status_page *page;
+    pthread_mutex_t lock;       /* Poll routine and meter reads both write */
+    char name[sizeof(((struct rig_state *)0)->status_shm) + 1];
+};
+
+static const struct
+{
+    setting_t level;
+    int slot;
+} status_page_meters[] =
+{
+    { RIG_LEVEL_STRENGTH,            RIG_STATUS_METER_STRENGTH },
+    { RIG_LEVEL_SWR,                 RIG_STATUS_METER_SWR },
+    { RIG_LEVEL_ALC,                 RIG_STATUS_METER_ALC },
+    { RIG_LEVEL_RFPOWER_METER,       RIG_STATUS_METER_RFPOWER },
+    { RIG_LEVEL_RFPOWER_METER_WATTS, RIG_STATUS_METER_RFPOWER_WATTS },
+    { RIG_LEVEL_COMP_METER,          RIG_STATUS_METER_COMP },
+    { RIG_LEVEL_VD_METER,            RIG_STATUS_METER_VD },
+    { RIG_LEVEL_ID_METER,            RIG_STATUS_METER_ID },
+};
+
+
+static uint64_t status_page_now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+
+/* Seqlock write side; callers hold priv->lock */
+static void status_page_write_begin(struct rig_status_page *page)
+{
+    __atomic_store_n(&page->seq, page->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+
+static void status_page_write_end(struct rig_status_page *page)
+{
+    page->update_ms = status_page_now_ms();
+    __atomic_store_n(&page->seq, page->seq + 1, __ATOMIC_RELEASE);
+}
+//! @endcond
+
+
+/**
+ * \brief Create the status page of a rig
+ *
+ * Creates (or takes over) the POSIX shared-memory object \a name and maps
+ * it for writing.  A leading '/' is added when \a name lacks one.
+ *
+ * \return RIG_OK, or -RIG_ENIMPL on hosts without POSIX shared memory
+ */
+int status_page_start(RIG *rig, const char *name)
+{
+#ifdef STATUS_PAGE_SHM
+    struct rig_state *rs = STATE(rig);
+    struct status_page_priv *priv;
+    struct rig_status_page *page;
+    int fd;
+
+    if (rs->status_page_priv != NULL)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = calloc(1, sizeof(*priv));
+
+    if (priv == NULL)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    SNPRINTF(priv->name, sizeof(priv->name), "%s%s", name[0] == '/' ? "" : "/",
+             name);
+
+    fd = shm_open(priv->name, O_CREAT | O_RDWR, 0644);
+
+    if (fd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: shm_open(%s): %s\n", __func__, priv->name,
+                  strerror(errno));
+        free(priv);
+        return -RIG_EIO;
+    }
+
+    if (ftruncate(fd, sizeof(*page)) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: ftruncate(%s): %s\n", __func__, priv->name,
+                  strerror(errno));
+        close(fd);
+        free(priv);
+        return -RIG_EIO;
+    }
+
+    page = mmap(NULL, sizeof(*page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (page == MAP_FAILED)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: mmap(%s): %s\n", __func__, priv->name,
+                  strerror(errno));
+        free(priv);
+        return -RIG_EIO;
+    }
+
+    /* A reader of a stale page from an earlier run sees a write in
+     * progress until the header is valid again.  A writer that died
+     * mid-update left seq odd, so make it odd outright rather than
+     * counting on write_begin's increment. */
+    __atomic_store_n(&page->seq, page->seq | 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    page->magic = RIG_STATUS_PAGE_MAGIC;
+    page->version = RIG_STATUS_PAGE_VERSION;
+    page->size = sizeof(*page);
+    page->rig_model = rig->caps->rig_model;
+    memset(page->vfo_state, 0, sizeof(page->vfo_state));
+    memset(page->meter, 0, sizeof(page->meter));
+    status_page_write_end(page);
+
+    pthread_mutex_init(&priv->lock, NULL);
+    priv->page = page;
+    rs->status_page_priv = priv;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: publishing status page %s\n", __func__,
+              priv->name);
+
+    return RIG_OK;
+#else
+    rig_debug(RIG_DEBUG_ERR, "%s: no POSIX shared memory on this host\n",
+              __func__);
+    return -RIG_ENIMPL;
+#endif
+}
+
+
+/**
+ * \brief Remove the status page of a rig
+ *
+ * Unmaps and unlinks the page; readers that still have it mapped keep
+ * the last state.
+ */
+int status_page_stop(RIG *rig)
+{
+    struct rig_state *rs = STATE(rig);
+    struct status_page_priv *priv = rs->status_page_priv;
+
+    if (priv == NULL)
+    {
+        return RIG_OK;
+    }
+
+    rs->status_page_priv = NULL;
+
+#ifdef STATUS_PAGE_SHM
+    munmap(priv->page, sizeof(*priv->page));
+    shm_unlink(priv->name);
+#endif
+    pthread_mutex_destroy(&priv->lock);
+    free(priv);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Mirror the rig cache into the status page
+ *
+ * Called by the rig poll routine whenever it publishes poll data.
+ */
+void status_page_publish(RIG *rig)
+{
+    const struct rig_state *rs = STATE(rig);
+    struct status_page_priv *priv = rs->status_page_priv;
+    const struct rig_cache *cachep = CACHE(rig);
+    struct rig_status_page *page;
+    struct rig_status_vfo *v;
+
+    if (priv == NULL)
+    {
+        return;
+    }
+
+    page = priv->page;
+    v = page->vfo_state;
+
+    pthread_mutex_lock(&priv->lock);
+    status_page_write_begin(page);
+
+    page->vfo = rs->current_vfo;
+    page->tx_vfo = rs->tx_vfo;
+    page->split_vfo = cachep->split_vfo;
+    page->ptt = cachep->ptt;
+    page->split = cachep->split;
+    page->satmode = cachep->satmode;
+
+    v[RIG_STATUS_VFO_MAIN_A].freq = cachep->freqMainA;
+    v[RIG_STATUS_VFO_MAIN_A].mode = cachep->modeMainA;
+    v[RIG_STATUS_VFO_MAIN_A].width = cachep->widthMainA;
+    v[RIG_STATUS_VFO_MAIN_B].freq = cachep->freqMainB;
+    v[RIG_STATUS_VFO_MAIN_B].mode = cachep->modeMainB;
+    v[RIG_STATUS_VFO_MAIN_B].width = cachep->widthMainB;
+    v[RIG_STATUS_VFO_MAIN_C].freq = cachep->freqMainC;
+    v[RIG_STATUS_VFO_MAIN_C].mode = cachep->modeMainC;
+    v[RIG_STATUS_VFO_MAIN_C].width = cachep->widthMainC;
+    v[RIG_STATUS_VFO_SUB_A].freq = cachep->freqSubA;
+    v[RIG_STATUS_VFO_SUB_A].mode = cachep->modeSubA;
+    v[RIG_STATUS_VFO_SUB_A].width = cachep->widthSubA;
+    v[RIG_STATUS_VFO_SUB_B].freq = cachep->freqSubB;
+    v[RIG_STATUS_VFO_SUB_B].mode = cachep->modeSubB;
+    v[RIG_STATUS_VFO_SUB_B].width = cachep->widthSubB;
+    v[RIG_STATUS_VFO_SUB_C].freq = cachep->freqSubC;
+    v[RIG_STATUS_VFO_SUB_C].mode = cachep->modeSubC;
+    v[RIG_STATUS_VFO_SUB_C].width = cachep->widthSubC;
+
+    status_page_write_end(page);
+    pthread_mutex_unlock(&priv->lock);
+}
+
+
+/**
+ * \brief Record a meter read in the status page
+ *
+ * Called by rig_get_level() on success; levels that are not meters are
+ * ignored.
+ */
+void status_page_update_meter(RIG *rig, setting_t level, const value_t *val)
+{
+    struct status_page_priv *priv = STATE(rig)->status_page_priv;
+    struct rig_status_meter *m;
+    int i;
+
+    if (priv == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < (int)(sizeof(status_page_meters) / sizeof(status_page_meters[0]));
+            i++)
+    {
+        if (status_page_meters[i].level == level)
+        {
+            break;
+        }
+    }
+
+    if (i == (int)(sizeof(status_page_meters) / sizeof(status_page_meters[0])))
+    {
+        return;
+    }
+
+    m = &priv->page->meter[status_page_meters[i].slot];
+
+    pthread_mutex_lock(&priv->lock);
+    status_page_write_begin(priv->page);
+    m->value = RIG_LEVEL_IS_FLOAT(level) ? val->f : (float)val->i;
+    m->valid = 1;
+    m->time_ms = status_page_now_ms();
+    status_page_write_end(priv->page);
+    pthread_mutex_unlock(&priv->lock);
+}
+
+
+/**
+ * \brief Map a status page for reading
+ * \param name  The shared-memory object name given as \c status_shm
+ *
+ * Maps the page read-only.  The page must have been created by a rig
+ * with the same layout version.
+ *
+ * \return The page, or NULL if it does not exist or is incompatible
+ *
+ * \sa rig_status_page_read(), rig_status_page_close()
+ */
+const struct rig_status_page *HAMLIB_API rig_status_page_open(const char *name)
+{
+#ifdef STATUS_PAGE_SHM
+    char path[256];
+    const struct rig_status_page *page;
+    struct stat st;
+    int fd;
+
+    if (!name || !name[0])
+    {
+        return NULL;
+    }
+
+    SNPRINTF(path, sizeof(path), "%s%s", name[0] == '/' ? "" : "/", name);
+    fd = shm_open(path, O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*page))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    page = mmap(NULL, sizeof(*page), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (page == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    if (page->magic != RIG_STATUS_PAGE_MAGIC
+            || page->version != RIG_STATUS_PAGE_VERSION)
+    {
+        munmap((void *)page, sizeof(*page));
+        return NULL;
+    }
+
+    return page;
+#else
+    return NULL;
+#endif
+}
+
+
+/**
+ * \brief Take a consistent snapshot of a status page
+ * \param page      A page from rig_status_page_open()
+ * \param snapshot  Where to copy the page
+ *
+ * Makes no system call: the copy is retried while the writer is updating
+ * the page.
+ *
+ * \return RIG_OK, or -RIG_BUSBUSY if the page stayed busy
+ */
+int HAMLIB_API rig_status_page_read(const struct rig_status_page *page,
+                                    struct rig_status_page *snapshot)
+{
+    int tries;
+
+    if (!page || !snapshot)
+    {
+        return -RIG_EINVAL;
+    }
+
+    for (tries = 0; tries < STATUS_PAGE_READ_TRIES; tries++)
+    {
+        uint32_t seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+
+        if (seq & 1)
+        {
+            continue;
+        }
+
+        memcpy(snapshot, page, sizeof(*snapshot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == seq)
+        {
+            snapshot->seq = seq;
+            return RIG_OK;
+        }
+    }
+
+    return -RIG_BUSBUSY;
+}
+
+
+/**
+ * \brief Unmap a status page
+ * \param page  A page from rig_status_page_open(), or NULL
+ */
+void HAMLIB_API rig_status_page_close(const struct rig_status_page *page)
+{
+#ifdef STATUS_PAGE_SHM
+
+    if (page)
+    {
+        munmap((void *)page, sizeof(*page));
+    }
+
+#endif
+}
+
+/** @} */
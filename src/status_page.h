@@ -0,0 +1,39 @@
+/*
+ *  Hamlib Interface - shared-memory status page writer
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#ifndef _STATUS_PAGE_INT_H
+#define _STATUS_PAGE_INT_H 1
+
+#include "hamlib/rig.h"
+#include "hamlib/status_page.h"
+
+__BEGIN_DECLS
+
+/* Hamlib internal use, see rig.c, event.c and settings.c */
+int status_page_start(RIG *rig, const char *name);
+int status_page_stop(RIG *rig);
+void status_page_publish(RIG *rig);
+void status_page_update_meter(RIG *rig, setting_t level, const value_t *val);
+
+__END_DECLS
+
+#endif /* _STATUS_PAGE_INT_H */
@@ -30,8 +30,10 @@
 #include "stream.h"
 #include "stream_ringbuf.h"
 #include "hamlib/rig_state.h"
+#include "stream_codec.h"
 #include "stream_convert.h"
 #include "stream_proto.h"
+#include "stream_record.h"
 #include "stream_time.h"
 #include "cache.h"
 #include "misc.h"
@@ -65,6 +67,9 @@ int rig_stream_state_init(struct rig_stream_state **state)
 }
 
 
+static void stream_reader_free(struct rig_stream_reader *reader);
+
+
 /* Quiescent teardown of a single stream that the caller has already removed
  * from the registry. Marks it closing, wakes and waits out any blocked
  * rig_stream_read()/rig_stream_wait_write_status() caller, runs the backend
@@ -105,6 +110,16 @@ static void stream_teardown(struct rig_stream_state *ss,
 
     pthread_mutex_unlock(&ss->stream_mutex);
 
+    /* Their readers have seen the stream close; what they read goes to
+     * disk before the readers go. */
+    while (stream->recorders)
+    {
+        struct rig_stream_recorder *rec = stream->recorders;
+
+        stream->recorders = rec->next;
+        stream_recorder_finish(rec);
+    }
+
     if (stream->rig && stream->rig->caps->stream_close)
     {
         stream->rig->caps->stream_close(stream->rig, stream);
@@ -112,8 +127,18 @@ static void stream_teardown(struct rig_stream_state *ss,
 
     stream_ringbuf_destroy(&stream->ringbuf);
     stream_write_event_destroy(stream);
+    while (stream->readers)
+    {
+        struct rig_stream_reader *r = stream->readers;
+
+        stream->readers = r->next;
+        stream_reader_free(r);
+    }
+
     stream_conv_free(stream->conv);
-    free(stream);
+    free(stream->acquire_bounce);
+    free(stream->acquire_silence);
+    free(stream->alloc);
 }
 
 
@@ -319,9 +344,8 @@ static void stream_guard_leave(RIG *rig, rig_stream_t *stream)
                                 | RIG_STREAM_FORMAT_IQ_CS16 \
                                 | RIG_STREAM_FORMAT_IQ_CF32)
 
-#ifdef HAVE_SAMPLERATE
-/* Standard rates advertised in the effective set when the resampler is
- * built (bounded by the largest native rate; I/Q strictly below it). */
+/* Standard rates advertised in the effective set (bounded by the largest
+ * native rate; I/Q strictly below it). */
 static const int stream_curated_rates[] =
 {
     8000, 11025, 16000, 22050, 24000, 44100, 48000, 96000, 192000, 0
@@ -329,14 +353,12 @@ static const int stream_curated_rates[] =
 
 /* Largest integer-decimation factor advertised (exact divisions only). */
 #define STREAM_MAX_DECIM_FACTOR 10
-#endif
 
 static int stream_type_is_iq_type(rig_stream_type_t type)
 {
     return type == RIG_STREAM_TYPE_IQ_RX || type == RIG_STREAM_TYPE_IQ_TX;
 }
 
-#ifdef HAVE_SAMPLERATE
 /* Append rate to a 0-terminated list if absent and there is room; the
  * caller adds in priority order, so on overflow the least useful entries
  * (highest decimation factors, added last) are the ones trimmed. */
@@ -374,8 +396,6 @@ static int stream_rate_list_max(const int *rates)
     return max;
 }
 
-#endif /* HAVE_SAMPLERATE */
-
 /* Ascending int comparator for caps list sorting (rates and channel
  * counts alike). */
 static int stream_rate_cmp(const void *a, const void *b)
@@ -451,6 +471,12 @@ static void stream_derive_caps(struct rig_stream_caps *dst,
     if (src->formats & STREAM_PCM_FORMAT_MASK)
     {
         dst->formats |= STREAM_PCM_FORMAT_MASK;
+
+        /* The frontend codes Opus from PCM audio when built with libopus */
+        if (!is_iq && stream_opus_available())
+        {
+            dst->formats |= RIG_STREAM_FORMAT_OPUS;
+        }
     }
 
     if (src->formats & STREAM_IQ_FORMAT_MASK)
@@ -492,14 +518,12 @@ static void stream_derive_caps(struct rig_stream_caps *dst,
         qsort(dst->channels, n, sizeof(int), stream_rate_cmp);
     }
 
-#ifdef HAVE_SAMPLERATE
-    /* Rates (resampler built): native, then curated standards, then
+    /* Rates: native, then curated standards, then
      * integer divisions of each native rate (factors 2..10, exact results
      * only) — in that priority order, deduplicated, ascending. This list
      * is discoverability; acceptance at open is rule-based. Audio may go
      * up to the largest native rate, I/Q only strictly below it
-     * (downward-only: the I/Q sample rate is the represented bandwidth).
-     * Without the resampler the effective rates equal the native rates. */
+     * (downward-only: the I/Q sample rate is the represented bandwidth). */
     {
         int native_max = stream_rate_list_max(src->sample_rates);
         int n;
@@ -534,7 +558,6 @@ static void stream_derive_caps(struct rig_stream_caps *dst,
 
         qsort(dst->sample_rates, n, sizeof(int), stream_rate_cmp);
     }
-#endif /* HAVE_SAMPLERATE */
 }
 
 /* Return the app-visible derived caps array, building or refreshing it
@@ -816,7 +839,6 @@ static int caps_rate_native(const struct rig_stream_caps *caps, int rate)
 }
 
 
-#ifdef HAVE_SAMPLERATE
 /* Smallest native rate >= rate (the cheapest downconversion source), or 0
  * when the request exceeds every native rate — the effective set is
  * bounded by the largest native rate for audio and I/Q alike. */
@@ -837,7 +859,26 @@ static int caps_rate_source(const struct rig_stream_caps *caps, int rate)
 
     return best;
 }
-#endif
+
+/* Smallest native rate that is a whole multiple of rate (the cheapest
+ * decimation source), or 0 if none is. */
+static int caps_rate_multiple(const struct rig_stream_caps *caps, int rate)
+{
+    int best = 0;
+
+    for (int i = 0; i < HAMLIB_MAX_STREAM_RATES
+            && caps->sample_rates[i] != 0; i++)
+    {
+        int r = caps->sample_rates[i];
+
+        if (r % rate == 0 && (best == 0 || r < best))
+        {
+            best = r;
+        }
+    }
+
+    return best;
+}
 
 /* Resolution for a pre-derived caps entry (native_formats set — a relaying
  * backend such as netrigctl): conversion happens on the far side of the
@@ -867,9 +908,16 @@ static int resolve_delegated_source(const struct rig_stream_config *config,
     }
 
     /* Codec formats are native-only on the far side too: same rule as
-     * resolve_stream_source(), against the relayed native view. */
+     * resolve_stream_source(), against the relayed native view — unless
+     * the far side codes them from PCM itself, where its own checks apply. */
     if (!(config->format & (STREAM_PCM_FORMAT_MASK | STREAM_IQ_FORMAT_MASK)))
     {
+        if (!(config->format & caps->native_formats))
+        {
+            *conversions = RIG_STREAM_CONV_CODEC;
+            return RIG_OK;
+        }
+
         if (!rate_in_list(caps->native_sample_rates, config->sample_rate))
         {
             rig_debug(RIG_DEBUG_ERR,
@@ -921,6 +969,12 @@ static int resolve_delegated_source(const struct rig_stream_config *config,
         conv |= RIG_STREAM_CONV_CHANNELS;
     }
 
+    /* The far side shifts too; it checks the rest of the request. */
+    if (config->iq_shift != 0)
+    {
+        conv |= RIG_STREAM_CONV_SHIFT;
+    }
+
     *conversions = conv;
     return RIG_OK;
 }
@@ -975,6 +1029,25 @@ static int resolve_stream_source(const struct rig_stream_config *config,
         return -RIG_EINVAL;
     }
 
+    /* The decimator takes complex input and only ever narrows; the shift
+     * is one of its stages. */
+    if (config->iq_decimate || config->iq_shift != 0)
+    {
+        if (config->type != RIG_STREAM_TYPE_IQ_RX)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: iq_decimate/iq_shift need an I/Q RX "
+                      "stream\n", __func__);
+            return -RIG_EINVAL;
+        }
+
+        if (!config->iq_decimate || !isfinite(config->iq_shift))
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: iq_shift needs iq_decimate and a "
+                      "finite value\n", __func__);
+            return -RIG_EINVAL;
+        }
+    }
+
     /* Pre-derived entry: the relaying backend's far side converts;
      * backend_cfg stays equal to the request. */
     if (caps->native_formats != 0)
@@ -982,6 +1055,38 @@ static int resolve_stream_source(const struct rig_stream_config *config,
         return resolve_delegated_source(config, caps, conversions);
     }
 
+    /* Opus from a PCM-only backend: the pipeline encodes (RX) or decodes
+     * (TX) on its float side, so the rest resolves as a PCM_F32 request at
+     * a rate Opus codes. */
+    if (config->format == RIG_STREAM_FORMAT_OPUS
+            && !(caps->formats & RIG_STREAM_FORMAT_OPUS)
+            && !is_iq && (caps->formats & STREAM_PCM_FORMAT_MASK))
+    {
+        struct rig_stream_config pcm_req = *config;
+        int ret;
+
+        if (!stream_opus_available()
+                || !stream_opus_rate_ok(config->sample_rate, config->channels))
+        {
+            rig_debug(RIG_DEBUG_ERR,
+                      "%s: Opus at %d Hz x %d needs libopus and 8, 12, 16, 24 "
+                      "or 48 kHz mono or stereo\n",
+                      __func__, config->sample_rate, config->channels);
+            return -RIG_EINVAL;
+        }
+
+        pcm_req.format = RIG_STREAM_FORMAT_PCM_F32;
+        ret = resolve_stream_source(&pcm_req, caps, backend_cfg, conversions);
+
+        if (ret == RIG_OK)
+        {
+            *conversions = (*conversions & ~RIG_STREAM_CONV_FORMAT)
+                           | RIG_STREAM_CONV_CODEC;
+        }
+
+        return ret;
+    }
+
     /* Format: native, or reachable within the family via conversion.
      * Codec formats (outside the family masks) must be native. */
     if (!(config->format & caps->formats))
@@ -1046,12 +1151,43 @@ static int resolve_stream_source(const struct rig_stream_config *config,
         return RIG_OK;    /* conv stays RIG_STREAM_CONV_NONE */
     }
 
-    /* Rate: native, or (resampler built) any rate up to the largest
+    /* Rate: native, or any rate up to the largest
      * native rate — audio and I/Q alike; I/Q upsampling beyond the
-     * hardware is impossible by this bound (sample rate = bandwidth). */
-    if (!caps_rate_native(caps, config->sample_rate))
+     * hardware is impossible by this bound (sample rate = bandwidth).
+     * The decimator needs a whole multiple of the request instead. */
+    if (config->iq_decimate)
+    {
+        int src_rate = caps_rate_multiple(caps, config->sample_rate);
+
+        if (src_rate <= 0)
+        {
+            rig_debug(RIG_DEBUG_ERR,
+                      "%s: no native rate is a multiple of %d to decimate\n",
+                      __func__, config->sample_rate);
+            return -RIG_EINVAL;
+        }
+
+        if (fabs(config->iq_shift) >= src_rate / 2.0)
+        {
+            rig_debug(RIG_DEBUG_ERR,
+                      "%s: iq_shift %.0f Hz is outside the %d Hz window\n",
+                      __func__, config->iq_shift, src_rate);
+            return -RIG_EINVAL;
+        }
+
+        if (src_rate != config->sample_rate)
+        {
+            backend_cfg->sample_rate = src_rate;
+            conv |= RIG_STREAM_CONV_RATE;
+        }
+
+        if (config->iq_shift != 0)
+        {
+            conv |= RIG_STREAM_CONV_SHIFT;
+        }
+    }
+    else if (!caps_rate_native(caps, config->sample_rate))
     {
-#ifdef HAVE_SAMPLERATE
         int src_rate = caps_rate_source(caps, config->sample_rate);
 
         if (src_rate <= 0)
@@ -1064,12 +1200,6 @@ static int resolve_stream_source(const struct rig_stream_config *config,
 
         backend_cfg->sample_rate = src_rate;
         conv |= RIG_STREAM_CONV_RATE;
-#else
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: sample rate %d not native and resampling is not "
-                  "built in\n", __func__, config->sample_rate);
-        return -RIG_EINVAL;
-#endif
     }
 
     /* Channels: a count in the native list passes through untouched. The
@@ -1264,15 +1394,22 @@ int HAMLIB_API rig_stream_open(RIG *rig,
         return -RIG_EINVAL;
     }
 
-    /* Allocate and initialize stream handle */
-    struct rig_stream *s = calloc(1, sizeof(*s));
+    /* Allocate and initialize stream handle, on a cache line as its ring
+     * requires (malloc only guarantees max_align_t) */
+    void *alloc = calloc(1, sizeof(struct rig_stream)
+                         + STREAM_RINGBUF_CACHE_LINE - 1);
 
-    if (!s)
+    if (!alloc)
     {
         pthread_mutex_unlock(&ss->stream_mutex);
         return -RIG_ENOMEM;
     }
 
+    struct rig_stream *s = (struct rig_stream *)(((uintptr_t)alloc
+                           + STREAM_RINGBUF_CACHE_LINE - 1)
+                           & ~(uintptr_t)(STREAM_RINGBUF_CACHE_LINE - 1));
+    s->alloc = alloc;
+
     s->type = config->type;
     /* Sized copy over a zeroed target: an older app's config may be smaller
      * than our struct (its unset trailing fields default to 0), and a newer
@@ -1328,6 +1465,10 @@ int HAMLIB_API rig_stream_open(RIG *rig,
                     || config->type == RIG_STREAM_TYPE_IQ_TX;
         int quality = stream_resample_quality(rig);
         int conv_ret;
+        /* An Opus request converts through PCM_F32, then the codec */
+        rig_stream_format_t app_fmt = (conversions & RIG_STREAM_CONV_CODEC)
+                                      ? RIG_STREAM_FORMAT_PCM_F32
+                                      : config->format;
 
         if (is_rx)
         {
@@ -1335,14 +1476,14 @@ int HAMLIB_API rig_stream_open(RIG *rig,
                                         backend_cfg.format,
                                         backend_cfg.sample_rate,
                                         backend_cfg.channels,
-                                        config->format,
+                                        app_fmt,
                                         config->sample_rate,
                                         config->channels, is_iq, quality);
         }
         else
         {
             conv_ret = stream_conv_init(&s->conv,
-                                        config->format,
+                                        app_fmt,
                                         config->sample_rate,
                                         config->channels,
                                         backend_cfg.format,
@@ -1350,12 +1491,33 @@ int HAMLIB_API rig_stream_open(RIG *rig,
                                         backend_cfg.channels, is_iq, quality);
         }
 
+        /* The decimator swaps in for the resampler and carries the shift;
+         * the window centre reported for the stream moves with it. */
+        if (conv_ret == 0 && config->iq_decimate)
+        {
+            conv_ret = stream_conv_use_decimator(s->conv, config->iq_shift,
+                                                 quality);
+            s->center_shift = config->iq_shift;
+        }
+
+        /* RX encodes one packet per frame_samples (20 ms by default) into
+         * the codec ring; TX decodes the client's packets into the PCM ring */
+        if (conv_ret == 0 && (conversions & RIG_STREAM_CONV_CODEC))
+        {
+            conv_ret = stream_conv_use_opus(s->conv, is_rx,
+                                            stream_opus_frame_samples(
+                                                config->sample_rate,
+                                                config->frame_samples),
+                                            STATE(rig)->stream_opus_bitrate,
+                                            (size_t)s->max_payload);
+        }
+
         if (conv_ret != 0)
         {
             rig_debug(RIG_DEBUG_ERR,
                       "%s: conversion pipeline init failed (0x%x)\n",
                       __func__, conversions);
-            free(s);
+            free(s->alloc);
             pthread_mutex_unlock(&ss->stream_mutex);
             return -RIG_ENOMEM;
         }
@@ -1397,7 +1559,7 @@ int HAMLIB_API rig_stream_open(RIG *rig,
     if (stream_ringbuf_init(&s->ringbuf, buf_size) != 0)
     {
         stream_conv_free(s->conv);
-        free(s);
+        free(s->alloc);
         pthread_mutex_unlock(&ss->stream_mutex);
         return -RIG_ENOMEM;
     }
@@ -1427,7 +1589,7 @@ int HAMLIB_API rig_stream_open(RIG *rig,
         stream_ringbuf_destroy(&s->ringbuf);
         stream_write_event_destroy(s);
         stream_conv_free(s->conv);
-        free(s);
+        free(s->alloc);
         return ret;
     }
 
@@ -1447,6 +1609,23 @@ static size_t conv_ring_sink(void *ctx, const void *buf, size_t len)
     return stream_ringbuf_write(&s->ringbuf, buf, len);
 }
 
+static ssize_t codec_produce(struct rig_stream *stream, const void *buf,
+                             size_t len, uint32_t duration_samples,
+                             int have_index, uint64_t start_index,
+                             int account_drop);
+
+/* One packet from the pipeline's encoder becomes one codec-frame record;
+ * a full ring drops it with the usual RX accounting */
+static size_t conv_codec_sink(void *ctx, const void *buf, size_t len)
+{
+    struct rig_stream *s = ctx;
+    ssize_t n = codec_produce(s, buf, len,
+                              (uint32_t)stream_conv_opus_frame(s->conv),
+                              0, 0, 1);
+
+    return n > 0 ? (size_t)n : 0;
+}
+
 size_t stream_backend_write(struct rig_stream *stream, const void *buf,
                             size_t bytes)
 {
@@ -1455,6 +1634,16 @@ size_t stream_backend_write(struct rig_stream *stream, const void *buf,
         return 0;
     }
 
+    /* A codec stream encoded here from the backend's PCM; otherwise the
+     * backend delivers whole frames itself */
+    if (stream->is_codec && stream->conv)
+    {
+        ssize_t n = stream_conv_process(stream->conv, buf, bytes,
+                                        conv_codec_sink, stream);
+
+        return n < 0 ? 0 : (size_t)n;
+    }
+
     if (stream->is_codec)
     {
         rig_debug(RIG_DEBUG_ERR,
@@ -1570,7 +1759,7 @@ static ssize_t codec_produce(struct rig_stream *stream, const void *buf,
          * would double count). The index advance below exposes the hole
          * to the consumer as a start-index jump. */
         stream->ringbuf.overrun_count++;
-        stream->pending_drop_flags |= RIG_STREAM_DROP_OVERRUN;
+        stream->account.pending_drop_flags |= RIG_STREAM_DROP_OVERRUN;
         stream->dropped_samples_overrun += duration_samples;
     }
 
@@ -1764,6 +1953,15 @@ int HAMLIB_API rig_stream_close(RIG *rig, rig_stream_t *stream)
 }
 
 
+/* Sample index of the frame holding ring byte index byte_index. Caller must
+ * hold stream->ringbuf.lock (for skipped_samples). */
+static uint64_t stream_sample_index_locked(struct rig_stream *stream,
+                                           uint64_t byte_index)
+{
+    return byte_index / (uint64_t)stream->frame_bytes + stream->skipped_samples;
+}
+
+
 /* ------------------------------------------------------------------ */
 /* rig_stream_read                                                     */
 /* ------------------------------------------------------------------ */
@@ -1799,7 +1997,7 @@ int HAMLIB_API rig_stream_read(RIG *rig,
 
     struct rig_stream_ringbuf *rb = &stream->ringbuf;
 
-    uint64_t first_index;
+    uint64_t first_index, first_byte;
     int ret;
 
     /* Paused: don't deliver data, leave ring buffer intact */
@@ -1910,8 +2108,12 @@ int HAMLIB_API rig_stream_read(RIG *rig,
         goto out;
     }
 
-    first_index = stream_first_readable_index_locked(stream);
-    *bytes_read = stream_ringbuf_consume_locked(rb, buffer, buffer_size);
+    /* The producer does not take the lock: the first index is where the
+     * copy actually started, which a concurrent overwrite can move. */
+    *bytes_read = stream_ringbuf_consume_at_locked(rb, buffer, buffer_size,
+                                                   &first_byte);
+    first_index = stream->frame_bytes > 0
+                  ? stream_sample_index_locked(stream, first_byte) : 0;
 
     /* Account for the consume in the same critical section as the consume
      * itself, so a concurrent stream_skip_samples() cannot land between them
@@ -2150,194 +2352,1028 @@ out:
 
 
 /* ------------------------------------------------------------------ */
-/* rig_stream_drain                                                    */
+/* Zero-copy acquire / release                                         */
 /* ------------------------------------------------------------------ */
 
-int HAMLIB_API rig_stream_drain(RIG *rig,
-                                rig_stream_t *stream,
-                                int timeout_ms)
+/* The zero-copy calls work on the ring itself: not through a backend hook,
+ * on codec records or through a TX conversion pipeline. */
+static int stream_zero_copy_check(RIG *rig, rig_stream_t *stream, int tx)
 {
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
-    if (!rig || !stream)
+    if ((tx ? rig->caps->stream_write != NULL : rig->caps->stream_read != NULL)
+            || stream->is_codec || stream->frame_bytes <= 0
+            || (tx && stream->conv))
     {
-        return -RIG_EINVAL;
+        return -RIG_ENIMPL;
     }
 
-    if (stream_guard_enter(rig, stream) != RIG_OK)
-    {
-        return -RIG_EINVAL;
-    }
+    return RIG_OK;
+}
 
-    int ret = RIG_OK;
 
-    /* Use backend hook if available */
-    if (rig->caps->stream_drain)
+/* The bounce frame for a frame straddling the end of an unmirrored ring */
+static unsigned char *stream_acquire_bounce(rig_stream_t *stream)
+{
+    if (!stream->acquire_bounce)
     {
-        ret = rig->caps->stream_drain(rig, stream, timeout_ms);
-        goto out;
+        stream->acquire_bounce = malloc(stream->frame_bytes);
     }
 
-    /* Poll until ring buffer is empty or timeout expires */
-    struct timespec start;
-    clock_gettime(CLOCK_MONOTONIC, &start);
-
-    while (stream_ringbuf_available(&stream->ringbuf) > 0)
-    {
-        usleep(1000);  /* 1ms poll interval */
+    return stream->acquire_bounce;
+}
 
-        struct timespec now;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000
-                          + (now.tv_nsec - start.tv_nsec) / 1000000;
 
-        if (elapsed_ms >= timeout_ms)
-        {
-            ret = -RIG_ETIMEOUT;
-            goto out;
-        }
+/* Zeros for a muted read region of up to len bytes.  The ring itself is
+ * left alone: broadcast readers and recorders read the same bytes later. */
+static unsigned char *stream_acquire_silence(rig_stream_t *stream, size_t len)
+{
+    if (stream->acquire_silence_bytes < len)
+    {
+        free(stream->acquire_silence);
+        stream->acquire_silence = calloc(1, len);
+        stream->acquire_silence_bytes = stream->acquire_silence ? len : 0;
     }
 
-out:
-    stream_guard_leave(rig, stream);
-    return ret;
+    return stream->acquire_silence;
 }
 
 
-/* ------------------------------------------------------------------ */
-/* rig_stream_get_hardware_time                                        */
-/* ------------------------------------------------------------------ */
-
-int HAMLIB_API rig_stream_get_hardware_time(RIG *rig, rig_stream_t *stream,
-        struct rig_stream_time_anchor *now)
+int HAMLIB_API rig_stream_read_acquire(RIG *rig,
+                                       rig_stream_t *stream,
+                                       const void **data,
+                                       size_t max_bytes,
+                                       size_t *bytes,
+                                       int timeout_ms,
+                                       struct rig_stream_read_info *info)
 {
-    if (!rig || !stream || !now)
+    rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
+
+    if (!rig || !stream || !data || !bytes)
     {
         return -RIG_EINVAL;
     }
 
-    /* Zero first so the reserved tail is cleared whether the backend or the
-     * host fallback fills the anchor. */
-    memset(now, 0, sizeof(*now));
+    *data = NULL;
+    *bytes = 0;
+
+    if (info)
+    {
+        memset(info, 0, sizeof(*info));
+    }
 
     if (stream_guard_enter(rig, stream) != RIG_OK)
     {
         return -RIG_EINVAL;
     }
 
-    int ret;
+    struct rig_stream_ringbuf *rb = &stream->ringbuf;
+    unsigned char *region;
+    uint64_t start;
+    size_t len;
+    int muted = stream->muted;
+    int ret = stream_zero_copy_check(rig, stream, 0);
 
-    if (rig->caps->stream_hardware_time)
+    if (ret != RIG_OK)
     {
-        ret = rig->caps->stream_hardware_time(rig, stream, now);
         goto out;
     }
 
-    /* Host fallback: CLOCK_REALTIME, not tied to the radio sample clock */
-    now->sample_index = rig_stream_get_samples_written(stream);
-    stream_time_now(&now->seconds, &now->picoseconds);
-    now->source = RIG_STREAM_TIME_SRC_HOST;
-    now->accuracy = RIG_STREAM_TIME_ACC_MS;
-    ret = RIG_OK;
-
-out:
-    stream_guard_leave(rig, stream);
-    return ret;
-}
-
-
-/* ------------------------------------------------------------------ */
-/* Loss accounting: producer index, gap marking, cause attribution     */
-/* ------------------------------------------------------------------ */
+    if (max_bytes < (size_t)stream->frame_bytes || stream->acquire_active)
+    {
+        ret = -RIG_EINVAL;
+        goto out;
+    }
 
-/* Caller must hold stream->ringbuf.lock. */
-uint64_t stream_first_readable_index_locked(struct rig_stream *stream)
-{
-    if (stream->frame_bytes <= 0)
+    if (!rb->mirrored && !stream_acquire_bounce(stream))
     {
-        return 0;
+        ret = -RIG_ENOMEM;
+        goto out;
     }
 
-    uint64_t consumed_bytes = stream->ringbuf.write_total
-                              - stream->ringbuf.count;
-    return consumed_bytes / (uint64_t)stream->frame_bytes
-           + stream->skipped_samples;
-}
+    if (muted && !stream_acquire_silence(stream, max_bytes < rb->capacity
+                                         ? max_bytes : rb->capacity))
+    {
+        ret = -RIG_ENOMEM;
+        goto out;
+    }
 
+    /* Paused: don't deliver data, leave ring buffer intact */
+    if (stream->paused)
+    {
+        ret = -RIG_ETIMEOUT;
+        goto out;
+    }
 
-void stream_skip_samples(struct rig_stream *stream, uint64_t dropped_samples,
-                         uint8_t drop_flag)
-{
-    /* Backends report losses in their own (native) sample domain; the ring
-     * accounting runs in the consumer domain, so scale under RX rate
-     * conversion (identity otherwise). */
-    dropped_samples = stream_scale_backend_samples(stream, dropped_samples);
+    pthread_mutex_lock(&rb->lock);
 
-    pthread_mutex_lock(&stream->ringbuf.lock);
+    if (rb->closing)
+    {
+        pthread_mutex_unlock(&rb->lock);
+        ret = -RIG_ENAVAIL;
+        goto out;
+    }
 
-    stream->pending_drop_flags |= drop_flag;
+    stream->blocked_waiters++;
 
-    switch (drop_flag)
+    if (stream_ringbuf_wait_data_locked(rb, timeout_ms) < 0)
     {
-    case RIG_STREAM_DROP_GAP:
-        stream->gap_count++;
+        int closing = rb->closing;
 
-        /* A codec stream's producer index accumulates in codec_pos; a
-         * radio-side gap advances it so the next frame's start index
-         * exposes the hole. */
-        if (stream->is_codec)
+        if (--stream->blocked_waiters == 0 && closing)
         {
-            stream->codec_pos += dropped_samples;
+            pthread_cond_signal(&stream->quiesced);
         }
 
+        pthread_mutex_unlock(&rb->lock);
+        ret = closing ? -RIG_ENAVAIL : -RIG_ETIMEOUT;
+        goto out;
+    }
 
-        if (dropped_samples == 0)
-        {
-            stream->gaps_unknown++;
-            stream->pending_drop_flags |= RIG_STREAM_DROP_UNSIZED;
-        }
-        else
-        {
-            stream->dropped_samples_gap += dropped_samples;
-        }
+    /* Whole frames only, so the next region starts on a frame too */
+    len = stream_ringbuf_read_region(rb, &region, &start);
+    len = len < max_bytes ? len : max_bytes;
+    len -= len % (size_t)stream->frame_bytes;
+    stream->acquire_bounced = 0;
 
-        break;
+    if (len == 0)
+    {
+        /* A frame straddles the end of an unmirrored ring: hand out a copy
+         * of it, consumed on release like the real thing. */
+        region = stream->acquire_bounce;
+        len = stream_ringbuf_peek_at_locked(rb, region, stream->frame_bytes,
+                                            &start);
+        stream->acquire_bounced = 1;
+    }
 
-    case RIG_STREAM_DROP_OVERRUN:
-        stream->remote_overruns++;
-        stream->dropped_samples_overrun += dropped_samples;
-        break;
+    /* The drops up to the region are reported now; the consumer position
+     * moves past it on release, by as much as the caller consumed. */
+    stream->acquired_first_index = stream_sample_index_locked(stream, start);
+    stream_consume_account_locked(stream, stream->acquired_first_index, 0,
+                                  info);
+    stream->acquire_active = 1;
+    stream->acquired = len;
+    stream->acquired_start = start;
+
+    pthread_mutex_unlock(&rb->lock);
+
+    /* Muted: silence instead of the region, which is consumed on release
+     * all the same */
+    if (muted)
+    {
+        region = stream->acquire_silence;
+    }
+
+    if (info)
+    {
+        stream_fill_read_time(stream, info);
+    }
+
+    pthread_mutex_lock(&rb->lock);
+
+    if (--stream->blocked_waiters == 0 && rb->closing)
+    {
+        pthread_cond_signal(&stream->quiesced);
+    }
+
+    pthread_mutex_unlock(&rb->lock);
+
+    *data = region;
+    *bytes = len;
+
+out:
+    stream_guard_leave(rig, stream);
+    return ret;
+}
+
+
+int HAMLIB_API rig_stream_read_release(RIG *rig,
+                                       rig_stream_t *stream,
+                                       size_t bytes)
+{
+    rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
+
+    if (!rig || !stream)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    struct rig_stream_ringbuf *rb = &stream->ringbuf;
+    int ret = RIG_OK;
+
+    pthread_mutex_lock(&rb->lock);
+
+    if (!stream->acquire_active || bytes > stream->acquired)
+    {
+        pthread_mutex_unlock(&rb->lock);
+        ret = -RIG_EINVAL;
+        goto out;
+    }
+
+    /* A copy in the bounce frame was intact when made */
+    if (stream_ringbuf_read_commit(rb, stream->acquired_start, bytes) < 0
+            && !stream->acquire_bounced)
+    {
+        ret = -RIG_EIO;
+    }
+
+    stream->account.next_expected = stream->acquired_first_index
+                            + bytes / (uint64_t)stream->frame_bytes;
+    stream->acquire_active = 0;
+
+    pthread_mutex_unlock(&rb->lock);
+
+out:
+    stream_guard_leave(rig, stream);
+    return ret;
+}
+
+
+int HAMLIB_API rig_stream_write_acquire(RIG *rig,
+                                        rig_stream_t *stream,
+                                        void **data,
+                                        size_t max_bytes,
+                                        size_t *bytes,
+                                        int timeout_ms)
+{
+    rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
+
+    if (!rig || !stream || !data || !bytes)
+    {
+        return -RIG_EINVAL;
+    }
+
+    *data = NULL;
+    *bytes = 0;
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    size_t frame_bytes = (size_t)stream->frame_bytes;
+    unsigned char *region;
+    size_t len, free_total;
+    struct timespec start;
+    int ret = stream_zero_copy_check(rig, stream, 1);
+
+    if (ret != RIG_OK)
+    {
+        goto out;
+    }
+
+    if (max_bytes < frame_bytes || stream->acquire_active)
+    {
+        ret = -RIG_EINVAL;
+        goto out;
+    }
+
+    if (!stream->ringbuf.mirrored && !stream_acquire_bounce(stream))
+    {
+        ret = -RIG_ENOMEM;
+        goto out;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* Unlike rig_stream_write() this never overwrites what the backend has
+     * yet to send: the caller is writing into the ring while it waits.
+     * With no room for a frame, poll up to the timeout. */
+    for (;;)
+    {
+        len = stream_ringbuf_write_region(&stream->ringbuf, &region,
+                                          &free_total);
+        len = len < max_bytes ? len : max_bytes;
+        len -= len % frame_bytes;
+
+        if (len > 0 || free_total >= frame_bytes)
+        {
+            break;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000
+                          + (now.tv_nsec - start.tv_nsec) / 1000000;
+
+        if (stream->ringbuf.closing)
+        {
+            ret = -RIG_ENAVAIL;
+            goto out;
+        }
+
+        if (timeout_ms >= 0 && elapsed_ms >= timeout_ms)
+        {
+            ret = -RIG_ETIMEOUT;
+            goto out;
+        }
+
+        usleep(1000);
+    }
+
+    stream->acquire_bounced = 0;
+
+    if (len == 0)
+    {
+        /* The free frame straddles the end of an unmirrored ring */
+        region = stream->acquire_bounce;
+        len = frame_bytes;
+        stream->acquire_bounced = 1;
+    }
+
+    stream->acquire_active = 1;
+    stream->acquired = len;
+    *data = region;
+    *bytes = len;
+
+out:
+    stream_guard_leave(rig, stream);
+    return ret;
+}
+
+
+int HAMLIB_API rig_stream_write_commit(RIG *rig,
+                                       rig_stream_t *stream,
+                                       size_t bytes,
+                                       const struct rig_stream_write_info *info)
+{
+    rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
+
+    if (!rig || !stream)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    int ret = RIG_OK;
+
+    if (!stream->acquire_active || bytes > stream->acquired)
+    {
+        ret = -RIG_EINVAL;
+        goto out;
+    }
+
+    stream->acquire_active = 0;
+
+    /* Muted: the samples were written but are not published */
+    if (stream->muted || bytes == 0)
+    {
+        goto out;
+    }
+
+    /* A burst target binds to the first sample of this commit */
+    if (info && (info->time_valid || info->flags))
+    {
+        ret = stream_bind_tx_target(stream, info);
+
+        if (ret != RIG_OK)
+        {
+            goto out;
+        }
+    }
+
+    if (stream->acquire_bounced)
+    {
+        /* Free space for it was there at acquire and only grows */
+        stream_ringbuf_write(&stream->ringbuf, stream->acquire_bounce, bytes);
+    }
+    else
+    {
+        stream_ringbuf_write_commit(&stream->ringbuf, bytes);
+    }
+
+out:
+    stream_guard_leave(rig, stream);
+    return ret;
+}
+
+
+/* ------------------------------------------------------------------ */
+/* rig_stream_drain                                                    */
+/* ------------------------------------------------------------------ */
+
+int HAMLIB_API rig_stream_drain(RIG *rig,
+                                rig_stream_t *stream,
+                                int timeout_ms)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!rig || !stream)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    int ret = RIG_OK;
+
+    /* Use backend hook if available */
+    if (rig->caps->stream_drain)
+    {
+        ret = rig->caps->stream_drain(rig, stream, timeout_ms);
+        goto out;
+    }
+
+    /* Poll until ring buffer is empty or timeout expires */
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (stream_ringbuf_available(&stream->ringbuf) > 0)
+    {
+        usleep(1000);  /* 1ms poll interval */
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000
+                          + (now.tv_nsec - start.tv_nsec) / 1000000;
+
+        if (elapsed_ms >= timeout_ms)
+        {
+            ret = -RIG_ETIMEOUT;
+            goto out;
+        }
+    }
+
+out:
+    stream_guard_leave(rig, stream);
+    return ret;
+}
+
+
+/* ------------------------------------------------------------------ */
+/* rig_stream_get_hardware_time                                        */
+/* ------------------------------------------------------------------ */
+
+int HAMLIB_API rig_stream_get_hardware_time(RIG *rig, rig_stream_t *stream,
+        struct rig_stream_time_anchor *now)
+{
+    if (!rig || !stream || !now)
+    {
+        return -RIG_EINVAL;
+    }
+
+    /* Zero first so the reserved tail is cleared whether the backend or the
+     * host fallback fills the anchor. */
+    memset(now, 0, sizeof(*now));
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    int ret;
+
+    if (rig->caps->stream_hardware_time)
+    {
+        ret = rig->caps->stream_hardware_time(rig, stream, now);
+        goto out;
+    }
+
+    /* Host fallback: CLOCK_REALTIME, not tied to the radio sample clock */
+    now->sample_index = rig_stream_get_samples_written(stream);
+    stream_time_now(&now->seconds, &now->picoseconds);
+    now->source = RIG_STREAM_TIME_SRC_HOST;
+    now->accuracy = RIG_STREAM_TIME_ACC_MS;
+    ret = RIG_OK;
+
+out:
+    stream_guard_leave(rig, stream);
+    return ret;
+}
+
+
+/* ------------------------------------------------------------------ */
+/* Loss accounting: producer index, gap marking, cause attribution     */
+/* ------------------------------------------------------------------ */
+
+/* Caller must hold stream->ringbuf.lock. */
+uint64_t stream_first_readable_index_locked(struct rig_stream *stream)
+{
+    if (stream->frame_bytes <= 0)
+    {
+        return 0;
+    }
+
+    return stream_sample_index_locked(stream,
+                                      stream_ringbuf_read_index(&stream->ringbuf));
+}
+
+
+static void stream_account_skip(struct stream_consumer_account *account,
+                                uint64_t dropped_samples, uint8_t flags)
+{
+    account->pending_drop_flags |= flags;
+    account->skip_samples_unread += dropped_samples;
+}
+
+
+void stream_skip_samples(struct rig_stream *stream, uint64_t dropped_samples,
+                         uint8_t drop_flag)
+{
+    /* Backends report losses in their own (native) sample domain; the ring
+     * accounting runs in the consumer domain, so scale under RX rate
+     * conversion (identity otherwise). */
+    dropped_samples = stream_scale_backend_samples(stream, dropped_samples);
+
+    uint8_t flags = drop_flag;
+
+    pthread_mutex_lock(&stream->ringbuf.lock);
+
+    switch (drop_flag)
+    {
+    case RIG_STREAM_DROP_GAP:
+        stream->gap_count++;
+
+        /* A codec stream's producer index accumulates in codec_pos; a
+         * radio-side gap advances it so the next frame's start index
+         * exposes the hole. */
+        if (stream->is_codec)
+        {
+            stream->codec_pos += dropped_samples;
+        }
+
+
+        if (dropped_samples == 0)
+        {
+            stream->gaps_unknown++;
+            flags |= RIG_STREAM_DROP_UNSIZED;
+        }
+        else
+        {
+            stream->dropped_samples_gap += dropped_samples;
+        }
+
+        break;
+
+    case RIG_STREAM_DROP_OVERRUN:
+        stream->remote_overruns++;
+        stream->dropped_samples_overrun += dropped_samples;
+        break;
 
     case RIG_STREAM_DROP_LINK:
         stream->link_loss++;
         stream->dropped_samples_link += dropped_samples;
         break;
 
-    default:
-        break;
+    default:
+        break;
+    }
+
+    stream->skipped_samples += dropped_samples;
+
+    /* Every reader sees the same hole on its next read */
+    stream_account_skip(&stream->account, dropped_samples, flags);
+
+    for (struct rig_stream_reader *r = stream->readers; r; r = r->next)
+    {
+        stream_account_skip(&r->account, dropped_samples, flags);
+    }
+
+    pthread_mutex_unlock(&stream->ringbuf.lock);
+}
+
+
+int HAMLIB_API rig_stream_get_stats(RIG *rig, rig_stream_t *stream,
+                                    struct rig_stream_stats *stats)
+{
+    struct udp_batch_stats link_io;
+
+    if (!rig || !stream || !stats)
+    {
+        return -RIG_EINVAL;
+    }
+
+    /* Zero the reserved tail (and any field not set below). */
+    memset(stats, 0, sizeof(*stats));
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&stream->ringbuf.lock);
+
+    /* overruns/underruns are LOCAL-ring only; remote losses are separate. */
+    stats->overruns = (uint32_t)stream->ringbuf.overrun_count;
+    stats->underruns = (uint32_t)stream->ringbuf.underrun_count;
+    stats->gaps = (uint32_t)stream->gap_count;
+    stats->gaps_unknown = stream->gaps_unknown;
+    stats->link_loss = stream->link_loss;
+    stats->tx_late = stream->tx_late;
+    stats->remote_overruns = stream->remote_overruns;
+    stats->remote_underruns = stream->remote_underruns;
+    stats->write_events_dropped = stream->write_events_dropped;
+    stats->dropped_samples_gap = stream->dropped_samples_gap;
+    stats->dropped_samples_overrun = stream->dropped_samples_overrun;
+    stats->dropped_samples_link = stream->dropped_samples_link;
+    stats->codec_frames = stream->codec_frames;
+
+    pthread_mutex_unlock(&stream->ringbuf.lock);
+
+    udp_batch_stats_get(&stream->link_io, &link_io);
+    stats->link_packets = link_io.packets;
+    stats->link_syscalls = link_io.syscalls;
+
+    stream_guard_leave(rig, stream);
+    return RIG_OK;
+}
+
+
+/* ------------------------------------------------------------------ */
+/* Broadcast readers                                                   */
+/* ------------------------------------------------------------------ */
+
+/* Ring bytes a converting reader takes through its pipeline per read */
+#define STREAM_READER_SCRATCH_BYTES 16384
+
+
+static void stream_reader_free(struct rig_stream_reader *reader)
+{
+    stream_conv_free(reader->conv);
+    free(reader->scratch);
+    free(reader);
+}
+
+
+/* Check config against what stream's ring can be converted to and set up
+ * the reader's format and pipeline. */
+static int stream_reader_setup(RIG *rig, struct rig_stream *stream,
+                               struct rig_stream_reader *reader,
+                               const struct rig_stream_config *config)
+{
+    int is_iq = stream_type_is_iq_type(stream->type);
+    rig_stream_format_t family = is_iq ? STREAM_IQ_FORMAT_MASK
+                                 : STREAM_PCM_FORMAT_MASK;
+    int channels = stream->config.channels;
+
+    reader->config = stream->config;
+    reader->frame_bytes = stream->frame_bytes;
+
+    if (!config)
+    {
+        return RIG_OK;
+    }
+
+    /* One rate: the sample indices the readers report are the ring's.
+     * Channels as stream_conv can map them: a subset, or mono to stereo. */
+    if (config->struct_size == 0
+            || (config->sample_rate != 0
+                && config->sample_rate != stream->config.sample_rate)
+            || !(config->format & family)
+            || config->channels <= 0
+            || (config->channels > channels
+                && !(!is_iq && channels == 1 && config->channels == 2)))
+    {
+        return -RIG_EINVAL;
+    }
+
+    reader->config.format = config->format;
+    reader->config.channels = config->channels;
+    reader->frame_bytes = stream_format_bytes_per_frame(config->format,
+                                                        config->channels);
+
+    if (config->format == stream->config.format && config->channels == channels)
+    {
+        return RIG_OK;
+    }
+
+    reader->scratch_size = STREAM_READER_SCRATCH_BYTES
+                           - STREAM_READER_SCRATCH_BYTES % stream->frame_bytes;
+
+    if (reader->scratch_size == 0)
+    {
+        reader->scratch_size = stream->frame_bytes;
+    }
+
+    reader->scratch = malloc(reader->scratch_size);
+
+    if (!reader->scratch)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    if (stream_conv_init(&reader->conv, stream->config.format,
+                         stream->config.sample_rate, channels,
+                         config->format, stream->config.sample_rate,
+                         config->channels, is_iq,
+                         stream_resample_quality(rig)) != 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+
+int HAMLIB_API rig_stream_reader_open(RIG *rig,
+                                      rig_stream_t *stream,
+                                      const struct rig_stream_config *config,
+                                      rig_stream_reader_t **reader)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!rig || !stream || !reader)
+    {
+        return -RIG_EINVAL;
+    }
+
+    *reader = NULL;
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    struct rig_stream_reader *r = NULL;
+    int ret;
+
+    if (stream->type != RIG_STREAM_TYPE_AUDIO_RX
+            && stream->type != RIG_STREAM_TYPE_IQ_RX)
+    {
+        ret = -RIG_EINVAL;
+        goto out;
+    }
+
+    /* A backend read hook bypasses the ring, and a codec ring holds
+     * records that one consumer dequeues whole. */
+    if (rig->caps->stream_read || stream->is_codec || stream->frame_bytes <= 0)
+    {
+        ret = -RIG_ENIMPL;
+        goto out;
+    }
+
+    r = calloc(1, sizeof(*r));
+
+    if (!r)
+    {
+        ret = -RIG_ENOMEM;
+        goto out;
     }
 
-    if (dropped_samples > 0)
+    r->stream = stream;
+    ret = stream_reader_setup(rig, stream, r, config);
+
+    if (ret != RIG_OK)
     {
-        stream->skipped_samples += dropped_samples;
-        stream->skip_samples_unread += dropped_samples;
+        stream_reader_free(r);
+        goto out;
     }
 
+    pthread_mutex_lock(&stream->ringbuf.lock);
+    stream_ringbuf_cursor_init(&stream->ringbuf, &r->cursor);
+    r->account.next_expected = stream_sample_index_locked(stream,
+                                                          r->cursor.read_total);
+    r->next = stream->readers;
+    stream->readers = r;
     pthread_mutex_unlock(&stream->ringbuf.lock);
+
+    *reader = r;
+
+out:
+    stream_guard_leave(rig, stream);
+    return ret;
 }
 
 
-int HAMLIB_API rig_stream_get_stats(RIG *rig, rig_stream_t *stream,
-                                    struct rig_stream_stats *stats)
+/* Converted output landing in the caller's buffer */
+struct stream_reader_out
 {
-    if (!rig || !stream || !stats)
+    unsigned char *buf;
+    size_t used;
+    size_t size;
+};
+
+
+static size_t stream_reader_sink(void *ctx, const void *buf, size_t len)
+{
+    struct stream_reader_out *out = ctx;
+
+    if (len > out->size - out->used)
+    {
+        len = out->size - out->used;
+    }
+
+    memcpy(out->buf + out->used, buf, len);
+    out->used += len;
+
+    return len;
+}
+
+
+/* Mark the reader slow once it is lag bytes behind past the first
+ * threshold, and no longer once it is back under the second. Caller holds
+ * ringbuf.lock. */
+static void stream_reader_track_lag_locked(struct rig_stream_reader *reader,
+                                           uint64_t lag)
+{
+    size_t capacity = reader->stream->ringbuf.capacity;
+
+    if (!reader->slow && lag > capacity / 8 * STREAM_READER_SLOW_LAG)
+    {
+        reader->slow = 1;
+        reader->slow_events++;
+        rig_debug(RIG_DEBUG_WARN, "%s: stream %d reader %p is falling behind "
+                  "(%llu of %lu bytes)\n", __func__, reader->stream->id,
+                  (void *)reader, (unsigned long long)lag,
+                  (unsigned long)capacity);
+    }
+    else if (reader->slow && lag < capacity / 8 * STREAM_READER_CAUGHT_UP)
+    {
+        reader->slow = 0;
+    }
+}
+
+
+int HAMLIB_API rig_stream_reader_read(RIG *rig,
+                                      rig_stream_reader_t *reader,
+                                      void *buffer,
+                                      size_t buffer_size,
+                                      size_t *bytes_read,
+                                      int timeout_ms,
+                                      struct rig_stream_read_info *info)
+{
+    rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
+
+    if (!rig || !reader || !buffer || !bytes_read)
+    {
+        return -RIG_EINVAL;
+    }
+
+    *bytes_read = 0;
+
+    if (info)
+    {
+        memset(info, 0, sizeof(*info));
+    }
+
+    struct rig_stream *stream = reader->stream;
+    size_t frames = buffer_size / (size_t)reader->frame_bytes;
+
+    if (frames == 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    struct rig_stream_ringbuf *rb = &stream->ringbuf;
+    unsigned char *dst = reader->conv ? reader->scratch : buffer;
+    size_t len = frames * (size_t)stream->frame_bytes;
+    uint64_t first_byte, overrun_part, lag;
+    size_t skip;
+    int ret;
+
+    if (stream->paused)
+    {
+        ret = -RIG_ETIMEOUT;
+        goto out;
+    }
+
+    if (reader->conv && len > reader->scratch_size)
+    {
+        len = reader->scratch_size;
+    }
+
+    pthread_mutex_lock(&rb->lock);
+
+    if (rb->closing)
+    {
+        pthread_mutex_unlock(&rb->lock);
+        ret = -RIG_ENAVAIL;
+        goto out;
+    }
+
+    stream->blocked_waiters++;
+    ret = stream_ringbuf_cursor_wait_locked(rb, &reader->cursor, timeout_ms);
+
+    if (ret < 0)
+    {
+        /* As for the ring's own underruns, silence before the producer's
+         * first write is not one. */
+        if (ret == -2 && __atomic_load_n(&rb->write_total, __ATOMIC_RELAXED) > 0)
+        {
+            reader->underruns++;
+        }
+
+        ret = ret == -1 ? -RIG_ENAVAIL : -RIG_ETIMEOUT;
+        goto unblock;
+    }
+
+    lag = stream_ringbuf_cursor_lag(rb, &reader->cursor);
+
+    if (lag > rb->capacity)
+    {
+        reader->overruns++;
+    }
+
+    stream_reader_track_lag_locked(reader, lag);
+
+    len = stream_ringbuf_cursor_read(rb, &reader->cursor, dst, len,
+                                     &first_byte);
+
+    /* A lapped reader resumes a ring behind the producer, which need not be
+     * a frame boundary: drop the partial frame, and leave a partial one at
+     * the end for the next read. */
+    skip = first_byte % (uint64_t)stream->frame_bytes;
+    skip = skip ? (size_t)stream->frame_bytes - skip : 0;
+
+    if (skip >= len)
+    {
+        len = 0;
+    }
+    else
+    {
+        memmove(dst, dst + skip, len - skip);
+        first_byte += skip;
+        len -= skip;
+        len -= len % (size_t)stream->frame_bytes;
+    }
+
+    reader->cursor.read_total = first_byte + len;
+
+    overrun_part = stream_account_consume(&reader->account,
+                                          stream_sample_index_locked(stream,
+                                                                     first_byte),
+                                          len / (uint64_t)stream->frame_bytes,
+                                          info);
+    reader->dropped_samples_overrun += overrun_part;
+    stream_reader_track_lag_locked(reader,
+                                   stream_ringbuf_cursor_lag(rb,
+                                                             &reader->cursor));
+
+    pthread_mutex_unlock(&rb->lock);
+
+    if (reader->conv)
+    {
+        struct stream_reader_out conv_out = { buffer, 0, buffer_size };
+
+        if (stream_conv_process(reader->conv, reader->scratch, len,
+                                stream_reader_sink, &conv_out) < 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: conversion failed\n", __func__);
+        }
+
+        *bytes_read = conv_out.used;
+    }
+    else
+    {
+        *bytes_read = len;
+    }
+
+    if (stream->muted)
+    {
+        memset(buffer, 0, *bytes_read);
+    }
+
+    if (info)
+    {
+        stream_fill_read_time(stream, info);
+    }
+
+    pthread_mutex_lock(&rb->lock);
+    ret = RIG_OK;
+
+unblock:
+
+    if (--stream->blocked_waiters == 0 && rb->closing)
+    {
+        pthread_cond_signal(&stream->quiesced);
+    }
+
+    pthread_mutex_unlock(&rb->lock);
+
+out:
+    stream_guard_leave(rig, stream);
+    return ret;
+}
+
+
+int HAMLIB_API rig_stream_reader_get_stats(RIG *rig,
+                                           rig_stream_reader_t *reader,
+                                           struct rig_stream_reader_stats *stats)
+{
+    if (!rig || !reader || !stats)
     {
         return -RIG_EINVAL;
     }
 
-    /* Zero the reserved tail (and any field not set below). */
     memset(stats, 0, sizeof(*stats));
 
+    struct rig_stream *stream = reader->stream;
+
     if (stream_guard_enter(rig, stream) != RIG_OK)
     {
         return -RIG_EINVAL;
@@ -2345,20 +3381,101 @@ int HAMLIB_API rig_stream_get_stats(RIG *rig, rig_stream_t *stream,
 
     pthread_mutex_lock(&stream->ringbuf.lock);
 
-    /* overruns/underruns are LOCAL-ring only; remote losses are separate. */
-    stats->overruns = (uint32_t)stream->ringbuf.overrun_count;
-    stats->underruns = (uint32_t)stream->ringbuf.underrun_count;
-    stats->gaps = (uint32_t)stream->gap_count;
-    stats->gaps_unknown = stream->gaps_unknown;
-    stats->link_loss = stream->link_loss;
-    stats->tx_late = stream->tx_late;
-    stats->remote_overruns = stream->remote_overruns;
-    stats->remote_underruns = stream->remote_underruns;
-    stats->write_events_dropped = stream->write_events_dropped;
-    stats->dropped_samples_gap = stream->dropped_samples_gap;
-    stats->dropped_samples_overrun = stream->dropped_samples_overrun;
-    stats->dropped_samples_link = stream->dropped_samples_link;
-    stats->codec_frames = stream->codec_frames;
+    uint64_t lag = stream_ringbuf_cursor_lag(&stream->ringbuf, &reader->cursor);
+
+    if (lag > stream->ringbuf.capacity)
+    {
+        lag = stream->ringbuf.capacity;
+    }
+
+    stats->overruns = reader->overruns;
+    stats->underruns = reader->underruns;
+    stats->slow_events = reader->slow_events;
+    stats->slow = reader->slow;
+    stats->lag_samples = lag / (uint64_t)stream->frame_bytes;
+    stats->dropped_samples_overrun = reader->dropped_samples_overrun;
+
+    pthread_mutex_unlock(&stream->ringbuf.lock);
+
+    stream_guard_leave(rig, stream);
+    return RIG_OK;
+}
+
+
+int HAMLIB_API rig_stream_reader_close(RIG *rig, rig_stream_reader_t *reader)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!rig || !reader)
+    {
+        return -RIG_EINVAL;
+    }
+
+    struct rig_stream *stream = reader->stream;
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&stream->ringbuf.lock);
+
+    for (struct rig_stream_reader **p = &stream->readers; *p; p = &(*p)->next)
+    {
+        if (*p == reader)
+        {
+            *p = reader->next;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&stream->ringbuf.lock);
+
+    stream_guard_leave(rig, stream);
+    stream_reader_free(reader);
+    return RIG_OK;
+}
+
+
+int stream_recorder_attach(RIG *rig, struct rig_stream_recorder *recorder)
+{
+    struct rig_stream *stream = recorder->stream;
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&stream->ringbuf.lock);
+    recorder->next = stream->recorders;
+    stream->recorders = recorder;
+    pthread_mutex_unlock(&stream->ringbuf.lock);
+
+    stream_guard_leave(rig, stream);
+    return RIG_OK;
+}
+
+
+int stream_recorder_detach(RIG *rig, struct rig_stream_recorder *recorder)
+{
+    struct rig_stream *stream = recorder->stream;
+
+    if (stream_guard_enter(rig, stream) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&stream->ringbuf.lock);
+
+    for (struct rig_stream_recorder **p = &stream->recorders; *p;
+            p = &(*p)->next)
+    {
+        if (*p == recorder)
+        {
+            *p = recorder->next;
+            break;
+        }
+    }
 
     pthread_mutex_unlock(&stream->ringbuf.lock);
 
@@ -2599,7 +3716,9 @@ uint64_t HAMLIB_API rig_stream_get_samples_written(const rig_stream_t *stream)
     }
 
     uint64_t written = s->frame_bytes > 0
-                       ? s->ringbuf.write_total / (uint64_t)s->frame_bytes
+                       ? __atomic_load_n(&s->ringbuf.write_total,
+                                         __ATOMIC_ACQUIRE)
+                         / (uint64_t)s->frame_bytes
                        : 0;
     written += s->skipped_samples;
 
@@ -2816,7 +3935,8 @@ static int cache_to_metadata(RIG *rig, rig_stream_t *stream,
         freq_t center = stream->center_freq;
         pthread_mutex_unlock(&stream->ringbuf.lock);
 
-        meta->center_freq = (center != 0) ? center : freq;
+        meta->center_freq = ((center != 0) ? center : freq)
+                            + stream->center_shift;
         meta->field_mask |= RIG_STREAM_META_CENTER_FREQ;
     }
 
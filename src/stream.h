@@ -33,6 +33,7 @@
 #include "stream_ringbuf.h"
 #include "stream_anchor.h"
 #include "stream_account.h"
+#include "udp_batch.h"
 
 /* HAMLIB_ATOMIC is defined in hamlib/rig.h */
 
@@ -69,6 +70,40 @@ struct rig_stream_tx_target
 };
 
 
+/* A further reader of an RX stream's ring (rig_stream_reader_open()): the
+ * producer's one write serves it alongside the stream's own consumer. It
+ * has its own cursor and loss accounting and, when it asked for another
+ * format or channel count, its own conversion pipeline from the ring's.
+ * Linked into rig_stream.readers; the list and the accounting fields are
+ * protected by the stream's ringbuf.lock, the rest belongs to the thread
+ * reading. */
+struct rig_stream_reader
+{
+    struct rig_stream *stream;
+    struct rig_stream_reader *next;
+    struct rig_stream_ringbuf_cursor cursor;
+    struct rig_stream_config config; /* What this reader gets */
+    int frame_bytes;                /* Bytes per frame in config's format */
+    struct stream_conv *conv;       /* Ring -> config, NULL when they match */
+    unsigned char *scratch;         /* Ring bytes on their way through conv */
+    size_t scratch_size;            /* Whole ring frames */
+
+    struct stream_consumer_account account;
+    int slow;                       /* 1 = behind by more than
+                                     * STREAM_READER_SLOW_LAG of the ring */
+    uint32_t slow_events;           /* Times slow went from 0 to 1 */
+    uint32_t overruns;              /* Reads that found the reader lapped */
+    uint32_t underruns;             /* Blocking reads that timed out empty */
+    uint64_t dropped_samples_overrun;
+};
+
+/* Slow-reader thresholds, in eighths of the ring: a reader is slow once
+ * its unread bytes pass the first and no longer once they drop below the
+ * second, so a reader hovering at the edge is not reported on every read. */
+#define STREAM_READER_SLOW_LAG  6
+#define STREAM_READER_CAUGHT_UP 2
+
+
 /* Full stream handle (opaque to applications via rig_stream_t). */
 struct rig_stream
 {
@@ -88,7 +123,9 @@ struct rig_stream
                                      * and the ring, NULL on a native stream.
                                      * The ring always holds the CONSUMER's
                                      * format: requested for RX, native for TX. */
-    struct rig_stream_ringbuf ringbuf;
+    struct rig_stream_ringbuf ringbuf;  /* Cache-line aligned, hence alloc */
+    void *alloc;                    /* What to free: the handle is placed
+                                     * on a cache line inside it */
     HAMLIB_ATOMIC int active;          /* 1 = running, 0 = closed */
     HAMLIB_ATOMIC int paused;          /* 1 = backend I/O stopped */
     HAMLIB_ATOMIC int muted;           /* 1 = TX writes discarded, RX reads
@@ -99,6 +136,9 @@ struct rig_stream
                                        panadapter-driven backends under
                                        ringbuf.lock. 0 = unset, frontend then
                                        reports the VFO frequency. */
+    freq_t center_shift;            /* Added to the reported center: the
+                                       iq_shift of a local decimator that
+                                       moved the window, 0 otherwise */
     struct rig_stream_metadata
         last_metadata;  /* Latest metadata: sent on a producing stream (change
                      * detection), or ingested from the wire on a netrigctl
@@ -128,9 +168,7 @@ struct rig_stream
     uint64_t caps_flags;            /* RIG_STREAM_CAP_* from the caps entry */
     int tx_horizon_ms;              /* Max timed-TX lead time (0 = none) */
     uint64_t skipped_samples;       /* Index holes inserted by skip/mark_gap */
-    uint64_t next_expected;         /* Consumer position for drop detection */
-    uint64_t skip_samples_unread;   /* Sized skips since the last consume */
-    uint8_t  pending_drop_flags;    /* RIG_STREAM_DROP_* since last consume */
+    struct stream_consumer_account account; /* The ring consumer's */
     uint32_t gaps_unknown;          /* Gap events with unknown size */
     uint32_t remote_overruns;       /* Overruns reported by a remote server */
     uint32_t remote_underruns;      /* Underruns reported by a remote server */
@@ -140,6 +178,9 @@ struct rig_stream
     uint64_t dropped_samples_gap;      /* Per-cause dropped-sample totals */
     uint64_t dropped_samples_overrun;
     uint64_t dropped_samples_link;
+    struct udp_batch_stats link_io; /* Network client: datagrams on the
+                                     * stream socket and the system calls
+                                     * they took (atomic, see udp_batch.h) */
 
     /* Time anchors (protected by ringbuf.lock) */
     struct rig_stream_time_anchor anchors[RIG_STREAM_ANCHOR_DEPTH];
@@ -169,6 +210,28 @@ struct rig_stream
     int blocked_waiters;            /* Threads inside a blocking read/wait call */
     pthread_cond_t quiesced;        /* Signalled when a blocked caller exits */
 
+    /* Zero-copy region handed out by rig_stream_read_acquire() or
+     * rig_stream_write_acquire(), owned by the one reader or writer until
+     * released or committed. */
+    int acquire_active;             /* 1 = a region is out */
+    size_t acquired;                /* Bytes in it */
+    uint64_t acquired_start;        /* Ring index of the first one */
+    uint64_t acquired_first_index;  /* Its sample index (RX accounting) */
+    unsigned char *acquire_bounce;  /* One frame straddling the end of an
+                                     * unmirrored ring; NULL until needed */
+    int acquire_bounced;            /* 1 = the region is acquire_bounce */
+    unsigned char *acquire_silence; /* Zeros handed out instead of the ring
+                                     * while muted; NULL until needed */
+    size_t acquire_silence_bytes;
+
+    /* Broadcast readers of an RX ring (protected by ringbuf.lock); freed
+     * with the stream. */
+    struct rig_stream_reader *readers;
+
+    /* Recorders of an RX stream (protected by ringbuf.lock), each on one of
+     * the readers; finished with the stream. */
+    struct rig_stream_recorder *recorders;
+
     /* In-flight public-API-call count, guarded by rig_stream_state.stream_mutex
      * (NOT ringbuf.lock, which close destroys). Each rig_stream_* call
      * increments this under stream_mutex after confirming the stream is still
@@ -299,6 +362,11 @@ void stream_skip_samples(struct rig_stream *stream, uint64_t dropped_samples,
 /* Producer index of the oldest readable byte; caller holds ringbuf.lock. */
 uint64_t stream_first_readable_index_locked(struct rig_stream *stream);
 
+/* Link a recorder into, or out of, the recorders of its stream, as long as
+ * the stream is still open. Return RIG_OK or -RIG_EINVAL. */
+int stream_recorder_attach(RIG *rig, struct rig_stream_recorder *recorder);
+int stream_recorder_detach(RIG *rig, struct rig_stream_recorder *recorder);
+
 /* Initialize / destroy the write-status event and close-rendezvous condvars
  * (clock matched to the ringbuf). rig_stream_open()/close() call these;
  * white-box tests that build a bare struct rig_stream (after stream_ringbuf_init) must
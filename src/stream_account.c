@@ -58,17 +58,16 @@ int rig_stream_mark_gap(struct rig_stream *stream, uint64_t dropped_samples)
 }
 
 
-void stream_consume_account_locked(struct rig_stream *stream,
-                                   uint64_t first_index,
-                                   uint64_t frames_read,
-                                   struct rig_stream_read_info *info)
+uint64_t stream_account_consume(struct stream_consumer_account *account,
+                                uint64_t first_index, uint64_t frames_read,
+                                struct rig_stream_read_info *info)
 {
-    uint64_t dropped = first_index > stream->next_expected
-                       ? first_index - stream->next_expected : 0;
+    uint64_t dropped = first_index > account->next_expected
+                       ? first_index - account->next_expected : 0;
 
     /* The portion of the hole not explained by announced skips is a
      * local ring-buffer overrun. */
-    uint64_t skipped_part = stream->skip_samples_unread;
+    uint64_t skipped_part = account->skip_samples_unread;
 
     if (skipped_part > dropped)
     {
@@ -76,23 +75,16 @@ void stream_consume_account_locked(struct rig_stream *stream,
     }
 
     uint64_t overrun_part = dropped - skipped_part;
-    uint8_t flags = stream->pending_drop_flags;
+    uint8_t flags = account->pending_drop_flags;
 
     if (overrun_part > 0)
     {
         flags |= RIG_STREAM_DROP_OVERRUN;
-
-        /* Codec streams: the producer already counted the dropped frames
-         * (drop-newest) — attribute the cause, but do not double count. */
-        if (!stream->is_codec)
-        {
-            stream->dropped_samples_overrun += overrun_part;
-        }
     }
 
-    stream->next_expected = first_index + frames_read;
-    stream->skip_samples_unread = 0;
-    stream->pending_drop_flags = 0;
+    account->next_expected = first_index + frames_read;
+    account->skip_samples_unread = 0;
+    account->pending_drop_flags = 0;
 
     if (info)
     {
@@ -102,6 +94,26 @@ void stream_consume_account_locked(struct rig_stream *stream,
                                 ? UINT32_MAX : (uint32_t)dropped;
         info->drop_flags = flags;
     }
+
+    return overrun_part;
+}
+
+
+void stream_consume_account_locked(struct rig_stream *stream,
+                                   uint64_t first_index,
+                                   uint64_t frames_read,
+                                   struct rig_stream_read_info *info)
+{
+    uint64_t overrun_part = stream_account_consume(&stream->account,
+                                                   first_index, frames_read,
+                                                   info);
+
+    /* Codec streams: the producer already counted the dropped frames
+     * (drop-newest) — attribute the cause, but do not double count. */
+    if (!stream->is_codec)
+    {
+        stream->dropped_samples_overrun += overrun_part;
+    }
 }
 
 
@@ -33,6 +33,17 @@ struct rig_stream_read_info;
 struct rig_stream_tx_target;
 
 
+/* Where one reader of a stream stands in the loss accounting: the stream's
+ * own consumer, or one of its broadcast readers (rig_stream_reader_open()).
+ * Protected by the stream's ringbuf.lock. */
+struct stream_consumer_account
+{
+    uint64_t next_expected;         /* Consumer position for drop detection */
+    uint64_t skip_samples_unread;   /* Sized skips since the last consume */
+    uint8_t  pending_drop_flags;    /* RIG_STREAM_DROP_* since last consume */
+};
+
+
 /* --- Loss accounting (backend- and client-facing) --- */
 
 /* Backend-facing: report a radio/network-side gap of dropped_samples samples
@@ -53,6 +64,13 @@ void stream_consume_account(struct rig_stream *stream, uint64_t first_index,
                             uint64_t frames_read,
                             struct rig_stream_read_info *info);
 
+/* The attribution step of stream_consume_account_locked() for any one
+ * reader: moves account past the read, fills info likewise and returns the
+ * part of the hole that was a local ring overrun. */
+uint64_t stream_account_consume(struct stream_consumer_account *account,
+                                uint64_t first_index, uint64_t frames_read,
+                                struct rig_stream_read_info *info);
+
 /* As stream_consume_account(), but the caller already holds ringbuf.lock.
  * Lets a reader snapshot the consume position and account for it atomically,
  * so a concurrent stream_skip_samples() cannot land in the gap between the two
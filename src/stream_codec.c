@@ -28,149 +28,200 @@
 
 #include "stream_codec.h"
 #include "stream_convert.h"
+#include "stream_convert_simd.h"
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_OPUS
+#include <opus.h>
+#endif
+
 
 /* ------------------------------------------------------------------ */
 /* G.711 mu-law / A-law (ITU-T), clean-room from the published spec.   */
 /* Both pivot on host-order 16-bit linear, matching stream_convert's   */
-/* S16LE handling.                                                     */
+/* S16LE handling.  These are the scalar STREAM_CONVERT_*LAW* kernels; */
+/* stream_convert_simd.c has vector encoders giving the same bytes.    */
 /* ------------------------------------------------------------------ */
 
 #define G711_BIAS 0x84   /* 16-bit-scale add-in bias for mu-law */
 #define G711_CLIP 32635
 
-/* First segment-end value table search: index of the first entry the
- * value does not exceed, or size if it exceeds all of them. */
-static int g711_segment(int value, const int *seg_end, int size)
+/* Decoding is a lookup: the linear value of every code */
+static const int16_t mulaw_to_s16[256] =
 {
-    int i;
+    -32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+    -23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+    -15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+    -11900, -11388, -10876, -10364, -9852, -9340, -8828, -8316,
+    -7932, -7676, -7420, -7164, -6908, -6652, -6396, -6140,
+    -5884, -5628, -5372, -5116, -4860, -4604, -4348, -4092,
+    -3900, -3772, -3644, -3516, -3388, -3260, -3132, -3004,
+    -2876, -2748, -2620, -2492, -2364, -2236, -2108, -1980,
+    -1884, -1820, -1756, -1692, -1628, -1564, -1500, -1436,
+    -1372, -1308, -1244, -1180, -1116, -1052, -988, -924,
+    -876, -844, -812, -780, -748, -716, -684, -652,
+    -620, -588, -556, -524, -492, -460, -428, -396,
+    -372, -356, -340, -324, -308, -292, -276, -260,
+    -244, -228, -212, -196, -180, -164, -148, -132,
+    -120, -112, -104, -96, -88, -80, -72, -64,
+    -56, -48, -40, -32, -24, -16, -8, 0,
+    32124, 31100, 30076, 29052, 28028, 27004, 25980, 24956,
+    23932, 22908, 21884, 20860, 19836, 18812, 17788, 16764,
+    15996, 15484, 14972, 14460, 13948, 13436, 12924, 12412,
+    11900, 11388, 10876, 10364, 9852, 9340, 8828, 8316,
+    7932, 7676, 7420, 7164, 6908, 6652, 6396, 6140,
+    5884, 5628, 5372, 5116, 4860, 4604, 4348, 4092,
+    3900, 3772, 3644, 3516, 3388, 3260, 3132, 3004,
+    2876, 2748, 2620, 2492, 2364, 2236, 2108, 1980,
+    1884, 1820, 1756, 1692, 1628, 1564, 1500, 1436,
+    1372, 1308, 1244, 1180, 1116, 1052, 988, 924,
+    876, 844, 812, 780, 748, 716, 684, 652,
+    620, 588, 556, 524, 492, 460, 428, 396,
+    372, 356, 340, 324, 308, 292, 276, 260,
+    244, 228, 212, 196, 180, 164, 148, 132,
+    120, 112, 104, 96, 88, 80, 72, 64,
+    56, 48, 40, 32, 24, 16, 8, 0
+};
 
-    for (i = 0; i < size; i++)
+static const int16_t alaw_to_s16[256] =
+{
+    -5504, -5248, -6016, -5760, -4480, -4224, -4992, -4736,
+    -7552, -7296, -8064, -7808, -6528, -6272, -7040, -6784,
+    -2752, -2624, -3008, -2880, -2240, -2112, -2496, -2368,
+    -3776, -3648, -4032, -3904, -3264, -3136, -3520, -3392,
+    -22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+    -30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+    -11008, -10496, -12032, -11520, -8960, -8448, -9984, -9472,
+    -15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+    -344, -328, -376, -360, -280, -264, -312, -296,
+    -472, -456, -504, -488, -408, -392, -440, -424,
+    -88, -72, -120, -104, -24, -8, -56, -40,
+    -216, -200, -248, -232, -152, -136, -184, -168,
+    -1376, -1312, -1504, -1440, -1120, -1056, -1248, -1184,
+    -1888, -1824, -2016, -1952, -1632, -1568, -1760, -1696,
+    -688, -656, -752, -720, -560, -528, -624, -592,
+    -944, -912, -1008, -976, -816, -784, -880, -848,
+    5504, 5248, 6016, 5760, 4480, 4224, 4992, 4736,
+    7552, 7296, 8064, 7808, 6528, 6272, 7040, 6784,
+    2752, 2624, 3008, 2880, 2240, 2112, 2496, 2368,
+    3776, 3648, 4032, 3904, 3264, 3136, 3520, 3392,
+    22016, 20992, 24064, 23040, 17920, 16896, 19968, 18944,
+    30208, 29184, 32256, 31232, 26112, 25088, 28160, 27136,
+    11008, 10496, 12032, 11520, 8960, 8448, 9984, 9472,
+    15104, 14592, 16128, 15616, 13056, 12544, 14080, 13568,
+    344, 328, 376, 360, 280, 264, 312, 296,
+    472, 456, 504, 488, 408, 392, 440, 424,
+    88, 72, 120, 104, 24, 8, 56, 40,
+    216, 200, 248, 232, 152, 136, 184, 168,
+    1376, 1312, 1504, 1440, 1120, 1056, 1248, 1184,
+    1888, 1824, 2016, 1952, 1632, 1568, 1760, 1696,
+    688, 656, 752, 720, 560, 528, 624, 592,
+    944, 912, 1008, 976, 816, 784, 880, 848
+};
+
+/* Position of the highest set bit of v, which must not be 0 */
+static int g711_top_bit(unsigned int v)
+{
+#ifdef __GNUC__
+    return 31 - __builtin_clz(v);
+#else
+    int bit = 0;
+
+    while (v >>= 1)
     {
-        if (value <= seg_end[i])
-        {
-            return i;
-        }
+        bit++;
     }
 
-    return size;
+    return bit;
+#endif
 }
 
-static int16_t mulaw_decode_sample(uint8_t code)
+/* The segment is how far the top bit of the biased magnitude sits above
+ * bit 7 (the bias puts it at 7 or more), and the 4 bits below the top bit
+ * are the step within it */
+static uint8_t mulaw_encode_sample(int pcm)
 {
-    code = (uint8_t)~code;
+    int mask = pcm < 0 ? 0x7F : 0xFF;
+    int value = pcm < 0 ? -pcm : pcm;
 
-    int t = ((code & 0x0F) << 3) + G711_BIAS;
-    t <<= (code & 0x70) >> 4;
+    if (value > G711_CLIP - G711_BIAS)
+    {
+        value = G711_CLIP - G711_BIAS;
+    }
 
-    return (int16_t)((code & 0x80) ? (G711_BIAS - t) : (t - G711_BIAS));
+    value += G711_BIAS;
+
+    int seg = g711_top_bit((unsigned int)value) - 7;
+
+    return (uint8_t)(((seg << 4) | ((value >> (seg + 3)) & 0x0F)) ^ mask);
 }
 
-static uint8_t mulaw_encode_sample(int16_t pcm)
+/* A-law codes a 13-bit magnitude.  Below 32 it is segment 0, which has the
+ * same step as segment 1; above, the segment follows the top bit. */
+static uint8_t alaw_encode_sample(int pcm)
 {
-    static const int seg_end[8] =
-    {
-        0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF, 0x3FFF, 0x7FFF
-    };
-
-    int value = pcm;
-    int mask;
+    int value = pcm >> 3;
+    int mask = value >= 0 ? 0xD5 : 0x55;
 
     if (value < 0)
     {
-        value = G711_BIAS - value;
-        mask = 0x7F;
-    }
-    else
-    {
-        value = value + G711_BIAS;
-        mask = 0xFF;
-    }
-
-    if (value > G711_CLIP)
-    {
-        value = G711_CLIP;
+        value = ~value;     /* -value - 1 */
     }
 
-    int seg = g711_segment(value, seg_end, 8);
+    int seg = value < 32 ? 0 : g711_top_bit((unsigned int)value) - 4;
+    int shift = seg < 2 ? 1 : seg;
 
-    if (seg >= 8)
-    {
-        return (uint8_t)(0x7F ^ mask);
-    }
-
-    uint8_t uval = (uint8_t)((seg << 4) | ((value >> (seg + 3)) & 0x0F));
-    return (uint8_t)(uval ^ mask);
+    return (uint8_t)(((seg << 4) | ((value >> shift) & 0x0F)) ^ mask);
 }
 
-static int16_t alaw_decode_sample(uint8_t code)
+void stream_codec_mulaw_to_s16(const void *src, void *dst, size_t n)
 {
-    code ^= 0x55;
-
-    int t = (code & 0x0F) << 4;
-    int seg = (code & 0x70) >> 4;
+    const uint8_t *s = src;
+    int16_t *d = dst;
+    size_t i;
 
-    switch (seg)
+    for (i = 0; i < n; i++)
     {
-    case 0:
-        t += 8;
-        break;
-
-    case 1:
-        t += 0x108;
-        break;
-
-    default:
-        t += 0x108;
-        t <<= seg - 1;
-        break;
+        d[i] = mulaw_to_s16[s[i]];
     }
-
-    return (int16_t)((code & 0x80) ? t : -t);
 }
 
-static uint8_t alaw_encode_sample(int16_t pcm)
+void stream_codec_alaw_to_s16(const void *src, void *dst, size_t n)
 {
-    static const int seg_end[8] =
-    {
-        0x1F, 0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF
-    };
-
-    int value = pcm >> 3;   /* A-law operates on a 13-bit magnitude */
-    int mask;
+    const uint8_t *s = src;
+    int16_t *d = dst;
+    size_t i;
 
-    if (value >= 0)
-    {
-        mask = 0xD5;
-    }
-    else
+    for (i = 0; i < n; i++)
     {
-        mask = 0x55;
-        value = -value - 1;
+        d[i] = alaw_to_s16[s[i]];
     }
+}
 
-    int seg = g711_segment(value, seg_end, 8);
+void stream_codec_s16_to_mulaw(const void *src, void *dst, size_t n)
+{
+    const int16_t *s = src;
+    uint8_t *d = dst;
+    size_t i;
 
-    if (seg >= 8)
+    for (i = 0; i < n; i++)
     {
-        return (uint8_t)(0x7F ^ mask);
+        d[i] = mulaw_encode_sample(s[i]);
     }
+}
 
-    uint8_t aval = (uint8_t)(seg << 4);
+void stream_codec_s16_to_alaw(const void *src, void *dst, size_t n)
+{
+    const int16_t *s = src;
+    uint8_t *d = dst;
+    size_t i;
 
-    if (seg < 2)
+    for (i = 0; i < n; i++)
     {
-        aval |= (value >> 1) & 0x0F;
+        d[i] = alaw_encode_sample(s[i]);
     }
-    else
-    {
-        aval |= (value >> seg) & 0x0F;
-    }
-
-    return (uint8_t)(aval ^ mask);
 }
 
 
@@ -232,74 +283,52 @@ static int16_t ima_clamp_sample(int sample)
     return (int16_t)sample;
 }
 
-/* Decode one 4-bit code, advancing the predictor and step index. */
-static int16_t ima_decode_nibble(int *predictor, int *index, int nibble)
+/* Decode one 4-bit code, advancing the predictor and step index.  The
+ * code bits are close to random, so the difference is assembled with masks
+ * instead of branches that would mispredict half the time. */
+static inline int16_t ima_decode_nibble(int *predictor, int *index, int nibble)
 {
     int step = ima_step_table[*index];
-    int diff = step >> 3;
+    int diff = (step >> 3)
+               + ((step >> 2) & -(nibble & 1))
+               + ((step >> 1) & -((nibble >> 1) & 1))
+               + (step & -((nibble >> 2) & 1));
+    int neg = -((nibble >> 3) & 1);
 
-    if (nibble & 1)
-    {
-        diff += step >> 2;
-    }
-
-    if (nibble & 2)
-    {
-        diff += step >> 1;
-    }
-
-    if (nibble & 4)
-    {
-        diff += step;
-    }
-
-    if (nibble & 8)
-    {
-        diff = -diff;
-    }
-
-    *predictor = ima_clamp_sample(*predictor + diff);
+    *predictor = ima_clamp_sample(*predictor + ((diff ^ neg) - neg));
     *index = ima_clamp_index(*index + ima_index_table[nibble]);
     return (int16_t) * predictor;
 }
 
-/* Encode one sample to a 4-bit code, advancing the predictor and index. */
-static int ima_encode_sample(int *predictor, int *index, int16_t sample)
+/* Encode one sample to a 4-bit code, advancing the predictor and index.
+ * Each code bit is a comparison turned into a mask, as in decoding. */
+static inline int ima_encode_sample(int *predictor, int *index, int16_t sample)
 {
     int step = ima_step_table[*index];
     int diff = sample - *predictor;
-    int nibble = 0;
+    int sign = diff < 0 ? 8 : 0;
     int vpdiff = step >> 3;
+    int bit, nibble;
 
-    if (diff < 0)
-    {
-        nibble = 8;
-        diff = -diff;
-    }
+    diff = diff < 0 ? -diff : diff;
 
-    if (diff >= step)
-    {
-        nibble |= 4;
-        diff -= step;
-        vpdiff += step;
-    }
+    bit = diff >= step;
+    nibble = bit << 2;
+    diff -= step & -bit;
+    vpdiff += step & -bit;
 
-    if (diff >= (step >> 1))
-    {
-        nibble |= 2;
-        diff -= step >> 1;
-        vpdiff += step >> 1;
-    }
+    bit = diff >= (step >> 1);
+    nibble |= bit << 1;
+    diff -= (step >> 1) & -bit;
+    vpdiff += (step >> 1) & -bit;
 
-    if (diff >= (step >> 2))
-    {
-        nibble |= 1;
-        vpdiff += step >> 2;
-    }
+    bit = diff >= (step >> 2);
+    nibble |= bit;
+    vpdiff += (step >> 2) & -bit;
 
-    *predictor = ima_clamp_sample(*predictor + ((nibble & 8) ? -vpdiff : vpdiff));
-    *index = ima_clamp_index(*index + ima_index_table[nibble & 0x0F]);
-    return nibble & 0x0F;
+    *predictor = ima_clamp_sample(*predictor + (sign ? -vpdiff : vpdiff));
+    *index = ima_clamp_index(*index + ima_index_table[nibble]);
+    return nibble | sign;
 }
 
 
@@ -381,7 +410,7 @@ static long adpcm_decode_block(struct rig_audio_codec_state *st,
 static long adpcm_encode_block(struct rig_audio_codec_state *st,
                                size_t samples, uint8_t *dst, size_t dst_cap)
 {
-    int predictor, index, hold = 0, have = 0;
+    int predictor, index;
     size_t need, out, i;
 
     if (samples == 0)
@@ -405,25 +434,19 @@ static long adpcm_encode_block(struct rig_audio_codec_state *st,
     dst[3] = 0;
     out = 4;
 
-    for (i = 1; i < samples; i++)
+    for (i = 1; i + 1 < samples; i += 2)
     {
-        int nib = ima_encode_sample(&predictor, &index, st->scratch[i]);
+        int lo = ima_encode_sample(&predictor, &index, st->scratch[i]);
+        int hi = ima_encode_sample(&predictor, &index, st->scratch[i + 1]);
 
-        if (!have)
-        {
-            hold = nib;
-            have = 1;
-        }
-        else
-        {
-            dst[out++] = (uint8_t)(hold | (nib << 4));
-            have = 0;
-        }
+        dst[out++] = (uint8_t)(lo | (hi << 4));
     }
 
-    if (have)
+    if (i < samples)
     {
-        dst[out++] = (uint8_t)hold;   /* trailing nibble, high nibble padded */
+        /* trailing nibble, high nibble padded */
+        dst[out++] = (uint8_t)ima_encode_sample(&predictor, &index,
+                                                st->scratch[i]);
     }
 
     st->adpcm_index = index;   /* carry the step index into the next block */
@@ -549,19 +572,13 @@ static long decode_to_scratch(struct rig_audio_codec_state *st,
         break;
 
     case RIG_AUDIO_CODEC_MULAW:
-        for (size_t i = 0; i < samples; i++)
-        {
-            st->scratch[i] = mulaw_decode_sample(in[i]);
-        }
-
+        stream_convert_active_kernels()->op[STREAM_CONVERT_MULAW_TO_S16](
+            in, st->scratch, samples);
         break;
 
     case RIG_AUDIO_CODEC_ALAW:
-        for (size_t i = 0; i < samples; i++)
-        {
-            st->scratch[i] = alaw_decode_sample(in[i]);
-        }
-
+        stream_convert_active_kernels()->op[STREAM_CONVERT_ALAW_TO_S16](
+            in, st->scratch, samples);
         break;
 
     default:
@@ -600,19 +617,13 @@ static long encode_from_scratch(struct rig_audio_codec_state *st,
         break;
 
     case RIG_AUDIO_CODEC_MULAW:
-        for (size_t i = 0; i < samples; i++)
-        {
-            out[i] = mulaw_encode_sample(st->scratch[i]);
-        }
-
+        stream_convert_active_kernels()->op[STREAM_CONVERT_S16_TO_MULAW](
+            st->scratch, out, samples);
         break;
 
     case RIG_AUDIO_CODEC_ALAW:
-        for (size_t i = 0; i < samples; i++)
-        {
-            out[i] = alaw_encode_sample(st->scratch[i]);
-        }
-
+        stream_convert_active_kernels()->op[STREAM_CONVERT_S16_TO_ALAW](
+            st->scratch, out, samples);
         break;
 
     default:
@@ -776,3 +787,208 @@ size_t rig_audio_codec_max_encoded_bytes(struct rig_audio_codec_state *st,
     size_t samples = pcm_bytes / (size_t)rig_stream_format_sample_size(pcm_format);
     return samples * (size_t)unit;
 }
+
+
+/* ------------------------------------------------------------------ */
+/* Opus stream format, through libopus when the build has it.          */
+/* ------------------------------------------------------------------ */
+
+struct stream_opus
+{
+    int encode;
+    int channels;
+#ifdef HAVE_OPUS
+    OpusEncoder *enc;
+    OpusDecoder *dec;
+#endif
+};
+
+int stream_opus_available(void)
+{
+#ifdef HAVE_OPUS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int stream_opus_rate_ok(int rate, int channels)
+{
+    if (channels < 1 || channels > 2)
+    {
+        return 0;
+    }
+
+    return rate == 8000 || rate == 12000 || rate == 16000 || rate == 24000
+           || rate == 48000;
+}
+
+int stream_opus_frame_samples(int rate, int frame_samples)
+{
+    // Multiples of 2.5 ms
+    static const int units[] = { 1, 2, 4, 8, 16, 24 };
+    size_t i;
+
+    for (i = 0; i < sizeof(units) / sizeof(units[0]); i++)
+    {
+        if (frame_samples == rate / 400 * units[i])
+        {
+            return frame_samples;
+        }
+    }
+
+    return rate / 50;
+}
+
+struct stream_opus *stream_opus_open(int encode, int rate, int channels,
+                                     int bitrate)
+{
+#ifdef HAVE_OPUS
+    struct stream_opus *o;
+    int err = OPUS_OK;
+
+    if (!stream_opus_rate_ok(rate, channels))
+    {
+        return NULL;
+    }
+
+    o = calloc(1, sizeof(*o));
+
+    if (o == NULL)
+    {
+        return NULL;
+    }
+
+    o->encode = encode;
+    o->channels = channels;
+
+    if (encode)
+    {
+        // Radio audio carries data modes as well as voice, so code for fidelity
+        o->enc = opus_encoder_create(rate, channels, OPUS_APPLICATION_AUDIO, &err);
+
+        if (o->enc != NULL && err == OPUS_OK && bitrate > 0)
+        {
+            err = opus_encoder_ctl(o->enc, OPUS_SET_BITRATE(bitrate));
+        }
+    }
+    else
+    {
+        o->dec = opus_decoder_create(rate, channels, &err);
+    }
+
+    if (err != OPUS_OK || (o->enc == NULL && o->dec == NULL))
+    {
+        stream_opus_close(o);
+        return NULL;
+    }
+
+    return o;
+#else
+    (void)encode;
+    (void)rate;
+    (void)channels;
+    (void)bitrate;
+    return NULL;
+#endif
+}
+
+void stream_opus_reset(struct stream_opus *o)
+{
+#ifdef HAVE_OPUS
+
+    if (o == NULL)
+    {
+        return;
+    }
+
+    if (o->enc != NULL)
+    {
+        opus_encoder_ctl(o->enc, OPUS_RESET_STATE);
+    }
+
+    if (o->dec != NULL)
+    {
+        opus_decoder_ctl(o->dec, OPUS_RESET_STATE);
+    }
+
+#else
+    (void)o;
+#endif
+}
+
+void stream_opus_close(struct stream_opus *o)
+{
+    if (o == NULL)
+    {
+        return;
+    }
+
+#ifdef HAVE_OPUS
+
+    if (o->enc != NULL)
+    {
+        opus_encoder_destroy(o->enc);
+    }
+
+    if (o->dec != NULL)
+    {
+        opus_decoder_destroy(o->dec);
+    }
+
+#endif
+    free(o);
+}
+
+int stream_opus_encode(struct stream_opus *o, const float *pcm,
+                       int frame_samples, unsigned char *dst, size_t dst_cap)
+{
+#ifdef HAVE_OPUS
+    opus_int32 n;
+
+    if (o == NULL || o->enc == NULL || pcm == NULL || dst == NULL
+            || dst_cap == 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (dst_cap > STREAM_OPUS_MAX_PACKET)
+    {
+        dst_cap = STREAM_OPUS_MAX_PACKET;
+    }
+
+    n = opus_encode_float(o->enc, pcm, frame_samples, dst, (opus_int32)dst_cap);
+    return n < 0 ? -RIG_EINTERNAL : (int)n;
+#else
+    (void)o;
+    (void)pcm;
+    (void)frame_samples;
+    (void)dst;
+    (void)dst_cap;
+    return -RIG_ENIMPL;
+#endif
+}
+
+int stream_opus_decode(struct stream_opus *o, const unsigned char *pkt,
+                       size_t len, float *pcm, int cap_frames)
+{
+#ifdef HAVE_OPUS
+    int n;
+
+    if (o == NULL || o->dec == NULL || pkt == NULL || len == 0 || pcm == NULL
+            || len > STREAM_OPUS_MAX_PACKET)
+    {
+        return -RIG_EINVAL;
+    }
+
+    n = opus_decode_float(o->dec, pkt, (opus_int32)len, pcm, cap_frames, 0);
+    return n < 0 ? -RIG_EPROTO : n;
+#else
+    (void)o;
+    (void)pkt;
+    (void)len;
+    (void)pcm;
+    (void)cap_frames;
+    return -RIG_ENIMPL;
+#endif
+}
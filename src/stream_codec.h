@@ -20,7 +20,8 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 /* Device audio codec conversion for the Hamlib streaming subsystem. */
-/* Converts between device-link codecs (mu-law, A-law, ADPCM) and PCM. */
+/* Converts between device-link codecs (mu-law, A-law, ADPCM) and PCM, */
+/* and between PCM and the Opus stream format. */
 
 #ifndef HAMLIB_STREAM_CODEC_H
 #define HAMLIB_STREAM_CODEC_H
@@ -100,4 +101,54 @@ size_t rig_audio_codec_max_encoded_bytes(struct rig_audio_codec_state *st,
         size_t pcm_bytes,
         rig_stream_format_t pcm_format);
 
+/* Opus (RIG_STREAM_FORMAT_OPUS). Unlike the device codecs above, Opus is a
+ * stream format: it travels on the application-facing wire. When a backend
+ * carries PCM, the conversion pipeline (stream_conv_use_opus()) encodes RX
+ * audio and decodes TX packets with these calls. They need libopus at build
+ * time (HAVE_OPUS); without it stream_opus_available() is 0 and
+ * stream_opus_open() fails. PCM here is interleaved float. */
+
+/* Largest packet the encoder writes (libopus' recommended bound for one
+ * packet of up to 120 ms) */
+#define STREAM_OPUS_MAX_PACKET 4000
+
+/* Longest packet the decoder accepts, in frames: 120 ms at 48 kHz */
+#define STREAM_OPUS_MAX_FRAMES 5760
+
+struct stream_opus;
+
+/* 1 when this build can encode and decode Opus */
+int stream_opus_available(void);
+
+/* 1 when Opus codes this rate and channel count: 8, 12, 16, 24 or 48 kHz,
+ * mono or stereo */
+int stream_opus_rate_ok(int rate, int channels);
+
+/* The encoder frame in samples per channel: frame_samples when it is an
+ * Opus frame length at rate (2.5, 5, 10, 20, 40 or 60 ms), else 20 ms */
+int stream_opus_frame_samples(int rate, int frame_samples);
+
+/* An encoder (encode = 1) or decoder for rate and channels.  bitrate is the
+ * encoder's target in bits/s, 0 = the codec's own choice.  Returns NULL on
+ * a rate Opus does not code, out of memory, or a build without libopus. */
+struct stream_opus *stream_opus_open(int encode, int rate, int channels,
+                                     int bitrate);
+
+/* Back to the open-time state, as after a gap in the stream */
+void stream_opus_reset(struct stream_opus *o);
+
+/* Free an encoder or decoder. NULL is accepted. */
+void stream_opus_close(struct stream_opus *o);
+
+/* Encode frame_samples frames of pcm, a stream_opus_frame_samples() length,
+ * into one packet of at most dst_cap bytes at dst.  Returns the packet
+ * length, or a negative rig_errcode. */
+int stream_opus_encode(struct stream_opus *o, const float *pcm,
+                       int frame_samples, unsigned char *dst, size_t dst_cap);
+
+/* Decode one packet into pcm, which holds cap_frames frames.  Returns the
+ * frames decoded, or a negative rig_errcode on a corrupt packet. */
+int stream_opus_decode(struct stream_opus *o, const unsigned char *pkt,
+                       size_t len, float *pcm, int cap_frames);
+
 #endif /* HAMLIB_STREAM_CODEC_H */
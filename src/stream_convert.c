@@ -20,7 +20,8 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 /* Sample format conversion for the Hamlib streaming subsystem. */
-/* Fast path: direct integer converters; fallback: float-intermediate path. */
+/* Direct converters for every pair in a family, vectorized where the CPU
+ * allows (stream_convert_simd.c). */
 /* Converters operate on samples in host byte order. The wire payload is
  * little-endian, so a little-endian host needs no byte swap and the in-memory
  * layout matches the wire directly. A little-endian host is required, enforced
@@ -30,7 +31,11 @@
 #include "hamlib/config.h"
 #endif
 
+#include "stream_codec.h"
 #include "stream_convert.h"
+#include "stream_convert_simd.h"
+#include "stream_decimate.h"
+#include "stream_resample.h"
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -44,9 +49,6 @@
 #error "Hamlib streaming requires a little-endian host"
 #endif
 
-/* Float scratch-buffer size (samples) for the float-intermediate fallback. */
-#define STREAM_CONVERT_FLOAT_CHUNK 4096
-
 
 /* ------------------------------------------------------------------ */
 /* Format classification helpers                                       */
@@ -96,26 +98,28 @@ int rig_stream_format_sample_size(rig_stream_format_t format)
 }
 
 
-/* Scale a float sample by a symmetric power-of-two factor, round to
- * nearest and clamp. The symmetric factor (the same 2^n used by the
+/* Scale a float sample by a symmetric power-of-two factor, clamp and
+ * round to nearest. The symmetric factor (the same 2^n used by the
  * integer -> float direction) plus round-to-nearest makes
  * integer -> float -> integer round-trips value-exact, which the
- * conversion-pipeline tests rely on. */
+ * conversion-pipeline tests rely on. Clamping first keeps lrintf() in
+ * range for any input, and is the order the vector kernels work in:
+ * infinities clamp to the matching end, NaN to lo. */
 static inline long scale_round_clamp(float v, float scale, long lo, long hi)
 {
-    long r = lrintf(v * scale);
+    float x = v * scale;
 
-    if (r < lo)
+    if (!(x >= (float)lo))
     {
         return lo;
     }
 
-    if (r > hi)
+    if (x > (float)hi)
     {
         return hi;
     }
 
-    return r;
+    return lrintf(x);
 }
 
 
@@ -171,79 +175,6 @@ static void convert_s16_to_u8(const void *src, void *dst, size_t n)
     }
 }
 
-/* CU8 -> CS8: subtract 128 per component */
-static void convert_cu8_to_cs8(const void *src, void *dst, size_t n)
-{
-    const uint8_t *s = src;
-    int8_t *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = (int8_t)((int)s[i] - 128);
-    }
-}
-
-/* CS8 -> CU8: add 128 per component */
-static void convert_cs8_to_cu8(const void *src, void *dst, size_t n)
-{
-    const int8_t *s = src;
-    uint8_t *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = (uint8_t)((int)s[i] + 128);
-    }
-}
-
-/* CU8 -> CS16: subtract 128, shift left 8 per component */
-static void convert_cu8_to_cs16(const void *src, void *dst, size_t n)
-{
-    const uint8_t *s = src;
-    int16_t *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = (int16_t)((int)s[i] - 128) << 8;
-    }
-}
-
-/* CS8 -> CS16: sign-extend and shift left 8 per component */
-static void convert_cs8_to_cs16(const void *src, void *dst, size_t n)
-{
-    const int8_t *s = src;
-    int16_t *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = (int16_t)s[i] << 8;
-    }
-}
-
-/* CS16 -> CS8: arithmetic shift right 8 per component */
-static void convert_cs16_to_cs8(const void *src, void *dst, size_t n)
-{
-    const int16_t *s = src;
-    int8_t *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = (int8_t)(s[i] >> 8);
-    }
-}
-
-/* CS16 -> CU8: shift right 8, add 128 per component */
-static void convert_cs16_to_cu8(const void *src, void *dst, size_t n)
-{
-    const int16_t *s = src;
-    uint8_t *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = (uint8_t)((s[i] >> 8) + 128);
-    }
-}
-
-
 /* S8 -> U8: add 128 offset */
 static void convert_s8_to_u8(const void *src, void *dst, size_t n)
 {
@@ -321,66 +252,6 @@ static void convert_u8_to_f32(const void *src, void *dst, size_t n)
     }
 }
 
-/* CS16 -> CF32: same as S16->F32 but for I/Q components */
-static void convert_cs16_to_cf32(const void *src, void *dst, size_t n)
-{
-    convert_s16_to_f32(src, dst, 2 * n);
-}
-
-/* CF32 -> CS16 */
-static void convert_cf32_to_cs16(const void *src, void *dst, size_t n)
-{
-    convert_f32_to_s16(src, dst, 2 * n);
-}
-
-/* CU8 -> CF32: subtract 128 offset, scale to [-1, ~1] per component */
-static void convert_cu8_to_cf32(const void *src, void *dst, size_t n)
-{
-    const uint8_t *s = src;
-    float *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = ((float)s[i] - 128.0f) / 128.0f;
-    }
-}
-
-/* CS8 -> CF32 */
-static void convert_cs8_to_cf32(const void *src, void *dst, size_t n)
-{
-    const int8_t *s = src;
-    float *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = (float)s[i] / 128.0f;
-    }
-}
-
-/* CF32 -> CU8 */
-static void convert_cf32_to_cu8(const void *src, void *dst, size_t n)
-{
-    const float *s = src;
-    uint8_t *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = (uint8_t)(scale_round_clamp(s[i], 128.0f, -128, 127) + 128);
-    }
-}
-
-/* CF32 -> CS8 */
-static void convert_cf32_to_cs8(const void *src, void *dst, size_t n)
-{
-    const float *s = src;
-    int8_t *d = dst;
-
-    for (size_t i = 0; i < 2 * n; i++)
-    {
-        d[i] = (int8_t)scale_round_clamp(s[i], 128.0f, -128, 127);
-    }
-}
-
 /* F32 -> S8 with clamping */
 static void convert_f32_to_s8(const void *src, void *dst, size_t n)
 {
@@ -436,126 +307,143 @@ static int format_index(rig_stream_format_t fmt)
 
 #define NUM_FORMATS 8
 
-/* Converter function: takes src, dst, sample_count (not counting channels). */
-typedef void (*convert_fn)(const void *src, void *dst, size_t n);
-
-/* Direct converter table. NULL entries use float fallback. */
-static const convert_fn direct_table[NUM_FORMATS][NUM_FORMATS] =
+/* Element operation behind each direct conversion; STREAM_CONVERT_NONE
+ * across families. I/Q pairs run through their audio counterparts as two
+ * elements each, so every same-family pair converts in one pass, with no
+ * float intermediate between integer formats. */
+static const unsigned char convert_ops[NUM_FORMATS][NUM_FORMATS] =
 {
     /* From S8 (index 0) */
     [0] = {
-        [1] = convert_s8_to_u8,                     /* S8 -> U8 */
-        [2] = convert_s8_to_s16,                    /* S8 -> S16 */
-        [3] = convert_s8_to_f32,                    /* S8 -> F32 */
+        [1] = STREAM_CONVERT_S8_TO_U8,              /* S8 -> U8 */
+        [2] = STREAM_CONVERT_S8_TO_S16,             /* S8 -> S16 */
+        [3] = STREAM_CONVERT_S8_TO_F32,             /* S8 -> F32 */
     },
     /* From U8 (index 1) */
     [1] = {
-        [0] = convert_u8_to_s8,                     /* U8 -> S8 */
-        [2] = convert_u8_to_s16,                    /* U8 -> S16 */
-        [3] = convert_u8_to_f32,                    /* U8 -> F32 */
+        [0] = STREAM_CONVERT_U8_TO_S8,              /* U8 -> S8 */
+        [2] = STREAM_CONVERT_U8_TO_S16,             /* U8 -> S16 */
+        [3] = STREAM_CONVERT_U8_TO_F32,             /* U8 -> F32 */
     },
     /* From S16 (index 2) */
     [2] = {
-        [0] = convert_s16_to_s8,                    /* S16 -> S8 */
-        [1] = convert_s16_to_u8,                    /* S16 -> U8 */
-        [3] = convert_s16_to_f32,                   /* S16 -> F32 */
+        [0] = STREAM_CONVERT_S16_TO_S8,             /* S16 -> S8 */
+        [1] = STREAM_CONVERT_S16_TO_U8,             /* S16 -> U8 */
+        [3] = STREAM_CONVERT_S16_TO_F32,            /* S16 -> F32 */
     },
     /* From F32 (index 3) */
     [3] = {
-        [0] = convert_f32_to_s8,                    /* F32 -> S8 */
-        [1] = convert_f32_to_u8,                    /* F32 -> U8 */
-        [2] = convert_f32_to_s16,                   /* F32 -> S16 */
+        [0] = STREAM_CONVERT_F32_TO_S8,             /* F32 -> S8 */
+        [1] = STREAM_CONVERT_F32_TO_U8,             /* F32 -> U8 */
+        [2] = STREAM_CONVERT_F32_TO_S16,            /* F32 -> S16 */
     },
     /* From CS8 (index 4) */
     [4] = {
-        [5] = convert_cs8_to_cu8,                   /* CS8 -> CU8 */
-        [6] = convert_cs8_to_cs16,                  /* CS8 -> CS16 */
-        [7] = convert_cs8_to_cf32,                  /* CS8 -> CF32 */
+        [5] = STREAM_CONVERT_S8_TO_U8,              /* CS8 -> CU8 */
+        [6] = STREAM_CONVERT_S8_TO_S16,             /* CS8 -> CS16 */
+        [7] = STREAM_CONVERT_S8_TO_F32,             /* CS8 -> CF32 */
     },
     /* From CU8 (index 5) */
     [5] = {
-        [4] = convert_cu8_to_cs8,                   /* CU8 -> CS8 */
-        [6] = convert_cu8_to_cs16,                  /* CU8 -> CS16 */
-        [7] = convert_cu8_to_cf32,                  /* CU8 -> CF32 */
+        [4] = STREAM_CONVERT_U8_TO_S8,              /* CU8 -> CS8 */
+        [6] = STREAM_CONVERT_U8_TO_S16,             /* CU8 -> CS16 */
+        [7] = STREAM_CONVERT_U8_TO_F32,             /* CU8 -> CF32 */
     },
     /* From CS16 (index 6) */
     [6] = {
-        [4] = convert_cs16_to_cs8,                  /* CS16 -> CS8 */
-        [5] = convert_cs16_to_cu8,                  /* CS16 -> CU8 */
-        [7] = convert_cs16_to_cf32,                 /* CS16 -> CF32 */
+        [4] = STREAM_CONVERT_S16_TO_S8,             /* CS16 -> CS8 */
+        [5] = STREAM_CONVERT_S16_TO_U8,             /* CS16 -> CU8 */
+        [7] = STREAM_CONVERT_S16_TO_F32,            /* CS16 -> CF32 */
     },
     /* From CF32 (index 7) */
     [7] = {
-        [4] = convert_cf32_to_cs8,                  /* CF32 -> CS8 */
-        [5] = convert_cf32_to_cu8,                  /* CF32 -> CU8 */
-        [6] = convert_cf32_to_cs16,                 /* CF32 -> CS16 */
+        [4] = STREAM_CONVERT_F32_TO_S8,             /* CF32 -> CS8 */
+        [5] = STREAM_CONVERT_F32_TO_U8,             /* CF32 -> CU8 */
+        [6] = STREAM_CONVERT_F32_TO_S16,            /* CF32 -> CS16 */
     },
 };
 
 
-/* Two-hop fallback: src -> float intermediate -> dst.
- * Audio uses F32 (index 3), I/Q uses CF32 (index 7). */
-static int convert_via_float(const void *src, rig_stream_format_t src_fmt,
-                             void *dst, rig_stream_format_t dst_fmt,
-                             size_t sample_count, int channels)
+static const struct stream_convert_kernels scalar_kernels =
 {
-    int si = format_index(src_fmt);
-    int di = format_index(dst_fmt);
-
-    if (si < 0 || di < 0)
-    {
-        return -1;
+    "scalar",
+    {
+        [STREAM_CONVERT_S8_TO_U8] = convert_s8_to_u8,
+        [STREAM_CONVERT_U8_TO_S8] = convert_u8_to_s8,
+        [STREAM_CONVERT_S8_TO_S16] = convert_s8_to_s16,
+        [STREAM_CONVERT_U8_TO_S16] = convert_u8_to_s16,
+        [STREAM_CONVERT_S16_TO_S8] = convert_s16_to_s8,
+        [STREAM_CONVERT_S16_TO_U8] = convert_s16_to_u8,
+        [STREAM_CONVERT_S8_TO_F32] = convert_s8_to_f32,
+        [STREAM_CONVERT_U8_TO_F32] = convert_u8_to_f32,
+        [STREAM_CONVERT_S16_TO_F32] = convert_s16_to_f32,
+        [STREAM_CONVERT_F32_TO_S8] = convert_f32_to_s8,
+        [STREAM_CONVERT_F32_TO_U8] = convert_f32_to_u8,
+        [STREAM_CONVERT_F32_TO_S16] = convert_f32_to_s16,
+        [STREAM_CONVERT_MULAW_TO_S16] = stream_codec_mulaw_to_s16,
+        [STREAM_CONVERT_ALAW_TO_S16] = stream_codec_alaw_to_s16,
+        [STREAM_CONVERT_S16_TO_MULAW] = stream_codec_s16_to_mulaw,
+        [STREAM_CONVERT_S16_TO_ALAW] = stream_codec_s16_to_alaw,
     }
+};
 
-    /* Pick float intermediate based on format family */
-    int float_idx;
+/* Set in use, chosen on first conversion; racing first callers pick the
+ * same one */
+static const struct stream_convert_kernels *active_kernels;
 
-    if (is_iq_format(src_fmt))
-    {
-        float_idx = 7;   /* CF32 */
-    }
-    else
-    {
-        float_idx = 3;   /* F32 */
-    }
 
-    convert_fn to_float = direct_table[si][float_idx];
-    convert_fn from_float = direct_table[float_idx][di];
+const struct stream_convert_kernels *stream_convert_scalar_kernels(void)
+{
+    return &scalar_kernels;
+}
 
-    if (!to_float || !from_float)
+
+const struct stream_convert_kernels *stream_convert_active_kernels(void)
+{
+    const struct stream_convert_kernels *k =
+        __atomic_load_n(&active_kernels, __ATOMIC_ACQUIRE);
+
+    if (!k)
     {
-        return -1;
+        stream_convert_use_kernels(NULL);
+        k = __atomic_load_n(&active_kernels, __ATOMIC_ACQUIRE);
     }
 
-    /* Process in chunks using a stack buffer to avoid heap allocation. */
-    size_t total = sample_count * channels;
+    return k;
+}
 
-    /* I/Q samples produce 2 floats each; audio samples produce 1 */
-    int iq_mult = is_iq_format(src_fmt) ? 2 : 1;
-    size_t chunk_samples = STREAM_CONVERT_FLOAT_CHUNK / iq_mult;
 
-    int src_bps = rig_stream_format_sample_size(src_fmt);
-    int dst_bps = rig_stream_format_sample_size(dst_fmt);
+int stream_convert_use_kernels(const char *name)
+{
+    const struct stream_convert_kernels *sets[8];
+    const struct stream_convert_kernels *k = &scalar_kernels;
+    int count = stream_convert_simd_kernels(sets, 8);
 
-    if (src_bps <= 0 || dst_bps <= 0)
+    if (name == NULL)
     {
-        return -1;
+        if (count > 0)
+        {
+            k = sets[count - 1];
+        }
     }
+    else if (strcmp(name, scalar_kernels.name) != 0)
+    {
+        int i;
 
-    float tmp[STREAM_CONVERT_FLOAT_CHUNK];
-    const unsigned char *sp = (const unsigned char *)src;
-    unsigned char *dp = (unsigned char *)dst;
+        for (i = 0; i < count && strcmp(name, sets[i]->name) != 0; i++)
+        {
+        }
 
-    while (total > 0)
-    {
-        size_t batch = (total < chunk_samples) ? total : chunk_samples;
-        to_float(sp, tmp, batch);
-        from_float(tmp, dp, batch);
-        sp += batch * src_bps;
-        dp += batch * dst_bps;
-        total -= batch;
+        if (i == count)
+        {
+            return -1;
+        }
+
+        k = sets[i];
     }
 
+    __atomic_store_n(&active_kernels, k, __ATOMIC_RELEASE);
+
     return 0;
 }
 
@@ -612,18 +500,17 @@ int rig_stream_convert(const void *src, rig_stream_format_t src_format,
         return -1;
     }
 
-    /* Check direct converter */
-    convert_fn fn = direct_table[si][di];
+    int op = convert_ops[si][di];
 
-    if (fn)
+    if (op == STREAM_CONVERT_NONE)
     {
-        fn(src, dst, sample_count * channels);
-        return 0;
+        return -1;
     }
 
-    /* Fallback: two-hop via float intermediate */
-    return convert_via_float(src, src_format, dst, dst_format,
-                             sample_count, channels);
+    size_t n = sample_count * channels * (is_iq_format(src_format) ? 2 : 1);
+
+    stream_convert_active_kernels()->op[op](src, dst, n);
+    return 0;
 }
 
 
@@ -731,72 +618,69 @@ int rig_stream_convert_channels(const void *src, int src_channels,
 
 
 /* ------------------------------------------------------------------ */
-/* rig_stream_resample — sample rate conversion (requires libsamplerate) */
+/* rig_stream_resample — one-shot sample rate conversion               */
 /* ------------------------------------------------------------------ */
 
-#ifdef HAVE_SAMPLERATE
-#include <samplerate.h>
-
-/* Map Hamlib quality constants to libsamplerate converter types. */
-static int resample_converter_type(int quality)
-{
-    switch (quality)
-    {
-    case RIG_RESAMPLE_BEST:   return SRC_SINC_BEST_QUALITY;
-
-    case RIG_RESAMPLE_MEDIUM: return SRC_SINC_MEDIUM_QUALITY;
-
-    case RIG_RESAMPLE_FAST:   return SRC_SINC_FASTEST;
-
-    default:                  return SRC_SINC_FASTEST;
-    }
-}
-
 int rig_stream_resample(const float *src, int src_rate,
                         float *dst, int dst_rate,
                         size_t src_samples, size_t *dst_samples,
                         int channels, int quality)
 {
-    double ratio = (double)dst_rate / (double)src_rate;
-    SRC_DATA data;
+    struct stream_resampler *rs;
+    size_t want, made, used, pad;
+    float *silence;
 
-    data.data_in = (float *)(uintptr_t)src;  /* cast for libsamplerate < 0.2.0 */
-    data.input_frames = (long)src_samples;
-    data.data_out = dst;
-    data.output_frames = (long)(*dst_samples);
-    data.src_ratio = ratio;
-    data.end_of_input = 0;
+    if (!src || !dst || !dst_samples || src_rate <= 0 || dst_rate <= 0
+            || channels <= 0)
+    {
+        return -1;
+    }
 
-    int err = src_simple(&data, resample_converter_type(quality), channels);
+    if (src_rate == dst_rate)
+    {
+        made = src_samples < *dst_samples ? src_samples : *dst_samples;
+        memcpy(dst, src, made * channels * sizeof(float));
+        *dst_samples = made;
+        return 0;
+    }
 
-    if (err)
+    if (stream_resampler_init(&rs, src_rate, dst_rate, channels, quality) != 0)
     {
         return -1;
     }
 
-    *dst_samples = (size_t)data.output_frames_gen;
-    return 0;
-}
+    /* Line the output up with the input and pad the end with the filter
+     * delay's worth of silence, so output frame k is input time
+     * k * src_rate / dst_rate and every input frame reaches the output. */
+    stream_resampler_skip_delay(rs);
+    pad = stream_resampler_delay(rs);
+    silence = calloc(pad * channels, sizeof(float));
+
+    if (!silence)
+    {
+        stream_resampler_free(rs);
+        return -1;
+    }
 
-#else /* !HAVE_SAMPLERATE */
+    want = stream_resampler_max_output(rs, src_samples + pad);
 
-int rig_stream_resample(const float *src, int src_rate,
-                        float *dst, int dst_rate,
-                        size_t src_samples, size_t *dst_samples,
-                        int channels, int quality)
-{
-    (void)src;
-    (void)src_rate;
-    (void)dst;
-    (void)dst_rate;
-    (void)src_samples;
-    (void)dst_samples;
-    (void)channels;
-    (void)quality;
-    return -1;  /* libsamplerate not available */
-}
+    if (want > *dst_samples)
+    {
+        want = *dst_samples;
+    }
+
+    used = src_samples;
+    made = stream_resampler_process(rs, src, &used, dst, want);
+    used = pad;
+    made += stream_resampler_process(rs, silence, &used,
+                                     dst + made * channels, want - made);
 
-#endif /* HAVE_SAMPLERATE */
+    free(silence);
+    stream_resampler_free(rs);
+
+    *dst_samples = made;
+    return 0;
+}
 
 
 /* ------------------------------------------------------------------ */
@@ -820,9 +704,15 @@ struct stream_conv
     unsigned char *buf_a;           /* ping-pong scratch */
     unsigned char *buf_b;
     size_t buf_bytes;
-#ifdef HAVE_SAMPLERATE
-    SRC_STATE *src_state;           /* stateful resampler, NULL if no rate conv */
-#endif
+    struct stream_resampler *rs;    /* NULL without rate conversion */
+    struct stream_decimator *dec;   /* I/Q decimator instead of rs, or NULL */
+    struct stream_opus *opus;       /* Opus codec on the float side, or NULL */
+    int opus_encode;                /* 1 = encode the output, 0 = decode input */
+    int opus_frame;                 /* Encoder frames per packet */
+    int opus_have;                  /* Encoder frames waiting in opus_pcm */
+    float *opus_pcm;                /* Encoder frame, or one decoded packet */
+    unsigned char *opus_packet;     /* Encoder output */
+    size_t opus_max_packet;
 };
 
 /* Select the first dst_ch of src_ch interleaved per-frame elements
@@ -888,15 +778,6 @@ int stream_conv_init(struct stream_conv **out,
         return -1;  /* compressed/unknown formats are not convertible */
     }
 
-#ifndef HAVE_SAMPLERATE
-
-    if (src_rate != dst_rate)
-    {
-        return -1;  /* rate conversion requires libsamplerate */
-    }
-
-#endif
-
     struct stream_conv *c = calloc(1, sizeof(*c));
 
     if (!c)
@@ -954,28 +835,21 @@ int stream_conv_init(struct stream_conv **out,
         return -1;
     }
 
-#ifdef HAVE_SAMPLERATE
-
     if (src_rate != dst_rate)
     {
         /* Interleaved I/Q resamples as 2 float channels per I/Q channel:
          * I and Q pass through identical filters, preserving the complex
          * signal. */
         int rs_channels = is_iq ? 2 * dst_ch : dst_ch;
-        int err = 0;
-
-        c->src_state = src_new(resample_converter_type(quality),
-                               rs_channels, &err);
 
-        if (!c->src_state)
+        if (stream_resampler_init(&c->rs, src_rate, dst_rate, rs_channels,
+                                  quality) != 0)
         {
             stream_conv_free(c);
             return -1;
         }
     }
 
-#endif
-
     *out = c;
     return 0;
 }
@@ -987,17 +861,150 @@ void stream_conv_free(struct stream_conv *c)
         return;
     }
 
-#ifdef HAVE_SAMPLERATE
+    stream_resampler_free(c->rs);
+    stream_decimator_free(c->dec);
+    stream_opus_close(c->opus);
+    free(c->opus_pcm);
+    free(c->opus_packet);
+    free(c->buf_a);
+    free(c->buf_b);
+    free(c);
+}
 
-    if (c->src_state)
+int stream_conv_use_decimator(struct stream_conv *c, double shift_hz,
+                              int quality)
+{
+    struct stream_decimator *dec;
+
+    if (!c || !c->is_iq || c->src_rate % c->dst_rate != 0)
     {
-        src_delete(c->src_state);
+        return -1;
     }
 
-#endif
-    free(c->buf_a);
-    free(c->buf_b);
-    free(c);
+    if (c->src_rate == c->dst_rate && shift_hz == 0.0)
+    {
+        return 0;   /* nothing to decimate or shift */
+    }
+
+    if (stream_decimator_init(&dec, c->src_rate, c->src_rate / c->dst_rate,
+                              c->dst_ch, shift_hz, quality) != 0)
+    {
+        return -1;
+    }
+
+    stream_resampler_free(c->rs);
+    stream_decimator_free(c->dec);
+    c->rs = NULL;
+    c->dec = dec;
+    return 0;
+}
+
+int stream_conv_use_opus(struct stream_conv *c, int encode, int frame_samples,
+                         int bitrate, size_t max_packet)
+{
+    struct stream_opus *opus;
+    float *pcm;
+    unsigned char *packet = NULL;
+
+    if (!c || c->is_iq || c->opus
+            || (encode ? c->dst_fmt : c->src_fmt) != RIG_STREAM_FORMAT_PCM_F32)
+    {
+        return -1;
+    }
+
+    int rate = encode ? c->dst_rate : c->src_rate;
+    int ch = encode ? c->dst_ch : c->src_ch;
+    size_t pcm_frames = encode ? (size_t)frame_samples : STREAM_OPUS_MAX_FRAMES;
+
+    if (encode && (max_packet == 0
+                   || stream_opus_frame_samples(rate, frame_samples)
+                   != frame_samples))
+    {
+        return -1;
+    }
+
+    opus = stream_opus_open(encode, rate, ch, bitrate);
+
+    if (!opus)
+    {
+        return -1;
+    }
+
+    pcm = malloc(pcm_frames * ch * sizeof(float));
+
+    if (encode)
+    {
+        if (max_packet > STREAM_OPUS_MAX_PACKET)
+        {
+            max_packet = STREAM_OPUS_MAX_PACKET;
+        }
+
+        packet = malloc(max_packet);
+    }
+
+    if (!pcm || (encode && !packet))
+    {
+        free(pcm);
+        free(packet);
+        stream_opus_close(opus);
+        return -1;
+    }
+
+    c->opus = opus;
+    c->opus_encode = encode;
+    c->opus_frame = encode ? frame_samples : 0;
+    c->opus_have = 0;
+    c->opus_pcm = pcm;
+    c->opus_packet = packet;
+    c->opus_max_packet = max_packet;
+    return 0;
+}
+
+int stream_conv_opus_frame(const struct stream_conv *c)
+{
+    return c && c->opus ? c->opus_frame : 0;
+}
+
+/* Gather converted float frames into whole encoder frames and hand each
+ * packet to the sink.  A sink that refuses a packet (full ring) has
+ * already accounted for the drop, so encoding carries on.  Returns 0, or
+ * -1 when the encoder fails. */
+static int conv_opus_encode(struct stream_conv *c, const float *pcm,
+                            size_t frames, stream_conv_sink_fn sink,
+                            void *ctx)
+{
+    while (frames > 0)
+    {
+        size_t take = (size_t)(c->opus_frame - c->opus_have);
+
+        if (take > frames)
+        {
+            take = frames;
+        }
+
+        memcpy(c->opus_pcm + (size_t)c->opus_have * c->dst_ch, pcm,
+               take * c->dst_ch * sizeof(float));
+        c->opus_have += (int)take;
+        pcm += take * c->dst_ch;
+        frames -= take;
+
+        if (c->opus_have == c->opus_frame)
+        {
+            int n = stream_opus_encode(c->opus, c->opus_pcm, c->opus_frame,
+                                       c->opus_packet, c->opus_max_packet);
+
+            c->opus_have = 0;
+
+            if (n < 0)
+            {
+                return -1;
+            }
+
+            sink(ctx, c->opus_packet, (size_t)n);
+        }
+    }
+
+    return 0;
 }
 
 /* Convert one slice of in_frames source frames and deliver the result to
@@ -1028,7 +1035,7 @@ static size_t conv_run_slice(struct stream_conv *c, const unsigned char *in,
         cur_ch = c->dst_ch;
     }
 
-    int resampling = c->src_rate != c->dst_rate;
+    int resampling = c->rs != NULL || c->dec != NULL;
 
     /* Stage 2: convert to the pivot (resampling) or the destination. */
     rig_stream_format_t target = resampling ? c->pivot_fmt : c->dst_fmt;
@@ -1050,29 +1057,28 @@ static size_t conv_run_slice(struct stream_conv *c, const unsigned char *in,
         cur_fmt = target;
     }
 
-#ifdef HAVE_SAMPLERATE
-
-    /* Stage 3: stateful resample on the float pivot (I/Q runs as 2 float
-     * channels per I/Q channel, fixed at src_new time). */
+    /* Stage 3: stateful resample or decimation on the float pivot (I/Q
+     * runs as 2 float channels per I/Q channel, fixed at init time).
+     * out_cap_frames holds everything a chunk produces, so all of the
+     * input is used. */
     if (resampling)
     {
-        SRC_DATA data;
-
-        data.data_in = (float *)(uintptr_t)cur;
-        data.input_frames = (long)frames;
-        data.data_out = (float *)other;
-        data.output_frames = (long)c->out_cap_frames;
-        data.src_ratio = (double)c->dst_rate / (double)c->src_rate;
-        data.end_of_input = 0;
+        size_t used = frames;
 
-        if (src_process(c->src_state, &data) != 0)
+        if (c->dec)
         {
-            return (size_t)-1;
+            frames = stream_decimator_process(c->dec, (const float *)cur,
+                                              frames, (float *)other);
+        }
+        else
+        {
+            frames = stream_resampler_process(c->rs, (const float *)cur, &used,
+                                              (float *)other,
+                                              c->out_cap_frames);
         }
 
         cur = other;
         other = (other == c->buf_a) ? c->buf_b : c->buf_a;
-        frames = (size_t)data.output_frames_gen;
 
         /* Stage 4: pivot -> destination format. */
         if (c->dst_fmt != cur_fmt)
@@ -1090,8 +1096,6 @@ static size_t conv_run_slice(struct stream_conv *c, const unsigned char *in,
         }
     }
 
-#endif /* HAVE_SAMPLERATE */
-
     size_t out_bytes = frames * c->dst_frame_bytes;
     *out_bytes_total = out_bytes;
 
@@ -1100,12 +1104,60 @@ static size_t conv_run_slice(struct stream_conv *c, const unsigned char *in,
         return 0;  /* resampler primed but produced nothing yet */
     }
 
+    if (c->opus && c->opus_encode)
+    {
+        return conv_opus_encode(c, (const float *)cur, frames, sink, ctx) == 0
+               ? out_bytes : (size_t)-1;
+    }
+
     return sink(ctx, cur, out_bytes);
 }
 
+/* Decode one Opus packet and run its audio through the pipeline.  The
+ * decoder has moved on whatever the sink takes, so the packet counts as
+ * consumed.  Returns len, or -1 on a corrupt packet or conversion error. */
+static ssize_t conv_opus_decode(struct stream_conv *c,
+                                const unsigned char *pkt, size_t len,
+                                stream_conv_sink_fn sink, void *ctx)
+{
+    const unsigned char *in = (const unsigned char *)c->opus_pcm;
+    int decoded = stream_opus_decode(c->opus, pkt, len, c->opus_pcm,
+                                     STREAM_OPUS_MAX_FRAMES);
+    size_t frames_left;
+
+    if (decoded < 0)
+    {
+        return -1;
+    }
+
+    frames_left = (size_t)decoded;
+
+    while (frames_left > 0)
+    {
+        size_t slice = frames_left > STREAM_CONV_CHUNK_FRAMES
+                       ? STREAM_CONV_CHUNK_FRAMES : frames_left;
+        size_t offered = 0;
+
+        if (conv_run_slice(c, in, slice, sink, ctx, &offered) == (size_t)-1)
+        {
+            return -1;
+        }
+
+        in += slice * c->src_frame_bytes;
+        frames_left -= slice;
+    }
+
+    return (ssize_t)len;
+}
+
 ssize_t stream_conv_process(struct stream_conv *c, const void *buf,
                             size_t len, stream_conv_sink_fn sink, void *ctx)
 {
+    if (c && c->opus && !c->opus_encode && buf && sink)
+    {
+        return conv_opus_decode(c, buf, len, sink, ctx);
+    }
+
     if (!c || !buf || !sink || len % c->src_frame_bytes != 0)
     {
         return -1;
@@ -60,14 +60,19 @@ int rig_stream_convert_channels(const void *src, int src_channels,
                                 rig_stream_format_t format);
 
 /* Resample quality levels for rig_stream_resample(). */
-#define RIG_RESAMPLE_BEST    0  /* Highest quality SINC interpolation */
-#define RIG_RESAMPLE_MEDIUM  1  /* Balanced quality/speed SINC */
-#define RIG_RESAMPLE_FAST    2  /* Fastest SINC interpolation */
-
-/* Resample audio data (F32LE only).
- * src_samples is per channel. *dst_samples set to actual output count.
- * quality is one of RIG_RESAMPLE_BEST, RIG_RESAMPLE_MEDIUM, RIG_RESAMPLE_FAST.
- * Returns 0 on success, -1 if libsamplerate not compiled in. */
+#define RIG_RESAMPLE_BEST    0  /* 96 taps, 100 dB stopband */
+#define RIG_RESAMPLE_MEDIUM  1  /* 48 taps, 80 dB stopband */
+#define RIG_RESAMPLE_FAST    2  /* 24 taps, 60 dB stopband */
+
+/* Resample audio data (F32LE only) with the built-in polyphase resampler
+ * (stream_resample.c).
+ * src_samples is per channel. *dst_samples is the capacity on entry and
+ * is set to the actual output count, which is
+ * ceil(src_samples * dst_rate / src_rate) when it fits. Output frame k
+ * is the input at time k * src_rate / dst_rate, silence assumed past both
+ * ends. quality is one of RIG_RESAMPLE_BEST, RIG_RESAMPLE_MEDIUM,
+ * RIG_RESAMPLE_FAST.
+ * Returns 0 on success, -1 on bad arguments or out of memory. */
 int rig_stream_resample(const float *src, int src_rate,
                         float *dst, int dst_rate,
                         size_t src_samples, size_t *dst_samples,
@@ -76,9 +81,9 @@ int rig_stream_resample(const float *src, int src_rate,
 /* --- Persistent per-stream conversion context (frontend data path) --- */
 
 /* Opaque context carrying the stream's conversion pipeline state: scratch
- * buffers and, when rates differ, a STATEFUL resampler (src_process), so
- * consecutive calls are seam-free — unlike rig_stream_resample(), whose
- * one-shot src_simple() produces boundary artifacts on continuous data. */
+ * buffers and, when rates differ, a STATEFUL resampler, so consecutive
+ * calls are seam-free — unlike rig_stream_resample(), which treats every
+ * call as a whole signal with silence around it. */
 struct stream_conv;
 
 /* Sink for converted output. Returns the number of bytes accepted;
@@ -90,15 +95,36 @@ typedef size_t (*stream_conv_sink_fn)(void *ctx, const void *buf,
  * parameters to the destination (consumer-side) ones. Channel conversion:
  * audio maps 1<->2 (duplicate / average) and selects the first dst_ch
  * channels when narrowing from more; I/Q only selects a subset. Rate
- * conversion requires libsamplerate (fails otherwise) and resamples I/Q
- * as interleaved I/Q float pairs; quality is the RIG_RESAMPLE_* sinc
- * converter to use (ignored without rate conversion). Returns 0 and
+ * conversion resamples I/Q as interleaved I/Q float pairs; quality is the
+ * RIG_RESAMPLE_* filter to use (ignored without rate conversion). Returns 0 and
  * sets *out, or -1. */
 int stream_conv_init(struct stream_conv **out,
                      rig_stream_format_t src_fmt, int src_rate, int src_ch,
                      rig_stream_format_t dst_fmt, int dst_rate, int dst_ch,
                      int is_iq, int quality);
 
+/* Rate-convert an I/Q context with the CIC + half-band decimator
+ * (stream_decimate.c) instead of the polyphase resampler, first moving the
+ * signal at +shift_hz to DC when shift_hz is non-zero. The source rate
+ * must be an integer multiple of the destination rate. Returns 0, or -1
+ * leaving the context as it was. */
+int stream_conv_use_decimator(struct stream_conv *c, double shift_hz,
+                              int quality);
+
+/* Put an Opus codec (stream_codec.h) on the PCM_F32 side of a context.
+ * encode = 1 needs a PCM_F32 destination and turns the output into Opus
+ * packets of frame_samples frames each (a stream_opus_frame_samples()
+ * length), handing the sink one whole packet per call; bitrate is the
+ * target in bits/s (0 = codec default) and max_packet bounds a packet.
+ * encode = 0 needs a PCM_F32 source and takes one Opus packet per
+ * stream_conv_process() call in place of frames; a packet is consumed
+ * whole.  Returns 0, or -1 leaving the context as it was. */
+int stream_conv_use_opus(struct stream_conv *c, int encode, int frame_samples,
+                         int bitrate, size_t max_packet);
+
+/* Frames per encoded packet, or 0 without an Opus encoder */
+int stream_conv_opus_frame(const struct stream_conv *c);
+
 /* Feed whole source-side frames through the pipeline; converted output is
  * delivered to sink in chunks. Returns the number of source bytes
  * consumed (all of len unless the sink stopped early — then a
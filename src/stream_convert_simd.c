@@ -0,0 +1,1046 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* SSE2, AVX2 and NEON versions of the sample conversion kernels.  Each is
+ * compiled for its instruction set with a target attribute, so the library
+ * keeps the compiler's baseline and only runs what the CPU reports.  The
+ * last few elements of a call go to the scalar kernel.
+ *
+ * Float to integer conversion clamps before it rounds, like the scalar
+ * scale_round_clamp(): the max against the low end comes first, with x as
+ * its first operand, so a NaN comes out as the low end as well. */
+
+#ifdef HAVE_CONFIG_H
+#include "hamlib/config.h"
+#endif
+
+#include "stream_convert_simd.h"
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define STREAM_CONVERT_X86 1
+#  include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#  define STREAM_CONVERT_NEON 1
+#  include <arm_neon.h>
+#endif
+
+
+/* The scalar kernel for the elements a vector loop left */
+static void convert_tail(int op, const void *src, size_t src_size, void *dst,
+                         size_t dst_size, size_t done, size_t n)
+{
+    if (done < n)
+    {
+        stream_convert_scalar_kernels()->op[op](
+            (const unsigned char *)src + done * src_size,
+            (unsigned char *)dst + done * dst_size, n - done);
+    }
+}
+
+
+/* G.711 encoding (stream_codec.c): mu-law adds a bias of 0x84 to the
+ * magnitude and clips the sum at 32635; A-law codes the top 13 bits.  The
+ * segment is where the top bit of the result lies and the step the 4 bits
+ * under it.  Turned into a float, a magnitude carries the top bit's
+ * position in its exponent and the bits under it at the top of its
+ * mantissa, so float bits 19 up are segment and step together, offset by
+ * the exponent bias. */
+#define G711_BIAS       0x84
+#define G711_MAG_MAX    (32635 - G711_BIAS)
+#define G711_MULAW_BASE ((127 + 7) << 4)   /* Segment 0: top bit 7 */
+#define G711_ALAW_BASE  ((127 + 4) << 4)   /* Segment 1: top bit 5 */
+
+
+#ifdef STREAM_CONVERT_X86
+
+/* ------------------------------------------------------------------ */
+/* SSE2                                                                */
+/* ------------------------------------------------------------------ */
+
+#define SSE2 __attribute__((target("sse2")))
+
+SSE2 static void sse2_flip_sign8(const void *src, void *dst, size_t n,
+                                 int op)
+{
+    const __m128i sign = _mm_set1_epi8((char)0x80);
+    const unsigned char *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_xor_si128(v, sign));
+    }
+
+    convert_tail(op, src, 1, dst, 1, i, n);
+}
+
+SSE2 static void sse2_s8_to_u8(const void *src, void *dst, size_t n)
+{
+    sse2_flip_sign8(src, dst, n, STREAM_CONVERT_S8_TO_U8);
+}
+
+SSE2 static void sse2_u8_to_s8(const void *src, void *dst, size_t n)
+{
+    sse2_flip_sign8(src, dst, n, STREAM_CONVERT_U8_TO_S8);
+}
+
+/* 8-bit to 16-bit: the byte goes to the high half, a zero below it */
+SSE2 static void sse2_8_to_s16(const void *src, void *dst, size_t n, int op,
+                               int flip)
+{
+    const __m128i sign = _mm_set1_epi8(flip ? (char)0x80 : 0);
+    const __m128i zero = _mm_setzero_si128();
+    const unsigned char *s = src;
+    int16_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(s + i)), sign);
+        _mm_storeu_si128((__m128i *)(d + i), _mm_unpacklo_epi8(zero, v));
+        _mm_storeu_si128((__m128i *)(d + i + 8), _mm_unpackhi_epi8(zero, v));
+    }
+
+    convert_tail(op, src, 1, dst, 2, i, n);
+}
+
+SSE2 static void sse2_s8_to_s16(const void *src, void *dst, size_t n)
+{
+    sse2_8_to_s16(src, dst, n, STREAM_CONVERT_S8_TO_S16, 0);
+}
+
+SSE2 static void sse2_u8_to_s16(const void *src, void *dst, size_t n)
+{
+    sse2_8_to_s16(src, dst, n, STREAM_CONVERT_U8_TO_S16, 1);
+}
+
+SSE2 static void sse2_s16_to_8(const void *src, void *dst, size_t n, int op,
+                               int flip)
+{
+    const __m128i sign = _mm_set1_epi8(flip ? (char)0x80 : 0);
+    const int16_t *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_srai_epi16(_mm_loadu_si128((const __m128i *)(s + i)), 8);
+        __m128i b = _mm_srai_epi16(_mm_loadu_si128((const __m128i *)(s + i + 8)), 8);
+        _mm_storeu_si128((__m128i *)(d + i),
+                         _mm_xor_si128(_mm_packs_epi16(a, b), sign));
+    }
+
+    convert_tail(op, src, 2, dst, 1, i, n);
+}
+
+SSE2 static void sse2_s16_to_s8(const void *src, void *dst, size_t n)
+{
+    sse2_s16_to_8(src, dst, n, STREAM_CONVERT_S16_TO_S8, 0);
+}
+
+SSE2 static void sse2_s16_to_u8(const void *src, void *dst, size_t n)
+{
+    sse2_s16_to_8(src, dst, n, STREAM_CONVERT_S16_TO_U8, 1);
+}
+
+SSE2 static void sse2_8_to_f32(const void *src, void *dst, size_t n, int op,
+                               int flip)
+{
+    const __m128i sign = _mm_set1_epi8(flip ? (char)0x80 : 0);
+    const __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+    const unsigned char *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(s + i)), sign);
+        __m128i w[2];
+        int k;
+
+        // Sign extend: the byte doubled into both halves, shifted down
+        w[0] = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+        w[1] = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+
+        for (k = 0; k < 2; k++)
+        {
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(w[k], w[k]), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(w[k], w[k]), 16);
+            _mm_storeu_ps(d + i + k * 8, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(d + i + k * 8 + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+    }
+
+    convert_tail(op, src, 1, dst, 4, i, n);
+}
+
+SSE2 static void sse2_s8_to_f32(const void *src, void *dst, size_t n)
+{
+    sse2_8_to_f32(src, dst, n, STREAM_CONVERT_S8_TO_F32, 0);
+}
+
+SSE2 static void sse2_u8_to_f32(const void *src, void *dst, size_t n)
+{
+    sse2_8_to_f32(src, dst, n, STREAM_CONVERT_U8_TO_F32, 1);
+}
+
+SSE2 static void sse2_s16_to_f32(const void *src, void *dst, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    const int16_t *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(d + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(d + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+
+    convert_tail(STREAM_CONVERT_S16_TO_F32, src, 2, dst, 4, i, n);
+}
+
+/* Four floats scaled, clamped to [lo, hi] and rounded to nearest even */
+SSE2 static inline __m128i sse2_scale_round_clamp(const float *s, __m128 scale,
+        __m128 lo, __m128 hi)
+{
+    __m128 x = _mm_mul_ps(_mm_loadu_ps(s), scale);
+
+    return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(x, lo), hi));
+}
+
+SSE2 static void sse2_f32_to_s16(const void *src, void *dst, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    const float *s = src;
+    int16_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i a = sse2_scale_round_clamp(s + i, scale, lo, hi);
+        __m128i b = sse2_scale_round_clamp(s + i + 4, scale, lo, hi);
+        _mm_storeu_si128((__m128i *)(d + i), _mm_packs_epi32(a, b));
+    }
+
+    convert_tail(STREAM_CONVERT_F32_TO_S16, src, 4, dst, 2, i, n);
+}
+
+SSE2 static void sse2_f32_to_8(const void *src, void *dst, size_t n, int op,
+                               int flip)
+{
+    const __m128i sign = _mm_set1_epi8(flip ? (char)0x80 : 0);
+    const __m128 scale = _mm_set1_ps(128.0f);
+    const __m128 lo = _mm_set1_ps(-128.0f);
+    const __m128 hi = _mm_set1_ps(127.0f);
+    const float *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = sse2_scale_round_clamp(s + i, scale, lo, hi);
+        __m128i b = sse2_scale_round_clamp(s + i + 4, scale, lo, hi);
+        __m128i c = sse2_scale_round_clamp(s + i + 8, scale, lo, hi);
+        __m128i e = sse2_scale_round_clamp(s + i + 12, scale, lo, hi);
+        __m128i v = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, e));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_xor_si128(v, sign));
+    }
+
+    convert_tail(op, src, 4, dst, 1, i, n);
+}
+
+SSE2 static void sse2_f32_to_s8(const void *src, void *dst, size_t n)
+{
+    sse2_f32_to_8(src, dst, n, STREAM_CONVERT_F32_TO_S8, 0);
+}
+
+SSE2 static void sse2_f32_to_u8(const void *src, void *dst, size_t n)
+{
+    sse2_f32_to_8(src, dst, n, STREAM_CONVERT_F32_TO_U8, 1);
+}
+
+/* Segment and step of eight magnitudes below 2^15, as float bits >> 19 */
+SSE2 static inline __m128i sse2_g711_seg_step(__m128i mag)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_castps_si128(_mm_cvtepi32_ps(_mm_unpacklo_epi16(mag,
+                                  zero)));
+    __m128i hi = _mm_castps_si128(_mm_cvtepi32_ps(_mm_unpackhi_epi16(mag,
+                                  zero)));
+
+    return _mm_packs_epi32(_mm_srli_epi32(lo, 19), _mm_srli_epi32(hi, 19));
+}
+
+/* Eight mu-law codes in 16-bit lanes */
+SSE2 static inline __m128i sse2_mulaw8(const int16_t *s)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)s);
+    __m128i sign = _mm_srai_epi16(v, 15);
+    // Saturating, so -32768 becomes 32767 and clips like the scalar code
+    __m128i mag = _mm_subs_epi16(_mm_xor_si128(v, sign), sign);
+    __m128i code;
+
+    mag = _mm_add_epi16(_mm_min_epi16(mag, _mm_set1_epi16(G711_MAG_MAX)),
+                        _mm_set1_epi16(G711_BIAS));
+    code = _mm_sub_epi16(sse2_g711_seg_step(mag),
+                         _mm_set1_epi16(G711_MULAW_BASE));
+
+    // Inverted: 0xFF for positive samples, 0x7F for negative
+    return _mm_xor_si128(code, _mm_xor_si128(_mm_set1_epi16(0xFF),
+                         _mm_and_si128(sign, _mm_set1_epi16(0x80))));
+}
+
+/* Eight A-law codes in 16-bit lanes.  Magnitudes below 32 are segment 0,
+ * which shares segment 1's step. */
+SSE2 static inline __m128i sse2_alaw8(const int16_t *s)
+{
+    __m128i v = _mm_srai_epi16(_mm_loadu_si128((const __m128i *)s), 3);
+    __m128i sign = _mm_srai_epi16(v, 15);
+    __m128i mag = _mm_xor_si128(v, sign);           /* -v - 1 when negative */
+    __m128i small = _mm_cmplt_epi16(mag, _mm_set1_epi16(32));
+    __m128i big = _mm_sub_epi16(sse2_g711_seg_step(mag),
+                                _mm_set1_epi16(G711_ALAW_BASE));
+    __m128i code = _mm_or_si128(_mm_and_si128(small, _mm_srli_epi16(mag, 1)),
+                                _mm_andnot_si128(small, big));
+
+    // Even bits inverted: 0xD5 for positive samples, 0x55 for negative
+    return _mm_xor_si128(code, _mm_xor_si128(_mm_set1_epi16(0xD5),
+                         _mm_and_si128(sign, _mm_set1_epi16(0x80))));
+}
+
+SSE2 static void sse2_s16_to_mulaw(const void *src, void *dst, size_t n)
+{
+    const int16_t *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm_storeu_si128((__m128i *)(d + i),
+                         _mm_packus_epi16(sse2_mulaw8(s + i),
+                                          sse2_mulaw8(s + i + 8)));
+    }
+
+    convert_tail(STREAM_CONVERT_S16_TO_MULAW, src, 2, dst, 1, i, n);
+}
+
+SSE2 static void sse2_s16_to_alaw(const void *src, void *dst, size_t n)
+{
+    const int16_t *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm_storeu_si128((__m128i *)(d + i),
+                         _mm_packus_epi16(sse2_alaw8(s + i),
+                                          sse2_alaw8(s + i + 8)));
+    }
+
+    convert_tail(STREAM_CONVERT_S16_TO_ALAW, src, 2, dst, 1, i, n);
+}
+
+static const struct stream_convert_kernels sse2_kernels =
+{
+    "sse2",
+    {
+        [STREAM_CONVERT_S8_TO_U8] = sse2_s8_to_u8,
+        [STREAM_CONVERT_U8_TO_S8] = sse2_u8_to_s8,
+        [STREAM_CONVERT_S8_TO_S16] = sse2_s8_to_s16,
+        [STREAM_CONVERT_U8_TO_S16] = sse2_u8_to_s16,
+        [STREAM_CONVERT_S16_TO_S8] = sse2_s16_to_s8,
+        [STREAM_CONVERT_S16_TO_U8] = sse2_s16_to_u8,
+        [STREAM_CONVERT_S8_TO_F32] = sse2_s8_to_f32,
+        [STREAM_CONVERT_U8_TO_F32] = sse2_u8_to_f32,
+        [STREAM_CONVERT_S16_TO_F32] = sse2_s16_to_f32,
+        [STREAM_CONVERT_F32_TO_S8] = sse2_f32_to_s8,
+        [STREAM_CONVERT_F32_TO_U8] = sse2_f32_to_u8,
+        [STREAM_CONVERT_F32_TO_S16] = sse2_f32_to_s16,
+        [STREAM_CONVERT_MULAW_TO_S16] = stream_codec_mulaw_to_s16,
+        [STREAM_CONVERT_ALAW_TO_S16] = stream_codec_alaw_to_s16,
+        [STREAM_CONVERT_S16_TO_MULAW] = sse2_s16_to_mulaw,
+        [STREAM_CONVERT_S16_TO_ALAW] = sse2_s16_to_alaw,
+    }
+};
+
+
+/* ------------------------------------------------------------------ */
+/* AVX2                                                                */
+/* ------------------------------------------------------------------ */
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static void avx2_flip_sign8(const void *src, void *dst, size_t n,
+                                 int op)
+{
+    const __m256i sign = _mm256_set1_epi8((char)0x80);
+    const unsigned char *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        _mm256_storeu_si256((__m256i *)(d + i), _mm256_xor_si256(v, sign));
+    }
+
+    convert_tail(op, src, 1, dst, 1, i, n);
+}
+
+AVX2 static void avx2_s8_to_u8(const void *src, void *dst, size_t n)
+{
+    avx2_flip_sign8(src, dst, n, STREAM_CONVERT_S8_TO_U8);
+}
+
+AVX2 static void avx2_u8_to_s8(const void *src, void *dst, size_t n)
+{
+    avx2_flip_sign8(src, dst, n, STREAM_CONVERT_U8_TO_S8);
+}
+
+AVX2 static void avx2_8_to_s16(const void *src, void *dst, size_t n, int op,
+                               int flip)
+{
+    const __m128i sign = _mm_set1_epi8(flip ? (char)0x80 : 0);
+    const unsigned char *s = src;
+    int16_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(s + i)), sign);
+        __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(s + i + 16)),
+                                  sign);
+        _mm256_storeu_si256((__m256i *)(d + i),
+                            _mm256_slli_epi16(_mm256_cvtepi8_epi16(a), 8));
+        _mm256_storeu_si256((__m256i *)(d + i + 16),
+                            _mm256_slli_epi16(_mm256_cvtepi8_epi16(b), 8));
+    }
+
+    convert_tail(op, src, 1, dst, 2, i, n);
+}
+
+AVX2 static void avx2_s8_to_s16(const void *src, void *dst, size_t n)
+{
+    avx2_8_to_s16(src, dst, n, STREAM_CONVERT_S8_TO_S16, 0);
+}
+
+AVX2 static void avx2_u8_to_s16(const void *src, void *dst, size_t n)
+{
+    avx2_8_to_s16(src, dst, n, STREAM_CONVERT_U8_TO_S16, 1);
+}
+
+/* The packs work within each 128-bit lane; the permute puts the halves
+ * back in order */
+AVX2 static void avx2_s16_to_8(const void *src, void *dst, size_t n, int op,
+                               int flip)
+{
+    const __m256i sign = _mm256_set1_epi8(flip ? (char)0x80 : 0);
+    const int16_t *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i a = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i *)(s + i)),
+                                      8);
+        __m256i b = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i *)(s + i +
+                                      16)), 8);
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i *)(d + i), _mm256_xor_si256(v, sign));
+    }
+
+    convert_tail(op, src, 2, dst, 1, i, n);
+}
+
+AVX2 static void avx2_s16_to_s8(const void *src, void *dst, size_t n)
+{
+    avx2_s16_to_8(src, dst, n, STREAM_CONVERT_S16_TO_S8, 0);
+}
+
+AVX2 static void avx2_s16_to_u8(const void *src, void *dst, size_t n)
+{
+    avx2_s16_to_8(src, dst, n, STREAM_CONVERT_S16_TO_U8, 1);
+}
+
+AVX2 static void avx2_8_to_f32(const void *src, void *dst, size_t n, int op,
+                               int flip)
+{
+    const __m128i sign = _mm_set1_epi8(flip ? (char)0x80 : 0);
+    const __m256 scale = _mm256_set1_ps(1.0f / 128.0f);
+    const unsigned char *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(s + i)), sign);
+        __m256i lo = _mm256_cvtepi8_epi32(v);
+        __m256i hi = _mm256_cvtepi8_epi32(_mm_srli_si128(v, 8));
+        _mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(d + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+
+    convert_tail(op, src, 1, dst, 4, i, n);
+}
+
+AVX2 static void avx2_s8_to_f32(const void *src, void *dst, size_t n)
+{
+    avx2_8_to_f32(src, dst, n, STREAM_CONVERT_S8_TO_F32, 0);
+}
+
+AVX2 static void avx2_u8_to_f32(const void *src, void *dst, size_t n)
+{
+    avx2_8_to_f32(src, dst, n, STREAM_CONVERT_U8_TO_F32, 1);
+}
+
+AVX2 static void avx2_s16_to_f32(const void *src, void *dst, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+    const int16_t *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(s + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(s + i +
+                                           8)));
+        _mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(d + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+
+    convert_tail(STREAM_CONVERT_S16_TO_F32, src, 2, dst, 4, i, n);
+}
+
+AVX2 static inline __m256i avx2_scale_round_clamp(const float *s,
+        __m256 scale, __m256 lo, __m256 hi)
+{
+    __m256 x = _mm256_mul_ps(_mm256_loadu_ps(s), scale);
+
+    return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(x, lo), hi));
+}
+
+AVX2 static void avx2_f32_to_s16(const void *src, void *dst, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    const float *s = src;
+    int16_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i a = avx2_scale_round_clamp(s + i, scale, lo, hi);
+        __m256i b = avx2_scale_round_clamp(s + i + 8, scale, lo, hi);
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i *)(d + i), v);
+    }
+
+    convert_tail(STREAM_CONVERT_F32_TO_S16, src, 4, dst, 2, i, n);
+}
+
+/* After the two packs each lane holds four bytes from each input in turn;
+ * the dword permute gathers them back in order */
+AVX2 static void avx2_f32_to_8(const void *src, void *dst, size_t n, int op,
+                               int flip)
+{
+    const __m256i sign = _mm256_set1_epi8(flip ? (char)0x80 : 0);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256 scale = _mm256_set1_ps(128.0f);
+    const __m256 lo = _mm256_set1_ps(-128.0f);
+    const __m256 hi = _mm256_set1_ps(127.0f);
+    const float *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i a = avx2_scale_round_clamp(s + i, scale, lo, hi);
+        __m256i b = avx2_scale_round_clamp(s + i + 8, scale, lo, hi);
+        __m256i c = avx2_scale_round_clamp(s + i + 16, scale, lo, hi);
+        __m256i e = avx2_scale_round_clamp(s + i + 24, scale, lo, hi);
+        __m256i v = _mm256_packs_epi16(_mm256_packs_epi32(a, b),
+                                       _mm256_packs_epi32(c, e));
+        v = _mm256_permutevar8x32_epi32(v, order);
+        _mm256_storeu_si256((__m256i *)(d + i), _mm256_xor_si256(v, sign));
+    }
+
+    convert_tail(op, src, 4, dst, 1, i, n);
+}
+
+AVX2 static void avx2_f32_to_s8(const void *src, void *dst, size_t n)
+{
+    avx2_f32_to_8(src, dst, n, STREAM_CONVERT_F32_TO_S8, 0);
+}
+
+AVX2 static void avx2_f32_to_u8(const void *src, void *dst, size_t n)
+{
+    avx2_f32_to_8(src, dst, n, STREAM_CONVERT_F32_TO_U8, 1);
+}
+
+/* Segment and step of sixteen magnitudes below 2^15, in order */
+AVX2 static inline __m256i avx2_g711_seg_step(__m256i mag)
+{
+    __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(mag));
+    __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(mag, 1));
+
+    lo = _mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(lo)), 19);
+    hi = _mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(hi)), 19);
+
+    // packs works per 128-bit lane; put the quarters back in order
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+}
+
+AVX2 static inline __m256i avx2_mulaw16(const int16_t *s)
+{
+    __m256i v = _mm256_loadu_si256((const __m256i *)s);
+    __m256i sign = _mm256_srai_epi16(v, 15);
+    __m256i mag = _mm256_subs_epi16(_mm256_xor_si256(v, sign), sign);
+    __m256i code;
+
+    mag = _mm256_add_epi16(_mm256_min_epi16(mag,
+                                            _mm256_set1_epi16(G711_MAG_MAX)),
+                           _mm256_set1_epi16(G711_BIAS));
+    code = _mm256_sub_epi16(avx2_g711_seg_step(mag),
+                            _mm256_set1_epi16(G711_MULAW_BASE));
+
+    return _mm256_xor_si256(code, _mm256_xor_si256(_mm256_set1_epi16(0xFF),
+                            _mm256_and_si256(sign, _mm256_set1_epi16(0x80))));
+}
+
+AVX2 static inline __m256i avx2_alaw16(const int16_t *s)
+{
+    __m256i v = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i *)s), 3);
+    __m256i sign = _mm256_srai_epi16(v, 15);
+    __m256i mag = _mm256_xor_si256(v, sign);
+    __m256i small = _mm256_cmpgt_epi16(_mm256_set1_epi16(32), mag);
+    __m256i big = _mm256_sub_epi16(avx2_g711_seg_step(mag),
+                                   _mm256_set1_epi16(G711_ALAW_BASE));
+    __m256i code = _mm256_blendv_epi8(big, _mm256_srli_epi16(mag, 1), small);
+
+    return _mm256_xor_si256(code, _mm256_xor_si256(_mm256_set1_epi16(0xD5),
+                            _mm256_and_si256(sign, _mm256_set1_epi16(0x80))));
+}
+
+/* Thirty-two codes from two halves, packed and put back in order */
+AVX2 static inline void avx2_store_g711(unsigned char *d, __m256i a, __m256i b)
+{
+    _mm256_storeu_si256((__m256i *)d,
+                        _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+}
+
+AVX2 static void avx2_s16_to_mulaw(const void *src, void *dst, size_t n)
+{
+    const int16_t *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        avx2_store_g711(d + i, avx2_mulaw16(s + i), avx2_mulaw16(s + i + 16));
+    }
+
+    convert_tail(STREAM_CONVERT_S16_TO_MULAW, src, 2, dst, 1, i, n);
+}
+
+AVX2 static void avx2_s16_to_alaw(const void *src, void *dst, size_t n)
+{
+    const int16_t *s = src;
+    unsigned char *d = dst;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        avx2_store_g711(d + i, avx2_alaw16(s + i), avx2_alaw16(s + i + 16));
+    }
+
+    convert_tail(STREAM_CONVERT_S16_TO_ALAW, src, 2, dst, 1, i, n);
+}
+
+static const struct stream_convert_kernels avx2_kernels =
+{
+    "avx2",
+    {
+        [STREAM_CONVERT_S8_TO_U8] = avx2_s8_to_u8,
+        [STREAM_CONVERT_U8_TO_S8] = avx2_u8_to_s8,
+        [STREAM_CONVERT_S8_TO_S16] = avx2_s8_to_s16,
+        [STREAM_CONVERT_U8_TO_S16] = avx2_u8_to_s16,
+        [STREAM_CONVERT_S16_TO_S8] = avx2_s16_to_s8,
+        [STREAM_CONVERT_S16_TO_U8] = avx2_s16_to_u8,
+        [STREAM_CONVERT_S8_TO_F32] = avx2_s8_to_f32,
+        [STREAM_CONVERT_U8_TO_F32] = avx2_u8_to_f32,
+        [STREAM_CONVERT_S16_TO_F32] = avx2_s16_to_f32,
+        [STREAM_CONVERT_F32_TO_S8] = avx2_f32_to_s8,
+        [STREAM_CONVERT_F32_TO_U8] = avx2_f32_to_u8,
+        [STREAM_CONVERT_F32_TO_S16] = avx2_f32_to_s16,
+        [STREAM_CONVERT_MULAW_TO_S16] = stream_codec_mulaw_to_s16,
+        [STREAM_CONVERT_ALAW_TO_S16] = stream_codec_alaw_to_s16,
+        [STREAM_CONVERT_S16_TO_MULAW] = avx2_s16_to_mulaw,
+        [STREAM_CONVERT_S16_TO_ALAW] = avx2_s16_to_alaw,
+    }
+};
+
+
+int stream_convert_simd_kernels(const struct stream_convert_kernels **sets,
+                                int max)
+{
+    int count = 0;
+
+    __builtin_cpu_init();
+
+    if (count < max && __builtin_cpu_supports("sse2"))
+    {
+        sets[count++] = &sse2_kernels;
+    }
+
+    if (count < max && __builtin_cpu_supports("avx2"))
+    {
+        sets[count++] = &avx2_kernels;
+    }
+
+    return count;
+}
+
+#elif defined(STREAM_CONVERT_NEON)
+
+/* ------------------------------------------------------------------ */
+/* NEON (AArch64, where it is always present)                          */
+/* ------------------------------------------------------------------ */
+
+static void neon_flip_sign8(const void *src, void *dst, size_t n, int op)
+{
+    const uint8x16_t sign = vdupq_n_u8(0x80);
+    const uint8_t *s = src;
+    uint8_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        vst1q_u8(d + i, veorq_u8(vld1q_u8(s + i), sign));
+    }
+
+    convert_tail(op, src, 1, dst, 1, i, n);
+}
+
+static void neon_s8_to_u8(const void *src, void *dst, size_t n)
+{
+    neon_flip_sign8(src, dst, n, STREAM_CONVERT_S8_TO_U8);
+}
+
+static void neon_u8_to_s8(const void *src, void *dst, size_t n)
+{
+    neon_flip_sign8(src, dst, n, STREAM_CONVERT_U8_TO_S8);
+}
+
+static void neon_8_to_s16(const void *src, void *dst, size_t n, int op,
+                          int flip)
+{
+    const uint8x16_t sign = vdupq_n_u8(flip ? 0x80 : 0);
+    const uint8_t *s = src;
+    int16_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        int8x16_t v = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(s + i), sign));
+        vst1q_s16(d + i, vshll_n_s8(vget_low_s8(v), 8));
+        vst1q_s16(d + i + 8, vshll_high_n_s8(v, 8));
+    }
+
+    convert_tail(op, src, 1, dst, 2, i, n);
+}
+
+static void neon_s8_to_s16(const void *src, void *dst, size_t n)
+{
+    neon_8_to_s16(src, dst, n, STREAM_CONVERT_S8_TO_S16, 0);
+}
+
+static void neon_u8_to_s16(const void *src, void *dst, size_t n)
+{
+    neon_8_to_s16(src, dst, n, STREAM_CONVERT_U8_TO_S16, 1);
+}
+
+static void neon_s16_to_8(const void *src, void *dst, size_t n, int op,
+                          int flip)
+{
+    const uint8x16_t sign = vdupq_n_u8(flip ? 0x80 : 0);
+    const int16_t *s = src;
+    uint8_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        int8x16_t v = vcombine_s8(vshrn_n_s16(vld1q_s16(s + i), 8),
+                                  vshrn_n_s16(vld1q_s16(s + i + 8), 8));
+        vst1q_u8(d + i, veorq_u8(vreinterpretq_u8_s8(v), sign));
+    }
+
+    convert_tail(op, src, 2, dst, 1, i, n);
+}
+
+static void neon_s16_to_s8(const void *src, void *dst, size_t n)
+{
+    neon_s16_to_8(src, dst, n, STREAM_CONVERT_S16_TO_S8, 0);
+}
+
+static void neon_s16_to_u8(const void *src, void *dst, size_t n)
+{
+    neon_s16_to_8(src, dst, n, STREAM_CONVERT_S16_TO_U8, 1);
+}
+
+static inline void neon_store_s16_f32(float *d, int16x8_t v, float scale)
+{
+    vst1q_f32(d, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+    vst1q_f32(d + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(v)), scale));
+}
+
+static void neon_8_to_f32(const void *src, void *dst, size_t n, int op,
+                          int flip)
+{
+    const uint8x16_t sign = vdupq_n_u8(flip ? 0x80 : 0);
+    const uint8_t *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        int8x16_t v = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(s + i), sign));
+        neon_store_s16_f32(d + i, vmovl_s8(vget_low_s8(v)), 1.0f / 128.0f);
+        neon_store_s16_f32(d + i + 8, vmovl_high_s8(v), 1.0f / 128.0f);
+    }
+
+    convert_tail(op, src, 1, dst, 4, i, n);
+}
+
+static void neon_s8_to_f32(const void *src, void *dst, size_t n)
+{
+    neon_8_to_f32(src, dst, n, STREAM_CONVERT_S8_TO_F32, 0);
+}
+
+static void neon_u8_to_f32(const void *src, void *dst, size_t n)
+{
+    neon_8_to_f32(src, dst, n, STREAM_CONVERT_U8_TO_F32, 1);
+}
+
+static void neon_s16_to_f32(const void *src, void *dst, size_t n)
+{
+    const int16_t *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        neon_store_s16_f32(d + i, vld1q_s16(s + i), 1.0f / 32768.0f);
+    }
+
+    convert_tail(STREAM_CONVERT_S16_TO_F32, src, 2, dst, 4, i, n);
+}
+
+/* maxnm returns the number when the other operand is NaN */
+static inline int32x4_t neon_scale_round_clamp(const float *s, float scale,
+        float32x4_t lo, float32x4_t hi)
+{
+    float32x4_t x = vmulq_n_f32(vld1q_f32(s), scale);
+
+    return vcvtnq_s32_f32(vminnmq_f32(vmaxnmq_f32(x, lo), hi));
+}
+
+static void neon_f32_to_s16(const void *src, void *dst, size_t n)
+{
+    const float32x4_t lo = vdupq_n_f32(-32768.0f);
+    const float32x4_t hi = vdupq_n_f32(32767.0f);
+    const float *s = src;
+    int16_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        int32x4_t a = neon_scale_round_clamp(s + i, 32768.0f, lo, hi);
+        int32x4_t b = neon_scale_round_clamp(s + i + 4, 32768.0f, lo, hi);
+        vst1q_s16(d + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+    }
+
+    convert_tail(STREAM_CONVERT_F32_TO_S16, src, 4, dst, 2, i, n);
+}
+
+static void neon_f32_to_8(const void *src, void *dst, size_t n, int op,
+                          int flip)
+{
+    const uint8x16_t sign = vdupq_n_u8(flip ? 0x80 : 0);
+    const float32x4_t lo = vdupq_n_f32(-128.0f);
+    const float32x4_t hi = vdupq_n_f32(127.0f);
+    const float *s = src;
+    uint8_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        int16x8_t ab = vcombine_s16(
+                           vqmovn_s32(neon_scale_round_clamp(s + i, 128.0f, lo, hi)),
+                           vqmovn_s32(neon_scale_round_clamp(s + i + 4, 128.0f, lo, hi)));
+        int16x8_t ce = vcombine_s16(
+                           vqmovn_s32(neon_scale_round_clamp(s + i + 8, 128.0f, lo, hi)),
+                           vqmovn_s32(neon_scale_round_clamp(s + i + 12, 128.0f, lo, hi)));
+        int8x16_t v = vcombine_s8(vqmovn_s16(ab), vqmovn_s16(ce));
+        vst1q_u8(d + i, veorq_u8(vreinterpretq_u8_s8(v), sign));
+    }
+
+    convert_tail(op, src, 4, dst, 1, i, n);
+}
+
+static void neon_f32_to_s8(const void *src, void *dst, size_t n)
+{
+    neon_f32_to_8(src, dst, n, STREAM_CONVERT_F32_TO_S8, 0);
+}
+
+static void neon_f32_to_u8(const void *src, void *dst, size_t n)
+{
+    neon_f32_to_8(src, dst, n, STREAM_CONVERT_F32_TO_U8, 1);
+}
+
+/* Eight mu-law codes; NEON counts leading zeros and shifts per lane */
+static inline uint16x8_t neon_mulaw8(const int16_t *s)
+{
+    int16x8_t v = vld1q_s16(s);
+    uint16x8_t neg = vcltq_s16(v, vdupq_n_s16(0));
+    // Saturating, so -32768 becomes 32767 and clips like the scalar code
+    uint16x8_t mag = vreinterpretq_u16_s16(
+                         vaddq_s16(vminq_s16(vqabsq_s16(v), vdupq_n_s16(G711_MAG_MAX)),
+                                   vdupq_n_s16(G711_BIAS)));
+    // Top bit 15 - clz, at least 7
+    int16x8_t seg = vsubq_s16(vdupq_n_s16(15 - 7),
+                              vreinterpretq_s16_u16(vclzq_u16(mag)));
+    uint16x8_t step = vandq_u16(vshlq_u16(mag, vnegq_s16(vaddq_s16(seg,
+                                          vdupq_n_s16(3)))), vdupq_n_u16(0x0F));
+    uint16x8_t code = vorrq_u16(vshlq_n_u16(vreinterpretq_u16_s16(seg), 4), step);
+
+    return veorq_u16(code, veorq_u16(vdupq_n_u16(0xFF),
+                                     vandq_u16(neg, vdupq_n_u16(0x80))));
+}
+
+static inline uint16x8_t neon_alaw8(const int16_t *s)
+{
+    int16x8_t v = vshrq_n_s16(vld1q_s16(s), 3);
+    int16x8_t sign = vshrq_n_s16(v, 15);
+    uint16x8_t mag = vreinterpretq_u16_s16(veorq_s16(v, sign));
+    // Segment 0 below a top bit of 5, where the step stays at 1 bit
+    int16x8_t seg = vmaxq_s16(vsubq_s16(vdupq_n_s16(15 - 4),
+                                        vreinterpretq_s16_u16(vclzq_u16(mag))),
+                              vdupq_n_s16(0));
+    int16x8_t shift = vmaxq_s16(seg, vdupq_n_s16(1));
+    uint16x8_t step = vandq_u16(vshlq_u16(mag, vnegq_s16(shift)),
+                                vdupq_n_u16(0x0F));
+    uint16x8_t code = vorrq_u16(vshlq_n_u16(vreinterpretq_u16_s16(seg), 4), step);
+
+    return veorq_u16(code, veorq_u16(vdupq_n_u16(0xD5),
+                                     vandq_u16(vreinterpretq_u16_s16(sign),
+                                               vdupq_n_u16(0x80))));
+}
+
+static void neon_s16_to_mulaw(const void *src, void *dst, size_t n)
+{
+    const int16_t *s = src;
+    uint8_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        vst1q_u8(d + i, vcombine_u8(vmovn_u16(neon_mulaw8(s + i)),
+                                    vmovn_u16(neon_mulaw8(s + i + 8))));
+    }
+
+    convert_tail(STREAM_CONVERT_S16_TO_MULAW, src, 2, dst, 1, i, n);
+}
+
+static void neon_s16_to_alaw(const void *src, void *dst, size_t n)
+{
+    const int16_t *s = src;
+    uint8_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        vst1q_u8(d + i, vcombine_u8(vmovn_u16(neon_alaw8(s + i)),
+                                    vmovn_u16(neon_alaw8(s + i + 8))));
+    }
+
+    convert_tail(STREAM_CONVERT_S16_TO_ALAW, src, 2, dst, 1, i, n);
+}
+
+static const struct stream_convert_kernels neon_kernels =
+{
+    "neon",
+    {
+        [STREAM_CONVERT_S8_TO_U8] = neon_s8_to_u8,
+        [STREAM_CONVERT_U8_TO_S8] = neon_u8_to_s8,
+        [STREAM_CONVERT_S8_TO_S16] = neon_s8_to_s16,
+        [STREAM_CONVERT_U8_TO_S16] = neon_u8_to_s16,
+        [STREAM_CONVERT_S16_TO_S8] = neon_s16_to_s8,
+        [STREAM_CONVERT_S16_TO_U8] = neon_s16_to_u8,
+        [STREAM_CONVERT_S8_TO_F32] = neon_s8_to_f32,
+        [STREAM_CONVERT_U8_TO_F32] = neon_u8_to_f32,
+        [STREAM_CONVERT_S16_TO_F32] = neon_s16_to_f32,
+        [STREAM_CONVERT_F32_TO_S8] = neon_f32_to_s8,
+        [STREAM_CONVERT_F32_TO_U8] = neon_f32_to_u8,
+        [STREAM_CONVERT_F32_TO_S16] = neon_f32_to_s16,
+        [STREAM_CONVERT_MULAW_TO_S16] = stream_codec_mulaw_to_s16,
+        [STREAM_CONVERT_ALAW_TO_S16] = stream_codec_alaw_to_s16,
+        [STREAM_CONVERT_S16_TO_MULAW] = neon_s16_to_mulaw,
+        [STREAM_CONVERT_S16_TO_ALAW] = neon_s16_to_alaw,
+    }
+};
+
+
+int stream_convert_simd_kernels(const struct stream_convert_kernels **sets,
+                                int max)
+{
+    if (max < 1)
+    {
+        return 0;
+    }
+
+    sets[0] = &neon_kernels;
+
+    return 1;
+}
+
+#else
+
+int stream_convert_simd_kernels(const struct stream_convert_kernels **sets,
+                                int max)
+{
+    (void)sets;
+    (void)max;
+
+    return 0;
+}
+
+#endif
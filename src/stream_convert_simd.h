@@ -0,0 +1,95 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Element kernels behind rig_stream_convert() and the G.711 device codecs,
+ * and the vector versions of them picked at run time from what the CPU
+ * has.  Every vector kernel gives the same bytes as the scalar one,
+ * including rounding and clamping. */
+
+#ifndef HAMLIB_STREAM_CONVERT_SIMD_H
+#define HAMLIB_STREAM_CONVERT_SIMD_H
+
+#include <stddef.h>
+
+
+/* The element-wise operations the format converters are made of.  An I/Q
+ * conversion is its audio counterpart run over both components. */
+enum stream_convert_op
+{
+    STREAM_CONVERT_NONE = 0,
+    STREAM_CONVERT_S8_TO_U8,
+    STREAM_CONVERT_U8_TO_S8,
+    STREAM_CONVERT_S8_TO_S16,
+    STREAM_CONVERT_U8_TO_S16,
+    STREAM_CONVERT_S16_TO_S8,
+    STREAM_CONVERT_S16_TO_U8,
+    STREAM_CONVERT_S8_TO_F32,
+    STREAM_CONVERT_U8_TO_F32,
+    STREAM_CONVERT_S16_TO_F32,
+    STREAM_CONVERT_F32_TO_S8,
+    STREAM_CONVERT_F32_TO_U8,
+    STREAM_CONVERT_F32_TO_S16,
+    STREAM_CONVERT_MULAW_TO_S16,        /* G.711, for stream_codec.c */
+    STREAM_CONVERT_ALAW_TO_S16,
+    STREAM_CONVERT_S16_TO_MULAW,
+    STREAM_CONVERT_S16_TO_ALAW,
+    STREAM_CONVERT_OP_COUNT
+};
+
+/* Convert n elements (an I/Q pair is two) from src to dst.  Neither needs
+ * any alignment. */
+typedef void (*stream_convert_kernel_fn)(const void *src, void *dst,
+                                         size_t n);
+
+/* One implementation of every operation; op[STREAM_CONVERT_NONE] is
+ * unused. */
+struct stream_convert_kernels
+{
+    const char *name;                   /* "scalar", "sse2", "avx2", "neon" */
+    stream_convert_kernel_fn op[STREAM_CONVERT_OP_COUNT];
+};
+
+/* The plain C kernels, which define the results (stream_convert.c). */
+const struct stream_convert_kernels *stream_convert_scalar_kernels(void);
+
+/* The scalar G.711 kernels, kept with the codecs (stream_codec.c).
+ * Decoding is a table lookup in every set. */
+void stream_codec_mulaw_to_s16(const void *src, void *dst, size_t n);
+void stream_codec_alaw_to_s16(const void *src, void *dst, size_t n);
+void stream_codec_s16_to_mulaw(const void *src, void *dst, size_t n);
+void stream_codec_s16_to_alaw(const void *src, void *dst, size_t n);
+
+/* The vector kernel sets this CPU runs, fastest last, at most max of them
+ * into sets.  Returns their number, 0 where there are none
+ * (stream_convert_simd.c). */
+int stream_convert_simd_kernels(const struct stream_convert_kernels **sets,
+                                int max);
+
+/* The set rig_stream_convert() uses: the fastest this CPU runs, unless
+ * stream_convert_use_kernels() picked another. */
+const struct stream_convert_kernels *stream_convert_active_kernels(void);
+
+/* Make rig_stream_convert() use the set called name, or the fastest for
+ * NULL; for tests and benchmarks.  Returns 0, or -1 when this CPU has no
+ * such set. */
+int stream_convert_use_kernels(const char *name);
+
+#endif /* HAMLIB_STREAM_CONVERT_SIMD_H */
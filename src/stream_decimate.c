@@ -0,0 +1,854 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* CIC + half-band + compensating FIR decimator.  The factor D splits as
+ * cic x 2^halfbands x fir.  The FIR side (2^halfbands x fir) is the
+ * smallest divisor of D of at least 4 or 8, which with the quality's CIC
+ * order keeps the CIC's aliases into the passband below the stopband
+ * attenuation; every factor of 2 in it but one becomes a half-band stage,
+ * and the final FIR takes the rest, its passband shaped to undo the CIC
+ * droop.
+ *
+ * The CIC runs in wrapping 64-bit integers on input scaled to 28
+ * fractional bits, which is exact however long it runs: the factor is
+ * capped so that order x log2(factor) bits of growth still fit.  The filters keep
+ * a deinterleaved history per lane (I and Q of each channel) like the
+ * resampler, so each output is one dot product per lane. */
+
+#ifdef HAVE_CONFIG_H
+#include "hamlib/config.h"
+#endif
+
+#include "stream_decimate.h"
+#include "stream_convert.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Input frames handled per pass */
+#define STREAM_DECIMATE_BLOCK 1024
+
+/* Outputs a FIR stage computes per lane at a time */
+#define STREAM_DECIMATE_RUN 256
+
+#define STREAM_DECIMATE_MAX_HALFBANDS 8
+
+/* CIC input scaling; samples are clamped to +/- 8 so that 28 fractional
+ * bits plus up to 32 bits of growth fit in 64 */
+#define STREAM_DECIMATE_CIC_FRAC_BITS 28
+#define STREAM_DECIMATE_CIC_GROWTH_BITS 32
+#define STREAM_DECIMATE_CIC_LIMIT 7.99f
+
+/* Integrator stages kept per lane, the highest CIC order */
+#define STREAM_DECIMATE_CIC_STAGES 5
+
+/* Integration steps for the droop compensation */
+#define STREAM_DECIMATE_COMP_STEPS 1024
+
+/* Flat passband as a fraction of the output Nyquist frequency, stopband
+ * attenuation, CIC order and the smallest factor the filters take after
+ * the CIC.  Aliases from the first CIC null onto the passband edge land
+ * 120, 100 and 80 dB down. */
+static const struct
+{
+    double pass;
+    double atten_db;
+    int cic_order;
+    int min_fir;
+} decimate_quality[] =
+{
+    [RIG_RESAMPLE_BEST]   = { 0.90, 100.0, 5, 8 },
+    [RIG_RESAMPLE_MEDIUM] = { 0.80, 80.0, 4, 8 },
+    [RIG_RESAMPLE_FAST]   = { 0.70, 60.0, 4, 4 },
+};
+
+/* One decimating FIR stage: a half-band (side > 0, coefs holds the side
+ * taps at odd offsets from a 0.5 centre tap) or a plain FIR */
+struct decim_fir
+{
+    int taps;                       /* Window length */
+    int factor;
+    int side;                       /* Half-band taps each side, or 0 */
+    float *coefs;
+    size_t cap;                     /* Frames buf holds per lane */
+    float *buf;                     /* lanes x cap, deinterleaved */
+    size_t have;                    /* Frames in buf */
+    size_t pos;                     /* Newest frame the next output uses */
+};
+
+struct stream_decimator
+{
+    int lanes;                      /* I and Q of every channel */
+    int factor;
+    int cic;                        /* CIC factor, 1 = no CIC */
+    int cic_order;
+    int cic_count;                  /* Input frames since the last output */
+    uint64_t *cic_integ;            /* lanes x STAGES integrators */
+    uint64_t *cic_comb;             /* lanes x STAGES previous comb inputs */
+    double cic_gain;                /* Undoes the scaling and cic^order */
+    int halfbands;
+    int fir_factor;
+    int stages;                     /* Entries of fir[] in use */
+    struct decim_fir fir[STREAM_DECIMATE_MAX_HALFBANDS + 1];
+    int shift;                      /* NCO in use */
+    double *nco_table;              /* cos, sin of k steps, k <= BLOCK */
+    float *nco_phase;               /* This block's phasors, BLOCK pairs */
+    double nco_cos, nco_sin;        /* NCO phase at the block start */
+    int nco_count;                  /* Frames into the block */
+    uint64_t in_total, out_total;
+    float *scratch[2];              /* Ping-pong, BLOCK frames each */
+};
+
+
+/* Modified Bessel function of the first kind, order 0 */
+static double decimate_bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+
+    for (int k = 1; k < 64 && term > sum * 1e-12; k++)
+    {
+        double half = x / (2.0 * k);
+        term *= half * half;
+        sum += term;
+    }
+
+    return sum;
+}
+
+
+/* Kaiser window at r in [-1, 1] */
+static double decimate_kaiser(double r, double beta, double i0_beta)
+{
+    return fabs(r) < 1.0
+           ? decimate_bessel_i0(beta * sqrt(1.0 - r * r)) / i0_beta : 0.0;
+}
+
+
+/* Kaiser's estimate of the taps for atten_db over a transition width in
+ * cycles per sample */
+static int decimate_kaiser_taps(double atten_db, double width)
+{
+    return (int)ceil((atten_db - 7.95) / (14.36 * width)) + 1;
+}
+
+
+/* Gain of the CIC at u cycles per CIC output sample, 1 at DC */
+static double decimate_cic_response(double u, int cic, int order)
+{
+    double g;
+
+    if (u < 1e-12)
+    {
+        return 1.0;
+    }
+
+    g = sin(M_PI * u) / (cic * sin(M_PI * u / cic));
+
+    return pow(fabs(g), order);
+}
+
+
+/* Split factor into cic x 2^halfbands x fir, with cic at most max_cic */
+static void decimate_split(int factor, int min_fir, int max_cic, int *cic,
+                           int *halfbands, int *fir)
+{
+    int m = factor, h = 0;
+
+    if (factor >= min_fir)
+    {
+        for (m = min_fir; m < factor; m++)
+        {
+            if (factor % m == 0 && factor / m <= max_cic)
+            {
+                break;
+            }
+        }
+    }
+
+    *cic = factor / m;
+
+    while (m % 4 == 0 && h < STREAM_DECIMATE_MAX_HALFBANDS)
+    {
+        m /= 2;
+        h++;
+    }
+
+    *halfbands = h;
+    *fir = m;
+}
+
+
+/* Half-band side taps: the ideal response at odd offsets 1, 3, ... from
+ * the centre, windowed and scaled so the whole filter has unity DC gain */
+static void decimate_design_halfband(float *side, int n, double beta,
+                                     double i0_beta)
+{
+    double sum = 0.0;
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        int d = 2 * i + 1;
+        double h = sin(M_PI * d / 2.0) / (M_PI * d)
+                   * decimate_kaiser(d / (2.0 * n), beta, i0_beta);
+
+        side[i] = (float)h;
+        sum += h;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        side[i] = (float)(side[i] * 0.25 / sum);
+    }
+}
+
+
+/* The final FIR: a lowpass at cutoff cycles per sample whose passband gain
+ * is the inverse of the CIC's, so the cascade is flat.  droop_scale takes
+ * this stage's frequencies to the CIC's output rate.  The ideal response
+ * is the sinc plus the integral of the droop correction, summed with a
+ * cosine recurrence. */
+static void decimate_design_fir(float *coefs, int taps, double cutoff,
+                                int cic, int order, double droop_scale,
+                                double beta, double i0_beta)
+{
+    double corr[STREAM_DECIMATE_COMP_STEPS];
+    double df = cutoff / STREAM_DECIMATE_COMP_STEPS;
+    double mid = (taps - 1) / 2.0;
+    double sum = 0.0;
+    int j, k;
+
+    for (k = 0; k < STREAM_DECIMATE_COMP_STEPS; k++)
+    {
+        corr[k] = cic > 1
+                  ? 1.0 / decimate_cic_response((k + 0.5) * df * droop_scale, cic,
+                                                order) - 1.0 : 0.0;
+    }
+
+    for (j = 0; j < taps; j++)
+    {
+        double t = j - mid;
+        double x = 2.0 * cutoff * t;
+        double h = 2.0 * cutoff * (fabs(x) < 1e-9 ? 1.0 : sin(M_PI * x) /
+                                   (M_PI * x));
+
+        if (cic > 1)
+        {
+            double theta = 2.0 * M_PI * df * t;
+            double twice = 2.0 * cos(theta);
+            double prev = cos(-0.5 * theta), cur = cos(0.5 * theta);
+            double acc = 0.0;
+
+            for (k = 0; k < STREAM_DECIMATE_COMP_STEPS; k++)
+            {
+                double next = twice * cur - prev;
+
+                acc += corr[k] * cur;
+                prev = cur;
+                cur = next;
+            }
+
+            h += 2.0 * df * acc;
+        }
+
+        h *= decimate_kaiser(t / (taps / 2.0), beta, i0_beta);
+        coefs[j] = (float)h;
+        sum += h;
+    }
+
+    for (j = 0; j < taps; j++)
+    {
+        coefs[j] = (float)(coefs[j] / sum);
+    }
+}
+
+
+static int decim_fir_init(struct decim_fir *st, int taps, int factor,
+                          int side, int lanes)
+{
+    size_t block = STREAM_DECIMATE_BLOCK;
+
+    if (block < 2 * (size_t)factor)
+    {
+        block = 2 * (size_t)factor;
+    }
+
+    st->taps = taps;
+    st->factor = factor;
+    st->side = side;
+    st->cap = (size_t)taps - 1 + block;
+    st->coefs = malloc((side > 0 ? side : taps) * sizeof(float));
+    st->buf = malloc((size_t)lanes * st->cap * sizeof(float));
+
+    return st->coefs && st->buf ? 0 : -1;
+}
+
+
+static void decim_fir_reset(struct decim_fir *st, int lanes)
+{
+    memset(st->buf, 0, (size_t)lanes * st->cap * sizeof(float));
+    st->have = st->taps - 1;
+    st->pos = st->taps - 1;
+}
+
+
+static float decim_dot(const float *c, const float *x, int taps)
+{
+    float acc[8] = { 0 };
+
+    for (int i = 0; i < taps; i += 8)
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            acc[k] += c[i + k] * x[i + k];
+        }
+    }
+
+    return ((acc[0] + acc[4]) + (acc[1] + acc[5]))
+           + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+}
+
+
+/* n outputs of a half-band stage for one lane, the first over the window
+ * starting at x.  Tap by tap over the whole run so the inner loop
+ * vectorizes; every output still sums its taps in the same order. */
+static void decim_halfband_run(const struct decim_fir *st, const float *x,
+                               size_t n, float *y)
+{
+    const float *centre = x + 2 * st->side - 1;
+    size_t j;
+
+    for (j = 0; j < n; j++)
+    {
+        y[j] = 0.5f * centre[2 * j];
+    }
+
+    for (int i = 0; i < st->side; i++)
+    {
+        const float c = st->coefs[i];
+        const float *early = centre - (2 * i + 1);
+        const float *late = centre + (2 * i + 1);
+
+        for (j = 0; j < n; j++)
+        {
+            y[j] += c * (early[2 * j] + late[2 * j]);
+        }
+    }
+}
+
+
+/* Run frames interleaved frames of lanes through a stage; all are used */
+static size_t decim_fir_process(struct decim_fir *st, int lanes,
+                                const float *in, size_t frames, float *out)
+{
+    size_t used = 0, made = 0;
+    int l;
+
+    for (;;)
+    {
+        size_t first, take, i;
+
+        while (st->pos < st->have)
+        {
+            const float *x = st->buf + st->pos - (st->taps - 1);
+            size_t n = (st->have - st->pos + st->factor - 1) / st->factor;
+
+            if (n > STREAM_DECIMATE_RUN)
+            {
+                n = STREAM_DECIMATE_RUN;
+            }
+
+            for (l = 0; l < lanes; l++)
+            {
+                const float *xl = x + l * st->cap;
+                float run[STREAM_DECIMATE_RUN];
+
+                if (st->side > 0)
+                {
+                    decim_halfband_run(st, xl, n, run);
+                }
+                else
+                {
+                    for (i = 0; i < n; i++)
+                    {
+                        run[i] = decim_dot(st->coefs, xl + i * st->factor, st->taps);
+                    }
+                }
+
+                for (i = 0; i < n; i++)
+                {
+                    out[(made + i) * lanes + l] = run[i];
+                }
+            }
+
+            made += n;
+            st->pos += n * st->factor;
+        }
+
+        // Drop the frames no later output reaches back to
+        first = st->pos - (st->taps - 1);
+
+        if (first > st->have)
+        {
+            first = st->have;
+        }
+
+        if (first > 0)
+        {
+            for (l = 0; l < lanes; l++)
+            {
+                float *b = st->buf + l * st->cap;
+                memmove(b, b + first, (st->have - first) * sizeof(float));
+            }
+
+            st->have -= first;
+            st->pos -= first;
+        }
+
+        if (used == frames)
+        {
+            break;
+        }
+
+        take = st->cap - st->have;
+
+        if (take > frames - used)
+        {
+            take = frames - used;
+        }
+
+        for (l = 0; l < lanes; l++)
+        {
+            const float *s = in + used * lanes + l;
+            float *b = st->buf + l * st->cap + st->have;
+
+            for (i = 0; i < take; i++)
+            {
+                b[i] = s[i * lanes];
+            }
+        }
+
+        st->have += take;
+        used += take;
+    }
+
+    return made;
+}
+
+
+/* Multiply every I/Q pair by the NCO's exp(-j theta).  The phase of each
+ * frame is the block's starting phasor times a precomputed rotation, so
+ * frames do not wait on each other; the starting phasor steps once per
+ * block, at fixed frame counts, so the chunking never shows. */
+static void decimate_mix(struct stream_decimator *d, const float *in,
+                         size_t frames, float *out)
+{
+    const int lanes = d->lanes;
+    size_t i = 0;
+
+    while (i < frames)
+    {
+        double c = d->nco_cos, s = d->nco_sin;
+        size_t n = STREAM_DECIMATE_BLOCK - d->nco_count;
+        const double *rot = d->nco_table + 2 * d->nco_count;
+
+        if (n > frames - i)
+        {
+            n = frames - i;
+        }
+
+        float *ph = d->nco_phase;
+
+        for (size_t k = 0; k < n; k++)
+        {
+            ph[2 * k] = (float)(c * rot[2 * k] - s * rot[2 * k + 1]);
+            ph[2 * k + 1] = (float)(s * rot[2 * k] + c * rot[2 * k + 1]);
+        }
+
+        for (int l = 0; l < lanes; l += 2)
+        {
+            const float *x = in + i * lanes + l;
+            float *y = out + i * lanes + l;
+
+            for (size_t k = 0; k < n; k++)
+            {
+                float re = x[k * lanes], im = x[k * lanes + 1];
+
+                y[k * lanes] = re * ph[2 * k] + im * ph[2 * k + 1];
+                y[k * lanes + 1] = im * ph[2 * k] - re * ph[2 * k + 1];
+            }
+        }
+
+        i += n;
+        d->nco_count += (int)n;
+
+        if (d->nco_count == STREAM_DECIMATE_BLOCK)
+        {
+            const double *step = d->nco_table + 2 * STREAM_DECIMATE_BLOCK;
+            double t = c * step[0] - s * step[1];
+            double g;
+
+            s = s * step[0] + c * step[1];
+            c = t;
+
+            // Pull the phasor back onto the unit circle
+            g = 1.5 - 0.5 * (c * c + s * s);
+            d->nco_cos = c * g;
+            d->nco_sin = s * g;
+            d->nco_count = 0;
+        }
+    }
+}
+
+
+/* Integrate lane by lane with the integrators held in locals.  All
+ * STREAM_DECIMATE_CIC_STAGES stages run whatever the order; a lower order
+ * reads its own last stage and ignores the rest. */
+static size_t decimate_cic(struct stream_decimator *d, const float *in,
+                           size_t frames, float *out)
+{
+    const float scale = (float)(1L << STREAM_DECIMATE_CIC_FRAC_BITS);
+    const int lanes = d->lanes, order = d->cic_order;
+    size_t made = 0;
+
+    for (int l = 0; l < lanes; l++)
+    {
+        uint64_t *integ = d->cic_integ + l * STREAM_DECIMATE_CIC_STAGES;
+        uint64_t *comb = d->cic_comb + l * STREAM_DECIMATE_CIC_STAGES;
+        uint64_t s0 = integ[0], s1 = integ[1], s2 = integ[2], s3 = integ[3];
+        uint64_t s4 = integ[4];
+        int count = d->cic_count;
+
+        made = 0;
+
+        for (size_t i = 0; i < frames; i++)
+        {
+            float v = in[i * lanes + l];
+
+            // NaN lands on the upper limit
+            v = v < STREAM_DECIMATE_CIC_LIMIT ? v : STREAM_DECIMATE_CIC_LIMIT;
+            v = v > -STREAM_DECIMATE_CIC_LIMIT ? v : -STREAM_DECIMATE_CIC_LIMIT;
+
+            s0 += (uint64_t)(int64_t)(v * scale);
+            s1 += s0;
+            s2 += s1;
+            s3 += s2;
+            s4 += s3;
+
+            if (count == 0)
+            {
+                uint64_t y = order == 5 ? s4 : s3;
+
+                for (int k = 0; k < order; k++)
+                {
+                    uint64_t prev = comb[k];
+
+                    comb[k] = y;
+                    y -= prev;
+                }
+
+                out[made * lanes + l] = (float)((double)(int64_t)y * d->cic_gain);
+                made++;
+            }
+
+            if (++count == d->cic)
+            {
+                count = 0;
+            }
+        }
+
+        integ[0] = s0;
+        integ[1] = s1;
+        integ[2] = s2;
+        integ[3] = s3;
+        integ[4] = s4;
+    }
+
+    d->cic_count = (int)((d->cic_count + frames) % d->cic);
+
+    return made;
+}
+
+
+int stream_decimator_init(struct stream_decimator **out, int in_rate,
+                          int factor, int channels, double shift_hz,
+                          int quality)
+{
+    struct stream_decimator *d;
+    double atten, beta, i0_beta, pass;
+    int j;
+
+    if (!out || in_rate <= 0 || factor <= 0 || channels <= 0
+            || !(fabs(shift_hz) < in_rate / 2.0))
+    {
+        return -1;
+    }
+
+    if (quality < RIG_RESAMPLE_BEST || quality > RIG_RESAMPLE_FAST)
+    {
+        quality = RIG_RESAMPLE_FAST;
+    }
+
+    d = calloc(1, sizeof(*d));
+
+    if (!d)
+    {
+        return -1;
+    }
+
+    d->lanes = 2 * channels;
+    d->factor = factor;
+    d->cic_order = decimate_quality[quality].cic_order;
+    decimate_split(factor, decimate_quality[quality].min_fir,
+                   (int)pow(2.0, (double)STREAM_DECIMATE_CIC_GROWTH_BITS
+                            / d->cic_order),
+                   &d->cic, &d->halfbands, &d->fir_factor);
+
+    d->scratch[0] = malloc(STREAM_DECIMATE_BLOCK * d->lanes * sizeof(float));
+    d->scratch[1] = malloc(STREAM_DECIMATE_BLOCK * d->lanes * sizeof(float));
+
+    if (!d->scratch[0] || !d->scratch[1])
+    {
+        stream_decimator_free(d);
+        return -1;
+    }
+
+    if (d->cic > 1)
+    {
+        d->cic_integ = calloc((size_t)STREAM_DECIMATE_CIC_STAGES * d->lanes,
+                              sizeof(uint64_t));
+        d->cic_comb = calloc((size_t)STREAM_DECIMATE_CIC_STAGES * d->lanes,
+                             sizeof(uint64_t));
+
+        if (!d->cic_integ || !d->cic_comb)
+        {
+            stream_decimator_free(d);
+            return -1;
+        }
+
+        d->cic_gain = 1.0 / (pow(d->cic, d->cic_order)
+                             * (double)(1L << STREAM_DECIMATE_CIC_FRAC_BITS));
+    }
+
+    atten = decimate_quality[quality].atten_db;
+    beta = atten > 50.0 ? 0.1102 * (atten - 8.7)
+           : 0.5842 * pow(atten - 21.0, 0.4) + 0.07886 * (atten - 21.0);
+    i0_beta = decimate_bessel_i0(beta);
+
+    // Passband edge in cycles per output sample
+    pass = decimate_quality[quality].pass * 0.5;
+
+    // Each half-band passes the output band at its own rate and stops what
+    // would alias onto it
+    for (j = 0; j < d->halfbands; j++)
+    {
+        double edge = pass / (d->fir_factor * (double)(1 << (d->halfbands - j)));
+        int taps = decimate_kaiser_taps(atten, 0.5 - 2.0 * edge);
+        int side = (taps + 4) / 4;
+        struct decim_fir *st = &d->fir[d->stages++];
+
+        if (decim_fir_init(st, 4 * side - 1, 2, side, d->lanes) != 0)
+        {
+            stream_decimator_free(d);
+            return -1;
+        }
+
+        decimate_design_halfband(st->coefs, side, beta, i0_beta);
+    }
+
+    // The final FIR stops at the output Nyquist frequency
+    if (d->fir_factor > 1)
+    {
+        double edge = pass / d->fir_factor;
+        double stop = 0.5 / d->fir_factor;
+        int taps = decimate_kaiser_taps(atten, stop - edge);
+        struct decim_fir *st = &d->fir[d->stages++];
+
+        taps = (taps + 7) & ~7;
+
+        if (taps > STREAM_DECIMATE_MAX_TAPS)
+        {
+            taps = STREAM_DECIMATE_MAX_TAPS;
+        }
+
+        if (decim_fir_init(st, taps, d->fir_factor, 0, d->lanes) != 0)
+        {
+            stream_decimator_free(d);
+            return -1;
+        }
+
+        decimate_design_fir(st->coefs, taps, (edge + stop) / 2.0, d->cic,
+                            d->cic_order, 1.0 / (1 << d->halfbands), beta,
+                            i0_beta);
+    }
+
+    if (shift_hz != 0.0)
+    {
+        double step = 2.0 * M_PI * shift_hz / in_rate;
+
+        d->shift = 1;
+        d->nco_table = malloc((STREAM_DECIMATE_BLOCK + 1) * 2 * sizeof(double));
+        d->nco_phase = malloc(STREAM_DECIMATE_BLOCK * 2 * sizeof(float));
+
+        if (!d->nco_table || !d->nco_phase)
+        {
+            stream_decimator_free(d);
+            return -1;
+        }
+
+        for (j = 0; j <= STREAM_DECIMATE_BLOCK; j++)
+        {
+            d->nco_table[2 * j] = cos(step * j);
+            d->nco_table[2 * j + 1] = sin(step * j);
+        }
+    }
+
+    stream_decimator_reset(d);
+
+    *out = d;
+    return 0;
+}
+
+
+void stream_decimator_free(struct stream_decimator *d)
+{
+    if (!d)
+    {
+        return;
+    }
+
+    for (int j = 0; j < d->stages; j++)
+    {
+        free(d->fir[j].coefs);
+        free(d->fir[j].buf);
+    }
+
+    free(d->cic_integ);
+    free(d->cic_comb);
+    free(d->nco_table);
+    free(d->nco_phase);
+    free(d->scratch[0]);
+    free(d->scratch[1]);
+    free(d);
+}
+
+
+void stream_decimator_reset(struct stream_decimator *d)
+{
+    if (d->cic > 1)
+    {
+        memset(d->cic_integ, 0,
+               (size_t)STREAM_DECIMATE_CIC_STAGES * d->lanes * sizeof(uint64_t));
+        memset(d->cic_comb, 0,
+               (size_t)STREAM_DECIMATE_CIC_STAGES * d->lanes * sizeof(uint64_t));
+    }
+
+    d->cic_count = 0;
+
+    for (int j = 0; j < d->stages; j++)
+    {
+        decim_fir_reset(&d->fir[j], d->lanes);
+    }
+
+    d->nco_cos = 1.0;
+    d->nco_sin = 0.0;
+    d->nco_count = 0;
+    d->in_total = 0;
+    d->out_total = 0;
+}
+
+
+void stream_decimator_plan(const struct stream_decimator *d, int *cic,
+                           int *halfbands, int *fir)
+{
+    *cic = d->cic;
+    *halfbands = d->halfbands;
+    *fir = d->fir_factor;
+}
+
+
+size_t stream_decimator_max_output(const struct stream_decimator *d,
+                                   size_t in_frames)
+{
+    uint64_t total = d->in_total + in_frames;
+
+    return (size_t)((total + d->factor - 1) / d->factor - d->out_total);
+}
+
+
+size_t stream_decimator_process(struct stream_decimator *d, const float *in,
+                                size_t in_frames, float *out)
+{
+    size_t made = 0;
+
+    d->in_total += in_frames;
+
+    while (in_frames > 0)
+    {
+        size_t n = in_frames < STREAM_DECIMATE_BLOCK ? in_frames
+                   : STREAM_DECIMATE_BLOCK;
+        size_t frames = n;
+        const float *cur = in;
+        int next = 0;
+
+        if (d->shift)
+        {
+            decimate_mix(d, cur, frames, d->scratch[next]);
+            cur = d->scratch[next];
+            next ^= 1;
+        }
+
+        if (d->cic > 1)
+        {
+            frames = decimate_cic(d, cur, frames, d->scratch[next]);
+            cur = d->scratch[next];
+            next ^= 1;
+        }
+
+        // The last stage writes straight to out
+        for (int j = 0; j < d->stages; j++)
+        {
+            float *dst = j == d->stages - 1 ? out + made * d->lanes
+                         : d->scratch[next];
+
+            frames = decim_fir_process(&d->fir[j], d->lanes, cur, frames, dst);
+            cur = dst;
+            next ^= 1;
+        }
+
+        if (d->stages == 0)
+        {
+            memcpy(out + made * d->lanes, cur, frames * d->lanes * sizeof(float));
+        }
+
+        made += frames;
+        in += n * d->lanes;
+        in_frames -= n;
+    }
+
+    d->out_total += made;
+    return made;
+}
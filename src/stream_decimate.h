@@ -0,0 +1,69 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Integer-ratio decimator for complex (I/Q) float streams.  An optional
+ * NCO first mixes the band at shift_hz down to DC; a CIC filter then takes
+ * the bulk of the factor at the input rate, half-band filters halve the
+ * rate a few times, and a final FIR decimates by the rest while flattening
+ * the CIC's passband droop.  Each stage runs at the lowest rate it can,
+ * so a narrow output from a wide native stream costs far less than the
+ * general polyphase resampler (stream_resample.h). */
+
+#ifndef HAMLIB_STREAM_DECIMATE_H
+#define HAMLIB_STREAM_DECIMATE_H
+
+#include <stddef.h>
+
+#define STREAM_DECIMATE_MAX_TAPS 4096    /* Final FIR length, for large odd factors */
+
+struct stream_decimator;
+
+/* A decimator by factor for interleaved frames of channels I/Q pairs at
+ * in_rate.  shift_hz, when non-zero, moves the signal at +shift_hz to DC
+ * before filtering; |shift_hz| must be below in_rate / 2.  quality is one
+ * of RIG_RESAMPLE_BEST, _MEDIUM or _FAST.  factor 1 only shifts.  Returns
+ * 0 and sets *out, or -1 on bad arguments or out of memory. */
+int stream_decimator_init(struct stream_decimator **out, int in_rate,
+                          int factor, int channels, double shift_hz,
+                          int quality);
+
+void stream_decimator_free(struct stream_decimator *d);
+
+/* Forget the history and restart the NCO, as after a gap in the input */
+void stream_decimator_reset(struct stream_decimator *d);
+
+/* The stages the factor was split into: CIC factor (1 = no CIC), number of
+ * half-band stages, and the final FIR's factor */
+void stream_decimator_plan(const struct stream_decimator *d, int *cic,
+                           int *halfbands, int *fir);
+
+/* Frames the next in_frames of input produce.  After N input frames in
+ * total a decimator has produced exactly ceil(N / factor) frames. */
+size_t stream_decimator_max_output(const struct stream_decimator *d,
+                                   size_t in_frames);
+
+/* Decimate in_frames frames from in to out, which must hold
+ * stream_decimator_max_output() frames.  All of the input is used.
+ * Returns the frames written. */
+size_t stream_decimator_process(struct stream_decimator *d, const float *in,
+                                size_t in_frames, float *out);
+
+#endif /* HAMLIB_STREAM_DECIMATE_H */
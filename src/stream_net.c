@@ -144,6 +144,11 @@ static ssize_t recv_from_server(struct rig_stream_net_session *sess,
     ssize_t n = recvfrom(sess->udp_sock, (char *)buf, buflen, 0,
                          (struct sockaddr *)&from, &from_len);
 
+    if (sess->stream)
+    {
+        udp_batch_stats_add(&sess->stream->link_io, n >= 0, 1, 0, 0);
+    }
+
     if (n <= 0)
     {
         return n;
@@ -262,6 +267,8 @@ static int send_control_packet(struct rig_stream_net_session *sess,
                           (struct sockaddr *)&sess->server_addr,
                           sess->server_addr_len);
 
+    udp_batch_stats_add(&stream->link_io, sent >= 0, 1, sent < 0, 0);
+
     if (sent != RIG_STREAM_HEADER_SIZE)
     {
         return -1;
@@ -493,6 +500,8 @@ int rig_stream_net_send_data(struct rig_stream_net_session *sess,
                           (struct sockaddr *)&sess->server_addr,
                           sess->server_addr_len);
 
+    udp_batch_stats_add(&stream->link_io, sent >= 0, 1, sent < 0, 0);
+
     if (sent != (ssize_t)total)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: sendto failed: sent %zd of %zu bytes\n",
@@ -811,6 +820,53 @@ static void maybe_keepalive(struct rig_stream_net_session *sess,
 }
 
 
+/* Receive what is waiting through queue and process each datagram from the
+ * server, dropping the rest as recv_from_server() does */
+static void receive_batch(struct rig_stream_net_session *sess,
+                          struct rig_stream *stream,
+                          struct udp_recv_queue *queue,
+                          struct udp_batch_stats *counted)
+{
+    struct udp_batch_stats now;
+    const unsigned char *pkt;
+    const void *from;
+    size_t n;
+
+    if (udp_recv_queue_fill(queue) < 0)
+    {
+        return;
+    }
+
+    udp_batch_stats_get(&queue->stats, &now);
+    udp_batch_stats_add(&stream->link_io, now.packets - counted->packets,
+                        now.syscalls - counted->syscalls, 0,
+                        now.offloaded - counted->offloaded);
+    *counted = now;
+
+    while ((pkt = udp_recv_queue_next(queue, &n, &from)) != NULL)
+    {
+        if (!rig_stream_net_source_ip_equal((const struct sockaddr *)from,
+                                            (struct sockaddr *)&sess->server_addr))
+        {
+            if (!sess->bad_source_logged)
+            {
+                rig_debug(RIG_DEBUG_WARN,
+                          "%s: dropping datagram(s) from unexpected source\n",
+                          __func__);
+                sess->bad_source_logged = 1;
+            }
+
+            continue;
+        }
+
+        if (n >= RIG_STREAM_HEADER_SIZE)
+        {
+            rig_stream_net_process_packet(sess, stream, pkt, n);
+        }
+    }
+}
+
+
 void *rig_stream_net_rx_thread(void *arg)
 {
     struct rig_stream *stream = (struct rig_stream *)arg;
@@ -818,6 +874,21 @@ void *rig_stream_net_rx_thread(void *arg)
         (struct rig_stream_net_session *)stream->backend_priv;
     /* Sized to the jumbo ceiling so a larger-MTU sender is not truncated. */
     unsigned char pkt[RIG_STREAM_MAX_DATAGRAM];
+    struct udp_recv_queue queue;
+    struct udp_batch_stats counted;
+    int batched = sess->batch_depth > 1
+                  && udp_recv_queue_init(&queue, sess->udp_sock,
+                                         sess->batch_depth,
+                                         RIG_STREAM_MAX_DATAGRAM, 1) == RIG_OK;
+
+    if (batched)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE,
+                  "%s: receiving up to %d datagrams per call, GRO %s\n",
+                  __func__, queue.depth, queue.gro ? "on" : "off");
+    }
+
+    memset(&counted, 0, sizeof(counted));
 
     while (sess->rx_running)
     {
@@ -828,6 +899,13 @@ void *rig_stream_net_rx_thread(void *arg)
             continue;
         }
 
+        if (batched)
+        {
+            receive_batch(sess, stream, &queue, &counted);
+            maybe_keepalive(sess, stream);
+            continue;
+        }
+
         ssize_t n = recv_from_server(sess, pkt, sizeof(pkt));
 
         if (n < RIG_STREAM_HEADER_SIZE)
@@ -841,6 +919,11 @@ void *rig_stream_net_rx_thread(void *arg)
         maybe_keepalive(sess, stream);
     }
 
+    if (batched)
+    {
+        udp_recv_queue_free(&queue);
+    }
+
     return NULL;
 }
 
@@ -91,6 +91,10 @@ struct rig_stream_net_session
     unsigned int transport_buffer_ms;
     unsigned int transport_buffer_bytes;
 
+    /* Datagrams the receive thread takes per system call (with GRO where
+     * the system has it); 1 receives them one at a time */
+    int batch_depth;
+
     /* Back-pointer for rx_thread access */
     struct rig_stream *stream;
 };
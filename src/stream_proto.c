@@ -899,6 +899,8 @@ static const struct
     { RIG_STREAM_CONV_FORMAT,   "FORMAT" },
     { RIG_STREAM_CONV_RATE,     "RATE" },
     { RIG_STREAM_CONV_CHANNELS, "CHANNELS" },
+    { RIG_STREAM_CONV_SHIFT,    "SHIFT" },
+    { RIG_STREAM_CONV_CODEC,    "CODEC" },
 };
 
 int stream_conversions_str(int conv, char *buf, size_t buflen)
@@ -139,6 +139,12 @@ size_t stream_transport_buffer_effective(unsigned int cfg_ms,
         unsigned int tok_ms, unsigned int tok_bytes,
         int sample_rate, int frame_bytes);
 
+
+/* Datagrams a stream sends or receives per system call (the
+ * stream_batch_depth conf token, 0 = this default); 1 is one at a time,
+ * without segmentation offload. */
+#define RIG_STREAM_BATCH_DEPTH_DEFAULT 16
+
 /* Apply a socket buffer size: which is SO_RCVBUF or SO_SNDBUF. Best-effort —
  * logs the requested and kernel-granted size (kernels clamp/double silently),
  * returns 0 on success, -1 if setsockopt failed. */
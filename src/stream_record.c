@@ -0,0 +1,1301 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Stream recorder: SigMF and WAV/RF64 files from an RX stream. */
+
+#ifdef HAVE_CONFIG_H
+#include "hamlib/config.h"
+#endif
+
+#include "stream_record.h"
+#include "stream.h"
+#include "json_writer.h"
+#include "sleep.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef WORDS_BIGENDIAN
+#define RECORD_BYTE_ORDER "_be"
+#else
+#define RECORD_BYTE_ORDER "_le"
+#endif
+
+#if defined(_WIN32)
+// gmtime_r can be defined by mingw
+#ifndef gmtime_r
+static struct tm *gmtime_r(const time_t *t, struct tm *r)
+{
+    // gmtime is threadsafe in windows because it uses TLS
+    const struct tm *theTm = gmtime(t);
+
+    if (theTm)
+    {
+        *r = *theTm;
+        return r;
+    }
+    else
+    {
+        return 0;
+    }
+}
+#endif // gmtime_r
+#endif // _WIN32
+
+
+/* The stream formats a recorder takes, and how each goes to file */
+struct record_format
+{
+    rig_stream_format_t format;
+    const char *sigmf;          /* core:datatype */
+    int bytes;                  /* Per sample of one component */
+    int iq;
+    rig_stream_format_t wav;    /* What WAV keeps it as: 8 bits unsigned */
+};
+
+static const struct record_format record_formats[] =
+{
+    { RIG_STREAM_FORMAT_PCM_S8,  "ri8",                      1, 0, RIG_STREAM_FORMAT_PCM_U8 },
+    { RIG_STREAM_FORMAT_PCM_U8,  "ru8",                      1, 0, RIG_STREAM_FORMAT_PCM_U8 },
+    { RIG_STREAM_FORMAT_PCM_S16, "ri16" RECORD_BYTE_ORDER,   2, 0, RIG_STREAM_FORMAT_PCM_S16 },
+    { RIG_STREAM_FORMAT_PCM_F32, "rf32" RECORD_BYTE_ORDER,   4, 0, RIG_STREAM_FORMAT_PCM_F32 },
+    { RIG_STREAM_FORMAT_IQ_CS8,  "ci8",                      1, 1, RIG_STREAM_FORMAT_IQ_CU8 },
+    { RIG_STREAM_FORMAT_IQ_CU8,  "cu8",                      1, 1, RIG_STREAM_FORMAT_IQ_CU8 },
+    { RIG_STREAM_FORMAT_IQ_CS16, "ci16" RECORD_BYTE_ORDER,   2, 1, RIG_STREAM_FORMAT_IQ_CS16 },
+    { RIG_STREAM_FORMAT_IQ_CF32, "cf32" RECORD_BYTE_ORDER,   4, 1, RIG_STREAM_FORMAT_IQ_CF32 },
+};
+
+
+static const struct record_format *record_format_find(rig_stream_format_t format)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(record_formats) / sizeof(record_formats[0]); i++)
+    {
+        if (record_formats[i].format == format)
+        {
+            return &record_formats[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+const char *stream_record_sigmf_datatype(rig_stream_format_t format)
+{
+    const struct record_format *f = record_format_find(format);
+
+    return f ? f->sigmf : NULL;
+}
+
+
+rig_stream_format_t stream_record_sigmf_format(const char *datatype)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(record_formats) / sizeof(record_formats[0]); i++)
+    {
+        if (strcmp(record_formats[i].sigmf, datatype) == 0)
+        {
+            return record_formats[i].format;
+        }
+    }
+
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------ */
+/* WAV / RF64 header                                                   */
+/* ------------------------------------------------------------------ */
+
+static void put_le16(unsigned char *p, uint16_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+
+static void put_le32(unsigned char *p, uint32_t v)
+{
+    put_le16(p, (uint16_t)v);
+    put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+
+static void put_le64(unsigned char *p, uint64_t v)
+{
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+
+/* Copy text into a fixed-size bext field, NUL padded, not terminated
+ * when it fills the field */
+static void put_text(unsigned char *p, size_t size, const char *text)
+{
+    size_t len = strlen(text);
+
+    memcpy(p, text, len < size ? len : size);
+}
+
+
+#define WAV_BEXT_SIZE 602               /* bext without coding history */
+
+/* Layout: RIFF, JUNK (ds64 in RF64), fmt, bext, JUNK padding and the data
+ * chunk header ending at STREAM_RECORD_WAV_HEADER, so the samples start
+ * on a page of their own and O_DIRECT writes stay aligned (EBU Tech 3285,
+ * 3306). */
+void stream_record_wav_header(unsigned char *hdr, rig_stream_format_t format,
+                              int channels, int sample_rate,
+                              uint64_t data_bytes,
+                              const struct stream_record_capture *first,
+                              const char *description)
+{
+    const struct record_format *f = record_format_find(format);
+    int is_float = format == RIG_STREAM_FORMAT_PCM_F32
+                   || format == RIG_STREAM_FORMAT_IQ_CF32;
+    int wav_channels = channels * (f && f->iq ? 2 : 1);
+    int bytes = f ? f->bytes : 2;
+    uint32_t block_align = (uint32_t)(wav_channels * bytes);
+    uint32_t fmt_size = is_float ? 18 : 16;
+    uint64_t riff_size = STREAM_RECORD_WAV_HEADER - 8 + data_bytes
+                         + (data_bytes & 1);
+    int rf64 = riff_size > 0xFFFFFFFFULL;
+    unsigned char *p, *bext;
+    char text[64];
+
+    memset(hdr, 0, STREAM_RECORD_WAV_HEADER);
+
+    memcpy(hdr, rf64 ? "RF64" : "RIFF", 4);
+    put_le32(hdr + 4, rf64 ? 0xFFFFFFFF : (uint32_t)riff_size);
+    memcpy(hdr + 8, "WAVE", 4);
+
+    memcpy(hdr + 12, rf64 ? "ds64" : "JUNK", 4);
+    put_le32(hdr + 16, 28);
+
+    if (rf64)
+    {
+        put_le64(hdr + 20, riff_size);
+        put_le64(hdr + 28, data_bytes);
+        put_le64(hdr + 36, data_bytes / block_align);
+    }
+
+    p = hdr + 48;
+    memcpy(p, "fmt ", 4);
+    put_le32(p + 4, fmt_size);
+    put_le16(p + 8, is_float ? 3 : 1);
+    put_le16(p + 10, (uint16_t)wav_channels);
+    put_le32(p + 12, (uint32_t)sample_rate);
+    put_le32(p + 16, (uint32_t)sample_rate * block_align);
+    put_le16(p + 20, (uint16_t)block_align);
+    put_le16(p + 22, (uint16_t)(bytes * 8));
+    p += 8 + fmt_size;
+
+    memcpy(p, "bext", 4);
+    put_le32(p + 4, WAV_BEXT_SIZE);
+    bext = p + 8;
+
+    if (description)
+    {
+        put_text(bext, 256, description);
+    }
+    else if (first && first->frequency > 0)
+    {
+        snprintf(text, sizeof(text), "Hamlib stream at %.0f Hz",
+                 first->frequency);
+        put_text(bext, 256, text);
+    }
+
+    put_text(bext + 256, 32, "Hamlib");
+
+    /* The time of the first sample, UTC, as date, time and samples since
+     * midnight */
+    if (first && first->time_valid)
+    {
+        time_t t = (time_t)first->seconds;
+        uint64_t since_midnight;
+        struct tm tm;
+
+        if (gmtime_r(&t, &tm))
+        {
+            snprintf(text, sizeof(text), "%04d-%02d-%02d", tm.tm_year + 1900,
+                     tm.tm_mon + 1, tm.tm_mday);
+            put_text(bext + 320, 10, text);
+            snprintf(text, sizeof(text), "%02d:%02d:%02d", tm.tm_hour,
+                     tm.tm_min, tm.tm_sec);
+            put_text(bext + 330, 8, text);
+
+            since_midnight = (uint64_t)(tm.tm_hour * 3600 + tm.tm_min * 60
+                                        + tm.tm_sec) * (uint64_t)sample_rate
+                             + (uint64_t)((double)first->picoseconds
+                                          * sample_rate / 1e12);
+            put_le64(bext + 338, since_midnight);
+        }
+    }
+
+    put_le16(bext + 346, 1);
+    p = bext + WAV_BEXT_SIZE;
+
+    memcpy(p, "JUNK", 4);
+    put_le32(p + 4, (uint32_t)(hdr + STREAM_RECORD_WAV_HEADER - 8 - (p + 8)));
+
+    p = hdr + STREAM_RECORD_WAV_HEADER - 8;
+    memcpy(p, "data", 4);
+    put_le32(p + 4, rf64 ? 0xFFFFFFFF : (uint32_t)data_bytes);
+}
+
+
+/* ------------------------------------------------------------------ */
+/* Writer thread                                                       */
+/* ------------------------------------------------------------------ */
+
+#ifdef O_DIRECT
+/* Go on through the page cache: for the short last block, and after a
+ * short write has left the file offset off a page boundary */
+static void record_direct_off(struct rig_stream_recorder *rec)
+{
+    int flags = fcntl(rec->fd, F_GETFL);
+
+    if (flags >= 0)
+    {
+        fcntl(rec->fd, F_SETFL, flags & ~O_DIRECT);
+    }
+
+    __atomic_store_n(&rec->direct_io, 0, __ATOMIC_RELAXED);
+}
+#endif
+
+
+static int record_write(struct rig_stream_recorder *rec,
+                        const unsigned char *buf, size_t len)
+{
+#ifdef O_DIRECT
+
+    if (rec->direct_io && len % STREAM_RECORD_ALIGN != 0)
+    {
+        record_direct_off(rec);
+    }
+
+#endif
+
+    while (len > 0)
+    {
+        ssize_t n = write(rec->fd, buf, len);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            rig_debug(RIG_DEBUG_ERR, "%s: writing %s failed: %s\n", __func__,
+                      rec->data_path, strerror(errno));
+            __atomic_add_fetch(&rec->write_errors, 1, __ATOMIC_RELAXED);
+            return -RIG_EIO;
+        }
+
+#ifdef O_DIRECT
+
+        if (rec->direct_io && (size_t)n < len)
+        {
+            record_direct_off(rec);
+        }
+
+#endif
+        buf += n;
+        len -= (size_t)n;
+        __atomic_add_fetch(&rec->file_bytes, (uint64_t)n, __ATOMIC_RELAXED);
+    }
+
+    return RIG_OK;
+}
+
+
+static void *record_write_thread(void *arg)
+{
+    struct rig_stream_recorder *rec = arg;
+
+    for (;;)
+    {
+        const unsigned char *block;
+        size_t len;
+
+        pthread_mutex_lock(&rec->lock);
+
+        while (rec->written == rec->filled && rec->draining)
+        {
+            pthread_cond_wait(&rec->block_filled, &rec->lock);
+        }
+
+        if (rec->written == rec->filled)
+        {
+            pthread_mutex_unlock(&rec->lock);
+            break;
+        }
+
+        block = rec->pool + (rec->written % rec->blocks) * rec->block_bytes;
+        len = rec->block_len[rec->written % rec->blocks];
+        pthread_mutex_unlock(&rec->lock);
+
+        /* After a failure the blocks are only given back: the file ends
+         * where the disk gave up */
+        if (!__atomic_load_n(&rec->write_errors, __ATOMIC_RELAXED))
+        {
+            record_write(rec, block, len);
+        }
+
+        pthread_mutex_lock(&rec->lock);
+        rec->written++;
+        pthread_cond_signal(&rec->block_written);
+        pthread_mutex_unlock(&rec->lock);
+    }
+
+    return NULL;
+}
+
+
+/* ------------------------------------------------------------------ */
+/* Drain thread                                                        */
+/* ------------------------------------------------------------------ */
+
+/* Give the full block to the writer and take the next one, waiting for
+ * the disk when every block is still waiting on it */
+static void drain_hand_over(struct rig_stream_recorder *rec)
+{
+    pthread_mutex_lock(&rec->lock);
+    rec->block_len[rec->filled % rec->blocks] = rec->fill;
+    rec->filled++;
+    pthread_cond_signal(&rec->block_filled);
+
+    if (rec->filled - rec->written >= rec->blocks)
+    {
+        __atomic_add_fetch(&rec->disk_waits, 1, __ATOMIC_RELAXED);
+
+        while (rec->filled - rec->written >= rec->blocks)
+        {
+            pthread_cond_wait(&rec->block_written, &rec->lock);
+        }
+    }
+
+    rec->block = rec->pool + (rec->filled % rec->blocks) * rec->block_bytes;
+    pthread_mutex_unlock(&rec->lock);
+    rec->fill = 0;
+}
+
+
+/* Add len bytes from src, or silence when src is NULL */
+static void drain_append(struct rig_stream_recorder *rec,
+                         const unsigned char *src, size_t len)
+{
+    int silence = rec->format == RIG_STREAM_FORMAT_PCM_U8
+                  || rec->format == RIG_STREAM_FORMAT_IQ_CU8 ? 0x80 : 0;
+
+    while (len > 0)
+    {
+        size_t n = rec->block_bytes - rec->fill;
+
+        n = n < len ? n : len;
+
+        if (src)
+        {
+            memcpy(rec->block + rec->fill, src, n);
+            src += n;
+        }
+        else
+        {
+            memset(rec->block + rec->fill, silence, n);
+        }
+
+        rec->fill += n;
+        len -= n;
+
+        if (rec->fill == rec->block_bytes)
+        {
+            drain_hand_over(rec);
+        }
+    }
+}
+
+
+/* Start a capture segment at frame sample_start of the file, or restate
+ * the one that already starts there */
+static void record_capture(struct rig_stream_recorder *rec,
+                           uint64_t sample_start,
+                           const struct rig_stream_read_info *info)
+{
+    struct stream_record_capture *c;
+
+    if (rec->capture_count > 0
+            && rec->captures[rec->capture_count - 1].sample_start == sample_start)
+    {
+        c = &rec->captures[rec->capture_count - 1];
+    }
+    else
+    {
+        if (rec->capture_count == rec->capture_size)
+        {
+            int size = rec->capture_size ? rec->capture_size * 2 : 16;
+            void *p = realloc(rec->captures, size * sizeof(*rec->captures));
+
+            if (!p)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: out of memory, capture at %llu "
+                          "not kept\n", __func__,
+                          (unsigned long long)sample_start);
+                return;
+            }
+
+            rec->captures = p;
+            rec->capture_size = size;
+        }
+
+        c = &rec->captures[rec->capture_count];
+        __atomic_store_n(&rec->capture_count, rec->capture_count + 1,
+                         __ATOMIC_RELAXED);
+    }
+
+    c->sample_start = sample_start;
+    c->global_index = info->sample_index;
+    c->frequency = rec->frequency;
+    c->time_valid = info->time_valid;
+    c->seconds = info->seconds;
+    c->picoseconds = info->picoseconds;
+}
+
+
+static void record_gap(struct rig_stream_recorder *rec, uint64_t sample_start,
+                       const struct rig_stream_read_info *info)
+{
+    if (rec->gap_count == rec->gap_size)
+    {
+        int size = rec->gap_size ? rec->gap_size * 2 : 16;
+        void *p = realloc(rec->gaps, size * sizeof(*rec->gaps));
+
+        if (!p)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: out of memory, gap at %llu not "
+                      "kept\n", __func__, (unsigned long long)sample_start);
+            return;
+        }
+
+        rec->gaps = p;
+        rec->gap_size = size;
+    }
+
+    rec->gaps[rec->gap_count].sample_start = sample_start;
+    rec->gaps[rec->gap_count].dropped_samples = info->dropped_samples;
+    rec->gaps[rec->gap_count].drop_flags = info->drop_flags;
+    __atomic_store_n(&rec->gap_count, rec->gap_count + 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&rec->dropped_samples, info->dropped_samples,
+                       __ATOMIC_RELAXED);
+}
+
+
+/* The RF frequency the stream's samples are at now: the I/Q window's
+ * centre, or the dial for audio */
+static double record_frequency(struct rig_stream_recorder *rec)
+{
+    struct rig_stream_metadata meta;
+
+    memset(&meta, 0, sizeof(meta));
+
+    if (rig_stream_read_metadata(rec->rig, rec->stream, &meta) != RIG_OK)
+    {
+        return rec->frequency;
+    }
+
+    if (meta.field_mask & RIG_STREAM_META_CENTER_FREQ)
+    {
+        return meta.center_freq;
+    }
+
+    if (meta.field_mask & RIG_STREAM_META_VFO_FREQ)
+    {
+        return meta.vfo_freq;
+    }
+
+    return rec->frequency;
+}
+
+
+#ifdef WORDS_BIGENDIAN
+/* WAV samples are little-endian */
+static void record_swap(unsigned char *p, size_t len, int bytes)
+{
+    size_t i;
+
+    for (i = 0; i + bytes <= len; i += bytes)
+    {
+        unsigned char t = p[i];
+
+        if (bytes == 2)
+        {
+            p[i] = p[i + 1];
+            p[i + 1] = t;
+        }
+        else if (bytes == 4)
+        {
+            p[i] = p[i + 3];
+            p[i + 3] = t;
+            t = p[i + 1];
+            p[i + 1] = p[i + 2];
+            p[i + 2] = t;
+        }
+    }
+}
+#endif
+
+
+/* n bytes just read into the block at fill, with their info */
+static void drain_read(struct rig_stream_recorder *rec,
+                       const struct rig_stream_read_info *info, size_t n)
+{
+    int gap = rec->started
+              && (info->dropped_samples > 0
+                  || (info->drop_flags & RIG_STREAM_DROP_UNSIZED));
+    int new_capture = !rec->started || gap;
+    uint64_t start;
+
+#ifdef WORDS_BIGENDIAN
+
+    if (rec->container == RIG_STREAM_RECORD_WAV)
+    {
+        record_swap(rec->block + rec->fill, n,
+                    record_format_find(rec->format)->bytes);
+    }
+
+#endif
+
+    if (gap)
+    {
+        record_gap(rec, rec->samples, info);
+    }
+
+    if (gap && rec->container == RIG_STREAM_RECORD_WAV
+            && info->dropped_samples > 0)
+    {
+        /* The samples went in where the gap's silence belongs: move them
+         * behind it */
+        memcpy(rec->scratch, rec->block + rec->fill, n);
+        drain_append(rec, NULL,
+                     (size_t)info->dropped_samples * (size_t)rec->frame_bytes);
+        __atomic_add_fetch(&rec->samples, info->dropped_samples,
+                           __ATOMIC_RELAXED);
+        start = rec->samples;
+        drain_append(rec, rec->scratch, n);
+    }
+    else
+    {
+        start = rec->samples;
+        rec->fill += n;
+
+        if (rec->fill == rec->block_bytes)
+        {
+            drain_hand_over(rec);
+        }
+    }
+
+    if (new_capture || start >= rec->next_meta_poll)
+    {
+        double frequency = record_frequency(rec);
+
+        if (frequency != rec->frequency)
+        {
+            rec->frequency = frequency;
+            new_capture = 1;
+        }
+
+        rec->next_meta_poll = start + (uint64_t)rec->sample_rate
+                              * STREAM_RECORD_POLL_MS / 1000;
+    }
+
+    if (new_capture)
+    {
+        record_capture(rec, start, info);
+    }
+
+    __atomic_add_fetch(&rec->samples, n / (size_t)rec->frame_bytes,
+                       __ATOMIC_RELAXED);
+    rec->started = 1;
+}
+
+
+static void *record_drain_thread(void *arg)
+{
+    struct rig_stream_recorder *rec = arg;
+
+    while (rec->running)
+    {
+        struct rig_stream_read_info info;
+        size_t n = 0;
+        int ret = rig_stream_reader_read(rec->rig, rec->reader,
+                                         rec->block + rec->fill,
+                                         rec->block_bytes - rec->fill, &n,
+                                         STREAM_RECORD_POLL_MS, &info);
+
+        if (ret == -RIG_ETIMEOUT)
+        {
+            /* A paused stream answers at once */
+            if (rec->stream->paused)
+            {
+                hl_usleep(STREAM_RECORD_POLL_MS * 1000);
+            }
+
+            continue;
+        }
+
+        if (ret != RIG_OK)
+        {
+            break;              /* The stream is closing */
+        }
+
+        if (n > 0)
+        {
+            drain_read(rec, &info, n);
+        }
+    }
+
+    /* The last block, however full */
+    pthread_mutex_lock(&rec->lock);
+
+    if (rec->fill > 0)
+    {
+        rec->block_len[rec->filled % rec->blocks] = rec->fill;
+        rec->filled++;
+    }
+
+    rec->draining = 0;
+    pthread_cond_signal(&rec->block_filled);
+    pthread_mutex_unlock(&rec->lock);
+
+    return NULL;
+}
+
+
+/* ------------------------------------------------------------------ */
+/* SigMF metadata                                                      */
+/* ------------------------------------------------------------------ */
+
+/* ISO 8601 UTC with nanoseconds, as SigMF core:datetime wants */
+static int record_datetime(char *buf, size_t size, int64_t seconds,
+                           uint64_t picoseconds)
+{
+    time_t t = (time_t)seconds;
+    struct tm tm;
+
+    if (!gmtime_r(&t, &tm))
+    {
+        return -RIG_EINVAL;
+    }
+
+    snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d.%09lluZ",
+             tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour,
+             tm.tm_min, tm.tm_sec, (unsigned long long)(picoseconds / 1000));
+    return RIG_OK;
+}
+
+
+static void record_gap_comment(char *buf, size_t size,
+                               const struct stream_record_gap *gap)
+{
+    const char *cause = (gap->drop_flags & RIG_STREAM_DROP_OVERRUN)
+                        ? "overrun"
+                        : (gap->drop_flags & RIG_STREAM_DROP_LINK)
+                        ? "network loss" : "gap at the radio";
+
+    snprintf(buf, size, "%s%llu samples dropped (%s)",
+             (gap->drop_flags & RIG_STREAM_DROP_UNSIZED) ? "at least " : "",
+             (unsigned long long)gap->dropped_samples, cause);
+}
+
+
+#define SIGMF_META_FIXED 2048           /* global, and the brackets */
+#define SIGMF_META_ENTRY 256            /* Per capture or annotation */
+
+static int record_write_sigmf_meta(struct rig_stream_recorder *rec)
+{
+    size_t size = SIGMF_META_FIXED + SIGMF_META_ENTRY
+                  * (size_t)(rec->capture_count + rec->gap_count);
+    char *json = malloc(size);
+    struct json_writer w;
+    char text[128];
+    FILE *f;
+    int i, len, ret = RIG_OK;
+
+    if (!json)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    json_writer_init(&w, json, size);
+    json_write_begin_object(&w, NULL);
+
+    json_write_begin_object(&w, "global");
+    json_write_string(&w, "core:datatype",
+                      stream_record_sigmf_datatype(rec->format));
+    json_write_number(&w, "core:sample_rate", rec->sample_rate);
+    json_write_string(&w, "core:version", "1.0.0");
+    json_write_number(&w, "core:num_channels", rec->channels);
+    json_write_string(&w, "core:recorder", hamlib_version);
+    snprintf(text, sizeof(text), "%s %s", rec->rig->caps->mfg_name,
+             rec->rig->caps->model_name);
+    json_write_string(&w, "core:hw", text);
+
+    if (rec->description)
+    {
+        json_write_string(&w, "core:description", rec->description);
+    }
+
+    json_write_end_object(&w);
+
+    json_write_begin_array(&w, "captures");
+
+    for (i = 0; i < rec->capture_count; i++)
+    {
+        const struct stream_record_capture *c = &rec->captures[i];
+
+        json_write_begin_object(&w, NULL);
+        json_write_number(&w, "core:sample_start", (double)c->sample_start);
+        json_write_number(&w, "core:global_index", (double)c->global_index);
+
+        if (c->frequency > 0)
+        {
+            json_write_number(&w, "core:frequency", c->frequency);
+        }
+
+        if (c->time_valid && record_datetime(text, sizeof(text), c->seconds,
+                                             c->picoseconds) == RIG_OK)
+        {
+            json_write_string(&w, "core:datetime", text);
+        }
+
+        json_write_end_object(&w);
+    }
+
+    json_write_end_array(&w);
+
+    json_write_begin_array(&w, "annotations");
+
+    for (i = 0; i < rec->gap_count; i++)
+    {
+        json_write_begin_object(&w, NULL);
+        json_write_number(&w, "core:sample_start",
+                          (double)rec->gaps[i].sample_start);
+        json_write_string(&w, "core:label", "gap");
+        record_gap_comment(text, sizeof(text), &rec->gaps[i]);
+        json_write_string(&w, "core:comment", text);
+        json_write_end_object(&w);
+    }
+
+    json_write_end_array(&w);
+    json_write_end_object(&w);
+    len = json_writer_finish(&w);
+
+    f = len < 0 ? NULL : fopen(rec->meta_path, "w");
+
+    if (!f)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot create %s: %s\n", __func__,
+                  rec->meta_path, len < 0 ? "metadata too long"
+                  : strerror(errno));
+        free(json);
+        return -RIG_EIO;
+    }
+
+    if (fwrite(json, 1, (size_t)len, f) != (size_t)len || fputc('\n', f) == EOF)
+    {
+        ret = -RIG_EIO;
+    }
+
+    if (fclose(f) != 0 || ret != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: writing %s failed: %s\n", __func__,
+                  rec->meta_path, strerror(errno));
+        ret = -RIG_EIO;
+    }
+
+    free(json);
+    return ret;
+}
+
+
+/* ------------------------------------------------------------------ */
+/* Open / close                                                        */
+/* ------------------------------------------------------------------ */
+
+static void record_free(struct rig_stream_recorder *rec)
+{
+    if (rec->threads)
+    {
+        pthread_mutex_destroy(&rec->lock);
+        pthread_cond_destroy(&rec->block_filled);
+        pthread_cond_destroy(&rec->block_written);
+    }
+
+    if (rec->fd >= 0)
+    {
+        close(rec->fd);
+    }
+
+    free(rec->pool_alloc);
+    free(rec->block_len);
+    free(rec->scratch);
+    free(rec->data_path);
+    free(rec->meta_path);
+    free(rec->description);
+    free(rec->captures);
+    free(rec->gaps);
+    free(rec);
+}
+
+
+/* Complete the files: the WAV header with the final sizes, the SigMF
+ * metadata */
+static int record_finalize(struct rig_stream_recorder *rec)
+{
+    int ret = __atomic_load_n(&rec->write_errors, __ATOMIC_RELAXED)
+              ? -RIG_EIO : RIG_OK;
+
+#ifdef O_DIRECT
+
+    if (rec->direct_io)
+    {
+        record_direct_off(rec);
+    }
+
+#endif
+
+    if (rec->container == RIG_STREAM_RECORD_WAV)
+    {
+        static const unsigned char pad = 0;
+        unsigned char hdr[STREAM_RECORD_WAV_HEADER];
+        uint64_t data_bytes = rec->file_bytes > STREAM_RECORD_WAV_HEADER
+                              ? rec->file_bytes - STREAM_RECORD_WAV_HEADER : 0;
+
+        /* A chunk of odd length is followed by a pad byte */
+        if (ret == RIG_OK && (data_bytes & 1))
+        {
+            ret = record_write(rec, &pad, 1);
+        }
+
+        stream_record_wav_header(hdr, rec->format, rec->channels,
+                                 rec->sample_rate, data_bytes,
+                                 rec->capture_count ? &rec->captures[0] : NULL,
+                                 rec->description);
+
+        if (lseek(rec->fd, 0, SEEK_SET) != 0
+                || write(rec->fd, hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr))
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: writing the header of %s failed: "
+                      "%s\n", __func__, rec->data_path, strerror(errno));
+            ret = -RIG_EIO;
+        }
+    }
+
+    if (close(rec->fd) != 0)
+    {
+        ret = -RIG_EIO;
+    }
+
+    rec->fd = -1;
+
+    if (rec->container == RIG_STREAM_RECORD_SIGMF
+            && record_write_sigmf_meta(rec) != RIG_OK)
+    {
+        ret = -RIG_EIO;
+    }
+
+    return ret;
+}
+
+
+int stream_recorder_finish(struct rig_stream_recorder *rec)
+{
+    int ret;
+
+    rec->running = 0;
+
+    if (rec->threads)
+    {
+        pthread_join(rec->drain_thread, NULL);
+        pthread_join(rec->write_thread, NULL);
+    }
+
+    ret = record_finalize(rec);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s: %llu samples, %llu bytes, %d gaps, "
+              "%d captures, %u disk waits\n", __func__, rec->data_path,
+              (unsigned long long)rec->samples,
+              (unsigned long long)rec->file_bytes, rec->gap_count,
+              rec->capture_count, rec->disk_waits);
+
+    record_free(rec);
+    return ret;
+}
+
+
+static int record_open_file(struct rig_stream_recorder *rec, int direct)
+{
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+
+#ifdef O_BINARY
+    flags |= O_BINARY;
+#endif
+#ifdef O_DIRECT
+
+    if (direct)
+    {
+        rec->fd = open(rec->data_path, flags | O_DIRECT, 0644);
+
+        if (rec->fd >= 0)
+        {
+            rec->direct_io = 1;
+            return RIG_OK;
+        }
+
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: no O_DIRECT for %s (%s), writing "
+                  "through the page cache\n", __func__, rec->data_path,
+                  strerror(errno));
+    }
+
+#else
+    (void)direct;
+#endif
+
+    rec->fd = open(rec->data_path, flags, 0644);
+
+    if (rec->fd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot create %s: %s\n", __func__,
+                  rec->data_path, strerror(errno));
+        return -RIG_EIO;
+    }
+
+    return RIG_OK;
+}
+
+
+static char *record_path(const char *path, const char *suffix)
+{
+    size_t len = strlen(path) + strlen(suffix) + 1;
+    char *p = malloc(len);
+
+    if (p)
+    {
+        snprintf(p, len, "%s%s", path, suffix);
+    }
+
+    return p;
+}
+
+
+static size_t gcd(size_t a, size_t b)
+{
+    while (b)
+    {
+        size_t t = a % b;
+
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+
+/* Blocks, buffers and files for config; the threads are not started */
+static int record_setup(struct rig_stream_recorder *rec,
+                        const struct rig_stream_record_config *config)
+{
+    size_t unit = STREAM_RECORD_ALIGN / gcd(STREAM_RECORD_ALIGN,
+                                            (size_t)rec->frame_bytes)
+                  * (size_t)rec->frame_bytes;
+    size_t want = config->block_bytes ? config->block_bytes
+                  : STREAM_RECORD_BLOCK_DEFAULT;
+
+    /* Whole pages of whole frames */
+    want = want < STREAM_RECORD_BLOCK_MAX ? want : STREAM_RECORD_BLOCK_MAX;
+    rec->block_bytes = (want + unit - 1) / unit * unit;
+    rec->blocks = config->blocks ? config->blocks : STREAM_RECORD_BLOCKS_DEFAULT;
+    rec->blocks = rec->blocks < STREAM_RECORD_BLOCKS_MIN
+                  ? STREAM_RECORD_BLOCKS_MIN
+                  : rec->blocks > STREAM_RECORD_BLOCKS_MAX
+                  ? STREAM_RECORD_BLOCKS_MAX : rec->blocks;
+
+    rec->pool_alloc = malloc(rec->blocks * rec->block_bytes
+                             + STREAM_RECORD_ALIGN);
+    rec->block_len = calloc(rec->blocks, sizeof(*rec->block_len));
+
+    if (!rec->pool_alloc || !rec->block_len)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    rec->pool = (unsigned char *)(((uintptr_t)rec->pool_alloc
+                                   + STREAM_RECORD_ALIGN - 1)
+                                  & ~(uintptr_t)(STREAM_RECORD_ALIGN - 1));
+    rec->block = rec->pool;
+
+    if (rec->container == RIG_STREAM_RECORD_WAV)
+    {
+        rec->scratch = malloc(rec->block_bytes);
+        rec->data_path = strdup(config->path);
+    }
+    else
+    {
+        rec->data_path = record_path(config->path, ".sigmf-data");
+        rec->meta_path = record_path(config->path, ".sigmf-meta");
+    }
+
+    if (config->description)
+    {
+        rec->description = strdup(config->description);
+    }
+
+    if (!rec->data_path
+            || (rec->container == RIG_STREAM_RECORD_WAV && !rec->scratch)
+            || (rec->container == RIG_STREAM_RECORD_SIGMF && !rec->meta_path)
+            || (config->description && !rec->description))
+    {
+        return -RIG_ENOMEM;
+    }
+
+    if (record_open_file(rec, config->direct_io) != RIG_OK)
+    {
+        return -RIG_EIO;
+    }
+
+    /* The header goes first, from an aligned block, and again with the
+     * sizes at the close */
+    if (rec->container == RIG_STREAM_RECORD_WAV)
+    {
+        stream_record_wav_header(rec->pool, rec->format, rec->channels,
+                                 rec->sample_rate, 0, NULL, rec->description);
+
+        if (record_write(rec, rec->pool, STREAM_RECORD_WAV_HEADER) != RIG_OK)
+        {
+            return -RIG_EIO;
+        }
+    }
+
+    return RIG_OK;
+}
+
+
+int HAMLIB_API rig_stream_recorder_open(RIG *rig,
+                                        rig_stream_t *stream,
+                                        const struct rig_stream_record_config *config,
+                                        rig_stream_recorder_t **recorder)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!rig || !stream || !config || !config->path || !recorder)
+    {
+        return -RIG_EINVAL;
+    }
+
+    *recorder = NULL;
+
+    if (config->container != RIG_STREAM_RECORD_SIGMF
+            && config->container != RIG_STREAM_RECORD_WAV)
+    {
+        return -RIG_EINVAL;
+    }
+
+    const struct record_format *f = record_format_find(stream->config.format);
+    struct rig_stream_recorder *rec;
+    int ret;
+
+    if (!f)
+    {
+        return stream->is_codec ? -RIG_ENIMPL : -RIG_EINVAL;
+    }
+
+    rec = calloc(1, sizeof(*rec));
+
+    if (!rec)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    rec->fd = -1;
+    rec->rig = rig;
+    rec->stream = stream;
+    rec->container = config->container;
+    rec->format = config->container == RIG_STREAM_RECORD_WAV ? f->wav
+                  : f->format;
+    rec->channels = stream->config.channels;
+    rec->sample_rate = stream->config.sample_rate;
+
+    /* A reader of its own, converting only to what WAV can hold */
+    if (rec->format != stream->config.format)
+    {
+        struct rig_stream_config *reader_config = rig_stream_config_alloc();
+
+        if (!reader_config)
+        {
+            free(rec);
+            return -RIG_ENOMEM;
+        }
+
+        reader_config->format = rec->format;
+        reader_config->channels = rec->channels;
+        ret = rig_stream_reader_open(rig, stream, reader_config, &rec->reader);
+        rig_stream_config_free(reader_config);
+    }
+    else
+    {
+        ret = rig_stream_reader_open(rig, stream, NULL, &rec->reader);
+    }
+
+    if (ret != RIG_OK)
+    {
+        free(rec);
+        return ret;
+    }
+
+    rec->frame_bytes = rec->reader->frame_bytes;
+    ret = record_setup(rec, config);
+
+    if (ret == RIG_OK)
+    {
+        pthread_mutex_init(&rec->lock, NULL);
+        pthread_cond_init(&rec->block_filled, NULL);
+        pthread_cond_init(&rec->block_written, NULL);
+        rec->running = 1;
+        rec->draining = 1;
+        ret = stream_recorder_attach(rig, rec);
+    }
+
+    if (ret == RIG_OK)
+    {
+        if (pthread_create(&rec->write_thread, NULL, record_write_thread,
+                           rec) != 0)
+        {
+            ret = -RIG_ENOMEM;
+        }
+        else if (pthread_create(&rec->drain_thread, NULL, record_drain_thread,
+                                rec) != 0)
+        {
+            /* Let the writer find nothing to write */
+            pthread_mutex_lock(&rec->lock);
+            rec->draining = 0;
+            pthread_cond_signal(&rec->block_filled);
+            pthread_mutex_unlock(&rec->lock);
+            pthread_join(rec->write_thread, NULL);
+            ret = -RIG_ENOMEM;
+        }
+
+        if (ret != RIG_OK)
+        {
+            stream_recorder_detach(rig, rec);
+        }
+    }
+
+    if (ret != RIG_OK)
+    {
+        rig_stream_reader_close(rig, rec->reader);
+
+        if (rec->running)
+        {
+            pthread_mutex_destroy(&rec->lock);
+            pthread_cond_destroy(&rec->block_filled);
+            pthread_cond_destroy(&rec->block_written);
+        }
+
+        record_free(rec);
+        return ret;
+    }
+
+    rec->threads = 1;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: recording stream %d to %s, %u blocks "
+              "of %lu bytes%s\n", __func__, stream->id, rec->data_path,
+              rec->blocks, (unsigned long)rec->block_bytes,
+              rec->direct_io ? ", O_DIRECT" : "");
+
+    *recorder = rec;
+    return RIG_OK;
+}
+
+
+int HAMLIB_API rig_stream_recorder_get_stats(RIG *rig,
+                                             rig_stream_recorder_t *recorder,
+                                             struct rig_stream_record_stats *stats)
+{
+    if (!rig || !recorder || !stats)
+    {
+        return -RIG_EINVAL;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+    stats->samples = __atomic_load_n(&recorder->samples, __ATOMIC_RELAXED);
+    stats->bytes_written = __atomic_load_n(&recorder->file_bytes,
+                                           __ATOMIC_RELAXED);
+    stats->dropped_samples = __atomic_load_n(&recorder->dropped_samples,
+                                             __ATOMIC_RELAXED);
+    stats->gaps = (uint32_t)__atomic_load_n(&recorder->gap_count,
+                                            __ATOMIC_RELAXED);
+    stats->captures = (uint32_t)__atomic_load_n(&recorder->capture_count,
+                                                __ATOMIC_RELAXED);
+    stats->disk_waits = __atomic_load_n(&recorder->disk_waits,
+                                        __ATOMIC_RELAXED);
+    stats->write_errors = __atomic_load_n(&recorder->write_errors,
+                                          __ATOMIC_RELAXED);
+    stats->direct_io = __atomic_load_n(&recorder->direct_io, __ATOMIC_RELAXED);
+
+    return RIG_OK;
+}
+
+
+int HAMLIB_API rig_stream_recorder_close(RIG *rig,
+                                         rig_stream_recorder_t *recorder)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!rig || !recorder)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (stream_recorder_detach(rig, recorder) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    /* Stop reading before the reader goes */
+    recorder->running = 0;
+    pthread_join(recorder->drain_thread, NULL);
+    pthread_join(recorder->write_thread, NULL);
+    recorder->threads = 0;
+    rig_stream_reader_close(rig, recorder->reader);
+
+    return stream_recorder_finish(recorder);
+}
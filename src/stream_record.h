@@ -0,0 +1,149 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Stream recorder (rig_stream_recorder_open()): a broadcast reader of an RX
+ * stream drained by a thread of its own into large page-aligned blocks,
+ * which a writer thread puts on disk in order.  Neither the stream's
+ * producer nor its consumer waits for the disk; when every block is
+ * waiting on it, the recorder's reader falls behind and is eventually
+ * lapped, which the recording shows as a gap. */
+
+#ifndef HAMLIB_STREAM_RECORD_H
+#define HAMLIB_STREAM_RECORD_H
+
+#include <hamlib/rig.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define STREAM_RECORD_ALIGN 4096            /* O_DIRECT offsets and sizes */
+#define STREAM_RECORD_BLOCK_DEFAULT (1024 * 1024)
+#define STREAM_RECORD_BLOCK_MAX (64 * 1024 * 1024)
+#define STREAM_RECORD_BLOCKS_DEFAULT 8
+#define STREAM_RECORD_BLOCKS_MIN 2
+#define STREAM_RECORD_BLOCKS_MAX 256
+#define STREAM_RECORD_WAV_HEADER STREAM_RECORD_ALIGN /* Samples start here */
+#define STREAM_RECORD_POLL_MS 100           /* Read wait, and metadata poll
+                                               interval in ms of samples */
+
+/* Where a SigMF capture segment starts, and what holds from there on */
+struct stream_record_capture
+{
+    uint64_t sample_start;      /* Frame in the file */
+    uint64_t global_index;      /* Stream sample index of that frame */
+    double frequency;           /* Hz, 0 = unknown */
+    int time_valid;             /* seconds/picoseconds are the time of
+                                   the frame */
+    int64_t seconds;
+    uint64_t picoseconds;
+};
+
+/* Samples the stream lost before a frame of the file */
+struct stream_record_gap
+{
+    uint64_t sample_start;
+    uint64_t dropped_samples;
+    uint8_t drop_flags;         /* RIG_STREAM_DROP_* */
+};
+
+struct rig_stream_recorder
+{
+    RIG *rig;
+    struct rig_stream *stream;
+    struct rig_stream_recorder *next;   /* In stream->recorders */
+    rig_stream_reader_t *reader;
+    int container;                      /* RIG_STREAM_RECORD_* */
+    rig_stream_format_t format;         /* What the file holds */
+    int channels;
+    int sample_rate;
+    int frame_bytes;
+    char *data_path;
+    char *meta_path;                    /* SigMF metadata, NULL for WAV */
+    char *description;
+    int fd;
+    uint64_t file_bytes;                /* Written to fd, header included */
+
+    /* Blocks between the two threads: the drain thread fills block
+     * filled % blocks while fewer than blocks are waiting, the writer
+     * writes block written % blocks (protected by lock) */
+    pthread_mutex_t lock;
+    pthread_cond_t block_filled;
+    pthread_cond_t block_written;
+    void *pool_alloc;
+    unsigned char *pool;                /* blocks of block_bytes, aligned */
+    size_t block_bytes;                 /* Whole pages and whole frames */
+    unsigned int blocks;
+    size_t *block_len;
+    uint64_t filled;
+    uint64_t written;
+    int draining;                       /* 0 once the drain thread handed
+                                           over its last block */
+    HAMLIB_ATOMIC int running;
+    int threads;                        /* 1 while the threads exist */
+    pthread_t drain_thread;
+    pthread_t write_thread;
+
+    /* Drain thread only, then the close */
+    unsigned char *block;               /* Being filled */
+    size_t fill;
+    unsigned char *scratch;             /* WAV: a read moved behind the
+                                           silence of its gap */
+    int started;                        /* 1 after the first samples */
+    double frequency;                   /* Of the capture in progress */
+    uint64_t next_meta_poll;            /* In frames of the file */
+    struct stream_record_capture *captures;
+    int capture_count;
+    int capture_size;
+    struct stream_record_gap *gaps;
+    int gap_count;
+    int gap_size;
+
+    /* Counters for rig_stream_recorder_get_stats() (atomic) */
+    uint64_t samples;
+    uint64_t dropped_samples;
+    uint32_t disk_waits;
+    uint32_t write_errors;
+    int direct_io;
+};
+
+/* Stop rec, put the samples it holds on disk, finish its files and free
+ * it; its reader is left to the stream.  For the stream's teardown, once
+ * no thread can read the stream any more.  Returns RIG_OK or -RIG_EIO
+ * when a write failed. */
+int stream_recorder_finish(struct rig_stream_recorder *rec);
+
+/* The STREAM_RECORD_WAV_HEADER bytes in front of data_bytes of samples in
+ * format (a format WAV holds) and channels, with first's time, when
+ * valid, as the bext time reference: RIFF, or RF64 past 4 GB. */
+void stream_record_wav_header(unsigned char *hdr, rig_stream_format_t format,
+                              int channels, int sample_rate,
+                              uint64_t data_bytes,
+                              const struct stream_record_capture *first,
+                              const char *description);
+
+/* SigMF core:datatype of format in host byte order, NULL when it has none */
+const char *stream_record_sigmf_datatype(rig_stream_format_t format);
+
+/* The format of a SigMF core:datatype, 0 when no stream format holds it
+ * (other types, or the other byte order) */
+rig_stream_format_t stream_record_sigmf_format(const char *datatype);
+
+#endif /* HAMLIB_STREAM_RECORD_H */
@@ -0,0 +1,402 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Polyphase FIR resampler.  With out_rate / in_rate = up / down in lowest
+ * terms, output frame k sits at input time k * down / up: the newest input
+ * frame it uses is floor(k * down / up), and the remainder (the phase)
+ * picks the filter.  Each filter is stored reversed, so an output is one
+ * contiguous dot product per channel over a deinterleaved history; the
+ * tap count is a multiple of 8 and the dot product keeps 8 partial sums,
+ * which the compiler turns into vector code. */
+
+#ifdef HAVE_CONFIG_H
+#include "hamlib/config.h"
+#endif
+
+#include "stream_resample.h"
+#include "stream_convert.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Input frames buffered per pass, at least */
+#define STREAM_RESAMPLE_BLOCK 1024
+
+/* Taps per phase, counted at the lower of the two rates, and stopband
+ * attenuation of each quality.  The cutoff sits half the Kaiser transition
+ * width below the lower Nyquist frequency, so the stopband starts there:
+ * FAST passes 70 % of that band, MEDIUM 79 % and BEST 87 %. */
+static const struct
+{
+    int taps;
+    double atten_db;
+} resample_quality[] =
+{
+    [RIG_RESAMPLE_BEST]   = { 96, 100.0 },
+    [RIG_RESAMPLE_MEDIUM] = { 48, 80.0 },
+    [RIG_RESAMPLE_FAST]   = { 24, 60.0 },
+};
+
+struct stream_resampler
+{
+    int channels;
+    unsigned long up, down;         /* out_rate / in_rate in lowest terms */
+    int taps;                       /* Per phase, a multiple of 8 */
+    int phases;                     /* Filters in the bank */
+    int interpolate;                /* phases < up: blend the two nearest */
+    float *coefs;                   /* phases (+ 1 interpolating) x taps */
+    size_t cap;                     /* Frames buf holds per channel */
+    float *buf;                     /* channels x cap, deinterleaved */
+    size_t have;                    /* Frames in buf */
+    size_t pos;                     /* Newest frame the next output uses */
+    unsigned long phase;            /* 0 .. up - 1 */
+};
+
+
+static unsigned long resample_gcd(unsigned long a, unsigned long b)
+{
+    while (b != 0)
+    {
+        unsigned long t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+
+/* Modified Bessel function of the first kind, order 0 */
+static double resample_bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+
+    for (int k = 1; k < 64 && term > sum * 1e-12; k++)
+    {
+        double half = x / (2.0 * k);
+        term *= half * half;
+        sum += term;
+    }
+
+    return sum;
+}
+
+
+/* The filter for an output frac of an input frame past the newest one it
+ * uses, delayed by taps / 2 frames; coefs[i] multiplies the frame
+ * taps - 1 - i before the newest.  Normalized for unity gain at DC. */
+static void resample_design(float *coefs, int taps, double frac,
+                            double cutoff, double beta, double i0_beta)
+{
+    double half = taps / 2.0;
+    double sum = 0.0;
+    int j;
+
+    for (j = 0; j < taps; j++)
+    {
+        double t = frac + j - half;
+        double r = t / half;
+        double x = 2.0 * cutoff * t;
+        double w = fabs(r) < 1.0
+                   ? resample_bessel_i0(beta * sqrt(1.0 - r * r)) / i0_beta : 0.0;
+        double h = 2.0 * cutoff * w * (fabs(x) < 1e-9 ? 1.0 : sin(M_PI * x) /
+                                       (M_PI * x));
+
+        coefs[taps - 1 - j] = (float)h;
+        sum += h;
+    }
+
+    for (j = 0; j < taps; j++)
+    {
+        coefs[j] = (float)(coefs[j] / sum);
+    }
+}
+
+
+static float resample_dot(const float *c, const float *x, int taps)
+{
+    float acc[8] = { 0 };
+
+    for (int i = 0; i < taps; i += 8)
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            acc[k] += c[i + k] * x[i + k];
+        }
+    }
+
+    return ((acc[0] + acc[4]) + (acc[1] + acc[5]))
+           + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+}
+
+
+int stream_resampler_init(struct stream_resampler **out, int in_rate,
+                          int out_rate, int channels, int quality)
+{
+    struct stream_resampler *rs;
+    unsigned long g;
+    double atten, beta, i0_beta, transition, cutoff;
+    size_t block, filters;
+    int base_taps, taps, p;
+
+    if (!out || in_rate <= 0 || out_rate <= 0 || channels <= 0)
+    {
+        return -1;
+    }
+
+    if (quality < RIG_RESAMPLE_BEST || quality > RIG_RESAMPLE_FAST)
+    {
+        quality = RIG_RESAMPLE_FAST;
+    }
+
+    rs = calloc(1, sizeof(*rs));
+
+    if (!rs)
+    {
+        return -1;
+    }
+
+    g = resample_gcd((unsigned long)in_rate, (unsigned long)out_rate);
+    rs->channels = channels;
+    rs->up = (unsigned long)out_rate / g;
+    rs->down = (unsigned long)in_rate / g;
+
+    // Decimating narrows the passband in input terms, so the filter is
+    // longer by the same factor to keep its transition band
+    base_taps = resample_quality[quality].taps;
+    taps = base_taps;
+
+    if (rs->down > rs->up)
+    {
+        double longer = ceil((double)base_taps * rs->down / rs->up);
+        taps = longer > STREAM_RESAMPLE_MAX_TAPS ? STREAM_RESAMPLE_MAX_TAPS
+               : (int)longer;
+    }
+
+    rs->taps = (taps + 7) & ~7;
+
+    rs->interpolate = rs->up > STREAM_RESAMPLE_MAX_PHASES;
+    rs->phases = rs->interpolate ? STREAM_RESAMPLE_MAX_PHASES : (int)rs->up;
+    filters = (size_t)rs->phases + (rs->interpolate ? 1 : 0);
+
+    block = STREAM_RESAMPLE_BLOCK;
+
+    if (block < 2 * (rs->down / rs->up + 1))
+    {
+        block = 2 * (rs->down / rs->up + 1);
+    }
+
+    rs->cap = (size_t)rs->taps - 1 + block;
+    rs->coefs = malloc(filters * rs->taps * sizeof(float));
+    rs->buf = malloc((size_t)channels * rs->cap * sizeof(float));
+
+    if (!rs->coefs || !rs->buf)
+    {
+        stream_resampler_free(rs);
+        return -1;
+    }
+
+    // Kaiser: beta from the attenuation, transition width from the taps
+    atten = resample_quality[quality].atten_db;
+    beta = atten > 50.0 ? 0.1102 * (atten - 8.7)
+           : 0.5842 * pow(atten - 21.0, 0.4) + 0.07886 * (atten - 21.0);
+    i0_beta = resample_bessel_i0(beta);
+    transition = (atten - 7.95) / (14.36 * base_taps);
+    cutoff = 0.5 - transition / 2.0;
+
+    if (rs->down > rs->up)
+    {
+        cutoff *= (double)rs->up / rs->down;
+    }
+
+    for (p = 0; p < (int)filters; p++)
+    {
+        resample_design(rs->coefs + (size_t)p * rs->taps, rs->taps,
+                        (double)p / rs->phases, cutoff, beta, i0_beta);
+    }
+
+    stream_resampler_reset(rs);
+
+    *out = rs;
+    return 0;
+}
+
+
+void stream_resampler_free(struct stream_resampler *rs)
+{
+    if (!rs)
+    {
+        return;
+    }
+
+    free(rs->coefs);
+    free(rs->buf);
+    free(rs);
+}
+
+
+void stream_resampler_reset(struct stream_resampler *rs)
+{
+    // The history starts as taps - 1 frames of silence
+    memset(rs->buf, 0, (size_t)rs->channels * rs->cap * sizeof(float));
+    rs->have = rs->taps - 1;
+    rs->pos = rs->taps - 1;
+    rs->phase = 0;
+}
+
+
+int stream_resampler_delay(const struct stream_resampler *rs)
+{
+    return rs->taps / 2;
+}
+
+
+void stream_resampler_skip_delay(struct stream_resampler *rs)
+{
+    rs->pos += rs->taps / 2;
+}
+
+
+size_t stream_resampler_max_output(const struct stream_resampler *rs,
+                                   size_t in_frames)
+{
+    uint64_t reach;
+
+    if (rs->have + in_frames <= rs->pos)
+    {
+        return 0;
+    }
+
+    // Outputs k with pos + (phase + k * down) / up < have + in_frames
+    reach = (uint64_t)(rs->have + in_frames - rs->pos) * rs->up - rs->phase;
+
+    return (size_t)((reach + rs->down - 1) / rs->down);
+}
+
+
+static void resample_one(const struct stream_resampler *rs, float *out)
+{
+    const float *x = rs->buf + rs->pos - (rs->taps - 1);
+    int ch;
+
+    if (!rs->interpolate)
+    {
+        const float *c = rs->coefs + (size_t)rs->phase * rs->taps;
+
+        for (ch = 0; ch < rs->channels; ch++)
+        {
+            out[ch] = resample_dot(c, x + ch * rs->cap, rs->taps);
+        }
+    }
+    else
+    {
+        uint64_t at = (uint64_t)rs->phase * rs->phases;
+        const float *c0 = rs->coefs + (size_t)(at / rs->up) * rs->taps;
+        const float *c1 = c0 + rs->taps;
+        float frac = (float)(at % rs->up) / (float)rs->up;
+
+        for (ch = 0; ch < rs->channels; ch++)
+        {
+            float a = resample_dot(c0, x + ch * rs->cap, rs->taps);
+            float b = resample_dot(c1, x + ch * rs->cap, rs->taps);
+
+            out[ch] = a + frac * (b - a);
+        }
+    }
+}
+
+
+size_t stream_resampler_process(struct stream_resampler *rs, const float *in,
+                                size_t *in_frames, float *out,
+                                size_t out_frames)
+{
+    size_t used = 0, made = 0;
+    int ch;
+
+    for (;;)
+    {
+        size_t first, take, i;
+
+        while (made < out_frames && rs->pos < rs->have)
+        {
+            resample_one(rs, out + made * rs->channels);
+            made++;
+
+            rs->phase += rs->down;
+            rs->pos += rs->phase / rs->up;
+            rs->phase %= rs->up;
+        }
+
+        // Drop the frames no later output reaches back to
+        first = rs->pos - (rs->taps - 1);
+
+        if (first > rs->have)
+        {
+            first = rs->have;
+        }
+
+        if (first > 0)
+        {
+            for (ch = 0; ch < rs->channels; ch++)
+            {
+                float *b = rs->buf + ch * rs->cap;
+                memmove(b, b + first, (rs->have - first) * sizeof(float));
+            }
+
+            rs->have -= first;
+            rs->pos -= first;
+        }
+
+        if (used == *in_frames || made == out_frames)
+        {
+            break;
+        }
+
+        take = rs->cap - rs->have;
+
+        if (take > *in_frames - used)
+        {
+            take = *in_frames - used;
+        }
+
+        for (ch = 0; ch < rs->channels; ch++)
+        {
+            const float *s = in + used * rs->channels + ch;
+            float *b = rs->buf + ch * rs->cap + rs->have;
+
+            for (i = 0; i < take; i++)
+            {
+                b[i] = s[i * rs->channels];
+            }
+        }
+
+        rs->have += take;
+        used += take;
+    }
+
+    *in_frames = used;
+    return made;
+}
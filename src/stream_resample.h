@@ -0,0 +1,69 @@
+/*
+ *  Hamlib streaming subsystem
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Stateful polyphase FIR resampler for float samples.  The ratio is kept
+ * as the exact fraction out_rate / in_rate, so the output never drifts;
+ * ratios needing up to STREAM_RESAMPLE_MAX_PHASES filter phases get one
+ * filter per phase, others interpolate between the neighbouring two of a
+ * bank that size.  The filter is a Kaiser-windowed sinc sized by the
+ * RIG_RESAMPLE_* quality. */
+
+#ifndef HAMLIB_STREAM_RESAMPLE_H
+#define HAMLIB_STREAM_RESAMPLE_H
+
+#include <stddef.h>
+
+#define STREAM_RESAMPLE_MAX_PHASES 512
+#define STREAM_RESAMPLE_MAX_TAPS 4096    /* Per phase, for deep decimation */
+
+struct stream_resampler;
+
+/* A resampler for interleaved frames of channels floats.  quality is one
+ * of RIG_RESAMPLE_BEST, _MEDIUM or _FAST.  Returns 0 and sets *out, or -1
+ * on bad arguments or out of memory. */
+int stream_resampler_init(struct stream_resampler **out, int in_rate,
+                          int out_rate, int channels, int quality);
+
+void stream_resampler_free(struct stream_resampler *rs);
+
+/* Forget the history, as after a gap in the input */
+void stream_resampler_reset(struct stream_resampler *rs);
+
+/* Delay of the output behind the input, in input frames */
+int stream_resampler_delay(const struct stream_resampler *rs);
+
+/* Start the output delay input frames later, so output frame k lines up
+ * with input time k * in_rate / out_rate.  Call before the first process;
+ * the caller pads the end of the input with delay frames of silence. */
+void stream_resampler_skip_delay(struct stream_resampler *rs);
+
+/* Most frames in_frames of input can produce */
+size_t stream_resampler_max_output(const struct stream_resampler *rs,
+                                   size_t in_frames);
+
+/* Resample *in_frames frames from in into at most out_frames frames at
+ * out.  Returns the frames written and sets *in_frames to the frames
+ * used, which is all of them unless out filled up first. */
+size_t stream_resampler_process(struct stream_resampler *rs, const float *in,
+                                size_t *in_frames, float *out,
+                                size_t out_frames);
+
+#endif /* HAMLIB_STREAM_RESAMPLE_H */
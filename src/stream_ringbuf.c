@@ -19,8 +19,9 @@
  */
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
-/* Thread-safe ring buffer for streaming audio/I/Q data. */
-/* Overwrite-oldest producer, timeout-blocking reader using a condition var. */
+/* Lock-free single-producer/single-consumer ring buffer for streaming
+ * audio/I/Q data: overwrite-oldest producer, reader that sleeps on a
+ * condition variable only when the ring is empty. */
 
 #ifdef HAVE_CONFIG_H
 #include "hamlib/config.h"
@@ -35,6 +36,11 @@
 #include <time.h>
 #include <unistd.h>
 
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_SYS_MMAN_H)
+#define STREAM_RINGBUF_MIRROR 1
+#include <sys/mman.h>
+#endif
+
 
 /* Round up to the next power of 2.  Returns v unchanged if already a power of 2. */
 static size_t next_power_of_two(size_t v)
@@ -53,6 +59,63 @@ static size_t next_power_of_two(size_t v)
 }
 
 
+#ifdef STREAM_RINGBUF_MIRROR
+/* Map one memfd of capacity bytes twice, back to back, into a reserved
+ * range of twice that.  NULL when capacity is not a whole number of pages
+ * or the system refuses; the caller falls back to the heap. */
+static unsigned char *ringbuf_map_mirrored(size_t capacity)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    unsigned char *base;
+    int fd;
+
+    if (page <= 0 || capacity % (size_t)page != 0)
+    {
+        return NULL;
+    }
+
+    fd = memfd_create("hamlib-stream", MFD_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    if (ftruncate(fd, (off_t)capacity) < 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    base = mmap(NULL, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                0);
+
+    if (base == MAP_FAILED)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    if (mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+             fd, 0) == MAP_FAILED
+            || mmap(base + capacity, capacity, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: mirroring %zu bytes failed: %s\n",
+                  __func__, capacity, strerror(errno));
+        munmap(base, 2 * capacity);
+        close(fd);
+        return NULL;
+    }
+
+    /* The mappings keep the memory alive */
+    close(fd);
+
+    return base;
+}
+#endif
+
+
 int stream_ringbuf_init(struct rig_stream_ringbuf *rb, size_t capacity)
 {
     memset(rb, 0, sizeof(*rb));
@@ -71,7 +134,15 @@ int stream_ringbuf_init(struct rig_stream_ringbuf *rb, size_t capacity)
 
     capacity = next_power_of_two(capacity);
 
-    rb->buffer = calloc(1, capacity);
+#ifdef STREAM_RINGBUF_MIRROR
+    rb->buffer = ringbuf_map_mirrored(capacity);
+    rb->mirrored = rb->buffer != NULL;
+#endif
+
+    if (!rb->buffer)
+    {
+        rb->buffer = calloc(1, capacity);
+    }
 
     if (!rb->buffer)
     {
@@ -110,9 +181,100 @@ void stream_ringbuf_destroy(struct rig_stream_ringbuf *rb)
 {
     pthread_mutex_destroy(&rb->lock);
     pthread_cond_destroy(&rb->data_available);
-    free(rb->buffer);
+
+#ifdef STREAM_RINGBUF_MIRROR
+
+    if (rb->mirrored)
+    {
+        munmap(rb->buffer, 2 * rb->capacity);
+    }
+    else
+#endif
+    {
+        free(rb->buffer);
+    }
+
     rb->buffer = NULL;
     rb->capacity = 0;
+    rb->mirrored = 0;
+}
+
+
+/* Copy len bytes in at index pos, handling wraparound.  A mirrored
+ * buffer has none to handle. */
+static void ringbuf_copy_in(struct rig_stream_ringbuf *rb, uint64_t pos,
+                            const unsigned char *src, size_t len)
+{
+    size_t offset = pos & (rb->capacity - 1);
+    size_t first = rb->capacity - offset;
+
+    if (first >= len || rb->mirrored)
+    {
+        memcpy(rb->buffer + offset, src, len);
+    }
+    else
+    {
+        memcpy(rb->buffer + offset, src, first);
+        memcpy(rb->buffer, src + first, len - first);
+    }
+}
+
+
+static void ringbuf_copy_out(struct rig_stream_ringbuf *rb, uint64_t pos,
+                             unsigned char *dst, size_t len)
+{
+    size_t offset = pos & (rb->capacity - 1);
+    size_t first = rb->capacity - offset;
+
+    if (first >= len || rb->mirrored)
+    {
+        memcpy(dst, rb->buffer + offset, len);
+    }
+    else
+    {
+        memcpy(dst, rb->buffer + offset, first);
+        memcpy(dst + first, rb->buffer, len - first);
+    }
+}
+
+
+/* First unread index of the consumer at *read_total given the producer
+ * index head: its own index unless the producer has lapped it. */
+static uint64_t ringbuf_tail_of(struct rig_stream_ringbuf *rb,
+                                const uint64_t *read_total, uint64_t head)
+{
+    uint64_t tail = __atomic_load_n(read_total, __ATOMIC_ACQUIRE);
+
+    if (head - tail > rb->capacity)
+    {
+        tail = head - rb->capacity;
+    }
+
+    return tail;
+}
+
+
+static uint64_t ringbuf_tail(struct rig_stream_ringbuf *rb, uint64_t head)
+{
+    return ringbuf_tail_of(rb, &rb->read_total, head);
+}
+
+
+/* Publish new bytes up to end, then wake the readers if any sleeps.  The
+ * seq_cst fence pairs with the one in ringbuf_wait_locked(): either a
+ * reader sees the new bytes before sleeping, or we see it waiting -- and it
+ * holds the lock until it is inside the wait. */
+static void ringbuf_publish(struct rig_stream_ringbuf *rb, uint64_t end)
+{
+    __atomic_store_n(&rb->write_total, end, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&rb->reader_waiting, __ATOMIC_RELAXED))
+    {
+        pthread_mutex_lock(&rb->lock);
+        pthread_cond_broadcast(&rb->data_available);
+        pthread_mutex_unlock(&rb->lock);
+    }
 }
 
 
@@ -120,13 +282,12 @@ size_t stream_ringbuf_write(struct rig_stream_ringbuf *rb,
                             const void *data, size_t len)
 {
     const unsigned char *src = data;
-
-    pthread_mutex_lock(&rb->lock);
+    uint64_t head = __atomic_load_n(&rb->write_total, __ATOMIC_RELAXED);
 
     /* Producer position counts every byte produced, including bytes that
      * are clamped or overwritten below — the consumer detects the loss as
      * a jump in the first-readable index. */
-    rb->write_total += len;
+    uint64_t end = head + len;
 
     /* If writing more than capacity, only keep the last capacity bytes. */
     if (len > rb->capacity)
@@ -135,33 +296,20 @@ size_t stream_ringbuf_write(struct rig_stream_ringbuf *rb,
         len = rb->capacity;
     }
 
-    /* If writing would overflow, advance read_pos to discard oldest data. */
-    if (len > rb->capacity - rb->count)
+    /* Overwriting unread bytes: the consumer skips past them on its next
+     * read, all we do is count it. */
+    if (end - ringbuf_tail(rb, head) > rb->capacity)
     {
-        size_t overflow = len - (rb->capacity - rb->count);
-        rb->read_pos = (rb->read_pos + overflow) & (rb->capacity - 1);
-        rb->count -= overflow;
         rb->overrun_count++;
     }
 
-    /* Write data, handling wraparound. */
-    size_t first = rb->capacity - rb->write_pos;
+    /* Claim before copying: a consumer that read bytes below
+     * write_claim - capacity may have copied them half overwritten. */
+    __atomic_store_n(&rb->write_claim, end, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
 
-    if (first >= len)
-    {
-        memcpy(rb->buffer + rb->write_pos, src, len);
-    }
-    else
-    {
-        memcpy(rb->buffer + rb->write_pos, src, first);
-        memcpy(rb->buffer, src + first, len - first);
-    }
-
-    rb->write_pos = (rb->write_pos + len) & (rb->capacity - 1);
-    rb->count += len;
-
-    pthread_cond_signal(&rb->data_available);
-    pthread_mutex_unlock(&rb->lock);
+    ringbuf_copy_in(rb, end - len, src, len);
+    ringbuf_publish(rb, end);
 
     return len;
 }
@@ -172,179 +320,219 @@ size_t stream_ringbuf_write_record(struct rig_stream_ringbuf *rb,
                                    const void *payload, size_t len)
 {
     size_t total = hdr_len + len;
-
-    pthread_mutex_lock(&rb->lock);
+    uint64_t head = __atomic_load_n(&rb->write_total, __ATOMIC_RELAXED);
 
     /* All or nothing: a partial record would strand the reader mid-frame,
      * and overwriting the oldest bytes would destroy record alignment.
      * No overrun counting here — a retrying TX writer polls this path,
-     * so the caller decides whether a failure is a real drop. */
-    if (total > rb->capacity - rb->count)
+     * so the caller decides whether a failure is a real drop.  The
+     * acquire load of read_total means the consumer is done copying the
+     * space we reuse. */
+    if (total > rb->capacity - (head - ringbuf_tail(rb, head)))
     {
-        pthread_mutex_unlock(&rb->lock);
         return 0;
     }
 
-    rb->write_total += total;
+    __atomic_store_n(&rb->write_claim, head + total, __ATOMIC_RELAXED);
+    ringbuf_copy_in(rb, head, hdr, hdr_len);
+    ringbuf_copy_in(rb, head + hdr_len, payload, len);
+    ringbuf_publish(rb, head + total);
 
-    const unsigned char *parts[2] = { hdr, payload };
-    const size_t part_len[2] = { hdr_len, len };
+    return total;
+}
 
-    for (int i = 0; i < 2; i++)
+
+/* Copy up to len bytes unread by the consumer at *read_total, retrying
+ * when the producer overwrote them during the copy.  Returns bytes copied;
+ * *start gets the index of the first. */
+static size_t ringbuf_copy_from(struct rig_stream_ringbuf *rb,
+                                const uint64_t *read_total,
+                                unsigned char *dst, size_t len,
+                                uint64_t *start)
+{
+    for (;;)
     {
-        const unsigned char *src = parts[i];
-        size_t n = part_len[i];
-        size_t first = rb->capacity - rb->write_pos;
+        uint64_t head = __atomic_load_n(&rb->write_total, __ATOMIC_ACQUIRE);
+        uint64_t tail = ringbuf_tail_of(rb, read_total, head);
+        size_t n = len < head - tail ? len : (size_t)(head - tail);
 
-        if (first >= n)
-        {
-            memcpy(rb->buffer + rb->write_pos, src, n);
-        }
-        else
+        ringbuf_copy_out(rb, tail, dst, n);
+
+        /* Seqlock-style validation: the bytes copied survive if the
+         * producer has not claimed the slots they sat in. */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint64_t claim = __atomic_load_n(&rb->write_claim, __ATOMIC_RELAXED);
+
+        if (claim - tail <= rb->capacity)
         {
-            memcpy(rb->buffer + rb->write_pos, src, first);
-            memcpy(rb->buffer, src + first, n - first);
+            *start = tail;
+            return n;
         }
-
-        rb->write_pos = (rb->write_pos + n) & (rb->capacity - 1);
-        rb->count += n;
     }
+}
 
-    pthread_cond_signal(&rb->data_available);
-    pthread_mutex_unlock(&rb->lock);
 
-    return total;
+static size_t ringbuf_copy_tail(struct rig_stream_ringbuf *rb,
+                                unsigned char *dst, size_t len,
+                                uint64_t *start)
+{
+    return ringbuf_copy_from(rb, &rb->read_total, dst, len, start);
+}
+
+
+size_t stream_ringbuf_peek_at_locked(struct rig_stream_ringbuf *rb,
+                                     unsigned char *dst, size_t len,
+                                     uint64_t *start)
+{
+    return ringbuf_copy_tail(rb, dst, len, start);
 }
 
 
 size_t stream_ringbuf_peek_locked(struct rig_stream_ringbuf *rb,
                                   unsigned char *dst, size_t len)
 {
-    if (len > rb->count)
-    {
-        len = rb->count;
-    }
+    uint64_t start;
 
-    size_t first = rb->capacity - rb->read_pos;
+    return ringbuf_copy_tail(rb, dst, len, &start);
+}
 
-    if (first >= len)
-    {
-        memcpy(dst, rb->buffer + rb->read_pos, len);
-    }
-    else
-    {
-        memcpy(dst, rb->buffer + rb->read_pos, first);
-        memcpy(dst + first, rb->buffer, len - first);
-    }
 
-    return len;
+static size_t ringbuf_available_of(struct rig_stream_ringbuf *rb,
+                                   const uint64_t *read_total)
+{
+    uint64_t head = __atomic_load_n(&rb->write_total, __ATOMIC_ACQUIRE);
+
+    return (size_t)(head - ringbuf_tail_of(rb, read_total, head));
 }
 
 
-/* Wait for readable data. Caller holds rb->lock.
+static size_t ringbuf_available(struct rig_stream_ringbuf *rb)
+{
+    return ringbuf_available_of(rb, &rb->read_total);
+}
+
+
+/* Wait until the consumer at *read_total has data. Caller holds rb->lock.
  * timeout_ms < 0 blocks until data or shutdown; 0 polls; > 0 bounds the wait.
- * Returns 0 when data is available, -1 on timeout (bumps underrun_count) or
- * when the ring is closing. */
-int stream_ringbuf_wait_data_locked(struct rig_stream_ringbuf *rb,
-                                    int timeout_ms)
+ * Returns 0 when data is available, -1 when the ring is closing, -2 on
+ * timeout. */
+static int ringbuf_wait_locked(struct rig_stream_ringbuf *rb,
+                               const uint64_t *read_total, int timeout_ms)
 {
+    struct timespec ts;
+    int ret = 0;
+
     if (rb->closing)
     {
         return -1;
     }
 
-    if (rb->count > 0)
+    if (ringbuf_available_of(rb, read_total) > 0)
     {
         return 0;
     }
 
-    /* Block indefinitely: wait until data arrives or the ring is closed. */
-    if (timeout_ms < 0)
+    if (timeout_ms >= 0)
     {
-        while (rb->count == 0 && !rb->closing)
+        clockid_t clk = rb->use_monotonic ? CLOCK_MONOTONIC : CLOCK_REALTIME;
+        clock_gettime(clk, &ts);
+        ts.tv_sec  += timeout_ms / 1000;
+        ts.tv_nsec += (timeout_ms % 1000) * 1000000L;
+
+        if (ts.tv_nsec >= 1000000000L)
         {
-            pthread_cond_wait(&rb->data_available, &rb->lock);
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
         }
-
-        return rb->closing ? -1 : 0;
     }
 
-    struct timespec ts;
-
-    clockid_t clk = rb->use_monotonic ? CLOCK_MONOTONIC : CLOCK_REALTIME;
-    clock_gettime(clk, &ts);
-    ts.tv_sec  += timeout_ms / 1000;
-    ts.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    /* Announce the wait before the last look at the producer index (see
+     * ringbuf_publish()); the producer leaves the lock alone otherwise. */
+    __atomic_add_fetch(&rb->reader_waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-    if (ts.tv_nsec >= 1000000000L)
+    while (ringbuf_available_of(rb, read_total) == 0 && !rb->closing)
     {
-        ts.tv_sec++;
-        ts.tv_nsec -= 1000000000L;
-    }
-
-    while (rb->count == 0)
-    {
-        if (rb->closing)
+        /* Block indefinitely: wait until data arrives or the ring is
+         * closed. */
+        if (timeout_ms < 0)
         {
-            return -1;
+            pthread_cond_wait(&rb->data_available, &rb->lock);
+            continue;
         }
 
-        int ret = pthread_cond_timedwait(&rb->data_available,
-                                         &rb->lock, &ts);
-
-        if (ret == ETIMEDOUT)
+        if (pthread_cond_timedwait(&rb->data_available, &rb->lock,
+                                   &ts) == ETIMEDOUT
+                && ringbuf_available_of(rb, read_total) == 0)
         {
-            /* An underrun is the producer falling behind, which it cannot do
-             * before it has produced anything. A consumer that starts first
-             * and reads while the stream is still coming up is early, not
-             * starved, and counting that leaves every stream reporting one
-             * underrun it never suffered -- which hides the first real one.
-             * write_total counts every byte ever produced and survives a
-             * reset, so this only excuses the opening silence. */
-            if (rb->write_total > 0)
-            {
-                rb->underrun_count++;
-            }
-
-            return -1;
+            ret = -2;
+            break;
         }
     }
 
-    return 0;
+    __atomic_sub_fetch(&rb->reader_waiting, 1, __ATOMIC_RELAXED);
+
+    return rb->closing ? -1 : ret;
 }
 
 
-/* Copy up to len readable bytes out of the buffer. Caller holds rb->lock. */
-size_t stream_ringbuf_consume_locked(struct rig_stream_ringbuf *rb,
-                                     unsigned char *dst, size_t len)
+/* Wait for readable data. Caller holds rb->lock.
+ * Returns 0 when data is available, -1 on timeout (bumps underrun_count) or
+ * when the ring is closing. */
+int stream_ringbuf_wait_data_locked(struct rig_stream_ringbuf *rb,
+                                    int timeout_ms)
 {
-    if (len > rb->count)
+    int ret = ringbuf_wait_locked(rb, &rb->read_total, timeout_ms);
+
+    /* An underrun is the producer falling behind, which it cannot do
+     * before it has produced anything. A consumer that starts first
+     * and reads while the stream is still coming up is early, not
+     * starved, and counting that leaves every stream reporting one
+     * underrun it never suffered -- which hides the first real one.
+     * write_total counts every byte ever produced and survives a
+     * reset, so this only excuses the opening silence. */
+    if (ret == -2 && __atomic_load_n(&rb->write_total, __ATOMIC_RELAXED) > 0)
     {
-        len = rb->count;
+        rb->underrun_count++;
     }
 
-    size_t first = rb->capacity - rb->read_pos;
+    return ret < 0 ? -1 : 0;
+}
 
-    if (first >= len)
-    {
-        memcpy(dst, rb->buffer + rb->read_pos, len);
-    }
-    else
-    {
-        memcpy(dst, rb->buffer + rb->read_pos, first);
-        memcpy(dst + first, rb->buffer, len - first);
-    }
 
-    rb->read_pos = (rb->read_pos + len) & (rb->capacity - 1);
-    rb->count -= len;
+size_t stream_ringbuf_consume_at_locked(struct rig_stream_ringbuf *rb,
+                                        unsigned char *dst, size_t len,
+                                        uint64_t *start)
+{
+    len = ringbuf_copy_tail(rb, dst, len, start);
+
+    /* Release: the producer may reuse the space once it sees this. */
+    __atomic_store_n(&rb->read_total, *start + len, __ATOMIC_RELEASE);
 
     return len;
 }
 
 
+/* Copy up to len readable bytes out of the buffer. Caller holds rb->lock. */
+size_t stream_ringbuf_consume_locked(struct rig_stream_ringbuf *rb,
+                                     unsigned char *dst, size_t len)
+{
+    uint64_t start;
+
+    return stream_ringbuf_consume_at_locked(rb, dst, len, &start);
+}
+
+
 size_t stream_ringbuf_read(struct rig_stream_ringbuf *rb,
                            void *data, size_t len, int timeout_ms)
 {
+    /* Fast path: data is there, no lock needed. */
+    if (ringbuf_available(rb) > 0
+            && !__atomic_load_n(&rb->closing, __ATOMIC_RELAXED))
+    {
+        return stream_ringbuf_consume_locked(rb, data, len);
+    }
+
     pthread_mutex_lock(&rb->lock);
 
     if (stream_ringbuf_wait_data_locked(rb, timeout_ms) < 0)
@@ -363,18 +551,130 @@ size_t stream_ringbuf_read(struct rig_stream_ringbuf *rb,
 
 size_t stream_ringbuf_available(struct rig_stream_ringbuf *rb)
 {
-    pthread_mutex_lock(&rb->lock);
-    size_t count = rb->count;
-    pthread_mutex_unlock(&rb->lock);
-    return count;
+    return ringbuf_available(rb);
+}
+
+
+uint64_t stream_ringbuf_read_index(struct rig_stream_ringbuf *rb)
+{
+    return ringbuf_tail(rb, __atomic_load_n(&rb->write_total,
+                                            __ATOMIC_ACQUIRE));
+}
+
+
+size_t stream_ringbuf_read_region(struct rig_stream_ringbuf *rb,
+                                  unsigned char **data, uint64_t *start)
+{
+    uint64_t head = __atomic_load_n(&rb->write_total, __ATOMIC_ACQUIRE);
+    uint64_t tail = ringbuf_tail(rb, head);
+    size_t offset = tail & (rb->capacity - 1);
+    size_t len = (size_t)(head - tail);
+
+    if (!rb->mirrored && len > rb->capacity - offset)
+    {
+        len = rb->capacity - offset;
+    }
+
+    *data = rb->buffer + offset;
+    *start = tail;
+
+    return len;
+}
+
+
+int stream_ringbuf_read_commit(struct rig_stream_ringbuf *rb, uint64_t start,
+                               size_t len)
+{
+    /* As in ringbuf_copy_tail(): the caller's reads are done, so a claim
+     * reaching past start + capacity means some were of overwritten
+     * bytes. */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t claim = __atomic_load_n(&rb->write_claim, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&rb->read_total, start + len, __ATOMIC_RELEASE);
+
+    return claim - start <= rb->capacity ? 0 : -1;
+}
+
+
+size_t stream_ringbuf_write_region(struct rig_stream_ringbuf *rb,
+                                   unsigned char **data, size_t *free_total)
+{
+    uint64_t head = __atomic_load_n(&rb->write_total, __ATOMIC_RELAXED);
+    size_t offset = head & (rb->capacity - 1);
+    size_t len = rb->capacity - (size_t)(head - ringbuf_tail(rb, head));
+
+    *free_total = len;
+
+    if (!rb->mirrored && len > rb->capacity - offset)
+    {
+        len = rb->capacity - offset;
+    }
+
+    *data = rb->buffer + offset;
+
+    return len;
+}
+
+
+void stream_ringbuf_write_commit(struct rig_stream_ringbuf *rb, size_t len)
+{
+    uint64_t end = __atomic_load_n(&rb->write_total, __ATOMIC_RELAXED) + len;
+
+    /* The bytes went into free space, so this overwrites nothing; the
+     * claim only has to keep up with write_total. */
+    __atomic_store_n(&rb->write_claim, end, __ATOMIC_RELAXED);
+    ringbuf_publish(rb, end);
 }
 
 
 void stream_ringbuf_reset(struct rig_stream_ringbuf *rb)
 {
     pthread_mutex_lock(&rb->lock);
-    rb->read_pos = 0;
-    rb->write_pos = 0;
-    rb->count = 0;
+    __atomic_store_n(&rb->read_total,
+                     __atomic_load_n(&rb->write_total, __ATOMIC_ACQUIRE),
+                     __ATOMIC_RELEASE);
     pthread_mutex_unlock(&rb->lock);
 }
+
+
+void stream_ringbuf_cursor_init(struct rig_stream_ringbuf *rb,
+                                struct rig_stream_ringbuf_cursor *cursor)
+{
+    cursor->read_total = __atomic_load_n(&rb->write_total, __ATOMIC_ACQUIRE);
+}
+
+
+size_t stream_ringbuf_cursor_available(struct rig_stream_ringbuf *rb,
+                                       const struct rig_stream_ringbuf_cursor *cursor)
+{
+    return ringbuf_available_of(rb, &cursor->read_total);
+}
+
+
+uint64_t stream_ringbuf_cursor_lag(struct rig_stream_ringbuf *rb,
+                                   const struct rig_stream_ringbuf_cursor *cursor)
+{
+    return __atomic_load_n(&rb->write_total, __ATOMIC_ACQUIRE)
+           - cursor->read_total;
+}
+
+
+int stream_ringbuf_cursor_wait_locked(struct rig_stream_ringbuf *rb,
+                                      const struct rig_stream_ringbuf_cursor *cursor,
+                                      int timeout_ms)
+{
+    return ringbuf_wait_locked(rb, &cursor->read_total, timeout_ms);
+}
+
+
+size_t stream_ringbuf_cursor_read(struct rig_stream_ringbuf *rb,
+                                  struct rig_stream_ringbuf_cursor *cursor,
+                                  unsigned char *dst, size_t len,
+                                  uint64_t *start)
+{
+    len = ringbuf_copy_from(rb, &cursor->read_total, dst, len, start);
+    cursor->read_total = *start + len;
+
+    return len;
+}
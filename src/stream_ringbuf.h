@@ -19,8 +19,10 @@
  */
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
-/* Thread-safe ring buffer for streaming audio/I/Q data. */
-/* Single producer never blocks (overwrites oldest); reader blocks with timeout. */
+/* Ring buffer for streaming audio/I/Q data between one producer and one
+ * consumer, plus any number of further readers with cursors of their own.
+ * The data path is lock-free: the producer never blocks and overwrites the
+ * oldest bytes; a reader only takes the lock to sleep. */
 
 #ifndef HAMLIB_STREAM_RINGBUF_H
 #define HAMLIB_STREAM_RINGBUF_H
@@ -33,43 +35,85 @@
 /* HAMLIB_ATOMIC is defined in hamlib/rig.h */
 
 
-/* Ring buffer for streaming audio/I/Q data between producer and consumer. */
+/* Keeps the producer's and the consumer's indices on cache lines of their
+ * own, so neither side's stores invalidate the other's line.  The struct
+ * is aligned to it as a result: whatever embeds one must be allocated
+ * that aligned. */
+#define STREAM_RINGBUF_CACHE_LINE 64
+
+/* Ring buffer for streaming audio/I/Q data between producer and consumer.
+ *
+ * Positions are free-running byte indices; buffer offset is index &
+ * (capacity - 1).  The producer owns write_total and write_claim, the
+ * consumer owns read_total, both published with __atomic builtins.
+ * Unread bytes are write_total - max(read_total, write_total - capacity):
+ * the producer never moves read_total, a consumer that was lapped skips
+ * ahead itself.  write_claim is advanced before the producer copies, so a
+ * consumer whose copy raced an overwrite notices and retries.
+ *
+ * lock and data_available are only used to put a reader to sleep (and by
+ * stream.c for its own state); the producer wakes them only when
+ * reader_waiting says someone is asleep. */
 struct rig_stream_ringbuf
 {
     unsigned char *buffer;
     size_t capacity;                /* Total bytes (power of 2) */
-    size_t read_pos;
-    size_t write_pos;
-    size_t count;                   /* Bytes available to read */
-    uint64_t write_total;           /* Bytes ever produced, incl. overwritten
-                                     * and clamped (protected by lock) */
+    int mirrored;                   /* 1 = buffer[capacity..2*capacity) maps
+                                     * the same memory as buffer[0..capacity),
+                                     * so any span up to capacity bytes from
+                                     * any offset is contiguous */
     pthread_mutex_t lock;
     pthread_cond_t data_available;  /* Signal when data written */
     int closing;                    /* 1 = shutting down; wakes blocked reader */
     int use_monotonic;              /* 1 if condvar uses CLOCK_MONOTONIC */
     HAMLIB_ATOMIC int overrun_count;
     HAMLIB_ATOMIC int underrun_count;
+
+    uint64_t write_total            /* Bytes ever produced, incl. overwritten
+                                     * and clamped (producer index) */
+    __attribute__((aligned(STREAM_RINGBUF_CACHE_LINE)));
+    uint64_t write_claim;           /* write_total once the copy in progress
+                                     * lands */
+
+    uint64_t read_total             /* Bytes consumed or skipped (consumer
+                                     * index) */
+    __attribute__((aligned(STREAM_RINGBUF_CACHE_LINE)));
+    int reader_waiting;             /* Readers asleep on data_available,
+                                     * the consumer and cursors alike */
 };
 
 
-/* Allocate ring buffer. capacity is rounded up to a power of 2. */
+/* A further reader of the same ring (broadcast): an index of its own over
+ * the buffer, owned by one reader thread.  The producer never looks at it,
+ * so it neither holds the producer back nor counts in overrun_count; a
+ * lapped cursor skips ahead like the consumer does. */
+struct rig_stream_ringbuf_cursor
+{
+    uint64_t read_total;            /* Bytes read or skipped by this reader */
+};
+
+
+/* Allocate ring buffer. capacity is rounded up to a power of 2.  Where the
+ * system has memfd_create() and capacity is a whole number of pages, the
+ * buffer is mirrored; otherwise it is plain heap memory and accesses that
+ * wrap are split in two. */
 int stream_ringbuf_init(struct rig_stream_ringbuf *rb, size_t capacity);
 
 /* Free ring buffer resources. */
 void stream_ringbuf_destroy(struct rig_stream_ringbuf *rb);
 
-/* Write data to ring buffer.
+/* Write data to ring buffer.  Lock-free, callable by the one producer only.
  * Overwrites oldest data if buffer is full (producer never blocks).
  * Increments overrun_count when overwriting.
- * Signals data_available.
+ * Signals data_available when a reader is waiting for it.
  * Returns bytes stored: len, or capacity when len exceeds capacity (only the
  * last capacity bytes are kept). write_total still counts every byte produced,
  * so the consumer detects the dropped remainder. */
 size_t stream_ringbuf_write(struct rig_stream_ringbuf *rb,
                             const void *data, size_t len);
 
-/* Read data from ring buffer.
- * Blocks up to timeout_ms waiting for data_available.
+/* Read data from ring buffer.  Lock-free while data is there; otherwise
+ * blocks up to timeout_ms waiting for data_available.
  * Returns bytes read (may be less than requested).
  * Increments underrun_count if timeout expires with no data. */
 size_t stream_ringbuf_read(struct rig_stream_ringbuf *rb,
@@ -84,15 +128,27 @@ size_t stream_ringbuf_write_record(struct rig_stream_ringbuf *rb,
                                    const void *hdr, size_t hdr_len,
                                    const void *payload, size_t len);
 
-/* Copy up to len readable bytes WITHOUT consuming them (read_pos and
- * count unchanged). Caller holds rb->lock. Returns bytes copied. */
+/* Copy up to len readable bytes WITHOUT consuming them. Caller holds
+ * rb->lock. Meant for record rings, which are never overwritten. Returns
+ * bytes copied. */
 size_t stream_ringbuf_peek_locked(struct rig_stream_ringbuf *rb,
                                   unsigned char *dst, size_t len);
 
+/* As stream_ringbuf_peek_locked(), also returning in *start the index of
+ * the first byte copied. */
+size_t stream_ringbuf_peek_at_locked(struct rig_stream_ringbuf *rb,
+                                     unsigned char *dst, size_t len,
+                                     uint64_t *start);
+
 /* Query bytes available for reading without blocking. */
 size_t stream_ringbuf_available(struct rig_stream_ringbuf *rb);
 
-/* Reset ring buffer to empty state. */
+/* Index of the first unread byte: read_total, or further on when the
+ * producer has overwritten what the consumer had not read yet. */
+uint64_t stream_ringbuf_read_index(struct rig_stream_ringbuf *rb);
+
+/* Reset ring buffer to empty state.  Discards on the consumer's side, so
+ * must not race a reader. */
 void stream_ringbuf_reset(struct rig_stream_ringbuf *rb);
 
 /* Lower-level primitives for consumers that need to snapshot additional
@@ -108,4 +164,66 @@ int stream_ringbuf_wait_data_locked(struct rig_stream_ringbuf *rb,
 size_t stream_ringbuf_consume_locked(struct rig_stream_ringbuf *rb,
                                      unsigned char *dst, size_t len);
 
+/* As stream_ringbuf_consume_locked(), also returning in *start the index
+ * of the first byte copied, which moves when the producer overwrites
+ * unread bytes between the caller's look and the copy. */
+size_t stream_ringbuf_consume_at_locked(struct rig_stream_ringbuf *rb,
+                                        unsigned char *dst, size_t len,
+                                        uint64_t *start);
+
+/* In-place access for the zero-copy stream API.  Regions are contiguous:
+ * on a mirrored ring they cover everything readable or free, otherwise
+ * they stop at the end of the buffer. */
+
+/* Readable bytes at the first unread index; *data points at them and
+ * *start gets their index.  The consumer side, like the consume calls. */
+size_t stream_ringbuf_read_region(struct rig_stream_ringbuf *rb,
+                                  unsigned char **data, uint64_t *start);
+
+/* Consume len bytes from start once the caller is done with them in place.
+ * Returns 0, or -1 when the producer overwrote some of them meanwhile;
+ * they are consumed either way. */
+int stream_ringbuf_read_commit(struct rig_stream_ringbuf *rb, uint64_t start,
+                               size_t len);
+
+/* Free space at the producer index.  Never unread bytes, so writing there
+ * overwrites nothing; *free_total gets all the free space, contiguous or
+ * not. */
+size_t stream_ringbuf_write_region(struct rig_stream_ringbuf *rb,
+                                   unsigned char **data, size_t *free_total);
+
+/* Publish len bytes written in place at the producer index. */
+void stream_ringbuf_write_commit(struct rig_stream_ringbuf *rb, size_t len);
+
+/* Further readers (struct rig_stream_ringbuf_cursor).  Reads are lock-free
+ * like the consumer's; only the wait needs rb->lock. */
+
+/* Start the cursor at the producer index: it reads what is written from
+ * now on. */
+void stream_ringbuf_cursor_init(struct rig_stream_ringbuf *rb,
+                                struct rig_stream_ringbuf_cursor *cursor);
+
+/* Bytes the cursor can read now. */
+size_t stream_ringbuf_cursor_available(struct rig_stream_ringbuf *rb,
+                                       const struct rig_stream_ringbuf_cursor *cursor);
+
+/* Bytes written since the cursor's index, lapped ones included: more than
+ * capacity means the producer has overwritten bytes it had not read. */
+uint64_t stream_ringbuf_cursor_lag(struct rig_stream_ringbuf *rb,
+                                   const struct rig_stream_ringbuf_cursor *cursor);
+
+/* As stream_ringbuf_wait_data_locked() for the cursor, but counting nothing:
+ * returns 0 when data is available, -1 when the ring is closing, -2 on
+ * timeout. */
+int stream_ringbuf_cursor_wait_locked(struct rig_stream_ringbuf *rb,
+                                      const struct rig_stream_ringbuf_cursor *cursor,
+                                      int timeout_ms);
+
+/* Copy up to len bytes from the cursor's first unread index on and move
+ * past them.  *start gets the index of the first byte copied. */
+size_t stream_ringbuf_cursor_read(struct rig_stream_ringbuf *rb,
+                                  struct rig_stream_ringbuf_cursor *cursor,
+                                  unsigned char *dst, size_t len,
+                                  uint64_t *start);
+
 #endif /* HAMLIB_STREAM_RINGBUF_H */
@@ -165,6 +165,28 @@
 #define TOK_STREAM_KEEPALIVE_INTERVAL  TOKEN_FRONTEND(146)
 /** \brief rig: Stream resampler quality: best, medium (default) or fast */
 #define TOK_STREAM_RESAMPLE_QUALITY  TOKEN_FRONTEND(147)
+/** \brief rig: POSIX shared-memory object name for the status page ("" = none) */
+#define TOK_STATUS_SHM  TOKEN_FRONTEND(148)
+/** \brief rig: How spectrum lines are multicast: json, binary or both */
+#define TOK_MULTICAST_SPECTRUM_FORMAT  TOKEN_FRONTEND(149)
+/** \brief rig: Encoding of binary spectrum packets: raw, rle, delta or auto */
+#define TOK_MULTICAST_SPECTRUM_ENCODING  TOKEN_FRONTEND(150)
+/** \brief rig: Spectrum processing for the multicast publisher, e.g. "bins=256,rate=5" */
+#define TOK_MULTICAST_SPECTRUM_PROCESS  TOKEN_FRONTEND(151)
+/** \brief rig: Spectrum processing for the application spectrum callback */
+#define TOK_SPECTRUM_CALLBACK_PROCESS  TOKEN_FRONTEND(152)
+/** \brief rig: Milliseconds between multicast keyframes, 0 = full snapshots only */
+#define TOK_MULTICAST_KEYFRAME_INTERVAL  TOKEN_FRONTEND(153)
+/** \brief rig: Microseconds the multicast publisher gathers packets into one send */
+#define TOK_MULTICAST_BATCH_WINDOW  TOKEN_FRONTEND(154)
+/** \brief rig: Publish through the one multicast thread and socket of the process */
+#define TOK_MULTICAST_HUB  TOKEN_FRONTEND(155)
+/** \brief rig: Opus bitrate in bits/s for streams the frontend encodes (0 = codec default) */
+#define TOK_STREAM_OPUS_BITRATE  TOKEN_FRONTEND(156)
+/** \brief rig: Stream datagrams per send or receive system call (0 = built-in, 1 = one each) */
+#define TOK_STREAM_BATCH_DEPTH  TOKEN_FRONTEND(157)
+/** \brief rig: Microseconds a stream sender waits to fill a batch, 0 = no waiting */
+#define TOK_STREAM_BATCH_WINDOW  TOKEN_FRONTEND(158)
 
 /*
  * rotator specific tokens
@@ -0,0 +1,629 @@
+/*
+ *  Hamlib Interface - batched UDP datagram I/O
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "hamlib/config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+
+#ifdef HAVE_SYS_SOCKET_H
+#  include <sys/socket.h>
+#elif HAVE_WS2TCPIP_H
+#  include <ws2tcpip.h>
+#endif
+
+#include "hamlib/rig.h"
+#include "udp_batch.h"
+
+#if defined(HAVE_SENDMMSG) && defined(HAVE_RECVMMSG) && defined(MSG_DONTWAIT)
+#  define UDP_BATCH_MMSG 1
+#endif
+
+#ifndef _WIN32
+#  define UDP_BATCH_GATHER 1    /* sendmsg() sends a datagram of several parts */
+#endif
+
+#if defined(__linux__) && defined(UDP_BATCH_MMSG)
+#  include <netinet/in.h>
+#  include <netinet/udp.h>
+#  ifndef SOL_UDP
+#    define SOL_UDP 17
+#  endif
+#  ifndef UDP_SEGMENT
+#    define UDP_SEGMENT 103
+#  endif
+#  ifndef UDP_GRO
+#    define UDP_GRO 104
+#  endif
+#  define UDP_BATCH_OFFLOAD 1
+#endif
+
+
+void udp_batch_stats_add(struct udp_batch_stats *stats, uint64_t packets,
+                         uint64_t syscalls, uint64_t errors,
+                         uint64_t offloaded)
+{
+    __atomic_add_fetch(&stats->packets, packets, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->syscalls, syscalls, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->errors, errors, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->offloaded, offloaded, __ATOMIC_RELAXED);
+}
+
+
+int udp_batch_init(struct udp_batch *batch, int socket_fd, const void *dest,
+                   int dest_len)
+{
+    if (udp_batch_set_dest(batch, dest, dest_len) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    batch->socket_fd = socket_fd;
+    batch->depth = UDP_BATCH_MAX;
+    batch->gso = 0;
+    batch->count = 0;
+    batch->used = 0;
+    memset(&batch->stats, 0, sizeof(batch->stats));
+
+    return RIG_OK;
+}
+
+
+int udp_batch_set_dest(struct udp_batch *batch, const void *dest,
+                       int dest_len)
+{
+    if (dest_len <= 0 || dest_len > (int)sizeof(batch->dest))
+    {
+        return -RIG_EINVAL;
+    }
+
+    memcpy(batch->dest, dest, dest_len);
+    batch->dest_len = dest_len;
+
+    return RIG_OK;
+}
+
+
+void udp_batch_set_depth(struct udp_batch *batch, int depth)
+{
+    batch->depth = depth < 1 ? 1
+                   : depth > UDP_BATCH_DEPTH_MAX ? UDP_BATCH_DEPTH_MAX : depth;
+}
+
+
+int udp_batch_enable_gso(struct udp_batch *batch)
+{
+#ifdef UDP_BATCH_OFFLOAD
+    int size = 0;
+    socklen_t len = sizeof(size);
+
+    // Kernels that know UDP_SEGMENT (4.18 on) answer for it
+    batch->gso = getsockopt(batch->socket_fd, SOL_UDP, UDP_SEGMENT, &size,
+                            &len) == 0;
+#else
+    batch->gso = 0;
+#endif
+
+    return batch->gso;
+}
+
+
+unsigned char *udp_batch_reserve(struct udp_batch *batch, size_t size)
+{
+    if (size > sizeof(batch->buffer))
+    {
+        return NULL;
+    }
+
+    if (batch->count >= batch->depth
+            || sizeof(batch->buffer) - batch->used < size)
+    {
+        udp_batch_flush(batch);
+    }
+
+    return batch->buffer + batch->used;
+}
+
+
+void udp_batch_commit(struct udp_batch *batch, size_t length)
+{
+    batch->offset[batch->count] = batch->used;
+    batch->length[batch->count] = length;
+    batch->data[batch->count] = NULL;
+    batch->data_len[batch->count] = 0;
+    batch->used += length;
+    batch->count++;
+}
+
+
+void udp_batch_commit_gather(struct udp_batch *batch, size_t length,
+                             const void *data, size_t data_len)
+{
+#ifdef UDP_BATCH_GATHER
+    udp_batch_commit(batch, length);
+    batch->data[batch->count - 1] = data;
+    batch->data_len[batch->count - 1] = data_len;
+#else
+    memcpy(batch->buffer + batch->used + length, data, data_len);
+    udp_batch_commit(batch, length + data_len);
+#endif
+}
+
+
+#ifdef UDP_BATCH_GATHER
+
+/* The queued datagrams from first on as messages to send, and how many
+ * datagrams each carries */
+struct udp_batch_send
+{
+    struct msghdr msgs[UDP_BATCH_DEPTH_MAX];
+    int segments[UDP_BATCH_DEPTH_MAX];
+    struct iovec iov[UDP_BATCH_DEPTH_MAX * 2];
+#ifdef UDP_BATCH_OFFLOAD
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control[UDP_BATCH_DEPTH_MAX];
+#endif
+};
+
+
+static size_t udp_batch_size(const struct udp_batch *batch, int i)
+{
+    return batch->length[i] + batch->data_len[i];
+}
+
+
+/* One message per datagram; with GSO one per run of datagrams of the same
+ * size, of which the last may be shorter, for the kernel to split.
+ * Returns the number of messages. */
+static int udp_batch_messages(struct udp_batch *batch, int first,
+                              struct udp_batch_send *send)
+{
+    int msg = 0, iovs = 0, i = first;
+
+    while (i < batch->count)
+    {
+        struct msghdr *hdr = &send->msgs[msg];
+        size_t size = udp_batch_size(batch, i), total = 0;
+        int start = iovs, n = 0;
+
+        memset(hdr, 0, sizeof(*hdr));
+        hdr->msg_name = batch->dest;
+        hdr->msg_namelen = batch->dest_len;
+        hdr->msg_iov = &send->iov[start];
+
+        do
+        {
+            size_t len = udp_batch_size(batch, i);
+
+            send->iov[iovs].iov_base = batch->buffer + batch->offset[i];
+            send->iov[iovs++].iov_len = batch->length[i];
+
+            if (batch->data[i])
+            {
+                send->iov[iovs].iov_base = (void *)batch->data[i];
+                send->iov[iovs++].iov_len = batch->data_len[i];
+            }
+
+            total += len;
+            n++;
+            i++;
+
+            if (len < size)
+            {
+                break;
+            }
+        }
+        while (batch->gso && size > 0 && i < batch->count
+                && n < UDP_BATCH_GSO_MAX_SEGMENTS
+                && udp_batch_size(batch, i) <= size
+                && total + udp_batch_size(batch, i) <= UDP_BATCH_GSO_MAX_BYTES);
+
+        hdr->msg_iovlen = iovs - start;
+
+#ifdef UDP_BATCH_OFFLOAD
+
+        if (n > 1)
+        {
+            uint16_t segment = (uint16_t)size;
+            struct cmsghdr *cmsg;
+
+            hdr->msg_control = send->control[msg].buf;
+            hdr->msg_controllen = sizeof(send->control[msg].buf);
+            cmsg = CMSG_FIRSTHDR(hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(segment));
+            memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+        }
+
+#endif
+
+        send->segments[msg++] = n;
+    }
+
+    return msg;
+}
+
+#endif
+
+
+int udp_batch_flush(struct udp_batch *batch)
+{
+    int sent = 0, errors = 0, syscalls = 0, offloaded = 0;
+    int next = 0;           // First datagram neither sent nor dropped
+
+    while (next < batch->count)
+    {
+        int result, i;
+
+#if defined(UDP_BATCH_MMSG)
+        struct udp_batch_send send;
+        struct mmsghdr msgs[UDP_BATCH_DEPTH_MAX];
+        int count = udp_batch_messages(batch, next, &send);
+
+        for (i = 0; i < count; i++)
+        {
+            msgs[i].msg_hdr = send.msgs[i];
+            msgs[i].msg_len = 0;
+        }
+
+        result = sendmmsg(batch->socket_fd, msgs, count, 0);
+#elif defined(UDP_BATCH_GATHER)
+        struct udp_batch_send send;
+
+        udp_batch_messages(batch, next, &send);
+        result = sendmsg(batch->socket_fd, &send.msgs[0], 0) < 0 ? -1 : 1;
+#else
+        // Gathered data was copied in, one datagram a call
+        int segments = 1;
+
+        result = sendto(batch->socket_fd,
+                        (const char *)batch->buffer + batch->offset[next],
+                        batch->length[next], 0,
+                        (const struct sockaddr *)batch->dest,
+                        batch->dest_len) < 0 ? -1 : 1;
+#endif
+
+        syscalls++;
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+#ifdef UDP_BATCH_OFFLOAD
+
+            // No GSO on this route or device: split the runs ourselves
+            if (send.segments[0] > 1 && (errno == EIO || errno == EINVAL
+                                         || errno == ENOPROTOOPT || errno == EOPNOTSUPP))
+            {
+                rig_debug(RIG_DEBUG_VERBOSE, "%s: UDP GSO refused (%s), sending "
+                          "datagrams one by one\n", __func__, strerror(errno));
+                batch->gso = 0;
+                continue;
+            }
+
+#endif
+
+            // The datagrams at the front were refused; go on past them
+            rig_debug(RIG_DEBUG_ERR, "%s: error sending UDP packet: %s\n", __func__,
+                      strerror(errno));
+#ifdef UDP_BATCH_GATHER
+            errors += send.segments[0];
+            next += send.segments[0];
+#else
+            errors += segments;
+            next += segments;
+#endif
+            continue;
+        }
+
+        for (i = 0; i < result; i++)
+        {
+#ifdef UDP_BATCH_GATHER
+            int segments = send.segments[i];
+#endif
+
+            sent += segments;
+            offloaded += segments > 1 ? segments : 0;
+            next += segments;
+        }
+    }
+
+    udp_batch_stats_add(&batch->stats, sent, syscalls, errors, offloaded);
+
+    batch->count = 0;
+    batch->used = 0;
+
+    return errors ? -RIG_EIO : RIG_OK;
+}
+
+
+int udp_recv_batch(struct udp_recv_batch *batch, int socket_fd)
+{
+#ifdef UDP_BATCH_MMSG
+    struct mmsghdr msgs[UDP_RECV_BATCH_MAX];
+    struct iovec iov[UDP_RECV_BATCH_MAX];
+    int i, result;
+
+    memset(msgs, 0, sizeof(msgs));
+
+    for (i = 0; i < UDP_RECV_BATCH_MAX; i++)
+    {
+        iov[i].iov_base = batch->data[i];
+        iov[i].iov_len = UDP_RECV_DATAGRAM_SIZE;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    result = recvmmsg(socket_fd, msgs, UDP_RECV_BATCH_MAX, MSG_DONTWAIT, NULL);
+    batch->count = 0;
+
+    if (result < 0)
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : result;
+    }
+
+    for (i = 0; i < result; i++)
+    {
+        batch->length[i] = msgs[i].msg_len;
+        batch->data[i][msgs[i].msg_len] = '\0';
+    }
+
+    batch->count = result;
+    udp_batch_stats_add(&batch->stats, result, 1, 0, 0);
+
+    return result;
+
+#else
+    // Without a way to not block, only the datagram select() saw is taken
+    ssize_t result = recvfrom(socket_fd, batch->data[0], UDP_RECV_DATAGRAM_SIZE, 0,
+                              NULL, NULL);
+
+    batch->count = 0;
+
+    if (result < 0)
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : (int)result;
+    }
+
+    batch->length[0] = result;
+    batch->data[0][result] = '\0';
+    batch->count = 1;
+    udp_batch_stats_add(&batch->stats, 1, 1, 0, 0);
+
+    return 1;
+#endif
+}
+
+
+int udp_recv_queue_init(struct udp_recv_queue *queue, int socket_fd,
+                        int depth, size_t datagram_size, int gro)
+{
+    memset(queue, 0, sizeof(*queue));
+
+    if (depth < 1 || depth > UDP_BATCH_DEPTH_MAX || datagram_size == 0
+            || datagram_size > UDP_RECV_GRO_SLOT_SIZE)
+    {
+        return -RIG_EINVAL;
+    }
+
+    queue->socket_fd = socket_fd;
+    queue->depth = depth;
+    queue->slot_size = datagram_size;
+
+#ifdef UDP_BATCH_OFFLOAD
+
+    if (gro)
+    {
+        int on = 1;
+
+        // Coalesced datagrams may fill the largest slot there is
+        if (setsockopt(socket_fd, SOL_UDP, UDP_GRO, &on, sizeof(on)) == 0)
+        {
+            queue->gro = 1;
+            queue->slot_size = UDP_RECV_GRO_SLOT_SIZE;
+        }
+    }
+
+#else
+    (void)gro;
+#endif
+
+    queue->data = malloc(depth * queue->slot_size);
+    queue->from = calloc(depth, sizeof(struct sockaddr_storage));
+
+    if (!queue->data || !queue->from)
+    {
+        udp_recv_queue_free(queue);
+        return -RIG_ENOMEM;
+    }
+
+    return RIG_OK;
+}
+
+
+void udp_recv_queue_free(struct udp_recv_queue *queue)
+{
+    free(queue->data);
+    free(queue->from);
+    queue->data = NULL;
+    queue->from = NULL;
+    queue->count = 0;
+}
+
+
+int udp_recv_queue_fill(struct udp_recv_queue *queue)
+{
+    struct sockaddr_storage *from = queue->from;
+    uint64_t datagrams = 0, offloaded = 0;
+    int i, result;
+
+    queue->count = 0;
+    queue->slot = 0;
+    queue->pos = 0;
+
+#ifdef UDP_BATCH_MMSG
+    struct mmsghdr msgs[UDP_BATCH_DEPTH_MAX];
+    struct iovec iov[UDP_BATCH_DEPTH_MAX];
+#ifdef UDP_BATCH_OFFLOAD
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control[UDP_BATCH_DEPTH_MAX];
+#endif
+
+    memset(msgs, 0, sizeof(msgs[0]) * queue->depth);
+
+    for (i = 0; i < queue->depth; i++)
+    {
+        iov[i].iov_base = queue->data + i * queue->slot_size;
+        iov[i].iov_len = queue->slot_size;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &from[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+#ifdef UDP_BATCH_OFFLOAD
+
+        if (queue->gro)
+        {
+            msgs[i].msg_hdr.msg_control = control[i].buf;
+            msgs[i].msg_hdr.msg_controllen = sizeof(control[i].buf);
+        }
+
+#endif
+    }
+
+    result = recvmmsg(queue->socket_fd, msgs, queue->depth, MSG_DONTWAIT, NULL);
+
+    if (result < 0)
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : result;
+    }
+
+    for (i = 0; i < result; i++)
+    {
+        queue->length[i] = msgs[i].msg_len;
+        queue->segment[i] = 0;
+        datagrams++;
+
+#ifdef UDP_BATCH_OFFLOAD
+        struct cmsghdr *cmsg;
+
+        for (cmsg = queue->gro ? CMSG_FIRSTHDR(&msgs[i].msg_hdr) : NULL; cmsg;
+                cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+        {
+            int segment;
+
+            if (cmsg->cmsg_level != SOL_UDP || cmsg->cmsg_type != UDP_GRO)
+            {
+                continue;
+            }
+
+            memcpy(&segment, CMSG_DATA(cmsg), sizeof(segment));
+
+            if (segment > 0 && (size_t)segment < queue->length[i])
+            {
+                size_t n = (queue->length[i] + segment - 1) / segment;
+
+                queue->segment[i] = segment;
+                datagrams += n - 1;
+                offloaded += n;
+            }
+        }
+
+#endif
+    }
+
+#else
+    // Without a way to not block, only the datagram select() saw is taken
+    socklen_t from_len = sizeof(from[0]);
+    ssize_t n = recvfrom(queue->socket_fd, (char *)queue->data, queue->slot_size,
+                         0, (struct sockaddr *)&from[0], &from_len);
+
+    if (n < 0)
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : (int)n;
+    }
+
+    queue->length[0] = n;
+    queue->segment[0] = 0;
+    datagrams = 1;
+    result = 1;
+#endif
+
+    queue->count = result;
+    udp_batch_stats_add(&queue->stats, datagrams, 1, 0, offloaded);
+
+    return result;
+}
+
+
+const unsigned char *udp_recv_queue_next(struct udp_recv_queue *queue,
+        size_t *length, const void **from)
+{
+    const unsigned char *datagram;
+    size_t left, segment;
+
+    if (queue->slot >= queue->count)
+    {
+        return NULL;
+    }
+
+    datagram = queue->data + queue->slot * queue->slot_size + queue->pos;
+    left = queue->length[queue->slot] - queue->pos;
+    segment = queue->segment[queue->slot];
+    *length = segment && segment < left ? segment : left;
+
+    if (from)
+    {
+        *from = (struct sockaddr_storage *)queue->from + queue->slot;
+    }
+
+    queue->pos += *length;
+
+    if (queue->pos >= queue->length[queue->slot])
+    {
+        queue->slot++;
+        queue->pos = 0;
+    }
+
+    return datagram;
+}
+
+
+void udp_batch_stats_get(const struct udp_batch_stats *stats,
+                         struct udp_batch_stats *copy)
+{
+    copy->packets = __atomic_load_n(&stats->packets, __ATOMIC_RELAXED);
+    copy->syscalls = __atomic_load_n(&stats->syscalls, __ATOMIC_RELAXED);
+    copy->errors = __atomic_load_n(&stats->errors, __ATOMIC_RELAXED);
+    copy->offloaded = __atomic_load_n(&stats->offloaded, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,182 @@
+/*
+ *  Hamlib Interface - batched UDP datagram I/O
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Datagrams queued to one destination and sent with a single sendmmsg()
+ * where the system has it, one sendto() each elsewhere; and the receiving
+ * counterpart draining a socket with recvmmsg() or recvfrom().  Packets
+ * are built in place in the batch buffer, so queueing copies nothing.
+ *
+ * On Linux a run of equal-sized datagrams can also go to the kernel as one
+ * UDP GSO datagram (UDP_SEGMENT) that it splits on the way out, and a
+ * udp_recv_queue with GRO (UDP_GRO) takes datagrams the kernel coalesced
+ * and splits them again. */
+
+#ifndef _UDP_BATCH_H
+#define _UDP_BATCH_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hamlib/rig.h"
+
+__BEGIN_DECLS
+
+#define UDP_BATCH_MAX 16                /* Datagrams per send call */
+#define UDP_BATCH_DEPTH_MAX 64          /* Most udp_batch_set_depth() allows */
+#define UDP_BATCH_BUFFER_SIZE 131072
+#define UDP_BATCH_GSO_MAX_BYTES 65000   /* Largest datagram handed to GSO */
+#define UDP_BATCH_GSO_MAX_SEGMENTS 64   /* The kernel's limit */
+#define UDP_RECV_BATCH_MAX 8            /* Datagrams per receive call */
+#define UDP_RECV_DATAGRAM_SIZE 4096
+#define UDP_RECV_GRO_SLOT_SIZE 65536    /* A slot GRO may fill */
+
+/* Counters of one side, updated with atomics so another thread may read
+ * them: packets / syscalls is the batching achieved */
+struct udp_batch_stats
+{
+    uint64_t packets;
+    uint64_t syscalls;
+    uint64_t errors;            /* Datagrams the system refused */
+    uint64_t offloaded;         /* Of packets, those segmented by GSO or
+                                   coalesced by GRO */
+};
+
+struct udp_batch
+{
+    int socket_fd;
+    unsigned char dest[32];     /* struct sockaddr of dest_len bytes */
+    int dest_len;
+    int depth;                  /* Datagrams queued before a flush */
+    int gso;                    /* 1 while runs go out as GSO datagrams */
+    int count;                  /* Datagrams queued */
+    size_t used;                /* Bytes of buffer they take */
+    size_t offset[UDP_BATCH_DEPTH_MAX];
+    size_t length[UDP_BATCH_DEPTH_MAX];
+    const unsigned char *data[UDP_BATCH_DEPTH_MAX]; /* Sent after the
+                                                       buffer bytes, or NULL */
+    size_t data_len[UDP_BATCH_DEPTH_MAX];
+    struct udp_batch_stats stats;
+    unsigned char buffer[UDP_BATCH_BUFFER_SIZE];
+};
+
+struct udp_recv_batch
+{
+    int count;                  /* Datagrams from the last receive */
+    size_t length[UDP_RECV_BATCH_MAX];
+    struct udp_batch_stats stats;
+    /* Each NUL terminated after length bytes */
+    char data[UDP_RECV_BATCH_MAX][UDP_RECV_DATAGRAM_SIZE + 1];
+};
+
+/* A receiver for datagrams up to datagram_size bytes that keeps where each
+ * came from.  With GRO one slot may hold several datagrams the kernel
+ * coalesced; udp_recv_queue_next() hands them out one by one either way. */
+struct udp_recv_queue
+{
+    int socket_fd;
+    int depth;                  /* Slots, datagrams per receive call */
+    int gro;                    /* 1 when the kernel coalesces */
+    size_t slot_size;
+    int count;                  /* Slots filled by the last receive */
+    int slot;                   /* Next slot udp_recv_queue_next() reads */
+    size_t pos;                 /* and where in it */
+    size_t length[UDP_BATCH_DEPTH_MAX];
+    size_t segment[UDP_BATCH_DEPTH_MAX]; /* Size of the coalesced datagrams,
+                                            0 when a slot holds one */
+    struct udp_batch_stats stats;
+    unsigned char *data;        /* depth slots of slot_size bytes */
+    void *from;                 /* depth struct sockaddr_storage */
+};
+
+/* dest is a struct sockaddr of dest_len bytes; returns -RIG_EINVAL when
+ * it does not fit.  The batch starts at UDP_BATCH_MAX datagrams, without
+ * GSO. */
+int udp_batch_init(struct udp_batch *batch, int socket_fd, const void *dest,
+                   int dest_len);
+
+/* Send the datagrams queued from now on to dest instead */
+int udp_batch_set_dest(struct udp_batch *batch, const void *dest,
+                       int dest_len);
+
+/* Datagrams queued before the batch flushes itself, 1 to
+ * UDP_BATCH_DEPTH_MAX */
+void udp_batch_set_depth(struct udp_batch *batch, int depth);
+
+/* Send runs of equal-sized datagrams as one GSO datagram each.  Returns 1
+ * when the system can, 0 when it cannot and the batch goes on without.
+ * A send the kernel refuses for GSO turns it off again. */
+int udp_batch_enable_gso(struct udp_batch *batch);
+
+/* Room for a datagram of at most size bytes, flushing the batch first
+ * when it is full.  Nothing is queued until udp_batch_commit().  NULL
+ * when size is larger than the buffer. */
+unsigned char *udp_batch_reserve(struct udp_batch *batch, size_t size);
+void udp_batch_commit(struct udp_batch *batch, size_t length);
+
+/* Queue the length bytes reserved followed by data_len bytes at data,
+ * which must stay as they are until the batch is flushed.  The
+ * reservation must have room for both: where the system cannot send
+ * gathered datagrams, data is copied in after the reserved bytes. */
+void udp_batch_commit_gather(struct udp_batch *batch, size_t length,
+                             const void *data, size_t data_len);
+
+/* Send every queued datagram.  Returns RIG_OK, or -RIG_EIO when some of
+ * them could not be sent; those are counted in errors and dropped. */
+int udp_batch_flush(struct udp_batch *batch);
+
+/* Wait for nothing: take the datagrams already queued on socket_fd, at
+ * least one when select() said it is readable.  Returns their number, 0
+ * when none were waiting or < 0 with errno set. */
+int udp_recv_batch(struct udp_recv_batch *batch, int socket_fd);
+
+/* depth slots (1 to UDP_BATCH_DEPTH_MAX) for datagrams of at most
+ * datagram_size bytes; gro asks the kernel to coalesce, which takes
+ * UDP_RECV_GRO_SLOT_SIZE slots where it can.  Returns RIG_OK,
+ * -RIG_EINVAL or -RIG_ENOMEM. */
+int udp_recv_queue_init(struct udp_recv_queue *queue, int socket_fd,
+                        int depth, size_t datagram_size, int gro);
+void udp_recv_queue_free(struct udp_recv_queue *queue);
+
+/* Like udp_recv_batch(): take the datagrams already waiting, at least one
+ * when select() said the socket is readable.  Returns the slots filled, 0
+ * when nothing was waiting or < 0 with errno set.  Datagrams not yet read
+ * with udp_recv_queue_next() are dropped. */
+int udp_recv_queue_fill(struct udp_recv_queue *queue);
+
+/* The next datagram of the last fill and its length, or NULL when all
+ * were read.  from, when not NULL, is set to the struct sockaddr it came
+ * from. */
+const unsigned char *udp_recv_queue_next(struct udp_recv_queue *queue,
+        size_t *length, const void **from);
+
+/* Add to the counters, as the batch functions do */
+void udp_batch_stats_add(struct udp_batch_stats *stats, uint64_t packets,
+                         uint64_t syscalls, uint64_t errors,
+                         uint64_t offloaded);
+
+/* Copy the counters, safe while the owning thread updates them */
+void udp_batch_stats_get(const struct udp_batch_stats *stats,
+                         struct udp_batch_stats *copy);
+
+__END_DECLS
+
+#endif /* _UDP_BATCH_H */
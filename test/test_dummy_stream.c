@@ -30,8 +30,11 @@
 #include "test_debug.h"
 #include <hamlib/rig.h>
 #include "hamlib/rig_state.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
 
 #include "stream_time.h"
 
@@ -2008,7 +2011,6 @@ void test_loopback_s16_mono_to_f32_stereo(void)
 /* Loopback — sample rate conversion                                   */
 /* ------------------------------------------------------------------ */
 
-#ifdef HAVE_SAMPLERATE
 void test_loopback_resample_8k_to_48k(void)
 {
     RIG *rig = open_dummy();
@@ -2113,7 +2115,6 @@ void test_loopback_resample_8k_to_48k(void)
     priv->stream_mode = DUMMY_STREAM_TONE;
     close_dummy(rig);
 }
-#endif /* HAVE_SAMPLERATE */
 
 
 /* ------------------------------------------------------------------ */
@@ -2539,84 +2540,6 @@ void test_format_negotiation(void)
 }
 
 
-/* ------------------------------------------------------------------ */
-/* Resample unavailable (no libsamplerate)                             */
-/* ------------------------------------------------------------------ */
-
-#ifndef HAVE_SAMPLERATE
-void test_loopback_resample_unavailable(void)
-{
-    RIG *rig = open_dummy();
-    TEST_ASSERT(rig != NULL);
-
-    struct dummy_priv_data *priv =
-        (struct dummy_priv_data *)HAMLIB_STATE(rig)->priv;
-    priv->stream_mode = DUMMY_STREAM_LOOPBACK;
-
-    /* TX at 8kHz, RX at 48kHz — should fail without libsamplerate.
-     * The loopback thread will silently fail to resample, producing
-     * no output. We just verify data flow still works without crashing. */
-    struct rig_stream_config *tx_config = rig_stream_config_alloc();
-    TEST_ASSERT(tx_config != NULL);
-    tx_config->type = RIG_STREAM_TYPE_AUDIO_TX;
-    tx_config->format = RIG_STREAM_FORMAT_PCM_F32;
-    tx_config->sample_rate = 8000;
-    tx_config->channels = 1;
-    tx_config->frame_samples = 0;
-    tx_config->buffer_bytes = 0;
-    rig_stream_t *tx_stream = NULL;
-    int ret = rig_stream_open(rig, tx_config, &tx_stream);
-
-    /* the stream copied the config; releasing it here is safe */
-    rig_stream_config_free(tx_config);
-    TEST_ASSERT(ret == RIG_OK);
-
-    struct rig_stream_config *rx_config = rig_stream_config_alloc();
-    TEST_ASSERT(rx_config != NULL);
-    rx_config->type = RIG_STREAM_TYPE_AUDIO_RX;
-    rx_config->format = RIG_STREAM_FORMAT_PCM_F32;
-    rx_config->sample_rate = 48000;
-    rx_config->channels = 1;
-    rx_config->frame_samples = 0;
-    rx_config->buffer_bytes = 0;
-    rig_stream_t *rx_stream = NULL;
-    ret = rig_stream_open(rig, rx_config, &rx_stream);
-
-    /* the stream copied the config; releasing it here is safe */
-    rig_stream_config_free(rx_config);
-    TEST_ASSERT(ret == RIG_OK);
-
-    /* Write data — resample will fail, no data on RX side */
-    float tx_data[80];
-
-    for (int i = 0; i < 80; i++)
-    {
-        tx_data[i] = 0.5f * sinf(2.0f * (float)M_PI * (float)i / 80.0f);
-    }
-
-    size_t bytes_written = 0;
-    ret = rig_stream_write(rig, tx_stream, tx_data, sizeof(tx_data),
-                           &bytes_written, 100, NULL);
-    TEST_CHECK(ret == RIG_OK);
-
-    /* Read with short timeout — expect timeout (no resampled data) */
-    float rx_data[480];
-    size_t bytes_read = 0;
-    ret = rig_stream_read(rig, rx_stream, rx_data, sizeof(rx_data),
-                          &bytes_read, 100, NULL);
-
-    /* Without libsamplerate, the resample step fails and no data arrives */
-    TEST_CHECK(bytes_read == 0 || ret == -RIG_ETIMEOUT);
-    TEST_MSG("Without libsamplerate: bytes_read=%zu, ret=%d", bytes_read, ret);
-
-    rig_stream_close(rig, rx_stream);
-    rig_stream_close(rig, tx_stream);
-    priv->stream_mode = DUMMY_STREAM_TONE;
-    close_dummy(rig);
-}
-#endif /* !HAVE_SAMPLERATE */
-
-
 /* ------------------------------------------------------------------ */
 /* Time model tests: anchors, synthetic gaps, timed TX                 */
 /* ------------------------------------------------------------------ */
@@ -2732,6 +2655,374 @@ void test_synthetic_gap_reporting(void)
 }
 
 
+/* ------------------------------------------------------------------ */
+/* File replay                                                         */
+/* ------------------------------------------------------------------ */
+
+static void replay_path(char *path, size_t size, const char *name)
+{
+    snprintf(path, size, "/tmp/hamlib_replay_%d_%s", (int)getpid(), name);
+}
+
+
+static void put_le16(unsigned char *p, unsigned int v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+
+static void put_le32(unsigned char *p, uint32_t v)
+{
+    put_le16(p, v & 0xffff);
+    put_le16(p + 2, v >> 16);
+}
+
+
+/* A SigMF recording replayed at real-time pace: the samples arrive
+ * converted, the global_index jump between its captures comes out as a
+ * gap, and the captures' time and frequency reach the reader. */
+void test_replay_sigmf_gap_time(void)
+{
+    enum { FRAMES = 4800, SPLIT = 2400, GAP = 100 };
+    char base[256], data_path[300], meta_path[300];
+
+    replay_path(base, sizeof(base), "iq");
+    snprintf(data_path, sizeof(data_path), "%s.sigmf-data", base);
+    snprintf(meta_path, sizeof(meta_path), "%s.sigmf-meta", base);
+
+    FILE *f = fopen(data_path, "wb");
+    TEST_ASSERT(f != NULL);
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        unsigned char iq[4];
+        put_le16(iq, (uint16_t)i);
+        put_le16(iq + 2, (uint16_t)(-i));
+        fwrite(iq, 1, sizeof(iq), f);
+    }
+
+    fclose(f);
+
+    f = fopen(meta_path, "w");
+    TEST_ASSERT(f != NULL);
+    fprintf(f, "{\"global\":{\"core:datatype\":\"ci16_le\","
+            "\"core:sample_rate\":48000,\"core:version\":\"1.0.0\"},"
+            "\"captures\":["
+            "{\"core:sample_start\":0,\"core:global_index\":0,"
+            "\"core:frequency\":7100000,"
+            "\"core:datetime\":\"2026-01-02T03:04:05.5Z\"},"
+            "{\"core:sample_start\":%d,\"core:global_index\":%d}],"
+            "\"annotations\":[]}\n", SPLIT, SPLIT + GAP);
+    fclose(f);
+
+    RIG *rig = open_dummy();
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "stream_mode"),
+                             "replay") == RIG_OK);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_file"),
+                             meta_path) == RIG_OK);
+
+    struct rig_stream_config *config = rig_stream_config_alloc();
+    TEST_ASSERT(config != NULL);
+    config->type = RIG_STREAM_TYPE_IQ_RX;
+    config->format = RIG_STREAM_FORMAT_IQ_CF32;
+    config->sample_rate = 48000;
+    config->channels = 1;
+    rig_stream_t *stream = NULL;
+    TEST_ASSERT(rig_stream_open(rig, config, &stream) == RIG_OK);
+    rig_stream_config_free(config);
+
+    static float buf[FRAMES * 2];
+    struct rig_stream_read_info info;
+    size_t got = 0, frames = 0;
+    int first = 1, bad = 0;
+    uint32_t dropped = 0;
+
+    for (int i = 0; i < 200 && frames < FRAMES; i++)
+    {
+        if (rig_stream_read(rig, stream, buf, sizeof(buf) - frames * 8, &got,
+                            200, &info) != RIG_OK || got == 0)
+        {
+            continue;
+        }
+
+        if (first)
+        {
+            TEST_CHECK(info.time_valid);
+            TEST_CHECK_(info.seconds == 1767323045, "seconds=%lld",
+                        (long long)info.seconds);
+            TEST_CHECK(info.picoseconds == 500000000000ULL);
+            first = 0;
+        }
+
+        /* A read starting at the second capture has its time, run on from
+         * the first across the gap (the ring places a gap exactly only for
+         * a reader that kept up) */
+        if (info.dropped_samples > 0)
+        {
+            dropped += info.dropped_samples;
+            TEST_CHECK(info.drop_flags & RIG_STREAM_DROP_GAP);
+        }
+
+        if (info.dropped_samples > 0 && frames == SPLIT)
+        {
+            TEST_CHECK(info.time_valid);
+            TEST_CHECK(info.seconds == 1767323045);
+            TEST_CHECK_(llabs((long long)info.picoseconds
+                              - (500000000000LL + (SPLIT + GAP)
+                                 * 1000000000000LL / 48000)) < 1000000,
+                        "picoseconds=%llu",
+                        (unsigned long long)info.picoseconds);
+        }
+
+        for (size_t k = 0; k < got / 8; k++, frames++)
+        {
+            if (fabsf(buf[2 * k] - frames / 32768.0f) > 1e-6f
+                    || fabsf(buf[2 * k + 1] + frames / 32768.0f) > 1e-6f)
+            {
+                bad++;
+            }
+        }
+    }
+
+    TEST_CHECK_(frames == FRAMES, "frames=%zu", frames);
+    TEST_CHECK_(bad == 0, "%d samples differ", bad);
+    TEST_CHECK_(dropped == GAP, "dropped=%u", dropped);
+
+    struct rig_stream_metadata meta;
+    memset(&meta, 0, sizeof(meta));
+    TEST_CHECK(rig_stream_read_metadata(rig, stream, &meta) == RIG_OK);
+    TEST_CHECK(meta.field_mask & RIG_STREAM_META_CENTER_FREQ);
+    TEST_CHECK(meta.center_freq == 7100000);
+
+    rig_stream_close(rig, stream);
+
+    rig_set_conf(rig, rig_token_lookup(rig, "stream_mode"), "tone");
+    rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_file"), "");
+    close_dummy(rig);
+    unlink(data_path);
+    unlink(meta_path);
+}
+
+
+/* A broadcast WAV looped: the file's samples over and over, timed from its
+ * bext reference; a file that is missing fails the open. */
+void test_replay_wav_loop(void)
+{
+    enum { FRAMES = 960, BEXT = 602 };
+    static unsigned char wav[12 + 8 + BEXT + 8 + 16 + 8 + FRAMES * 2];
+    unsigned char *p = wav;
+    char path[256];
+
+    memcpy(p, "RIFF", 4);
+    put_le32(p + 4, sizeof(wav) - 8);
+    memcpy(p + 8, "WAVE", 4);
+    p += 12;
+    memcpy(p, "bext", 4);
+    put_le32(p + 4, BEXT);
+    memcpy(p + 8 + 320, "2026-01-02", 10);
+    memcpy(p + 8 + 330, "00:00:10", 8);
+    put_le32(p + 8 + 338, 480000);         /* 10 s past midnight */
+    p += 8 + BEXT;
+    memcpy(p, "fmt ", 4);
+    put_le32(p + 4, 16);
+    put_le16(p + 8, 1);
+    put_le16(p + 10, 1);
+    put_le32(p + 12, 48000);
+    put_le32(p + 16, 96000);
+    put_le16(p + 20, 2);
+    put_le16(p + 22, 16);
+    p += 8 + 16;
+    memcpy(p, "data", 4);
+    put_le32(p + 4, FRAMES * 2);
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        put_le16(p + 8 + 2 * i, (uint16_t)(i * 16));
+    }
+
+    replay_path(path, sizeof(path), "audio.wav");
+    FILE *f = fopen(path, "wb");
+    TEST_ASSERT(f != NULL);
+    fwrite(wav, 1, sizeof(wav), f);
+    fclose(f);
+
+    RIG *rig = open_dummy();
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "stream_mode"),
+                             "replay") == RIG_OK);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_loop"),
+                             "1") == RIG_OK);
+
+    struct rig_stream_config *config = rig_stream_config_alloc();
+    TEST_ASSERT(config != NULL);
+    config->type = RIG_STREAM_TYPE_AUDIO_RX;
+    config->format = RIG_STREAM_FORMAT_PCM_S16;
+    config->sample_rate = 48000;
+    config->channels = 1;
+    rig_stream_t *stream = NULL;
+
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_file"),
+                             "/tmp/hamlib_replay_missing.wav") == RIG_OK);
+    TEST_CHECK(rig_stream_open(rig, config, &stream) != RIG_OK);
+
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_file"),
+                             path) == RIG_OK);
+    TEST_ASSERT(rig_stream_open(rig, config, &stream) == RIG_OK);
+    rig_stream_config_free(config);
+
+    int16_t buf[FRAMES];
+    struct rig_stream_read_info info;
+    size_t got = 0, frames = 0;
+    int first = 1, bad = 0;
+
+    /* Real-time pace: two and a half passes are 50 ms */
+    for (int i = 0; i < 100 && frames < FRAMES * 5 / 2; i++)
+    {
+        if (rig_stream_read(rig, stream, buf, sizeof(buf), &got, 200,
+                            &info) != RIG_OK || got == 0)
+        {
+            continue;
+        }
+
+        if (first)
+        {
+            TEST_CHECK(info.time_valid);
+            TEST_CHECK_(info.seconds == 1767312010, "seconds=%lld",
+                        (long long)info.seconds);
+            first = 0;
+        }
+
+        for (size_t k = 0; k < got / 2; k++, frames++)
+        {
+            if (abs(buf[k] - (int)(frames % FRAMES) * 16) > 1)
+            {
+                bad++;
+            }
+        }
+    }
+
+    TEST_CHECK_(frames >= FRAMES * 5 / 2, "frames=%zu", frames);
+    TEST_CHECK_(bad == 0, "%d samples differ", bad);
+
+    struct rig_stream_stats stats;
+    rig_stream_get_stats(rig, stream, &stats);
+    TEST_CHECK(stats.gaps == 0);
+
+    rig_stream_close(rig, stream);
+
+    rig_set_conf(rig, rig_token_lookup(rig, "stream_mode"), "tone");
+    rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_file"), "");
+    rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_loop"), "0");
+    close_dummy(rig);
+    unlink(path);
+}
+
+
+/* A fast replay of a file six times the ring into a reader that dawdles:
+ * the replay waits on the reader, so every sample arrives and none is
+ * dropped to an overrun. */
+void test_replay_fast_backpressure(void)
+{
+    enum { FRAMES = 48000, RING = 16384 };
+    static unsigned char wav[12 + 8 + 16 + 8 + FRAMES * 2];
+    unsigned char *p = wav;
+    char path[256];
+
+    memcpy(p, "RIFF", 4);
+    put_le32(p + 4, sizeof(wav) - 8);
+    memcpy(p + 8, "WAVE", 4);
+    p += 12;
+    memcpy(p, "fmt ", 4);
+    put_le32(p + 4, 16);
+    put_le16(p + 8, 1);
+    put_le16(p + 10, 1);
+    put_le32(p + 12, 48000);
+    put_le32(p + 16, 96000);
+    put_le16(p + 20, 2);
+    put_le16(p + 22, 16);
+    p += 8 + 16;
+    memcpy(p, "data", 4);
+    put_le32(p + 4, FRAMES * 2);
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        put_le16(p + 8 + 2 * i, (uint16_t)(i & 0x7fff));
+    }
+
+    replay_path(path, sizeof(path), "fast.wav");
+    FILE *f = fopen(path, "wb");
+    TEST_ASSERT(f != NULL);
+    fwrite(wav, 1, sizeof(wav), f);
+    fclose(f);
+
+    RIG *rig = open_dummy();
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "stream_mode"),
+                             "replay") == RIG_OK);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_file"),
+                             path) == RIG_OK);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_pace"),
+                             "fast") == RIG_OK);
+
+    struct rig_stream_config *config = rig_stream_config_alloc();
+    TEST_ASSERT(config != NULL);
+    config->type = RIG_STREAM_TYPE_AUDIO_RX;
+    config->format = RIG_STREAM_FORMAT_PCM_S16;
+    config->sample_rate = 48000;
+    config->channels = 1;
+    config->buffer_bytes = RING;
+    rig_stream_t *stream = NULL;
+    TEST_ASSERT(rig_stream_open(rig, config, &stream) == RIG_OK);
+    rig_stream_config_free(config);
+
+    int16_t buf[512];
+    struct rig_stream_read_info info;
+    size_t got = 0, frames = 0;
+    int bad = 0;
+    uint64_t dropped = 0;
+
+    for (int i = 0; i < 2000 && frames < FRAMES; i++)
+    {
+        /* Slower than the replay can write: it has to wait for room */
+        usleep(1000);
+
+        if (rig_stream_read(rig, stream, buf, sizeof(buf), &got, 200,
+                            &info) != RIG_OK || got == 0)
+        {
+            break;                  /* Played out short */
+        }
+
+        dropped += info.dropped_samples;
+
+        for (size_t k = 0; k < got / 2; k++, frames++)
+        {
+            if (buf[k] != (int16_t)(frames & 0x7fff))
+            {
+                bad++;
+            }
+        }
+    }
+
+    TEST_CHECK_(frames == FRAMES, "frames=%zu", frames);
+    TEST_CHECK_(bad == 0, "%d samples differ", bad);
+    TEST_CHECK_(dropped == 0, "dropped=%llu", (unsigned long long)dropped);
+
+    struct rig_stream_stats stats;
+    rig_stream_get_stats(rig, stream, &stats);
+    TEST_CHECK_(stats.overruns == 0, "overruns=%u", stats.overruns);
+
+    rig_stream_close(rig, stream);
+
+    rig_set_conf(rig, rig_token_lookup(rig, "stream_mode"), "tone");
+    rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_file"), "");
+    rig_set_conf(rig, rig_token_lookup(rig, "stream_replay_pace"), "realtime");
+    close_dummy(rig);
+    unlink(path);
+}
+
+
 void test_timed_tx_late_counter(void)
 {
     RIG *rig = open_dummy();
@@ -3010,13 +3301,11 @@ void test_conversions_bitmask(void)
     TEST_CHECK(rig_stream_get_conversions(st) == RIG_STREAM_CONV_FORMAT);
     rig_stream_close(rig, st);
 
-#ifdef HAVE_SAMPLERATE
     st = open_audio_rx(rig, RIG_STREAM_FORMAT_PCM_S16, 44100, 0, &ret);
     TEST_ASSERT(ret == RIG_OK && st != NULL);
     TEST_CHECK(rig_stream_get_conversions(st)
                == (RIG_STREAM_CONV_FORMAT | RIG_STREAM_CONV_RATE));
     rig_stream_close(rig, st);
-#endif
 
     /* Above the largest native rate: outside the effective set. */
     st = open_audio_rx(rig, RIG_STREAM_FORMAT_PCM_F32, 500000, 0, &ret);
@@ -3043,10 +3332,8 @@ void test_require_native(void)
     TEST_CHECK(ret == -RIG_ENAVAIL && st == NULL);
     TEST_MSG("expected -RIG_ENAVAIL, got %d", ret);
 
-#ifdef HAVE_SAMPLERATE
     st = open_audio_rx(rig, RIG_STREAM_FORMAT_PCM_F32, 44100, 1, &ret);
     TEST_CHECK(ret == -RIG_ENAVAIL && st == NULL);
-#endif
 
     close_dummy(rig);
 }
@@ -3203,7 +3490,6 @@ void test_codec_loopback_roundtrip(void)
 }
 
 
-#ifdef HAVE_SAMPLERATE
 /* The stream_resample_quality conf token is honored at pipeline creation:
  * a resampled open succeeds at every advertised quality level. */
 void test_resample_quality_open(void)
@@ -3293,7 +3579,6 @@ void test_audio_rx_tone_resampled(void)
     rig_stream_close(rig, stream);
     close_dummy(rig);
 }
-#endif /* HAVE_SAMPLERATE */
 
 /* I/Q rates are downward-only: above-native is rejected outright. */
 void test_iq_upsample_rejected(void)
@@ -3318,6 +3603,140 @@ void test_iq_upsample_rejected(void)
 }
 
 
+/* Open an I/Q RX stream through the decimator, returning the result */
+static int open_iq_decimated(RIG *rig, int rate, double shift,
+                             rig_stream_t **stream)
+{
+    struct rig_stream_config *config = rig_stream_config_alloc();
+    int ret;
+
+    if (!config)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    config->type = RIG_STREAM_TYPE_IQ_RX;
+    config->format = RIG_STREAM_FORMAT_IQ_CF32;
+    config->sample_rate = rate;
+    config->channels = 1;
+    config->iq_decimate = 1;
+    config->iq_shift = shift;
+    *stream = NULL;
+    ret = rig_stream_open(rig, config, stream);
+    rig_stream_config_free(config);
+
+    return ret;
+}
+
+
+/* 12 kHz decimated from the 24 kHz native rate with the window moved 2 kHz
+ * down: the +1000 Hz dummy tone lands at +3000 Hz and the reported centre
+ * moves with the shift. */
+void test_iq_decimate_shift(void)
+{
+    RIG *rig = open_dummy();
+    TEST_ASSERT(rig != NULL);
+    TEST_CHECK(rig_set_freq(rig, RIG_VFO_A, (freq_t)14200000) == RIG_OK);
+
+    rig_stream_t *stream;
+    int ret = open_iq_decimated(rig, 12000, -2000.0, &stream);
+    TEST_ASSERT(ret == RIG_OK && stream != NULL);
+    TEST_CHECK(rig_stream_get_conversions(stream)
+               == (RIG_STREAM_CONV_RATE | RIG_STREAM_CONV_SHIFT));
+
+    const size_t N = 4096;
+    float *buf = malloc(N * 2 * sizeof(float));
+    TEST_ASSERT(buf != NULL);
+
+    size_t total_bytes = 0;
+    size_t target_bytes = N * 2 * sizeof(float);
+
+    while (total_bytes < target_bytes)
+    {
+        size_t bytes_read = 0;
+        ret = rig_stream_read(rig, stream,
+                              (char *)buf + total_bytes,
+                              target_bytes - total_bytes,
+                              &bytes_read, 500, NULL);
+
+        if (ret != RIG_OK && bytes_read == 0)
+        {
+            break;
+        }
+
+        total_bytes += bytes_read;
+    }
+
+    TEST_ASSERT(total_bytes == target_bytes);
+
+    float *mag = malloc(N * sizeof(float));
+    TEST_ASSERT(mag != NULL);
+    test_fft_magnitude_complex(buf, mag, N);
+
+    size_t peak = test_fft_peak_bin(mag, N);
+    float peak_freq = test_fft_bin_to_freq(peak, N, 12000);
+
+    if (peak > N / 2)
+    {
+        peak_freq = peak_freq - 12000.0f;
+    }
+
+    /* Bin width 12000/4096 = 2.9 Hz */
+    TEST_CHECK(fabsf(peak_freq - 3000.0f) < 6.0f);
+    TEST_MSG("Expected peak near 3000 Hz, got %.1f Hz (bin %zu)", peak_freq, peak);
+
+    struct rig_stream_metadata meta;
+    TEST_CHECK(rig_stream_read_metadata(rig, stream, &meta) == RIG_OK);
+    TEST_CHECK(meta.field_mask & RIG_STREAM_META_CENTER_FREQ);
+    TEST_CHECK(meta.center_freq == 14198000);
+    TEST_MSG("Expected center_freq=14198000, got %.0f", meta.center_freq);
+
+    free(mag);
+    free(buf);
+    rig_stream_close(rig, stream);
+    close_dummy(rig);
+}
+
+
+void test_iq_decimate_rejected(void)
+{
+    RIG *rig = open_dummy();
+    TEST_ASSERT(rig != NULL);
+
+    rig_stream_t *stream;
+    int ret;
+
+    /* No native rate is a multiple of 44100 */
+    ret = open_iq_decimated(rig, 44100, 0.0, &stream);
+    TEST_CHECK(ret == -RIG_EINVAL && stream == NULL);
+
+    /* The shift must stay inside the native band */
+    ret = open_iq_decimated(rig, 12000, 15000.0, &stream);
+    TEST_CHECK(ret == -RIG_EINVAL && stream == NULL);
+
+    /* A shift needs the decimator, and audio streams have neither */
+    struct rig_stream_config *config = rig_stream_config_alloc();
+    TEST_ASSERT(config != NULL);
+    config->type = RIG_STREAM_TYPE_IQ_RX;
+    config->format = RIG_STREAM_FORMAT_IQ_CF32;
+    config->sample_rate = 48000;
+    config->channels = 1;
+    config->iq_shift = 1000.0;
+    ret = rig_stream_open(rig, config, &stream);
+    TEST_CHECK(ret == -RIG_EINVAL && stream == NULL);
+
+    config->type = RIG_STREAM_TYPE_AUDIO_RX;
+    config->format = RIG_STREAM_FORMAT_PCM_F32;
+    config->iq_shift = 0.0;
+    config->iq_decimate = 1;
+    ret = rig_stream_open(rig, config, &stream);
+    TEST_CHECK(ret == -RIG_EINVAL && stream == NULL);
+    rig_stream_config_free(config);
+
+    close_dummy(rig);
+}
+
+
 TEST_LIST =
 {
     { "caps_query",                   test_caps_query },
@@ -3334,11 +3753,11 @@ TEST_LIST =
     { "require_native",               test_require_native },
     { "codec_rx_frame_sequence",      test_codec_rx_frame_sequence },
     { "codec_loopback_roundtrip",     test_codec_loopback_roundtrip },
-#ifdef HAVE_SAMPLERATE
     { "resample_quality_open",        test_resample_quality_open },
     { "audio_rx_tone_resampled",      test_audio_rx_tone_resampled },
-#endif
     { "iq_upsample_rejected",         test_iq_upsample_rejected },
+    { "iq_decimate_shift",            test_iq_decimate_shift },
+    { "iq_decimate_rejected",         test_iq_decimate_rejected },
     { "audio_rx_tone_u8",             test_audio_rx_tone_u8 },
     { "iq_rx_tone_cs16",            test_iq_rx_tone_cs16 },
     { "iq_rx_tone_cs8",               test_iq_rx_tone_cs8 },
@@ -3355,11 +3774,7 @@ TEST_LIST =
     { "loopback_mono_to_stereo",              test_loopback_mono_to_stereo },
     { "loopback_stereo_to_mono",              test_loopback_stereo_to_mono },
     { "loopback_s16_mono_to_f32_stereo",      test_loopback_s16_mono_to_f32_stereo },
-#ifdef HAVE_SAMPLERATE
     { "loopback_resample_8k_to_48k",          test_loopback_resample_8k_to_48k },
-#else
-    { "loopback_resample_unavailable",        test_loopback_resample_unavailable },
-#endif
     { "conf_tone_freq",                        test_conf_tone_freq },
     { "dummy_metadata_freq",                   test_dummy_metadata_freq },
     { "dummy_metadata_ptt",                    test_dummy_metadata_ptt },
@@ -3370,6 +3785,9 @@ TEST_LIST =
     { "format_negotiation",                    test_format_negotiation },
     { "rx_time_info",                          test_rx_time_info },
     { "synthetic_gap_reporting",               test_synthetic_gap_reporting },
+    { "replay_sigmf_gap_time",                 test_replay_sigmf_gap_time },
+    { "replay_wav_loop",                       test_replay_wav_loop },
+    { "replay_fast_backpressure",              test_replay_fast_backpressure },
     { "timed_tx_late_counter",                 test_timed_tx_late_counter },
     { "tx_write_overrun_direct",               test_tx_write_overrun_direct },
     { "timed_tx_gates_and_keys_ptt",           test_timed_tx_gates_and_keys_ptt },
@@ -0,0 +1,308 @@
+/*
+ *  Hamlib streaming JSON writer and snapshot serializer tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Checks the writer's output byte for byte against cJSON, which the
+ * multicast snapshot was printed with before, and the snapshot CRC. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include <hamlib/rig.h>
+#include <hamlib/rig_state.h>
+#include "json_writer.h"
+#include "snapshot_data.h"
+#include "misc.h"
+#include "cJSON.h"
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+
+static char out[HAMLIB_MAX_SNAPSHOT_PACKET_SIZE];
+
+
+/* Print root the way the old snapshot code did and compare */
+static void check_same_as_cjson(cJSON *root, const char *json)
+{
+    char *expected = cJSON_PrintUnformatted(root);
+
+    TEST_ASSERT(expected != NULL);
+    TEST_CHECK(strcmp(expected, json) == 0);
+    TEST_MSG("expected: %s", expected);
+    TEST_MSG("produced: %s", json);
+
+    free(expected);
+}
+
+
+void test_numbers_match_cjson(void)
+{
+    static const double numbers[] =
+    {
+        0, -1, 42, 14074000, 1e10, 0.1, -80.5, 1.0 / 3, 2.5e-300, 1e300,
+        INT_MAX, INT_MIN, 2147483648.0, -2147483649.0, 4294967295.0,
+        123456789.123
+    };
+    struct json_writer w;
+    cJSON *root = cJSON_CreateArray();
+    size_t i;
+
+    json_writer_init(&w, out, sizeof(out));
+    json_write_begin_array(&w, NULL);
+
+    for (i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++)
+    {
+        json_write_number(&w, NULL, numbers[i]);
+        cJSON_AddItemToArray(root, cJSON_CreateNumber(numbers[i]));
+    }
+
+    json_write_number(&w, NULL, NAN);
+    cJSON_AddItemToArray(root, cJSON_CreateNumber(NAN));
+    json_write_number(&w, NULL, -INFINITY);
+    cJSON_AddItemToArray(root, cJSON_CreateNumber(-INFINITY));
+
+    json_write_end_array(&w);
+    TEST_ASSERT(json_writer_finish(&w) > 0);
+
+    check_same_as_cjson(root, out);
+    cJSON_Delete(root);
+}
+
+
+void test_strings_match_cjson(void)
+{
+    static const char *strings[] =
+    {
+        "", "plain", "q\"uote", "back\\slash", "\b\f\n\r\t", "\x01x\x1f",
+        "/dev/ttyUSB0", "UTF-8 \xc3\xa4\xc3\xb6", "tail\\"
+    };
+    struct json_writer w;
+    cJSON *root = cJSON_CreateObject();
+    size_t i;
+
+    json_writer_init(&w, out, sizeof(out));
+    json_write_begin_object(&w, NULL);
+
+    for (i = 0; i < sizeof(strings) / sizeof(strings[0]); i++)
+    {
+        char key[16];
+
+        /* Keys are escaped like values */
+        snprintf(key, sizeof(key), "k%d\"", (int)i);
+        json_write_string(&w, key, strings[i]);
+        cJSON_AddStringToObject(root, key, strings[i]);
+    }
+
+    json_write_end_object(&w);
+    TEST_ASSERT(json_writer_finish(&w) > 0);
+
+    check_same_as_cjson(root, out);
+    cJSON_Delete(root);
+}
+
+
+void test_nesting_and_raw(void)
+{
+    static const unsigned char bytes[] = { 0x0a, 0x1b, 0xff };
+    struct json_writer w;
+    char fragment[64];
+    int len;
+
+    /* A cached fragment, rendered on its own */
+    json_writer_init(&w, fragment, sizeof(fragment));
+    json_write_string(&w, "app", "Hamlib");
+    json_write_bool(&w, "on", 1);
+    len = json_writer_finish(&w);
+    TEST_ASSERT(len > 0);
+
+    json_writer_init(&w, out, sizeof(out));
+    json_write_begin_object(&w, NULL);
+    json_write_begin_array(&w, "a");
+    json_write_end_array(&w);
+    json_write_raw(&w, fragment, len);
+    json_write_begin_object(&w, "b");
+    json_write_end_object(&w);
+    json_write_begin_array(&w, "c");
+    json_write_begin_object(&w, NULL);
+    json_write_bool(&w, "x", 1);
+    json_write_end_object(&w);
+    json_write_bool(&w, NULL, 0);
+    json_write_end_array(&w);
+    json_write_raw(&w, "", 0);
+    json_write_hex(&w, "d", bytes, sizeof(bytes));
+    json_write_end_object(&w);
+
+    TEST_CHECK(json_writer_finish(&w) > 0);
+    TEST_CHECK(strcmp(out,
+                      "{\"a\":[],\"app\":\"Hamlib\",\"on\":true,\"b\":{},"
+                      "\"c\":[{\"x\":true},false],\"d\":\"0A1BFF\"}") == 0);
+    TEST_MSG("produced: %s", out);
+}
+
+
+static int write_sample(char *buf, size_t size)
+{
+    static const unsigned char bytes[] = { 1, 2, 3 };
+    struct json_writer w;
+
+    json_writer_init(&w, buf, size);
+    json_write_begin_object(&w, NULL);
+    json_write_string(&w, "s", "a\"b\x01");
+    json_write_number(&w, "n", -80.5);
+    json_write_hex(&w, "h", bytes, sizeof(bytes));
+    json_write_begin_array(&w, "a");
+    json_write_bool(&w, NULL, 1);
+    json_write_end_array(&w);
+    json_write_end_object(&w);
+
+    return json_writer_finish(&w);
+}
+
+
+void test_overflow_never_writes_past_end(void)
+{
+    char full[256], buf[256 + 8];
+    int len = write_sample(full, sizeof(full));
+    size_t size;
+
+    TEST_ASSERT(len > 0);
+
+    for (size = 0; size <= (size_t)len + 1; size++)
+    {
+        int result;
+
+        TEST_CASE_("size %d", (int)size);
+        memset(buf, 0x5a, sizeof(buf));
+        result = write_sample(buf, size);
+
+        TEST_CHECK(result == (size == (size_t)len + 1 ? len : -1));
+        TEST_CHECK(buf[size] == 0x5a);
+
+        if (result < 0 && size > 0)
+        {
+            TEST_CHECK(buf[0] == '\0');
+        }
+    }
+
+    TEST_CHECK(memcmp(buf, full, len + 1) == 0);
+}
+
+
+void test_snapshot_matches_cjson_with_crc(void)
+{
+    static unsigned char bins[HAMLIB_MAX_SPECTRUM_DATA];
+    struct snapshot_static *st = calloc(1, sizeof(*st));
+    struct rig_spectrum_line line;
+    cJSON *root, *crc_item, *spectrum;
+    unsigned int seq;
+    double crc;
+    char *zeroed;
+    size_t i;
+    RIG *rig;
+
+    TEST_ASSERT(st != NULL);
+
+    rig = rig_init(RIG_MODEL_DUMMY);
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "device_id"),
+                             "shack \"A\"") == RIG_OK);
+    TEST_ASSERT(rig_open(rig) == RIG_OK);
+    TEST_CHECK(rig_set_freq(rig, RIG_VFO_A, 14074000) == RIG_OK);
+    TEST_CHECK(rig_set_mode(rig, RIG_VFO_A, RIG_MODE_PKTUSB, 3000) == RIG_OK);
+
+    for (i = 0; i < sizeof(bins); i++)
+    {
+        bins[i] = (unsigned char)(i * 7);
+    }
+
+    memset(&line, 0, sizeof(line));
+    line.spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
+    line.data_level_max = 160;
+    line.signal_strength_min = -80.5;
+    line.center_freq = 14074000;
+    line.span_freq = 50000;
+    line.low_edge_freq = 14049000;
+    line.high_edge_freq = 14099000;
+    line.spectrum_data_length = sizeof(bins);
+    line.spectrum_data = bins;
+
+    TEST_ASSERT(snapshot_init(st, rig) == RIG_OK);
+
+    seq = STATE(rig)->snapshot_packet_sequence_number;
+    TEST_ASSERT(snapshot_serialize(sizeof(out), out, rig, st, &line) == RIG_OK);
+    TEST_CHECK(STATE(rig)->snapshot_packet_sequence_number == seq + 1);
+
+    root = cJSON_Parse(out);
+    TEST_ASSERT(root != NULL);
+    check_same_as_cjson(root, out);
+
+    TEST_CHECK(strcmp(cJSON_GetObjectItem(root, "app")->valuestring,
+                      "Hamlib") == 0);
+    TEST_CHECK(strcmp(cJSON_GetObjectItem(cJSON_GetObjectItem(cJSON_GetObjectItem(
+                                              root, "rig"), "id"), "deviceId")->valuestring, "shack \"A\"") == 0);
+    TEST_CHECK(cJSON_GetArraySize(cJSON_GetObjectItem(cJSON_GetObjectItem(root,
+                                  "rig"), "modes")) > 0);
+    TEST_CHECK(cJSON_GetObjectItem(cJSON_GetArrayItem(cJSON_GetObjectItem(root,
+                                   "vfos"), 0), "freq")->valuedouble == 14074000);
+
+    /* The full line, not cut short by a byte like the old hex conversion */
+    spectrum = cJSON_GetArrayItem(cJSON_GetObjectItem(root, "spectra"), 0);
+    TEST_ASSERT(spectrum != NULL);
+    TEST_CHECK(strlen(cJSON_GetObjectItem(spectrum, "data")->valuestring)
+               == 2 * sizeof(bins));
+
+    /* CRC-32 of the record with the crc value written as 0 */
+    crc_item = cJSON_GetObjectItem(root, "crc");
+    TEST_ASSERT(crc_item != NULL);
+    crc = crc_item->valuedouble;
+    cJSON_SetNumberValue(crc_item, 0);
+    zeroed = cJSON_PrintUnformatted(root);
+    TEST_ASSERT(zeroed != NULL);
+    TEST_CHECK(crc == CRC32_function((const uint8_t *)zeroed, strlen(zeroed)));
+    TEST_MSG("crc %.0f, computed %u", crc,
+             CRC32_function((const uint8_t *)zeroed, strlen(zeroed)));
+    free(zeroed);
+    cJSON_Delete(root);
+
+    /* Poll snapshot without spectra, and a buffer too small for it */
+    TEST_CHECK(snapshot_serialize(sizeof(out), out, rig, st, NULL) == RIG_OK);
+    TEST_CHECK(strstr(out, "\"spectra\"") == NULL);
+    TEST_CHECK(snapshot_serialize(strlen(out) / 2, out, rig, st, NULL)
+               == -RIG_EINVAL);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+    free(st);
+}
+
+
+TEST_LIST =
+{
+    { "numbers_match_cjson",            test_numbers_match_cjson },
+    { "strings_match_cjson",            test_strings_match_cjson },
+    { "nesting_and_raw",                test_nesting_and_raw },
+    { "overflow_never_writes_past_end", test_overflow_never_writes_past_end },
+    { "snapshot_matches_cjson_with_crc", test_snapshot_matches_cjson_with_crc },
+    { NULL, NULL }
+};
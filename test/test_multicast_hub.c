@@ -0,0 +1,267 @@
+/*
+ *  Hamlib multicast hub tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Several rigs published through the one hub thread and socket, each
+ * packet telling which rig it came from. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include <hamlib/rig.h>
+#include "network.h"
+#include "spectrum_packet.h"
+#include "event.h"
+#include "cJSON.h"
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static unsigned char packet[SPECTRUM_PACKET_MAX_SIZE + 16384];
+
+
+static int open_receiver(char *port, size_t port_len)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    struct timeval tv = { 2, 0 };
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+            || getsockname(fd, (struct sockaddr *)&addr, &addr_len) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    snprintf(port, port_len, "%d", ntohs(addr.sin_port));
+
+    return fd;
+}
+
+
+static RIG *open_rig(const char *port, int hub)
+{
+    RIG *rig = rig_init(RIG_MODEL_DUMMY);
+
+    if (rig == NULL)
+    {
+        return NULL;
+    }
+
+    rig_set_conf(rig, rig_token_lookup(rig, "multicast_data_addr"), "127.0.0.1");
+    rig_set_conf(rig, rig_token_lookup(rig, "multicast_data_port"), port);
+    rig_set_conf(rig, rig_token_lookup(rig, "multicast_spectrum_format"), "both");
+    rig_set_conf(rig, rig_token_lookup(rig, "multicast_hub"), hub ? "1" : "0");
+
+    if (rig_open(rig) != RIG_OK)
+    {
+        rig_cleanup(rig);
+        return NULL;
+    }
+
+    return rig;
+}
+
+
+static void close_rig(RIG *rig)
+{
+    rig_close(rig);
+    rig_cleanup(rig);
+}
+
+
+static void fire_line(RIG *rig, freq_t center)
+{
+    static unsigned char bins[100];
+    struct rig_spectrum_line line;
+
+    memset(&line, 0, sizeof(line));
+    line.spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
+    line.center_freq = center;
+    line.spectrum_data_length = sizeof(bins);
+    line.spectrum_data = bins;
+
+    TEST_CHECK(rig_fire_spectrum_event(rig, &line) == RIG_OK);
+}
+
+
+/* The source of the next spectrum packet with the given center frequency,
+ * checking that the JSON snapshot carrying the same line agrees; -1 when
+ * none arrives */
+static long receive_source(int fd, freq_t center)
+{
+    static unsigned char data[HAMLIB_MAX_SPECTRUM_DATA];
+    struct rig_spectrum_line line;
+    long binary_source = -1, json_source = -1;
+    ssize_t n;
+
+    while ((binary_source < 0 || json_source < 0)
+            && (n = recv(fd, packet, sizeof(packet) - 1, 0)) > 0)
+    {
+        if (packet[0] == '{')
+        {
+            cJSON *root, *id, *spectrum, *source;
+
+            packet[n] = '\0';
+            root = cJSON_Parse((char *)packet);
+            id = cJSON_GetObjectItem(cJSON_GetObjectItem(root, "rig"), "id");
+            spectrum = cJSON_GetArrayItem(cJSON_GetObjectItem(root, "spectra"), 0);
+
+            if (spectrum != NULL
+                    && cJSON_GetObjectItem(spectrum, "centerFreq")->valuedouble == center)
+            {
+                source = cJSON_GetObjectItem(id, "source");
+                json_source = source != NULL ? (long)source->valuedouble : 0;
+            }
+
+            cJSON_Delete(root);
+        }
+        else if (spectrum_packet_decode(packet, n, &line, data, NULL, NULL) == RIG_OK
+                 && line.center_freq == center)
+        {
+            binary_source = spectrum_packet_source(packet);
+        }
+    }
+
+    TEST_CHECK(binary_source == json_source);
+    TEST_MSG("binary %ld, JSON %ld", binary_source, json_source);
+
+    return binary_source;
+}
+
+
+void test_rigs_share_hub(void)
+{
+    struct udp_batch_stats stats1, stats2;
+    char port[16];
+    long source1, source2;
+    int fd = open_receiver(port, sizeof(port));
+    RIG *rig1, *rig2;
+
+    TEST_ASSERT(fd >= 0);
+    rig1 = open_rig(port, 1);
+    rig2 = open_rig(port, 1);
+    TEST_ASSERT(rig1 != NULL && rig2 != NULL);
+
+    fire_line(rig1, 14074000);
+    source1 = receive_source(fd, 14074000);
+    fire_line(rig2, 7074000);
+    source2 = receive_source(fd, 7074000);
+
+    TEST_CHECK(source1 > 0 && source2 > 0 && source1 != source2);
+
+    // One socket: both rigs read the same counters
+    TEST_CHECK(network_multicast_publisher_get_stats(rig1, &stats1) == RIG_OK);
+    TEST_CHECK(network_multicast_publisher_get_stats(rig2, &stats2) == RIG_OK);
+    TEST_CHECK(stats1.packets == stats2.packets && stats1.packets >= 4);
+
+    // The hub keeps going for the rig left
+    close_rig(rig1);
+    fire_line(rig2, 3574000);
+    TEST_CHECK(receive_source(fd, 3574000) == source2);
+
+    // A new rig gets a new number after the hub stopped and restarted
+    close_rig(rig2);
+    rig1 = open_rig(port, 1);
+    TEST_ASSERT(rig1 != NULL);
+    fire_line(rig1, 1840000);
+    TEST_CHECK(receive_source(fd, 1840000) > source2);
+    close_rig(rig1);
+
+    close(fd);
+}
+
+
+void test_own_publisher_untagged(void)
+{
+    char port[16], other_port[16];
+    int fd = open_receiver(port, sizeof(port));
+    int other_fd = open_receiver(other_port, sizeof(other_port));
+    RIG *rig, *hub_rig, *elsewhere;
+
+    TEST_ASSERT(fd >= 0 && other_fd >= 0);
+
+    rig = open_rig(port, 0);
+    TEST_ASSERT(rig != NULL);
+    fire_line(rig, 14074000);
+    TEST_CHECK(receive_source(fd, 14074000) == 0);
+
+    // A hub rig sending elsewhere than the hub gets a publisher of its own
+    hub_rig = open_rig(port, 1);
+    elsewhere = open_rig(other_port, 1);
+    TEST_ASSERT(hub_rig != NULL && elsewhere != NULL);
+    fire_line(hub_rig, 7074000);
+    TEST_CHECK(receive_source(fd, 7074000) > 0);
+    fire_line(elsewhere, 3574000);
+    TEST_CHECK(receive_source(other_fd, 3574000) == 0);
+
+    close_rig(elsewhere);
+    close_rig(hub_rig);
+    close_rig(rig);
+    close(other_fd);
+    close(fd);
+}
+
+
+void test_conf_token(void)
+{
+    char val[8];
+    RIG *rig = rig_init(RIG_MODEL_DUMMY);
+    hamlib_token_t token;
+
+    TEST_ASSERT(rig != NULL);
+    token = rig_token_lookup(rig, "multicast_hub");
+
+    TEST_CHECK(rig_get_conf2(rig, token, val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "0") == 0);
+    TEST_CHECK(rig_set_conf(rig, token, "1") == RIG_OK);
+    TEST_CHECK(rig_get_conf2(rig, token, val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "1") == 0);
+    TEST_CHECK(rig_set_conf(rig, token, "yes") == -RIG_EINVAL);
+
+    rig_cleanup(rig);
+}
+
+
+TEST_LIST =
+{
+    { "rigs_share_hub",         test_rigs_share_hub },
+    { "own_publisher_untagged", test_own_publisher_untagged },
+    { "conf_token",             test_conf_token },
+    { NULL, NULL }
+};
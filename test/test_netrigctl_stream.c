@@ -61,6 +61,7 @@ TEST_LIST =
 #include <unistd.h>
 #include <signal.h>
 #include <sys/wait.h>
+#include <sys/un.h>
 #include <errno.h>
 #include <math.h>
 
@@ -399,8 +400,9 @@ static void stop_rigctld(struct rigctld_proc *proc)
 }
 
 
-/* Open a netrigctl RIG connected to the subprocess rigctld. */
-static RIG *open_netrigctl(int port)
+/* Open a netrigctl RIG connected to the subprocess rigctld, with the
+ * change feed at notify_interval (NULL = off). */
+static RIG *open_netrigctl_notify(int port, const char *notify_interval)
 {
     /* A freshly spawned rigctld can stall for hundreds of ms on a loaded
      * CI runner between accepting the TCP connection and serving it, which
@@ -428,6 +430,12 @@ static RIG *open_netrigctl(int port)
         snprintf(pathname, sizeof(pathname), "127.0.0.1:%d", port);
         rig_set_conf(rig, rig_token_lookup(rig, "rig_pathname"), pathname);
 
+        if (notify_interval)
+        {
+            rig_set_conf(rig, rig_token_lookup(rig, "notify_interval"),
+                         notify_interval);
+        }
+
         if (rig_open(rig) == RIG_OK)
         {
             return rig;
@@ -451,6 +459,12 @@ static RIG *open_netrigctl(int port)
 }
 
 
+static RIG *open_netrigctl(int port)
+{
+    return open_netrigctl_notify(port, NULL);
+}
+
+
 /* Helper: find a stream_caps entry by type, return pointer or NULL. */
 /* The relayed advertisement is published as SESSION caps (netrigctl
  * never writes rig->caps), so lookups go through the public served view:
@@ -1124,8 +1138,7 @@ void test_rx_data_received(void)
  * dummy. The client must report the server's
  * conversion stages, deliver (converted) data, refuse the same config
  * under require_native with -RIG_ENAVAIL, and report a native stream for
- * the PCM_F32 form. Format conversion needs no resampler, so this holds
- * with and without HAVE_SAMPLERATE on either end. */
+ * the PCM_F32 form. */
 void test_rx_converted_stream_e2e(void)
 {
     struct rigctld_proc proc = {0};
@@ -1499,12 +1512,9 @@ void test_rx_iq_multichannel_e2e(void)
 }
 
 
-#ifdef HAVE_SAMPLERATE
 /* Server-side resampling E2E: 44100 Hz is in the relayed effective list but not
  * native to the dummy, so the SERVER resamples and the client accepts by
- * list membership (delegated resolution — no local resampler involved).
- * Client and server share this build, so HAVE_SAMPLERATE here implies the
- * server advertises the widened list. */
+ * list membership (delegated resolution — no local resampler involved). */
 void test_rx_resampled_stream_e2e(void)
 {
     struct rigctld_proc proc = {0};
@@ -1562,7 +1572,6 @@ void test_rx_resampled_stream_e2e(void)
     rig_cleanup(rig);
     stop_rigctld(&proc);
 }
-#endif /* HAVE_SAMPLERATE */
 
 
 /* RX data path: read multiple frames and verify ongoing data flow. */
@@ -2693,6 +2702,510 @@ void test_stream_source_id_cli_and_derived(void)
 }
 
 
+
+/* Poll rig_get_freq() until it reads want, for at most timeout_ms. */
+static int wait_freq(RIG *rig, freq_t want, int timeout_ms)
+{
+    freq_t freq = 0;
+
+    for (int waited = 0; waited <= timeout_ms; waited += 10)
+    {
+        if (rig_get_freq(rig, RIG_VFO_CURR, &freq) == RIG_OK && freq == want)
+        {
+            return 1;
+        }
+
+        usleep(10000);
+    }
+
+    TEST_MSG("freq=%.0f, expected %.0f", freq, want);
+    return 0;
+}
+
+
+/* netrigctl read cache: with notify_interval set, changes made by another
+ * client reach the cache through the change feed, and our own writes are
+ * readable back straight away. */
+void test_read_cache_follows_feed(void)
+{
+    struct rigctld_proc proc = {0};
+    RIG *cached, *other;
+    rmode_t mode = RIG_MODE_NONE;
+    pbwidth_t width = 0;
+    value_t val;
+
+    if (start_rigctld(&proc) < 0)
+    {
+        TEST_CHECK_(0, "could not start rigctld");
+        return;
+    }
+
+    cached = open_netrigctl_notify(proc.port, "20");
+    TEST_ASSERT(cached != NULL);
+    other = open_netrigctl(proc.port);
+    TEST_ASSERT(other != NULL);
+
+    /* Another client's change arrives through the feed */
+    TEST_CHECK(rig_set_freq(other, RIG_VFO_CURR, 14074000) == RIG_OK);
+    TEST_CHECK(wait_freq(cached, 14074000, 2000));
+
+    TEST_CHECK(rig_set_mode(other, RIG_VFO_CURR, RIG_MODE_PKTUSB, 2400)
+               == RIG_OK);
+
+    for (int waited = 0; waited <= 2000 && mode != RIG_MODE_PKTUSB;
+            waited += 10)
+    {
+        usleep(10000);
+        rig_get_mode(cached, RIG_VFO_CURR, &mode, &width);
+    }
+
+    TEST_CHECK(mode == RIG_MODE_PKTUSB && width == 2400);
+    TEST_MSG("mode=%s width=%ld", rig_strrmode(mode), (long)width);
+
+    /* Common levels are cached too */
+    val.f = 0.25f;
+    TEST_CHECK(rig_set_level(other, RIG_VFO_CURR, RIG_LEVEL_AF, val) == RIG_OK);
+    val.f = 0;
+
+    for (int waited = 0; waited <= 2000 && val.f != 0.25f; waited += 10)
+    {
+        usleep(10000);
+        rig_get_level(cached, RIG_VFO_CURR, RIG_LEVEL_AF, &val);
+    }
+
+    TEST_CHECK(val.f == 0.25f);
+    TEST_MSG("AF=%f", val.f);
+
+    /* Own writes are written through: no wait for the feed */
+    TEST_CHECK(rig_set_freq(cached, RIG_VFO_CURR, 7074000) == RIG_OK);
+    TEST_CHECK(wait_freq(cached, 7074000, 0));
+    /* ...while a client without the feed sees it once its cache expires */
+    TEST_CHECK(wait_freq(other, 7074000, 2000));
+
+    rig_close(other);
+    rig_cleanup(other);
+    rig_close(cached);
+    rig_cleanup(cached);
+    stop_rigctld(&proc);
+}
+
+
+/* Debug callback picking netrigctl's read cache statistics out of the line
+ * it logs when the feed stops; arg is unsigned long[2], hits and misses. */
+static int ncache_stats_cb(enum rig_debug_level_e level, rig_ptr_t arg,
+                           const char *fmt, va_list ap)
+{
+    unsigned long *stats = (unsigned long *)arg;
+    char line[256];
+    const char *p;
+
+    (void)level;
+    vsnprintf(line, sizeof(line), fmt, ap);
+    p = strstr(line, "read cache hits=");
+
+    if (p)
+    {
+        sscanf(p, "read cache hits=%lu misses=%lu", &stats[0], &stats[1]);
+    }
+
+    return 0;
+}
+
+
+/* Read the VFO, expecting want, and then the frequency reads times from the
+ * cached client, once the feed has had time to push whatever changed. */
+static void read_cached_freq(RIG *rig, vfo_t want, int reads)
+{
+    vfo_t vfo = RIG_VFO_NONE;
+    freq_t freq;
+
+    usleep(200000);
+    /* Every read goes to netrigctl, not the frontend's own cache (set here,
+     * after the poll routine has set its own at start) */
+    rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, 0);
+
+    /* Also brings the frontend's current VFO up to date */
+    TEST_CHECK(rig_get_vfo(rig, &vfo) == RIG_OK);
+    TEST_CHECK_(vfo == want, "vfo=%s", rig_strvfo(vfo));
+
+    for (int i = 0; i < reads; i++)
+    {
+        TEST_CHECK(rig_get_freq(rig, RIG_VFO_CURR, &freq) == RIG_OK);
+        TEST_CHECK_(freq == 14074000, "freq=%.0f", freq);
+    }
+}
+
+
+/* netrigctl read cache across VFO switches, ours and another client's, when
+ * both VFOs share a frequency: the feed brings the new VFO's entries along
+ * with it even though nothing differs, so every read is still a hit. */
+void test_read_cache_vfo_switch(void)
+{
+    struct rigctld_proc proc = {0};
+    RIG *cached, *other;
+    unsigned long stats[2] = { 0, 0 };
+    vprintf_cb_t prev;
+
+    if (start_rigctld(&proc) < 0)
+    {
+        TEST_CHECK_(0, "could not start rigctld");
+        return;
+    }
+
+    other = open_netrigctl(proc.port);
+    TEST_ASSERT(other != NULL);
+    TEST_CHECK(rig_set_vfo(other, RIG_VFO_B) == RIG_OK);
+    TEST_CHECK(rig_set_freq(other, RIG_VFO_CURR, 14074000) == RIG_OK);
+    TEST_CHECK(rig_set_vfo(other, RIG_VFO_A) == RIG_OK);
+    TEST_CHECK(rig_set_freq(other, RIG_VFO_CURR, 14074000) == RIG_OK);
+
+    cached = open_netrigctl_notify(proc.port, "20");
+    TEST_ASSERT(cached != NULL);
+    read_cached_freq(cached, RIG_VFO_A, 5);
+
+    /* Another client's switch, and back */
+    TEST_CHECK(rig_set_vfo(other, RIG_VFO_B) == RIG_OK);
+    read_cached_freq(cached, RIG_VFO_B, 5);
+    TEST_CHECK(rig_set_vfo(other, RIG_VFO_A) == RIG_OK);
+    read_cached_freq(cached, RIG_VFO_A, 5);
+
+    /* Our own switch, once pushed */
+    TEST_CHECK(rig_set_vfo(cached, RIG_VFO_B) == RIG_OK);
+    read_cached_freq(cached, RIG_VFO_B, 5);
+
+    rig_close(other);
+    rig_cleanup(other);
+
+    rig_set_debug(RIG_DEBUG_VERBOSE);
+    prev = rig_set_debug_callback(ncache_stats_cb, (rig_ptr_t)stats);
+    rig_close(cached);
+    rig_set_debug_callback(prev, NULL);
+    test_debug_init();
+    rig_cleanup(cached);
+    stop_rigctld(&proc);
+
+    /* Four rounds of a VFO and five frequency reads; rig_open's own reads
+     * and the one rig_set_vfo makes before the push are misses */
+    TEST_CHECK_(stats[0] >= 24, "hits=%lu misses=%lu", stats[0], stats[1]);
+}
+
+
+/* Start rigctld with one extra option; without a --rigs-file it serves the
+ * dummy rig. proc->port is the TCP port. */
+static int start_rigctld_with(struct rigctld_proc *proc, const char *opt,
+                              const char *arg)
+{
+    const char *rigctld_path = find_rigctld();
+    char port_str[16];
+
+    proc->port = find_free_port();
+
+    if (proc->port < 0)
+    {
+        return -1;
+    }
+
+    snprintf(port_str, sizeof(port_str), "%d", proc->port);
+    snprintf(proc->log_path, sizeof(proc->log_path),
+             "rigctld-%d.log", proc->port);
+
+    proc->pid = fork();
+
+    if (proc->pid < 0)
+    {
+        return -1;
+    }
+
+    if (proc->pid == 0)
+    {
+        if (freopen("/dev/null", "w", stdout) == NULL) {}
+
+        if (freopen(proc->log_path, "w", stderr) == NULL)
+        {
+            if (freopen("/dev/null", "w", stderr) == NULL) {}
+        }
+
+        if (strcmp(opt, "--rigs-file") == 0)
+        {
+            execlp(rigctld_path, "rigctld", "-t", port_str, "-vvv", opt, arg,
+                   NULL);
+        }
+        else
+        {
+            execlp(rigctld_path, "rigctld", "-m", "1", "-t", port_str, "-vvv",
+                   opt, arg, NULL);
+        }
+
+
+        _exit(127);
+    }
+
+    if (wait_for_rigctld(proc->port, 5000) < 0 || !rigctld_alive(proc))
+    {
+        stop_rigctld(proc);
+        return -1;
+    }
+
+    last_rigctld_proc = proc;
+    return 0;
+}
+
+
+/* Start rigctld serving the rigs in rigs_path; proc->port is the shared port */
+static int start_rigctld_rigs(struct rigctld_proc *proc, const char *rigs_path)
+{
+    return start_rigctld_with(proc, "--rigs-file", rigs_path);
+}
+
+
+/* Send one extended-response command on sock and read up to its RPRT line */
+static int raw_cmd(int sock, const char *cmd, char *buf, size_t size)
+{
+    size_t total = 0;
+
+    buf[0] = '\0';
+
+    if (send(sock, cmd, strlen(cmd), 0) != (ssize_t)strlen(cmd))
+    {
+        return -1;
+    }
+
+    while (total < size - 1 && strstr(buf, "RPRT") == NULL)
+    {
+        fd_set fds;
+        struct timeval tv = { 3, 0 };
+        ssize_t n;
+
+        FD_ZERO(&fds);
+        FD_SET(sock, &fds);
+
+        if (select(sock + 1, &fds, NULL, NULL, &tv) <= 0)
+        {
+            return -1;
+        }
+
+        n = recv(sock, buf + total, size - 1 - total, 0);
+
+        if (n <= 0)
+        {
+            return -1;
+        }
+
+        total += (size_t)n;
+        buf[total] = '\0';
+    }
+
+    return 0;
+}
+
+
+static int64_t rigctld_test_now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+static int connect_port(int port)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+
+    if (sock < 0)
+    {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+
+/* rigctld --rigs-file: the shared port reaches the first rig, a rig with a
+ * port of its own is reached there, and \rig_select moves a connection. */
+void test_multi_rig_routing(void)
+{
+    struct rigctld_proc proc = {0};
+    char rigs_path[64];
+    char buf[1024];
+    int vhf_port = find_free_port();
+    RIG *hf, *vhf;
+    FILE *f;
+    int sock;
+
+    TEST_ASSERT(vhf_port > 0);
+    snprintf(rigs_path, sizeof(rigs_path), "rigs-%d.conf", (int)getpid());
+    f = fopen(rigs_path, "w");
+    TEST_ASSERT(f != NULL);
+    fprintf(f, "[hf]\nmodel = 1\n\n[vhf]\nmodel = 1\nport = %d\n", vhf_port);
+    fclose(f);
+
+    if (start_rigctld_rigs(&proc, rigs_path) < 0)
+    {
+        unlink(rigs_path);
+        TEST_CHECK_(0, "could not start rigctld");
+        return;
+    }
+
+    TEST_ASSERT(wait_for_rigctld(vhf_port, 5000) == 0);
+
+    hf = open_netrigctl(proc.port);
+    TEST_ASSERT(hf != NULL);
+    vhf = open_netrigctl(vhf_port);
+    TEST_ASSERT(vhf != NULL);
+
+    /* Each port reaches its own rig */
+    TEST_CHECK(rig_set_freq(hf, RIG_VFO_CURR, 7074000) == RIG_OK);
+    TEST_CHECK(rig_set_freq(vhf, RIG_VFO_CURR, 144174000) == RIG_OK);
+    TEST_CHECK(wait_freq(hf, 7074000, 2000));
+    TEST_CHECK(wait_freq(vhf, 144174000, 2000));
+
+    /* A shared-port connection switches rig with \rig_select */
+    sock = connect_port(proc.port);
+    TEST_ASSERT(sock >= 0);
+
+    TEST_CHECK(raw_cmd(sock, "+\\rig_list\n", buf, sizeof(buf)) == 0);
+    TEST_CHECK(strstr(buf, "name: hf") != NULL);
+    TEST_CHECK(strstr(buf, "name: vhf") != NULL);
+    TEST_MSG("rig_list: %s", buf);
+
+    TEST_CHECK(raw_cmd(sock, "+\\get_freq\n", buf, sizeof(buf)) == 0);
+    TEST_CHECK(strstr(buf, "Frequency: 7074000") != NULL);
+    TEST_MSG("hf: %s", buf);
+
+    TEST_CHECK(raw_cmd(sock, "+\\rig_select vhf\n", buf, sizeof(buf)) == 0);
+    TEST_CHECK(strstr(buf, "RPRT 0") != NULL);
+    TEST_CHECK(raw_cmd(sock, "+\\get_freq\n", buf, sizeof(buf)) == 0);
+    TEST_CHECK(strstr(buf, "Frequency: 144174000") != NULL);
+    TEST_MSG("vhf: %s", buf);
+
+    TEST_CHECK(raw_cmd(sock, "+\\rig_select uhf\n", buf, sizeof(buf)) == 0);
+    TEST_CHECK(strstr(buf, "RPRT -1") != NULL);
+    TEST_MSG("unknown rig: %s", buf);
+    close(sock);
+
+    rig_close(vhf);
+    rig_cleanup(vhf);
+    rig_close(hf);
+    rig_cleanup(hf);
+    stop_rigctld(&proc);
+    unlink(rigs_path);
+}
+
+
+/* rigctld --unix-socket: a local client on the socket drives the same rig
+ * as a TCP client, and the socket file goes away with the daemon. */
+void test_unix_socket_client(void)
+{
+    struct rigctld_proc proc = {0};
+    struct sockaddr_un addr;
+    char path[64];
+    char buf[1024];
+    RIG *tcp;
+    int sock;
+
+    snprintf(path, sizeof(path), "rigctld-%d.sock", (int)getpid());
+
+    if (start_rigctld_with(&proc, "--unix-socket", path) < 0)
+    {
+        TEST_CHECK_(0, "could not start rigctld");
+        return;
+    }
+
+    tcp = open_netrigctl(proc.port);
+    TEST_ASSERT(tcp != NULL);
+    TEST_CHECK(rig_set_freq(tcp, RIG_VFO_CURR, 10136000) == RIG_OK);
+
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    TEST_ASSERT(sock >= 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    TEST_ASSERT(connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+
+    TEST_CHECK(raw_cmd(sock, "+\\get_freq\n", buf, sizeof(buf)) == 0);
+    TEST_CHECK(strstr(buf, "Frequency: 10136000") != NULL);
+    TEST_MSG("unix: %s", buf);
+
+    TEST_CHECK(raw_cmd(sock, "+\\set_freq 18100000\n", buf, sizeof(buf)) == 0);
+    TEST_CHECK(strstr(buf, "RPRT 0") != NULL);
+    TEST_CHECK(wait_freq(tcp, 18100000, 2000));
+    close(sock);
+
+    rig_close(tcp);
+    rig_cleanup(tcp);
+    stop_rigctld(&proc);
+    TEST_CHECK(access(path, F_OK) != 0);
+    unlink(path);
+}
+
+
+/* rigctld --rate-limit: a client reading faster than its read rate is
+ * slowed down to it, writes stay unthrottled, and \client_stats shows it. */
+void test_rate_limit_stats(void)
+{
+    struct rigctld_proc proc = {0};
+    char buf[4096];
+    int64_t start_ms, elapsed_ms;
+    const char *p;
+    int sock, i;
+
+    if (start_rigctld_with(&proc, "--rate-limit", "20") < 0)
+    {
+        TEST_CHECK_(0, "could not start rigctld");
+        return;
+    }
+
+    sock = connect_port(proc.port);
+    TEST_ASSERT(sock >= 0);
+
+    /* The first second's worth passes at once, the next 20 at 20/s */
+    start_ms = rigctld_test_now_ms();
+
+    for (i = 0; i < 40; i++)
+    {
+        TEST_ASSERT(raw_cmd(sock, "+\\get_freq\n", buf, sizeof(buf)) == 0);
+    }
+
+    elapsed_ms = rigctld_test_now_ms() - start_ms;
+    TEST_CHECK(elapsed_ms >= 800);
+    TEST_MSG("40 reads took %lld ms", (long long)elapsed_ms);
+
+    start_ms = rigctld_test_now_ms();
+    TEST_CHECK(raw_cmd(sock, "+\\set_freq 14074000\n", buf, sizeof(buf)) == 0);
+    TEST_CHECK(strstr(buf, "RPRT 0") != NULL);
+    TEST_CHECK(rigctld_test_now_ms() - start_ms < 500);
+
+    TEST_CHECK(raw_cmd(sock, "+\\client_stats\n", buf, sizeof(buf)) == 0);
+    TEST_MSG("client_stats: %s", buf);
+    TEST_CHECK(strstr(buf, "read_rate: 20") != NULL);
+    TEST_CHECK(strstr(buf, "write_rate: 0") != NULL);
+    TEST_CHECK(strstr(buf, "self: 1") != NULL);
+    TEST_CHECK(strstr(buf, "write_commands: 1") != NULL);
+    TEST_CHECK(strstr(buf, "write_throttled: 0") != NULL);
+
+    p = strstr(buf, "read_throttled: ");
+    TEST_ASSERT(p != NULL);
+    TEST_CHECK(atoi(p + strlen("read_throttled: ")) >= 19);
+    close(sock);
+
+    stop_rigctld(&proc);
+}
+
+
 TEST_LIST =
 {
     { "rx_overlong_payload_len_rejected", test_rx_overlong_payload_len_rejected },
@@ -2715,9 +3228,7 @@ TEST_LIST =
     { "rx_codec_passthrough_e2e",  test_rx_codec_passthrough_e2e },
     { "rx_stereo_channels_forwarded", test_rx_stereo_channels_forwarded },
     { "rx_iq_multichannel_e2e",    test_rx_iq_multichannel_e2e },
-#ifdef HAVE_SAMPLERATE
     { "rx_resampled_stream_e2e",   test_rx_resampled_stream_e2e },
-#endif
     { "rx_continuous_data",        test_rx_continuous_data },
     { "open_unsupported_rate",     test_open_unsupported_rate },
     { "open_unsupported_format",   test_open_unsupported_format },
@@ -2727,6 +3238,11 @@ TEST_LIST =
     { "stream_source_id_cli_and_derived", test_stream_source_id_cli_and_derived },
     { "subscribe_retransmits_after_loss", test_subscribe_retransmits_after_loss },
     { "subscribe_ignores_non_ack_first", test_subscribe_ignores_non_ack_first },
+    { "read_cache_follows_feed",   test_read_cache_follows_feed },
+    { "read_cache_vfo_switch",     test_read_cache_vfo_switch },
+    { "multi_rig_routing",         test_multi_rig_routing },
+    { "unix_socket_client",        test_unix_socket_client },
+    { "rate_limit_stats",          test_rate_limit_stats },
     { NULL, NULL }
 };
 
@@ -100,18 +100,12 @@ extern int is_rigctld;
 #define EXPECTED_AUDIO_NATIVE_RATES "8000,16000,24000,48000,96000"
 #define EXPECTED_IQ_NATIVE_RATES    "24000,48000,96000,192000"
 
-#ifdef HAVE_SAMPLERATE
 #define EXPECTED_AUDIO_RATES \
     "800,1000,1600,2000,2400,3000,3200,4000,4800,6000,8000,9600,11025," \
     "12000,16000,19200,22050,24000,32000,44100,48000,96000"
 #define EXPECTED_IQ_RATES \
     "2400,3000,4000,4800,6000,8000,9600,11025,12000,16000,19200,22050," \
     "24000,32000,38400,44100,48000,64000,96000,192000"
-#else
-/* Without the resampler the effective sets equal the native sets. */
-#define EXPECTED_AUDIO_RATES EXPECTED_AUDIO_NATIVE_RATES
-#define EXPECTED_IQ_RATES    EXPECTED_IQ_NATIVE_RATES
-#endif
 
 /* AUDIO_RX carries the dummy's fabricated OPUS test codec: it appears in
  * both views (declared native, passed through derivation untouched). */
@@ -160,6 +154,7 @@ static RIG *test_rig_setup(void)
 
     /* Tests exercise rigctld stream commands */
     is_rigctld = 1;
+    rigctl_parse_init();    /* thread_data_key, looked up for scheduling */
 
     return rig;
 }
@@ -1069,8 +1064,7 @@ void test_cmd_stream_open_iq_multichannel(void)
 
 /* The open response reports the conversion stages — a converted
  * request (PCM_S16 against the PCM_F32-native dummy) shows CONV_FORMAT,
- * a native request shows CONV_NONE. Format conversion needs no resampler,
- * so this holds with and without HAVE_SAMPLERATE. */
+ * a native request shows CONV_NONE. */
 void test_cmd_stream_open_reports_conversions(void)
 {
     RIG *rig = stream_test_begin();
@@ -0,0 +1,660 @@
+/*
+ *  Hamlib rigctld change subscription tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Tests for rigctld \subscribe: argument parsing, diff/format, rate limiting
+ * and coalescing, driven through rigctld_notify_tick() on a dummy rig. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+/* Socket headers come from stream_proto.h (via rigctld_stream.h), which picks
+ * the right set for the host; do not include them directly. */
+#include "../tests/rigctl_parse.h"
+#include "../tests/rigctld_stream.h"
+#include "../tests/rigctld_notify.h"
+#include "../tests/rigctld_client.h"
+#include <hamlib/rig.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+/* Globals required by rigctl_parse.c */
+int lock_mode = 0;
+powerstat_t rig_powerstat = RIG_POWER_ON;
+extern int is_rigctld;
+
+
+/* --- Test helpers --- */
+
+static RIG *notify_test_begin(void)
+{
+    RIG *rig = rig_init(RIG_MODEL_DUMMY);
+
+    if (!rig)
+    {
+        return NULL;
+    }
+
+    if (rig_open(rig) != RIG_OK)
+    {
+        rig_cleanup(rig);
+        return NULL;
+    }
+
+    is_rigctld = 1;
+    rigctl_parse_init();    /* thread_data_key, looked up by \subscribe */
+    rigctld_notify_registry_init(&g_notify_registry);
+    g_notify_registry.rig = rig;
+
+    return rig;
+}
+
+
+static void notify_test_end(RIG *rig)
+{
+    rigctld_notify_registry_destroy(&g_notify_registry);
+
+    if (rig)
+    {
+        rig_close(rig);
+        rig_cleanup(rig);
+    }
+}
+
+
+/* Connected loopback TCP pair: *srv is the rigctld side, *cli the client. */
+static int tcp_pair(int *srv, int *cli)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int lsock = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (lsock < 0)
+    {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(lsock, (struct sockaddr *)&addr, sizeof(addr)) < 0
+            || listen(lsock, 1) < 0
+            || getsockname(lsock, (struct sockaddr *)&addr, &len) < 0)
+    {
+        socket_close(lsock);
+        return -1;
+    }
+
+    *cli = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (*cli < 0 || connect(*cli, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        socket_close(lsock);
+        return -1;
+    }
+
+    *srv = accept(lsock, NULL, NULL);
+    socket_close(lsock);
+
+    return *srv < 0 ? -1 : 0;
+}
+
+
+/* Read whatever the notifier pushed, waiting at most timeout_ms.
+ * Returns the number of bytes read (0 = nothing pushed). */
+static int read_pushed(int sock, char *buf, size_t size, int timeout_ms)
+{
+    fd_set rfds;
+    struct timeval tv;
+    int n;
+
+    FD_ZERO(&rfds);
+    FD_SET(sock, &rfds);
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+    if (select(sock + 1, &rfds, NULL, NULL, &tv) <= 0)
+    {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    n = recv(sock, buf, size - 1, 0);
+
+    if (n < 0) { n = 0; }
+
+    buf[n] = '\0';
+    return n;
+}
+
+
+/* Run one command through rigctl_parse() and capture its output. */
+static int run_cmd(RIG *rig, const char *cmd_str, char *outbuf,
+                   size_t outbuf_size)
+{
+    FILE *fin = tmpfile();
+    FILE *fout = tmpfile();
+    int vfo_opt = 0;
+    int ext_resp = 0;
+    char resp_sep = '\n';
+    int retval;
+    size_t got;
+
+    if (!fin || !fout)
+    {
+        if (fin) { fclose(fin); }
+
+        if (fout) { fclose(fout); }
+
+        return -1;
+    }
+
+    fprintf(fin, "%s\n", cmd_str);
+    rewind(fin);
+
+    errno = 0;
+    retval = rigctl_parse(rig, fin, fout, NULL, 0, NULL,
+                          1, 0, &vfo_opt, '\n', &ext_resp, &resp_sep, 0);
+
+    fflush(fout);
+    rewind(fout);
+    got = fread(outbuf, 1, outbuf_size - 1, fout);
+    outbuf[got] = '\0';
+
+    fclose(fin);
+    fclose(fout);
+    return retval;
+}
+
+
+/* --- Argument parsing --- */
+
+void test_parse_args_defaults(void)
+{
+    unsigned int items;
+    int interval, deadband;
+
+    TEST_CHECK(rigctld_notify_parse_args("FREQ", &items, &interval,
+                                         &deadband) == 0);
+    TEST_CHECK(items == RIGCTLD_NOTIFY_FREQ);
+    TEST_CHECK(interval == RIGCTLD_NOTIFY_INTERVAL_DEFAULT);
+    TEST_CHECK(deadband == 0);
+
+    TEST_CHECK(rigctld_notify_parse_args("all", &items, &interval,
+                                         &deadband) == 0);
+    TEST_CHECK(items == RIGCTLD_NOTIFY_ALL);
+}
+
+
+void test_parse_args_full(void)
+{
+    unsigned int items;
+    int interval, deadband;
+
+    TEST_CHECK(rigctld_notify_parse_args(" freq,Mode,PTT,STRENGTH 250 3",
+                                         &items, &interval, &deadband) == 0);
+    TEST_CHECK(items == (RIGCTLD_NOTIFY_FREQ | RIGCTLD_NOTIFY_MODE
+                         | RIGCTLD_NOTIFY_PTT | RIGCTLD_NOTIFY_STRENGTH));
+    TEST_CHECK(interval == 250);
+    TEST_CHECK(deadband == 3);
+
+    TEST_CHECK(rigctld_notify_parse_args("AF,rf,SQL,RFPOWER", &items,
+                                         &interval, &deadband) == 0);
+    TEST_CHECK(items == (RIGCTLD_NOTIFY_AF | RIGCTLD_NOTIFY_RF
+                         | RIGCTLD_NOTIFY_SQL | RIGCTLD_NOTIFY_RFPOWER));
+
+    /* Interval is clamped, not rejected */
+    TEST_CHECK(rigctld_notify_parse_args("FREQ 1", &items, &interval,
+                                         &deadband) == 0);
+    TEST_CHECK(interval == RIGCTLD_NOTIFY_INTERVAL_MIN);
+    TEST_CHECK(rigctld_notify_parse_args("FREQ 999999", &items, &interval,
+                                         &deadband) == 0);
+    TEST_CHECK(interval == RIGCTLD_NOTIFY_INTERVAL_MAX);
+}
+
+
+void test_parse_args_invalid(void)
+{
+    unsigned int items;
+    int interval, deadband;
+
+    TEST_CHECK(rigctld_notify_parse_args("", &items, &interval,
+                                         &deadband) < 0);
+    TEST_CHECK(rigctld_notify_parse_args("FREQ,BOGUS", &items, &interval,
+                                         &deadband) < 0);
+    TEST_CHECK(rigctld_notify_parse_args("FREQ,,MODE", &items, &interval,
+                                         &deadband) < 0);
+    TEST_CHECK(rigctld_notify_parse_args("FREQ abc", &items, &interval,
+                                         &deadband) < 0);
+    TEST_CHECK(rigctld_notify_parse_args("FREQ 100 -1", &items, &interval,
+                                         &deadband) < 0);
+    TEST_CHECK(rigctld_notify_parse_args("FREQ 100 2 extra", &items,
+                                         &interval, &deadband) < 0);
+}
+
+
+/* --- Diff and format --- */
+
+void test_diff_first_push_is_full(void)
+{
+    struct rigctld_subscriber sub;
+    struct rigctld_notify_state st;
+
+    memset(&sub, 0, sizeof(sub));
+    memset(&st, 0, sizeof(st));
+    sub.items = RIGCTLD_NOTIFY_FREQ | RIGCTLD_NOTIFY_PTT;
+    st.valid = RIGCTLD_NOTIFY_FREQ | RIGCTLD_NOTIFY_PTT | RIGCTLD_NOTIFY_MODE;
+    st.freq = 14074000;
+
+    /* Nothing sent yet: every subscribed, readable item counts as changed;
+     * MODE was read but not subscribed. */
+    TEST_CHECK(rigctld_notify_diff(&sub, &st)
+               == (RIGCTLD_NOTIFY_FREQ | RIGCTLD_NOTIFY_PTT));
+
+    sub.sent = st;
+    TEST_CHECK(rigctld_notify_diff(&sub, &st) == 0);
+
+    st.freq = 14075000;
+    TEST_CHECK(rigctld_notify_diff(&sub, &st) == RIGCTLD_NOTIFY_FREQ);
+
+    /* Levels are diffed one by one */
+    sub.items |= RIGCTLD_NOTIFY_AF | RIGCTLD_NOTIFY_SQL;
+    st.valid |= RIGCTLD_NOTIFY_AF | RIGCTLD_NOTIFY_SQL;
+    sub.sent = st;
+    st.level[2] = 0.75f;
+    TEST_CHECK(rigctld_notify_diff(&sub, &st) == RIGCTLD_NOTIFY_SQL);
+
+    /* A VFO change resends every item, equal to the old VFO's or not */
+    sub.items |= RIGCTLD_NOTIFY_VFO;
+    st.valid |= RIGCTLD_NOTIFY_VFO;
+    st.vfo = RIG_VFO_A;
+    sub.sent = st;
+    st.vfo = RIG_VFO_B;
+    TEST_CHECK(rigctld_notify_diff(&sub, &st)
+               == (RIGCTLD_NOTIFY_VFO | RIGCTLD_NOTIFY_FREQ | RIGCTLD_NOTIFY_PTT
+                   | RIGCTLD_NOTIFY_AF | RIGCTLD_NOTIFY_SQL));
+}
+
+
+void test_diff_strength_deadband(void)
+{
+    struct rigctld_subscriber sub;
+    struct rigctld_notify_state st;
+
+    memset(&sub, 0, sizeof(sub));
+    memset(&st, 0, sizeof(st));
+    sub.items = RIGCTLD_NOTIFY_STRENGTH;
+    sub.deadband = 3;
+    st.valid = RIGCTLD_NOTIFY_STRENGTH;
+    st.strength = -20;
+    sub.sent = st;
+
+    st.strength = -17;
+    TEST_CHECK(rigctld_notify_diff(&sub, &st) == 0);
+
+    st.strength = -24;
+    TEST_CHECK(rigctld_notify_diff(&sub, &st) == RIGCTLD_NOTIFY_STRENGTH);
+}
+
+
+void test_format_line(void)
+{
+    struct rigctld_notify_state st;
+    char line[256];
+    int len;
+
+    memset(&st, 0, sizeof(st));
+    st.vfo = RIG_VFO_A;
+    st.freq = 7074000;
+    st.mode = RIG_MODE_USB;
+    st.width = 2400;
+    st.ptt = RIG_PTT_ON;
+    st.split = RIG_SPLIT_ON;
+    st.tx_vfo = RIG_VFO_B;
+
+    len = rigctld_notify_format(RIGCTLD_NOTIFY_VFO | RIGCTLD_NOTIFY_FREQ
+                                | RIGCTLD_NOTIFY_MODE | RIGCTLD_NOTIFY_PTT
+                                | RIGCTLD_NOTIFY_SPLIT, &st, line,
+                                sizeof(line));
+    TEST_CHECK(len == (int)strlen(line));
+    TEST_CHECK(strcmp(line, "!notify vfo=VFOA freq=7074000 mode=USB "
+                      "width=2400 ptt=1 split=1 txvfo=VFOB\n") == 0);
+    TEST_MSG("line: %s", line);
+
+    len = rigctld_notify_format(RIGCTLD_NOTIFY_PTT, &st, line, sizeof(line));
+    TEST_CHECK(strcmp(line, "!notify ptt=1\n") == 0);
+
+    st.level[0] = 0.5f;
+    st.level[3] = 0.25f;
+    rigctld_notify_format(RIGCTLD_NOTIFY_AF | RIGCTLD_NOTIFY_RFPOWER, &st,
+                          line, sizeof(line));
+    TEST_CHECK(strcmp(line, "!notify af=0.5 rfpower=0.25\n") == 0);
+    TEST_MSG("line: %s", line);
+
+    /* Too small a buffer is an error, never a truncated line */
+    TEST_CHECK(rigctld_notify_format(RIGCTLD_NOTIFY_FREQ, &st, line, 12) < 0);
+}
+
+
+/* --- Commands --- */
+
+void test_cmd_subscribe_unsubscribe(void)
+{
+    RIG *rig = notify_test_begin();
+    char out[256];
+
+    TEST_ASSERT(rig != NULL);
+    rigctld_client_id_init();
+    rigctld_client_id_set(7);
+
+    run_cmd(rig, "\\subscribe FREQ,MODE 50", out, sizeof(out));
+    TEST_CHECK(strstr(out, "RPRT 0") != NULL);
+    TEST_MSG("out: %s", out);
+    TEST_CHECK(rigctld_notify_count(&g_notify_registry) == 1);
+
+    /* Resubscribing replaces, it does not add */
+    run_cmd(rig, "\\subscribe PTT", out, sizeof(out));
+    TEST_CHECK(strstr(out, "RPRT 0") != NULL);
+    TEST_CHECK(rigctld_notify_count(&g_notify_registry) == 1);
+
+    run_cmd(rig, "\\unsubscribe", out, sizeof(out));
+    TEST_CHECK(strstr(out, "RPRT 0") != NULL);
+    TEST_CHECK(rigctld_notify_count(&g_notify_registry) == 0);
+
+    /* Nothing left to unsubscribe */
+    run_cmd(rig, "\\unsubscribe", out, sizeof(out));
+    TEST_CHECK(strstr(out, "RPRT -1") != NULL);
+    TEST_MSG("out: %s", out);
+
+    notify_test_end(rig);
+}
+
+
+void test_cmd_subscribe_bad_items(void)
+{
+    RIG *rig = notify_test_begin();
+    char out[256];
+
+    TEST_ASSERT(rig != NULL);
+
+    run_cmd(rig, "\\subscribe FREQ,NOPE", out, sizeof(out));
+    TEST_CHECK(strstr(out, "RPRT -1") != NULL);
+    TEST_MSG("out: %s", out);
+    TEST_CHECK(rigctld_notify_count(&g_notify_registry) == 0);
+
+    notify_test_end(rig);
+}
+
+
+void test_cmd_subscribe_needs_registry(void)
+{
+    RIG *rig = rig_init(RIG_MODEL_DUMMY);
+    char out[256];
+
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(rig_open(rig) == RIG_OK);
+    rigctl_parse_init();
+
+    /* A local rigctl has no notifier */
+    run_cmd(rig, "\\subscribe FREQ", out, sizeof(out));
+    TEST_CHECK(strstr(out, "RPRT -11") != NULL);
+    TEST_MSG("out: %s", out);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+}
+
+
+/* --- Notifier --- */
+
+void test_tick_pushes_snapshot_then_changes(void)
+{
+    RIG *rig = notify_test_begin();
+    char buf[512];
+    int srv, cli;
+
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(tcp_pair(&srv, &cli) == 0);
+
+    rig_set_freq(rig, RIG_VFO_CURR, 14074000);
+    rig_set_mode(rig, RIG_VFO_CURR, RIG_MODE_USB, 2400);
+
+    TEST_CHECK(rigctld_notify_subscribe(&g_notify_registry, 1, srv,
+                                        RIGCTLD_NOTIFY_FREQ | RIGCTLD_NOTIFY_MODE
+                                        | RIGCTLD_NOTIFY_PTT, 100, 0) == RIG_OK);
+
+    /* First push is a full snapshot of the subscribed items */
+    rigctld_notify_tick(&g_notify_registry, 1000);
+    read_pushed(cli, buf, sizeof(buf), 500);
+    TEST_CHECK(strcmp(buf, "!notify freq=14074000 mode=USB width=2400 "
+                      "ptt=0\n") == 0);
+    TEST_MSG("pushed: %s", buf);
+
+    /* Nothing changed: nothing pushed */
+    rigctld_notify_tick(&g_notify_registry, 1100);
+    TEST_CHECK(read_pushed(cli, buf, sizeof(buf), 50) == 0);
+
+    /* Only the changed item is pushed */
+    rig_set_freq(rig, RIG_VFO_CURR, 7074000);
+    rigctld_notify_tick(&g_notify_registry, 1200);
+    read_pushed(cli, buf, sizeof(buf), 500);
+    TEST_CHECK(strcmp(buf, "!notify freq=7074000\n") == 0);
+    TEST_MSG("pushed: %s", buf);
+
+    rigctld_notify_unsubscribe(&g_notify_registry, 1);
+    socket_close(cli);
+    socket_close(srv);
+    notify_test_end(rig);
+}
+
+
+void test_tick_rate_limit_coalesces(void)
+{
+    RIG *rig = notify_test_begin();
+    char buf[512];
+    int srv, cli;
+
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(tcp_pair(&srv, &cli) == 0);
+
+    rig_set_freq(rig, RIG_VFO_CURR, 14074000);
+    rigctld_notify_subscribe(&g_notify_registry, 1, srv, RIGCTLD_NOTIFY_FREQ,
+                             500, 0);
+    rigctld_notify_tick(&g_notify_registry, 1000);
+    read_pushed(cli, buf, sizeof(buf), 500);
+    TEST_CHECK(strstr(buf, "freq=14074000") != NULL);
+
+    /* Changes inside the interval are held back... */
+    rig_set_freq(rig, RIG_VFO_CURR, 14075000);
+    TEST_CHECK(rigctld_notify_tick(&g_notify_registry, 1100) == 400);
+    rig_set_freq(rig, RIG_VFO_CURR, 14076000);
+    rigctld_notify_tick(&g_notify_registry, 1300);
+    TEST_CHECK(read_pushed(cli, buf, sizeof(buf), 50) == 0);
+
+    /* ...even when an event wakes the notifier early */
+    rigctld_notify_wake(&g_notify_registry);
+    rigctld_notify_tick(&g_notify_registry, 1400);
+    TEST_CHECK(read_pushed(cli, buf, sizeof(buf), 50) == 0);
+
+    /* ...and then pushed once, with the latest value only */
+    rigctld_notify_tick(&g_notify_registry, 1500);
+    read_pushed(cli, buf, sizeof(buf), 500);
+    TEST_CHECK(strcmp(buf, "!notify freq=14076000\n") == 0);
+    TEST_MSG("pushed: %s", buf);
+
+    rigctld_notify_unsubscribe(&g_notify_registry, 1);
+    socket_close(cli);
+    socket_close(srv);
+    notify_test_end(rig);
+}
+
+
+void test_tick_subscribers_independent(void)
+{
+    RIG *rig = notify_test_begin();
+    char buf[512];
+    int srv1, cli1, srv2, cli2;
+
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(tcp_pair(&srv1, &cli1) == 0);
+    TEST_ASSERT(tcp_pair(&srv2, &cli2) == 0);
+
+    rig_set_freq(rig, RIG_VFO_CURR, 3573000);
+    rigctld_notify_subscribe(&g_notify_registry, 1, srv1, RIGCTLD_NOTIFY_FREQ,
+                             100, 0);
+    rigctld_notify_subscribe(&g_notify_registry, 2, srv2, RIGCTLD_NOTIFY_PTT,
+                             100, 0);
+
+    rigctld_notify_tick(&g_notify_registry, 1000);
+    read_pushed(cli1, buf, sizeof(buf), 500);
+    TEST_CHECK(strcmp(buf, "!notify freq=3573000\n") == 0);
+    read_pushed(cli2, buf, sizeof(buf), 500);
+    TEST_CHECK(strcmp(buf, "!notify ptt=0\n") == 0);
+
+    /* A freq change reaches only the FREQ subscriber */
+    rig_set_freq(rig, RIG_VFO_CURR, 3574000);
+    rigctld_notify_tick(&g_notify_registry, 1100);
+    read_pushed(cli1, buf, sizeof(buf), 500);
+    TEST_CHECK(strcmp(buf, "!notify freq=3574000\n") == 0);
+    TEST_CHECK(read_pushed(cli2, buf, sizeof(buf), 50) == 0);
+
+    /* A disconnected client stops being served */
+    TEST_CHECK(rigctld_notify_unsubscribe(&g_notify_registry, 1) == 1);
+    TEST_CHECK(rigctld_notify_unsubscribe(&g_notify_registry, 1) == 0);
+    TEST_CHECK(rigctld_notify_count(&g_notify_registry) == 1);
+
+    rigctld_notify_unsubscribe(&g_notify_registry, 2);
+    socket_close(cli1);
+    socket_close(srv1);
+    socket_close(cli2);
+    socket_close(srv2);
+    notify_test_end(rig);
+}
+
+
+/* A subscriber that stops reading never blocks the tick (which holds the
+ * reply lock): its pushes are dropped, or it is disconnected once a line
+ * is cut short. */
+void test_tick_stalled_subscriber_drops(void)
+{
+    RIG *rig = notify_test_begin();
+    char fill[4096];
+    const struct rigctld_subscriber *sub = NULL;
+    int srv, cli, i;
+
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(tcp_pair(&srv, &cli) == 0);
+
+    memset(fill, 'x', sizeof(fill));
+
+    TEST_CHECK(rigctld_notify_subscribe(&g_notify_registry, 1, srv,
+                                        RIGCTLD_NOTIFY_FREQ, 100,
+                                        0) == RIG_OK);
+
+    for (i = 0; i < RIGCTLD_MAX_SUBSCRIBERS && !sub; i++)
+    {
+        sub = g_notify_registry.subs[i];
+    }
+
+    TEST_ASSERT(sub != NULL);
+
+    for (i = 0; i < 5; i++)
+    {
+        int n;
+
+        /* Refill: the kernel may have made room since */
+        for (n = 0; n < 100000; n++)
+        {
+            if (send(srv, fill, sizeof(fill), MSG_DONTWAIT) < 0)
+            {
+                break;
+            }
+        }
+
+        TEST_ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+        rig_set_freq(rig, RIG_VFO_CURR, 14074000 + i * 1000);
+        rigctld_notify_tick(&g_notify_registry, 1000 + i * 100);
+    }
+
+    TEST_CHECK_(sub->drops >= 1, "pushes=%u drops=%u", sub->pushes,
+                sub->drops);
+
+    rigctld_notify_unsubscribe(&g_notify_registry, 1);
+    socket_close(cli);
+    socket_close(srv);
+    notify_test_end(rig);
+}
+
+
+void test_thread_pushes(void)
+{
+    RIG *rig = notify_test_begin();
+    char buf[512];
+    int srv, cli;
+
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(tcp_pair(&srv, &cli) == 0);
+
+    rig_set_freq(rig, RIG_VFO_CURR, 10136000);
+    TEST_ASSERT(rigctld_notify_start(&g_notify_registry, rig, NULL, NULL) == 0);
+    rigctld_notify_subscribe(&g_notify_registry, 1, srv, RIGCTLD_NOTIFY_FREQ,
+                             RIGCTLD_NOTIFY_INTERVAL_MIN, 0);
+
+    read_pushed(cli, buf, sizeof(buf), 2000);
+    TEST_CHECK(strcmp(buf, "!notify freq=10136000\n") == 0);
+    TEST_MSG("pushed: %s", buf);
+
+    rig_set_freq(rig, RIG_VFO_CURR, 10137000);
+    read_pushed(cli, buf, sizeof(buf), 2000);
+    TEST_CHECK(strcmp(buf, "!notify freq=10137000\n") == 0);
+    TEST_MSG("pushed: %s", buf);
+
+    rigctld_notify_unsubscribe(&g_notify_registry, 1);
+    notify_test_end(rig);   /* joins the notifier */
+    socket_close(cli);
+    socket_close(srv);
+}
+
+
+TEST_LIST =
+{
+    { "parse_args_defaults",               test_parse_args_defaults },
+    { "parse_args_full",                   test_parse_args_full },
+    { "parse_args_invalid",                test_parse_args_invalid },
+    { "diff_first_push_is_full",           test_diff_first_push_is_full },
+    { "diff_strength_deadband",            test_diff_strength_deadband },
+    { "format_line",                       test_format_line },
+    { "cmd_subscribe_unsubscribe",         test_cmd_subscribe_unsubscribe },
+    { "cmd_subscribe_bad_items",           test_cmd_subscribe_bad_items },
+    { "cmd_subscribe_needs_registry",      test_cmd_subscribe_needs_registry },
+    { "tick_pushes_snapshot_then_changes", test_tick_pushes_snapshot_then_changes },
+    { "tick_rate_limit_coalesces",         test_tick_rate_limit_coalesces },
+    { "tick_subscribers_independent",      test_tick_subscribers_independent },
+    { "tick_stalled_subscriber_drops",     test_tick_stalled_subscriber_drops },
+    { "thread_pushes",                     test_thread_pushes },
+    { NULL, NULL }
+};
@@ -0,0 +1,205 @@
+/*
+ *  Hamlib rigctld rigs file tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Tests for the multi-rig rigctld rigs file parser. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include "../tests/rigctld_rigs.h"
+#include <string.h>
+#include <stdio.h>
+
+
+/* Parse text as a rigs file; returns the parser result. */
+static int parse_text(struct rigctld_rig_table *table, const char *text,
+                      char *err, size_t errlen)
+{
+    FILE *f = tmpfile();
+    int ret;
+
+    if (!f)
+    {
+        return -2;
+    }
+
+    fputs(text, f);
+    rewind(f);
+    err[0] = '\0';
+    ret = rigctld_rigs_parse(table, f, err, errlen);
+    fclose(f);
+
+    return ret;
+}
+
+
+void test_parse_two_rigs(void)
+{
+    static struct rigctld_rig_table table;
+    char err[128];
+    const char *text =
+        "# shack\n"
+        "[hf]\n"
+        "model = 1\n"
+        "rig_file = /dev/ttyUSB0\n"
+        "serial_speed = 38400\n"
+        "\n"
+        "; second rig has its own port\n"
+        "[ vhf ]\n"
+        "  model=1  \n"
+        "port = 4540\n";
+
+    TEST_ASSERT(parse_text(&table, text, err, sizeof(err)) == 0);
+    TEST_MSG("err: %s", err);
+    TEST_CHECK(table.count == 2);
+
+    TEST_CHECK(strcmp(table.rigs[0].name, "hf") == 0);
+    TEST_CHECK(table.rigs[0].model == 1);
+    TEST_CHECK(strcmp(table.rigs[0].rig_file, "/dev/ttyUSB0") == 0);
+    TEST_CHECK(table.rigs[0].serial_speed == 38400);
+    TEST_CHECK(table.rigs[0].port[0] == '\0');
+    TEST_CHECK(table.rigs[0].sock_listen == -1);
+
+    TEST_CHECK(strcmp(table.rigs[1].name, "vhf") == 0);
+    TEST_CHECK(strcmp(table.rigs[1].port, "4540") == 0);
+    TEST_CHECK(table.rigs[1].rig_file[0] == '\0');
+}
+
+
+void test_parse_set_conf_accumulates(void)
+{
+    static struct rigctld_rig_table table;
+    char err[128];
+    const char *text =
+        "[ic7300]\n"
+        "model = 3073\n"
+        "set_conf = civaddr=0x94\n"
+        "set_conf = ptt_type=RIG,timeout=500\n";
+
+    TEST_ASSERT(parse_text(&table, text, err, sizeof(err)) == 0);
+    TEST_CHECK(strcmp(table.rigs[0].set_conf,
+                      "civaddr=0x94,ptt_type=RIG,timeout=500") == 0);
+    TEST_MSG("set_conf: %s", table.rigs[0].set_conf);
+}
+
+
+void test_parse_errors(void)
+{
+    static struct rigctld_rig_table table;
+    static const struct
+    {
+        const char *text;
+        const char *err;
+    } cases[] =
+    {
+        { "", "no [rig] sections" },
+        { "# only a comment\n", "no [rig] sections" },
+        { "model = 1\n", "line 1: setting outside" },
+        { "[a]\nmodel = 1\n[a]\nmodel = 1\n", "line 3: duplicate rig 'a'" },
+        { "[a b]\nmodel = 1\n", "line 1: invalid rig name" },
+        { "[a\nmodel = 1\n", "line 1: malformed section" },
+        { "[a]\nport = 4540\n", "rig 'a' has no model" },
+        { "[a]\nmodel = 0\n", "line 2: invalid model" },
+        { "[a]\nmodel = x\n", "line 2: invalid model" },
+        { "[a]\nmodel = 1\nport = 70000\n", "line 3: invalid port" },
+        { "[a]\nmodel = 1\nserial_speed = -5\n", "line 3: invalid serial_speed" },
+        { "[a]\nmodel = 1\ncolour = red\n", "line 3: unknown key 'colour'" },
+        { "[a]\nmodel = 1\nnonsense\n", "line 3: expected key = value" },
+        {
+            "[a]\nmodel = 1\nport = 4540\n[b]\nmodel = 1\nport = 4540\n",
+            "rigs 'a' and 'b' share port 4540"
+        },
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        char err[128];
+
+        TEST_CASE_("%s", cases[i].err);
+        TEST_CHECK(parse_text(&table, cases[i].text, err, sizeof(err)) == -1);
+        TEST_CHECK(strstr(err, cases[i].err) != NULL);
+        TEST_MSG("err: %s", err);
+    }
+}
+
+
+void test_parse_too_many_rigs(void)
+{
+    static struct rigctld_rig_table table;
+    char text[2048] = "";
+    char err[128];
+    int i;
+
+    for (i = 0; i <= RIGCTLD_MAX_RIGS; i++)
+    {
+        char section[64];
+
+        snprintf(section, sizeof(section), "[rig%d]\nmodel = 1\n", i);
+        strcat(text, section);
+    }
+
+    TEST_CHECK(parse_text(&table, text, err, sizeof(err)) == -1);
+    TEST_CHECK(strstr(err, "more than") != NULL);
+    TEST_MSG("err: %s", err);
+}
+
+
+void test_find(void)
+{
+    static struct rigctld_rig_table table;
+    char err[128];
+
+    TEST_ASSERT(parse_text(&table, "[hf]\nmodel = 1\n[vhf]\nmodel = 1\n",
+                           err, sizeof(err)) == 0);
+
+    TEST_CHECK(rigctld_rigs_find(&table, "hf") == &table.rigs[0]);
+    TEST_CHECK(rigctld_rigs_find(&table, "vhf") == &table.rigs[1]);
+    TEST_CHECK(rigctld_rigs_find(&table, "VHF") == NULL);
+    TEST_CHECK(rigctld_rigs_find(&table, "uhf") == NULL);
+    TEST_CHECK(rigctld_rigs_find(&table, NULL) == NULL);
+}
+
+
+void test_load_missing_file(void)
+{
+    static struct rigctld_rig_table table;
+    char err[256];
+
+    TEST_CHECK(rigctld_rigs_load(&table, "/nonexistent/rigs.conf", err,
+                                 sizeof(err)) == -1);
+    TEST_CHECK(strstr(err, "/nonexistent/rigs.conf") != NULL);
+}
+
+
+TEST_LIST =
+{
+    { "parse_two_rigs",            test_parse_two_rigs },
+    { "parse_set_conf_accumulates", test_parse_set_conf_accumulates },
+    { "parse_errors",              test_parse_errors },
+    { "parse_too_many_rigs",       test_parse_too_many_rigs },
+    { "find",                      test_find },
+    { "load_missing_file",         test_load_missing_file },
+    { NULL, NULL }
+};
@@ -0,0 +1,310 @@
+/*
+ *  Hamlib rigctld command scheduling tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Tests for the rigctld fair rig lock and per-client token buckets. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include "../tests/rigctld_sched.h"
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static struct rigctld_sched sched;
+
+
+void test_parse_rates(void)
+{
+    static const char *bad[] =
+    {
+        "", "x", "-1", "10,", "10,x", "10,5,1", "20000", "10;5", NULL
+    };
+    int i;
+
+    rigctld_sched_init(&sched);
+
+    TEST_CHECK(rigctld_sched_parse_rates(&sched, "10") == 0);
+    TEST_CHECK(sched.rate[RIGCTLD_CLASS_READ] == 10);
+    TEST_CHECK(sched.rate[RIGCTLD_CLASS_WRITE] == 0);
+
+    TEST_CHECK(rigctld_sched_parse_rates(&sched, "0,25") == 0);
+    TEST_CHECK(sched.rate[RIGCTLD_CLASS_READ] == 0);
+    TEST_CHECK(sched.rate[RIGCTLD_CLASS_WRITE] == 25);
+
+    for (i = 0; bad[i]; i++)
+    {
+        TEST_CASE_("'%s'", bad[i]);
+        TEST_CHECK(rigctld_sched_parse_rates(&sched, bad[i]) == -1);
+    }
+
+    TEST_CHECK(rigctld_sched_parse_rates(&sched, NULL) == -1);
+    /* A rejected spec leaves the rates alone */
+    TEST_CHECK(sched.rate[RIGCTLD_CLASS_WRITE] == 25);
+}
+
+
+void test_command_class(void)
+{
+    TEST_CHECK(rigctld_sched_class(1, 0) == RIGCTLD_CLASS_WRITE);
+    TEST_CHECK(rigctld_sched_class(1, 1) == RIGCTLD_CLASS_READ);
+    TEST_CHECK(rigctld_sched_class(0, 1) == RIGCTLD_CLASS_READ);
+    TEST_CHECK(rigctld_sched_class(0, 0) == RIGCTLD_CLASS_READ);
+}
+
+
+void test_unlimited_counts_only(void)
+{
+    struct rigctld_sched_client *c;
+    int i;
+
+    rigctld_sched_init(&sched);
+    c = rigctld_sched_attach(&sched, 1, "127.0.0.1:1000");
+    TEST_ASSERT(c != NULL);
+
+    for (i = 0; i < 1000; i++)
+    {
+        TEST_CHECK(rigctld_sched_admit(&sched, c, RIGCTLD_CLASS_READ, 1000) == 0);
+    }
+
+    TEST_CHECK(c->stats[RIGCTLD_CLASS_READ].commands == 1000);
+    TEST_CHECK(c->stats[RIGCTLD_CLASS_READ].throttled == 0);
+}
+
+
+void test_bucket_throttles(void)
+{
+    struct rigctld_sched_client *c;
+    const int64_t t0 = 5000000;
+    int i;
+
+    rigctld_sched_init(&sched);
+    TEST_ASSERT(rigctld_sched_parse_rates(&sched, "10") == 0);
+    c = rigctld_sched_attach(&sched, 1, "127.0.0.1:1000");
+    TEST_ASSERT(c != NULL);
+
+    /* One second's worth goes through at once */
+    for (i = 0; i < 10; i++)
+    {
+        TEST_CHECK(rigctld_sched_admit(&sched, c, RIGCTLD_CLASS_READ, t0) == 0);
+    }
+
+    /* Then each command waits its turn at 10/s */
+    TEST_CHECK(rigctld_sched_admit(&sched, c, RIGCTLD_CLASS_READ, t0) == 100000);
+    TEST_CHECK(rigctld_sched_admit(&sched, c, RIGCTLD_CLASS_READ, t0) == 200000);
+    TEST_CHECK(c->stats[RIGCTLD_CLASS_READ].throttled == 2);
+    TEST_CHECK(c->stats[RIGCTLD_CLASS_READ].throttle_us == 300000);
+
+    /* Writes have no limit here */
+    TEST_CHECK(rigctld_sched_admit(&sched, c, RIGCTLD_CLASS_WRITE, t0) == 0);
+
+    /* After the backlog drains the bucket refills, capped at the burst */
+    TEST_CHECK(rigctld_sched_admit(&sched, c, RIGCTLD_CLASS_READ,
+                                   t0 + 300000) == 0);
+
+    for (i = 0; i < 9; i++)
+    {
+        TEST_CHECK(rigctld_sched_admit(&sched, c, RIGCTLD_CLASS_READ,
+                                       t0 + 10000000) == 0);
+    }
+
+    TEST_CHECK(rigctld_sched_admit(&sched, c, RIGCTLD_CLASS_READ,
+                                   t0 + 10000000) == 0);
+    TEST_CHECK(rigctld_sched_admit(&sched, c, RIGCTLD_CLASS_READ,
+                                   t0 + 10000000) == 100000);
+}
+
+
+void test_buckets_per_client(void)
+{
+    struct rigctld_sched_client *a, *b;
+    int i;
+
+    rigctld_sched_init(&sched);
+    TEST_ASSERT(rigctld_sched_parse_rates(&sched, "1,1") == 0);
+    a = rigctld_sched_attach(&sched, 1, "a");
+    b = rigctld_sched_attach(&sched, 2, "b");
+    TEST_ASSERT(a != NULL && b != NULL);
+
+    TEST_CHECK(rigctld_sched_admit(&sched, a, RIGCTLD_CLASS_READ, 1000) == 0);
+    TEST_CHECK(rigctld_sched_admit(&sched, a, RIGCTLD_CLASS_READ, 1000) > 0);
+
+    /* Another client, and control work, are not held back by a */
+    TEST_CHECK(rigctld_sched_admit(&sched, b, RIGCTLD_CLASS_READ, 1000) == 0);
+
+    for (i = 0; i < 10; i++)
+    {
+        TEST_CHECK(rigctld_sched_admit(&sched, a, RIGCTLD_CLASS_CONTROL, 1000) == 0);
+    }
+
+    TEST_CHECK(a->stats[RIGCTLD_CLASS_CONTROL].commands == 0);
+    TEST_CHECK(rigctld_sched_admit(&sched, NULL, RIGCTLD_CLASS_READ, 1000) == 0);
+}
+
+
+void test_attach_detach_snapshot(void)
+{
+    static struct rigctld_sched_client out[RIGCTLD_MAX_CLIENTS];
+    struct rigctld_sched_client *c[RIGCTLD_MAX_CLIENTS];
+    int i;
+
+    rigctld_sched_init(&sched);
+
+    for (i = 0; i < RIGCTLD_MAX_CLIENTS; i++)
+    {
+        c[i] = rigctld_sched_attach(&sched, i + 1, "peer");
+        TEST_ASSERT(c[i] != NULL);
+    }
+
+    TEST_CHECK(rigctld_sched_attach(&sched, 999, "peer") == NULL);
+
+    rigctld_sched_record_wait(&sched, c[3], RIGCTLD_CLASS_WRITE, 7000);
+    rigctld_sched_record_wait(&sched, c[3], RIGCTLD_CLASS_WRITE, 2000);
+    rigctld_sched_detach(&sched, c[0]);
+    rigctld_sched_detach(&sched, NULL);
+
+    TEST_CHECK(rigctld_sched_snapshot(&sched, out, RIGCTLD_MAX_CLIENTS)
+               == RIGCTLD_MAX_CLIENTS - 1);
+    TEST_CHECK(out[0].client_id == 2);
+    TEST_CHECK(out[2].client_id == 4);
+    TEST_CHECK(out[2].stats[RIGCTLD_CLASS_WRITE].wait_us == 9000);
+    TEST_CHECK(out[2].stats[RIGCTLD_CLASS_WRITE].wait_max_us == 7000);
+
+    /* A freed slot starts from scratch */
+    c[0] = rigctld_sched_attach(&sched, 500, "new");
+    TEST_ASSERT(c[0] != NULL);
+    TEST_CHECK(c[0]->client_id == 500);
+    TEST_CHECK(c[0]->stats[RIGCTLD_CLASS_READ].commands == 0);
+}
+
+
+/* --- Fair lock ordering --- */
+
+static struct rigctld_fair_lock fair;
+static pthread_mutex_t order_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char order[16];
+static int order_len;
+
+struct waiter
+{
+    int cls;
+    char tag;
+};
+
+
+static void *waiter_thread(void *p)
+{
+    const struct waiter *w = p;
+
+    rigctld_fair_lock_acquire(&fair, w->cls);
+
+    pthread_mutex_lock(&order_mutex);
+    order[order_len++] = w->tag;
+    pthread_mutex_unlock(&order_mutex);
+
+    rigctld_fair_lock_release(&fair);
+
+    return NULL;
+}
+
+
+/* Wait until n tickets of queue q have been handed out */
+static int wait_queued(int q, unsigned int n)
+{
+    for (int i = 0; i < 2000; i++)
+    {
+        unsigned int next;
+
+        pthread_mutex_lock(&fair.mutex);
+        next = fair.next[q];
+        pthread_mutex_unlock(&fair.mutex);
+
+        if (next == n)
+        {
+            return 1;
+        }
+
+        usleep(1000);
+    }
+
+    return 0;
+}
+
+
+void test_fair_lock_order(void)
+{
+    /* Queued in this order while the lock is held */
+    static const struct waiter waiters[] =
+    {
+        { RIGCTLD_CLASS_READ,    'a' },
+        { RIGCTLD_CLASS_READ,    'b' },
+        { RIGCTLD_CLASS_WRITE,   'W' },
+        { RIGCTLD_CLASS_READ,    'c' },
+        { RIGCTLD_CLASS_CONTROL, 'C' },
+    };
+    pthread_t threads[5];
+    unsigned int queued[2] = { 1, 0 };  /* The holder took a priority ticket */
+    int i;
+
+    rigctld_fair_lock_init(&fair);
+    order_len = 0;
+    memset(order, 0, sizeof(order));
+
+    rigctld_fair_lock_acquire(&fair, RIGCTLD_CLASS_CONTROL);
+
+    for (i = 0; i < 5; i++)
+    {
+        int q = waiters[i].cls == RIGCTLD_CLASS_READ;
+
+        TEST_ASSERT(pthread_create(&threads[i], NULL, waiter_thread,
+                                   (void *)&waiters[i]) == 0);
+        TEST_ASSERT(wait_queued(q, ++queued[q]));
+    }
+
+    rigctld_fair_lock_release(&fair);
+
+    for (i = 0; i < 5; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Writes and control jump the read queue; each queue is FIFO */
+    TEST_CHECK(strcmp(order, "WCabc") == 0);
+    TEST_MSG("order: %s", order);
+
+    rigctld_fair_lock_destroy(&fair);
+}
+
+
+TEST_LIST =
+{
+    { "parse_rates",            test_parse_rates },
+    { "command_class",          test_command_class },
+    { "unlimited_counts_only",  test_unlimited_counts_only },
+    { "bucket_throttles",       test_bucket_throttles },
+    { "buckets_per_client",     test_buckets_per_client },
+    { "attach_detach_snapshot", test_attach_detach_snapshot },
+    { "fair_lock_order",        test_fair_lock_order },
+    { NULL, NULL }
+};
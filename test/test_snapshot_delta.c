@@ -0,0 +1,301 @@
+/*
+ *  Hamlib multicast snapshot delta tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Keyframes and change-only deltas of the multicast snapshot, and the
+ * receiver side loss detection. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include <hamlib/rig.h>
+#include <hamlib/rig_state.h>
+#include "snapshot_data.h"
+#include "misc.h"
+#include "cJSON.h"
+#include <string.h>
+#include <stdlib.h>
+
+static char out[HAMLIB_MAX_SNAPSHOT_PACKET_SIZE];
+
+
+static RIG *open_rig(void)
+{
+    RIG *rig = rig_init(RIG_MODEL_DUMMY);
+
+    if (rig == NULL || rig_open(rig) != RIG_OK)
+    {
+        return NULL;
+    }
+
+    rig_set_freq(rig, RIG_VFO_A, 14074000);
+    rig_set_mode(rig, RIG_VFO_A, RIG_MODE_PKTUSB, 3000);
+
+    return rig;
+}
+
+
+static void close_rig(RIG *rig)
+{
+    rig_close(rig);
+    rig_cleanup(rig);
+}
+
+
+/* Parse out and check its CRC like a receiver would */
+static cJSON *parse_checked(void)
+{
+    cJSON *root = cJSON_Parse(out);
+    cJSON *crc_item;
+    double crc;
+    char *zeroed;
+
+    if (root == NULL)
+    {
+        return NULL;
+    }
+
+    crc_item = cJSON_GetObjectItem(root, "crc");
+    TEST_ASSERT(crc_item != NULL);
+    crc = crc_item->valuedouble;
+    cJSON_SetNumberValue(crc_item, 0);
+    zeroed = cJSON_PrintUnformatted(root);
+    TEST_ASSERT(zeroed != NULL);
+    TEST_CHECK(crc == CRC32_function((const uint8_t *)zeroed, strlen(zeroed)));
+    free(zeroed);
+
+    return root;
+}
+
+
+void test_delta_off_is_plain_snapshot(void)
+{
+    static struct snapshot_static st;
+    struct snapshot_delta delta;
+    cJSON *root;
+    RIG *rig = open_rig();
+
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(snapshot_init(&st, rig) == RIG_OK);
+    snapshot_delta_init(&delta, 0);
+
+    TEST_CHECK(snapshot_serialize_delta(sizeof(out), out, rig, &st, &delta,
+                                        NULL, 1000) == RIG_OK);
+    root = parse_checked();
+    TEST_ASSERT(root != NULL);
+    TEST_CHECK(cJSON_GetObjectItem(root, "app") != NULL);
+    TEST_CHECK(cJSON_GetObjectItem(root, "keyframe") == NULL);
+    TEST_CHECK(cJSON_GetObjectItem(root, "delta") == NULL);
+    cJSON_Delete(root);
+
+    close_rig(rig);
+}
+
+
+void test_keyframe_then_changes_only(void)
+{
+    static struct snapshot_static st;
+    struct snapshot_delta delta;
+    cJSON *root, *rig_obj, *vfos, *vfo;
+    size_t keyframe_len;
+    double keyframe_seq;
+    RIG *rig = open_rig();
+
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(snapshot_init(&st, rig) == RIG_OK);
+    snapshot_delta_init(&delta, 5000);
+
+    /* The first packet is a full keyframe */
+    TEST_ASSERT(snapshot_serialize_delta(sizeof(out), out, rig, &st, &delta,
+                                         NULL, 1000) == RIG_OK);
+    keyframe_len = strlen(out);
+    root = parse_checked();
+    TEST_ASSERT(root != NULL);
+    TEST_CHECK(cJSON_IsTrue(cJSON_GetObjectItem(root, "keyframe")));
+    TEST_CHECK(cJSON_GetObjectItem(root, "app") != NULL);
+    rig_obj = cJSON_GetObjectItem(root, "rig");
+    TEST_CHECK(cJSON_GetObjectItem(rig_obj, "modes") != NULL);
+    TEST_CHECK(cJSON_GetObjectItem(rig_obj, "split") != NULL);
+    TEST_CHECK(cJSON_GetArraySize(cJSON_GetObjectItem(root, "vfos")) >= 2);
+    keyframe_seq = cJSON_GetObjectItem(root, "seq")->valuedouble;
+    cJSON_Delete(root);
+
+    /* Nothing changed: the rig id and sequence only */
+    TEST_ASSERT(snapshot_serialize_delta(sizeof(out), out, rig, &st, &delta,
+                                         NULL, 1500) == RIG_OK);
+    TEST_CHECK(strlen(out) < keyframe_len / 2);
+    TEST_MSG("delta %d bytes, keyframe %d bytes", (int)strlen(out),
+             (int)keyframe_len);
+    root = parse_checked();
+    TEST_ASSERT(root != NULL);
+    TEST_CHECK(cJSON_GetObjectItem(root, "app") == NULL);
+    TEST_CHECK(cJSON_GetObjectItem(root, "keyframe") == NULL);
+    TEST_CHECK(cJSON_GetObjectItem(root, "delta")->valuedouble == keyframe_seq);
+    TEST_CHECK(cJSON_GetObjectItem(root, "seq")->valuedouble == keyframe_seq + 1);
+    rig_obj = cJSON_GetObjectItem(root, "rig");
+    TEST_CHECK(cJSON_GetObjectItem(rig_obj, "id") != NULL);
+    TEST_CHECK(cJSON_GetObjectItem(rig_obj, "modes") == NULL);
+    TEST_CHECK(cJSON_GetObjectItem(rig_obj, "split") == NULL);
+    TEST_CHECK(cJSON_GetObjectItem(root, "vfos") == NULL);
+    cJSON_Delete(root);
+
+    /* One frequency changed: that VFO, named, with only its frequency */
+    TEST_CHECK(rig_set_freq(rig, RIG_VFO_A, 7074000) == RIG_OK);
+    TEST_ASSERT(snapshot_serialize_delta(sizeof(out), out, rig, &st, &delta,
+                                         NULL, 2000) == RIG_OK);
+    root = parse_checked();
+    TEST_ASSERT(root != NULL);
+    vfos = cJSON_GetObjectItem(root, "vfos");
+    TEST_ASSERT(vfos != NULL);
+    TEST_CHECK(cJSON_GetArraySize(vfos) >= 1);
+
+    /* The dummy rig shares VFOA's cache with MainA and Main, all of which
+     * changed; VFOB did not */
+    cJSON_ArrayForEach(vfo, vfos)
+    {
+        const char *name = cJSON_GetObjectItem(vfo, "name")->valuestring;
+
+        TEST_CHECK(strcmp(name, "VFOB") != 0);
+        TEST_CHECK(cJSON_GetObjectItem(vfo, "freq")->valuedouble == 7074000);
+        TEST_CHECK(cJSON_GetObjectItem(vfo, "mode") == NULL);
+        TEST_CHECK(cJSON_GetObjectItem(vfo, "rx") == NULL);
+    }
+
+    TEST_CHECK(strcmp(cJSON_GetObjectItem(cJSON_GetArrayItem(vfos, 0),
+                                          "name")->valuestring, "VFOA") == 0);
+    cJSON_Delete(root);
+
+    /* Once the interval is up the next packet is a keyframe again */
+    TEST_ASSERT(snapshot_serialize_delta(sizeof(out), out, rig, &st, &delta,
+                                         NULL, 6000) == RIG_OK);
+    root = parse_checked();
+    TEST_ASSERT(root != NULL);
+    TEST_CHECK(cJSON_IsTrue(cJSON_GetObjectItem(root, "keyframe")));
+    cJSON_Delete(root);
+
+    /* As it is on request */
+    delta.keyframe_pending = 1;
+    TEST_ASSERT(snapshot_serialize_delta(sizeof(out), out, rig, &st, &delta,
+                                         NULL, 6001) == RIG_OK);
+    TEST_CHECK(strstr(out, "\"keyframe\":true") != NULL);
+
+    close_rig(rig);
+}
+
+
+void test_spectrum_in_delta(void)
+{
+    static struct snapshot_static st;
+    static unsigned char bins[100];
+    struct rig_spectrum_line line;
+    struct snapshot_delta delta;
+    cJSON *root, *spectrum;
+    RIG *rig = open_rig();
+
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(snapshot_init(&st, rig) == RIG_OK);
+    snapshot_delta_init(&delta, 5000);
+
+    memset(&line, 0, sizeof(line));
+    line.spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
+    line.center_freq = 14074000;
+    line.spectrum_data_length = sizeof(bins);
+    line.spectrum_data = bins;
+
+    TEST_ASSERT(snapshot_serialize_delta(sizeof(out), out, rig, &st, &delta,
+                                         NULL, 0) == RIG_OK);
+    TEST_ASSERT(snapshot_serialize_delta(sizeof(out), out, rig, &st, &delta,
+                                         &line, 10) == RIG_OK);
+    root = parse_checked();
+    TEST_ASSERT(root != NULL);
+    TEST_CHECK(cJSON_GetObjectItem(root, "delta") != NULL);
+    spectrum = cJSON_GetArrayItem(cJSON_GetObjectItem(root, "spectra"), 0);
+    TEST_ASSERT(spectrum != NULL);
+    TEST_CHECK(strlen(cJSON_GetObjectItem(spectrum, "data")->valuestring)
+               == 2 * sizeof(bins));
+    cJSON_Delete(root);
+
+    close_rig(rig);
+}
+
+
+void test_receiver_detects_loss(void)
+{
+    struct snapshot_delta_receiver rx;
+
+    memset(&rx, 0, sizeof(rx));
+
+    /* Deltas before any keyframe cannot be used */
+    TEST_CHECK(snapshot_delta_receive(&rx, 10, 0)
+               == SNAPSHOT_DELTA_AWAIT_KEYFRAME);
+    TEST_CHECK(snapshot_delta_receive(&rx, 11, 1) == SNAPSHOT_DELTA_APPLY);
+    TEST_CHECK(snapshot_delta_receive(&rx, 12, 0) == SNAPSHOT_DELTA_APPLY);
+    TEST_CHECK(rx.lost == 0);
+
+    /* 13 and 14 went missing */
+    TEST_CHECK(snapshot_delta_receive(&rx, 15, 0)
+               == SNAPSHOT_DELTA_AWAIT_KEYFRAME);
+    TEST_CHECK(snapshot_delta_receive(&rx, 16, 0)
+               == SNAPSHOT_DELTA_AWAIT_KEYFRAME);
+    TEST_CHECK(rx.lost == 2);
+    TEST_CHECK(snapshot_delta_receive(&rx, 17, 1) == SNAPSHOT_DELTA_APPLY);
+    TEST_CHECK(snapshot_delta_receive(&rx, 18, 0) == SNAPSHOT_DELTA_APPLY);
+
+    /* Wrapping around is in order; a restarted publisher is no loss */
+    rx.last_seq = 0xffffffff;
+    TEST_CHECK(snapshot_delta_receive(&rx, 0, 0) == SNAPSHOT_DELTA_APPLY);
+    TEST_CHECK(snapshot_delta_receive(&rx, 0, 1) == SNAPSHOT_DELTA_APPLY);
+    TEST_CHECK(rx.lost == 2);
+}
+
+
+void test_conf_token(void)
+{
+    char val[32];
+    RIG *rig = rig_init(RIG_MODEL_DUMMY);
+    hamlib_token_t token;
+
+    TEST_ASSERT(rig != NULL);
+    token = rig_token_lookup(rig, "multicast_keyframe_interval");
+
+    TEST_CHECK(rig_get_conf2(rig, token, val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "0") == 0);
+    TEST_CHECK(rig_set_conf(rig, token, "5000") == RIG_OK);
+    TEST_CHECK(rig_get_conf2(rig, token, val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "5000") == 0);
+    TEST_CHECK(rig_set_conf(rig, token, "-1") == -RIG_EINVAL);
+    TEST_CHECK(rig_set_conf(rig, token, "x") == -RIG_EINVAL);
+
+    rig_cleanup(rig);
+}
+
+
+TEST_LIST =
+{
+    { "delta_off_is_plain_snapshot",  test_delta_off_is_plain_snapshot },
+    { "keyframe_then_changes_only",   test_keyframe_then_changes_only },
+    { "spectrum_in_delta",            test_spectrum_in_delta },
+    { "receiver_detects_loss",        test_receiver_detects_loss },
+    { "conf_token",                   test_conf_token },
+    { NULL, NULL }
+};
@@ -0,0 +1,295 @@
+/*
+ *  Hamlib binary spectrum packet tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Tests for the multicast spectrum packet: PackBits coding, encode/decode
+ * round trips per encoding, and rejection of malformed packets. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include <hamlib/rig.h>
+#include "../src/spectrum_packet.h"
+#include <string.h>
+#include <stdlib.h>
+
+static unsigned char bins[HAMLIB_MAX_SPECTRUM_DATA];
+static unsigned char packet[SPECTRUM_PACKET_MAX_SIZE];
+static unsigned char decoded[HAMLIB_MAX_SPECTRUM_DATA];
+
+
+/* A scope line like an IC-7610's: 475 bins of noise floor with a few
+ * signals, as the rig quantizes it (flat runs of the floor level) */
+static void make_scope_line(size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        bins[i] = (i % 37) < 30 ? 8 : (unsigned char)(20 + (i % 37) * 3);
+    }
+}
+
+
+static void make_line(struct rig_spectrum_line *line, size_t n)
+{
+    memset(line, 0, sizeof(*line));
+    line->id = 1;
+    line->spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
+    line->data_level_min = 0;
+    line->data_level_max = 160;
+    line->signal_strength_min = -80.5;
+    line->signal_strength_max = 0;
+    line->center_freq = 14074000;
+    line->span_freq = 50000;
+    line->low_edge_freq = 14049000;
+    line->high_edge_freq = 14099000;
+    line->spectrum_data_length = n;
+    line->spectrum_data = bins;
+}
+
+
+void test_packbits_roundtrip(void)
+{
+    static unsigned char in[1000], coded[1200], out[1000];
+    size_t i;
+    int len;
+
+    /* Long runs split at 128, literals split at 128 */
+    memset(in, 7, 300);
+
+    for (i = 300; i < 1000; i++)
+    {
+        in[i] = (unsigned char)(i * 7919 >> 3);
+    }
+
+    len = spectrum_packbits_encode(in, sizeof(in), coded, sizeof(coded));
+    TEST_ASSERT(len > 0);
+    TEST_CHECK(spectrum_packbits_decode(coded, len, out, sizeof(out))
+               == (int)sizeof(in));
+    TEST_CHECK(memcmp(in, out, sizeof(in)) == 0);
+
+    /* 300 equal bytes take three runs: 2 bytes each */
+    len = spectrum_packbits_encode(in, 300, coded, sizeof(coded));
+    TEST_CHECK(len == 6);
+    TEST_MSG("len=%d", len);
+
+    TEST_CHECK(spectrum_packbits_encode(in, 0, coded, sizeof(coded)) == 0);
+    TEST_CHECK(spectrum_packbits_encode(in + 300, 700, coded, 100) == -1);
+}
+
+
+void test_packbits_malformed(void)
+{
+    static const unsigned char truncated_literal[] = { 4, 1, 2 };
+    static const unsigned char truncated_run[] = { 0xfe };
+    static const unsigned char noop[] = { 0x80, 0xfe, 9 };
+    unsigned char out[8];
+
+    TEST_CHECK(spectrum_packbits_decode(truncated_literal,
+                                        sizeof(truncated_literal), out, sizeof(out)) == -1);
+    TEST_CHECK(spectrum_packbits_decode(truncated_run, sizeof(truncated_run), out,
+                                        sizeof(out)) == -1);
+    TEST_CHECK(spectrum_packbits_decode(noop, sizeof(noop), out, sizeof(out)) == 3);
+    TEST_CHECK(out[0] == 9 && out[2] == 9);
+
+    /* Output overflow */
+    TEST_CHECK(spectrum_packbits_decode(noop, sizeof(noop), out, 2) == -1);
+}
+
+
+void test_encode_decode_each_encoding(void)
+{
+    static const int encodings[] =
+    {
+        SPECTRUM_ENCODING_RAW, SPECTRUM_ENCODING_RLE,
+        SPECTRUM_ENCODING_DELTA, SPECTRUM_ENCODING_AUTO
+    };
+    struct rig_spectrum_line line, out;
+    size_t i;
+
+    make_scope_line(475);
+    make_line(&line, 475);
+
+    for (i = 0; i < sizeof(encodings) / sizeof(encodings[0]); i++)
+    {
+        uint32_t seq = 0;
+        uint64_t time_us = 0;
+        int len;
+
+        TEST_CASE_("%s", spectrum_packet_encoding_name(encodings[i]));
+
+        len = spectrum_packet_encode(&line, 1234 + i, 1700000000123456ULL,
+                                     encodings[i], packet, sizeof(packet));
+        TEST_ASSERT(len > SPECTRUM_PACKET_HEADER_SIZE);
+        TEST_MSG("%d bytes", len);
+
+        if (encodings[i] == SPECTRUM_ENCODING_RAW)
+        {
+            TEST_CHECK(len == SPECTRUM_PACKET_HEADER_SIZE + 475);
+        }
+        else
+        {
+            /* The floor runs compress well below the hex JSON and raw bins */
+            TEST_CHECK(len < SPECTRUM_PACKET_HEADER_SIZE + 475 / 2);
+        }
+
+        memset(decoded, 0, sizeof(decoded));
+        TEST_ASSERT(spectrum_packet_decode(packet, len, &out, decoded, &seq,
+                                           &time_us) == RIG_OK);
+        TEST_CHECK(seq == 1234 + i);
+        TEST_CHECK(time_us == 1700000000123456ULL);
+        TEST_CHECK(out.id == 1);
+        TEST_CHECK(out.spectrum_mode == RIG_SPECTRUM_MODE_CENTER);
+        TEST_CHECK(out.data_level_max == 160);
+        TEST_CHECK(out.signal_strength_min == -80.5);
+        TEST_CHECK(out.center_freq == 14074000);
+        TEST_CHECK(out.span_freq == 50000);
+        TEST_CHECK(out.low_edge_freq == 14049000);
+        TEST_CHECK(out.high_edge_freq == 14099000);
+        TEST_CHECK(out.spectrum_data_length == 475);
+        TEST_CHECK(out.spectrum_data == decoded);
+        TEST_CHECK(memcmp(decoded, bins, 475) == 0);
+    }
+}
+
+
+void test_incompressible_falls_back_to_raw(void)
+{
+    struct rig_spectrum_line line, out;
+    size_t i;
+    int len;
+
+    srand(1);
+
+    for (i = 0; i < HAMLIB_MAX_SPECTRUM_DATA; i++)
+    {
+        bins[i] = (unsigned char)rand();
+    }
+
+    make_line(&line, HAMLIB_MAX_SPECTRUM_DATA);
+
+    len = spectrum_packet_encode(&line, 0, 0, SPECTRUM_ENCODING_DELTA, packet,
+                                 sizeof(packet));
+    TEST_CHECK(len == SPECTRUM_PACKET_MAX_SIZE);
+    TEST_CHECK(packet[5] == SPECTRUM_ENCODING_RAW);
+    TEST_ASSERT(spectrum_packet_decode(packet, len, &out, decoded, NULL,
+                                       NULL) == RIG_OK);
+    TEST_CHECK(memcmp(decoded, bins, HAMLIB_MAX_SPECTRUM_DATA) == 0);
+
+    /* Empty line */
+    make_line(&line, 0);
+    len = spectrum_packet_encode(&line, 0, 0, SPECTRUM_ENCODING_AUTO, packet,
+                                 sizeof(packet));
+    TEST_CHECK(len == SPECTRUM_PACKET_HEADER_SIZE);
+    TEST_CHECK(spectrum_packet_decode(packet, len, &out, decoded, NULL,
+                                      NULL) == RIG_OK);
+    TEST_CHECK(out.spectrum_data_length == 0);
+
+    /* Too small a buffer */
+    make_line(&line, 100);
+    TEST_CHECK(spectrum_packet_encode(&line, 0, 0, SPECTRUM_ENCODING_RAW, packet,
+                                      SPECTRUM_PACKET_HEADER_SIZE + 99) == -RIG_EINVAL);
+}
+
+
+void test_decode_rejects_malformed(void)
+{
+    struct rig_spectrum_line line, out;
+    unsigned char bad[SPECTRUM_PACKET_MAX_SIZE];
+    int len;
+
+    make_scope_line(475);
+    make_line(&line, 475);
+    len = spectrum_packet_encode(&line, 0, 0, SPECTRUM_ENCODING_DELTA, packet,
+                                 sizeof(packet));
+    TEST_ASSERT(len > 0);
+
+    /* Truncated header and payload */
+    TEST_CHECK(spectrum_packet_decode(packet, SPECTRUM_PACKET_HEADER_SIZE - 1,
+                                      &out, decoded, NULL, NULL) == -RIG_EPROTO);
+    TEST_CHECK(spectrum_packet_decode(packet, len - 1, &out, decoded, NULL,
+                                      NULL) == -RIG_EPROTO);
+
+    /* A JSON snapshot, a newer version, an unknown encoding */
+    TEST_CHECK(spectrum_packet_decode((const unsigned char *)"{\"app\":\"Hamlib\"}",
+                                      16, &out, decoded, NULL, NULL) == -RIG_EPROTO);
+    memcpy(bad, packet, len);
+    bad[4] = 2;
+    TEST_CHECK(spectrum_packet_decode(bad, len, &out, decoded, NULL,
+                                      NULL) == -RIG_EPROTO);
+    memcpy(bad, packet, len);
+    bad[5] = 7;
+    TEST_CHECK(spectrum_packet_decode(bad, len, &out, decoded, NULL,
+                                      NULL) == -RIG_EPROTO);
+
+    /* Bin count that the payload does not decode to */
+    memcpy(bad, packet, len);
+    bad[69]++;
+    TEST_CHECK(spectrum_packet_decode(bad, len, &out, decoded, NULL,
+                                      NULL) == -RIG_EPROTO);
+}
+
+
+void test_conf_tokens(void)
+{
+    RIG *rig = rig_init(RIG_MODEL_DUMMY);
+    char val[32];
+
+    TEST_ASSERT(rig != NULL);
+
+    TEST_CHECK(rig_get_conf2(rig, rig_token_lookup(rig,
+                             "multicast_spectrum_format"), val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "json") == 0);
+    TEST_CHECK(rig_get_conf2(rig, rig_token_lookup(rig,
+                             "multicast_spectrum_encoding"), val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "auto") == 0);
+
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig,
+                            "multicast_spectrum_format"), "both") == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig,
+                            "multicast_spectrum_encoding"), "delta") == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig,
+                            "multicast_spectrum_encoding"), "zip") == -RIG_EINVAL);
+
+    TEST_CHECK(rig_get_conf2(rig, rig_token_lookup(rig,
+                             "multicast_spectrum_format"), val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "both") == 0);
+    TEST_CHECK(rig_get_conf2(rig, rig_token_lookup(rig,
+                             "multicast_spectrum_encoding"), val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "delta") == 0);
+
+    rig_cleanup(rig);
+}
+
+
+TEST_LIST =
+{
+    { "packbits_roundtrip",              test_packbits_roundtrip },
+    { "packbits_malformed",              test_packbits_malformed },
+    { "encode_decode_each_encoding",     test_encode_decode_each_encoding },
+    { "incompressible_falls_back_to_raw", test_incompressible_falls_back_to_raw },
+    { "decode_rejects_malformed",        test_decode_rejects_malformed },
+    { "conf_tokens",                     test_conf_tokens },
+    { NULL, NULL }
+};
@@ -0,0 +1,301 @@
+/*
+ *  Hamlib spectrum line processing tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Tests for the spectrum processing kernels, the per-scope processor and
+ * the per-subscriber stage in rig_fire_spectrum_event(). */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include <hamlib/rig.h>
+#include "spectrum_proc.h"
+#include "event.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+static unsigned char bins[HAMLIB_MAX_SPECTRUM_DATA];
+
+
+static void make_line(struct rig_spectrum_line *line, size_t n)
+{
+    memset(line, 0, sizeof(*line));
+    line->spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
+    line->data_level_max = 160;
+    line->center_freq = 14074000;
+    line->span_freq = 50000;
+    line->low_edge_freq = 14049000;
+    line->high_edge_freq = 14099000;
+    line->spectrum_data_length = n;
+    line->spectrum_data = bins;
+}
+
+
+void test_decimate_kernels(void)
+{
+    static const unsigned char in[] = { 1, 9, 3, 4, 4, 4, 200, 0, 7, 6 };
+    unsigned char out[8];
+
+    TEST_CHECK(spectrum_decimate_max(in, sizeof(in), 3, out) == 4);
+    TEST_CHECK(out[0] == 9 && out[1] == 4 && out[2] == 200 && out[3] == 6);
+
+    TEST_CHECK(spectrum_decimate_mean(in, sizeof(in), 3, out) == 4);
+    /* 13/3 rounds to 4, 207/3 = 69, the short last group is just 6 */
+    TEST_CHECK(out[0] == 4 && out[1] == 4 && out[2] == 69 && out[3] == 6);
+    TEST_MSG("%d %d %d %d", out[0], out[1], out[2], out[3]);
+
+    TEST_CHECK(spectrum_decimate_max(in, sizeof(in), 1, out) == sizeof(in));
+}
+
+
+void test_average_and_peak_kernels(void)
+{
+    float acc[4] = { 0, 100, 50, 255 };
+    unsigned char peak[4] = { 10, 100, 0, 255 };
+    static const unsigned char in[4] = { 100, 0, 50, 0 };
+    int i;
+
+    for (i = 0; i < 50; i++)
+    {
+        spectrum_average(acc, in, 4, 0.25f);
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        TEST_CHECK(fabsf(acc[i] - in[i]) < 0.01f);
+    }
+
+    spectrum_peak_hold(peak, in, 4, 3);
+    TEST_CHECK(peak[0] == 100 && peak[1] == 97 && peak[2] == 50
+               && peak[3] == 252);
+
+    /* No decay holds forever, a large decay cannot wrap below zero */
+    spectrum_peak_hold(peak, in, 4, 0);
+    TEST_CHECK(peak[1] == 97);
+    spectrum_peak_hold(peak, in, 4, 255);
+    TEST_CHECK(peak[1] == 0 && peak[0] == 100);
+}
+
+
+void test_parse_and_format(void)
+{
+    static const char *bad[] =
+    {
+        "bins", "bins=-1", "bins=4096", "decimate=min", "average=1.5",
+        "average=x", "peak=256", "rate=1001", "fast=1", "bins=10,,rate=x",
+        NULL
+    };
+    struct spectrum_proc_config c;
+    char buf[128];
+    int i;
+
+    TEST_CHECK(spectrum_proc_parse("", &c) == RIG_OK);
+    TEST_CHECK(spectrum_proc_is_passthrough(&c));
+
+    TEST_CHECK(spectrum_proc_parse("rate=5,peak=2,average=0.25,"
+                                   "decimate=mean,bins=256", &c) == RIG_OK);
+    TEST_CHECK(c.bins == 256 && c.decimate == SPECTRUM_DECIMATE_MEAN);
+    TEST_CHECK(c.average == 0.25 && c.peak && c.peak_decay == 2 && c.rate == 5);
+    spectrum_proc_format(&c, buf, sizeof(buf));
+    TEST_CHECK(strcmp(buf, "bins=256,decimate=mean,average=0.25,peak=2,rate=5")
+               == 0);
+    TEST_MSG("%s", buf);
+
+    /* peak=0 is hold forever, not off; average=1 is off */
+    TEST_CHECK(spectrum_proc_parse("peak=0,average=1", &c) == RIG_OK);
+    TEST_CHECK(c.peak && c.average == 0);
+    spectrum_proc_format(&c, buf, sizeof(buf));
+    TEST_CHECK(strcmp(buf, "peak=0") == 0);
+
+    for (i = 0; bad[i]; i++)
+    {
+        TEST_CASE_("'%s'", bad[i]);
+        TEST_CHECK(spectrum_proc_parse(bad[i], &c) == -RIG_EINVAL);
+    }
+
+    /* A rejected spec leaves the configuration alone */
+    TEST_CHECK(c.peak && c.average == 0);
+}
+
+
+void test_run_decimates_and_holds(void)
+{
+    static struct spectrum_proc proc;
+    struct spectrum_proc_config c;
+    struct rig_spectrum_line line, out;
+    size_t i;
+
+    TEST_ASSERT(spectrum_proc_parse("bins=100,peak=10", &c) == RIG_OK);
+    spectrum_proc_init(&proc, &c);
+
+    memset(bins, 20, sizeof(bins));
+    bins[250] = 150;
+    make_line(&line, 475);
+
+    TEST_ASSERT(spectrum_proc_run(&proc, &line, 1000, &out) == 1);
+    /* 475 bins in groups of 5 */
+    TEST_CHECK(out.spectrum_data_length == 95);
+    TEST_CHECK(out.spectrum_data != bins);
+    TEST_CHECK(out.spectrum_data[50] == 150);
+    TEST_CHECK(out.center_freq == 14074000 && out.span_freq == 50000);
+
+    /* The signal goes away; its peak decays */
+    bins[250] = 20;
+    TEST_ASSERT(spectrum_proc_run(&proc, &line, 2000, &out) == 1);
+    TEST_CHECK(out.spectrum_data[50] == 140);
+
+    /* A new span starts over */
+    line.span_freq = 100000;
+    line.low_edge_freq = 14024000;
+    line.high_edge_freq = 14124000;
+    TEST_ASSERT(spectrum_proc_run(&proc, &line, 3000, &out) == 1);
+    TEST_CHECK(out.spectrum_data[50] == 20);
+
+    /* Scopes are independent */
+    line.id = 1;
+    bins[0] = 99;
+    TEST_ASSERT(spectrum_proc_run(&proc, &line, 4000, &out) == 1);
+    TEST_CHECK(out.spectrum_data[0] == 99);
+
+    for (i = 1; i < out.spectrum_data_length; i++)
+    {
+        TEST_CHECK(out.spectrum_data[i] == 20);
+    }
+
+    /* Out of range ids and passthrough configs hand back the line as is */
+    line.id = HAMLIB_MAX_SPECTRUM_SCOPES;
+    TEST_ASSERT(spectrum_proc_run(&proc, &line, 5000, &out) == 1);
+    TEST_CHECK(out.spectrum_data == bins && out.spectrum_data_length == 475);
+}
+
+
+void test_run_rate_limit_keeps_cadence(void)
+{
+    static struct spectrum_proc proc;
+    struct spectrum_proc_config c;
+    struct rig_spectrum_line line, out;
+    int64_t t;
+    int delivered = 0;
+
+    TEST_ASSERT(spectrum_proc_parse("rate=10,average=0.5", &c) == RIG_OK);
+    spectrum_proc_init(&proc, &c);
+    memset(bins, 0, sizeof(bins));
+    make_line(&line, 100);
+
+    /* 30 lines/s with jitter for two seconds: 10 lines/s come out */
+    for (t = 1000000; t < 3000000; t += 33333)
+    {
+        int64_t jitter = (t / 33333) % 3 == 0 ? 4000 : 0;
+
+        bins[0] = 200;
+        delivered += spectrum_proc_run(&proc, &line, t + jitter, &out);
+    }
+
+    TEST_CHECK(delivered >= 19 && delivered <= 21);
+    TEST_MSG("delivered %d", delivered);
+
+    /* Held back lines still went into the average */
+    TEST_CHECK(out.spectrum_data[0] == 200);
+}
+
+
+static int callback_lines;
+static size_t callback_length;
+
+static int spectrum_cb(RIG *rig, struct rig_spectrum_line *line,
+                       rig_ptr_t arg)
+{
+    (void)rig;
+    (void)arg;
+
+    callback_lines++;
+    callback_length = line->spectrum_data_length;
+
+    return RIG_OK;
+}
+
+
+void test_stage_per_subscriber(void)
+{
+    struct rig_spectrum_line line;
+    char val[128];
+    RIG *rig = rig_init(RIG_MODEL_DUMMY);
+    int i;
+
+    TEST_ASSERT(rig != NULL);
+
+    TEST_CHECK(rig_get_conf2(rig, rig_token_lookup(rig,
+                             "spectrum_callback_process"), val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "") == 0);
+
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig,
+                            "spectrum_callback_process"), "bins=50,decimate=max") == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig,
+                            "multicast_spectrum_process"), "rate=1") == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig,
+                            "multicast_spectrum_process"), "rate=0.5") == -RIG_EINVAL);
+
+    TEST_CHECK(rig_get_conf2(rig, rig_token_lookup(rig,
+                             "spectrum_callback_process"), val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "bins=50") == 0);
+    TEST_CHECK(rig_get_conf2(rig, rig_token_lookup(rig,
+                             "multicast_spectrum_process"), val, sizeof(val)) == RIG_OK);
+    TEST_CHECK(strcmp(val, "rate=1") == 0);
+
+    TEST_ASSERT(rig_open(rig) == RIG_OK);
+    TEST_ASSERT(rig_set_spectrum_callback(rig, spectrum_cb, NULL) == RIG_OK);
+    memset(bins, 1, sizeof(bins));
+    make_line(&line, 475);
+
+    /* The multicast rate limit does not hold back the callback */
+    for (i = 0; i < 5; i++)
+    {
+        TEST_CHECK(rig_fire_spectrum_event(rig, &line) == RIG_OK);
+    }
+
+    TEST_CHECK(callback_lines == 5);
+    TEST_CHECK(callback_length == 48);
+    TEST_MSG("length %d", (int)callback_length);
+
+    /* Back to passthrough */
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig,
+                            "spectrum_callback_process"), "") == RIG_OK);
+    TEST_CHECK(rig_fire_spectrum_event(rig, &line) == RIG_OK);
+    TEST_CHECK(callback_length == 475);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+}
+
+
+TEST_LIST =
+{
+    { "decimate_kernels",            test_decimate_kernels },
+    { "average_and_peak_kernels",    test_average_and_peak_kernels },
+    { "parse_and_format",            test_parse_and_format },
+    { "run_decimates_and_holds",     test_run_decimates_and_holds },
+    { "run_rate_limit_keeps_cadence", test_run_rate_limit_keeps_cadence },
+    { "stage_per_subscriber",        test_stage_per_subscriber },
+    { NULL, NULL }
+};
@@ -0,0 +1,307 @@
+/*
+ *  Hamlib spectrum line ring tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Tests for the SPSC spectrum ring and the multicast publisher reading
+ * lines from it. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include <hamlib/rig.h>
+#include "spectrum_ring.h"
+#include "spectrum_packet.h"
+#include "event.h"
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define STRESS_LINES 20000
+
+static unsigned char bins[HAMLIB_MAX_SPECTRUM_DATA];
+
+
+static void make_line(struct rig_spectrum_line *line, size_t n, int tag)
+{
+    memset(line, 0, sizeof(*line));
+    line->spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
+    line->data_level_max = 160;
+    line->center_freq = 14074000 + tag;
+    line->span_freq = 50000;
+    line->spectrum_data_length = n;
+    line->spectrum_data = bins;
+    memset(bins, tag & 0xff, n);
+}
+
+
+void test_put_peek_release(void)
+{
+    struct spectrum_ring *ring = malloc(sizeof(*ring));
+    struct rig_spectrum_line line;
+    struct spectrum_ring_slot *slot;
+    int i;
+
+    TEST_ASSERT(ring != NULL);
+    spectrum_ring_init(ring);
+    TEST_CHECK(spectrum_ring_empty(ring));
+    TEST_CHECK(spectrum_ring_peek(ring) == NULL);
+
+    for (i = 0; i < SPECTRUM_RING_SLOTS; i++)
+    {
+        make_line(&line, 100 + i, i);
+        TEST_CHECK(spectrum_ring_put(ring, &line) == RIG_OK);
+    }
+
+    /* Full: the newest line is dropped, nothing is overwritten */
+    make_line(&line, 10, 99);
+    TEST_CHECK(spectrum_ring_put(ring, &line) == -RIG_ENAVAIL);
+    TEST_CHECK(ring->dropped == 1);
+    TEST_CHECK(spectrum_ring_acquire(ring) == NULL);
+
+    for (i = 0; i < SPECTRUM_RING_SLOTS; i++)
+    {
+        slot = spectrum_ring_peek(ring);
+        TEST_ASSERT(slot != NULL);
+        TEST_CHECK(slot->line.spectrum_data == slot->data);
+        TEST_CHECK(slot->line.spectrum_data_length == (size_t)(100 + i));
+        TEST_CHECK(slot->line.center_freq == 14074000 + i);
+        TEST_CHECK(slot->data[0] == i && slot->data[99 + i] == i);
+        spectrum_ring_release(ring);
+    }
+
+    TEST_CHECK(spectrum_ring_empty(ring));
+
+    /* Too long for a slot */
+    make_line(&line, 10, 1);
+    line.spectrum_data_length = HAMLIB_MAX_SPECTRUM_DATA + 1;
+    TEST_CHECK(spectrum_ring_put(ring, &line) == -RIG_EINVAL);
+
+    free(ring);
+}
+
+
+void test_acquire_fills_in_place(void)
+{
+    struct spectrum_ring *ring = malloc(sizeof(*ring));
+    struct spectrum_ring_slot *slot, *read;
+    unsigned int i;
+
+    TEST_ASSERT(ring != NULL);
+    spectrum_ring_init(ring);
+
+    /* Wrap the counters around the slots a few times */
+    for (i = 0; i < 3 * SPECTRUM_RING_SLOTS + 5; i++)
+    {
+        slot = spectrum_ring_acquire(ring);
+        TEST_ASSERT(slot != NULL);
+        TEST_CHECK(slot->line.spectrum_data == slot->data);
+
+        slot->line.id = (int)(i % HAMLIB_MAX_SPECTRUM_SCOPES);
+        slot->line.spectrum_data_length = 1;
+        slot->data[0] = (unsigned char)i;
+
+        /* Not visible before the commit */
+        TEST_CHECK(spectrum_ring_peek(ring) == NULL);
+        spectrum_ring_commit(ring);
+
+        read = spectrum_ring_peek(ring);
+        TEST_ASSERT(read == slot);
+        TEST_CHECK(read->data[0] == (unsigned char)i);
+        spectrum_ring_release(ring);
+    }
+
+    free(ring);
+}
+
+
+static void *stress_consumer(void *arg)
+{
+    struct spectrum_ring *ring = arg;
+    long errors = 0;
+    unsigned int expected = 0;
+
+    while (expected < STRESS_LINES)
+    {
+        struct spectrum_ring_slot *slot = spectrum_ring_peek(ring);
+        size_t i;
+
+        if (slot == NULL)
+        {
+            continue;
+        }
+
+        /* Lines arrive in order and whole; drops only skip ahead */
+        if (slot->line.center_freq < expected)
+        {
+            errors++;
+        }
+
+        expected = (unsigned int)slot->line.center_freq + 1;
+
+        for (i = 0; i < slot->line.spectrum_data_length; i++)
+        {
+            if (slot->data[i] != (unsigned char)slot->line.center_freq)
+            {
+                errors++;
+                break;
+            }
+        }
+
+        spectrum_ring_release(ring);
+    }
+
+    return (void *)errors;
+}
+
+
+void test_threaded_order_and_integrity(void)
+{
+    struct spectrum_ring *ring = malloc(sizeof(*ring));
+    unsigned int delivered = 0;
+    pthread_t thread;
+    void *errors;
+    unsigned int i;
+
+    TEST_ASSERT(ring != NULL);
+    spectrum_ring_init(ring);
+    TEST_ASSERT(pthread_create(&thread, NULL, stress_consumer, ring) == 0);
+
+    for (i = 0; i < STRESS_LINES; i++)
+    {
+        struct spectrum_ring_slot *slot;
+
+        /* The last line must get through to end the consumer */
+        while ((slot = spectrum_ring_acquire(ring)) == NULL
+                && i == STRESS_LINES - 1)
+        {
+        }
+
+        if (slot == NULL)
+        {
+            continue;
+        }
+
+        slot->line.center_freq = i;
+        slot->line.spectrum_data_length = 64 + i % 512;
+        memset(slot->data, (unsigned char)i, slot->line.spectrum_data_length);
+        spectrum_ring_commit(ring);
+        delivered++;
+    }
+
+    pthread_join(thread, &errors);
+
+    TEST_CHECK(errors == NULL);
+    TEST_MSG("%ld errors", (long)errors);
+    TEST_CHECK(delivered > 0);
+    TEST_CHECK(spectrum_ring_empty(ring));
+
+    free(ring);
+}
+
+
+/* Lines fired on the rig reach the socket in order via the ring */
+void test_publisher_sends_from_ring(void)
+{
+    static unsigned char packet[SPECTRUM_PACKET_MAX_SIZE];
+    static unsigned char data[HAMLIB_MAX_SPECTRUM_DATA];
+    struct sockaddr_in addr;
+    struct rig_spectrum_line line, decoded;
+    struct timeval tv = { 2, 0 };
+    socklen_t addr_len = sizeof(addr);
+    char port[16];
+    int received = 0, last = -1;
+    RIG *rig;
+    int fd, i;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT(fd >= 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    TEST_ASSERT(getsockname(fd, (struct sockaddr *)&addr, &addr_len) == 0);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    snprintf(port, sizeof(port), "%d", ntohs(addr.sin_port));
+
+    rig = rig_init(RIG_MODEL_DUMMY);
+    TEST_ASSERT(rig != NULL);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig, "multicast_data_addr"),
+                            "127.0.0.1") == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig, "multicast_data_port"),
+                            port) == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig,
+                            "multicast_spectrum_format"), "binary") == RIG_OK);
+    TEST_ASSERT(rig_open(rig) == RIG_OK);
+
+    for (i = 0; i < 8; i++)
+    {
+        make_line(&line, 475, i + 1);
+        TEST_CHECK(rig_fire_spectrum_event(rig, &line) == RIG_OK);
+    }
+
+    while (received < 8)
+    {
+        ssize_t n = recv(fd, packet, sizeof(packet), 0);
+
+        if (n < 0)
+        {
+            break;
+        }
+
+        /* Poll snapshots go to the same port */
+        if (spectrum_packet_decode(packet, n, &decoded, data, NULL, NULL) != RIG_OK)
+        {
+            continue;
+        }
+
+        TEST_CHECK(decoded.spectrum_data_length == 475);
+        TEST_CHECK(data[0] == data[474]);
+        TEST_CHECK(data[0] > last);
+        TEST_CHECK(decoded.center_freq == 14074000 + data[0]);
+        last = data[0];
+        received++;
+    }
+
+    /* All eight fit in the ring, none may be lost */
+    TEST_CHECK(received == 8);
+    TEST_MSG("received %d", received);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+    close(fd);
+}
+
+
+TEST_LIST =
+{
+    { "put_peek_release",              test_put_peek_release },
+    { "acquire_fills_in_place",        test_acquire_fills_in_place },
+    { "threaded_order_and_integrity",  test_threaded_order_and_integrity },
+    { "publisher_sends_from_ring",     test_publisher_sends_from_ring },
+    { NULL, NULL }
+};
@@ -0,0 +1,275 @@
+/*
+ *  Hamlib shared-memory status page tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Tests for the status_shm page: the poll routine mirror seen through
+ * rig_status_page_read(), meter reads, and seqlock consistency under a
+ * concurrent writer. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include <hamlib/rig.h>
+#include <hamlib/rig_state.h>
+#include <hamlib/status_page.h>
+#include "../src/status_page.h"
+#include "cache.h"
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_SHM_OPEN)
+
+#include <sys/mman.h>
+
+static void page_name(char *buf, size_t len, const char *tag)
+{
+    snprintf(buf, len, "/hamlib-test-%s-%d", tag, (int)getpid());
+}
+
+
+/* Poll rig_status_page_read() until VFO A shows want, for at most timeout_ms */
+static int wait_page_freq(const struct rig_status_page *page, double want,
+                          int timeout_ms, struct rig_status_page *snap)
+{
+    for (int waited = 0; waited <= timeout_ms; waited += 10)
+    {
+        if (rig_status_page_read(page, snap) == RIG_OK
+                && snap->vfo_state[RIG_STATUS_VFO_MAIN_A].freq == want)
+        {
+            return 1;
+        }
+
+        usleep(10000);
+    }
+
+    TEST_MSG("freq=%.0f, expected %.0f",
+             snap->vfo_state[RIG_STATUS_VFO_MAIN_A].freq, want);
+    return 0;
+}
+
+
+void test_page_follows_rig(void)
+{
+    struct rig_status_page snap;
+    const struct rig_status_page *page;
+    char name[64];
+    value_t val;
+    RIG *rig;
+
+    page_name(name, sizeof(name), "follow");
+    rig = rig_init(RIG_MODEL_DUMMY);
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "status_shm"), name)
+                == RIG_OK);
+    TEST_ASSERT(rig_open(rig) == RIG_OK);
+
+    page = rig_status_page_open(name);
+    TEST_ASSERT(page != NULL);
+
+    TEST_CHECK(rig_status_page_read(page, &snap) == RIG_OK);
+    TEST_CHECK(snap.magic == RIG_STATUS_PAGE_MAGIC);
+    TEST_CHECK(snap.size == sizeof(snap));
+    TEST_CHECK(snap.rig_model == RIG_MODEL_DUMMY);
+    TEST_CHECK((snap.seq & 1) == 0);
+
+    /* The poll routine picks up cache changes within its change interval */
+    TEST_CHECK(rig_set_freq(rig, RIG_VFO_A, 14074000) == RIG_OK);
+    TEST_CHECK(wait_page_freq(page, 14074000, 2000, &snap));
+    TEST_CHECK(snap.update_ms > 0);
+
+    /* Meters hold the latest read */
+    TEST_CHECK(snap.meter[RIG_STATUS_METER_SWR].valid == 0);
+    TEST_CHECK(rig_get_level(rig, RIG_VFO_CURR, RIG_LEVEL_SWR, &val) == RIG_OK);
+    TEST_CHECK(rig_status_page_read(page, &snap) == RIG_OK);
+    TEST_CHECK(snap.meter[RIG_STATUS_METER_SWR].valid == 1);
+    TEST_CHECK(snap.meter[RIG_STATUS_METER_SWR].value == val.f);
+    TEST_CHECK(snap.meter[RIG_STATUS_METER_SWR].time_ms > 0);
+
+    rig_status_page_close(page);
+
+    /* rig_close removes the page */
+    rig_close(rig);
+    TEST_CHECK(rig_status_page_open(name) == NULL);
+    rig_cleanup(rig);
+}
+
+
+void test_open_missing_page(void)
+{
+    char name[64];
+
+    page_name(name, sizeof(name), "missing");
+    TEST_CHECK(rig_status_page_open(name) == NULL);
+    TEST_CHECK(rig_status_page_open("") == NULL);
+    TEST_CHECK(rig_status_page_open(NULL) == NULL);
+}
+
+
+/* A page left by a writer that died mid-update (odd seq) is taken over
+ * cleanly: the new writer's header ends up readable. */
+void test_takeover_dead_writer(void)
+{
+    struct rig_status_page *stale;
+    struct rig_status_page snap;
+    const struct rig_status_page *page;
+    char name[64];
+    RIG *rig;
+    int fd;
+
+    page_name(name, sizeof(name), "stale");
+    fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT(ftruncate(fd, sizeof(*stale)) == 0);
+    stale = mmap(NULL, sizeof(*stale), PROT_READ | PROT_WRITE, MAP_SHARED,
+                 fd, 0);
+    close(fd);
+    TEST_ASSERT(stale != MAP_FAILED);
+    memset(stale, 0xa5, sizeof(*stale));
+    stale->seq = 5;
+    munmap(stale, sizeof(*stale));
+
+    rig = rig_init(RIG_MODEL_DUMMY);
+    TEST_ASSERT(rig != NULL);
+    TEST_ASSERT(rig_set_conf(rig, rig_token_lookup(rig, "status_shm"), name)
+                == RIG_OK);
+    TEST_ASSERT(rig_open(rig) == RIG_OK);
+
+    page = rig_status_page_open(name);
+    TEST_ASSERT(page != NULL);
+    TEST_CHECK(rig_status_page_read(page, &snap) == RIG_OK);
+    TEST_CHECK((snap.seq & 1) == 0);
+    TEST_CHECK(snap.magic == RIG_STATUS_PAGE_MAGIC);
+    TEST_CHECK(snap.rig_model == RIG_MODEL_DUMMY);
+    rig_status_page_close(page);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+}
+
+
+struct torture_arg
+{
+    RIG *rig;
+    volatile int stop;
+};
+
+
+/* Writer: VFO A and B always carry the same value within one publish */
+static void *torture_writer(void *p)
+{
+    struct torture_arg *arg = p;
+    struct rig_cache *cachep = CACHE(arg->rig);
+    double f = 1000000;
+
+    while (!arg->stop)
+    {
+        f += 1;
+        cachep->freqMainA = f;
+        cachep->freqMainB = f;
+        cachep->modeMainA = (rmode_t)f;
+        cachep->modeMainB = (rmode_t)f;
+        status_page_publish(arg->rig);
+    }
+
+    return NULL;
+}
+
+
+void test_seqlock_never_torn(void)
+{
+    struct torture_arg arg = { 0 };
+    const struct rig_status_page *page;
+    struct rig_status_page snap;
+    pthread_t writer;
+    char name[64];
+    int torn = 0, reads = 0;
+
+    page_name(name, sizeof(name), "torture");
+    arg.rig = rig_init(RIG_MODEL_DUMMY);
+    TEST_ASSERT(arg.rig != NULL);
+    TEST_ASSERT(status_page_start(arg.rig, name) == RIG_OK);
+
+    page = rig_status_page_open(name);
+    TEST_ASSERT(page != NULL);
+    TEST_ASSERT(pthread_create(&writer, NULL, torture_writer, &arg) == 0);
+
+    for (int i = 0; i < 200000; i++)
+    {
+        const struct rig_status_vfo *v = snap.vfo_state;
+
+        if (rig_status_page_read(page, &snap) != RIG_OK)
+        {
+            continue;
+        }
+
+        reads++;
+
+        if (v[RIG_STATUS_VFO_MAIN_A].freq != v[RIG_STATUS_VFO_MAIN_B].freq
+                || v[RIG_STATUS_VFO_MAIN_A].mode != v[RIG_STATUS_VFO_MAIN_B].mode
+                || (rmode_t)v[RIG_STATUS_VFO_MAIN_A].freq
+                != v[RIG_STATUS_VFO_MAIN_A].mode)
+        {
+            torn++;
+        }
+    }
+
+    arg.stop = 1;
+    pthread_join(writer, NULL);
+
+    TEST_CHECK(reads > 0);
+    TEST_CHECK(torn == 0);
+    TEST_MSG("%d torn snapshots in %d reads", torn, reads);
+
+    rig_status_page_close(page);
+    status_page_stop(arg.rig);
+    rig_cleanup(arg.rig);
+}
+
+
+TEST_LIST =
+{
+    { "page_follows_rig",     test_page_follows_rig },
+    { "open_missing_page",    test_open_missing_page },
+    { "seqlock_never_torn",   test_seqlock_never_torn },
+    { "takeover_dead_writer", test_takeover_dead_writer },
+    { NULL, NULL }
+};
+
+#else
+
+void test_requires_shm(void)
+{
+    TEST_MSG("no POSIX shared memory on this host; skipped");
+    TEST_CHECK(rig_status_page_open("hamlib-test") == NULL);
+}
+
+TEST_LIST =
+{
+    { "requires_shm", test_requires_shm },
+    { NULL, NULL }
+};
+
+#endif
@@ -315,6 +315,47 @@ static struct rig_caps stub_caps_codec_stream =
     .stream_close = stub_stream_close,
 };
 
+/* Plain PCM both ways, with a 3-channel (6-byte frame) RX option whose
+ * frames do not divide a power-of-two ring. */
+static const struct rig_stream_caps stub_pcm_tx_stream_caps[] =
+{
+    {
+        .type = RIG_STREAM_TYPE_AUDIO_RX,
+        .formats = RIG_STREAM_FORMAT_PCM_S16,
+        .sample_rates = { 48000, 0 },
+        .channels = { 1, 3, 0 },
+        .max_streams = 1,
+    },
+    {
+        .type = RIG_STREAM_TYPE_AUDIO_TX,
+        .formats = RIG_STREAM_FORMAT_PCM_S16,
+        .sample_rates = { 48000, 0 },
+        .channels = { 1, 0 },
+        .max_streams = 1,
+    },
+    { 0 }  /* Terminator */
+};
+
+static struct rig_caps stub_caps_pcm_tx_stream =
+{
+    .rig_model = 7,
+    .model_name = "Stub PCM TX Stream",
+    .mfg_name = "Test",
+    .version = "1.0",
+    .status = RIG_STATUS_STABLE,
+    .rig_type = RIG_TYPE_TRANSCEIVER,
+    .port_type = RIG_PORT_NONE,
+    .timeout = 1000,
+    .retry = 0,
+    .stream_caps = stub_pcm_tx_stream_caps,
+    .rig_init = stub_rig_init,
+    .rig_cleanup = stub_rig_cleanup,
+    .rig_open = stub_rig_open,
+    .rig_close = stub_rig_close,
+    .stream_open = stub_stream_open,
+    .stream_close = stub_stream_close,
+};
+
 
 /* Helper: set up a RIG with the given caps, call rig_open-equivalent init. */
 static RIG *setup_rig(struct rig_caps *caps)
@@ -460,7 +501,6 @@ void test_caps_derived_rates(void)
     TEST_CHECK(rate_in_list(audio->sample_rates, 48000));
     TEST_CHECK(rate_in_list(iq->sample_rates, 192000));
 
-#ifdef HAVE_SAMPLERATE
     /* Curated standards bounded by the largest native rate. */
     TEST_CHECK(rate_in_list(audio->sample_rates, 44100));
     TEST_CHECK(rate_in_list(audio->sample_rates, 24000));
@@ -484,16 +524,6 @@ void test_caps_derived_rates(void)
         TEST_CHECK(audio->sample_rates[i] > audio->sample_rates[i - 1]);
     }
 
-#else
-    /* Without the resampler the effective rates equal the native rates. */
-    TEST_CHECK(audio->sample_rates[0] == 8000);
-    TEST_CHECK(audio->sample_rates[1] == 48000);
-    TEST_CHECK(audio->sample_rates[2] == 0);
-    TEST_CHECK(iq->sample_rates[0] == 48000);
-    TEST_CHECK(iq->sample_rates[1] == 192000);
-    TEST_CHECK(iq->sample_rates[2] == 0);
-#endif
-
     teardown_rig(rig);
 }
 
@@ -1038,7 +1068,13 @@ void test_open_close(void)
     int ret = rig_stream_open(rig, config, &stream);
     TEST_CHECK(ret == RIG_OK);
     TEST_MSG("rig_stream_open returned %d", ret);
-    TEST_CHECK(stream != NULL);
+    TEST_ASSERT(stream != NULL);
+
+    /* The handle is placed so its ring's indices sit on cache lines */
+    TEST_CHECK((uintptr_t)&stream->ringbuf.write_total
+               % STREAM_RINGBUF_CACHE_LINE == 0);
+    TEST_CHECK((uintptr_t)&stream->ringbuf.read_total
+               % STREAM_RINGBUF_CACHE_LINE == 0);
 
     ret = rig_stream_close(rig, stream);
     TEST_CHECK(ret == RIG_OK);
@@ -1222,6 +1258,449 @@ void test_read_write_ringbuf(void)
     teardown_rig(rig);
 }
 
+static rig_stream_t *open_pcm_stream(RIG *rig, rig_stream_type_t type,
+                                     int channels, size_t buffer_bytes)
+{
+    struct rig_stream_config *config = rig_stream_config_alloc();
+    rig_stream_t *stream = NULL;
+
+    TEST_ASSERT(config != NULL);
+    config->type = type;
+    config->format = RIG_STREAM_FORMAT_PCM_S16;
+    config->sample_rate = 48000;
+    config->channels = channels;
+    config->buffer_bytes = buffer_bytes;
+    TEST_CHECK(rig_stream_open(rig, config, &stream) == RIG_OK);
+    rig_stream_config_free(config);
+
+    return stream;
+}
+
+
+/* Zero-copy reads hand out the ring's own bytes, with the same positions
+ * as rig_stream_read(); what is not released is read again. */
+void test_read_acquire_release(void)
+{
+    RIG *rig = setup_rig(&stub_caps_pcm_tx_stream);
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_pcm_stream(rig, RIG_STREAM_TYPE_AUDIO_RX, 1,
+                                           64);
+    TEST_ASSERT(stream != NULL);
+
+    struct rig_stream_read_info info;
+    int16_t samples[4] = { 100, -200, 32767, -32768 };
+    const void *data;
+    size_t bytes;
+
+    TEST_CHECK(rig_stream_read_release(rig, stream, 0) == -RIG_EINVAL);
+    TEST_CHECK(rig_stream_read_acquire(rig, stream, &data, 1, &bytes, 0,
+                                       NULL) == -RIG_EINVAL);
+
+    stream_ringbuf_write(&stream->ringbuf, samples, sizeof(samples));
+
+    TEST_CHECK(rig_stream_read_acquire(rig, stream, &data, 1000, &bytes, 100,
+                                       &info) == RIG_OK);
+    TEST_CHECK(bytes == sizeof(samples));
+    TEST_CHECK(data == stream->ringbuf.buffer);
+    TEST_CHECK(memcmp(data, samples, sizeof(samples)) == 0);
+    TEST_CHECK(info.sample_index == 0);
+
+    /* One region at a time */
+    TEST_CHECK(rig_stream_read_acquire(rig, stream, &data, 1000, &bytes, 0,
+                                       NULL) == -RIG_EINVAL);
+    TEST_CHECK(rig_stream_read_release(rig, stream, 9) == -RIG_EINVAL);
+
+    TEST_CHECK(rig_stream_read_release(rig, stream, 4) == RIG_OK);
+    TEST_CHECK(rig_stream_read_acquire(rig, stream, &data, 1000, &bytes, 100,
+                                       &info) == RIG_OK);
+    TEST_CHECK(bytes == 4);
+    TEST_CHECK(memcmp(data, samples + 2, 4) == 0);
+    TEST_CHECK(info.sample_index == 2);
+    TEST_CHECK(info.dropped_samples == 0);
+    TEST_CHECK(rig_stream_read_release(rig, stream, 4) == RIG_OK);
+
+    TEST_CHECK(rig_stream_read_acquire(rig, stream, &data, 1000, &bytes, 10,
+                                       NULL) == -RIG_ETIMEOUT);
+    TEST_CHECK(bytes == 0);
+
+    rig_stream_close(rig, stream);
+    teardown_rig(rig);
+}
+
+
+/* A region the producer laps while it is out is reported on release, and
+ * the bytes it lost show up as an overrun like on any read. */
+void test_read_acquire_overwritten(void)
+{
+    RIG *rig = setup_rig(&stub_caps_pcm_tx_stream);
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_pcm_stream(rig, RIG_STREAM_TYPE_AUDIO_RX, 1,
+                                           64);
+    TEST_ASSERT(stream != NULL);
+
+    struct rig_stream_read_info info;
+    struct rig_stream_stats stats;
+    uint8_t block[64], out[64];
+    const void *data;
+    size_t bytes;
+
+    memset(block, 0x11, sizeof(block));
+    stream_ringbuf_write(&stream->ringbuf, block, sizeof(block));
+    TEST_CHECK(rig_stream_read_acquire(rig, stream, &data, 32, &bytes, 100,
+                                       NULL) == RIG_OK);
+    TEST_CHECK(bytes == 32);
+
+    stream_ringbuf_write(&stream->ringbuf, block, 40);
+    TEST_CHECK(rig_stream_read_release(rig, stream, 32) == -RIG_EIO);
+
+    TEST_CHECK(rig_stream_read(rig, stream, out, sizeof(out), &bytes, 100,
+                               &info) == RIG_OK);
+    TEST_CHECK(bytes == 64);
+    TEST_CHECK(info.sample_index == 20);
+    TEST_CHECK(info.dropped_samples == 4);
+    TEST_CHECK(info.drop_flags & RIG_STREAM_DROP_OVERRUN);
+
+    TEST_CHECK(rig_stream_get_stats(rig, stream, &stats) == RIG_OK);
+    TEST_CHECK(stats.overruns == 1);
+
+    rig_stream_close(rig, stream);
+    teardown_rig(rig);
+}
+
+
+/* On a heap ring a frame can straddle the end of the buffer; it comes out
+ * whole through a copy, and the next one in place again. */
+void test_read_acquire_straddling_frame(void)
+{
+    RIG *rig = setup_rig(&stub_caps_pcm_tx_stream);
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_pcm_stream(rig, RIG_STREAM_TYPE_AUDIO_RX, 3,
+                                           64);
+    TEST_ASSERT(stream != NULL);
+    TEST_ASSERT(stream->frame_bytes == 6 && !stream->ringbuf.mirrored);
+
+    struct rig_stream_read_info info;
+    uint8_t fill[60], frames[12];
+    const void *data;
+    size_t bytes;
+
+    memset(fill, 0, sizeof(fill));
+    stream_ringbuf_write(&stream->ringbuf, fill, sizeof(fill));
+    TEST_CHECK(rig_stream_read(rig, stream, fill, sizeof(fill), &bytes, 100,
+                               NULL) == RIG_OK);
+
+    for (int i = 0; i < (int)sizeof(frames); i++)
+    {
+        frames[i] = (uint8_t)(i + 1);
+    }
+
+    stream_ringbuf_write(&stream->ringbuf, frames, sizeof(frames));
+
+    TEST_CHECK(rig_stream_read_acquire(rig, stream, &data, 1000, &bytes, 100,
+                                       &info) == RIG_OK);
+    TEST_CHECK(bytes == 6);
+    TEST_CHECK(memcmp(data, frames, 6) == 0);
+    TEST_CHECK(info.sample_index == 10);
+    TEST_CHECK(rig_stream_read_release(rig, stream, 6) == RIG_OK);
+
+    TEST_CHECK(rig_stream_read_acquire(rig, stream, &data, 1000, &bytes, 100,
+                                       &info) == RIG_OK);
+    TEST_CHECK(bytes == 6);
+    TEST_CHECK(data == stream->ringbuf.buffer + 2);
+    TEST_CHECK(memcmp(data, frames + 6, 6) == 0);
+    TEST_CHECK(info.sample_index == 11);
+    TEST_CHECK(rig_stream_read_release(rig, stream, 6) == RIG_OK);
+
+    rig_stream_close(rig, stream);
+    teardown_rig(rig);
+}
+
+
+/* Zero-copy writes fill free ring space in place and never overwrite what
+ * the backend has yet to take. */
+void test_write_acquire_commit(void)
+{
+    RIG *rig = setup_rig(&stub_caps_pcm_tx_stream);
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_pcm_stream(rig, RIG_STREAM_TYPE_AUDIO_TX, 1,
+                                           64);
+    TEST_ASSERT(stream != NULL);
+
+    struct rig_stream_write_info winfo;
+    struct rig_stream_tx_target target;
+    uint8_t out[64];
+    void *data;
+    size_t bytes;
+
+    TEST_CHECK(rig_stream_write_commit(rig, stream, 0, NULL) == -RIG_EINVAL);
+
+    TEST_CHECK(rig_stream_write_acquire(rig, stream, &data, 1000, &bytes,
+                                        0) == RIG_OK);
+    TEST_CHECK(bytes == 64);
+    TEST_CHECK(data == stream->ringbuf.buffer);
+    memset(data, 0x22, 16);
+
+    memset(&winfo, 0, sizeof(winfo));
+    winfo.flags = RIG_STREAM_TIME_FLAG_SOB;
+    TEST_CHECK(rig_stream_write_commit(rig, stream, 65, NULL) == -RIG_EINVAL);
+    TEST_CHECK(rig_stream_write_commit(rig, stream, 16, &winfo) == RIG_OK);
+    TEST_CHECK(rig_stream_get_samples_written(stream) == 8);
+    TEST_CHECK(rig_stream_pop_tx_target(stream, 0, &target) == 1);
+    TEST_CHECK(target.flags & RIG_STREAM_TIME_FLAG_SOB);
+
+    TEST_CHECK(stream_ringbuf_read(&stream->ringbuf, out, sizeof(out), 0)
+               == 16);
+    TEST_CHECK(out[0] == 0x22 && out[15] == 0x22);
+
+    /* Up to the end of the buffer, then the space freed at its start */
+    TEST_CHECK(rig_stream_write_acquire(rig, stream, &data, 1000, &bytes,
+                                        0) == RIG_OK);
+    TEST_CHECK(bytes == 48);
+    TEST_CHECK(rig_stream_write_commit(rig, stream, 48, NULL) == RIG_OK);
+    TEST_CHECK(rig_stream_write_acquire(rig, stream, &data, 1000, &bytes,
+                                        0) == RIG_OK);
+    TEST_CHECK(bytes == 16);
+    TEST_CHECK(data == stream->ringbuf.buffer);
+    TEST_CHECK(rig_stream_write_commit(rig, stream, 16, NULL) == RIG_OK);
+
+    /* Full: waits, then gives up instead of overwriting */
+    TEST_CHECK(rig_stream_write_acquire(rig, stream, &data, 1000, &bytes,
+                                        10) == -RIG_ETIMEOUT);
+    TEST_CHECK(stream->ringbuf.overrun_count == 0);
+    TEST_CHECK(stream_ringbuf_available(&stream->ringbuf) == 64);
+
+    rig_stream_close(rig, stream);
+    teardown_rig(rig);
+}
+
+
+/* One write, read by the stream's consumer and by every reader at its own
+ * position, in its own format. */
+void test_reader_broadcast(void)
+{
+    RIG *rig = setup_rig(&stub_caps_pcm_tx_stream);
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_pcm_stream(rig, RIG_STREAM_TYPE_AUDIO_RX, 1,
+                                           64);
+    TEST_ASSERT(stream != NULL);
+
+    struct rig_stream_config *config = rig_stream_config_alloc();
+    struct rig_stream_read_info info;
+    rig_stream_reader_t *same, *converted, *late;
+    int16_t samples[4] = { 16384, -16384, 8192, 0 };
+    int16_t pcm[8];
+    float f32[8];
+    size_t bytes;
+
+    TEST_ASSERT(config != NULL);
+    TEST_CHECK(rig_stream_reader_open(rig, stream, NULL, &same) == RIG_OK);
+    config->format = RIG_STREAM_FORMAT_PCM_F32;
+    config->channels = 2;
+    TEST_CHECK(rig_stream_reader_open(rig, stream, config,
+                                      &converted) == RIG_OK);
+
+    stream_backend_write(stream, samples, sizeof(samples));
+
+    TEST_CHECK(rig_stream_read(rig, stream, pcm, sizeof(pcm), &bytes, 100,
+                               NULL) == RIG_OK);
+    TEST_CHECK(bytes == sizeof(samples));
+
+    TEST_CHECK(rig_stream_reader_read(rig, same, pcm, sizeof(pcm), &bytes, 100,
+                                      &info) == RIG_OK);
+    TEST_CHECK(bytes == sizeof(samples));
+    TEST_CHECK(memcmp(pcm, samples, sizeof(samples)) == 0);
+    TEST_CHECK(info.sample_index == 0);
+
+    /* Mono to stereo float, two frames a read */
+    TEST_CHECK(rig_stream_reader_read(rig, converted, f32, 4 * sizeof(float),
+                                      &bytes, 100, &info) == RIG_OK);
+    TEST_CHECK(bytes == 4 * sizeof(float));
+    TEST_CHECK(f32[0] == 0.5f && f32[1] == 0.5f);
+    TEST_CHECK(f32[2] == -0.5f && f32[3] == -0.5f);
+    TEST_CHECK(rig_stream_reader_read(rig, converted, f32, sizeof(f32),
+                                      &bytes, 100, &info) == RIG_OK);
+    TEST_CHECK(bytes == 4 * sizeof(float));
+    TEST_CHECK(f32[0] == 0.25f && f32[2] == 0.0f);
+    TEST_CHECK(info.sample_index == 2);
+
+    /* A reader starts at the newest sample; a gap reaches everyone */
+    TEST_CHECK(rig_stream_reader_open(rig, stream, NULL, &late) == RIG_OK);
+    TEST_CHECK(rig_stream_reader_read(rig, late, pcm, sizeof(pcm), &bytes, 10,
+                                      NULL) == -RIG_ETIMEOUT);
+    stream_skip_samples(stream, 5, RIG_STREAM_DROP_GAP);
+    stream_backend_write(stream, samples, sizeof(samples));
+
+    TEST_CHECK(rig_stream_reader_read(rig, late, pcm, sizeof(pcm), &bytes, 100,
+                                      &info) == RIG_OK);
+    TEST_CHECK(info.sample_index == 9);
+    TEST_CHECK(info.dropped_samples == 5);
+    TEST_CHECK(info.drop_flags == RIG_STREAM_DROP_GAP);
+    TEST_CHECK(rig_stream_reader_read(rig, same, pcm, sizeof(pcm), &bytes, 100,
+                                      &info) == RIG_OK);
+    TEST_CHECK(info.sample_index == 9);
+    TEST_CHECK(info.dropped_samples == 5);
+
+    /* Less than a frame, another rate, a TX stream */
+    TEST_CHECK(rig_stream_reader_read(rig, same, pcm, 1, &bytes, 0,
+                                      NULL) == -RIG_EINVAL);
+    config->sample_rate = 8000;
+    TEST_CHECK(rig_stream_reader_open(rig, stream, config,
+                                      &late) == -RIG_EINVAL);
+    rig_stream_t *tx = open_pcm_stream(rig, RIG_STREAM_TYPE_AUDIO_TX, 1, 64);
+    TEST_ASSERT(tx != NULL);
+    TEST_CHECK(rig_stream_reader_open(rig, tx, NULL, &late) == -RIG_EINVAL);
+    rig_stream_close(rig, tx);
+
+    TEST_CHECK(rig_stream_reader_close(rig, same) == RIG_OK);
+    rig_stream_config_free(config);
+
+    /* The readers left go with the stream */
+    rig_stream_close(rig, stream);
+    teardown_rig(rig);
+}
+
+
+/* A muted consumer's zero-copy read gets silence without wiping the ring:
+ * a reader behind it still gets the samples. */
+void test_reader_after_muted_acquire(void)
+{
+    RIG *rig = setup_rig(&stub_caps_pcm_tx_stream);
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_pcm_stream(rig, RIG_STREAM_TYPE_AUDIO_RX, 1,
+                                           64);
+    TEST_ASSERT(stream != NULL);
+
+    rig_stream_reader_t *reader;
+    int16_t samples[4] = { 16384, -16384, 8192, 1 };
+    int16_t pcm[8];
+    const void *data;
+    size_t bytes;
+
+    TEST_CHECK(rig_stream_reader_open(rig, stream, NULL, &reader) == RIG_OK);
+    stream_backend_write(stream, samples, sizeof(samples));
+
+    TEST_CHECK(rig_stream_mute(rig, stream) == RIG_OK);
+    TEST_CHECK(rig_stream_read_acquire(rig, stream, &data, sizeof(pcm),
+                                       &bytes, 100, NULL) == RIG_OK);
+    TEST_ASSERT(bytes == sizeof(samples));
+    TEST_CHECK(memcmp(data, (int16_t[4]) { 0 }, sizeof(samples)) == 0);
+    TEST_CHECK(rig_stream_read_release(rig, stream, bytes) == RIG_OK);
+    TEST_CHECK(rig_stream_unmute(rig, stream) == RIG_OK);
+
+    TEST_CHECK(rig_stream_reader_read(rig, reader, pcm, sizeof(pcm), &bytes,
+                                      100, NULL) == RIG_OK);
+    TEST_CHECK(bytes == sizeof(samples));
+    TEST_CHECK(memcmp(pcm, samples, sizeof(samples)) == 0);
+
+    rig_stream_close(rig, stream);
+    teardown_rig(rig);
+}
+
+
+/* A reader that does not keep up is lapped on its own: the stream's
+ * consumer and the other readers lose nothing. */
+void test_reader_lapped(void)
+{
+    RIG *rig = setup_rig(&stub_caps_pcm_tx_stream);
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_pcm_stream(rig, RIG_STREAM_TYPE_AUDIO_RX, 1,
+                                           64);
+    TEST_ASSERT(stream != NULL);
+
+    struct rig_stream_reader_stats rstats;
+    struct rig_stream_read_info info;
+    struct rig_stream_stats stats;
+    rig_stream_reader_t *slow, *fast;
+    int16_t samples[8], pcm[32];
+    size_t bytes;
+    int i;
+
+    TEST_CHECK(rig_stream_reader_open(rig, stream, NULL, &slow) == RIG_OK);
+    TEST_CHECK(rig_stream_reader_open(rig, stream, NULL, &fast) == RIG_OK);
+
+    /* 40 samples through a 32-sample ring */
+    for (i = 0; i < 5; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            samples[j] = (int16_t)(i * 8 + j);
+        }
+
+        stream_backend_write(stream, samples, sizeof(samples));
+        TEST_CHECK(rig_stream_read(rig, stream, pcm, sizeof(pcm), &bytes, 100,
+                                   NULL) == RIG_OK);
+        TEST_CHECK(rig_stream_reader_read(rig, fast, pcm, sizeof(pcm), &bytes,
+                                          100, NULL) == RIG_OK);
+        TEST_CHECK(bytes == sizeof(samples) && pcm[0] == i * 8);
+    }
+
+    TEST_CHECK(rig_stream_reader_get_stats(rig, slow, &rstats) == RIG_OK);
+    TEST_CHECK(rstats.lag_samples == 32);
+    TEST_CHECK(rstats.overruns == 0);
+
+    TEST_CHECK(rig_stream_reader_read(rig, slow, pcm, sizeof(pcm), &bytes, 100,
+                                      &info) == RIG_OK);
+    TEST_CHECK(bytes == 64);
+    TEST_CHECK(pcm[0] == 8);
+    TEST_CHECK(info.sample_index == 8);
+    TEST_CHECK(info.dropped_samples == 8);
+    TEST_CHECK(info.drop_flags == RIG_STREAM_DROP_OVERRUN);
+
+    TEST_CHECK(rig_stream_reader_get_stats(rig, slow, &rstats) == RIG_OK);
+    TEST_CHECK(rstats.overruns == 1);
+    TEST_CHECK(rstats.slow_events == 1);
+    TEST_CHECK(rstats.slow == 0);
+    TEST_CHECK(rstats.lag_samples == 0);
+    TEST_CHECK(rstats.dropped_samples_overrun == 8);
+
+    TEST_CHECK(rig_stream_reader_get_stats(rig, fast, &rstats) == RIG_OK);
+    TEST_CHECK(rstats.overruns == 0 && rstats.slow_events == 0);
+    TEST_CHECK(rig_stream_get_stats(rig, stream, &stats) == RIG_OK);
+    TEST_CHECK(stats.dropped_samples_overrun == 0);
+
+    rig_stream_close(rig, stream);
+    teardown_rig(rig);
+}
+
+
+struct reader_close_ctx { RIG *rig; rig_stream_reader_t *reader; int ret; };
+
+static void *blocked_stream_reader(void *arg)
+{
+    struct reader_close_ctx *c = arg;
+    int16_t pcm[8];
+    size_t got;
+
+    c->ret = rig_stream_reader_read(c->rig, c->reader, pcm, sizeof(pcm), &got,
+                                    -1, NULL);
+    return NULL;
+}
+
+/* Closing the stream wakes its readers before freeing them */
+void test_reader_close_wakes_reader(void)
+{
+    RIG *rig = setup_rig(&stub_caps_pcm_tx_stream);
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_pcm_stream(rig, RIG_STREAM_TYPE_AUDIO_RX, 1,
+                                           64);
+    TEST_ASSERT(stream != NULL);
+
+    struct reader_close_ctx ctx = { rig, NULL, 999 };
+    pthread_t th;
+
+    TEST_ASSERT(rig_stream_reader_open(rig, stream, NULL,
+                                       &ctx.reader) == RIG_OK);
+    TEST_ASSERT(pthread_create(&th, NULL, blocked_stream_reader, &ctx) == 0);
+
+    usleep(150 * 1000);
+    TEST_CHECK(rig_stream_close(rig, stream) == RIG_OK);
+    pthread_join(th, NULL);
+    TEST_CHECK(ctx.ret == -RIG_ENAVAIL);
+
+    teardown_rig(rig);
+}
+
+
 void test_overrun_underrun_counters(void)
 {
     RIG *rig = setup_rig(&stub_caps_with_stream);
@@ -2312,20 +2791,13 @@ void test_session_caps_narrow_only_the_served_view(void)
     TEST_CHECK(served->native_channels[1] == 0);
 
     /* Effective widens over the session truth exactly as it would over a
-     * model declaration -- mono audio upmixes to stereo, and with the
-     * resampler built in the rate list grows around the session's native
-     * rate (bounded by it). The model's 8000 stays reachable only as a
-     * conversion of the session's 48000, never as native; without the
-     * resampler the effective rates are the session rates alone. */
+     * model declaration -- mono audio upmixes to stereo, and the rate list
+     * grows around the session's native rate (bounded by it). The model's
+     * 8000 stays reachable only as a conversion of the session's 48000,
+     * never as native. */
     TEST_CHECK(served->channels[0] == 1 && served->channels[1] == 2);
     TEST_CHECK(rate_in_list(served->sample_rates, 48000));
-#ifdef HAVE_SAMPLERATE
     TEST_CHECK(rate_in_list(served->sample_rates, 8000));
-#else
-    TEST_CHECK(served->sample_rates[0] == 48000);
-    TEST_CHECK(served->sample_rates[1] == 0);
-    TEST_MSG("served rate[1]=%d, expected none", served->sample_rates[1]);
-#endif
 
     /* Session caps gate the OPEN path too, not just discovery: the
      * session's own geometry opens, and the model-declared I/Q type the
@@ -2408,6 +2880,14 @@ TEST_LIST =
     { "read_write_ringbuf",       test_read_write_ringbuf },
     { "write_via_api",            test_write_via_api },
     { "overrun_underrun_counters", test_overrun_underrun_counters },
+    { "read_acquire_release",     test_read_acquire_release },
+    { "read_acquire_overwritten", test_read_acquire_overwritten },
+    { "read_acquire_straddling_frame", test_read_acquire_straddling_frame },
+    { "write_acquire_commit",     test_write_acquire_commit },
+    { "reader_broadcast",         test_reader_broadcast },
+    { "reader_after_muted_acquire", test_reader_after_muted_acquire },
+    { "reader_lapped",            test_reader_lapped },
+    { "reader_close_wakes_reader", test_reader_close_wakes_reader },
     { "gap_counter",              test_gap_counter },
     { "get_type_id",              test_get_type_id },
     { "per_type_namespace",       test_per_type_namespace },
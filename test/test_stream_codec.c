@@ -20,7 +20,9 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 /* Device audio codec unit tests for the Hamlib streaming subsystem. */
-/* Covers state lifecycle, mu-law/A-law decode+encode, sizing, reset, stereo. */
+/* Covers state lifecycle, mu-law/A-law decode+encode, sizing, reset, stereo,
+ * bit-exactness of the table, vector and branch-free kernels against the
+ * plain per-sample codecs, and the Opus stage of the conversion pipeline. */
 
 #ifdef HAVE_CONFIG_H
 #include "hamlib/config.h"
@@ -30,6 +32,9 @@
 #include "test_debug.h"
 #include "stream_codec.h"
 #include "stream_convert.h"
+#include "stream_convert_simd.h"
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 
@@ -518,6 +523,454 @@ void test_stereo_mulaw_interleave(void)
 }
 
 
+/* --- Bit-exactness against the per-sample reference codecs --- */
+
+/* The straightforward G.711 and IMA ADPCM code the kernels replaced: a
+ * segment search per sample and a branch per code bit. */
+
+static int ref_g711_segment(int value, const int *seg_end)
+{
+    int i;
+
+    for (i = 0; i < 8 && value > seg_end[i]; i++)
+    {
+    }
+
+    return i;
+}
+
+static int16_t ref_mulaw_decode(uint8_t code)
+{
+    code = (uint8_t)~code;
+
+    int t = ((code & 0x0F) << 3) + 0x84;
+    t <<= (code & 0x70) >> 4;
+
+    return (int16_t)((code & 0x80) ? (0x84 - t) : (t - 0x84));
+}
+
+static uint8_t ref_mulaw_encode(int16_t pcm)
+{
+    static const int seg_end[8] =
+    {
+        0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF, 0x3FFF, 0x7FFF
+    };
+    int value = pcm < 0 ? 0x84 - pcm : pcm + 0x84;
+    int mask = pcm < 0 ? 0x7F : 0xFF;
+
+    if (value > 32635)
+    {
+        value = 32635;
+    }
+
+    int seg = ref_g711_segment(value, seg_end);
+
+    return (uint8_t)(((seg << 4) | ((value >> (seg + 3)) & 0x0F)) ^ mask);
+}
+
+static int16_t ref_alaw_decode(uint8_t code)
+{
+    code ^= 0x55;
+
+    int t = (code & 0x0F) << 4;
+    int seg = (code & 0x70) >> 4;
+
+    t += seg == 0 ? 8 : 0x108;
+
+    if (seg > 1)
+    {
+        t <<= seg - 1;
+    }
+
+    return (int16_t)((code & 0x80) ? t : -t);
+}
+
+static uint8_t ref_alaw_encode(int16_t pcm)
+{
+    static const int seg_end[8] =
+    {
+        0x1F, 0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF
+    };
+    int value = pcm >> 3;
+    int mask = value >= 0 ? 0xD5 : 0x55;
+
+    if (value < 0)
+    {
+        value = -value - 1;
+    }
+
+    int seg = ref_g711_segment(value, seg_end);
+    int aval = seg << 4;
+
+    aval |= (value >> (seg < 2 ? 1 : seg)) & 0x0F;
+
+    return (uint8_t)(aval ^ mask);
+}
+
+static const int ref_ima_index[16] =
+{
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int ref_ima_step[89] =
+{
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190,
+    209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724,
+    796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272,
+    2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132,
+    7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500,
+    20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static int ref_clamp(int v, int lo, int hi)
+{
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+static int16_t ref_ima_decode(int *pred, int *index, int nibble)
+{
+    int step = ref_ima_step[*index];
+    int diff = step >> 3;
+
+    if (nibble & 1) { diff += step >> 2; }
+
+    if (nibble & 2) { diff += step >> 1; }
+
+    if (nibble & 4) { diff += step; }
+
+    if (nibble & 8) { diff = -diff; }
+
+    *pred = ref_clamp(*pred + diff, -32768, 32767);
+    *index = ref_clamp(*index + ref_ima_index[nibble], 0, 88);
+    return (int16_t)*pred;
+}
+
+static int ref_ima_encode(int *pred, int *index, int16_t sample)
+{
+    int step = ref_ima_step[*index];
+    int diff = sample - *pred;
+    int nibble = 0;
+    int vpdiff = step >> 3;
+
+    if (diff < 0) { nibble = 8; diff = -diff; }
+
+    if (diff >= step) { nibble |= 4; diff -= step; vpdiff += step; }
+
+    if (diff >= (step >> 1)) { nibble |= 2; diff -= step >> 1; vpdiff += step >> 1; }
+
+    if (diff >= (step >> 2)) { nibble |= 1; vpdiff += step >> 2; }
+
+    *pred = ref_clamp(*pred + ((nibble & 8) ? -vpdiff : vpdiff), -32768, 32767);
+    *index = ref_clamp(*index + ref_ima_index[nibble], 0, 88);
+    return nibble;
+}
+
+/* Every 16-bit sample and every code, through every kernel set */
+void test_g711_matches_reference(void)
+{
+    static int16_t pcm[65536 + 3], back[65536];
+    static uint8_t coded[65536 + 3];
+    const struct stream_convert_kernels *sets[8];
+    int count = stream_convert_simd_kernels(sets, 8);
+
+    for (int i = 0; i < 65536; i++)
+    {
+        pcm[i + 3] = (int16_t)(i - 32768);
+    }
+
+    for (int s = -1; s < count; s++)
+    {
+        for (int law = 0; law < 2; law++)
+        {
+            rig_audio_codec_t codec = law ? RIG_AUDIO_CODEC_ALAW
+                                      : RIG_AUDIO_CODEC_MULAW;
+            struct rig_audio_codec_state *st = rig_audio_codec_open(codec, 1);
+            size_t out = 0;
+            int bad = -1;
+
+            TEST_ASSERT(stream_convert_use_kernels(s < 0 ? "scalar"
+                                                   : sets[s]->name) == 0);
+
+            // Odd start, so the vector loads are unaligned
+            TEST_CHECK(rig_audio_convert_from_pcm(st, RIG_STREAM_FORMAT_PCM_S16,
+                                                  pcm + 3, 65536 * 2, coded + 3,
+                                                  65536, &out) == RIG_OK);
+
+            for (int i = 0; i < 65536 && bad < 0; i++)
+            {
+                if (coded[i + 3] != (law ? ref_alaw_encode(pcm[i + 3])
+                                     : ref_mulaw_encode(pcm[i + 3])))
+                {
+                    bad = i - 32768;
+                }
+            }
+
+            TEST_CHECK(out == 65536 && bad < 0);
+            TEST_MSG("%s %s: first mismatch at sample %d",
+                     stream_convert_active_kernels()->name, law ? "A-law" : "mu-law",
+                     bad);
+
+            for (int i = 0; i < 256; i++)
+            {
+                coded[i] = (uint8_t)i;
+            }
+
+            TEST_CHECK(rig_audio_convert_to_pcm(st, coded, 256,
+                                                RIG_STREAM_FORMAT_PCM_S16, back,
+                                                sizeof(back), &out) == RIG_OK);
+
+            for (int i = 0; i < 256; i++)
+            {
+                TEST_CHECK(back[i] == (law ? ref_alaw_decode((uint8_t)i)
+                                       : ref_mulaw_decode((uint8_t)i)));
+            }
+
+            rig_audio_codec_close(st);
+        }
+    }
+
+    TEST_CHECK(stream_convert_use_kernels(NULL) == 0);
+}
+
+/* Blocks of a loud, fast-moving signal, including clipping steps and odd
+ * lengths, with the step index carried from block to block */
+void test_adpcm_matches_reference(void)
+{
+    struct rig_audio_codec_state *enc =
+        rig_audio_codec_open(RIG_AUDIO_CODEC_ADPCM_IMA, 1);
+    struct rig_audio_codec_state *dec =
+        rig_audio_codec_open(RIG_AUDIO_CODEC_ADPCM_IMA, 1);
+    int16_t src[1001], out[1001];
+    uint8_t blk[600];
+    int ref_index = 0;
+
+    srand(7);
+
+    for (int b = 0; b < 40; b++)
+    {
+        size_t samples = 100 + (size_t)(b * 97) % 902, len = 0, out_bytes = 0;
+        int pred, index;
+
+        for (size_t i = 0; i < samples; i++)
+        {
+            double t = (double)(b * 1000 + i) / 8000;
+
+            src[i] = (int16_t)ref_clamp((int)(30000 * sin(2 * M_PI * 440 * t)
+                                              * sin(2 * M_PI * 3 * t)
+                                              + (rand() % 20001 - 10000)),
+                                        -32768, 32767);
+
+            if (i % 50 == 0)
+            {
+                src[i] = (i / 50) & 1 ? 32767 : -32768;
+            }
+        }
+
+        TEST_ASSERT(rig_audio_convert_from_pcm(enc, RIG_STREAM_FORMAT_PCM_S16,
+                                               src, samples * 2, blk, sizeof(blk),
+                                               &len) == RIG_OK);
+        TEST_CHECK(len == 4 + samples / 2);
+
+        // The reference encoder gives the same block
+        pred = src[0];
+        index = ref_index;
+        TEST_CHECK(blk[2] == index);
+
+        for (size_t i = 1; i < samples; i++)
+        {
+            int nib = ref_ima_encode(&pred, &index, src[i]);
+            int got = (blk[4 + (i - 1) / 2] >> (((i - 1) & 1) * 4)) & 0x0F;
+
+            if (!TEST_CHECK(got == nib))
+            {
+                TEST_MSG("block %d sample %zu: %d, expected %d", b, i, got, nib);
+                break;
+            }
+        }
+
+        ref_index = index;
+
+        // And the reference decoder the same samples
+        TEST_ASSERT(rig_audio_convert_to_pcm(dec, blk, len,
+                                             RIG_STREAM_FORMAT_PCM_S16, out,
+                                             sizeof(out), &out_bytes) == RIG_OK);
+        pred = (int16_t)(blk[0] | (blk[1] << 8));
+        index = blk[2];
+
+        for (size_t i = 1; i < out_bytes / 2; i++)
+        {
+            int nib = (blk[4 + (i - 1) / 2] >> (((i - 1) & 1) * 4)) & 0x0F;
+
+            if (!TEST_CHECK(out[i] == ref_ima_decode(&pred, &index, nib)))
+            {
+                TEST_MSG("block %d sample %zu", b, i);
+                break;
+            }
+        }
+    }
+
+    rig_audio_codec_close(enc);
+    rig_audio_codec_close(dec);
+}
+
+
+/* --- Opus stream format --- */
+
+void test_opus_rates_and_frames(void)
+{
+    TEST_CHECK(stream_opus_rate_ok(48000, 2));
+    TEST_CHECK(stream_opus_rate_ok(8000, 1));
+    TEST_CHECK(!stream_opus_rate_ok(44100, 1));
+    TEST_CHECK(!stream_opus_rate_ok(48000, 3));
+
+    /* Opus frame lengths pass; anything else becomes 20 ms */
+    TEST_CHECK(stream_opus_frame_samples(48000, 120) == 120);
+    TEST_CHECK(stream_opus_frame_samples(48000, 2880) == 2880);
+    TEST_CHECK(stream_opus_frame_samples(24000, 240) == 240);
+    TEST_CHECK(stream_opus_frame_samples(48000, 0) == 960);
+    TEST_CHECK(stream_opus_frame_samples(48000, 1000) == 960);
+    TEST_CHECK(stream_opus_frame_samples(8000, 5760) == 160);
+}
+
+struct opus_sink
+{
+    unsigned char bytes[65536];
+    size_t used;
+    int calls;
+};
+
+static size_t opus_collect(void *ctx, const void *buf, size_t len)
+{
+    struct opus_sink *k = ctx;
+
+    if (len > sizeof(k->bytes) - k->used)
+    {
+        return 0;
+    }
+
+    memcpy(k->bytes + k->used, buf, len);
+    k->used += len;
+    k->calls++;
+    return len;
+}
+
+/* Packets from the encoding pipeline are kept with their lengths so the
+ * decoding pipeline can be fed one at a time */
+struct opus_packets
+{
+    unsigned char data[65536];
+    size_t len[64];
+    size_t used;
+    int count;
+};
+
+static size_t opus_collect_packet(void *ctx, const void *buf, size_t len)
+{
+    struct opus_packets *p = ctx;
+
+    if (p->count == 64 || len > sizeof(p->data) - p->used)
+    {
+        return 0;
+    }
+
+    memcpy(p->data + p->used, buf, len);
+    p->len[p->count++] = len;
+    p->used += len;
+    return len;
+}
+
+void test_opus_pipeline(void)
+{
+    static float tone[48000];
+    static struct opus_packets pk;
+    static struct opus_sink pcm;
+    struct stream_conv *enc, *dec;
+    size_t off = 0;
+    double sum = 0;
+
+    /* F32 at 48 kHz -> Opus, 20 ms packets */
+    TEST_ASSERT(stream_conv_init(&enc, RIG_STREAM_FORMAT_PCM_F32, 48000, 1,
+                                 RIG_STREAM_FORMAT_PCM_F32, 48000, 1, 0,
+                                 RIG_RESAMPLE_MEDIUM) == 0);
+
+    if (!stream_opus_available())
+    {
+        TEST_CHECK(stream_opus_open(1, 48000, 1, 0) == NULL);
+        TEST_CHECK(stream_conv_use_opus(enc, 1, 960, 0, 1500) == -1);
+        stream_conv_free(enc);
+        return;
+    }
+
+    /* The encoder side must produce float, whole Opus frames */
+    TEST_CHECK(stream_conv_use_opus(enc, 1, 1000, 0, 1500) == -1);
+    TEST_ASSERT(stream_conv_use_opus(enc, 1, 960, 24000, 1500) == 0);
+    TEST_CHECK(stream_conv_opus_frame(enc) == 960);
+
+    for (int i = 0; i < 48000; i++)
+    {
+        tone[i] = (float)(0.5 * sin(2 * M_PI * 1000.0 * i / 48000));
+    }
+
+    /* Fed in pieces that do not line up with the frames */
+    memset(&pk, 0, sizeof(pk));
+
+    while (off < 48000)
+    {
+        size_t n = 48000 - off < 777 ? 48000 - off : 777;
+
+        TEST_CHECK(stream_conv_process(enc, tone + off, n * sizeof(float),
+                                       opus_collect_packet, &pk)
+                   == (ssize_t)(n * sizeof(float)));
+        off += n;
+    }
+
+    /* One second is 50 packets, far smaller than the float PCM */
+    TEST_CHECK(pk.count == 50);
+    TEST_CHECK(pk.used * 10 < sizeof(tone));
+    TEST_MSG("%d packets, %zu bytes", pk.count, pk.used);
+
+    /* Opus -> F32 -> S16 at 8 kHz: one packet per call */
+    TEST_ASSERT(stream_conv_init(&dec, RIG_STREAM_FORMAT_PCM_F32, 48000, 1,
+                                 RIG_STREAM_FORMAT_PCM_S16, 8000, 1, 0,
+                                 RIG_RESAMPLE_MEDIUM) == 0);
+    TEST_ASSERT(stream_conv_use_opus(dec, 0, 0, 0, 0) == 0);
+    TEST_CHECK(stream_conv_opus_frame(dec) == 0);
+    memset(&pcm, 0, sizeof(pcm));
+    off = 0;
+
+    for (int i = 0; i < pk.count; i++)
+    {
+        TEST_CHECK(stream_conv_process(dec, pk.data + off, pk.len[i],
+                                       opus_collect, &pcm)
+                   == (ssize_t)pk.len[i]);
+        off += pk.len[i];
+    }
+
+    /* A corrupt packet is an error, not silence */
+    TEST_CHECK(stream_conv_process(dec, "\xff\xff\xff", 3, opus_collect,
+                                   &pcm) == -1);
+
+    /* The tone comes back at about its level (RMS 0.354 of full scale) */
+    size_t samples = pcm.used / 2;
+    const int16_t *s16 = (const int16_t *)pcm.bytes;
+
+    TEST_CHECK(samples > 7000 && samples <= 8000);
+
+    for (size_t i = samples / 4; i < samples * 3 / 4; i++)
+    {
+        sum += (double)s16[i] * s16[i];
+    }
+
+    double rms = sqrt(sum / (samples / 2)) / 32768.0;
+    TEST_CHECK(fabs(rms - 0.354) < 0.05);
+    TEST_MSG("%zu samples, RMS %.3f", samples, rms);
+
+    stream_conv_free(enc);
+    stream_conv_free(dec);
+}
+
+
 TEST_LIST =
 {
     { "open_close_none",              test_open_close_none },
@@ -538,5 +991,9 @@ TEST_LIST =
     { "sizing_helpers",               test_sizing_helpers },
     { "reset_semantics",              test_reset_semantics },
     { "stereo_mulaw_interleave",      test_stereo_mulaw_interleave },
+    { "g711_matches_reference",       test_g711_matches_reference },
+    { "adpcm_matches_reference",      test_adpcm_matches_reference },
+    { "opus_rates_and_frames",        test_opus_rates_and_frames },
+    { "opus_pipeline",                test_opus_pipeline },
     { NULL, NULL }
 };
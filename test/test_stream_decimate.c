@@ -0,0 +1,477 @@
+/*
+ *  Hamlib streaming I/Q decimator tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* The CIC + half-band decimator: how factors split, exact output counts,
+ * seamless chunked input, a flat passband, alias rejection and the NCO
+ * shift, and its use inside a stream_conv pipeline. */
+
+#ifdef HAVE_CONFIG_H
+#include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include "stream_convert.h"
+#include "stream_decimate.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDE_RATE 1920000
+#define OUT_FRAMES 4800
+
+
+/* A complex tone of amplitude 0.5 at freq Hz on every channel */
+static float *make_tone(size_t frames, int channels, double freq, int rate)
+{
+    float *s = malloc(frames * channels * 2 * sizeof(float));
+
+    for (size_t i = 0; i < frames && s; i++)
+    {
+        double a = 2 * M_PI * freq * i / rate;
+
+        for (int ch = 0; ch < channels; ch++)
+        {
+            s[(i * channels + ch) * 2] = (float)(0.5 * cos(a + ch));
+            s[(i * channels + ch) * 2 + 1] = (float)(0.5 * sin(a + ch));
+        }
+    }
+
+    return s;
+}
+
+
+/* Amplitude of the complex tone at freq Hz in the middle half of a
+ * channel, away from the filters' ramps */
+static double tone_level(const float *s, size_t frames, int channels, int ch,
+                         double freq, int rate)
+{
+    double re = 0, im = 0;
+    size_t i, n = 0;
+
+    for (i = frames / 4; i < frames * 3 / 4; i++, n++)
+    {
+        double a = -2 * M_PI * freq * i / rate;
+        double x = s[(i * channels + ch) * 2];
+        double y = s[(i * channels + ch) * 2 + 1];
+
+        re += x * cos(a) - y * sin(a);
+        im += x * sin(a) + y * cos(a);
+    }
+
+    return sqrt(re * re + im * im) / n;
+}
+
+
+/* RMS magnitude of the middle half of a channel */
+static double mid_rms(const float *s, size_t frames, int channels, int ch)
+{
+    double sum = 0;
+    size_t i;
+
+    for (i = frames / 4; i < frames * 3 / 4; i++)
+    {
+        double x = s[(i * channels + ch) * 2];
+        double y = s[(i * channels + ch) * 2 + 1];
+
+        sum += x * x + y * y;
+    }
+
+    return sqrt(sum / (frames / 2));
+}
+
+
+/* Decimate all of in in one call, returning the frames made */
+static size_t decimate_all(int rate, int factor, int channels, double shift,
+                           int quality, const float *in, size_t frames,
+                           float *out)
+{
+    struct stream_decimator *d;
+    size_t made;
+
+    TEST_ASSERT(stream_decimator_init(&d, rate, factor, channels, shift,
+                                      quality) == 0);
+    TEST_CHECK(stream_decimator_max_output(d, frames)
+               == (frames + factor - 1) / factor);
+    made = stream_decimator_process(d, in, frames, out);
+    stream_decimator_free(d);
+
+    return made;
+}
+
+
+void test_plan(void)
+{
+    static const struct
+    {
+        int factor, quality, cic, halfbands, fir;
+    } plans[] =
+    {
+        { 40, RIG_RESAMPLE_MEDIUM, 5, 2, 2 },   // 1.92 MS/s -> 48 kS/s
+        { 4,  RIG_RESAMPLE_MEDIUM, 1, 1, 2 },   // 192 kS/s -> 48 kS/s
+        { 64, RIG_RESAMPLE_MEDIUM, 8, 2, 2 },
+        { 16, RIG_RESAMPLE_BEST,   2, 2, 2 },
+        { 1024, RIG_RESAMPLE_BEST, 64, 3, 2 },  // order 5 caps the CIC at 84
+        { 40, RIG_RESAMPLE_FAST,   10, 1, 2 },
+        { 12, RIG_RESAMPLE_MEDIUM, 1, 1, 6 },
+        { 10, RIG_RESAMPLE_MEDIUM, 1, 0, 10 },
+        { 1,  RIG_RESAMPLE_MEDIUM, 1, 0, 1 },
+    };
+
+    for (size_t k = 0; k < sizeof(plans) / sizeof(plans[0]); k++)
+    {
+        struct stream_decimator *d;
+        int cic, halfbands, fir;
+
+        TEST_ASSERT(stream_decimator_init(&d, 48000 * plans[k].factor,
+                                          plans[k].factor, 1, 0.0,
+                                          plans[k].quality) == 0);
+        stream_decimator_plan(d, &cic, &halfbands, &fir);
+        TEST_CHECK(cic == plans[k].cic && halfbands == plans[k].halfbands
+                   && fir == plans[k].fir);
+        TEST_MSG("factor %d: cic %d, %d half-bands, fir %d", plans[k].factor,
+                 cic, halfbands, fir);
+        stream_decimator_free(d);
+    }
+}
+
+
+void test_output_count_exact(void)
+{
+    static const int factors[] = { 1, 2, 3, 4, 8, 10, 12, 40, 97, 256 };
+    float *in = make_tone(3000, 2, 1000.0, 96000);
+    float *out = malloc(3000 * 2 * 2 * sizeof(float));
+
+    TEST_ASSERT(in != NULL && out != NULL);
+
+    for (size_t k = 0; k < sizeof(factors) / sizeof(factors[0]); k++)
+    {
+        struct stream_decimator *d;
+        size_t frames = 50000, made = 0, done = 0;
+
+        TEST_ASSERT(stream_decimator_init(&d, 96000 * factors[k], factors[k],
+                                          2, 1000.0, RIG_RESAMPLE_MEDIUM) == 0);
+
+        // The count never drifts however the input is cut up
+        while (done < frames)
+        {
+            size_t n = 1 + (done * 7919) % 2999, expect;
+
+            if (n > frames - done)
+            {
+                n = frames - done;
+            }
+
+            expect = stream_decimator_max_output(d, n);
+            TEST_CHECK(stream_decimator_process(d, in, n, out) == expect);
+            made += expect;
+            done += n;
+        }
+
+        TEST_CHECK(made == (frames + factors[k] - 1) / factors[k]);
+        TEST_MSG("factor %d: %zu frames", factors[k], made);
+        stream_decimator_free(d);
+    }
+
+    free(in);
+    free(out);
+}
+
+
+/* Feeding in pieces gives the same samples as one call */
+void test_chunks_match_one_call(void)
+{
+    static const int factors[] = { 4, 40, 12 };
+    size_t frames = 100000;
+    float *in = make_tone(frames, 1, 3000.0, 192000);
+    float *whole = malloc(frames * 2 * sizeof(float));
+    float *chunked = malloc(frames * 2 * sizeof(float));
+
+    TEST_ASSERT(in != NULL && whole != NULL && chunked != NULL);
+
+    for (size_t k = 0; k < sizeof(factors) / sizeof(factors[0]); k++)
+    {
+        struct stream_decimator *d;
+        size_t n, made = 0, done = 0;
+
+        n = decimate_all(192000, factors[k], 1, -7000.0, RIG_RESAMPLE_BEST, in,
+                         frames, whole);
+
+        TEST_ASSERT(stream_decimator_init(&d, 192000, factors[k], 1, -7000.0,
+                                          RIG_RESAMPLE_BEST) == 0);
+
+        while (done < frames)
+        {
+            size_t step = frames - done < 333 ? frames - done : 333;
+
+            made += stream_decimator_process(d, in + done * 2, step,
+                                             chunked + made * 2);
+            done += step;
+        }
+
+        TEST_CHECK(made == n);
+        TEST_CHECK(memcmp(chunked, whole, n * 2 * sizeof(float)) == 0);
+        TEST_MSG("factor %d: %zu vs %zu frames", factors[k], made, n);
+        stream_decimator_free(d);
+    }
+
+    free(in);
+    free(whole);
+    free(chunked);
+}
+
+
+/* Through CIC, half-bands and final FIR, a tone anywhere in the passband
+ * keeps its level on both sides of DC, and one that would alias onto the
+ * passband from the first CIC null or the output rate is rejected by
+ * about the quality's attenuation */
+void test_passband_and_rejection(void)
+{
+    static const struct
+    {
+        int quality;
+        double edge;
+        double reject_db;
+    } q[] =
+    {
+        { RIG_RESAMPLE_FAST,   16000.0, 55.0 },
+        { RIG_RESAMPLE_MEDIUM, 19000.0, 75.0 },
+        { RIG_RESAMPLE_BEST,   21500.0, 90.0 },
+    };
+    const int factor = WIDE_RATE / 48000;
+    size_t frames = (size_t)OUT_FRAMES * factor;
+    float *out = malloc(OUT_FRAMES * 2 * sizeof(float));
+
+    TEST_ASSERT(out != NULL);
+
+    for (size_t k = 0; k < sizeof(q) / sizeof(q[0]); k++)
+    {
+        const double pass[] = { 1000.0, -6000.0, q[k].edge, -q[k].edge };
+        const double alias[] = { 51000.0, 384000.0 + 3000.0, -93000.0 };
+        size_t i, made;
+
+        for (i = 0; i < sizeof(pass) / sizeof(pass[0]); i++)
+        {
+            float *in = make_tone(frames, 1, pass[i], WIDE_RATE);
+            double gain;
+
+            TEST_ASSERT(in != NULL);
+            made = decimate_all(WIDE_RATE, factor, 1, 0.0, q[k].quality, in,
+                                frames, out);
+            gain = tone_level(out, made, 1, 0, pass[i], 48000) / 0.5;
+            TEST_CHECK(fabs(gain - 1.0) < 0.01);
+            TEST_MSG("quality %d: %.0f Hz gain %.4f", q[k].quality, pass[i],
+                     gain);
+            free(in);
+        }
+
+        for (i = 0; i < sizeof(alias) / sizeof(alias[0]); i++)
+        {
+            float *in = make_tone(frames, 1, alias[i], WIDE_RATE);
+            double level;
+
+            TEST_ASSERT(in != NULL);
+            made = decimate_all(WIDE_RATE, factor, 1, 0.0, q[k].quality, in,
+                                frames, out);
+            level = 20 * log10(mid_rms(out, made, 1, 0) / 0.5);
+            TEST_CHECK(level < -q[k].reject_db);
+            TEST_MSG("quality %d: %.0f Hz left at %.1f dB", q[k].quality,
+                     alias[i], level);
+            free(in);
+        }
+    }
+
+    free(out);
+}
+
+
+/* The NCO moves the signal at +shift to DC: a tone 2 kHz above the shift
+ * comes out at 2 kHz, and one at the unshifted centre falls outside */
+void test_shift(void)
+{
+    const int factor = 4;
+    const double shift = 60000.0;
+    size_t frames = (size_t)OUT_FRAMES * factor;
+    float *out = malloc(OUT_FRAMES * 2 * 2 * sizeof(float));
+    float *in;
+    size_t made;
+    double gain;
+
+    TEST_ASSERT(out != NULL);
+
+    in = make_tone(frames, 2, shift + 2000.0, 192000);
+    TEST_ASSERT(in != NULL);
+    made = decimate_all(192000, factor, 2, shift, RIG_RESAMPLE_MEDIUM, in,
+                        frames, out);
+
+    for (int ch = 0; ch < 2; ch++)
+    {
+        gain = tone_level(out, made, 2, ch, 2000.0, 48000) / 0.5;
+        TEST_CHECK(fabs(gain - 1.0) < 0.01);
+        TEST_MSG("channel %d gain %.4f", ch, gain);
+        TEST_CHECK(tone_level(out, made, 2, ch, -2000.0, 48000) < 1e-4);
+    }
+
+    free(in);
+
+    in = make_tone(frames, 2, 1000.0, 192000);
+    TEST_ASSERT(in != NULL);
+    made = decimate_all(192000, factor, 2, shift, RIG_RESAMPLE_MEDIUM, in,
+                        frames, out);
+    TEST_CHECK(20 * log10(mid_rms(out, made, 2, 0) / 0.5) < -75.0);
+    free(in);
+
+    // Factor 1 only shifts
+    in = make_tone(4800, 1, 5000.0, 48000);
+    TEST_ASSERT(in != NULL);
+    made = decimate_all(48000, 1, 1, 4000.0, RIG_RESAMPLE_FAST, in, 4800, out);
+    TEST_CHECK(made == 4800);
+    gain = tone_level(out, made, 1, 0, 1000.0, 48000) / 0.5;
+    TEST_CHECK(fabs(gain - 1.0) < 1e-4);
+    TEST_MSG("shift-only gain %.6f", gain);
+    free(in);
+
+    free(out);
+}
+
+
+struct sink_state
+{
+    int16_t *out;
+    size_t bytes;
+};
+
+
+static size_t conv_sink(void *ctx, const void *buf, size_t len)
+{
+    struct sink_state *st = ctx;
+
+    memcpy((char *)st->out + st->bytes, buf, len);
+    st->bytes += len;
+
+    return len;
+}
+
+
+/* A stream_conv pipeline switched to the decimator: CF32 at 192 kS/s in,
+ * CS16 at 48 kS/s out, and the cases it refuses */
+void test_conv_pipeline(void)
+{
+    struct stream_conv *c;
+    size_t frames = 19200;
+    float *in = make_tone(frames, 1, 30000.0, 192000);
+    int16_t *out = malloc(frames * 2 * sizeof(int16_t));
+    struct sink_state sink_state = { out, 0 };
+
+    TEST_ASSERT(in != NULL && out != NULL);
+
+    // Audio, and rates that do not divide, keep the resampler
+    TEST_ASSERT(stream_conv_init(&c, RIG_STREAM_FORMAT_PCM_F32, 48000, 1,
+                                 RIG_STREAM_FORMAT_PCM_F32, 8000, 1, 0,
+                                 RIG_RESAMPLE_FAST) == 0);
+    TEST_CHECK(stream_conv_use_decimator(c, 0.0, RIG_RESAMPLE_FAST) == -1);
+    stream_conv_free(c);
+
+    TEST_ASSERT(stream_conv_init(&c, RIG_STREAM_FORMAT_IQ_CF32, 192000, 1,
+                                 RIG_STREAM_FORMAT_IQ_CF32, 44100, 1, 1,
+                                 RIG_RESAMPLE_FAST) == 0);
+    TEST_CHECK(stream_conv_use_decimator(c, 0.0, RIG_RESAMPLE_FAST) == -1);
+    stream_conv_free(c);
+
+    TEST_ASSERT(stream_conv_init(&c, RIG_STREAM_FORMAT_IQ_CF32, 192000, 1,
+                                 RIG_STREAM_FORMAT_IQ_CS16, 48000, 1, 1,
+                                 RIG_RESAMPLE_MEDIUM) == 0);
+    TEST_CHECK(stream_conv_use_decimator(c, 28000.0, RIG_RESAMPLE_MEDIUM) == 0);
+    TEST_CHECK(stream_conv_process(c, in, frames * 2 * sizeof(float),
+                                   conv_sink, &sink_state)
+               == (ssize_t)(frames * 2 * sizeof(float)));
+    TEST_CHECK(sink_state.bytes == frames / 4 * 2 * sizeof(int16_t));
+
+    // The tone 2 kHz above the shift, now at 2 kHz in S16
+    {
+        size_t n = sink_state.bytes / (2 * sizeof(int16_t));
+        float *f = malloc(n * 2 * sizeof(float));
+        double gain;
+
+        TEST_ASSERT(f != NULL);
+
+        for (size_t i = 0; i < n * 2; i++)
+        {
+            f[i] = out[i] / 32768.0f;
+        }
+
+        gain = tone_level(f, n, 1, 0, 2000.0, 48000) / 0.5;
+        TEST_CHECK(fabs(gain - 1.0) < 0.01);
+        TEST_MSG("pipeline gain %.4f", gain);
+        free(f);
+    }
+
+    stream_conv_free(c);
+    free(in);
+    free(out);
+}
+
+
+void test_reset_and_args(void)
+{
+    struct stream_decimator *d;
+    float *in = make_tone(4000, 1, 1000.0, 96000);
+    float first[2000], again[2000];
+    size_t n1, n2;
+
+    TEST_ASSERT(in != NULL);
+    TEST_CHECK(stream_decimator_init(&d, 0, 2, 1, 0.0, RIG_RESAMPLE_FAST) == -1);
+    TEST_CHECK(stream_decimator_init(&d, 96000, 0, 1, 0.0,
+                                     RIG_RESAMPLE_FAST) == -1);
+    TEST_CHECK(stream_decimator_init(&d, 96000, 2, 0, 0.0,
+                                     RIG_RESAMPLE_FAST) == -1);
+    TEST_CHECK(stream_decimator_init(&d, 96000, 2, 1, 48000.0,
+                                     RIG_RESAMPLE_FAST) == -1);
+    TEST_CHECK(stream_decimator_init(&d, 96000, 2, 1, NAN,
+                                     RIG_RESAMPLE_FAST) == -1);
+
+    // After a reset the same input gives the same output again
+    TEST_ASSERT(stream_decimator_init(&d, 96000, 4, 1, 3000.0, 99) == 0);
+    n1 = stream_decimator_process(d, in, 4000, first);
+    stream_decimator_reset(d);
+    TEST_CHECK(stream_decimator_max_output(d, 4000) == 1000);
+    n2 = stream_decimator_process(d, in, 4000, again);
+
+    TEST_CHECK(n1 == 1000 && n2 == n1);
+    TEST_CHECK(memcmp(first, again, n1 * 2 * sizeof(float)) == 0);
+
+    stream_decimator_free(d);
+    free(in);
+}
+
+
+TEST_LIST =
+{
+    { "plan",                    test_plan },
+    { "output_count_exact",      test_output_count_exact },
+    { "chunks_match_one_call",   test_chunks_match_one_call },
+    { "passband_and_rejection",  test_passband_and_rejection },
+    { "shift",                   test_shift },
+    { "conv_pipeline",           test_conv_pipeline },
+    { "reset_and_args",          test_reset_and_args },
+    { NULL, NULL }
+};
@@ -0,0 +1,519 @@
+/*
+ *  Hamlib stream recorder tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* SigMF and WAV recordings of RX streams fed through a stub backend. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include "stream.h"
+#include "stream_anchor.h"
+#include "stream_record.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <hamlib/rig.h>
+
+static int stub_stream_open(RIG *rig, struct rig_stream *stream)
+{
+    (void)rig;
+    (void)stream;
+    return RIG_OK;
+}
+
+static int stub_stream_close(RIG *rig, struct rig_stream *stream)
+{
+    (void)rig;
+    (void)stream;
+    return RIG_OK;
+}
+
+static int stub_rig_open(RIG *rig)
+{
+    (void)rig;
+    return RIG_OK;
+}
+
+static int stub_rig_close(RIG *rig)
+{
+    (void)rig;
+    return RIG_OK;
+}
+
+static const struct rig_stream_caps stub_stream_caps[] =
+{
+    {
+        .type = RIG_STREAM_TYPE_AUDIO_RX,
+        .formats = RIG_STREAM_FORMAT_PCM_S16,
+        .sample_rates = { 48000, 0 },
+        .channels = { 1, 0 },
+        .max_streams = 1,
+    },
+    {
+        .type = RIG_STREAM_TYPE_AUDIO_TX,
+        .formats = RIG_STREAM_FORMAT_PCM_S16,
+        .sample_rates = { 48000, 0 },
+        .channels = { 1, 0 },
+        .max_streams = 1,
+    },
+    {
+        .type = RIG_STREAM_TYPE_IQ_RX,
+        .formats = RIG_STREAM_FORMAT_IQ_CS8 | RIG_STREAM_FORMAT_IQ_CS16,
+        .sample_rates = { 48000, 0 },
+        .channels = { 1, 0 },
+        .max_streams = 1,
+    },
+    { 0 }
+};
+
+static struct rig_caps stub_caps =
+{
+    .rig_model = 1,
+    .model_name = "Stub Record",
+    .mfg_name = "Test",
+    .version = "1.0",
+    .status = RIG_STATUS_STABLE,
+    .rig_type = RIG_TYPE_TRANSCEIVER,
+    .port_type = RIG_PORT_NONE,
+    .timeout = 1000,
+    .stream_caps = stub_stream_caps,
+    .rig_open = stub_rig_open,
+    .rig_close = stub_rig_close,
+    .stream_open = stub_stream_open,
+    .stream_close = stub_stream_close,
+};
+
+
+static RIG *setup_rig(void)
+{
+    RIG *rig;
+
+    rig_register(&stub_caps);
+    rig = rig_init(stub_caps.rig_model);
+
+    if (rig && rig_open(rig) != RIG_OK)
+    {
+        rig_cleanup(rig);
+        return NULL;
+    }
+
+    return rig;
+}
+
+
+static void teardown_rig(RIG *rig)
+{
+    rig_close(rig);
+    rig_cleanup(rig);
+}
+
+
+static rig_stream_t *open_stream(RIG *rig, rig_stream_type_t type,
+                                 rig_stream_format_t format)
+{
+    struct rig_stream_config *config = rig_stream_config_alloc();
+    rig_stream_t *stream = NULL;
+
+    TEST_ASSERT(config != NULL);
+    config->type = type;
+    config->format = format;
+    config->sample_rate = 48000;
+    config->channels = 1;
+    config->buffer_bytes = 256 * 1024;
+    TEST_CHECK(rig_stream_open(rig, config, &stream) == RIG_OK);
+    rig_stream_config_free(config);
+
+    return stream;
+}
+
+
+/* Wait for the recorder to have taken samples frames from the stream */
+static int wait_samples(RIG *rig, rig_stream_recorder_t *rec, uint64_t samples)
+{
+    struct rig_stream_record_stats stats;
+    int i;
+
+    for (i = 0; i < 200; i++)
+    {
+        rig_stream_recorder_get_stats(rig, rec, &stats);
+
+        if (stats.samples >= samples)
+        {
+            return 1;
+        }
+
+        usleep(10 * 1000);
+    }
+
+    return 0;
+}
+
+
+static char *read_file(const char *path, long *size)
+{
+    FILE *f = fopen(path, "rb");
+    char *buf;
+
+    if (!f)
+    {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = calloc(1, *size + 1);
+
+    if (buf && fread(buf, 1, *size, f) != (size_t)*size)
+    {
+        free(buf);
+        buf = NULL;
+    }
+
+    fclose(f);
+    return buf;
+}
+
+
+static uint32_t get_le32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+static void temp_path(char *path, size_t size, const char *name)
+{
+    snprintf(path, size, "/tmp/hamlib_record_%d_%s", (int)getpid(), name);
+}
+
+
+/* I/Q into SigMF: the samples as they came, a capture per frequency and
+ * per gap with its time, an annotation per gap.  Closing the stream ends
+ * the recording. */
+static void test_sigmf_captures(void)
+{
+    RIG *rig = setup_rig();
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_stream(rig, RIG_STREAM_TYPE_IQ_RX,
+                                       RIG_STREAM_FORMAT_IQ_CS16);
+    TEST_ASSERT(stream != NULL);
+
+    struct rig_stream_record_config config;
+    struct rig_stream_record_stats stats;
+    struct rig_stream_time_anchor anchor;
+    rig_stream_recorder_t *rec;
+    static int16_t iq[4800 * 2];
+    char base[256], path[300];
+    char *data, *meta;
+    long size;
+    int i;
+
+    for (i = 0; i < 4800 * 2; i++)
+    {
+        iq[i] = (int16_t)(i * 7);
+    }
+
+    temp_path(base, sizeof(base), "iq");
+    memset(&config, 0, sizeof(config));
+    config.container = RIG_STREAM_RECORD_SIGMF;
+    config.path = base;
+    config.description = "40 m \"FT8\"";
+    config.block_bytes = 8192;
+    config.blocks = 2;
+    config.direct_io = 1;
+
+    pthread_mutex_lock(&stream->ringbuf.lock);
+    stream->center_freq = 7074000;
+    pthread_mutex_unlock(&stream->ringbuf.lock);
+
+    memset(&anchor, 0, sizeof(anchor));
+    anchor.seconds = 1736000000;
+    anchor.source = RIG_STREAM_TIME_SRC_GPS;
+    anchor.flags = RIG_STREAM_TIME_FLAG_LOCKED
+                   | RIG_STREAM_TIME_FLAG_SAMPLE_REFERENCED;
+    TEST_CHECK(rig_stream_push_time_anchor(stream, &anchor) == RIG_OK);
+
+    TEST_ASSERT(rig_stream_recorder_open(rig, stream, &config, &rec) == RIG_OK);
+
+    stream_backend_write(stream, iq, sizeof(iq));
+    TEST_CHECK(wait_samples(rig, rec, 4800));
+
+    /* Retuned: a new capture where the next read starts */
+    pthread_mutex_lock(&stream->ringbuf.lock);
+    stream->center_freq = 7076000;
+    pthread_mutex_unlock(&stream->ringbuf.lock);
+    stream_backend_write(stream, iq, sizeof(iq));
+    TEST_CHECK(wait_samples(rig, rec, 9600));
+
+    stream_skip_samples(stream, 100, RIG_STREAM_DROP_GAP);
+    stream_backend_write(stream, iq, 480 * 4);
+    TEST_CHECK(wait_samples(rig, rec, 10080));
+
+    TEST_CHECK(rig_stream_recorder_get_stats(rig, rec, &stats) == RIG_OK);
+    TEST_CHECK(stats.gaps == 1);
+    TEST_CHECK(stats.dropped_samples == 100);
+    TEST_CHECK(stats.captures == 3);
+
+    /* The stream's close finishes the recorder */
+    TEST_CHECK(rig_stream_close(rig, stream) == RIG_OK);
+
+    snprintf(path, sizeof(path), "%s.sigmf-data", base);
+    data = read_file(path, &size);
+    TEST_ASSERT(data != NULL);
+    TEST_CHECK(size == 10080 * 4);
+    TEST_CHECK(memcmp(data, iq, sizeof(iq)) == 0);
+    TEST_CHECK(memcmp(data + sizeof(iq), iq, sizeof(iq)) == 0);
+    TEST_CHECK(memcmp(data + 2 * sizeof(iq), iq, 480 * 4) == 0);
+    free(data);
+    unlink(path);
+
+    snprintf(path, sizeof(path), "%s.sigmf-meta", base);
+    meta = read_file(path, &size);
+    TEST_ASSERT(meta != NULL);
+    TEST_MSG("%s", meta);
+    TEST_CHECK(strstr(meta, "\"core:datatype\":\"ci16_le\"") != NULL);
+    TEST_CHECK(strstr(meta, "\"core:sample_rate\":48000") != NULL);
+    TEST_CHECK(strstr(meta, "\"core:hw\":\"Test Stub Record\"") != NULL);
+    TEST_CHECK(strstr(meta, "\"core:description\":\"40 m \\\"FT8\\\"\"")
+               != NULL);
+    TEST_CHECK(strstr(meta, "{\"core:sample_start\":0,\"core:global_index\":0,"
+                      "\"core:frequency\":7074000,\"core:datetime\":"
+                      "\"2025-01-04T14:13:20.000000000Z\"}") != NULL);
+    TEST_CHECK(strstr(meta, "{\"core:sample_start\":4800,"
+                      "\"core:global_index\":4800,"
+                      "\"core:frequency\":7076000,") != NULL);
+    TEST_CHECK(strstr(meta, "{\"core:sample_start\":9600,"
+                      "\"core:global_index\":9700,"
+                      "\"core:frequency\":7076000,\"core:datetime\":"
+                      "\"2025-01-04T14:13:20.2020833") != NULL);
+    TEST_CHECK(strstr(meta, "\"annotations\":[{\"core:sample_start\":9600,"
+                      "\"core:label\":\"gap\",\"core:comment\":"
+                      "\"100 samples dropped (gap at the radio)\"}]") != NULL);
+    free(meta);
+    unlink(path);
+
+    teardown_rig(rig);
+}
+
+
+/* Audio into WAV: samples after the header page, the gap as silence,
+ * sizes and bext filled in at the close. */
+static void test_wav_gap_silence(void)
+{
+    RIG *rig = setup_rig();
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_stream(rig, RIG_STREAM_TYPE_AUDIO_RX,
+                                       RIG_STREAM_FORMAT_PCM_S16);
+    TEST_ASSERT(stream != NULL);
+
+    struct rig_stream_record_config config;
+    struct rig_stream_time_anchor anchor;
+    rig_stream_recorder_t *rec;
+    int16_t pcm[480];
+    char path[256];
+    const unsigned char *hdr;
+    const int16_t *samples;
+    char *wav;
+    long size;
+    int i;
+
+    for (i = 0; i < 480; i++)
+    {
+        pcm[i] = (int16_t)(1000 + i);
+    }
+
+    temp_path(path, sizeof(path), "audio.wav");
+    memset(&config, 0, sizeof(config));
+    config.container = RIG_STREAM_RECORD_WAV;
+    config.path = path;
+
+    memset(&anchor, 0, sizeof(anchor));
+    anchor.seconds = 1736000000;
+    anchor.picoseconds = 500000000000ULL;
+    anchor.source = RIG_STREAM_TIME_SRC_NTP;
+    TEST_CHECK(rig_stream_push_time_anchor(stream, &anchor) == RIG_OK);
+
+    TEST_ASSERT(rig_stream_recorder_open(rig, stream, &config, &rec) == RIG_OK);
+
+    stream_backend_write(stream, pcm, sizeof(pcm));
+    TEST_CHECK(wait_samples(rig, rec, 480));
+    stream_skip_samples(stream, 20, RIG_STREAM_DROP_GAP);
+    stream_backend_write(stream, pcm, sizeof(pcm));
+    TEST_CHECK(wait_samples(rig, rec, 980));
+
+    TEST_CHECK(rig_stream_recorder_close(rig, rec) == RIG_OK);
+
+    wav = read_file(path, &size);
+    TEST_ASSERT(wav != NULL);
+    hdr = (const unsigned char *)wav;
+    TEST_CHECK(size == STREAM_RECORD_WAV_HEADER + 980 * 2);
+    TEST_CHECK(memcmp(hdr, "RIFF", 4) == 0);
+    TEST_CHECK(get_le32(hdr + 4) == (uint32_t)size - 8);
+    TEST_CHECK(memcmp(hdr + 8, "WAVE", 4) == 0);
+    TEST_CHECK(memcmp(hdr + 48, "fmt ", 4) == 0);
+    TEST_CHECK(get_le32(hdr + 60) == 48000);
+    TEST_CHECK(hdr[56] == 1 && hdr[58] == 1 && hdr[70] == 16);
+    TEST_CHECK(memcmp(hdr + 72, "bext", 4) == 0);
+    TEST_CHECK(memcmp(hdr + 80 + 256, "Hamlib", 6) == 0);
+    TEST_CHECK(memcmp(hdr + 80 + 320, "2025-01-0414:13:20", 18) == 0);
+    /* 14:13:20.5 is 51200.5 s after midnight */
+    TEST_CHECK(get_le32(hdr + 80 + 338) == 51200U * 48000 + 24000);
+    TEST_CHECK(memcmp(hdr + STREAM_RECORD_WAV_HEADER - 8, "data", 4) == 0);
+    TEST_CHECK(get_le32(hdr + STREAM_RECORD_WAV_HEADER - 4) == 980 * 2);
+
+    samples = (const int16_t *)(wav + STREAM_RECORD_WAV_HEADER);
+    TEST_CHECK(memcmp(samples, pcm, sizeof(pcm)) == 0);
+
+    for (i = 480; i < 500; i++)
+    {
+        TEST_CHECK_(samples[i] == 0, "silence at %d", i);
+    }
+
+    TEST_CHECK(memcmp(samples + 500, pcm, sizeof(pcm)) == 0);
+    free(wav);
+    unlink(path);
+
+    rig_stream_close(rig, stream);
+    teardown_rig(rig);
+}
+
+
+/* Signed 8-bit I/Q goes to WAV as unsigned, two channels per I/Q channel */
+static void test_wav_iq_unsigned(void)
+{
+    RIG *rig = setup_rig();
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *stream = open_stream(rig, RIG_STREAM_TYPE_IQ_RX,
+                                       RIG_STREAM_FORMAT_IQ_CS8);
+    TEST_ASSERT(stream != NULL);
+
+    struct rig_stream_record_config config;
+    rig_stream_recorder_t *rec;
+    int8_t iq[8] = { 0, 0, 64, -64, 127, -128, 1, -1 };
+    char path[256];
+    const unsigned char *hdr;
+    char *wav;
+    long size;
+
+    temp_path(path, sizeof(path), "iq.wav");
+    memset(&config, 0, sizeof(config));
+    config.container = RIG_STREAM_RECORD_WAV;
+    config.path = path;
+    TEST_ASSERT(rig_stream_recorder_open(rig, stream, &config, &rec) == RIG_OK);
+
+    stream_backend_write(stream, iq, sizeof(iq));
+    TEST_CHECK(wait_samples(rig, rec, 4));
+    TEST_CHECK(rig_stream_recorder_close(rig, rec) == RIG_OK);
+
+    wav = read_file(path, &size);
+    TEST_ASSERT(wav != NULL);
+    hdr = (const unsigned char *)wav;
+    TEST_CHECK(size == STREAM_RECORD_WAV_HEADER + 8);
+    TEST_CHECK(hdr[58] == 2 && hdr[70] == 8);
+    TEST_CHECK(hdr[STREAM_RECORD_WAV_HEADER] == 0x80);
+    TEST_CHECK(hdr[STREAM_RECORD_WAV_HEADER + 2] == 0xC0);
+    TEST_CHECK(hdr[STREAM_RECORD_WAV_HEADER + 3] == 0x40);
+    free(wav);
+    unlink(path);
+
+    rig_stream_close(rig, stream);
+    teardown_rig(rig);
+}
+
+
+/* Past 4 GB the header turns RF64, the sizes moving into ds64 */
+static void test_wav_rf64_header(void)
+{
+    static unsigned char hdr[STREAM_RECORD_WAV_HEADER];
+    uint64_t data_bytes = 5ULL * 1024 * 1024 * 1024 + 4;
+
+    stream_record_wav_header(hdr, RIG_STREAM_FORMAT_IQ_CF32, 1, 2000000,
+                             data_bytes, NULL, NULL);
+    TEST_CHECK(memcmp(hdr, "RF64", 4) == 0);
+    TEST_CHECK(get_le32(hdr + 4) == 0xFFFFFFFF);
+    TEST_CHECK(memcmp(hdr + 12, "ds64", 4) == 0);
+    TEST_CHECK(get_le32(hdr + 20) == (uint32_t)(data_bytes
+               + STREAM_RECORD_WAV_HEADER - 8));
+    TEST_CHECK(get_le32(hdr + 24) == 1);
+    TEST_CHECK(get_le32(hdr + 28) == (uint32_t)data_bytes);
+    TEST_CHECK(get_le32(hdr + 32) == 1);
+    TEST_CHECK(get_le32(hdr + 36) == (uint32_t)(data_bytes / 8));
+    TEST_CHECK(hdr[56] == 3 && hdr[58] == 2 && hdr[70] == 32);
+    TEST_CHECK(get_le32(hdr + STREAM_RECORD_WAV_HEADER - 4) == 0xFFFFFFFF);
+
+    stream_record_wav_header(hdr, RIG_STREAM_FORMAT_PCM_S16, 2, 48000, 1000,
+                             NULL, NULL);
+    TEST_CHECK(memcmp(hdr, "RIFF", 4) == 0);
+    TEST_CHECK(memcmp(hdr + 12, "JUNK", 4) == 0);
+    TEST_CHECK(get_le32(hdr + 4) == 1000 + STREAM_RECORD_WAV_HEADER - 8);
+
+    TEST_CHECK(strcmp(stream_record_sigmf_datatype(RIG_STREAM_FORMAT_IQ_CU8),
+                      "cu8") == 0);
+    TEST_CHECK(stream_record_sigmf_datatype(RIG_STREAM_FORMAT_OPUS) == NULL);
+}
+
+
+static void test_bad_args(void)
+{
+    RIG *rig = setup_rig();
+    TEST_ASSERT(rig != NULL);
+    rig_stream_t *rx = open_stream(rig, RIG_STREAM_TYPE_AUDIO_RX,
+                                   RIG_STREAM_FORMAT_PCM_S16);
+    rig_stream_t *tx = open_stream(rig, RIG_STREAM_TYPE_AUDIO_TX,
+                                   RIG_STREAM_FORMAT_PCM_S16);
+    TEST_ASSERT(rx != NULL && tx != NULL);
+
+    struct rig_stream_record_config config;
+    rig_stream_recorder_t *rec;
+
+    memset(&config, 0, sizeof(config));
+    config.container = RIG_STREAM_RECORD_WAV;
+
+    TEST_CHECK(rig_stream_recorder_open(rig, rx, &config,
+                                        &rec) == -RIG_EINVAL);
+    config.path = "/nonexistent/dir/x.wav";
+    TEST_CHECK(rig_stream_recorder_open(rig, rx, &config, &rec) == -RIG_EIO);
+    TEST_CHECK(rig_stream_recorder_open(rig, tx, &config,
+                                        &rec) == -RIG_EINVAL);
+    config.container = 7;
+    TEST_CHECK(rig_stream_recorder_open(rig, rx, &config,
+                                        &rec) == -RIG_EINVAL);
+    TEST_CHECK(rig_stream_recorder_close(rig, NULL) == -RIG_EINVAL);
+
+    rig_stream_close(rig, tx);
+    rig_stream_close(rig, rx);
+    teardown_rig(rig);
+}
+
+
+TEST_LIST =
+{
+    { "sigmf_captures",   test_sigmf_captures },
+    { "wav_gap_silence",  test_wav_gap_silence },
+    { "wav_iq_unsigned",  test_wav_iq_unsigned },
+    { "wav_rf64_header",  test_wav_rf64_header },
+    { "bad_args",         test_bad_args },
+    { NULL, NULL }
+};
@@ -0,0 +1,317 @@
+/*
+ *  Hamlib streaming resampler tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* The polyphase resampler: exact output counts, seamless chunked input,
+ * passband gain and stopband rejection for each quality. */
+
+#ifdef HAVE_CONFIG_H
+#include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include "stream_convert.h"
+#include "stream_resample.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TONE_FRAMES 48000
+
+static float tone_in[TONE_FRAMES * 2];
+static float tone_out[TONE_FRAMES * 8];
+static float chunk_out[TONE_FRAMES * 8];
+
+
+static void make_tone(float *s, size_t frames, int channels, double freq,
+                      int rate)
+{
+    for (size_t i = 0; i < frames; i++)
+    {
+        for (int ch = 0; ch < channels; ch++)
+        {
+            s[i * channels + ch] = (float)(0.5 * sin(2 * M_PI * freq * i / rate
+                                                     + ch));
+        }
+    }
+}
+
+
+/* RMS of the middle half of a channel, away from the filter's ramps */
+static double mid_rms(const float *s, size_t frames, int channels, int ch)
+{
+    double sum = 0;
+    size_t i;
+
+    for (i = frames / 4; i < frames * 3 / 4; i++)
+    {
+        sum += (double)s[i * channels + ch] * s[i * channels + ch];
+    }
+
+    return sqrt(sum / (frames / 2));
+}
+
+
+/* Resample all of in in one call, returning the frames made */
+static size_t resample_all(int in_rate, int out_rate, int channels,
+                           int quality, const float *in, size_t frames,
+                           float *out, size_t out_cap)
+{
+    struct stream_resampler *rs;
+    size_t used = frames, made;
+
+    TEST_ASSERT(stream_resampler_init(&rs, in_rate, out_rate, channels,
+                                      quality) == 0);
+    made = stream_resampler_process(rs, in, &used, out, out_cap);
+    TEST_CHECK(used == frames);
+    stream_resampler_free(rs);
+
+    return made;
+}
+
+
+void test_output_count_exact(void)
+{
+    static const int rates[][2] =
+    {
+        { 48000, 8000 }, { 8000, 48000 }, { 44100, 48000 }, { 48000, 44100 },
+        { 192000, 24000 }, { 12000, 48000 }, { 48000, 47999 }, { 11025, 8000 },
+    };
+
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++)
+    {
+        struct stream_resampler *rs;
+        size_t frames = 20000, made = 0, done = 0;
+        uint64_t expected = ((uint64_t)frames * rates[k][1] + rates[k][0] - 1)
+                            / rates[k][0];
+
+        TEST_ASSERT(stream_resampler_init(&rs, rates[k][0], rates[k][1], 1,
+                                          RIG_RESAMPLE_MEDIUM) == 0);
+        TEST_CHECK(stream_resampler_max_output(rs, frames) == expected);
+
+        // The count never drifts however the input is cut up
+        while (done < frames)
+        {
+            size_t used = 1 + (done * 7919) % 1500;
+
+            if (used > frames - done)
+            {
+                used = frames - done;
+            }
+
+            made += stream_resampler_process(rs, tone_in, &used, tone_out,
+                                             TONE_FRAMES * 8);
+            done += used;
+        }
+
+        TEST_CHECK(made == expected);
+        TEST_MSG("%d -> %d: %zu frames, expected %llu", rates[k][0], rates[k][1],
+                 made, (unsigned long long)expected);
+        stream_resampler_free(rs);
+    }
+}
+
+
+/* Feeding in pieces, or into a short output, gives the same samples as
+ * one call */
+void test_chunks_match_one_call(void)
+{
+    static const int rates[][2] = { { 44100, 48000 }, { 48000, 8000 },
+        { 8000, 48000 }, { 48000, 47999 }
+    };
+
+    make_tone(tone_in, TONE_FRAMES, 2, 700.0, 48000);
+
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++)
+    {
+        struct stream_resampler *rs;
+        size_t frames = 10000, whole, made = 0, done = 0;
+
+        whole = resample_all(rates[k][0], rates[k][1], 2, RIG_RESAMPLE_FAST,
+                             tone_in, frames, tone_out, TONE_FRAMES * 4);
+
+        TEST_ASSERT(stream_resampler_init(&rs, rates[k][0], rates[k][1], 2,
+                                          RIG_RESAMPLE_FAST) == 0);
+
+        while (done < frames)
+        {
+            size_t used = frames - done < 333 ? frames - done : 333;
+
+            made += stream_resampler_process(rs, tone_in + done * 2, &used,
+                                             chunk_out + made * 2, 97);
+            done += used;
+        }
+
+        // Drain what a full output held back
+        for (;;)
+        {
+            size_t used = 0, more;
+
+            more = stream_resampler_process(rs, tone_in, &used,
+                                            chunk_out + made * 2, 97);
+
+            if (more == 0)
+            {
+                break;
+            }
+
+            made += more;
+        }
+
+        TEST_CHECK(made == whole);
+        TEST_CHECK(memcmp(chunk_out, tone_out, whole * 2 * sizeof(float)) == 0);
+        TEST_MSG("%d -> %d: %zu vs %zu frames", rates[k][0], rates[k][1], made,
+                 whole);
+        stream_resampler_free(rs);
+    }
+}
+
+
+/* A tone in the passband keeps its level; one above the output Nyquist
+ * frequency is rejected by about the quality's stopband attenuation */
+void test_passband_and_stopband(void)
+{
+    static const struct
+    {
+        int quality;
+        double reject_db;
+    } q[] =
+    {
+        { RIG_RESAMPLE_FAST, 55.0 },
+        { RIG_RESAMPLE_MEDIUM, 75.0 },
+        { RIG_RESAMPLE_BEST, 90.0 },
+    };
+    double in_rms = 0.5 / sqrt(2.0);
+
+    for (size_t k = 0; k < sizeof(q) / sizeof(q[0]); k++)
+    {
+        size_t made;
+        double pass, stop;
+
+        make_tone(tone_in, TONE_FRAMES, 1, 1000.0, 48000);
+        made = resample_all(48000, 8000, 1, q[k].quality, tone_in, TONE_FRAMES,
+                            tone_out, TONE_FRAMES);
+        pass = mid_rms(tone_out, made, 1, 0);
+
+        // Would alias to 3 kHz
+        make_tone(tone_in, TONE_FRAMES, 1, 5000.0, 48000);
+        made = resample_all(48000, 8000, 1, q[k].quality, tone_in, TONE_FRAMES,
+                            tone_out, TONE_FRAMES);
+        stop = 20 * log10(mid_rms(tone_out, made, 1, 0) / in_rms);
+
+        TEST_CHECK(fabs(pass / in_rms - 1.0) < 0.01);
+        TEST_CHECK(stop < -q[k].reject_db);
+        TEST_MSG("quality %d: passband gain %.4f, stopband %.1f dB", q[k].quality,
+                 pass / in_rms, stop);
+    }
+}
+
+
+/* Upsampling by a ratio too fine for a phase per position interpolates
+ * between phases and still keeps the tone */
+void test_interpolated_phases(void)
+{
+    size_t made;
+    double gain;
+
+    make_tone(tone_in, TONE_FRAMES, 2, 1500.0, 44100);
+    made = resample_all(44100, 44101, 2, RIG_RESAMPLE_MEDIUM, tone_in,
+                        TONE_FRAMES, tone_out, TONE_FRAMES * 2);
+    TEST_CHECK(made == (size_t)(((uint64_t)TONE_FRAMES * 44101 + 44099) / 44100));
+
+    for (int ch = 0; ch < 2; ch++)
+    {
+        gain = mid_rms(tone_out, made, 2, ch) / (0.5 / sqrt(2.0));
+        TEST_CHECK(fabs(gain - 1.0) < 0.01);
+        TEST_MSG("channel %d gain %.4f", ch, gain);
+    }
+}
+
+
+/* rig_stream_resample() lines output frame k up with input time k / ratio */
+void test_one_shot_alignment(void)
+{
+    float src[200], dst[1200];
+    size_t dst_samples = 1200;
+
+    for (int i = 0; i < 200; i++)
+    {
+        src[i] = (float)i / 199.0f;
+    }
+
+    TEST_CHECK(rig_stream_resample(src, 8000, dst, 48000, 200, &dst_samples, 1,
+                                   RIG_RESAMPLE_BEST) == 0);
+    TEST_CHECK(dst_samples == 1200);
+
+    // A ramp passes a symmetric filter unchanged away from its ends
+    for (int i = 60; i < 140; i++)
+    {
+        TEST_CHECK(fabsf(dst[i * 6] - src[i]) < 1e-3f);
+        TEST_MSG("dst[%d] = %f, src[%d] = %f", i * 6, dst[i * 6], i, src[i]);
+    }
+
+    // A short output is filled and reported
+    dst_samples = 100;
+    TEST_CHECK(rig_stream_resample(src, 8000, dst, 48000, 200, &dst_samples, 1,
+                                   RIG_RESAMPLE_BEST) == 0);
+    TEST_CHECK(dst_samples == 100);
+
+    TEST_CHECK(rig_stream_resample(src, 0, dst, 48000, 200, &dst_samples, 1,
+                                   RIG_RESAMPLE_BEST) == -1);
+}
+
+
+void test_reset_and_args(void)
+{
+    struct stream_resampler *rs;
+    size_t used = 100, first, again;
+
+    TEST_CHECK(stream_resampler_init(&rs, 0, 48000, 1, RIG_RESAMPLE_FAST) == -1);
+    TEST_CHECK(stream_resampler_init(&rs, 48000, 48000, 0,
+                                     RIG_RESAMPLE_FAST) == -1);
+
+    make_tone(tone_in, 100, 1, 440.0, 8000);
+    TEST_ASSERT(stream_resampler_init(&rs, 8000, 48000, 1, 99) == 0);
+    first = stream_resampler_process(rs, tone_in, &used, tone_out, 1000);
+
+    // After a reset the same input gives the same output again
+    stream_resampler_reset(rs);
+    used = 100;
+    again = stream_resampler_process(rs, tone_in, &used, chunk_out, 1000);
+
+    TEST_CHECK(first == 600 && again == first);
+    TEST_CHECK(memcmp(tone_out, chunk_out, first * sizeof(float)) == 0);
+    TEST_CHECK(stream_resampler_delay(rs) > 0);
+
+    stream_resampler_free(rs);
+}
+
+
+TEST_LIST =
+{
+    { "output_count_exact",      test_output_count_exact },
+    { "chunks_match_one_call",   test_chunks_match_one_call },
+    { "passband_and_stopband",   test_passband_and_stopband },
+    { "interpolated_phases",     test_interpolated_phases },
+    { "one_shot_alignment",      test_one_shot_alignment },
+    { "reset_and_args",          test_reset_and_args },
+    { NULL, NULL }
+};
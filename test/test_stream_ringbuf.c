@@ -22,11 +22,17 @@
 /* Ring buffer unit tests for the Hamlib streaming subsystem. */
 /* Tests init/destroy, read/write, wraparound, overwrite, and concurrency. */
 
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
 #include "acutest.h"
 #include "test_debug.h"
 #include "stream.h"
 #include <string.h>
+#include <stddef.h>
 #include <pthread.h>
+#include <unistd.h>
 
 
 void test_ringbuf_init_destroy(void)
@@ -38,9 +44,9 @@ void test_ringbuf_init_destroy(void)
     TEST_MSG("stream_ringbuf_init returned %d", ret);
     TEST_CHECK(rb.buffer != NULL);
     TEST_CHECK(rb.capacity >= 1024);
-    TEST_CHECK(rb.read_pos == 0);
-    TEST_CHECK(rb.write_pos == 0);
-    TEST_CHECK(rb.count == 0);
+    TEST_CHECK(rb.read_total == 0);
+    TEST_CHECK(rb.write_total == 0);
+    TEST_CHECK(stream_ringbuf_available(&rb) == 0);
     TEST_CHECK(rb.overrun_count == 0);
     TEST_CHECK(rb.underrun_count == 0);
 
@@ -49,6 +55,21 @@ void test_ringbuf_init_destroy(void)
 }
 
 
+/* The producer's and the consumer's indices each start a cache line, so
+ * they never share one wherever the ring lands */
+void test_ringbuf_index_lines(void)
+{
+    TEST_CHECK(_Alignof(struct rig_stream_ringbuf) >= STREAM_RINGBUF_CACHE_LINE);
+    TEST_CHECK(offsetof(struct rig_stream_ringbuf, write_total)
+               % STREAM_RINGBUF_CACHE_LINE == 0);
+    TEST_CHECK(offsetof(struct rig_stream_ringbuf, read_total)
+               % STREAM_RINGBUF_CACHE_LINE == 0);
+    TEST_CHECK(offsetof(struct rig_stream_ringbuf, read_total)
+               - offsetof(struct rig_stream_ringbuf, write_claim)
+               >= STREAM_RINGBUF_CACHE_LINE - sizeof(uint64_t));
+}
+
+
 void test_ringbuf_write_read(void)
 {
     struct rig_stream_ringbuf rb;
@@ -347,9 +368,8 @@ void test_ringbuf_reset(void)
 
     stream_ringbuf_reset(&rb);
     TEST_CHECK(stream_ringbuf_available(&rb) == 0);
-    TEST_CHECK(rb.read_pos == 0);
-    TEST_CHECK(rb.write_pos == 0);
-    TEST_CHECK(rb.count == 0);
+    TEST_CHECK(rb.read_total == 100);
+    TEST_CHECK(rb.write_total == 100);
 
     stream_ringbuf_destroy(&rb);
 }
@@ -469,6 +489,251 @@ void test_ringbuf_concurrent(void)
 }
 
 
+/* Page-sized rings are mapped twice where memfd_create() exists, so a
+ * write across the end shows up at the start too; small ones stay on the
+ * heap.  Either way the data read back is the same. */
+void test_ringbuf_mirrored(void)
+{
+    struct rig_stream_ringbuf rb;
+    const size_t capacity = 65536;
+    unsigned char data[100], out[100];
+    static unsigned char fill[65536];
+
+    TEST_ASSERT(stream_ringbuf_init(&rb, 64) == 0);
+    TEST_CHECK(rb.mirrored == 0);
+    stream_ringbuf_destroy(&rb);
+
+    TEST_ASSERT(stream_ringbuf_init(&rb, capacity) == 0);
+#ifdef HAVE_MEMFD_CREATE
+    TEST_CHECK(rb.mirrored == 1);
+#endif
+
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (unsigned char)(i + 1);
+    }
+
+    /* Move both indices to 50 bytes before the end, then write across it */
+    TEST_CHECK(stream_ringbuf_write(&rb, fill, capacity - 50) == capacity - 50);
+    TEST_CHECK(stream_ringbuf_read(&rb, fill, capacity - 50, 0) == capacity - 50);
+    TEST_CHECK(stream_ringbuf_write(&rb, data, sizeof(data)) == sizeof(data));
+
+    if (rb.mirrored)
+    {
+        TEST_CHECK(memcmp(rb.buffer + capacity - 50, data, sizeof(data)) == 0);
+        TEST_CHECK(memcmp(rb.buffer, data + 50, 50) == 0);
+    }
+
+    TEST_CHECK(stream_ringbuf_read(&rb, out, sizeof(out), 0) == sizeof(out));
+    TEST_CHECK(memcmp(out, data, sizeof(data)) == 0);
+
+    stream_ringbuf_destroy(&rb);
+    TEST_CHECK(rb.buffer == NULL && rb.mirrored == 0);
+}
+
+
+/* The producer never takes the lock: a write while another thread holds it
+ * goes through, and the lapped reader resumes at the oldest kept byte. */
+void test_ringbuf_write_without_lock(void)
+{
+    struct rig_stream_ringbuf rb;
+    unsigned char data[96], out[64];
+    uint64_t start;
+
+    TEST_ASSERT(stream_ringbuf_init(&rb, 64) == 0);
+
+    for (int i = 0; i < 96; i++)
+    {
+        data[i] = (unsigned char)i;
+    }
+
+    pthread_mutex_lock(&rb.lock);
+    TEST_CHECK(stream_ringbuf_write(&rb, data, 64) == 64);
+    TEST_CHECK(stream_ringbuf_write(&rb, data + 64, 32) == 32);
+    TEST_CHECK(rb.overrun_count == 1);
+    TEST_CHECK(rb.write_total == 96);
+    TEST_CHECK(stream_ringbuf_read_index(&rb) == 32);
+
+    TEST_CHECK(stream_ringbuf_consume_at_locked(&rb, out, sizeof(out),
+               &start) == 64);
+    pthread_mutex_unlock(&rb.lock);
+
+    TEST_CHECK(start == 32);
+    TEST_CHECK(memcmp(out, data + 32, 64) == 0);
+    TEST_CHECK(stream_ringbuf_available(&rb) == 0);
+
+    stream_ringbuf_destroy(&rb);
+}
+
+
+static void *late_writer_thread(void *arg)
+{
+    struct rig_stream_ringbuf *rb = arg;
+    unsigned char data[16];
+
+    /* Only write once the reader is asleep */
+    while (!__atomic_load_n(&rb->reader_waiting, __ATOMIC_ACQUIRE))
+    {
+        usleep(1000);
+    }
+
+    memset(data, 0x5a, sizeof(data));
+    stream_ringbuf_write(rb, data, sizeof(data));
+
+    return NULL;
+}
+
+
+void test_ringbuf_wakes_blocked_reader(void)
+{
+    struct rig_stream_ringbuf rb;
+    unsigned char out[16];
+    pthread_t writer;
+
+    TEST_ASSERT(stream_ringbuf_init(&rb, 1024) == 0);
+    pthread_create(&writer, NULL, late_writer_thread, &rb);
+
+    TEST_CHECK(stream_ringbuf_read(&rb, out, sizeof(out), 5000) == sizeof(out));
+    TEST_CHECK(out[0] == 0x5a && out[15] == 0x5a);
+    TEST_CHECK(rb.reader_waiting == 0);
+    TEST_CHECK(rb.underrun_count == 0);
+
+    pthread_join(writer, NULL);
+    stream_ringbuf_destroy(&rb);
+}
+
+
+#define LAPPED_WORDS 200000
+
+static void *counting_producer_thread(void *arg)
+{
+    struct rig_stream_ringbuf *rb = arg;
+    uint32_t words[7];
+    uint32_t next = 0;
+
+    /* Chunks of 1..7 words: the ring is laps ahead of the reader most
+     * of the time */
+    while (next < LAPPED_WORDS)
+    {
+        int n = 1 + next % 7;
+
+        for (int i = 0; i < n; i++)
+        {
+            words[i] = next++;
+        }
+
+        stream_ringbuf_write(rb, words, n * sizeof(uint32_t));
+    }
+
+    return NULL;
+}
+
+
+/* A reader lapped by the producer never sees torn or stale words: every
+ * word read is its own index in the stream, as reported by the start of
+ * the copy. */
+void test_ringbuf_lapped_reader_integrity(void)
+{
+    struct rig_stream_ringbuf rb;
+    uint32_t out[16];
+    uint64_t start, last = 0;
+    int bad = 0, reads = 0;
+    pthread_t producer;
+
+    TEST_ASSERT(stream_ringbuf_init(&rb, 256) == 0);
+    pthread_create(&producer, NULL, counting_producer_thread, &rb);
+
+    while (last < LAPPED_WORDS)
+    {
+        pthread_mutex_lock(&rb.lock);
+
+        if (stream_ringbuf_wait_data_locked(&rb, 1000) < 0)
+        {
+            pthread_mutex_unlock(&rb.lock);
+            break;
+        }
+
+        size_t n = stream_ringbuf_consume_at_locked(&rb, (unsigned char *)out,
+                   sizeof(out), &start);
+        pthread_mutex_unlock(&rb.lock);
+
+        reads++;
+
+        if (start % sizeof(uint32_t) != 0 || n % sizeof(uint32_t) != 0
+                || start / sizeof(uint32_t) < last)
+        {
+            bad++;
+            break;
+        }
+
+        for (size_t i = 0; i < n / sizeof(uint32_t); i++)
+        {
+            bad += out[i] != start / sizeof(uint32_t) + i;
+        }
+
+        last = (start + n) / sizeof(uint32_t);
+    }
+
+    pthread_join(producer, NULL);
+
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(last == LAPPED_WORDS);
+    TEST_MSG("%d reads, %d bad, %llu of %d words, %d overruns", reads, bad,
+             (unsigned long long)last, LAPPED_WORDS, rb.overrun_count);
+
+    stream_ringbuf_destroy(&rb);
+}
+
+/* Cursors read the same bytes as the consumer without moving it, and the
+ * producer neither waits for them nor counts their overruns. */
+void test_ringbuf_cursors(void)
+{
+    struct rig_stream_ringbuf rb;
+    struct rig_stream_ringbuf_cursor a, b;
+    unsigned char data[48], out[64];
+    uint64_t start;
+
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (unsigned char)i;
+    }
+
+    TEST_ASSERT(stream_ringbuf_init(&rb, 64) == 0);
+    TEST_CHECK(stream_ringbuf_write(&rb, data, 16) == 16);
+
+    /* A new cursor starts at the producer */
+    stream_ringbuf_cursor_init(&rb, &a);
+    TEST_CHECK(stream_ringbuf_cursor_available(&rb, &a) == 0);
+    stream_ringbuf_cursor_init(&rb, &b);
+
+    TEST_CHECK(stream_ringbuf_write(&rb, data, 32) == 32);
+    TEST_CHECK(stream_ringbuf_cursor_read(&rb, &a, out, sizeof(out),
+                                          &start) == 32);
+    TEST_CHECK(start == 16);
+    TEST_CHECK(memcmp(out, data, 32) == 0);
+    TEST_CHECK(stream_ringbuf_available(&rb) == 48);
+
+    pthread_mutex_lock(&rb.lock);
+    TEST_CHECK(stream_ringbuf_cursor_wait_locked(&rb, &a, 10) == -2);
+    TEST_CHECK(stream_ringbuf_cursor_wait_locked(&rb, &b, 10) == 0);
+    pthread_mutex_unlock(&rb.lock);
+    TEST_CHECK(rb.underrun_count == 0);
+
+    /* Lap b only: the consumer keeps up, so no overrun is counted */
+    TEST_CHECK(stream_ringbuf_read(&rb, out, sizeof(out), 0) == 48);
+    TEST_CHECK(stream_ringbuf_write(&rb, data, 48) == 48);
+    TEST_CHECK(stream_ringbuf_cursor_lag(&rb, &b) == 80);
+    TEST_CHECK(stream_ringbuf_cursor_read(&rb, &b, out, sizeof(out),
+                                          &start) == 64);
+    TEST_CHECK(start == 32);
+    TEST_CHECK(memcmp(out + 16, data, 48) == 0);
+    TEST_CHECK(stream_ringbuf_cursor_lag(&rb, &b) == 0);
+    TEST_CHECK(rb.overrun_count == 0);
+
+    stream_ringbuf_destroy(&rb);
+}
+
+
 void test_ringbuf_init_zero_capacity(void)
 {
     struct rig_stream_ringbuf rb;
@@ -524,6 +789,7 @@ TEST_LIST =
 {
     { "stream_ringbuf_init_zero_capacity", test_ringbuf_init_zero_capacity },
     { "stream_ringbuf_init_destroy",   test_ringbuf_init_destroy },
+    { "stream_ringbuf_index_lines",    test_ringbuf_index_lines },
     { "stream_ringbuf_write_read",     test_ringbuf_write_read },
     { "stream_ringbuf_partial_read",   test_ringbuf_partial_read },
     { "stream_ringbuf_wraparound",     test_ringbuf_wraparound },
@@ -538,5 +804,10 @@ TEST_LIST =
     { "stream_ringbuf_reset",          test_ringbuf_reset },
     { "stream_ringbuf_power_of_two",   test_ringbuf_power_of_two },
     { "stream_ringbuf_concurrent",     test_ringbuf_concurrent },
+    { "stream_ringbuf_mirrored",       test_ringbuf_mirrored },
+    { "stream_ringbuf_write_without_lock", test_ringbuf_write_without_lock },
+    { "stream_ringbuf_wakes_blocked_reader", test_ringbuf_wakes_blocked_reader },
+    { "stream_ringbuf_lapped_reader_integrity", test_ringbuf_lapped_reader_integrity },
+    { "stream_ringbuf_cursors",        test_ringbuf_cursors },
     { NULL, NULL }
 };
@@ -0,0 +1,423 @@
+/*
+ *  Hamlib batched UDP I/O tests
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Datagrams queued and sent in batches, received in batches, and the
+ * multicast publisher gathering packets within its batch window. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "acutest.h"
+#include "test_debug.h"
+#include <hamlib/rig.h>
+#include "udp_batch.h"
+#include "network.h"
+#include "event.h"
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static struct udp_batch batch;
+static struct udp_recv_batch recv_batch;
+
+
+/* A receiving loopback socket; addr gets its address */
+static int open_receiver(struct sockaddr_in *addr)
+{
+    socklen_t addr_len = sizeof(*addr);
+    struct timeval tv = { 2, 0 };
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, (struct sockaddr *)addr, sizeof(*addr)) != 0
+            || getsockname(fd, (struct sockaddr *)addr, &addr_len) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    return fd;
+}
+
+
+static int wait_readable(int fd)
+{
+    struct timeval tv = { 2, 0 };
+    fd_set rfds;
+
+    FD_ZERO(&rfds);
+    FD_SET(fd, &rfds);
+
+    return select(fd + 1, &rfds, NULL, NULL, &tv) > 0;
+}
+
+
+static void queue_packet(int n)
+{
+    unsigned char *packet = udp_batch_reserve(&batch, 100);
+
+    TEST_ASSERT(packet != NULL);
+    snprintf((char *)packet, 100, "packet %d", n);
+    udp_batch_commit(&batch, strlen((char *)packet));
+}
+
+
+void test_send_and_receive_batch(void)
+{
+    struct sockaddr_in addr;
+    struct udp_batch_stats stats;
+    int rx_fd = open_receiver(&addr);
+    int tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int received = 0, i;
+
+    TEST_ASSERT(rx_fd >= 0 && tx_fd >= 0);
+    TEST_ASSERT(udp_batch_init(&batch, tx_fd, &addr, sizeof(addr)) == RIG_OK);
+
+    for (i = 0; i < 10; i++)
+    {
+        queue_packet(i);
+    }
+
+    TEST_CHECK(batch.count == 10);
+    TEST_CHECK(udp_batch_flush(&batch) == RIG_OK);
+    TEST_CHECK(batch.count == 0);
+
+    udp_batch_stats_get(&batch.stats, &stats);
+    TEST_CHECK(stats.packets == 10);
+    TEST_CHECK(stats.errors == 0);
+#ifdef HAVE_SENDMMSG
+    TEST_CHECK(stats.syscalls == 1);
+#else
+    TEST_CHECK(stats.syscalls == 10);
+#endif
+
+    while (received < 10 && wait_readable(rx_fd))
+    {
+        int n = udp_recv_batch(&recv_batch, rx_fd);
+        char expected[16];
+
+        TEST_ASSERT(n > 0);
+
+        for (i = 0; i < n; i++)
+        {
+            snprintf(expected, sizeof(expected), "packet %d", received++);
+            TEST_CHECK(strcmp(recv_batch.data[i], expected) == 0);
+            TEST_CHECK(recv_batch.length[i] == strlen(expected));
+        }
+    }
+
+    TEST_CHECK(received == 10);
+    udp_batch_stats_get(&recv_batch.stats, &stats);
+    TEST_CHECK(stats.packets == 10);
+#ifdef HAVE_RECVMMSG
+    // All ten were queued before the first receive
+    TEST_CHECK(stats.syscalls == 2);
+#endif
+
+    // Nothing left: no datagram and no error
+    TEST_CHECK(udp_recv_batch(&recv_batch, rx_fd) == 0);
+
+    close(tx_fd);
+    close(rx_fd);
+}
+
+
+void test_full_batch_flushes(void)
+{
+    struct sockaddr_in addr;
+    struct udp_batch_stats stats;
+    int rx_fd = open_receiver(&addr);
+    int tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int i;
+
+    TEST_ASSERT(rx_fd >= 0 && tx_fd >= 0);
+    TEST_ASSERT(udp_batch_init(&batch, tx_fd, &addr, sizeof(addr)) == RIG_OK);
+
+    // One more than a batch holds sends the first batch
+    for (i = 0; i <= UDP_BATCH_MAX; i++)
+    {
+        queue_packet(i);
+    }
+
+    udp_batch_stats_get(&batch.stats, &stats);
+    TEST_CHECK(stats.packets == UDP_BATCH_MAX);
+    TEST_CHECK(batch.count == 1);
+
+    // Out of buffer space does the same
+    TEST_CHECK(udp_batch_reserve(&batch, UDP_BATCH_BUFFER_SIZE) == batch.buffer);
+    TEST_CHECK(batch.count == 0);
+    TEST_CHECK(udp_batch_reserve(&batch, UDP_BATCH_BUFFER_SIZE + 1) == NULL);
+
+    close(tx_fd);
+    close(rx_fd);
+}
+
+
+void test_send_errors(void)
+{
+    struct sockaddr_in addr;
+    struct udp_batch_stats stats;
+    unsigned char big[64];
+
+    memset(big, 0, sizeof(big));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(9);
+
+    TEST_CHECK(udp_batch_init(&batch, -1, big, sizeof(big)) == -RIG_EINVAL);
+
+    // Every datagram refused is counted and dropped
+    TEST_ASSERT(udp_batch_init(&batch, -1, &addr, sizeof(addr)) == RIG_OK);
+    queue_packet(1);
+    queue_packet(2);
+    queue_packet(3);
+    TEST_CHECK(udp_batch_flush(&batch) == -RIG_EIO);
+    TEST_CHECK(batch.count == 0);
+
+    udp_batch_stats_get(&batch.stats, &stats);
+    TEST_CHECK(stats.packets == 0);
+    TEST_CHECK(stats.errors == 3);
+}
+
+
+/* Lines fired together leave the publisher in fewer system calls */
+void test_publisher_batches(void)
+{
+    static unsigned char bins[200];
+    struct rig_spectrum_line line;
+    struct udp_batch_stats stats;
+    struct sockaddr_in addr;
+    char port[16];
+    int received = 0;
+    RIG *rig;
+    int fd, i;
+
+    fd = open_receiver(&addr);
+    TEST_ASSERT(fd >= 0);
+    snprintf(port, sizeof(port), "%d", ntohs(addr.sin_port));
+
+    rig = rig_init(RIG_MODEL_DUMMY);
+    TEST_ASSERT(rig != NULL);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig, "multicast_data_addr"),
+                            "127.0.0.1") == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig, "multicast_data_port"),
+                            port) == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig,
+                            "multicast_spectrum_format"), "binary") == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig, "multicast_batch_window"),
+                            "50000") == RIG_OK);
+    TEST_CHECK(rig_set_conf(rig, rig_token_lookup(rig, "multicast_batch_window"),
+                            "100001") == -RIG_EINVAL);
+    TEST_ASSERT(rig_open(rig) == RIG_OK);
+
+    memset(&line, 0, sizeof(line));
+    line.spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
+    line.center_freq = 14074000;
+    line.spectrum_data_length = sizeof(bins);
+    line.spectrum_data = bins;
+
+    for (i = 0; i < 8; i++)
+    {
+        TEST_CHECK(rig_fire_spectrum_event(rig, &line) == RIG_OK);
+    }
+
+    while (received < 8 && wait_readable(fd))
+    {
+        int n = udp_recv_batch(&recv_batch, fd);
+
+        TEST_ASSERT(n >= 0);
+
+        for (i = 0; i < n; i++)
+        {
+            received += memcmp(recv_batch.data[i], "HSPC", 4) == 0;
+        }
+    }
+
+    TEST_CHECK(received == 8);
+
+    TEST_CHECK(network_multicast_publisher_get_stats(rig, &stats) == RIG_OK);
+    TEST_CHECK(stats.packets >= 8);
+#ifdef HAVE_SENDMMSG
+    TEST_CHECK(stats.syscalls < stats.packets);
+#endif
+    TEST_MSG("%llu packets in %llu calls", (unsigned long long)stats.packets,
+             (unsigned long long)stats.syscalls);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+    close(fd);
+}
+
+
+/* Equal-sized gathered packets, the last one short, sent with GSO where
+ * the system has it and read back through a receive queue */
+static void send_gathered_and_queue(int gro)
+{
+    static unsigned char payload[20][200];
+    struct udp_recv_queue queue;
+    struct sockaddr_in addr;
+    struct udp_batch_stats stats;
+    const unsigned char *data;
+    const void *from;
+    size_t length;
+    int rx_fd = open_receiver(&addr);
+    int tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int gso, received = 0, i;
+
+    TEST_ASSERT(rx_fd >= 0 && tx_fd >= 0);
+    TEST_ASSERT(udp_batch_init(&batch, tx_fd, &addr, sizeof(addr)) == RIG_OK);
+    TEST_ASSERT(udp_recv_queue_init(&queue, rx_fd, 32, 256, gro) == RIG_OK);
+    udp_batch_set_depth(&batch, 32);
+    gso = udp_batch_enable_gso(&batch);
+    TEST_MSG("GSO %d, GRO %d", gso, queue.gro);
+
+    for (i = 0; i < 20; i++)
+    {
+        unsigned char *header = udp_batch_reserve(&batch, 8 + 200);
+
+        TEST_ASSERT(header != NULL);
+        memset(payload[i], i, sizeof(payload[i]));
+        memcpy(header, "HDR", 3);
+        header[3] = (unsigned char)i;
+        memset(header + 4, 0, 4);
+        udp_batch_commit_gather(&batch, 8, payload[i], i < 19 ? 200 : 50);
+    }
+
+    TEST_CHECK(batch.count == 20);
+    TEST_CHECK(udp_batch_flush(&batch) == RIG_OK);
+
+    udp_batch_stats_get(&batch.stats, &stats);
+    TEST_CHECK(stats.packets == 20);
+    TEST_CHECK(stats.errors == 0);
+
+    if (gso)
+    {
+        // One GSO datagram carried the whole run
+        TEST_CHECK(stats.offloaded == 20);
+        TEST_CHECK(stats.syscalls == 1);
+    }
+
+    while (received < 20 && wait_readable(rx_fd))
+    {
+        TEST_ASSERT(udp_recv_queue_fill(&queue) > 0);
+
+        while ((data = udp_recv_queue_next(&queue, &length, &from)) != NULL)
+        {
+            const struct sockaddr_in *sin = from;
+            size_t expected = received < 19 ? 208 : 58;
+
+            TEST_CHECK(length == expected);
+            TEST_CHECK(data[3] == received);
+            TEST_CHECK(data[length - 1] == received);
+            TEST_CHECK(sin->sin_addr.s_addr == htonl(INADDR_LOOPBACK));
+            received++;
+        }
+    }
+
+    TEST_CHECK(received == 20);
+    udp_batch_stats_get(&queue.stats, &stats);
+    TEST_CHECK(stats.packets == 20);
+    TEST_CHECK(stats.syscalls < 20);
+    TEST_MSG("%llu received in %llu calls, %llu coalesced",
+             (unsigned long long)stats.packets,
+             (unsigned long long)stats.syscalls,
+             (unsigned long long)stats.offloaded);
+
+    udp_recv_queue_free(&queue);
+    close(tx_fd);
+    close(rx_fd);
+}
+
+
+void test_gathered_gso_send(void)
+{
+    send_gathered_and_queue(0);
+}
+
+
+void test_gathered_gro_receive(void)
+{
+    send_gathered_and_queue(1);
+}
+
+
+void test_batch_depth(void)
+{
+    struct sockaddr_in addr;
+    struct udp_batch_stats stats;
+    int rx_fd = open_receiver(&addr);
+    int tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int i;
+
+    TEST_ASSERT(rx_fd >= 0 && tx_fd >= 0);
+    TEST_ASSERT(udp_batch_init(&batch, tx_fd, &addr, sizeof(addr)) == RIG_OK);
+    TEST_CHECK(batch.depth == UDP_BATCH_MAX);
+
+    // Out of range depths are clamped
+    udp_batch_set_depth(&batch, 0);
+    TEST_CHECK(batch.depth == 1);
+    udp_batch_set_depth(&batch, UDP_BATCH_DEPTH_MAX + 1);
+    TEST_CHECK(batch.depth == UDP_BATCH_DEPTH_MAX);
+
+    udp_batch_set_depth(&batch, 4);
+
+    for (i = 0; i < 9; i++)
+    {
+        queue_packet(i);
+    }
+
+    udp_batch_stats_get(&batch.stats, &stats);
+    TEST_CHECK(stats.packets == 8);
+    TEST_CHECK(batch.count == 1);
+
+    close(tx_fd);
+    close(rx_fd);
+}
+
+
+TEST_LIST =
+{
+    { "send_and_receive_batch",  test_send_and_receive_batch },
+    { "full_batch_flushes",      test_full_batch_flushes },
+    { "send_errors",             test_send_errors },
+    { "publisher_batches",       test_publisher_batches },
+    { "gathered_gso_send",       test_gathered_gso_send },
+    { "gathered_gro_receive",    test_gathered_gro_receive },
+    { "batch_depth",             test_batch_depth },
+    { NULL, NULL }
+};
@@ -0,0 +1,185 @@
+/*
+ * Hamlib codec_bench program
+ *
+ * Times the device audio codecs (G.711 mu-law and A-law, IMA ADPCM) in
+ * both directions through rig_audio_convert_to_pcm() and
+ * rig_audio_convert_from_pcm() with 16-bit PCM, in packet-sized blocks the
+ * way a backend calls them, once per conversion kernel set this CPU runs.
+ *
+ * Usage: codec_bench [million samples per run, default 20]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "hamlib/config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#include "stream_codec.h"
+#include "stream_convert.h"
+#include "stream_convert_simd.h"
+
+#define BLOCK_SAMPLES 960           /* 20 ms at 48 kHz */
+
+static const struct
+{
+    const char *name;
+    rig_audio_codec_t codec;
+    int uses_kernels;               /* Runs through the conversion kernels */
+} codecs[] =
+{
+    { "mu-law",    RIG_AUDIO_CODEC_MULAW,     1 },
+    { "A-law",     RIG_AUDIO_CODEC_ALAW,      1 },
+    { "IMA ADPCM", RIG_AUDIO_CODEC_ADPCM_IMA, 0 },
+};
+
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+/* Speech-like level: two tones and some noise, well inside full scale */
+static void make_signal(int16_t *s, size_t samples)
+{
+    size_t i;
+
+    srand(1);
+
+    for (i = 0; i < samples; i++)
+    {
+        double t = (double)i / 48000;
+
+        s[i] = (int16_t)(8000.0 * sin(2 * M_PI * 440.0 * t)
+                         + 4000.0 * sin(2 * M_PI * 1900.0 * t)
+                         + 600.0 * ((double)rand() / RAND_MAX - 0.5));
+    }
+}
+
+
+/* Millions of samples per second for encoding, then decoding, all samples
+ * in BLOCK_SAMPLES blocks; both < 0 on failure */
+static void time_codec(rig_audio_codec_t codec, const int16_t *pcm,
+                       size_t samples, double *enc_msps, double *dec_msps)
+{
+    struct rig_audio_codec_state *enc = rig_audio_codec_open(codec, 1);
+    struct rig_audio_codec_state *dec = rig_audio_codec_open(codec, 1);
+    static uint8_t coded[BLOCK_SAMPLES * 2 + 16];
+    static int16_t out[BLOCK_SAMPLES * 2];
+    size_t done, coded_len = 0, out_len;
+    double start;
+
+    *enc_msps = -1;
+    *dec_msps = -1;
+
+    if (!enc || !dec)
+    {
+        rig_audio_codec_close(enc);
+        rig_audio_codec_close(dec);
+        return;
+    }
+
+    start = now();
+
+    for (done = 0; done + BLOCK_SAMPLES <= samples; done += BLOCK_SAMPLES)
+    {
+        if (rig_audio_convert_from_pcm(enc, RIG_STREAM_FORMAT_PCM_S16,
+                                       pcm + done, BLOCK_SAMPLES * 2, coded,
+                                       sizeof(coded), &coded_len) != RIG_OK)
+        {
+            goto out;
+        }
+    }
+
+    *enc_msps = done / (now() - start) / 1e6;
+    start = now();
+
+    for (done = 0; done + BLOCK_SAMPLES <= samples; done += BLOCK_SAMPLES)
+    {
+        if (rig_audio_convert_to_pcm(dec, coded, coded_len,
+                                     RIG_STREAM_FORMAT_PCM_S16, out,
+                                     sizeof(out), &out_len) != RIG_OK)
+        {
+            *enc_msps = -1;
+            goto out;
+        }
+    }
+
+    *dec_msps = done / (now() - start) / 1e6;
+
+out:
+    rig_audio_codec_close(enc);
+    rig_audio_codec_close(dec);
+}
+
+
+int main(int argc, char *argv[])
+{
+    double millions = argc > 1 ? atof(argv[1]) : 20.0;
+    const struct stream_convert_kernels *sets[8];
+    int count = stream_convert_simd_kernels(sets, 8);
+    size_t samples, k;
+    int16_t *pcm;
+
+    if (millions <= 0)
+    {
+        fprintf(stderr, "usage: %s [million samples per run]\n", argv[0]);
+        return 1;
+    }
+
+    samples = (size_t)(millions * 1e6);
+    pcm = malloc(samples * sizeof(int16_t));
+
+    if (!pcm)
+    {
+        return 1;
+    }
+
+    make_signal(pcm, samples);
+
+    printf("%-10s %-8s %14s %14s\n", "codec", "kernels", "encode MS/s",
+           "decode MS/s");
+
+    for (k = 0; k < sizeof(codecs) / sizeof(codecs[0]); k++)
+    {
+        int s;
+
+        for (s = -1; s < count; s++)
+        {
+            const char *set = s < 0 ? "scalar" : sets[s]->name;
+            double enc, dec;
+
+            if (!codecs[k].uses_kernels && s >= 0)
+            {
+                break;
+            }
+
+            stream_convert_use_kernels(set);
+            time_codec(codecs[k].codec, pcm, samples, &enc, &dec);
+
+            if (enc < 0 || dec < 0)
+            {
+                printf("%-10s %-8s %14s %14s\n", codecs[k].name, set, "failed",
+                       "failed");
+                continue;
+            }
+
+            printf("%-10s %-8s %14.1f %14.1f\n", codecs[k].name,
+                   codecs[k].uses_kernels ? set : "-", enc, dec);
+        }
+    }
+
+    stream_convert_use_kernels(NULL);
+    free(pcm);
+
+    return 0;
+}
@@ -0,0 +1,298 @@
+/*
+ * Hamlib resample_bench program
+ *
+ * Times the built-in stream resampler over the rate pairs radios use,
+ * fed in chunks the way a stream pipeline feeds it, the I/Q decimator on
+ * the integer-ratio I/Q pairs, and libsamplerate's sinc converters on the
+ * same input when the build has it.
+ *
+ * Usage: resample_bench [seconds of signal, default 10]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "hamlib/config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "stream_convert.h"
+#include "stream_resample.h"
+#include "stream_decimate.h"
+
+#ifdef HAVE_SAMPLERATE
+#include <samplerate.h>
+#endif
+
+#define CHUNK_FRAMES 1024
+
+struct bench_case
+{
+    const char *name;
+    int in_rate;
+    int out_rate;
+    int channels;
+    int iq;                         /* Interleaved I/Q pairs */
+};
+
+static const struct bench_case cases[] =
+{
+    { "audio 48k -> 8k",         48000,   8000, 1 },
+    { "audio 8k -> 48k",          8000,  48000, 1 },
+    { "audio 12k -> 48k",        12000,  48000, 1 },
+    { "audio 16k -> 48k",        16000,  48000, 1 },
+    { "audio 24k -> 48k",        24000,  48000, 1 },
+    { "audio 44.1k -> 48k st",   44100,  48000, 2 },
+    { "audio 48k -> 44.1k st",   48000,  44100, 2 },
+    { "iq 96k -> 48k",           96000,  48000, 2, 1 },
+    { "iq 192k -> 48k",         192000,  48000, 2, 1 },
+    { "iq 192k -> 24k",         192000,  24000, 2, 1 },
+    { "iq 1.92M -> 48k",       1920000,  48000, 2, 1 },
+};
+
+static const struct
+{
+    const char *name;
+    int quality;
+#ifdef HAVE_SAMPLERATE
+    int converter;
+#endif
+} qualities[] =
+{
+#ifdef HAVE_SAMPLERATE
+    { "fast",   RIG_RESAMPLE_FAST,   SRC_SINC_FASTEST },
+    { "medium", RIG_RESAMPLE_MEDIUM, SRC_SINC_MEDIUM_QUALITY },
+    { "best",   RIG_RESAMPLE_BEST,   SRC_SINC_BEST_QUALITY },
+#else
+    { "fast",   RIG_RESAMPLE_FAST },
+    { "medium", RIG_RESAMPLE_MEDIUM },
+    { "best",   RIG_RESAMPLE_BEST },
+#endif
+};
+
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+/* Two tones and a little noise on every channel */
+static float *make_signal(const struct bench_case *c, size_t frames)
+{
+    float *s = malloc(frames * c->channels * sizeof(float));
+    size_t i;
+    int ch;
+
+    if (!s)
+    {
+        return NULL;
+    }
+
+    srand(1);
+
+    for (i = 0; i < frames; i++)
+    {
+        for (ch = 0; ch < c->channels; ch++)
+        {
+            double t = (double)i / c->in_rate;
+
+            s[i * c->channels + ch] = (float)(0.4 * sin(2 * M_PI * 1000.0 * t + ch)
+                                              + 0.3 * sin(2 * M_PI * 2900.0 * t)
+                                              + 0.01 * ((double)rand() / RAND_MAX - 0.5));
+        }
+    }
+
+    return s;
+}
+
+
+/* Seconds to resample all frames with the built-in resampler, or < 0 */
+static double time_native(const struct bench_case *c, int quality,
+                          const float *in, size_t frames, float *out,
+                          size_t out_cap)
+{
+    struct stream_resampler *rs;
+    double start;
+    size_t done;
+
+    if (stream_resampler_init(&rs, c->in_rate, c->out_rate, c->channels,
+                              quality) != 0)
+    {
+        return -1;
+    }
+
+    start = now();
+
+    for (done = 0; done < frames;)
+    {
+        size_t used = frames - done < CHUNK_FRAMES ? frames - done : CHUNK_FRAMES;
+
+        stream_resampler_process(rs, in + done * c->channels, &used, out,
+                                 out_cap);
+        done += used;
+    }
+
+    start = now() - start;
+    stream_resampler_free(rs);
+
+    return start;
+}
+
+
+/* Seconds to decimate all frames of an I/Q case, or < 0 */
+static double time_decimator(const struct bench_case *c, int quality,
+                             const float *in, size_t frames, float *out)
+{
+    struct stream_decimator *d;
+    double start;
+    size_t done;
+
+    if (!c->iq || c->in_rate % c->out_rate != 0
+            || stream_decimator_init(&d, c->in_rate, c->in_rate / c->out_rate,
+                                     c->channels / 2, 0.0, quality) != 0)
+    {
+        return -1;
+    }
+
+    start = now();
+
+    for (done = 0; done < frames;)
+    {
+        size_t chunk = frames - done < CHUNK_FRAMES ? frames - done : CHUNK_FRAMES;
+
+        stream_decimator_process(d, in + done * c->channels, chunk, out);
+        done += chunk;
+    }
+
+    start = now() - start;
+    stream_decimator_free(d);
+
+    return start;
+}
+
+
+#ifdef HAVE_SAMPLERATE
+static double time_samplerate(const struct bench_case *c, int converter,
+                              const float *in, size_t frames, float *out,
+                              size_t out_cap)
+{
+    SRC_STATE *state;
+    SRC_DATA data;
+    double start;
+    size_t done;
+    int err;
+
+    state = src_new(converter, c->channels, &err);
+
+    if (!state)
+    {
+        return -1;
+    }
+
+    start = now();
+
+    for (done = 0; done < frames;)
+    {
+        size_t chunk = frames - done < CHUNK_FRAMES ? frames - done : CHUNK_FRAMES;
+
+        data.data_in = (float *)(in + done * c->channels);
+        data.input_frames = (long)chunk;
+        data.data_out = out;
+        data.output_frames = (long)out_cap;
+        data.src_ratio = (double)c->out_rate / c->in_rate;
+        data.end_of_input = 0;
+
+        if (src_process(state, &data) != 0)
+        {
+            src_delete(state);
+            return -1;
+        }
+
+        done += data.input_frames_used;
+    }
+
+    start = now() - start;
+    src_delete(state);
+
+    return start;
+}
+#endif
+
+
+int main(int argc, char *argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 10.0;
+    size_t k, q;
+
+    if (seconds <= 0)
+    {
+        fprintf(stderr, "usage: %s [seconds of signal]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-24s %-7s %12s %12s", "rates", "quality", "native x RT",
+           "decim x RT");
+#ifdef HAVE_SAMPLERATE
+    printf(" %14s %8s", "libsamplerate", "speedup");
+#endif
+    printf("\n");
+
+    for (k = 0; k < sizeof(cases) / sizeof(cases[0]); k++)
+    {
+        const struct bench_case *c = &cases[k];
+        size_t frames = (size_t)(seconds * c->in_rate);
+        size_t out_cap = (size_t)((double)CHUNK_FRAMES * c->out_rate / c->in_rate)
+                         + 64;
+        float *in = make_signal(c, frames);
+        float *out = malloc(out_cap * c->channels * sizeof(float));
+
+        if (!in || !out)
+        {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+
+        for (q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++)
+        {
+            double native = time_native(c, qualities[q].quality, in, frames, out,
+                                        out_cap);
+            double decim = time_decimator(c, qualities[q].quality, in, frames,
+                                          out);
+
+            // Speed as multiples of real time: seconds of signal per second
+            printf("%-24s %-7s %12.0f", c->name, qualities[q].name,
+                   native > 0 ? seconds / native : 0.0);
+
+            if (decim > 0)
+            {
+                printf(" %12.0f", seconds / decim);
+            }
+            else
+            {
+                printf(" %12s", "-");
+            }
+#ifdef HAVE_SAMPLERATE
+            {
+                double other = time_samplerate(c, qualities[q].converter, in, frames,
+                                               out, out_cap);
+
+                printf(" %14.0f %7.1fx", other > 0 ? seconds / other : 0.0,
+                       native > 0 && other > 0 ? other / native : 0.0);
+            }
+#endif
+            printf("\n");
+        }
+
+        free(in);
+        free(out);
+    }
+
+    return 0;
+}
@@ -37,6 +37,7 @@
 #include <unistd.h>
 #include <ctype.h>
 #include <errno.h>
+#include <math.h>
 #include "rig_tests.h"
 
 // If true adds some debug statements to see flow of rigctl parsing
@@ -80,6 +81,9 @@ extern int read_history();
 #include "rigctld_stream.h"
 #include "stream_convert.h"
 #include "rigctld_client.h"
+#include "rigctld_notify.h"
+#include "rigctld_rigs.h"
+#include "rigctld_sched.h"
 
 #ifdef HAVE_NETDB_H
 #  include <netdb.h>
@@ -296,6 +300,11 @@ declare_proto_rig(stream_unmute);
 declare_proto_rig(stream_metadata_read);
 declare_proto_rig(stream_drain);
 declare_proto_rig(stream_list);
+declare_proto_rig(subscribe);
+declare_proto_rig(unsubscribe);
+declare_proto_rig(rig_select);
+declare_proto_rig(rig_list);
+declare_proto_rig(client_stats);
 
 
 /*
@@ -426,6 +435,11 @@ static struct test_table test_list[] =
     { 0xb8, "stream_metadata_read", ACTION(stream_metadata_read), ARG_IN1 | ARG_OUT | ARG_NOVFO, "Stream ID" },
     { 0xb9, "stream_drain",        ACTION(stream_drain),        ARG_IN1 | ARG_NOVFO, "Stream ID" },
     { 0xba, "stream_list",         ACTION(stream_list),         ARG_OUT | ARG_NOVFO },
+    { 0xbd, "subscribe",           ACTION(subscribe),           ARG_IN1 | ARG_IN_LINE | ARG_NOVFO, "Items [Interval [Deadband]]" },
+    { 0xbe, "unsubscribe",         ACTION(unsubscribe),         ARG_NOVFO },
+    { 0xbf, "rig_select",          ACTION(rig_select),          ARG_IN1 | ARG_NOVFO, "Rig" },
+    { 0xc0, "rig_list",            ACTION(rig_list),            ARG_OUT | ARG_NOVFO },
+    { 0xc1, "client_stats",        ACTION(client_stats),        ARG_OUT | ARG_NOVFO },
     { 0x00, "", NULL },
 };
 
@@ -1779,6 +1793,15 @@ readline_repeat:
 
 #endif // HAVE_LIBREADLINE
 
+    connection = pthread_getspecific(thread_data_key);
+
+    /* rigctld schedules writes ahead of reads (see rigctld_sched.h) */
+    if (connection)
+    {
+        connection->cmd_class = rigctld_sched_class(cmd_entry->flags & ARG_IN,
+                                cmd_entry->flags & ARG_OUT);
+    }
+
     if (sync_cb) { sync_cb(1); }    /* lock if necessary */
 
     if (!prompt)
@@ -1856,9 +1879,6 @@ readline_repeat:
         else if (strcmp(cmd_entry->arg1, "Password") == 0) { preCmd = 1; }
     }
 
-    connection = pthread_getspecific(
-                     thread_data_key);  // Get state of this connection
-
     /* Streaming commands are gated even when they take no arguments */
     int is_stream_cmd = (cmd >= 0xb0 && cmd <= 0xba);
 
@@ -6385,13 +6405,15 @@ struct stream_open_opts
     int transport_buffer_ms;
     int transport_buffer_bytes;
     int keepalive_timeout;
+    int batch_depth;
+    int batch_window;
 };
 
 static void stream_open_parse_opts(FILE *fin, struct rig_stream_config *cfg,
                                    struct stream_open_opts *opts)
 {
-    struct hamlib_kv_pair kv[12];
-    int nkv = hamlib_parse_kv_args(fin, kv, 12);
+    struct hamlib_kv_pair kv[16];
+    int nkv = hamlib_parse_kv_args(fin, kv, 16);
     int i;
 
     for (i = 0; i < nkv; i++)
@@ -6409,6 +6431,31 @@ static void stream_open_parse_opts(FILE *fin, struct rig_stream_config *cfg,
                 cfg->require_native = (int)val;
             }
         }
+        else if (strcmp(kv[i].key, "iq_decimate") == 0)
+        {
+            long val;
+
+            if (stream_open_kv_long(&kv[i], 0, 1, &val) == 0)
+            {
+                cfg->iq_decimate = (int)val;
+            }
+        }
+        else if (strcmp(kv[i].key, "iq_shift") == 0)
+        {
+            char *endptr;
+            double val = strtod(kv[i].value, &endptr);
+
+            /* Range is checked against the native rate at open. */
+            if (endptr == kv[i].value || *endptr != '\0' || !isfinite(val))
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: invalid %s '%s'\n",
+                          __func__, kv[i].key, kv[i].value);
+            }
+            else
+            {
+                cfg->iq_shift = val;
+            }
+        }
         else if (strcmp(kv[i].key, "ttl") == 0)
         {
             long val;
@@ -6465,6 +6512,24 @@ static void stream_open_parse_opts(FILE *fin, struct rig_stream_config *cfg,
                 opts->transport_buffer_bytes = (int)val;
             }
         }
+        else if (strcmp(kv[i].key, "batch_depth") == 0)
+        {
+            long val;
+
+            if (stream_open_kv_long(&kv[i], 1, UDP_BATCH_DEPTH_MAX, &val) == 0)
+            {
+                opts->batch_depth = (int)val;
+            }
+        }
+        else if (strcmp(kv[i].key, "batch_window") == 0)
+        {
+            long val;
+
+            if (stream_open_kv_long(&kv[i], 0, 100000, &val) == 0)
+            {
+                opts->batch_window = (int)val;
+            }
+        }
         else if (strcmp(kv[i].key, "mtu") == 0)
         {
             long val;
@@ -6525,7 +6590,7 @@ declare_proto_rig(stream_open)
     int retval;
 
     /* Optional key=value parameters; -1 = unset (registry default applies) */
-    struct stream_open_opts opts = { NULL, -1, -1, -1, -1, -1, -1 };
+    struct stream_open_opts opts = { NULL, -1, -1, -1, -1, -1, -1, -1, -1 };
 
     ENTERFUNC2;
 
@@ -6703,6 +6768,14 @@ declare_proto_rig(stream_open)
                                   : (STATE(rig)->stream_metadata_refresh_ms
                                      ? (int)STATE(rig)->stream_metadata_refresh_ms
                                      : g_stream_registry.metadata_refresh_ms);
+    stream->batch_depth = (opts.batch_depth > 0)
+                          ? opts.batch_depth
+                          : (STATE(rig)->stream_batch_depth
+                             ? (int)STATE(rig)->stream_batch_depth
+                             : RIG_STREAM_BATCH_DEPTH_DEFAULT);
+    stream->batch_window_us = (opts.batch_window >= 0)
+                              ? opts.batch_window
+                              : (int)STATE(rig)->stream_batch_window;
 
     /* Anti-hijack token from the system CSPRNG; IP validation is a second
      * factor where the client address is known. */
@@ -6714,9 +6787,12 @@ declare_proto_rig(stream_open)
 
         if (getpeername(fileno(fout),
                         (struct sockaddr *)&stream->tcp_client_addr,
-                        &addr_len) < 0)
+                        &addr_len) < 0
+                || (stream->tcp_client_addr.ss_family != AF_INET
+                    && stream->tcp_client_addr.ss_family != AF_INET6))
         {
-            /* Not a socket (e.g. test harness) — leave zeroed, skip IP check */
+            /* Not an IP socket (test harness, or a --unix-socket client whose
+             * datagrams come from loopback) — leave zeroed, skip IP check */
             memset(&stream->tcp_client_addr, 0, sizeof(stream->tcp_client_addr));
         }
     }
@@ -6936,6 +7012,7 @@ declare_proto_rig(stream_status)
     int s_channels = stream->config.channels;
     int s_udp_port = stream->udp_port;
     int s_packet_count = stream->packet_count;
+    int s_send_syscalls = stream->send_syscalls;
     unsigned s_gap_count = (unsigned)stream->gap_count;
     int s_multicast = stream->multicast;
     struct sockaddr_storage s_multicast_addr = stream->multicast_addr;
@@ -6963,6 +7040,7 @@ declare_proto_rig(stream_status)
         fprintf(fout, "codec_frames: %llu%c",
                 (unsigned long long)s_codec_frames, resp_sep);
         fprintf(fout, "packet_count: %d%c", s_packet_count, resp_sep);
+        fprintf(fout, "send_syscalls: %d%c", s_send_syscalls, resp_sep);
         fprintf(fout, "gap_count: %u%c", s_gap_count, resp_sep);
         fprintf(fout, "overruns: %u%c", stats.overruns, resp_sep);
         fprintf(fout, "underruns: %u%c", stats.underruns, resp_sep);
@@ -7002,7 +7080,7 @@ declare_proto_rig(stream_status)
     else
     {
         fprintf(fout,
-                "%s%c%d%c%u%c%s%c%d%c%d%c%d%c%d%c%d%c%u%c%u%c%u%c%u%c%u%c%u%c%u%c%llu%c%llu%c%llu%c%s%c%llu%c",
+                "%s%c%d%c%u%c%s%c%d%c%d%c%d%c%d%c%d%c%u%c%u%c%u%c%u%c%u%c%u%c%u%c%llu%c%llu%c%llu%c%s%c%llu%c%d%c",
                 stream_type_name(s_type), resp_sep,
                 s_stream_id, resp_sep,
                 s_sample_rate, resp_sep,
@@ -7023,7 +7101,8 @@ declare_proto_rig(stream_status)
                 (unsigned long long)stats.dropped_samples_overrun, resp_sep,
                 (unsigned long long)stats.dropped_samples_link, resp_sep,
                 s_convbuf, resp_sep,
-                (unsigned long long)s_codec_frames, resp_sep);
+                (unsigned long long)s_codec_frames, resp_sep,
+                s_send_syscalls, resp_sep);
     }
 
     RETURNFUNC2(RIG_OK);
@@ -7317,3 +7396,283 @@ declare_proto_rig(stream_list)
 
     RETURNFUNC2(RIG_OK);
 }
+
+
+/* '\subscribe' -- push change notifications on this connection
+ *
+ * arg1 is the rest of the line: "Items [Interval [Deadband]]".  The reply is
+ * the usual RPRT; pushed lines follow it asynchronously (see rigctld_notify.h).
+ */
+declare_proto_rig(subscribe)
+{
+    unsigned int items;
+    int interval_ms;
+    int deadband;
+    int sock;
+    int retval;
+    struct handle_data *conn;
+    struct rigctld_notify_registry *reg = rigctld_notify_registry_find(rig);
+
+    ENTERFUNC2;
+
+    if (!reg)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: change notifications need rigctld\n",
+                  __func__);
+        RETURNFUNC2(-RIG_ENAVAIL);
+    }
+
+    if (rigctld_notify_parse_args(arg1, &items, &interval_ms, &deadband) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: invalid subscribe args '%s'\n",
+                  __func__, arg1 ? arg1 : "NULL");
+        RETURNFUNC2(-RIG_EINVAL);
+    }
+
+    /* Pushes go straight to the socket; fout is only a stdio view of it */
+    conn = pthread_getspecific(thread_data_key);
+    sock = conn ? conn->sock : fileno(fout);
+
+    retval = rigctld_notify_subscribe(reg,
+                                      rigctld_client_id_get(), sock, items,
+                                      interval_ms, deadband);
+
+    if (retval == RIG_OK)
+    {
+        char names[64];
+
+        rigctld_notify_items_str(items, names, sizeof(names));
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: client %d items=%s interval=%d "
+                  "deadband=%d\n", __func__, rigctld_client_id_get(), names,
+                  interval_ms, deadband);
+    }
+
+    RETURNFUNC2(retval);
+}
+
+
+/* '\unsubscribe' -- stop change notifications on this connection */
+declare_proto_rig(unsubscribe)
+{
+    struct rigctld_notify_registry *reg = rigctld_notify_registry_find(rig);
+
+    ENTERFUNC2;
+
+    if (!reg)
+    {
+        RETURNFUNC2(-RIG_ENAVAIL);
+    }
+
+    if (!rigctld_notify_unsubscribe(reg, rigctld_client_id_get()))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: no active subscription\n", __func__);
+        RETURNFUNC2(-RIG_EINVAL);
+    }
+
+    RETURNFUNC2(RIG_OK);
+}
+
+
+/* '\rig_select' -- route this connection's commands to another rig
+ *
+ * Multi-rig rigctld only.  Takes effect from the next command.  A
+ * subscription is per rig, so one on the rig being left is dropped.
+ */
+declare_proto_rig(rig_select)
+{
+    struct handle_data *conn;
+    struct rigctld_rig *target;
+    struct rigctld_notify_registry *reg;
+
+    ENTERFUNC2;
+
+    conn = pthread_getspecific(thread_data_key);
+
+    if (g_rig_table.count == 0 || !conn || !conn->active)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: rigctld serves a single rig\n", __func__);
+        RETURNFUNC2(-RIG_ENAVAIL);
+    }
+
+    target = rigctld_rigs_find(&g_rig_table, arg1);
+
+    if (!target)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: no rig named '%s'\n", __func__,
+                  arg1 ? arg1 : "NULL");
+        RETURNFUNC2(-RIG_EINVAL);
+    }
+
+    if (target != conn->active)
+    {
+        reg = rigctld_notify_registry_find(conn->active->rig);
+
+        if (reg) { rigctld_notify_unsubscribe(reg, rigctld_client_id_get()); }
+    }
+
+    conn->selected = target;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: client %d -> rig '%s'\n", __func__,
+              rigctld_client_id_get(), target->name);
+
+    RETURNFUNC2(RIG_OK);
+}
+
+
+/* '\rig_list' -- rigs served by a multi-rig rigctld
+ *
+ * One entry per rig: name, model, own port (0 = shared port only), whether
+ * it is open, and whether it serves this connection.
+ */
+declare_proto_rig(rig_list)
+{
+    const struct handle_data *conn;
+    int i;
+
+    ENTERFUNC2;
+
+    if (g_rig_table.count == 0)
+    {
+        RETURNFUNC2(-RIG_ENAVAIL);
+    }
+
+    conn = pthread_getspecific(thread_data_key);
+
+    for (i = 0; i < g_rig_table.count; i++)
+    {
+        const struct rigctld_rig *r = &g_rig_table.rigs[i];
+        int current = conn && conn->selected == r;
+
+        if (i > 0)
+        {
+            fprintf(fout, "%c", resp_sep);  /* Blank line separator */
+        }
+
+        if ((interactive && prompt)
+                || (interactive && !prompt && ext_resp))
+        {
+            fprintf(fout, "name: %s%c", r->name, resp_sep);
+            fprintf(fout, "model: %u%c", (unsigned)r->model, resp_sep);
+            fprintf(fout, "port: %s%c", r->port[0] ? r->port : "0", resp_sep);
+            fprintf(fout, "open: %d%c", (int)r->opened, resp_sep);
+            fprintf(fout, "current: %d%c", current, resp_sep);
+        }
+        else
+        {
+            fprintf(fout, "%s%c%u%c%s%c%d%c%d%c", r->name, resp_sep,
+                    (unsigned)r->model, resp_sep,
+                    r->port[0] ? r->port : "0", resp_sep,
+                    (int)r->opened, resp_sep, current, resp_sep);
+        }
+    }
+
+    RETURNFUNC2(RIG_OK);
+}
+
+
+/* '\client_stats' -- fair scheduling and rate limit statistics of rigctld
+ *
+ * The per-client rate limits, then one entry per connected client: its
+ * peer, and for reads and writes the commands run, how many the token
+ * bucket delayed and for how long in total, and the total and longest
+ * wait for the rig lock.
+ */
+declare_proto_rig(client_stats)
+{
+    struct rigctld_sched_client *clients;
+    static const struct
+    {
+        int cls;
+        const char *name;
+    } classes[] =
+    {
+        { RIGCTLD_CLASS_READ,  "read" },
+        { RIGCTLD_CLASS_WRITE, "write" },
+    };
+    const struct handle_data *conn;
+    int keyed = (interactive && prompt) || (interactive && !prompt && ext_resp);
+    int i, j, n;
+
+    ENTERFUNC2;
+
+    conn = pthread_getspecific(thread_data_key);
+
+    if (!conn)
+    {
+        RETURNFUNC2(-RIG_ENAVAIL);  /* Only rigctld schedules clients */
+    }
+
+    clients = calloc(RIGCTLD_MAX_CLIENTS, sizeof(*clients));
+
+    if (!clients)
+    {
+        RETURNFUNC2(-RIG_ENOMEM);
+    }
+
+    n = rigctld_sched_snapshot(&g_sched, clients, RIGCTLD_MAX_CLIENTS);
+
+    if (keyed)
+    {
+        fprintf(fout, "read_rate: %d%c", g_sched.rate[RIGCTLD_CLASS_READ],
+                resp_sep);
+        fprintf(fout, "write_rate: %d%c", g_sched.rate[RIGCTLD_CLASS_WRITE],
+                resp_sep);
+    }
+    else
+    {
+        fprintf(fout, "%d%c%d%c", g_sched.rate[RIGCTLD_CLASS_READ], resp_sep,
+                g_sched.rate[RIGCTLD_CLASS_WRITE], resp_sep);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        const struct rigctld_sched_client *c = &clients[i];
+
+        fprintf(fout, "%c", resp_sep);  /* Blank line separator */
+
+        if (keyed)
+        {
+            fprintf(fout, "client: %d%c", c->client_id, resp_sep);
+            fprintf(fout, "peer: %s%c", c->peer, resp_sep);
+            fprintf(fout, "self: %d%c", c->client_id == conn->client_id, resp_sep);
+        }
+        else
+        {
+            fprintf(fout, "%d%c%s%c%d%c", c->client_id, resp_sep, c->peer, resp_sep,
+                    c->client_id == conn->client_id, resp_sep);
+        }
+
+        for (j = 0; j < 2; j++)
+        {
+            const struct rigctld_sched_stats *st = &c->stats[classes[j].cls];
+            const char *name = classes[j].name;
+
+            if (keyed)
+            {
+                fprintf(fout, "%s_commands: %llu%c", name,
+                        (unsigned long long)st->commands, resp_sep);
+                fprintf(fout, "%s_throttled: %llu%c", name,
+                        (unsigned long long)st->throttled, resp_sep);
+                fprintf(fout, "%s_throttle_ms: %llu%c", name,
+                        (unsigned long long)(st->throttle_us / 1000), resp_sep);
+                fprintf(fout, "%s_wait_ms: %llu%c", name,
+                        (unsigned long long)(st->wait_us / 1000), resp_sep);
+                fprintf(fout, "%s_wait_max_ms: %llu%c", name,
+                        (unsigned long long)(st->wait_max_us / 1000), resp_sep);
+            }
+            else
+            {
+                fprintf(fout, "%llu%c%llu%c%llu%c%llu%c%llu%c",
+                        (unsigned long long)st->commands, resp_sep,
+                        (unsigned long long)st->throttled, resp_sep,
+                        (unsigned long long)(st->throttle_us / 1000), resp_sep,
+                        (unsigned long long)(st->wait_us / 1000), resp_sep,
+                        (unsigned long long)(st->wait_max_us / 1000), resp_sep);
+            }
+        }
+    }
+
+    free(clients);
+
+    RETURNFUNC2(RIG_OK);
+}
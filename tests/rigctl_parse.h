@@ -53,6 +53,15 @@ struct handle_data
     int use_password;
     int is_passwordOK;
     int client_id;      /* Identifies the connection owning a stream */
+    /* Multi-rig rigctld: the rig this connection is served by, and the one
+     * \rig_select asked for.  The switch is made between two commands so a
+     * command is locked and unlocked on the same rig.  NULL otherwise. */
+    struct rigctld_rig *active;
+    struct rigctld_rig *selected;
+    /* Fair scheduling: this client's buckets and statistics (NULL if the
+     * table was full), and the class of the command about to lock. */
+    struct rigctld_sched_client *sched;
+    int cmd_class;
 };
 
 extern pthread_key_t thread_data_key;
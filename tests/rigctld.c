@@ -65,6 +65,10 @@
 #  include <netdb.h>
 #endif
 
+#ifdef HAVE_SYS_UN_H
+#  include <sys/un.h>
+#endif
+
 #include <pthread.h>
 
 #include "hamlib/rig.h"
@@ -76,6 +80,9 @@
 #include "rigctl_parse.h"
 #include "rigctld_stream.h"
 #include "rigctld_client.h"
+#include "rigctld_notify.h"
+#include "rigctld_rigs.h"
+#include "rigctld_sched.h"
 #include "riglist.h"
 #include "token.h"
 
@@ -124,6 +131,9 @@ static struct option long_options[] =
     {"stream-time-stale-invalidate", 1, 0, 1002},
     {"stream-source-id",             1, 0, 1006},
     {"stream-keepalive-timeout",     1, 0, 1007},
+    {"rigs-file",                    1, 0, 1008},
+    {"unix-socket",                  1, 0, 1009},
+    {"rate-limit",                   1, 0, 1010},
     {0, 0, 0, 0}
 };
 
@@ -135,12 +145,12 @@ void *handle_socket(void *arg);
 static void usage(FILE *fout);
 static void short_usage(FILE *fout);
 
-static unsigned client_count;
+static HAMLIB_ATOMIC unsigned client_count;
 static HAMLIB_ATOMIC int next_client_id =
     1;  /* Monotonically increasing client ID */
 
 static RIG *my_rig;             /* handle to rig (instance) */
-static volatile int rig_opened = 0;
+static HAMLIB_ATOMIC int rig_opened = 0;
 static int verbose = RIG_DEBUG_NONE;
 
 #ifdef HAVE_SIG_ATOMIC_T
@@ -163,23 +173,103 @@ static int bind_all = 0;
 #define MAXCONFLEN 2048
 
 
-void mutex_rigctld(int lock)
-{
-    static pthread_mutex_t client_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct rigctld_fair_lock client_lock = RIGCTLD_FAIR_LOCK_INITIALIZER;
+
 
+static void lock_rig(struct rigctld_fair_lock *l, int lock, int cls)
+{
     if (lock)
     {
-        pthread_mutex_lock(&client_lock);
+        rigctld_fair_lock_acquire(l, cls);
         rig_debug(RIG_DEBUG_VERBOSE, "%s: client lock engaged\n", __func__);
     }
     else
     {
         rig_debug(RIG_DEBUG_VERBOSE, "%s: client lock disengaged\n", __func__);
-        pthread_mutex_unlock(&client_lock);
+        rigctld_fair_lock_release(l);
     }
+}
+
 
+/*
+ * With --rigs-file each rig has its own lock, so clients of different
+ * rigs do not wait for each other; otherwise one lock covers the rig.
+ *
+ * rigctl_parse() sets the class of the command about to run; the client's
+ * token bucket may delay it before it queues for the lock.  Other locks
+ * taken by a connection thread are CONTROL and go through unmetered.
+ */
+void mutex_rigctld(int lock)
+{
+    struct handle_data *conn = pthread_getspecific(thread_data_key);
+    struct rigctld_fair_lock *l = conn && conn->active ? &conn->active->lock :
+                                  &client_lock;
+    int cls = RIGCTLD_CLASS_CONTROL;
+    int64_t delay_us, start_us;
+
+    if (!lock || !conn)
+    {
+        lock_rig(l, lock, cls);
+        return;
+    }
+
+    cls = conn->cmd_class;
+    conn->cmd_class = RIGCTLD_CLASS_CONTROL;
+
+    delay_us = rigctld_sched_admit(&g_sched, conn->sched, cls,
+                                   rigctld_sched_now_us());
+
+    if (delay_us > 0)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: client %d throttled %lldus\n", __func__,
+                  conn->client_id, (long long)delay_us);
+        hl_usleep(delay_us);
+    }
+
+    start_us = rigctld_sched_now_us();
+    lock_rig(l, 1, cls);
+    rigctld_sched_record_wait(&g_sched, conn->sched, cls,
+                              rigctld_sched_now_us() - start_us);
+}
+
+
+/* Notifier sync hook: arg is the rig table entry, or NULL for the single rig.
+ * Its polling yields to client writes like any read. */
+static void notify_sync(int lock, void *arg)
+{
+    struct rigctld_rig *r = arg;
+
+    lock_rig(r ? &r->lock : &client_lock, lock, RIGCTLD_CLASS_READ);
+}
+
+
+/* Transceive event callbacks: wake the \subscribe notifier */
+static int notify_freq_event(RIG *rig, vfo_t vfo, freq_t freq, rig_ptr_t arg)
+{
+    rigctld_notify_wake(arg);
+    return RIG_OK;
 }
 
+static int notify_mode_event(RIG *rig, vfo_t vfo, rmode_t mode,
+                             pbwidth_t width, rig_ptr_t arg)
+{
+    rigctld_notify_wake(arg);
+    return RIG_OK;
+}
+
+static int notify_vfo_event(RIG *rig, vfo_t vfo, rig_ptr_t arg)
+{
+    rigctld_notify_wake(arg);
+    return RIG_OK;
+}
+
+static int notify_ptt_event(RIG *rig, vfo_t vfo, ptt_t ptt, rig_ptr_t arg)
+{
+    rigctld_notify_wake(arg);
+    return RIG_OK;
+}
+
+
 #ifdef WIN32
 static BOOL WINAPI CtrlHandler(DWORD fdwCtrlType)
 {
@@ -248,6 +338,237 @@ static void handle_error(enum rig_debug_level_e lvl, const char *msg)
 #endif
 }
 
+
+/* Apply a "key=val,key=val" list with rig_set_conf; unknown keys are skipped */
+static int set_conf_list(RIG *rig, char *conf_parms)
+{
+    const char *token = strtok(conf_parms, ",");
+
+    while (token)
+    {
+        char mytoken[100], myvalue[100];
+        hamlib_token_t lookup;
+        int retcode;
+
+        sscanf(token, "%99[^=]=%99s", mytoken, myvalue);
+        //printf("mytoken=%s,myvalue=%s\n",mytoken, myvalue);
+        lookup = rig_token_lookup(rig, mytoken);
+
+        if (lookup == 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: no such token as '%s'\n", __func__, mytoken);
+            token = strtok(NULL, ",");
+            continue;
+        }
+
+        retcode = rig_set_conf(rig, lookup, myvalue);
+
+        if (retcode != RIG_OK)
+        {
+            return retcode;
+        }
+
+        token = strtok(NULL, ",");
+    }
+
+    return RIG_OK;
+}
+
+
+/*
+ * Initialize and open one of the rigs-file rigs after the first.  A rig
+ * that fails to open is kept, like the command line rig: it may be
+ * powered off and clients reopen it.
+ */
+static int setup_table_rig(struct rigctld_rig *r, int twiddle_timeout,
+                           int twiddle_rit, int uplink)
+{
+    char conf[RIGCTLD_RIG_CONF_LEN];
+    struct rig_state *rs;
+    int retcode;
+
+    r->rig = rig_init(r->model);
+
+    if (!r->rig)
+    {
+        fprintf(stderr, "%s: unknown rig num %u, or initialization error.\n",
+                r->name, r->model);
+        return -RIG_EINVAL;
+    }
+
+    SNPRINTF(conf, sizeof(conf), "%s", r->set_conf);
+    retcode = set_conf_list(r->rig, conf);
+
+    if (retcode != RIG_OK)
+    {
+        fprintf(stderr, "%s: config parameter error: %s\n", r->name,
+                rigerror(retcode));
+        return retcode;
+    }
+
+    if (r->rig_file[0])
+    {
+        rig_set_conf(r->rig, TOK_PATHNAME, r->rig_file);
+    }
+
+    if (r->serial_speed != 0)
+    {
+        RIGPORT(r->rig)->parm.serial.rate = r->serial_speed;
+    }
+
+    rs = STATE(r->rig);
+    rs->twiddle_timeout = twiddle_timeout;
+    rs->twiddle_rit = twiddle_rit;
+    rs->uplink = uplink;
+
+    if (skip_open)
+    {
+        return RIG_OK;
+    }
+
+    retcode = rig_open(r->rig);
+    r->opened = retcode == RIG_OK ? 1 : 0;
+
+    if (retcode != RIG_OK)
+    {
+        fprintf(stderr, "%s: rig_open: error = %s %s\n", r->name,
+                rigerror(retcode), r->rig_file);
+    }
+    else if (verbose > RIG_DEBUG_ERR)
+    {
+        printf("Opened rig %s, model %u, '%s'\n", r->name,
+               r->rig->caps->rig_model, r->rig->caps->model_name);
+    }
+
+    return RIG_OK;
+}
+
+
+/* Listening socket for a rig with a port of its own; -1 on error */
+static int listen_rig_port(const char *addr, const char *port)
+{
+    struct addrinfo hints, *result, *ai;
+    int sock = -1;
+    int retcode;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    retcode = getaddrinfo(addr, port, &hints, &result);
+
+    if (retcode != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: getaddrinfo: %s\n", __func__,
+                  gai_strerror(retcode));
+        return -1;
+    }
+
+    for (ai = result; ai; ai = ai->ai_next)
+    {
+        const int optval = 1;
+
+        sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+        if (sock < 0)
+        {
+            continue;
+        }
+
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const void *)&optval,
+                   sizeof(optval));
+
+        if (bind(sock, ai->ai_addr, ai->ai_addrlen) == 0 && listen(sock, 4) == 0)
+        {
+            break;
+        }
+
+        handle_error(RIG_DEBUG_ERR, "binding rig port");
+#ifdef __MINGW32__
+        closesocket(sock);
+#else
+        close(sock);
+#endif
+        sock = -1;
+    }
+
+    freeaddrinfo(result);
+
+    return sock;
+}
+
+
+#ifdef HAVE_SYS_UN_H
+/* Listening socket at a filesystem path for --unix-socket; -1 on error.
+ * A stale socket left by an earlier run is replaced. */
+static int listen_unix(const char *path)
+{
+    struct sockaddr_un addr;
+    int sock;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "unix-socket: path too long: %s\n", path);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (sock < 0)
+    {
+        handle_error(RIG_DEBUG_ERR, "unix socket");
+        return -1;
+    }
+
+    unlink(path);
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0
+            || listen(sock, 4) < 0)
+    {
+        handle_error(RIG_DEBUG_ERR, "binding unix socket");
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+#endif
+
+
+/* Printable client address for the connection log */
+static void peer_name(const struct handle_data *h, char *host, size_t hostlen,
+                      char *serv, size_t servlen)
+{
+    int retcode;
+
+#ifdef HAVE_SYS_UN_H
+
+    if (h->cli_addr.ss_family == AF_UNIX)
+    {
+        SNPRINTF(host, hostlen, "%s", "unix");
+        SNPRINTF(serv, servlen, "%d", h->sock);
+        return;
+    }
+
+#endif
+
+    retcode = getnameinfo((struct sockaddr const *)&h->cli_addr, h->clilen,
+                          host, hostlen, serv, servlen,
+                          NI_NUMERICHOST | NI_NUMERICSERV);
+
+    if (retcode != 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "Peer lookup error: %s", gai_strerror(retcode));
+        SNPRINTF(host, hostlen, "%s", "?");
+        SNPRINTF(serv, servlen, "%s", "?");
+    }
+}
+
 int main(int argc, char *argv[])
 {
     rig_model_t my_model = RIG_MODEL_DUMMY;
@@ -262,6 +583,9 @@ int main(int argc, char *argv[])
     int serial_rate = 0;
     const char *civaddr = NULL;   /* NULL means no need to set conf */
     char conf_parms[MAXCONFLEN] = "";
+    const char *rigs_file = NULL;
+    const char *unix_socket = NULL;
+    int sock_unix = -1;
 
     struct addrinfo hints, *result, *saved_result;
     int sock_listen;
@@ -300,6 +624,8 @@ int main(int argc, char *argv[])
 
     rig_set_debug(verbose);
 
+    rigctld_sched_init(&g_sched);
+
     while (1)
     {
         int c;
@@ -456,6 +782,24 @@ int main(int argc, char *argv[])
 
             break;
 
+        case 1008:
+            rigs_file = optarg;
+            break;
+
+        case 1009:
+            unix_socket = optarg;
+            break;
+
+        case 1010:
+            if (rigctld_sched_parse_rates(&g_sched, optarg) < 0)
+            {
+                fprintf(stderr, "rate-limit must be READS[,WRITES], 0-%d commands/s\n",
+                        RIGCTLD_RATE_MAX);
+                exit(1);
+            }
+
+            break;
+
         case 'm':
             my_model = atoi(optarg);
             break;
@@ -683,6 +1027,30 @@ int main(int argc, char *argv[])
     rig_debug(RIG_DEBUG_VERBOSE, "Max# of rigctld client services=%d\n",
               NI_MAXSERV);
 
+    if (rigs_file)
+    {
+        char err[256];
+        const struct rigctld_rig *first;
+
+        if (rigctld_rigs_load(&g_rig_table, rigs_file, err, sizeof(err)) < 0)
+        {
+            fprintf(stderr, "rigs-file: %s\n", err);
+            exit(1);
+        }
+
+        for (i = 0; i < g_rig_table.count; i++)
+        {
+            rigctld_fair_lock_init(&g_rig_table.rigs[i].lock);
+        }
+
+        /* The first rig takes the place of the command line rig */
+        first = &g_rig_table.rigs[0];
+        my_model = first->model;
+        rig_file = first->rig_file[0] ? first->rig_file : NULL;
+        serial_rate = first->serial_speed;
+        SNPRINTF(conf_parms, sizeof(conf_parms), "%s", first->set_conf);
+    }
+
     my_rig = rig_init(my_model);
 
     if (!my_rig)
@@ -696,36 +1064,18 @@ int main(int argc, char *argv[])
     }
 
     my_rig->caps->ptt_type = ptt_type;
-    const char *token = strtok(conf_parms, ",");
     struct rig_state *rs = STATE(my_rig);
 
-    while (token)
-    {
-        char mytoken[100], myvalue[100];
-        hamlib_token_t lookup;
-        sscanf(token, "%99[^=]=%99s", mytoken, myvalue);
-        //printf("mytoken=%s,myvalue=%s\n",mytoken, myvalue);
-        lookup = rig_token_lookup(my_rig, mytoken);
+    retcode = set_conf_list(my_rig, conf_parms);
 
-        if (lookup == 0)
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: no such token as '%s'\n", __func__, mytoken);
-            token = strtok(NULL, ",");
-            continue;
-        }
-
-        retcode = rig_set_conf(my_rig, lookup, myvalue);
-
-        if (retcode != RIG_OK)
-        {
-            fprintf(stderr, "Config parameter error: %s\n", rigerror(retcode));
-            exit(2);
-        }
-
-        token = strtok(NULL, ",");
-        ptt_type = my_rig->caps->ptt_type; // in case we set the ptt_type with set_conf
+    if (retcode != RIG_OK)
+    {
+        fprintf(stderr, "Config parameter error: %s\n", rigerror(retcode));
+        exit(2);
     }
 
+    ptt_type = my_rig->caps->ptt_type; // in case we set the ptt_type with set_conf
+
     if (rig_file)
     {
         rig_set_conf(my_rig, TOK_PATHNAME, rig_file);
@@ -869,6 +1219,22 @@ int main(int argc, char *argv[])
     rig_debug(RIG_DEBUG_VERBOSE, "Stream source ID: %d\n",
               g_stream_registry.source_id);
 
+    /* \subscribe: a single notifier polls the rig for every subscriber.
+     * Transceive events wake it early so async rigs push without waiting
+     * out a full interval. */
+    rigctld_notify_registry_init(&g_notify_registry);
+
+    if (rigctld_notify_start(&g_notify_registry, my_rig, notify_sync,
+                             g_rig_table.count ? &g_rig_table.rigs[0] : NULL) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: change notifier not started\n", __func__);
+    }
+
+    rig_set_freq_callback(my_rig, notify_freq_event, &g_notify_registry);
+    rig_set_mode_callback(my_rig, notify_mode_event, &g_notify_registry);
+    rig_set_vfo_callback(my_rig, notify_vfo_event, &g_notify_registry);
+    rig_set_ptt_callback(my_rig, notify_ptt_event, &g_notify_registry);
+
     /* Rig-level staleness-watchdog defaults; per-stream \stream_open
      * key=value overrides take precedence (resolved at stream open). */
     STATE(my_rig)->stream_time_stale_coarse_ms =
@@ -876,6 +1242,35 @@ int main(int argc, char *argv[])
     STATE(my_rig)->stream_time_stale_invalidate_ms =
         (unsigned int)stream_time_stale_invalidate;
 
+    /* The other rigs of a rigs file, each with its own lock and notifier */
+    for (i = 1; i < g_rig_table.count; i++)
+    {
+        struct rigctld_rig *r = &g_rig_table.rigs[i];
+
+        if (setup_table_rig(r, twiddle_timeout, twiddle_rit, uplink) != RIG_OK)
+        {
+            exit(2);
+        }
+
+        STATE(r->rig)->stream_time_stale_coarse_ms =
+            (unsigned int)stream_time_stale_coarse;
+        STATE(r->rig)->stream_time_stale_invalidate_ms =
+            (unsigned int)stream_time_stale_invalidate;
+
+        rigctld_notify_registry_init(&r->notify);
+
+        if (rigctld_notify_start(&r->notify, r->rig, notify_sync, r) != 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: change notifier for %s not started\n",
+                      __func__, r->name);
+        }
+
+        rig_set_freq_callback(r->rig, notify_freq_event, &r->notify);
+        rig_set_mode_callback(r->rig, notify_mode_event, &r->notify);
+        rig_set_vfo_callback(r->rig, notify_vfo_event, &r->notify);
+        rig_set_ptt_callback(r->rig, notify_ptt_event, &r->notify);
+    }
+
     // Normally we keep the rig open to speed up the 1st client connect
     // But some rigs like the FT-736 have to lock the rig for CAT control
     // So they need to release the rig when no clients are connected
@@ -1068,6 +1463,45 @@ int main(int argc, char *argv[])
         exit(1);
     }
 
+    if (unix_socket)
+    {
+#ifdef HAVE_SYS_UN_H
+        sock_unix = listen_unix(unix_socket);
+
+        if (sock_unix < 0)
+        {
+            exit(1);
+        }
+
+#else
+        fprintf(stderr, "unix-socket: not supported on this host\n");
+        exit(1);
+#endif
+    }
+
+    /* Rigs with a port of their own; the shared port reaches the first rig */
+    for (i = 0; i < g_rig_table.count; i++)
+    {
+        struct rigctld_rig *r = &g_rig_table.rigs[i];
+
+        if (i == 0)
+        {
+            r->rig = my_rig;
+            r->opened = rig_opened;
+        }
+
+        if (r->port[0])
+        {
+            r->sock_listen = listen_rig_port(src_addr, r->port);
+
+            if (r->sock_listen < 0)
+            {
+                fprintf(stderr, "%s: cannot listen on port %s\n", r->name, r->port);
+                exit(1);
+            }
+        }
+    }
+
 #if HAVE_SIGACTION
 
 #ifdef SIGPIPE
@@ -1151,13 +1585,54 @@ int main(int argc, char *argv[])
     {
         fd_set set;
         struct timeval timeout;
+        int sock_max = sock_listen;
+        int sock_ready = sock_listen;
+        struct rigctld_rig *route = g_rig_table.count ? &g_rig_table.rigs[0] : NULL;
 
         /* use select to allow for periodic checks for CTRL+C */
         FD_ZERO(&set);
         FD_SET(sock_listen, &set);
+
+        if (sock_unix >= 0)
+        {
+            FD_SET(sock_unix, &set);
+            sock_max = sock_unix > sock_max ? sock_unix : sock_max;
+        }
+
+        for (i = 0; i < g_rig_table.count; i++)
+        {
+            if (g_rig_table.rigs[i].sock_listen >= 0)
+            {
+                FD_SET(g_rig_table.rigs[i].sock_listen, &set);
+
+                if (g_rig_table.rigs[i].sock_listen > sock_max)
+                {
+                    sock_max = g_rig_table.rigs[i].sock_listen;
+                }
+            }
+        }
+
         timeout.tv_sec = 5;
         timeout.tv_usec = 0;
-        retcode = select(sock_listen + 1, &set, NULL, NULL, &timeout);
+        retcode = select(sock_max + 1, &set, NULL, NULL, &timeout);
+
+        if (retcode > 0 && sock_unix >= 0 && FD_ISSET(sock_unix, &set))
+        {
+            sock_ready = sock_unix;
+        }
+        else if (retcode > 0 && !FD_ISSET(sock_listen, &set))
+        {
+            for (i = 0; i < g_rig_table.count; i++)
+            {
+                if (g_rig_table.rigs[i].sock_listen >= 0
+                        && FD_ISSET(g_rig_table.rigs[i].sock_listen, &set))
+                {
+                    sock_ready = g_rig_table.rigs[i].sock_listen;
+                    route = &g_rig_table.rigs[i];
+                    break;
+                }
+            }
+        }
 
         if (retcode == -1)
         {
@@ -1200,10 +1675,12 @@ int main(int argc, char *argv[])
 
             if (rigctld_password[0] != 0) { arg->use_password = 1; }
 
-            arg->rig = my_rig;
+            arg->rig = route ? route->rig : my_rig;
+            arg->active = route;
+            arg->selected = route;
             arg->clilen = sizeof(arg->cli_addr);
             arg->vfo_mode = vfo_mode;
-            arg->sock = accept(sock_listen,
+            arg->sock = accept(sock_ready,
                                (struct sockaddr *)&arg->cli_addr,
                                &arg->clilen);
 
@@ -1214,19 +1691,7 @@ int main(int argc, char *argv[])
                 break;
             }
 
-            if ((retcode = getnameinfo((struct sockaddr const *)&arg->cli_addr,
-                                       arg->clilen,
-                                       host,
-                                       sizeof(host),
-                                       serv,
-                                       sizeof(serv),
-                                       NI_NUMERICHOST | NI_NUMERICSERV))
-                    < 0)
-            {
-                rig_debug(RIG_DEBUG_WARN,
-                          "Peer lookup error: %s",
-                          gai_strerror(retcode));
-            }
+            peer_name(arg, host, sizeof(host), serv, sizeof(serv));
 
             if (client_count >= RIGCTLD_MAX_CLIENTS)
             {
@@ -1262,8 +1727,16 @@ int main(int argc, char *argv[])
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: while loop done\n", __func__);
 
+    /* The notifier takes the client lock to push, so stop it first */
+    rigctld_notify_registry_destroy(&g_notify_registry);
+
+    for (i = 1; i < g_rig_table.count; i++)
+    {
+        rigctld_notify_registry_destroy(&g_rig_table.rigs[i].notify);
+    }
+
     /* allow threads to finish current action */
-    mutex_rigctld(1);
+    notify_sync(1, g_rig_table.count ? &g_rig_table.rigs[0] : NULL);
 
     if (client_count)
     {
@@ -1275,8 +1748,37 @@ int main(int argc, char *argv[])
 #else
     close(sock_listen);
 #endif
+
+    if (sock_unix >= 0)
+    {
+        close(sock_unix);
+        unlink(unix_socket);
+    }
+
     rig_close(my_rig);
-    mutex_rigctld(0);
+    notify_sync(0, g_rig_table.count ? &g_rig_table.rigs[0] : NULL);
+
+    for (i = 0; i < g_rig_table.count; i++)
+    {
+        struct rigctld_rig *r = &g_rig_table.rigs[i];
+
+        if (r->sock_listen >= 0)
+        {
+#ifdef __MINGW__
+            closesocket(r->sock_listen);
+#else
+            close(r->sock_listen);
+#endif
+        }
+
+        if (i > 0)
+        {
+            rigctld_fair_lock_acquire(&r->lock, RIGCTLD_CLASS_CONTROL);
+            rig_close(r->rig);
+            rigctld_fair_lock_release(&r->lock);
+            rig_cleanup(r->rig);
+        }
+    }
 
     rigctld_stream_registry_destroy(&g_stream_registry);
     rig_cleanup(my_rig); /* if you care about memory */
@@ -1331,6 +1833,9 @@ void *handle_socket(void *arg)
     char my_resp_sep = resp_sep;  // Separator for this connection, initial default
     rig_powerstat = RIG_POWER_ON; // defaults to power on
     struct timespec powerstat_check_time;
+    RIG *rig = handle_data_arg->rig;
+    HAMLIB_ATOMIC int *opened = handle_data_arg->active ?
+                                &handle_data_arg->active->opened : &rig_opened;
 
     fsockin = get_fsockin(handle_data_arg);
 
@@ -1364,6 +1869,14 @@ void *handle_socket(void *arg)
     int my_client_id = handle_data_arg->client_id;
     rigctld_client_id_set(my_client_id);
 
+    {
+        char peer[sizeof(host) + sizeof(serv) + 1];
+
+        peer_name(handle_data_arg, host, sizeof(host), serv, sizeof(serv));
+        snprintf(peer, sizeof(peer), "%s:%s", host, serv);
+        handle_data_arg->sched = rigctld_sched_attach(&g_sched, my_client_id, peer);
+    }
+
     mutex_rigctld(1);
 
     ++client_count;
@@ -1385,31 +1898,40 @@ void *handle_socket(void *arg)
 
     mutex_rigctld(0);
 
-    if (my_rig->caps->get_powerstat)
+    if (rig->caps->get_powerstat)
     {
         mutex_rigctld(1);
-        rig_get_powerstat(my_rig, &rig_powerstat);
+        rig_get_powerstat(rig, &rig_powerstat);
         mutex_rigctld(0);
-        STATE(my_rig)->powerstat = rig_powerstat;
+        STATE(rig)->powerstat = rig_powerstat;
     }
 
     elapsed_ms(&powerstat_check_time, HAMLIB_ELAPSED_SET);
 
     do
     {
+        /* \rig_select takes effect between commands */
+        if (handle_data_arg->selected != handle_data_arg->active)
+        {
+            handle_data_arg->active = handle_data_arg->selected;
+            handle_data_arg->rig = handle_data_arg->active->rig;
+            rig = handle_data_arg->rig;
+            opened = &handle_data_arg->active->opened;
+        }
+
         mutex_rigctld(1);
 
-        if (!rig_opened)
+        if (!*opened)
         {
-            retcode = rig_open(my_rig);
-            rig_opened = retcode == RIG_OK ? 1 : 0;
+            retcode = rig_open(rig);
+            *opened = retcode == RIG_OK ? 1 : 0;
             rig_debug(RIG_DEBUG_ERR, "%s: rig_open reopened retcode=%d\n", __func__,
                       retcode);
         }
 
         mutex_rigctld(0);
 
-        if (rig_opened) // only do this if rig is open
+        if (*opened) // only do this if rig is open
         {
             rig_debug(RIG_DEBUG_TRACE, "%s: doing rigctl_parse vfo_mode=%d, secure=%d\n",
                       __func__,
@@ -1424,12 +1946,12 @@ void *handle_socket(void *arg)
             // If we get a timeout, the rig might be powered off
             // Update our power status in case power gets turned off
             // Check power status if rig is powered off, but not more often than once per second
-            if (my_rig->caps->get_powerstat && (retcode == -RIG_ETIMEOUT ||
+            if (rig->caps->get_powerstat && (retcode == -RIG_ETIMEOUT ||
                                                 (retcode == -RIG_EPOWER
                                                  && elapsed_ms(&powerstat_check_time, HAMLIB_ELAPSED_GET) >= 1000)))
             {
                 powerstat_t powerstat;
-                rig_get_powerstat(my_rig, &powerstat);
+                rig_get_powerstat(rig, &powerstat);
                 rig_powerstat = powerstat;
 
                 if (powerstat == RIG_POWER_OFF || powerstat == RIG_POWER_STANDBY)
@@ -1455,8 +1977,8 @@ void *handle_socket(void *arg)
             do
             {
                 mutex_rigctld(1);
-                retcode = rig_close(my_rig);
-                rig_opened = 0;
+                retcode = rig_close(rig);
+                *opened = 0;
                 mutex_rigctld(0);
                 rig_debug(RIG_DEBUG_ERR, "%s: rig_close retcode=%d\n", __func__, retcode);
 
@@ -1464,17 +1986,17 @@ void *handle_socket(void *arg)
 
                 mutex_rigctld(1);
 
-                if (!rig_opened)
+                if (!*opened)
                 {
-                    retcode = rig_open(my_rig);
-                    rig_opened = retcode == RIG_OK ? 1 : 0;
+                    retcode = rig_open(rig);
+                    *opened = retcode == RIG_OK ? 1 : 0;
                     rig_debug(RIG_DEBUG_ERR, "%s: rig_open retcode=%d, opened=%d\n", __func__,
-                              retcode, rig_opened);
+                              retcode, *opened);
                 }
 
                 mutex_rigctld(0);
             }
-            while (!ctrl_c && !rig_opened && retry-- > 0 && retcode != RIG_OK);
+            while (!ctrl_c && !*opened && retry-- > 0 && retcode != RIG_OK);
         }
     }
     while (!ctrl_c && (retcode == RIG_OK || RIG_IS_SOFT_ERRCODE(retcode)));
@@ -1483,9 +2005,9 @@ void *handle_socket(void *arg)
 
     if (rigctld_idle && client_count == 1)
     {
-        rig_close(my_rig);
+        rig_close(rig);
 
-        if (verbose > RIG_DEBUG_ERR) { printf("Closed rig model %s.  Will reopen for new clients\n", my_rig->caps->model_name); }
+        if (verbose > RIG_DEBUG_ERR) { printf("Closed rig model %s.  Will reopen for new clients\n", rig->caps->model_name); }
     }
 
     --client_count;
@@ -1512,18 +2034,7 @@ void *handle_socket(void *arg)
     mutex_rigctld(0);
 #endif
 
-    if ((retcode = getnameinfo((struct sockaddr const *)&handle_data_arg->cli_addr,
-                               handle_data_arg->clilen,
-                               host,
-                               sizeof(host),
-                               serv,
-                               sizeof(serv),
-                               NI_NUMERICHOST | NI_NUMERICSERV))
-            < 0)
-    {
-
-        rig_debug(RIG_DEBUG_WARN, "Peer lookup error: %s", gai_strerror(retcode));
-    }
+    peer_name(handle_data_arg, host, sizeof(host), serv, sizeof(serv));
 
     rig_debug(RIG_DEBUG_VERBOSE,
               "Connection closed from %s:%s\n",
@@ -1531,6 +2042,17 @@ void *handle_socket(void *arg)
               serv);
 
     rigctld_stream_registry_close_by_client(&g_stream_registry, my_client_id);
+    /* Must precede the close below: the notifier writes to this socket */
+    {
+        struct rigctld_notify_registry *notify = rigctld_notify_registry_find(rig);
+
+        if (notify)
+        {
+            rigctld_notify_unsubscribe(notify, my_client_id);
+        }
+    }
+
+    rigctld_sched_detach(&g_sched, handle_data_arg->sched);
 
 handle_exit:
 
@@ -1612,6 +2134,13 @@ static void usage(FILE *fout)
             "      --stream-source-id=N      stream source ID stamped on every stream\n"
             "                                packet (0-65535; -1 = derive from static\n"
             "                                configuration, the default; 0 = unset)\n"
+            "      --rigs-file=FILE          serve the rigs listed in FILE instead of the\n"
+            "                                -m/-r/-s/-C rig; see \\rig_select\n"
+            "      --unix-socket=PATH        also listen on a Unix domain socket at PATH\n"
+            "      --rate-limit=READS[,WRITES]\n"
+            "                                limit each client to READS read and WRITES\n"
+            "                                write commands per second (0 = unlimited,\n"
+            "                                the default); see \\client_stats\n"
             "  -h, --help                    display this help and exit\n"
             "  -V, --version                 output version information and exit\n\n",
             portno,
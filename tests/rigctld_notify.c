@@ -0,0 +1,956 @@
+/*
+ *  Hamlib rigctld change subscriptions
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Server-push change notifications for rigctld (\subscribe). */
+/* Rig polling is shared: N subscribers cost one query per item per tick. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "rigctld_notify.h"
+#include "hamlib/rig_state.h"
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef HAVE_SYS_SOCKET_H
+#  include <sys/socket.h>
+#elif defined(HAVE_WS2TCPIP_H)
+#  include <ws2tcpip.h>
+#endif
+
+#ifndef MSG_DONTWAIT
+#  define MSG_DONTWAIT 0
+#endif
+
+#ifndef MSG_NOSIGNAL
+#  define MSG_NOSIGNAL 0
+#endif
+
+#ifndef SHUT_RDWR
+#  define SHUT_RDWR 2           /* SD_BOTH */
+#endif
+
+/* Global notify registry (initialized by rigctld main). */
+struct rigctld_notify_registry g_notify_registry;
+
+/* Every initialized registry, for rigctld_notify_registry_find() */
+static struct rigctld_notify_registry *notify_registries;
+static pthread_mutex_t notify_registries_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static const struct
+{
+    unsigned int bit;
+    const char *name;
+} notify_items[] =
+{
+    { RIGCTLD_NOTIFY_VFO,      "VFO" },
+    { RIGCTLD_NOTIFY_FREQ,     "FREQ" },
+    { RIGCTLD_NOTIFY_MODE,     "MODE" },
+    { RIGCTLD_NOTIFY_PTT,      "PTT" },
+    { RIGCTLD_NOTIFY_SPLIT,    "SPLIT" },
+    { RIGCTLD_NOTIFY_STRENGTH, "STRENGTH" },
+    { RIGCTLD_NOTIFY_SWR,      "SWR" },
+    { RIGCTLD_NOTIFY_AF,       "AF" },
+    { RIGCTLD_NOTIFY_RF,       "RF" },
+    { RIGCTLD_NOTIFY_SQL,      "SQL" },
+    { RIGCTLD_NOTIFY_RFPOWER,  "RFPOWER" },
+};
+
+#define NOTIFY_ITEM_COUNT (sizeof(notify_items) / sizeof(notify_items[0]))
+
+/* Float level items; index i is state->level[i]. */
+static const struct
+{
+    unsigned int bit;
+    setting_t level;
+    const char *key;
+} notify_levels[RIGCTLD_NOTIFY_LEVEL_COUNT] =
+{
+    { RIGCTLD_NOTIFY_AF,      RIG_LEVEL_AF,      "af" },
+    { RIGCTLD_NOTIFY_RF,      RIG_LEVEL_RF,      "rf" },
+    { RIGCTLD_NOTIFY_SQL,     RIG_LEVEL_SQL,     "sql" },
+    { RIGCTLD_NOTIFY_RFPOWER, RIG_LEVEL_RFPOWER, "rfpower" },
+};
+
+
+int64_t rigctld_notify_now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/* --- Argument parsing --- */
+
+static unsigned int notify_item_bit(const char *name, size_t len)
+{
+    size_t i;
+
+    if (len == 3 && strncasecmp(name, "ALL", 3) == 0)
+    {
+        return RIGCTLD_NOTIFY_ALL;
+    }
+
+    for (i = 0; i < NOTIFY_ITEM_COUNT; i++)
+    {
+        if (strlen(notify_items[i].name) == len
+                && strncasecmp(name, notify_items[i].name, len) == 0)
+        {
+            return notify_items[i].bit;
+        }
+    }
+
+    return 0;
+}
+
+
+int rigctld_notify_parse_args(const char *line, unsigned int *items,
+                              int *interval_ms, int *deadband)
+{
+    const char *p = line;
+    const char *end;
+    char *num_end;
+    long v;
+
+    if (!line || !items || !interval_ms || !deadband)
+    {
+        return -1;
+    }
+
+    *items = 0;
+    *interval_ms = RIGCTLD_NOTIFY_INTERVAL_DEFAULT;
+    *deadband = 0;
+
+    while (*p == ' ') { p++; }
+
+    end = p + strcspn(p, " \t\r\n");
+
+    if (end == p)
+    {
+        return -1;
+    }
+
+    /* Item list: NAME[,NAME...] */
+    while (p < end)
+    {
+        const char *comma = memchr(p, ',', end - p);
+        const char *tok_end = comma ? comma : end;
+        unsigned int bit = notify_item_bit(p, tok_end - p);
+
+        if (bit == 0)
+        {
+            return -1;
+        }
+
+        *items |= bit;
+        p = comma ? comma + 1 : end;
+    }
+
+    /* Optional interval */
+    while (*p == ' ' || *p == '\t') { p++; }
+
+    if (*p == '\0' || *p == '\r' || *p == '\n')
+    {
+        return 0;
+    }
+
+    v = strtol(p, &num_end, 10);
+
+    if (num_end == p || v < 0)
+    {
+        return -1;
+    }
+
+    if (v < RIGCTLD_NOTIFY_INTERVAL_MIN) { v = RIGCTLD_NOTIFY_INTERVAL_MIN; }
+
+    if (v > RIGCTLD_NOTIFY_INTERVAL_MAX) { v = RIGCTLD_NOTIFY_INTERVAL_MAX; }
+
+    *interval_ms = (int)v;
+    p = num_end;
+
+    /* Optional STRENGTH deadband */
+    while (*p == ' ' || *p == '\t') { p++; }
+
+    if (*p == '\0' || *p == '\r' || *p == '\n')
+    {
+        return 0;
+    }
+
+    v = strtol(p, &num_end, 10);
+
+    if (num_end == p || v < 0 || v > 100)
+    {
+        return -1;
+    }
+
+    *deadband = (int)v;
+    p = num_end;
+
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') { p++; }
+
+    return *p == '\0' ? 0 : -1;
+}
+
+
+void rigctld_notify_items_str(unsigned int items, char *buf, size_t size)
+{
+    size_t i;
+    size_t len = 0;
+
+    if (size == 0)
+    {
+        return;
+    }
+
+    buf[0] = '\0';
+
+    for (i = 0; i < NOTIFY_ITEM_COUNT; i++)
+    {
+        if (items & notify_items[i].bit)
+        {
+            int n = snprintf(buf + len, size - len, "%s%s",
+                             len ? "," : "", notify_items[i].name);
+
+            if (n < 0 || (size_t)n >= size - len)
+            {
+                return;
+            }
+
+            len += n;
+        }
+    }
+}
+
+
+/* --- Registry --- */
+
+int rigctld_notify_registry_init(struct rigctld_notify_registry *reg)
+{
+    memset(reg, 0, sizeof(*reg));
+
+    if (pthread_mutex_init(&reg->lock, NULL) != 0)
+    {
+        return -1;
+    }
+
+    if (pthread_mutex_init(&reg->wake_lock, NULL) != 0)
+    {
+        pthread_mutex_destroy(&reg->lock);
+        return -1;
+    }
+
+    if (pthread_cond_init(&reg->wake_cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&reg->wake_lock);
+        pthread_mutex_destroy(&reg->lock);
+        return -1;
+    }
+
+    reg->initialized = 1;
+
+    pthread_mutex_lock(&notify_registries_lock);
+    reg->next = notify_registries;
+    notify_registries = reg;
+    pthread_mutex_unlock(&notify_registries_lock);
+
+    return 0;
+}
+
+
+struct rigctld_notify_registry *rigctld_notify_registry_find(RIG *rig)
+{
+    struct rigctld_notify_registry *reg;
+
+    pthread_mutex_lock(&notify_registries_lock);
+
+    for (reg = notify_registries; reg; reg = reg->next)
+    {
+        if (reg->rig == rig)
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&notify_registries_lock);
+
+    return reg;
+}
+
+
+void rigctld_notify_registry_destroy(struct rigctld_notify_registry *reg)
+{
+    int i;
+
+    struct rigctld_notify_registry **pp;
+
+    if (!reg->initialized)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&notify_registries_lock);
+
+    for (pp = &notify_registries; *pp; pp = &(*pp)->next)
+    {
+        if (*pp == reg)
+        {
+            *pp = reg->next;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&notify_registries_lock);
+
+    if (reg->thread_started)
+    {
+        reg->running = 0;
+        rigctld_notify_wake(reg);
+        pthread_join(reg->thread, NULL);
+        reg->thread_started = 0;
+    }
+
+    pthread_mutex_lock(&reg->lock);
+
+    for (i = 0; i < RIGCTLD_MAX_SUBSCRIBERS; i++)
+    {
+        free(reg->subs[i]);
+        reg->subs[i] = NULL;
+    }
+
+    pthread_mutex_unlock(&reg->lock);
+
+    pthread_cond_destroy(&reg->wake_cond);
+    pthread_mutex_destroy(&reg->wake_lock);
+    pthread_mutex_destroy(&reg->lock);
+    reg->initialized = 0;
+}
+
+
+int rigctld_notify_subscribe(struct rigctld_notify_registry *reg,
+                             int client_id, int sock, unsigned int items,
+                             int interval_ms, int deadband)
+{
+    struct rigctld_subscriber *sub = NULL;
+    int free_slot = -1;
+    int i;
+
+    pthread_mutex_lock(&reg->lock);
+
+    for (i = 0; i < RIGCTLD_MAX_SUBSCRIBERS; i++)
+    {
+        if (reg->subs[i] == NULL)
+        {
+            if (free_slot < 0) { free_slot = i; }
+        }
+        else if (reg->subs[i]->client_id == client_id)
+        {
+            sub = reg->subs[i];
+            break;
+        }
+    }
+
+    if (sub == NULL)
+    {
+        if (free_slot < 0 || (sub = calloc(1, sizeof(*sub))) == NULL)
+        {
+            pthread_mutex_unlock(&reg->lock);
+            return -RIG_ENOMEM;
+        }
+
+        reg->subs[free_slot] = sub;
+    }
+
+    /* A (re)subscribe starts from a clean slate: sent.valid == 0 makes the
+     * next push a full snapshot, and a zero last_check makes it due now. */
+    memset(sub, 0, sizeof(*sub));
+    sub->client_id = client_id;
+    sub->sock = sock;
+    sub->items = items & RIGCTLD_NOTIFY_ALL;
+    sub->interval_ms = interval_ms;
+    sub->deadband = deadband;
+
+    pthread_mutex_unlock(&reg->lock);
+
+    rigctld_notify_wake(reg);
+
+    return RIG_OK;
+}
+
+
+int rigctld_notify_unsubscribe(struct rigctld_notify_registry *reg,
+                               int client_id)
+{
+    int removed = 0;
+    int i;
+
+    if (!reg->initialized)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&reg->lock);
+
+    for (i = 0; i < RIGCTLD_MAX_SUBSCRIBERS; i++)
+    {
+        if (reg->subs[i] && reg->subs[i]->client_id == client_id)
+        {
+            free(reg->subs[i]);
+            reg->subs[i] = NULL;
+            removed = 1;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&reg->lock);
+
+    return removed;
+}
+
+
+int rigctld_notify_count(struct rigctld_notify_registry *reg)
+{
+    int count = 0;
+    int i;
+
+    pthread_mutex_lock(&reg->lock);
+
+    for (i = 0; i < RIGCTLD_MAX_SUBSCRIBERS; i++)
+    {
+        if (reg->subs[i]) { count++; }
+    }
+
+    pthread_mutex_unlock(&reg->lock);
+
+    return count;
+}
+
+
+/* --- State sampling, diff and formatting --- */
+
+void rigctld_notify_poll(RIG *rig, unsigned int items,
+                         struct rigctld_notify_state *state)
+{
+    value_t val;
+    int i;
+
+    memset(state, 0, sizeof(*state));
+
+    if (items & RIGCTLD_NOTIFY_VFO)
+    {
+        if (rig_get_vfo(rig, &state->vfo) != RIG_OK)
+        {
+            /* Rigs without get_vfo still track the selected VFO */
+            state->vfo = STATE(rig)->current_vfo;
+        }
+
+        state->valid |= RIGCTLD_NOTIFY_VFO;
+    }
+
+    if ((items & RIGCTLD_NOTIFY_FREQ)
+            && rig_get_freq(rig, RIG_VFO_CURR, &state->freq) == RIG_OK)
+    {
+        state->valid |= RIGCTLD_NOTIFY_FREQ;
+    }
+
+    if ((items & RIGCTLD_NOTIFY_MODE)
+            && rig_get_mode(rig, RIG_VFO_CURR, &state->mode,
+                            &state->width) == RIG_OK)
+    {
+        state->valid |= RIGCTLD_NOTIFY_MODE;
+    }
+
+    if ((items & RIGCTLD_NOTIFY_PTT)
+            && rig_get_ptt(rig, RIG_VFO_CURR, &state->ptt) == RIG_OK)
+    {
+        state->valid |= RIGCTLD_NOTIFY_PTT;
+    }
+
+    if ((items & RIGCTLD_NOTIFY_SPLIT)
+            && rig_get_split_vfo(rig, RIG_VFO_CURR, &state->split,
+                                 &state->tx_vfo) == RIG_OK)
+    {
+        state->valid |= RIGCTLD_NOTIFY_SPLIT;
+    }
+
+    if ((items & RIGCTLD_NOTIFY_STRENGTH)
+            && rig_has_get_level(rig, RIG_LEVEL_STRENGTH)
+            && rig_get_level(rig, RIG_VFO_CURR, RIG_LEVEL_STRENGTH,
+                             &val) == RIG_OK)
+    {
+        state->strength = val.i;
+        state->valid |= RIGCTLD_NOTIFY_STRENGTH;
+    }
+
+    if ((items & RIGCTLD_NOTIFY_SWR)
+            && rig_has_get_level(rig, RIG_LEVEL_SWR)
+            && rig_get_level(rig, RIG_VFO_CURR, RIG_LEVEL_SWR, &val) == RIG_OK)
+    {
+        state->swr = val.f;
+        state->valid |= RIGCTLD_NOTIFY_SWR;
+    }
+
+    for (i = 0; i < RIGCTLD_NOTIFY_LEVEL_COUNT; i++)
+    {
+        if ((items & notify_levels[i].bit)
+                && rig_has_get_level(rig, notify_levels[i].level)
+                && rig_get_level(rig, RIG_VFO_CURR, notify_levels[i].level,
+                                 &val) == RIG_OK)
+        {
+            state->level[i] = val.f;
+            state->valid |= notify_levels[i].bit;
+        }
+    }
+}
+
+
+unsigned int rigctld_notify_diff(const struct rigctld_subscriber *sub,
+                                 const struct rigctld_notify_state *state)
+{
+    const struct rigctld_notify_state *old = &sub->sent;
+    unsigned int candidates = sub->items & state->valid;
+    unsigned int changed = candidates & ~old->valid;
+    unsigned int known = candidates & old->valid;
+    int i;
+
+    if ((known & RIGCTLD_NOTIFY_VFO) && state->vfo != old->vfo)
+    {
+        changed |= RIGCTLD_NOTIFY_VFO;
+    }
+
+    if ((known & RIGCTLD_NOTIFY_FREQ) && state->freq != old->freq)
+    {
+        changed |= RIGCTLD_NOTIFY_FREQ;
+    }
+
+    if ((known & RIGCTLD_NOTIFY_MODE)
+            && (state->mode != old->mode || state->width != old->width))
+    {
+        changed |= RIGCTLD_NOTIFY_MODE;
+    }
+
+    if ((known & RIGCTLD_NOTIFY_PTT) && state->ptt != old->ptt)
+    {
+        changed |= RIGCTLD_NOTIFY_PTT;
+    }
+
+    if ((known & RIGCTLD_NOTIFY_SPLIT)
+            && (state->split != old->split || state->tx_vfo != old->tx_vfo))
+    {
+        changed |= RIGCTLD_NOTIFY_SPLIT;
+    }
+
+    if ((known & RIGCTLD_NOTIFY_STRENGTH)
+            && abs(state->strength - old->strength) > sub->deadband)
+    {
+        changed |= RIGCTLD_NOTIFY_STRENGTH;
+    }
+
+    if ((known & RIGCTLD_NOTIFY_SWR) && state->swr != old->swr)
+    {
+        changed |= RIGCTLD_NOTIFY_SWR;
+    }
+
+    for (i = 0; i < RIGCTLD_NOTIFY_LEVEL_COUNT; i++)
+    {
+        if ((known & notify_levels[i].bit)
+                && state->level[i] != old->level[i])
+        {
+            changed |= notify_levels[i].bit;
+        }
+    }
+
+    /* A new VFO is sent with everything else: left out, an item that equals
+     * the old VFO's would look to the subscriber like one not yet known */
+    if (changed & RIGCTLD_NOTIFY_VFO)
+    {
+        changed |= candidates;
+    }
+
+    return changed;
+}
+
+
+int rigctld_notify_format(unsigned int changed,
+                          const struct rigctld_notify_state *state,
+                          char *buf, size_t size)
+{
+    size_t len;
+    int n;
+    int i;
+
+#define NOTIFY_APPEND(...) \
+    do { \
+        n = snprintf(buf + len, size - len, __VA_ARGS__); \
+        if (n < 0 || (size_t)n >= size - len) { return -1; } \
+        len += n; \
+    } while (0)
+
+    if (size == 0)
+    {
+        return -1;
+    }
+
+    len = 0;
+    NOTIFY_APPEND("%s", RIGCTLD_NOTIFY_PREFIX);
+
+    if (changed & RIGCTLD_NOTIFY_VFO)
+    {
+        NOTIFY_APPEND(" vfo=%s", rig_strvfo(state->vfo));
+    }
+
+    if (changed & RIGCTLD_NOTIFY_FREQ)
+    {
+        NOTIFY_APPEND(" freq=%.0f", state->freq);
+    }
+
+    if (changed & RIGCTLD_NOTIFY_MODE)
+    {
+        NOTIFY_APPEND(" mode=%s width=%ld", rig_strrmode(state->mode),
+                      (long)state->width);
+    }
+
+    if (changed & RIGCTLD_NOTIFY_PTT)
+    {
+        NOTIFY_APPEND(" ptt=%d", (int)state->ptt);
+    }
+
+    if (changed & RIGCTLD_NOTIFY_SPLIT)
+    {
+        NOTIFY_APPEND(" split=%d txvfo=%s", (int)state->split,
+                      rig_strvfo(state->tx_vfo));
+    }
+
+    if (changed & RIGCTLD_NOTIFY_STRENGTH)
+    {
+        NOTIFY_APPEND(" strength=%d", state->strength);
+    }
+
+    if (changed & RIGCTLD_NOTIFY_SWR)
+    {
+        NOTIFY_APPEND(" swr=%.2f", state->swr);
+    }
+
+    for (i = 0; i < RIGCTLD_NOTIFY_LEVEL_COUNT; i++)
+    {
+        if (changed & notify_levels[i].bit)
+        {
+            NOTIFY_APPEND(" %s=%g", notify_levels[i].key,
+                          (double)state->level[i]);
+        }
+    }
+
+    NOTIFY_APPEND("\n");
+
+#undef NOTIFY_APPEND
+
+    return (int)len;
+}
+
+
+/* Copy the changed items of *state into what the subscriber has seen. */
+static void notify_mark_sent(struct rigctld_subscriber *sub, unsigned int changed,
+                             const struct rigctld_notify_state *state)
+{
+    struct rigctld_notify_state *old = &sub->sent;
+    int i;
+
+    if (changed & RIGCTLD_NOTIFY_VFO) { old->vfo = state->vfo; }
+
+    if (changed & RIGCTLD_NOTIFY_FREQ) { old->freq = state->freq; }
+
+    if (changed & RIGCTLD_NOTIFY_MODE)
+    {
+        old->mode = state->mode;
+        old->width = state->width;
+    }
+
+    if (changed & RIGCTLD_NOTIFY_PTT) { old->ptt = state->ptt; }
+
+    if (changed & RIGCTLD_NOTIFY_SPLIT)
+    {
+        old->split = state->split;
+        old->tx_vfo = state->tx_vfo;
+    }
+
+    if (changed & RIGCTLD_NOTIFY_STRENGTH) { old->strength = state->strength; }
+
+    if (changed & RIGCTLD_NOTIFY_SWR) { old->swr = state->swr; }
+
+    for (i = 0; i < RIGCTLD_NOTIFY_LEVEL_COUNT; i++)
+    {
+        if (changed & notify_levels[i].bit) { old->level[i] = state->level[i]; }
+    }
+
+    old->valid |= changed;
+}
+
+
+/* Send one whole line.  A client that is not reading must not stall the
+ * notifier (which holds the reply lock), so no attempt blocks: on a full
+ * socket buffer the push is dropped and, since the subscriber's sent state
+ * is left untouched, retried on its next interval.  A line cut short
+ * cannot be finished later without a command reply landing in its middle,
+ * so that client's connection is shut down instead.
+ * Returns 0 when sent, 1 when dropped, 2 when cut short, -1 on a socket
+ * error. */
+static int notify_send_line(int sock, const char *line, int len)
+{
+    int off = 0;
+
+    while (off < len)
+    {
+        ssize_t n = send(sock, line + off, len - off,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (n < 0)
+        {
+            if (errno == EINTR) { continue; }
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return off == 0 ? 1 : 2;
+            }
+
+            return -1;
+        }
+
+        off += (int)n;
+    }
+
+    return 0;
+}
+
+
+/* Subscriber is due for a state check: its interval elapsed since the last
+ * check, or an event woke the notifier and its rate limit allows a push. */
+static int notify_sub_due(const struct rigctld_subscriber *sub, int64_t now_ms,
+                          int woken)
+{
+    if (now_ms - sub->last_check_ms >= sub->interval_ms)
+    {
+        return 1;
+    }
+
+    return woken && now_ms - sub->last_push_ms >= sub->interval_ms;
+}
+
+
+int rigctld_notify_tick(struct rigctld_notify_registry *reg, int64_t now_ms)
+{
+    struct rigctld_notify_state state;
+    unsigned int poll_items = 0;
+    int64_t next_ms = now_ms + RIGCTLD_NOTIFY_INTERVAL_MAX;
+    int woken = reg->wake_pending;
+    int i;
+
+    reg->wake_pending = 0;
+
+    /* Pass 1: union of the items due subscribers need */
+    pthread_mutex_lock(&reg->lock);
+
+    for (i = 0; i < RIGCTLD_MAX_SUBSCRIBERS; i++)
+    {
+        const struct rigctld_subscriber *sub = reg->subs[i];
+
+        if (sub && notify_sub_due(sub, now_ms, woken))
+        {
+            poll_items |= sub->items;
+        }
+    }
+
+    pthread_mutex_unlock(&reg->lock);
+
+    if (poll_items != 0)
+    {
+        /* One rig query per item serves every subscriber.  No registry lock
+         * is held here: rig I/O can be slow and the rig API locks itself. */
+        rigctld_notify_poll(reg->rig, poll_items, &state);
+    }
+
+    /* Pass 2: diff and push.  Taking the reply lock first keeps a pushed
+     * line from landing in the middle of a command reply. */
+    if (poll_items != 0 && reg->sync_cb) { reg->sync_cb(1, reg->sync_arg); }
+
+    pthread_mutex_lock(&reg->lock);
+
+    for (i = 0; i < RIGCTLD_MAX_SUBSCRIBERS; i++)
+    {
+        struct rigctld_subscriber *sub = reg->subs[i];
+
+        if (!sub)
+        {
+            continue;
+        }
+
+        /* Subscribed after pass 1 or wants items that were not polled:
+         * leave it due for the next cycle. */
+        if (poll_items != 0 && (sub->items & ~poll_items) == 0
+                && notify_sub_due(sub, now_ms, woken))
+        {
+            unsigned int changed = rigctld_notify_diff(sub, &state);
+
+            sub->last_check_ms = now_ms;
+
+            if (changed)
+            {
+                char line[256];
+                int len = rigctld_notify_format(changed, &state, line,
+                                                sizeof(line));
+                int ret = len > 0 ? notify_send_line(sub->sock, line, len) : -1;
+
+                if (ret == 0)
+                {
+                    notify_mark_sent(sub, changed, &state);
+                    sub->last_push_ms = now_ms;
+                    sub->pushes++;
+                }
+                else if (ret == 1)
+                {
+                    sub->drops++;
+                }
+                else if (ret == 2)
+                {
+                    /* The client thread's next read fails and unsubscribes
+                     * it; the socket stays open until then, so its number
+                     * cannot be reused under us. */
+                    rig_debug(RIG_DEBUG_WARN,
+                              "%s: client %d stopped reading, disconnecting\n",
+                              __func__, sub->client_id);
+                    shutdown(sub->sock, SHUT_RDWR);
+                    sub->drops++;
+                    sub->items = 0;
+                }
+                else
+                {
+                    /* Broken connection: the client thread sees the same
+                     * error on its next read and unsubscribes; stop
+                     * polling for it meanwhile. */
+                    rig_debug(RIG_DEBUG_VERBOSE,
+                              "%s: client %d push failed: %s\n", __func__,
+                              sub->client_id, strerror(errno));
+                    sub->items = 0;
+                }
+            }
+        }
+
+        if (sub->items != 0 && sub->last_check_ms + sub->interval_ms < next_ms)
+        {
+            next_ms = sub->last_check_ms + sub->interval_ms;
+        }
+    }
+
+    pthread_mutex_unlock(&reg->lock);
+
+    if (poll_items != 0 && reg->sync_cb) { reg->sync_cb(0, reg->sync_arg); }
+
+    return next_ms > now_ms ? (int)(next_ms - now_ms) : 0;
+}
+
+
+/* --- Notifier thread --- */
+
+void rigctld_notify_wake(struct rigctld_notify_registry *reg)
+{
+    pthread_mutex_lock(&reg->wake_lock);
+    reg->wake_pending = 1;
+    pthread_cond_signal(&reg->wake_cond);
+    pthread_mutex_unlock(&reg->wake_lock);
+}
+
+
+static void *rigctld_notify_thread(void *arg)
+{
+    struct rigctld_notify_registry *reg = arg;
+
+    while (reg->running)
+    {
+        int wait_ms = rigctld_notify_tick(reg, rigctld_notify_now_ms());
+        struct timespec deadline;
+
+        if (wait_ms <= 0)
+        {
+            continue;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += wait_ms / 1000;
+        deadline.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&reg->wake_lock);
+
+        while (reg->running && !reg->wake_pending)
+        {
+            if (pthread_cond_timedwait(&reg->wake_cond, &reg->wake_lock,
+                                       &deadline) != 0)
+            {
+                break;
+            }
+        }
+
+        pthread_mutex_unlock(&reg->wake_lock);
+    }
+
+    return NULL;
+}
+
+
+int rigctld_notify_start(struct rigctld_notify_registry *reg, RIG *rig,
+                         void (*sync_cb)(int lock, void *arg), void *sync_arg)
+{
+    if (!reg->initialized || reg->thread_started)
+    {
+        return -1;
+    }
+
+    reg->rig = rig;
+    reg->sync_cb = sync_cb;
+    reg->sync_arg = sync_arg;
+    reg->running = 1;
+
+    if (pthread_create(&reg->thread, NULL, rigctld_notify_thread, reg) != 0)
+    {
+        reg->running = 0;
+        return -1;
+    }
+
+    reg->thread_started = 1;
+
+#ifdef __linux__
+    pthread_setname_np(reg->thread, "hl-notify");
+#endif
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+/*
+ *  Hamlib rigctld change subscriptions
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Server-push change notifications for rigctld (\subscribe). */
+/* One notifier thread polls the rig for all subscribers and pushes diffs. */
+
+#ifndef RIGCTLD_NOTIFY_H
+#define RIGCTLD_NOTIFY_H
+
+#include <hamlib/rig.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rigctld_client.h"
+
+
+/* --- Command codes for rigctld --- */
+
+#define RIGCTLD_CMD_SUBSCRIBE           0xbd
+#define RIGCTLD_CMD_UNSUBSCRIBE         0xbe
+
+
+/* --- Subscribable items (bit mask) --- */
+
+#define RIGCTLD_NOTIFY_VFO       (1u << 0)
+#define RIGCTLD_NOTIFY_FREQ      (1u << 1)
+#define RIGCTLD_NOTIFY_MODE      (1u << 2)
+#define RIGCTLD_NOTIFY_PTT       (1u << 3)
+#define RIGCTLD_NOTIFY_SPLIT     (1u << 4)
+#define RIGCTLD_NOTIFY_STRENGTH  (1u << 5)
+#define RIGCTLD_NOTIFY_SWR       (1u << 6)
+#define RIGCTLD_NOTIFY_AF        (1u << 7)
+#define RIGCTLD_NOTIFY_RF        (1u << 8)
+#define RIGCTLD_NOTIFY_SQL       (1u << 9)
+#define RIGCTLD_NOTIFY_RFPOWER   (1u << 10)
+#define RIGCTLD_NOTIFY_ALL       ((1u << 11) - 1)
+
+/* Float levels carried by the AF..RFPOWER items, in item bit order. */
+#define RIGCTLD_NOTIFY_LEVEL_COUNT 4
+
+/* Prefix of every pushed line. No regular reply starts with '!', so a
+ * client can tell notifications from replies on a shared connection. */
+#define RIGCTLD_NOTIFY_PREFIX    "!notify"
+
+/* Push interval bounds and default (milliseconds). The interval is the
+ * per-subscriber rate limit: changes inside one interval are coalesced into a
+ * single line carrying the latest value of every changed item. */
+#define RIGCTLD_NOTIFY_INTERVAL_MIN     20
+#define RIGCTLD_NOTIFY_INTERVAL_MAX     10000
+#define RIGCTLD_NOTIFY_INTERVAL_DEFAULT 100
+
+/* One subscription per client connection. */
+#define RIGCTLD_MAX_SUBSCRIBERS RIGCTLD_MAX_CLIENTS
+
+
+/* Rig state sampled by the notifier.  valid has a bit set for every item
+ * read successfully; the other fields are meaningful only under their bit. */
+struct rigctld_notify_state
+{
+    unsigned int valid;
+    vfo_t vfo;
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    ptt_t ptt;
+    split_t split;
+    vfo_t tx_vfo;
+    int strength;       /* dB relative to S9 */
+    float swr;
+    float level[RIGCTLD_NOTIFY_LEVEL_COUNT];    /* AF, RF, SQL, RFPOWER */
+};
+
+
+/* Per-client subscription. */
+struct rigctld_subscriber
+{
+    int client_id;
+    int sock;                   /* Client TCP socket (pushes bypass stdio) */
+    unsigned int items;
+    int interval_ms;            /* Minimum spacing between two pushes */
+    int deadband;               /* STRENGTH changes <= this are ignored (dB) */
+    int64_t last_check_ms;      /* Last time the state was diffed */
+    int64_t last_push_ms;       /* Last time a line was sent */
+    struct rigctld_notify_state sent;   /* What the client has been told */
+
+    /* Statistics */
+    uint32_t pushes;            /* Lines sent */
+    uint32_t drops;             /* Pushes skipped or cut short on a full
+                                   socket buffer */
+};
+
+
+/* Registry of subscriptions for a rigctld instance. */
+struct rigctld_notify_registry
+{
+    struct rigctld_subscriber *subs[RIGCTLD_MAX_SUBSCRIBERS];
+    RIG *rig;
+    /* Serializes pushes with command replies: rigctl_parse() writes a whole
+     * reply between sync_cb(1) and sync_cb(0) of the lock serving the rig.
+     * NULL when unused (tests). */
+    void (*sync_cb)(int lock, void *arg);
+    void *sync_arg;
+    pthread_mutex_t lock;       /* Protects subs[] and subscriber state */
+    pthread_mutex_t wake_lock;
+    pthread_cond_t wake_cond;
+    HAMLIB_ATOMIC int wake_pending;
+    HAMLIB_ATOMIC int running;
+    pthread_t thread;
+    int thread_started;
+    int initialized;            /* 1 between registry_init() and _destroy() */
+    struct rigctld_notify_registry *next;   /* Initialized registries */
+};
+
+
+/* Global notify registry shared by rigctld command handlers. */
+extern struct rigctld_notify_registry g_notify_registry;
+
+/* Initialize a registry (zeroes slots, inits locks).
+ * Returns 0 on success, -1 on failure. */
+int rigctld_notify_registry_init(struct rigctld_notify_registry *reg);
+
+/* Stop the notifier thread (if started) and free all subscriptions. */
+void rigctld_notify_registry_destroy(struct rigctld_notify_registry *reg);
+
+/* Find the initialized registry serving rig (one per rig in a multi-rig
+ * rigctld).  Returns NULL if there is none. */
+struct rigctld_notify_registry *rigctld_notify_registry_find(RIG *rig);
+
+/* Start the notifier thread polling rig.  sync_cb may be NULL; it is called
+ * with sync_arg as its second argument.
+ * Returns 0 on success, -1 on failure. */
+int rigctld_notify_start(struct rigctld_notify_registry *reg, RIG *rig,
+                         void (*sync_cb)(int lock, void *arg), void *sync_arg);
+
+/* Wake the notifier early, e.g. from a transceive event callback.  Pushes
+ * are still held to each subscriber's interval. */
+void rigctld_notify_wake(struct rigctld_notify_registry *reg);
+
+/* Parse the \subscribe argument line "Items [Interval [Deadband]]".
+ * Items is ALL or a comma-separated list of VFO, FREQ, MODE, PTT, SPLIT,
+ * STRENGTH, SWR, AF, RF, SQL, RFPOWER (case-insensitive).  Omitted values take the defaults;
+ * Interval is clamped to the valid range.
+ * Returns 0 on success, -1 on a malformed line. */
+int rigctld_notify_parse_args(const char *line, unsigned int *items,
+                              int *interval_ms, int *deadband);
+
+/* Format an item mask as a comma-separated list of item names. */
+void rigctld_notify_items_str(unsigned int items, char *buf, size_t size);
+
+/* Add or replace the subscription of client_id.  The first push after a
+ * (re)subscribe carries every subscribed item.
+ * Returns RIG_OK, or -RIG_ENOMEM when all slots are taken. */
+int rigctld_notify_subscribe(struct rigctld_notify_registry *reg,
+                             int client_id, int sock, unsigned int items,
+                             int interval_ms, int deadband);
+
+/* Remove the subscription of client_id.  After this returns the notifier
+ * no longer touches the client's socket.
+ * Returns 1 if a subscription was removed, 0 if there was none. */
+int rigctld_notify_unsubscribe(struct rigctld_notify_registry *reg,
+                               int client_id);
+
+/* Count active subscriptions. */
+int rigctld_notify_count(struct rigctld_notify_registry *reg);
+
+/* Read the requested items from the rig into *state. */
+void rigctld_notify_poll(RIG *rig, unsigned int items,
+                         struct rigctld_notify_state *state);
+
+/* Items of sub->items whose value in *state differs from what the
+ * subscriber was last sent (honoring the STRENGTH deadband). */
+unsigned int rigctld_notify_diff(const struct rigctld_subscriber *sub,
+                                 const struct rigctld_notify_state *state);
+
+/* Format one notification line for the changed items, newline included.
+ * Returns the line length, or -1 if buf is too small. */
+int rigctld_notify_format(unsigned int changed,
+                          const struct rigctld_notify_state *state,
+                          char *buf, size_t size);
+
+/* Run one notifier cycle at time now_ms: poll the rig once for the union of
+ * due subscribers' items and push each subscriber its changes.
+ * Returns the delay in ms until the next subscriber falls due
+ * (RIGCTLD_NOTIFY_INTERVAL_MAX when there are none). */
+int rigctld_notify_tick(struct rigctld_notify_registry *reg, int64_t now_ms);
+
+/* Monotonic clock in milliseconds, the time base of rigctld_notify_tick(). */
+int64_t rigctld_notify_now_ms(void);
+
+
+#endif /* RIGCTLD_NOTIFY_H */
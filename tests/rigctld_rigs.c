@@ -0,0 +1,335 @@
+/*
+ *  Hamlib rigctld multi-rig table
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Rigs file parsing for a multi-rig rigctld (--rigs-file). */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "rigctld_rigs.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <errno.h>
+
+/* Global rig table (filled by rigctld main from --rigs-file). */
+struct rigctld_rig_table g_rig_table;
+
+
+static char *trim(char *s)
+{
+    char *end;
+
+    while (isspace((unsigned char)*s)) { s++; }
+
+    end = s + strlen(s);
+
+    while (end > s && isspace((unsigned char)end[-1])) { *--end = '\0'; }
+
+    return s;
+}
+
+
+static int valid_name(const char *name)
+{
+    const char *p;
+
+    if (*name == '\0' || strlen(name) >= RIGCTLD_RIG_NAME_LEN)
+    {
+        return 0;
+    }
+
+    for (p = name; *p; p++)
+    {
+        if (!isalnum((unsigned char)*p) && *p != '_' && *p != '-')
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+/* Parse a decimal value in [min, max]; returns 0 on success. */
+static int parse_long(const char *s, long min, long max, long *out)
+{
+    char *end;
+    long v;
+
+    errno = 0;
+    v = strtol(s, &end, 10);
+
+    if (errno || end == s || *end != '\0' || v < min || v > max)
+    {
+        return -1;
+    }
+
+    *out = v;
+    return 0;
+}
+
+
+/* Checks that need the whole section: run when it ends. */
+static int finish_rig(struct rigctld_rig_table *table, int lineno,
+                      char *err, size_t errlen)
+{
+    struct rigctld_rig *r = &table->rigs[table->count - 1];
+    int i;
+
+    if (r->model == 0)
+    {
+        snprintf(err, errlen, "line %d: rig '%s' has no model", lineno,
+                 r->name);
+        return -1;
+    }
+
+    for (i = 0; i < table->count - 1; i++)
+    {
+        if (r->port[0] && strcmp(table->rigs[i].port, r->port) == 0)
+        {
+            snprintf(err, errlen, "line %d: rigs '%s' and '%s' share port %s",
+                     lineno, table->rigs[i].name, r->name, r->port);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+int rigctld_rigs_parse(struct rigctld_rig_table *table, FILE *f,
+                       char *err, size_t errlen)
+{
+    char line[RIGCTLD_RIG_CONF_LEN + 64];
+    int lineno = 0;
+    int i;
+
+    memset(table, 0, sizeof(*table));
+
+    for (i = 0; i < RIGCTLD_MAX_RIGS; i++)
+    {
+        table->rigs[i].sock_listen = -1;
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        struct rigctld_rig *r;
+        char *p, *eq, *key, *val;
+        long v;
+
+        lineno++;
+
+        if (!strchr(line, '\n') && !feof(f))
+        {
+            snprintf(err, errlen, "line %d: line too long", lineno);
+            return -1;
+        }
+
+        p = trim(line);
+
+        if (*p == '\0' || *p == '#' || *p == ';')
+        {
+            continue;
+        }
+
+        /* [name] starts a rig */
+        if (*p == '[')
+        {
+            char *close = strchr(p, ']');
+
+            if (!close || close[1] != '\0')
+            {
+                snprintf(err, errlen, "line %d: malformed section", lineno);
+                return -1;
+            }
+
+            *close = '\0';
+            p = trim(p + 1);
+
+            if (!valid_name(p))
+            {
+                snprintf(err, errlen, "line %d: invalid rig name '%s'", lineno,
+                         p);
+                return -1;
+            }
+
+            if (rigctld_rigs_find(table, p))
+            {
+                snprintf(err, errlen, "line %d: duplicate rig '%s'", lineno, p);
+                return -1;
+            }
+
+            if (table->count > 0 && finish_rig(table, lineno, err, errlen) < 0)
+            {
+                return -1;
+            }
+
+            if (table->count == RIGCTLD_MAX_RIGS)
+            {
+                snprintf(err, errlen, "line %d: more than %d rigs", lineno,
+                         RIGCTLD_MAX_RIGS);
+                return -1;
+            }
+
+            r = &table->rigs[table->count++];
+            strcpy(r->name, p);
+            continue;
+        }
+
+        if (table->count == 0)
+        {
+            snprintf(err, errlen, "line %d: setting outside a [rig] section",
+                     lineno);
+            return -1;
+        }
+
+        r = &table->rigs[table->count - 1];
+
+        /* key = value; the value may itself contain '=' (set_conf) */
+        eq = strchr(p, '=');
+
+        if (!eq)
+        {
+            snprintf(err, errlen, "line %d: expected key = value", lineno);
+            return -1;
+        }
+
+        *eq = '\0';
+        key = trim(p);
+        val = trim(eq + 1);
+
+        if (strcmp(key, "model") == 0)
+        {
+            if (parse_long(val, 1, 0x7fffffff, &v) < 0)
+            {
+                snprintf(err, errlen, "line %d: invalid model '%s'", lineno,
+                         val);
+                return -1;
+            }
+
+            r->model = (rig_model_t)v;
+        }
+        else if (strcmp(key, "rig_file") == 0)
+        {
+            if (strlen(val) >= sizeof(r->rig_file))
+            {
+                snprintf(err, errlen, "line %d: rig_file too long", lineno);
+                return -1;
+            }
+
+            strcpy(r->rig_file, val);
+        }
+        else if (strcmp(key, "serial_speed") == 0)
+        {
+            if (parse_long(val, 1, 10000000, &v) < 0)
+            {
+                snprintf(err, errlen, "line %d: invalid serial_speed '%s'",
+                         lineno, val);
+                return -1;
+            }
+
+            r->serial_speed = (int)v;
+        }
+        else if (strcmp(key, "port") == 0)
+        {
+            if (parse_long(val, 1, 65535, &v) < 0)
+            {
+                snprintf(err, errlen, "line %d: invalid port '%s'", lineno,
+                         val);
+                return -1;
+            }
+
+            snprintf(r->port, sizeof(r->port), "%ld", v);
+        }
+        else if (strcmp(key, "set_conf") == 0)
+        {
+            /* Repeated set_conf lines accumulate */
+            size_t len = strlen(r->set_conf);
+
+            if (len + (len ? 1 : 0) + strlen(val) >= sizeof(r->set_conf))
+            {
+                snprintf(err, errlen, "line %d: set_conf too long", lineno);
+                return -1;
+            }
+
+            if (len) { r->set_conf[len++] = ','; }
+
+            strcpy(r->set_conf + len, val);
+        }
+        else
+        {
+            snprintf(err, errlen, "line %d: unknown key '%s'", lineno, key);
+            return -1;
+        }
+    }
+
+    if (table->count == 0)
+    {
+        snprintf(err, errlen, "no [rig] sections");
+        return -1;
+    }
+
+    return finish_rig(table, lineno, err, errlen);
+}
+
+
+int rigctld_rigs_load(struct rigctld_rig_table *table, const char *path,
+                      char *err, size_t errlen)
+{
+    FILE *f = fopen(path, "r");
+    int ret;
+
+    if (!f)
+    {
+        snprintf(err, errlen, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    ret = rigctld_rigs_parse(table, f, err, errlen);
+    fclose(f);
+
+    return ret;
+}
+
+
+struct rigctld_rig *rigctld_rigs_find(struct rigctld_rig_table *table,
+                                      const char *name)
+{
+    int i;
+
+    if (!name)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < table->count; i++)
+    {
+        if (strcmp(table->rigs[i].name, name) == 0)
+        {
+            return &table->rigs[i];
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,105 @@
+/*
+ *  Hamlib rigctld multi-rig table
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Rigs served by one rigctld process (--rigs-file), with their routing. */
+
+#ifndef RIGCTLD_RIGS_H
+#define RIGCTLD_RIGS_H
+
+#include <hamlib/rig.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#include "rigctld_notify.h"
+#include "rigctld_sched.h"
+
+
+/* --- Command codes for rigctld --- */
+
+#define RIGCTLD_CMD_RIG_SELECT          0xbf
+#define RIGCTLD_CMD_RIG_LIST            0xc0
+
+
+#define RIGCTLD_MAX_RIGS        16
+#define RIGCTLD_RIG_NAME_LEN    32
+#define RIGCTLD_RIG_CONF_LEN    1024
+
+
+/*
+ * One [section] of the rigs file.
+ *
+ *   # comment
+ *   [ic7300]
+ *   model = 3073
+ *   rig_file = /dev/ttyUSB0
+ *   serial_speed = 115200
+ *   port = 4533
+ *   set_conf = civaddr=0x94,ptt_type=RIG
+ *
+ * model is required.  port gives the rig a listening socket of its own;
+ * without it the rig is reached through the shared port and \rig_select.
+ */
+struct rigctld_rig
+{
+    /* Configuration */
+    char name[RIGCTLD_RIG_NAME_LEN];
+    rig_model_t model;
+    char rig_file[HAMLIB_FILPATHLEN];
+    int serial_speed;                   /* 0 = backend default */
+    char port[8];                       /* "" = shared port only */
+    char set_conf[RIGCTLD_RIG_CONF_LEN];    /* "key=val,key=val" */
+
+    /* Runtime, owned by rigctld */
+    RIG *rig;
+    HAMLIB_ATOMIC int opened;
+    struct rigctld_fair_lock lock;  /* Serializes this rig's commands and replies */
+    struct rigctld_notify_registry notify;
+    int sock_listen;            /* -1 without a port of its own */
+};
+
+
+struct rigctld_rig_table
+{
+    struct rigctld_rig rigs[RIGCTLD_MAX_RIGS];
+    int count;                  /* 0 = single-rig rigctld */
+};
+
+
+/* Global rig table shared by rigctld command handlers. */
+extern struct rigctld_rig_table g_rig_table;
+
+/* Parse a rigs file from f into *table (which is reset first).
+ * Returns 0 on success, -1 with a "line N: ..." message in err. */
+int rigctld_rigs_parse(struct rigctld_rig_table *table, FILE *f,
+                       char *err, size_t errlen);
+
+/* Open and parse the rigs file at path.
+ * Returns 0 on success, -1 with a message in err. */
+int rigctld_rigs_load(struct rigctld_rig_table *table, const char *path,
+                      char *err, size_t errlen);
+
+/* Find a rig by name (case-sensitive).  Returns NULL if there is none. */
+struct rigctld_rig *rigctld_rigs_find(struct rigctld_rig_table *table,
+                                      const char *name);
+
+
+#endif /* RIGCTLD_RIGS_H */
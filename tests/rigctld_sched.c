@@ -0,0 +1,303 @@
+/*
+ *  Hamlib rigctld per-client command scheduling
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Fair rig lock, token buckets and statistics for rigctld clients. */
+
+#ifdef HAVE_CONFIG_H
+#  include "hamlib/config.h"
+#endif
+
+#include "rigctld_sched.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+
+/* Global scheduler (rate limits set by rigctld main from --rate-limit). */
+struct rigctld_sched g_sched;
+
+
+int64_t rigctld_sched_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/* --- Fair rig lock --- */
+
+void rigctld_fair_lock_init(struct rigctld_fair_lock *lock)
+{
+    memset(lock, 0, sizeof(*lock));
+    pthread_mutex_init(&lock->mutex, NULL);
+    pthread_cond_init(&lock->cond, NULL);
+}
+
+
+void rigctld_fair_lock_destroy(struct rigctld_fair_lock *lock)
+{
+    pthread_cond_destroy(&lock->cond);
+    pthread_mutex_destroy(&lock->mutex);
+}
+
+
+void rigctld_fair_lock_acquire(struct rigctld_fair_lock *lock, int cls)
+{
+    int q = cls == RIGCTLD_CLASS_READ;
+    unsigned int ticket;
+
+    pthread_mutex_lock(&lock->mutex);
+
+    ticket = lock->next[q]++;
+
+    /* Reads also step aside while any write holds a ticket */
+    while (lock->busy || lock->serving[q] != ticket
+            || (q && lock->next[0] != lock->serving[0]))
+    {
+        pthread_cond_wait(&lock->cond, &lock->mutex);
+    }
+
+    lock->busy = 1;
+    lock->serving[q]++;
+
+    pthread_mutex_unlock(&lock->mutex);
+}
+
+
+void rigctld_fair_lock_release(struct rigctld_fair_lock *lock)
+{
+    pthread_mutex_lock(&lock->mutex);
+    lock->busy = 0;
+    /* Waiters of both queues check their own turn */
+    pthread_cond_broadcast(&lock->cond);
+    pthread_mutex_unlock(&lock->mutex);
+}
+
+
+/* --- Scheduler --- */
+
+void rigctld_sched_init(struct rigctld_sched *s)
+{
+    memset(s, 0, sizeof(*s));
+    pthread_mutex_init(&s->mutex, NULL);
+}
+
+
+/* Parse a rate in [0, RIGCTLD_RATE_MAX]; returns 0 on success. */
+static int parse_rate(const char *p, char **end, int *out)
+{
+    long v;
+
+    errno = 0;
+    v = strtol(p, end, 10);
+
+    if (*end == p || errno || v < 0 || v > RIGCTLD_RATE_MAX)
+    {
+        return -1;
+    }
+
+    *out = (int)v;
+    return 0;
+}
+
+
+int rigctld_sched_parse_rates(struct rigctld_sched *s, const char *spec)
+{
+    int reads, writes = 0;
+    char *end;
+
+    if (!spec || parse_rate(spec, &end, &reads) < 0)
+    {
+        return -1;
+    }
+
+    if (*end == ',')
+    {
+        if (parse_rate(end + 1, &end, &writes) < 0)
+        {
+            return -1;
+        }
+    }
+
+    if (*end != '\0')
+    {
+        return -1;
+    }
+
+    s->rate[RIGCTLD_CLASS_READ] = reads;
+    s->rate[RIGCTLD_CLASS_WRITE] = writes;
+
+    return 0;
+}
+
+
+int rigctld_sched_class(int takes_args, int returns_values)
+{
+    return takes_args && !returns_values ? RIGCTLD_CLASS_WRITE
+           : RIGCTLD_CLASS_READ;
+}
+
+
+struct rigctld_sched_client *rigctld_sched_attach(struct rigctld_sched *s,
+        int client_id, const char *peer)
+{
+    struct rigctld_sched_client *c = NULL;
+    int i;
+
+    pthread_mutex_lock(&s->mutex);
+
+    for (i = 0; i < RIGCTLD_MAX_CLIENTS; i++)
+    {
+        if (!s->clients[i].in_use)
+        {
+            c = &s->clients[i];
+            memset(c, 0, sizeof(*c));
+            c->in_use = 1;
+            c->client_id = client_id;
+            snprintf(c->peer, sizeof(c->peer), "%s", peer ? peer : "");
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&s->mutex);
+
+    return c;
+}
+
+
+void rigctld_sched_detach(struct rigctld_sched *s,
+                          struct rigctld_sched_client *c)
+{
+    if (!c)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    c->in_use = 0;
+    pthread_mutex_unlock(&s->mutex);
+}
+
+
+int64_t rigctld_sched_admit(struct rigctld_sched *s,
+                            struct rigctld_sched_client *c, int cls,
+                            int64_t now_us)
+{
+    struct rigctld_bucket *b;
+    int64_t delay_us = 0;
+    double burst;
+    int rate;
+
+    if (!c || cls <= RIGCTLD_CLASS_CONTROL || cls >= RIGCTLD_CLASS_COUNT)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+
+    c->stats[cls].commands++;
+    rate = s->rate[cls];
+
+    if (rate > 0)
+    {
+        b = &c->bucket[cls];
+        burst = rate > 1 ? rate : 1;
+
+        if (b->last_us == 0)
+        {
+            b->tokens = burst;
+        }
+        else if (now_us > b->last_us)
+        {
+            b->tokens += (double)(now_us - b->last_us) * rate / 1e6;
+
+            if (b->tokens > burst)
+            {
+                b->tokens = burst;
+            }
+        }
+
+        b->last_us = now_us;
+
+        /* Take the token now even when short of one, so later commands
+         * queue behind this one instead of racing it for the refill */
+        b->tokens -= 1.0;
+
+        if (b->tokens < 0)
+        {
+            delay_us = (int64_t)(-b->tokens * 1e6 / rate + 0.5);
+            c->stats[cls].throttled++;
+            c->stats[cls].throttle_us += delay_us;
+        }
+    }
+
+    pthread_mutex_unlock(&s->mutex);
+
+    return delay_us;
+}
+
+
+void rigctld_sched_record_wait(struct rigctld_sched *s,
+                               struct rigctld_sched_client *c, int cls,
+                               int64_t wait_us)
+{
+    if (!c || cls <= RIGCTLD_CLASS_CONTROL || cls >= RIGCTLD_CLASS_COUNT
+            || wait_us < 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+
+    c->stats[cls].wait_us += wait_us;
+
+    if ((uint64_t)wait_us > c->stats[cls].wait_max_us)
+    {
+        c->stats[cls].wait_max_us = wait_us;
+    }
+
+    pthread_mutex_unlock(&s->mutex);
+}
+
+
+int rigctld_sched_snapshot(struct rigctld_sched *s,
+                           struct rigctld_sched_client *out, int max)
+{
+    int i, n = 0;
+
+    pthread_mutex_lock(&s->mutex);
+
+    for (i = 0; i < RIGCTLD_MAX_CLIENTS && n < max; i++)
+    {
+        if (s->clients[i].in_use)
+        {
+            out[n++] = s->clients[i];
+        }
+    }
+
+    pthread_mutex_unlock(&s->mutex);
+
+    return n;
+}
@@ -0,0 +1,152 @@
+/*
+ *  Hamlib rigctld per-client command scheduling
+ *  Copyright (c) 2026 by Mikael Nousiainen OH3BHX
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+/* Fair command scheduling for rigctld: a rig lock that serves queued
+ * write commands before reads and each class in arrival order, plus
+ * optional per-client token buckets (--rate-limit) and \client_stats. */
+
+#ifndef RIGCTLD_SCHED_H
+#define RIGCTLD_SCHED_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "rigctld_client.h"
+
+
+/* --- Command codes for rigctld --- */
+
+#define RIGCTLD_CMD_CLIENT_STATS        0xc1
+
+
+/* --- Command classes --- */
+
+/* CONTROL is rigctld's own work (open, close, notifier pushes) and is
+ * never metered; WRITE is a command that only takes arguments (set_freq,
+ * set_ptt, ...); everything else is a READ. */
+#define RIGCTLD_CLASS_CONTROL   0
+#define RIGCTLD_CLASS_WRITE     1
+#define RIGCTLD_CLASS_READ      2
+#define RIGCTLD_CLASS_COUNT     3
+
+/* Upper bound of a --rate-limit value, commands per second */
+#define RIGCTLD_RATE_MAX        10000
+
+
+/* --- Fair rig lock --- */
+
+/* One holder at a time. Waiters queue by ticket: CONTROL and WRITE share
+ * the priority queue, READ has its own and only proceeds while the
+ * priority queue is empty. A client looping on reads therefore gets one
+ * turn per round of the other waiting clients, and a PTT never waits
+ * behind more than the command already running. */
+struct rigctld_fair_lock
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int busy;
+    unsigned int next[2];       /* Next ticket to hand out, per queue */
+    unsigned int serving[2];    /* Ticket allowed in next, per queue */
+};
+
+#define RIGCTLD_FAIR_LOCK_INITIALIZER \
+    { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, { 0, 0 }, { 0, 0 } }
+
+void rigctld_fair_lock_init(struct rigctld_fair_lock *lock);
+void rigctld_fair_lock_destroy(struct rigctld_fair_lock *lock);
+void rigctld_fair_lock_acquire(struct rigctld_fair_lock *lock, int cls);
+void rigctld_fair_lock_release(struct rigctld_fair_lock *lock);
+
+
+/* --- Per-client token buckets and statistics --- */
+
+/* Refills at the class rate up to one second's worth (at least one
+ * token); tokens go negative while throttled commands wait their turn. */
+struct rigctld_bucket
+{
+    double tokens;
+    int64_t last_us;            /* 0 = not used yet, starts full */
+};
+
+struct rigctld_sched_stats
+{
+    uint64_t commands;
+    uint64_t throttled;         /* Commands delayed by the bucket */
+    uint64_t throttle_us;       /* Total delay imposed */
+    uint64_t wait_us;           /* Total time queued for the rig lock */
+    uint64_t wait_max_us;
+};
+
+struct rigctld_sched_client
+{
+    int in_use;
+    int client_id;
+    char peer[80];              /* "host:port" */
+    struct rigctld_bucket bucket[RIGCTLD_CLASS_COUNT];
+    struct rigctld_sched_stats stats[RIGCTLD_CLASS_COUNT];
+};
+
+struct rigctld_sched
+{
+    pthread_mutex_t mutex;
+    int rate[RIGCTLD_CLASS_COUNT];  /* Commands/s per client, 0 = unlimited */
+    struct rigctld_sched_client clients[RIGCTLD_MAX_CLIENTS];
+};
+
+
+/* Global scheduler shared by rigctld command handlers. */
+extern struct rigctld_sched g_sched;
+
+void rigctld_sched_init(struct rigctld_sched *s);
+
+/* Parse --rate-limit "READS[,WRITES]" (commands per second per client,
+ * 0 = unlimited). Returns 0, or -1 if spec is malformed. */
+int rigctld_sched_parse_rates(struct rigctld_sched *s, const char *spec);
+
+/* Class of a command from its argument flags: WRITE if it only takes
+ * arguments, READ otherwise. */
+int rigctld_sched_class(int takes_args, int returns_values);
+
+/* Client slots; attach returns NULL when the table is full. */
+struct rigctld_sched_client *rigctld_sched_attach(struct rigctld_sched *s,
+        int client_id, const char *peer);
+void rigctld_sched_detach(struct rigctld_sched *s,
+                          struct rigctld_sched_client *c);
+
+/* Count one command of class cls at now_us and take a token from its
+ * bucket. Returns the microseconds the caller must wait before running
+ * it, 0 if it may run at once. */
+int64_t rigctld_sched_admit(struct rigctld_sched *s,
+                            struct rigctld_sched_client *c, int cls,
+                            int64_t now_us);
+
+/* Record the time a command of class cls queued for the rig lock. */
+void rigctld_sched_record_wait(struct rigctld_sched *s,
+                               struct rigctld_sched_client *c, int cls,
+                               int64_t wait_us);
+
+/* Copy the attached clients into out (at most max). Returns the count. */
+int rigctld_sched_snapshot(struct rigctld_sched *s,
+                           struct rigctld_sched_client *out, int max);
+
+int64_t rigctld_sched_now_us(void);
+
+#endif /* RIGCTLD_SCHED_H */
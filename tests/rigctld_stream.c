@@ -34,6 +34,7 @@
 #include "rigctld_client.h"
 #include "stream_convert.h"
 #include "stream.h"
+#include "sleep.h"
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -1144,15 +1145,60 @@ static void stream_fill_header(struct rigctld_stream *stream,
 }
 
 
-/* Send a packed packet to the subscribed client and update send accounting.
- * Returns 0 on success, -1 on send failure. */
+/* Send what the stream's batch holds and add what became of it to the
+ * stream's counters. */
+static void flush_to_client(struct rigctld_stream *stream)
+{
+    struct udp_batch_stats now;
+    struct udp_batch_stats *counted = &stream->batch_counted;
+
+    udp_batch_flush(stream->batch);
+    udp_batch_stats_get(&stream->batch->stats, &now);
+
+    stream->packet_count += (int)(now.packets - counted->packets);
+    stream->send_drops += (int)(now.errors - counted->errors);
+    stream->send_syscalls += (int)(now.syscalls - counted->syscalls);
+    *counted = now;
+}
+
+
+/* Queue a copy of a packed packet in the stream's batch.  Returns 0, or -1
+ * when it cannot take a packet that large. */
+static int queue_to_client(struct rigctld_stream *stream,
+                           const unsigned char *pkt, size_t len)
+{
+    unsigned char *slot = udp_batch_reserve(stream->batch, len);
+
+    if (!slot)
+    {
+        stream->send_drops++;
+        return -1;
+    }
+
+    memcpy(slot, pkt, len);
+    udp_batch_commit(stream->batch, len);
+
+    return 0;
+}
+
+
+/* Send a packed packet to the subscribed client and update send accounting;
+ * with a batch it is only queued, see flush_to_client().  Returns 0 on
+ * success, -1 on send failure. */
 static int send_to_client(struct rigctld_stream *stream,
                           const unsigned char *pkt, size_t len)
 {
+    if (stream->batch)
+    {
+        return queue_to_client(stream, pkt, len);
+    }
+
     ssize_t sent = sendto(stream->udp_sock, (const char *)pkt, len, 0,
                           (struct sockaddr *)&stream->client_addr,
                           stream->client_addr_len);
 
+    stream->send_syscalls++;
+
     if (sent >= 0)
     {
         stream->packet_count++;
@@ -1164,6 +1210,79 @@ static int send_to_client(struct rigctld_stream *stream,
 }
 
 
+/* Send head_len bytes at head followed by len bytes at data as one
+ * datagram. head has room for the data right after it, where it may
+ * already be; otherwise on POSIX systems the two parts go out gathered,
+ * so data read in place from the stream ring is not copied here.  With a
+ * batch, data read in place must stay put until the batch is flushed. */
+static int send_to_client_gather(struct rigctld_stream *stream,
+                                 unsigned char *head, size_t head_len,
+                                 const unsigned char *data, size_t len)
+{
+    if (stream->batch)
+    {
+        unsigned char *slot;
+
+        if (data == head + head_len)
+        {
+            return queue_to_client(stream, head, head_len + len);
+        }
+
+        slot = udp_batch_reserve(stream->batch, head_len + len);
+
+        if (!slot)
+        {
+            stream->send_drops++;
+            return -1;
+        }
+
+        memcpy(slot, head, head_len);
+        udp_batch_commit_gather(stream->batch, head_len, data, len);
+
+        return 0;
+    }
+
+#ifdef _WIN32
+
+    if (data != head + head_len)
+    {
+        memcpy(head + head_len, data, len);
+    }
+
+    return send_to_client(stream, head, head_len + len);
+#else
+    struct iovec iov[2];
+    struct msghdr msg;
+
+    if (data == head + head_len)
+    {
+        return send_to_client(stream, head, head_len + len);
+    }
+
+    iov[0].iov_base = head;
+    iov[0].iov_len = head_len;
+    iov[1].iov_base = (void *)data;
+    iov[1].iov_len = len;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &stream->client_addr;
+    msg.msg_namelen = stream->client_addr_len;
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    stream->send_syscalls++;
+
+    if (sendmsg(stream->udp_sock, &msg, 0) >= 0)
+    {
+        stream->packet_count++;
+        return 0;
+    }
+
+    stream->send_drops++;
+    return -1;
+#endif
+}
+
+
 /* Build and send a metadata packet for this stream.
  * Returns 0 on success, -1 on send failure. */
 static int send_metadata_packet(struct rigctld_stream *stream,
@@ -1534,8 +1653,11 @@ static void *rigctld_stream_feeder_tx(void *arg)
 
                 /* Advance the sample counter by whole frames (all
                  * channels); codec frame durations are not on the wire,
-                 * so a codec TX position stays byte-agnostic (0). */
-                if (!stream->backend_stream->is_codec)
+                 * so a codec TX position stays byte-agnostic (0). That
+                 * holds for Opus decoded into a PCM ring as well. */
+                if (!stream->backend_stream->is_codec
+                        && rig_stream_format_sample_size(
+                            stream->config.format) > 0)
                 {
                     stream->timestamp += data_len / frame_bytes;
                 }
@@ -1612,14 +1734,173 @@ static void poll_incoming_control(struct rigctld_stream *stream,
         /* Re-subscribe: update client address, send ACK */
         memcpy(&stream->client_addr, &from_addr, from_len);
         stream->client_addr_len = from_len;
+
+        if (stream->batch)
+        {
+            udp_batch_set_dest(stream->batch, &from_addr, (int)from_len);
+        }
+
         stream->last_subscribe = now->tv_sec;
         rigctld_stream_send_control_reply(stream, RIG_STREAM_CTRL_SUBSCRIBE_ACK);
     }
 }
 
 
+/* Send one data packet of len bytes at data, read from the stream at the
+ * position and time rinfo describes.  pkt_buf has room for a header and a
+ * time block ahead of a payload. */
+static void send_data_packet(struct rigctld_stream *stream,
+                             const struct rig_stream_packet_header *hdr_template,
+                             unsigned char *pkt_buf, const void *data,
+                             size_t len,
+                             const struct rig_stream_read_info *rinfo)
+{
+    /* Patch per-packet fields into template header. The header
+     * timestamp carries the producer sample index, so upstream
+     * holes appear as timestamp jumps on the wire. */
+    struct rig_stream_packet_header hdr = *hdr_template;
+    hdr.seq = stream->seq++;
+    hdr.timestamp = rinfo->sample_index;
+    hdr.control = 0;
+
+    unsigned char *send_ptr;
+    size_t send_len;
+
+    /* Stamp every packet that has usable time, and — MUST-stamp
+     * rule — every packet whose timestamp jumps (discontinuity). */
+    if (rinfo->time_valid
+            || (rinfo->time_flags & RIG_STREAM_TIME_FLAG_DISCONTINUITY))
+    {
+        struct rig_stream_time_anchor blk;
+        memset(&blk, 0, sizeof(blk));
+        blk.seconds = rinfo->seconds;
+        blk.picoseconds = rinfo->picoseconds;
+        blk.source = rinfo->time_source;
+        blk.flags = rinfo->time_flags;
+        blk.accuracy = rinfo->time_accuracy;
+
+        hdr.control |= RIG_STREAM_CTRL_TIME;
+        hdr.payload_len = (uint16_t)(RIG_STREAM_TIME_BLOCK_SIZE + len);
+        stream_packet_header_pack(&hdr, pkt_buf);
+        stream_time_block_pack(&blk, pkt_buf + RIG_STREAM_HEADER_SIZE);
+        send_ptr = pkt_buf;
+        send_len = RIG_STREAM_HEADER_SIZE + RIG_STREAM_TIME_BLOCK_SIZE;
+    }
+    else
+    {
+        hdr.payload_len = (uint16_t)len;
+        send_ptr = pkt_buf + RIG_STREAM_TIME_BLOCK_SIZE;
+        stream_packet_header_pack(&hdr, send_ptr);
+        send_len = RIG_STREAM_HEADER_SIZE;
+    }
+
+    send_to_client_gather(stream, send_ptr, send_len, data, len);
+}
+
+
+/* Elapsed microseconds between two timespecs. */
+static long elapsed_us(const struct timespec *start, const struct timespec *end)
+{
+    long result = (end->tv_sec - start->tv_sec) * 1000000
+                  + (end->tv_nsec - start->tv_nsec) / 1000;
+    return result < 0 ? 0 : result;
+}
+
+
+/* Hold off reading while the ring has less than a batch, up to the batch
+ * window after the last send: a sample waits at most that long. */
+static void wait_for_batch(struct rigctld_stream *stream, size_t batch_bytes,
+                           int frame_bytes, const struct timespec *last_send)
+{
+    size_t available = stream_ringbuf_available(&stream->backend_stream->ringbuf);
+    struct timespec now;
+    long wait_us;
+
+    if (available >= batch_bytes)
+    {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    wait_us = stream->batch_window_us - elapsed_us(last_send, &now);
+
+    if (wait_us <= 0)
+    {
+        return;
+    }
+
+    /* No longer than the rest of the batch takes to arrive */
+    if (stream->config.sample_rate > 0)
+    {
+        uint64_t fill_us = (uint64_t)(batch_bytes - available) * 1000000
+                           / ((uint64_t)stream->config.sample_rate * frame_bytes);
+
+        if (fill_us < (uint64_t)wait_us)
+        {
+            wait_us = (long)fill_us + 1;
+        }
+    }
+
+    hl_usleep(wait_us);
+}
+
+
+/* Set up batched sending to the client, by the stream's batch depth */
+static void start_batching(struct rigctld_stream *stream)
+{
+    if (stream->batch_depth <= 1)
+    {
+        return;
+    }
+
+    stream->batch = calloc(1, sizeof(*stream->batch));
+
+    if (!stream->batch)
+    {
+        return;
+    }
+
+    udp_batch_init(stream->batch, stream->udp_sock, &stream->client_addr,
+                   (int)stream->client_addr_len);
+    udp_batch_set_depth(stream->batch, stream->batch_depth);
+    memset(&stream->batch_counted, 0, sizeof(stream->batch_counted));
+
+    rig_debug(RIG_DEBUG_VERBOSE,
+              "%s: stream %d sends up to %d packets per call, GSO %s, "
+              "window %d us\n", __func__, stream->stream_id,
+              stream->batch->depth,
+              udp_batch_enable_gso(stream->batch) ? "on" : "off",
+              stream->batch_window_us);
+}
+
+
+static void stop_batching(struct rigctld_stream *stream)
+{
+    struct udp_batch_stats stats;
+
+    if (!stream->batch)
+    {
+        return;
+    }
+
+    udp_batch_stats_get(&stream->batch->stats, &stats);
+    rig_debug(RIG_DEBUG_VERBOSE,
+              "%s: stream %d sent %llu packets in %llu system calls, %llu "
+              "segmented by GSO, %llu failed\n", __func__, stream->stream_id,
+              (unsigned long long)stats.packets,
+              (unsigned long long)stats.syscalls,
+              (unsigned long long)stats.offloaded,
+              (unsigned long long)stats.errors);
+
+    free(stream->batch);
+    stream->batch = NULL;
+}
+
+
 /* RX feeder thread: reads from backend ring buffer, sends UDP packets.
- * Sends initial metadata after subscribe, then polls for changes. */
+ * Sends initial metadata after subscribe, then polls for changes.  With a
+ * batch depth above one, a read takes up to that many packets' worth from
+ * the ring and they go out in one system call. */
 static void *rigctld_stream_feeder_rx(void *arg)
 {
     struct rigctld_stream *stream = (struct rigctld_stream *)arg;
@@ -1697,6 +1978,8 @@ static void *rigctld_stream_feeder_rx(void *arg)
         return NULL;
     }
 
+    start_batching(stream);
+
     /* Seed monotonic timestamps for interval checks */
     struct timespec last_meta_time, last_ctrl_check, last_data_time;
     clock_gettime(CLOCK_MONOTONIC, &last_meta_time);
@@ -1720,87 +2003,114 @@ static void *rigctld_stream_feeder_rx(void *arg)
         }
     }
 
+    /* Send the samples straight out of the stream's ring while the stream
+     * allows it (not codec streams or backends with their own read path);
+     * otherwise read them into the packet buffer. */
+    int zero_copy = 1;
+
+    /* A batch is read from the ring at once and sent in place */
+    size_t batch_bytes = (size_t)max_payload
+                         * (stream->batch ? stream->batch->depth : 1);
+
     /* Main feeder loop */
     while (stream->running)
     {
         size_t bytes_read = 0;
         struct rig_stream_read_info rinfo;
-        int ret = rig_stream_read(stream->rig, stream->backend_stream,
-                                  payload, max_payload, &bytes_read, 100,
-                                  &rinfo);
+        const void *data = payload;
+        int acquired = 0;
+        int ret;
 
-        if (ret == RIG_OK && bytes_read > 0)
+        if (zero_copy)
         {
-            /* Patch per-packet fields into template header. The header
-             * timestamp carries the producer sample index, so upstream
-             * holes appear as timestamp jumps on the wire. */
-            struct rig_stream_packet_header hdr = hdr_template;
-            hdr.seq = stream->seq++;
-            hdr.timestamp = rinfo.sample_index;
-            hdr.control = 0;
-
-            unsigned char *send_ptr;
-            size_t send_len;
-
-            /* Stamp every packet that has usable time, and — MUST-stamp
-             * rule — every packet whose timestamp jumps (discontinuity). */
-            if (rinfo.time_valid
-                    || (rinfo.time_flags & RIG_STREAM_TIME_FLAG_DISCONTINUITY))
+            if (stream->batch && stream->batch_window_us > 0)
             {
-                struct rig_stream_time_anchor blk;
-                memset(&blk, 0, sizeof(blk));
-                blk.seconds = rinfo.seconds;
-                blk.picoseconds = rinfo.picoseconds;
-                blk.source = rinfo.time_source;
-                blk.flags = rinfo.time_flags;
-                blk.accuracy = rinfo.time_accuracy;
-
-                hdr.control |= RIG_STREAM_CTRL_TIME;
-                hdr.payload_len = (uint16_t)(RIG_STREAM_TIME_BLOCK_SIZE
-                                             + bytes_read);
-                stream_packet_header_pack(&hdr, pkt_buf);
-                stream_time_block_pack(&blk,
-                                       pkt_buf + RIG_STREAM_HEADER_SIZE);
-                send_ptr = pkt_buf;
-                send_len = RIG_STREAM_HEADER_SIZE
-                           + RIG_STREAM_TIME_BLOCK_SIZE + bytes_read;
+                wait_for_batch(stream, batch_bytes, frame_bytes, &last_data_time);
             }
-            else
+
+            ret = rig_stream_read_acquire(stream->rig, stream->backend_stream,
+                                          &data, batch_bytes, &bytes_read,
+                                          100, &rinfo);
+
+            if (ret == -RIG_ENIMPL)
             {
-                hdr.payload_len = (uint16_t)bytes_read;
-                send_ptr = pkt_buf + RIG_STREAM_TIME_BLOCK_SIZE;
-                stream_packet_header_pack(&hdr, send_ptr);
-                send_len = RIG_STREAM_HEADER_SIZE + bytes_read;
+                zero_copy = 0;
+                continue;
             }
 
-            send_to_client(stream, send_ptr, send_len);
-
-            /* Track the producer position for non-data frames. A codec
-             * stream advances by the frame's decoded duration, not by
-             * bytes. */
-            stream->timestamp = stream->backend_stream->is_codec
-                                ? rinfo.sample_index
-                                + rinfo.codec_frame_samples
-                                : rinfo.sample_index
-                                + bytes_read / (size_t)frame_bytes;
-
-            /* Unconditional metadata refresh (cadence in stream-data time)
-             * so a lost change-detected frame heals without waiting for the
-             * next change; interval 0 sends metadata with every data packet. */
-            if (rigctld_stream_metadata_refresh_due(stream->metadata_refresh_ms,
-                                                    stream->config.sample_rate,
-                                                    stream->timestamp - last_meta_sample))
+            acquired = ret == RIG_OK;
+        }
+        else
+        {
+            ret = rig_stream_read(stream->rig, stream->backend_stream,
+                                  payload, max_payload, &bytes_read, 100,
+                                  &rinfo);
+        }
+
+        if (ret == RIG_OK && bytes_read > 0)
+        {
+            struct rig_stream_read_info pinfo = rinfo;
+            size_t offset = 0;
+
+            /* A region longer than one packet (batching) goes out as
+             * max_payload packets, each stamped for its own first sample */
+            while (offset < bytes_read)
             {
-                struct rig_stream_metadata meta;
+                size_t len = bytes_read - offset < (size_t)max_payload
+                             ? bytes_read - offset : (size_t)max_payload;
 
-                if (rig_stream_read_metadata(stream->rig,
-                                             stream->backend_stream,
-                                             &meta) == RIG_OK)
+                if (offset > 0)
+                {
+                    memset(&pinfo, 0, sizeof(pinfo));
+                    pinfo.sample_index = rinfo.sample_index
+                                         + offset / (size_t)frame_bytes;
+                    stream_fill_read_time(stream->backend_stream, &pinfo);
+                }
+
+                send_data_packet(stream, &hdr_template, pkt_buf,
+                                 (const unsigned char *)data + offset, len,
+                                 &pinfo);
+                offset += len;
+
+                /* Track the producer position for non-data frames. A codec
+                 * stream advances by the frame's decoded duration, not by
+                 * bytes. */
+                stream->timestamp = stream->backend_stream->is_codec
+                                    ? rinfo.sample_index
+                                    + rinfo.codec_frame_samples
+                                    : rinfo.sample_index
+                                    + offset / (size_t)frame_bytes;
+
+                /* Unconditional metadata refresh (cadence in stream-data time)
+                 * so a lost change-detected frame heals without waiting for the
+                 * next change; interval 0 sends metadata with every data packet. */
+                if (rigctld_stream_metadata_refresh_due(stream->metadata_refresh_ms,
+                                                        stream->config.sample_rate,
+                                                        stream->timestamp - last_meta_sample))
                 {
-                    send_metadata_packet(stream, &meta);
+                    struct rig_stream_metadata meta;
+
+                    if (rig_stream_read_metadata(stream->rig,
+                                                 stream->backend_stream,
+                                                 &meta) == RIG_OK)
+                    {
+                        send_metadata_packet(stream, &meta);
+                    }
+
+                    last_meta_sample = stream->timestamp;
                 }
+            }
+
+            /* The batch points into the region: out before it is released */
+            if (stream->batch)
+            {
+                flush_to_client(stream);
+            }
 
-                last_meta_sample = stream->timestamp;
+            if (acquired)
+            {
+                rig_stream_read_release(stream->rig, stream->backend_stream,
+                                        bytes_read);
             }
         }
 
@@ -1829,6 +2139,7 @@ static void *rigctld_stream_feeder_rx(void *arg)
             rig_debug(RIG_DEBUG_WARN,
                       "%s: keepalive timeout for stream %d\n",
                       __func__, stream->stream_id);
+            stop_batching(stream);
             free(pkt_buf);
             stream->running = 0;
             rigctld_stream_auto_close(&g_stream_registry, stream);
@@ -1867,8 +2178,14 @@ static void *rigctld_stream_feeder_rx(void *arg)
                 clock_gettime(CLOCK_MONOTONIC, &last_meta_time);
             }
         }
+
+        if (stream->batch && stream->batch->count > 0)
+        {
+            flush_to_client(stream);
+        }
     }
 
+    stop_batching(stream);
     free(pkt_buf);
     return NULL;
 }
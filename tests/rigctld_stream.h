@@ -27,6 +27,7 @@
 
 #include <hamlib/rig.h>
 #include "stream_proto.h"
+#include "udp_batch.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <pthread.h>
@@ -146,6 +147,8 @@ struct rigctld_stream
     HAMLIB_ATOMIC int packet_count;
     HAMLIB_ATOMIC uint32_t gap_count;
     HAMLIB_ATOMIC int send_drops;
+    HAMLIB_ATOMIC int send_syscalls;        /* packet_count / send_syscalls is
+                                               the batching achieved */
 
     /* Metadata */
     int metadata_interval_ms;
@@ -153,6 +156,14 @@ struct rigctld_stream
                                 * ms); 0 = every data packet */
     struct rig_stream_metadata last_sent_meta;
 
+    /* Batched sending (RX feeder): datagrams per system call, and how long
+     * the feeder may wait to fill a batch */
+    int batch_depth;
+    int batch_window_us;
+    struct udp_batch *batch;    /* While the RX feeder runs with depth > 1 */
+    struct udp_batch_stats batch_counted;   /* Of its counters, the part
+                                               already in the stream's */
+
     /* Cached invariants (computed once at feeder start) */
     uint8_t format_id;               /* Wire format index for headers */
     int sample_size;                     /* Bytes per sample (0 = unknown) */
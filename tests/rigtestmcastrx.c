@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <unistd.h>
 
 #ifdef _WIN32
@@ -18,7 +19,128 @@
 
 #define MCAST_PORT 4532
 #define MCAST_ADDR "224.0.0.1"
-#define BUFFER_SIZE 4096
+#define BUFFER_SIZE 16384
+
+/*
+ * Reference decoder for the binary spectrum packets sent with
+ * multicast_spectrum_format=binary or both (see README.multicast).
+ * Self-contained on purpose, so it can be copied into applications.
+ */
+#define SPECTRUM_MAGIC       0x48535043  /* "HSPC" */
+#define SPECTRUM_VERSION     1
+#define SPECTRUM_HEADER_SIZE 72
+#define SPECTRUM_MAX_BINS    2048
+
+static uint32_t be16(const unsigned char *p)
+{
+    return (uint32_t)p[0] << 8 | p[1];
+}
+
+static uint32_t be32(const unsigned char *p)
+{
+    return be16(p) << 16 | be16(p + 2);
+}
+
+static uint64_t be64(const unsigned char *p)
+{
+    return (uint64_t)be32(p) << 32 | be32(p + 4);
+}
+
+/* PackBits: n < 128 copies n+1 literal bytes, n > 128 repeats the next
+ * byte 257-n times, 128 is a no-op. Returns the decoded length or -1. */
+static int unpackbits(const unsigned char *in, int in_len,
+                      unsigned char *out, int out_len)
+{
+    int i = 0, o = 0;
+
+    while (i < in_len)
+    {
+        int c = in[i++];
+
+        if (c < 128)
+        {
+            if (i + c + 1 > in_len || o + c + 1 > out_len) { return -1; }
+
+            memcpy(out + o, in + i, c + 1);
+            i += c + 1;
+            o += c + 1;
+        }
+        else if (c > 128)
+        {
+            if (i >= in_len || o + 257 - c > out_len) { return -1; }
+
+            memset(out + o, in[i++], 257 - c);
+            o += 257 - c;
+        }
+    }
+
+    return o;
+}
+
+/* Decode one spectrum packet and print it; returns 0, or -1 if malformed */
+static int print_spectrum_packet(const unsigned char *p, int len)
+{
+    static const char *encodings[] = { "raw", "rle", "delta" };
+    unsigned char bins[SPECTRUM_MAX_BINS];
+    int nbins, payload_len, i, min, max;
+
+    if (len < SPECTRUM_HEADER_SIZE || p[4] != SPECTRUM_VERSION || p[5] > 2)
+    {
+        return -1;
+    }
+
+    nbins = (int)be16(p + 68);
+    payload_len = (int)be16(p + 70);
+
+    if (nbins > SPECTRUM_MAX_BINS || SPECTRUM_HEADER_SIZE + payload_len > len)
+    {
+        return -1;
+    }
+
+    if (p[5] == 0)
+    {
+        if (payload_len != nbins) { return -1; }
+
+        memcpy(bins, p + SPECTRUM_HEADER_SIZE, nbins);
+    }
+    else if (unpackbits(p + SPECTRUM_HEADER_SIZE, payload_len, bins,
+                        nbins) != nbins)
+    {
+        return -1;
+    }
+
+    if (p[5] == 2)  /* delta: each bin is stored relative to the previous one */
+    {
+        for (i = 1; i < nbins; i++)
+        {
+            bins[i] = (unsigned char)(bins[i] + bins[i - 1]);
+        }
+    }
+
+    min = 255;
+    max = 0;
+
+    for (i = 0; i < nbins; i++)
+    {
+        if (bins[i] < min) { min = bins[i]; }
+
+        if (bins[i] > max) { max = bins[i]; }
+    }
+
+    printf("spectrum source=%u id=%u seq=%u time=%llu.%06llu mode=%u center=%llu "
+           "span=%llu low=%llu high=%llu levels=%d..%d strength=%.1f..%.1fdB "
+           "bins=%d encoding=%s(%d bytes) data=%d..%d\n",
+           be32(p + 12), p[7], be32(p + 8),
+           (unsigned long long)(be64(p + 16) / 1000000),
+           (unsigned long long)(be64(p + 16) % 1000000), p[6],
+           (unsigned long long)be64(p + 24), (unsigned long long)be64(p + 32),
+           (unsigned long long)be64(p + 40), (unsigned long long)be64(p + 48),
+           (int32_t)be32(p + 56), (int32_t)be32(p + 60),
+           (int16_t)be16(p + 64) / 10.0, (int16_t)be16(p + 66) / 10.0,
+           nbins, encodings[p[5]], payload_len, nbins ? min : 0, max);
+
+    return 0;
+}
 
 int main()
 {
@@ -82,7 +204,7 @@ int main()
 
     while (1)
     {
-        bytes_received = recvfrom(sock, buffer, BUFFER_SIZE, 0, NULL, 0);
+        bytes_received = recvfrom(sock, buffer, BUFFER_SIZE - 1, 0, NULL, 0);
 
         if (bytes_received < 0)
         {
@@ -90,6 +212,17 @@ int main()
             break;
         }
 
+        if (bytes_received >= 4
+                && be32((unsigned char *)buffer) == SPECTRUM_MAGIC)
+        {
+            if (print_spectrum_packet((unsigned char *)buffer, bytes_received) < 0)
+            {
+                printf("malformed spectrum packet, %d bytes\n", bytes_received);
+            }
+
+            continue;
+        }
+
         buffer[bytes_received] = '\0';
         printf("%s\n", buffer);
     }